@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+namespace pr::benchmark
+{
+	// Best of uNumRuns runs in milliseconds, the best run is the one least disturbed by the rest of the system
+	template <class Function>
+	double MeasureMs(unsigned uNumRuns, Function&& function)
+	{
+		double bestMs = 0.0;
+		for (unsigned i = 0u; i < uNumRuns; ++i)
+		{
+			auto begin = std::chrono::steady_clock::now();
+			function();
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			bestMs = i == 0u || ms < bestMs ? ms : bestMs;
+		}
+
+		return bestMs;
+	}
+
+	// Keeps results alive so the measured work is not optimized away
+	inline volatile double g_Sink = 0.0;
+}
@@ -0,0 +1,241 @@
+#include "pch.h"
+
+#include <cmath>
+#include <random>
+
+#include "Scene/BoundingVolumeHierarchy.h"
+#include "Utility/JobSystem.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+namespace
+{
+	constexpr const UINT NUM_ITEMS = 100000u;
+	constexpr const UINT NUM_QUERIES = 64u;
+	constexpr const UINT NUM_REFIT_FRAMES = 60u;
+
+	Box toBox(_In_ const MeshBounds& bounds)
+	{
+		return Box
+		{
+			.Min = XMFLOAT3(bounds.Center.x - bounds.Extents.x, bounds.Center.y - bounds.Extents.y, bounds.Center.z - bounds.Extents.z),
+			.Max = XMFLOAT3(bounds.Center.x + bounds.Extents.x, bounds.Center.y + bounds.Extents.y, bounds.Center.z + bounds.Extents.z),
+		};
+	}
+
+	BOOL intersects(_In_ const Frustum& frustum, _In_ const Box& box)
+	{
+		XMFLOAT3 center((box.Min.x + box.Max.x) * 0.5f, (box.Min.y + box.Max.y) * 0.5f, (box.Min.z + box.Max.z) * 0.5f);
+		XMFLOAT3 extents((box.Max.x - box.Min.x) * 0.5f, (box.Max.y - box.Min.y) * 0.5f, (box.Max.z - box.Min.z) * 0.5f);
+		for (const XMFLOAT4& plane : frustum.aPlanes)
+		{
+			FLOAT distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+			if (distance + std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y + std::fabs(plane.z) * extents.z < 0.0f)
+			{
+				return FALSE;
+			}
+		}
+
+		return TRUE;
+	}
+
+	BOOL intersects(_In_ const Sphere& sphere, _In_ const Box& box)
+	{
+		FLOAT dx = std::max(std::max(box.Min.x - sphere.Center.x, sphere.Center.x - box.Max.x), 0.0f);
+		FLOAT dy = std::max(std::max(box.Min.y - sphere.Center.y, sphere.Center.y - box.Max.y), 0.0f);
+		FLOAT dz = std::max(std::max(box.Min.z - sphere.Center.z, sphere.Center.z - box.Max.z), 0.0f);
+
+		return dx * dx + dy * dy + dz * dz <= sphere.Radius * sphere.Radius;
+	}
+
+	BOOL intersects(_In_ const Box& query, _In_ const Box& box)
+	{
+		return box.Max.x >= query.Min.x && box.Max.y >= query.Min.y && box.Max.z >= query.Min.z
+			&& box.Min.x <= query.Max.x && box.Min.y <= query.Max.y && box.Min.z <= query.Max.z;
+	}
+
+	// Slab test, outEntry is the distance along the ray where it enters the box
+	BOOL intersects(_In_ const Ray& ray, _In_ const Box& box, _Out_ FLOAT& outEntry)
+	{
+		const FLOAT aOrigin[3] = { ray.Origin.x, ray.Origin.y, ray.Origin.z };
+		const FLOAT aDirection[3] = { ray.Direction.x, ray.Direction.y, ray.Direction.z };
+		const FLOAT aMin[3] = { box.Min.x, box.Min.y, box.Min.z };
+		const FLOAT aMax[3] = { box.Max.x, box.Max.y, box.Max.z };
+
+		FLOAT entry = 0.0f;
+		FLOAT exitDistance = ray.Length;
+		for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+		{
+			if (aDirection[uAxis] == 0.0f)
+			{
+				if (aOrigin[uAxis] < aMin[uAxis] || aOrigin[uAxis] > aMax[uAxis])
+				{
+					return FALSE;
+				}
+				continue;
+			}
+
+			FLOAT slabEntry = (aMin[uAxis] - aOrigin[uAxis]) / aDirection[uAxis];
+			FLOAT slabExit = (aMax[uAxis] - aOrigin[uAxis]) / aDirection[uAxis];
+			entry = std::max(entry, std::min(slabEntry, slabExit));
+			exitDistance = std::min(exitDistance, std::max(slabEntry, slabExit));
+			if (entry > exitDistance)
+			{
+				return FALSE;
+			}
+		}
+
+		outEntry = entry;
+		return TRUE;
+	}
+
+	BOOL intersects(_In_ const Ray& ray, _In_ const Box& box)
+	{
+		FLOAT entry;
+		return intersects(ray, box, entry);
+	}
+
+	// Queries that differ from testing every item, ray hits also have to come sorted by entry distance
+	template <class Shape>
+	UINT countMismatches(_In_ const std::vector<Shape>& aShapes, _In_ const std::vector<std::vector<UINT>>& aauItems, _In_ const std::vector<MeshBounds>& aBounds)
+	{
+		UINT uNumMismatches = 0u;
+		for (UINT q = 0u; q < aShapes.size(); ++q)
+		{
+			std::vector<UINT> auExpected;
+			for (UINT i = 0u; i < aBounds.size(); ++i)
+			{
+				if (intersects(aShapes[q], toBox(aBounds[i])))
+				{
+					auExpected.push_back(i);
+				}
+			}
+
+			if constexpr (std::is_same_v<Shape, Ray>)
+			{
+				FLOAT previousEntry = 0.0f;
+				for (UINT uItem : aauItems[q])
+				{
+					FLOAT entry = 0.0f;
+					intersects(aShapes[q], toBox(aBounds[uItem]), entry);
+					uNumMismatches += entry < previousEntry ? 1u : 0u;
+					previousEntry = entry;
+				}
+			}
+
+			std::vector<UINT> auItems = aauItems[q];
+			std::sort(auItems.begin(), auItems.end());
+			uNumMismatches += auItems == auExpected ? 0u : 1u;
+		}
+
+		return uNumMismatches;
+	}
+}
+
+// Builds a hierarchy over 100k boxes scattered over a 1 km square, queries it and refits it while the boxes move
+int main()
+{
+	std::mt19937 generator(7u);
+	std::uniform_real_distribution<FLOAT> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<FLOAT> extent(0.5f, 3.0f);
+	std::vector<MeshBounds> aBounds(NUM_ITEMS);
+	for (MeshBounds& bounds : aBounds)
+	{
+		bounds.Center = XMFLOAT3(position(generator), position(generator) * 0.2f, position(generator));
+		bounds.Extents = XMFLOAT3(extent(generator), extent(generator), extent(generator));
+		bounds.Radius = std::sqrt(bounds.Extents.x * bounds.Extents.x + bounds.Extents.y * bounds.Extents.y + bounds.Extents.z * bounds.Extents.z);
+	}
+
+	std::vector<Frustum> aFrustums(NUM_QUERIES);
+	std::vector<Sphere> aSpheres(NUM_QUERIES);
+	std::vector<Box> aBoxes(NUM_QUERIES);
+	std::vector<Ray> aRays(NUM_QUERIES);
+	for (UINT q = 0u; q < NUM_QUERIES; ++q)
+	{
+		FLOAT yaw = position(generator);
+		XMMATRIX view = XMMatrixLookToLH(XMVectorSet(position(generator), 5.0f, position(generator), 1.0f), XMVectorSet(std::sin(yaw), 0.0f, std::cos(yaw), 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, view * XMMatrixPerspectiveFovLH(1.0f, 16.0f / 9.0f, 0.1f, 300.0f));
+		aFrustums[q] = ExtractFrustum(viewProjection);
+
+		aSpheres[q] = Sphere{ .Center = XMFLOAT3(position(generator), 0.0f, position(generator)), .Radius = 30.0f };
+
+		XMFLOAT3 center(position(generator), 0.0f, position(generator));
+		aBoxes[q] = Box{ .Min = XMFLOAT3(center.x - 20.0f, -50.0f, center.z - 20.0f), .Max = XMFLOAT3(center.x + 20.0f, 50.0f, center.z + 20.0f) };
+
+		FLOAT angle = position(generator);
+		aRays[q] = Ray{ .Origin = XMFLOAT3(position(generator), position(generator) * 0.2f, position(generator)), .Length = 1000.0f, .Direction = XMFLOAT3(std::cos(angle), 0.0f, std::sin(angle)) };
+	}
+
+	JobSystem singleThread(0u);
+	JobSystem& jobSystem = JobSystem::GetInstance();
+
+	BoundingVolumeHierarchy hierarchy;
+	double buildMs = benchmark::MeasureMs(5u, [&]() { hierarchy.Build(aBounds.data(), NUM_ITEMS, singleThread); });
+	double parallelBuildMs = benchmark::MeasureMs(5u, [&]() { hierarchy.Build(aBounds.data(), NUM_ITEMS, jobSystem); });
+
+	BoundingVolumeHierarchy::Stats stats = hierarchy.GetStats();
+	std::printf("%u items, %u nodes, %u subtrees\n", stats.uNumItems, stats.uNumNodes, stats.uNumSubtrees);
+	std::printf("  Build (1 thread):    %8.3f ms\n", buildMs);
+	std::printf("  Build (%2u threads): %8.3f ms\n", jobSystem.GetNumThreads(), parallelBuildMs);
+
+	UINT uNumMismatches = 0u;
+	std::vector<std::vector<UINT>> aauItems(NUM_QUERIES);
+	auto measureQueries = [&](const char* pszName, auto&& query, auto&& aShapes)
+	{
+		double queryMs = benchmark::MeasureMs(5u, [&]() { query(aShapes.data(), NUM_QUERIES, aauItems.data(), singleThread); });
+		UINT uNumQueryMismatches = 0u;
+		double bruteForceMs = benchmark::MeasureMs(1u, [&]() { uNumQueryMismatches = countMismatches(aShapes, aauItems, aBounds); });
+		uNumMismatches += uNumQueryMismatches;
+
+		size_t uNumHits = 0u;
+		for (const std::vector<UINT>& auItems : aauItems)
+		{
+			uNumHits += auItems.size();
+		}
+		std::printf("  %u %-9s %8.3f ms on 1 thread, brute force %8.3f ms, %zu hits, %u mismatches\n", NUM_QUERIES, pszName, queryMs, bruteForceMs, uNumHits, uNumQueryMismatches);
+	};
+
+	auto measureAllQueries = [&]()
+	{
+		measureQueries("frustums", [&](auto&&... args) { hierarchy.QueryFrustums(args...); }, aFrustums);
+		measureQueries("spheres", [&](auto&&... args) { hierarchy.QuerySpheres(args...); }, aSpheres);
+		measureQueries("boxes", [&](auto&&... args) { hierarchy.QueryBoxes(args...); }, aBoxes);
+		measureQueries("rays", [&](auto&&... args) { hierarchy.QueryRays(args...); }, aRays);
+	};
+	measureAllQueries();
+
+	// Every moving box drifts a little each frame
+	std::uniform_real_distribution<FLOAT> velocity(-5.0f, 5.0f);
+	std::vector<XMFLOAT2> aVelocities(NUM_ITEMS);
+	for (XMFLOAT2& itemVelocity : aVelocities)
+	{
+		itemVelocity = XMFLOAT2(velocity(generator), velocity(generator));
+	}
+	for (FLOAT movingFraction : { 0.1f, 1.0f })
+	{
+		UINT uNumMoving = static_cast<UINT>(NUM_ITEMS * movingFraction);
+		UINT uNumRebuiltSubtrees = 0u;
+		double totalMs = 0.0;
+		for (UINT uFrame = 0u; uFrame < NUM_REFIT_FRAMES; ++uFrame)
+		{
+			for (UINT i = 0u; i < uNumMoving; ++i)
+			{
+				aBounds[i].Center.x += aVelocities[i].x * 0.01f;
+				aBounds[i].Center.z += aVelocities[i].y * 0.01f;
+			}
+
+			totalMs += benchmark::MeasureMs(1u, [&]() { hierarchy.Refit(aBounds.data(), singleThread); });
+			uNumRebuiltSubtrees += hierarchy.GetStats().uNumRebuiltSubtrees;
+		}
+
+		std::printf("  Refit with %3.0f%% moving: %8.3f ms per frame on 1 thread, %u subtrees rebuilt over %u frames\n", movingFraction * 100.0f, totalMs / NUM_REFIT_FRAMES, uNumRebuiltSubtrees, NUM_REFIT_FRAMES);
+	}
+
+	// Queries have to stay exact after the refits
+	measureAllQueries();
+
+	return uNumMismatches == 0u ? 0 : 1;
+}
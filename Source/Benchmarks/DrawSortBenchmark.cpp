@@ -0,0 +1,123 @@
+#include "pch.h"
+
+#include <random>
+
+#include "Graphics/DrawSortKey.h"
+#include "Utility/JobSystem.h"
+#include "Utility/RadixSort.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+namespace
+{
+	// State changes when the draws are recorded in this order, counted like RenderQueue::computeStats
+	struct StateChanges
+	{
+		UINT uNumPsoChanges;
+		UINT uNumMaterialChanges;
+		UINT uNumVertexBufferChanges;
+	};
+
+	StateChanges countStateChanges(_In_ const std::vector<SortItem>& aItems)
+	{
+		StateChanges changes = {};
+		const SortItem* pPrevious = nullptr;
+		for (const SortItem& item : aItems)
+		{
+			if (!pPrevious || DrawSortKey::GetPso(pPrevious->uKey) != DrawSortKey::GetPso(item.uKey))
+			{
+				++changes.uNumPsoChanges;
+			}
+			if (!pPrevious || DrawSortKey::GetMaterial(pPrevious->uKey) != DrawSortKey::GetMaterial(item.uKey))
+			{
+				++changes.uNumMaterialChanges;
+			}
+			if (!pPrevious || DrawSortKey::GetVertexBuffer(pPrevious->uKey) != DrawSortKey::GetVertexBuffer(item.uKey))
+			{
+				++changes.uNumVertexBufferChanges;
+			}
+			pPrevious = &item;
+		}
+
+		return changes;
+	}
+}
+
+// Sorts the keys of a frame with 100k draws the way RenderQueue::Sort does
+int main()
+{
+	constexpr const UINT NUM_DRAWS = 100000u;
+	constexpr const UINT NUM_PSOS = 16u;
+	constexpr const UINT NUM_MATERIALS = 2000u;
+	constexpr const UINT NUM_VERTEX_BUFFERS = 64u;
+
+	std::mt19937 generator(1u);
+	std::vector<SortItem> aItems(NUM_DRAWS);
+	for (UINT i = 0u; i < NUM_DRAWS; ++i)
+	{
+		eRenderPass pass = generator() % 10u == 0u ? eRenderPass::TRANSLUCENT_PASS : eRenderPass::OPAQUE_PASS;
+		aItems[i] = SortItem
+		{
+			.uKey = DrawSortKey::Encode(pass, generator() % NUM_PSOS, generator() % NUM_MATERIALS, generator() % NUM_VERTEX_BUFFERS, generator() % DrawSortKey::MAX_DEPTH),
+			.uValue = i,
+			.uPadding = 0u,
+		};
+	}
+
+	std::vector<SortItem> aExpected = aItems;
+	std::stable_sort(aExpected.begin(), aExpected.end(), [](const SortItem& a, const SortItem& b) { return a.uKey < b.uKey; });
+
+	std::vector<SortItem> aSorted(NUM_DRAWS);
+	std::vector<SortItem> aScratch(NUM_DRAWS);
+	JobSystem& jobSystem = JobSystem::GetInstance();
+
+	auto isSorted = [&]()
+	{
+		for (UINT i = 0u; i < NUM_DRAWS; ++i)
+		{
+			if (aSorted[i].uValue != aExpected[i].uValue)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	double stdMs = benchmark::MeasureMs(20u, [&]()
+		{
+			aSorted = aItems;
+			std::stable_sort(aSorted.begin(), aSorted.end(), [](const SortItem& a, const SortItem& b) { return a.uKey < b.uKey; });
+		});
+	double radixMs = benchmark::MeasureMs(20u, [&]()
+		{
+			aSorted = aItems;
+			RadixSort(aSorted.data(), aScratch.data(), NUM_DRAWS);
+		});
+	BOOL bRadixSorted = isSorted();
+	double parallelMs = benchmark::MeasureMs(20u, [&]()
+		{
+			aSorted = aItems;
+			ParallelRadixSort(aSorted.data(), aScratch.data(), NUM_DRAWS, jobSystem);
+		});
+	BOOL bParallelSorted = isSorted();
+
+	// Translucent draws stay back-to-front, so they keep most of their changes
+	StateChanges unsorted = countStateChanges(aItems);
+	StateChanges sorted = countStateChanges(aSorted);
+
+	std::printf("%u draws, times include copying the unsorted keys\n", NUM_DRAWS);
+	std::printf("  PSO changes:           %6u -> %6u\n", unsorted.uNumPsoChanges, sorted.uNumPsoChanges);
+	std::printf("  material changes:      %6u -> %6u\n", unsorted.uNumMaterialChanges, sorted.uNumMaterialChanges);
+	std::printf("  vertex buffer changes: %6u -> %6u\n", unsorted.uNumVertexBufferChanges, sorted.uNumVertexBufferChanges);
+	std::printf("  std::stable_sort:               %7.3f ms\n", stdMs);
+	std::printf("  RadixSort:                      %7.3f ms%s\n", radixMs, bRadixSorted ? "" : "  MISMATCH");
+	std::printf("  ParallelRadixSort (%2u threads): %7.3f ms%s\n", jobSystem.GetNumThreads(), parallelMs, bParallelSorted ? "" : "  MISMATCH");
+
+	BOOL bHasFewerChanges = sorted.uNumPsoChanges < unsorted.uNumPsoChanges
+		&& sorted.uNumMaterialChanges < unsorted.uNumMaterialChanges
+		&& sorted.uNumVertexBufferChanges <= unsorted.uNumVertexBufferChanges;
+
+	return bRadixSorted && bParallelSorted && bHasFewerChanges ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+#include "pch.h"
+
+#include <cmath>
+#include <random>
+
+#include "Graphics/FrustumCuller.h"
+#include "Utility/JobSystem.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+namespace
+{
+	BOOL isBoxVisible(const Frustum& frustum, const MeshBounds& bounds) noexcept
+	{
+		for (const XMFLOAT4& plane : frustum.aPlanes)
+		{
+			FLOAT distance = plane.x * bounds.Center.x + plane.y * bounds.Center.y + plane.z * bounds.Center.z + plane.w;
+			FLOAT radius = std::fabs(plane.x) * bounds.Extents.x + std::fabs(plane.y) * bounds.Extents.y + std::fabs(plane.z) * bounds.Extents.z;
+			if (distance + radius < 0.0f)
+			{
+				return FALSE;
+			}
+		}
+
+		return TRUE;
+	}
+}
+
+// Culls 1M random boxes around a camera at the origin with the SIMD culler and with a scalar reference
+int main()
+{
+	constexpr const UINT NUM_BOXES = 1000000u;
+
+	XMMATRIX viewProjection = XMMatrixLookToLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.3f, 0.1f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f))
+		* XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+	XMFLOAT4X4 viewProjectionMatrix;
+	XMStoreFloat4x4(&viewProjectionMatrix, viewProjection);
+	Frustum frustum = ExtractFrustum(viewProjectionMatrix);
+
+	std::mt19937 generator(1u);
+	std::uniform_real_distribution<FLOAT> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<FLOAT> extent(0.1f, 5.0f);
+	std::vector<MeshBounds> aBounds(NUM_BOXES);
+	for (MeshBounds& bounds : aBounds)
+	{
+		bounds.Center = XMFLOAT3(position(generator), position(generator), position(generator));
+		bounds.Extents = XMFLOAT3(extent(generator), extent(generator), extent(generator));
+		bounds.Radius = std::sqrt(bounds.Extents.x * bounds.Extents.x + bounds.Extents.y * bounds.Extents.y + bounds.Extents.z * bounds.Extents.z);
+	}
+
+	std::vector<BYTE> abExpected(NUM_BOXES);
+	double scalarMs = benchmark::MeasureMs(5u, [&]()
+		{
+			for (UINT i = 0u; i < NUM_BOXES; ++i)
+			{
+				abExpected[i] = static_cast<BYTE>(isBoxVisible(frustum, aBounds[i]));
+			}
+		});
+
+	FrustumCuller culler;
+	for (const MeshBounds& bounds : aBounds)
+	{
+		culler.AddBounds(bounds);
+	}
+
+	auto countMismatches = [&]()
+	{
+		UINT uNumMismatches = 0u;
+		for (UINT i = 0u; i < NUM_BOXES; ++i)
+		{
+			uNumMismatches += static_cast<BYTE>(culler.IsVisible(i) != 0) != abExpected[i] ? 1u : 0u;
+		}
+		return uNumMismatches;
+	};
+
+	JobSystem singleThread(0u);
+	double singleMs = benchmark::MeasureMs(5u, [&]() { culler.Cull(frustum, singleThread); });
+	UINT uNumSingleMismatches = countMismatches();
+
+	JobSystem& jobSystem = JobSystem::GetInstance();
+	double parallelMs = benchmark::MeasureMs(5u, [&]() { culler.Cull(frustum, jobSystem); });
+	UINT uNumParallelMismatches = countMismatches();
+
+#if defined(__AVX__)
+	const char* pszPath = "AVX";
+#else
+	const char* pszPath = "SSE";
+#endif
+	std::printf("%u boxes, %u visible, %s path\n", NUM_BOXES, culler.GetNumVisible(), pszPath);
+	std::printf("  scalar reference:            %7.3f ms\n", scalarMs);
+	std::printf("  FrustumCuller (1 thread):    %7.3f ms, %u mismatches\n", singleMs, uNumSingleMismatches);
+	std::printf("  FrustumCuller (%2u threads): %7.3f ms, %u mismatches\n", jobSystem.GetNumThreads(), parallelMs, uNumParallelMismatches);
+
+	return uNumSingleMismatches == 0u && uNumParallelMismatches == 0u ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <random>
+
+#include "Graphics/ClusteredLightCuller.h"
+#include "Utility/JobSystem.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+namespace
+{
+	constexpr const UINT NUM_LIGHTS = 10000u;
+	constexpr const FLOAT NEAR_Z = 0.01f;
+	constexpr const FLOAT FAR_Z = 1000.0f;
+
+	// Tests every light against every froxel with the same box, tile plane and cone tests as the culler, one at a time
+	std::vector<std::vector<UINT>> cullBruteForce(_In_ const std::vector<LightData>& aLights, _In_ const XMFLOAT3& viewOffset, _In_ FLOAT xScale, _In_ FLOAT yScale)
+	{
+		constexpr const UINT NX = ClusteredLightCuller::NUM_CLUSTERS_X;
+		constexpr const UINT NY = ClusteredLightCuller::NUM_CLUSTERS_Y;
+		constexpr const UINT NZ = ClusteredLightCuller::NUM_CLUSTERS_Z;
+
+		std::vector<std::vector<UINT>> aauLightIndices(ClusteredLightCuller::NUM_CLUSTERS);
+		for (UINT z = 0u; z < NZ; ++z)
+		{
+			FLOAT nearDepth = NEAR_Z * std::pow(FAR_Z / NEAR_Z, static_cast<FLOAT>(z) / NZ);
+			FLOAT farDepth = NEAR_Z * std::pow(FAR_Z / NEAR_Z, static_cast<FLOAT>(z + 1u) / NZ);
+			for (UINT y = 0u; y < NY; ++y)
+			{
+				for (UINT x = 0u; x < NX; ++x)
+				{
+					FLOAT aNdcX[2] = { -1.0f + 2.0f * x / NX, -1.0f + 2.0f * (x + 1u) / NX };
+					FLOAT aNdcY[2] = { 1.0f - 2.0f * y / NY, 1.0f - 2.0f * (y + 1u) / NY };
+					XMFLOAT3 boxMin(FLT_MAX, FLT_MAX, FLT_MAX);
+					XMFLOAT3 boxMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+					for (UINT uCorner = 0u; uCorner < 8u; ++uCorner)
+					{
+						FLOAT depth = uCorner & 1u ? farDepth : nearDepth;
+						XMFLOAT3 corner(aNdcX[(uCorner >> 1u) & 1u] * depth / xScale, aNdcY[(uCorner >> 2u) & 1u] * depth / yScale, depth);
+						boxMin = XMFLOAT3(std::min(boxMin.x, corner.x), std::min(boxMin.y, corner.y), std::min(boxMin.z, corner.z));
+						boxMax = XMFLOAT3(std::max(boxMax.x, corner.x), std::max(boxMax.y, corner.y), std::max(boxMax.z, corner.z));
+					}
+					XMFLOAT3 center((boxMin.x + boxMax.x) * 0.5f, (boxMin.y + boxMax.y) * 0.5f, (boxMin.z + boxMax.z) * 0.5f);
+					FLOAT radius = 0.5f * std::sqrt((boxMax.x - boxMin.x) * (boxMax.x - boxMin.x) + (boxMax.y - boxMin.y) * (boxMax.y - boxMin.y) + (boxMax.z - boxMin.z) * (boxMax.z - boxMin.z));
+
+					std::vector<UINT>& auLightIndices = aauLightIndices[(z * NY + y) * NX + x];
+					for (UINT i = 0u; i < aLights.size(); ++i)
+					{
+						const LightData& light = aLights[i];
+						XMFLOAT3 position(light.Position.x + viewOffset.x, light.Position.y + viewOffset.y, light.Position.z + viewOffset.z);
+
+						FLOAT dx = std::max(std::max(boxMin.x - position.x, position.x - boxMax.x), 0.0f);
+						FLOAT dy = std::max(std::max(boxMin.y - position.y, position.y - boxMax.y), 0.0f);
+						FLOAT dz = std::max(std::max(boxMin.z - position.z, position.z - boxMax.z), 0.0f);
+						if (dx * dx + dy * dy + dz * dz > light.Range * light.Range)
+						{
+							continue;
+						}
+
+						auto planeX = [&](FLOAT ndc) { return (position.x * xScale - ndc * position.z) / std::sqrt(xScale * xScale + ndc * ndc); };
+						auto planeY = [&](FLOAT ndc) { return (ndc * position.z - position.y * yScale) / std::sqrt(yScale * yScale + ndc * ndc); };
+						if (planeX(aNdcX[0]) <= -light.Range || planeX(aNdcX[1]) >= light.Range || planeY(aNdcY[0]) <= -light.Range || planeY(aNdcY[1]) >= light.Range)
+						{
+							continue;
+						}
+
+						if (light.Type == eLightType::SPOT)
+						{
+							XMFLOAT3 toCenter(center.x - position.x, center.y - position.y, center.z - position.z);
+							FLOAT lengthSquared = toCenter.x * toCenter.x + toCenter.y * toCenter.y + toCenter.z * toCenter.z;
+							FLOAT axial = toCenter.x * light.Direction.x + toCenter.y * light.Direction.y + toCenter.z * light.Direction.z;
+							FLOAT sinAngle = std::sqrt(1.0f - light.CosOuterAngle * light.CosOuterAngle);
+							FLOAT coneDistance = light.CosOuterAngle * std::sqrt(std::max(lengthSquared - axial * axial, 0.0f)) - axial * sinAngle;
+							if (coneDistance > radius || axial > radius + light.Range || axial < -radius)
+							{
+								continue;
+							}
+						}
+
+						auLightIndices.push_back(i);
+					}
+				}
+			}
+		}
+
+		return aauLightIndices;
+	}
+}
+
+// Culls 10k point and spot lights into the 16x9x24 froxels of a 90 degree view and compares them to a brute force test
+int main()
+{
+	XMFLOAT4X4 projection;
+	XMStoreFloat4x4(&projection, XMMatrixPerspectiveFovLH(XM_PIDIV2, 16.0f / 9.0f, NEAR_Z, FAR_Z));
+	const XMFLOAT3 viewOffset(3.0f, -2.0f, 5.0f);
+	XMFLOAT4X4 view;
+	XMStoreFloat4x4(&view, XMMatrixTranslation(viewOffset.x, viewOffset.y, viewOffset.z));
+
+	std::mt19937 generator(42u);
+	std::uniform_real_distribution<FLOAT> unit(-1.0f, 1.0f);
+	std::vector<LightData> aLights(NUM_LIGHTS);
+	for (LightData& light : aLights)
+	{
+		light.Position = XMFLOAT3(unit(generator) * 150.0f, unit(generator) * 60.0f + 60.0f, unit(generator) * 150.0f);
+		light.Range = 2.0f + (unit(generator) + 1.0f) * 6.0f;
+		light.Color = XMFLOAT3(1.0f, 1.0f, 1.0f);
+		light.Type = generator() % 4u == 0u ? eLightType::SPOT : eLightType::POINT;
+		XMVECTOR direction = XMVector3Normalize(XMVectorSet(unit(generator), unit(generator), unit(generator) + 1e-3f, 0.0f));
+		XMStoreFloat3(&light.Direction, direction);
+		light.CosOuterAngle = std::cos(0.2f + 0.3f * (unit(generator) + 1.0f));
+	}
+
+	ClusteredLightCuller culler;
+	culler.SetProjection(projection, NEAR_Z, FAR_Z);
+
+	JobSystem singleThread(0u);
+	double singleMs = benchmark::MeasureMs(50u, [&]() { culler.Cull(view, aLights.data(), NUM_LIGHTS, singleThread); });
+
+	JobSystem& jobSystem = JobSystem::GetInstance();
+	double parallelMs = benchmark::MeasureMs(50u, [&]() { culler.Cull(view, aLights.data(), NUM_LIGHTS, jobSystem); });
+
+	std::vector<std::vector<UINT>> aauExpected;
+	double bruteForceMs = benchmark::MeasureMs(1u, [&]() { aauExpected = cullBruteForce(aLights, viewOffset, projection._11, projection._22); });
+
+	UINT uNumMismatches = 0u;
+	for (UINT i = 0u; i < ClusteredLightCuller::NUM_CLUSTERS; ++i)
+	{
+		const LightCluster& cluster = culler.GetClusters()[i];
+		std::vector<UINT> auLightIndices(culler.GetLightIndices() + cluster.uOffset, culler.GetLightIndices() + cluster.uOffset + cluster.uNumLights);
+		std::sort(auLightIndices.begin(), auLightIndices.end());
+		uNumMismatches += auLightIndices == aauExpected[i] ? 0u : 1u;
+	}
+
+	ClusteredLightCuller::Stats stats = culler.GetStats();
+	std::printf("%u lights, %u visible, %u light indices, at most %u per froxel\n", stats.uNumLights, stats.uNumVisibleLights, stats.uNumLightIndices, stats.uMaxLightsPerCluster);
+	std::printf("  brute force:                        %8.3f ms\n", bruteForceMs);
+	std::printf("  ClusteredLightCuller (1 thread):    %8.3f ms\n", singleMs);
+	std::printf("  ClusteredLightCuller (%2u threads): %8.3f ms\n", jobSystem.GetNumThreads(), parallelMs);
+	std::printf("  %u of %u froxels differ from the brute force lists\n", uNumMismatches, ClusteredLightCuller::NUM_CLUSTERS);
+
+	return uNumMismatches == 0u ? 0 : 1;
+}
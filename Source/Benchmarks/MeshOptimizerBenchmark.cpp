@@ -0,0 +1,133 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+
+#include "Graphics/MeshOptimizer.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+namespace
+{
+	// Triangles rotated to start at their smallest vertex and sorted, so lists of the same triangles compare equal
+	std::vector<std::array<UINT, 3>> getTriangleSet(_In_ const std::vector<WORD>& aIndices, _In_ const std::vector<UINT>& auVertexIds)
+	{
+		std::vector<std::array<UINT, 3>> aTriangles;
+		for (size_t i = 0; i < aIndices.size(); i += 3u)
+		{
+			std::array<UINT, 3> triangle = { auVertexIds[aIndices[i]], auVertexIds[aIndices[i + 1u]], auVertexIds[aIndices[i + 2u]] };
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			aTriangles.push_back(triangle);
+		}
+		std::sort(aTriangles.begin(), aTriangles.end());
+
+		return aTriangles;
+	}
+}
+
+// Optimizes a 200x200 quad height field the way Model::optimizeMesh does, from row order and from shuffled triangles
+int main()
+{
+	constexpr const UINT GRID_SIZE = 200u;
+	constexpr const FLOAT OVERDRAW_THRESHOLD = 1.05f;
+
+	std::vector<XMFLOAT3> aPositions;
+	for (UINT z = 0u; z <= GRID_SIZE; ++z)
+	{
+		for (UINT x = 0u; x <= GRID_SIZE; ++x)
+		{
+			FLOAT fx = static_cast<FLOAT>(x);
+			FLOAT fz = static_cast<FLOAT>(z);
+			aPositions.push_back(XMFLOAT3(fx, 2.0f * std::sin(fx * 0.05f) * std::cos(fz * 0.07f), fz));
+		}
+	}
+
+	std::vector<WORD> aRowIndices;
+	for (UINT z = 0u; z < GRID_SIZE; ++z)
+	{
+		for (UINT x = 0u; x < GRID_SIZE; ++x)
+		{
+			WORD uCorner = static_cast<WORD>(z * (GRID_SIZE + 1u) + x);
+			WORD uNext = static_cast<WORD>(uCorner + GRID_SIZE + 1u);
+			aRowIndices.insert(aRowIndices.end(), { uCorner, uNext, static_cast<WORD>(uCorner + 1u), static_cast<WORD>(uCorner + 1u), uNext, static_cast<WORD>(uNext + 1u) });
+		}
+	}
+
+	std::vector<UINT> auTriangleOrder(aRowIndices.size() / 3u);
+	for (UINT i = 0u; i < auTriangleOrder.size(); ++i)
+	{
+		auTriangleOrder[i] = i;
+	}
+	std::shuffle(auTriangleOrder.begin(), auTriangleOrder.end(), std::mt19937(1u));
+	std::vector<WORD> aShuffledIndices;
+	for (UINT uTriangle : auTriangleOrder)
+	{
+		aShuffledIndices.insert(aShuffledIndices.end(), aRowIndices.begin() + uTriangle * 3u, aRowIndices.begin() + uTriangle * 3u + 3u);
+	}
+
+	const UINT uNumVertices = static_cast<UINT>(aPositions.size());
+	const UINT uNumIndices = static_cast<UINT>(aRowIndices.size());
+	std::vector<UINT> auIdentity(uNumVertices);
+	for (UINT i = 0u; i < uNumVertices; ++i)
+	{
+		auIdentity[i] = i;
+	}
+
+	std::printf("%u triangles, %u vertices, %u entry cache\n", uNumIndices / 3u, uNumVertices, VERTEX_CACHE_SIZE);
+
+	BOOL bIsValid = TRUE;
+	for (const std::vector<WORD>* paInput : { &aRowIndices, &aShuffledIndices })
+	{
+		VertexCacheStats before = SimulateVertexCache(paInput->data(), uNumIndices, uNumVertices);
+
+		std::vector<WORD> aIndices;
+		std::vector<UINT> auClusters;
+		double cacheMs = benchmark::MeasureMs(5u, [&]()
+		{
+			aIndices = *paInput;
+			OptimizeVertexCache(aIndices.data(), uNumIndices, uNumVertices, &auClusters);
+		});
+		VertexCacheStats afterCache = SimulateVertexCache(aIndices.data(), uNumIndices, uNumVertices);
+
+		const std::vector<WORD> aCacheIndices = aIndices;
+		double overdrawMs = benchmark::MeasureMs(5u, [&]()
+		{
+			aIndices = aCacheIndices;
+			OptimizeOverdraw(aIndices.data(), uNumIndices, aPositions.data(), sizeof(XMFLOAT3), uNumVertices, auClusters, OVERDRAW_THRESHOLD);
+		});
+		VertexCacheStats afterOverdraw = SimulateVertexCache(aIndices.data(), uNumIndices, uNumVertices);
+
+		const std::vector<WORD> aOverdrawIndices = aIndices;
+		std::vector<UINT> auRemap;
+		double fetchMs = benchmark::MeasureMs(5u, [&]()
+		{
+			aIndices = aOverdrawIndices;
+			OptimizeVertexFetch(auRemap, aIndices.data(), uNumIndices, uNumVertices);
+		});
+
+		// The reordered lists draw the same triangles, the fetch order renumbers the vertices
+		std::vector<UINT> auVertexIds(uNumVertices);
+		for (UINT i = 0u; i < uNumVertices; ++i)
+		{
+			auVertexIds[auRemap[i]] = i;
+		}
+		const std::vector<std::array<UINT, 3>> aInputTriangles = getTriangleSet(*paInput, auIdentity);
+		BOOL bIsSame = getTriangleSet(aCacheIndices, auIdentity) == aInputTriangles
+			&& getTriangleSet(aOverdrawIndices, auIdentity) == aInputTriangles
+			&& getTriangleSet(aIndices, auVertexIds) == aInputTriangles;
+		bIsValid = bIsValid && bIsSame && afterOverdraw.Acmr < before.Acmr;
+
+		std::printf("%s input:%s\n", paInput == &aRowIndices ? "row order" : "shuffled", bIsSame ? "" : " (triangles differ)");
+		std::printf("  ACMR %.3f -> %.3f after OptimizeVertexCache, %.3f after OptimizeOverdraw\n", before.Acmr, afterCache.Acmr, afterOverdraw.Acmr);
+		std::printf("  ATVR %.3f -> %.3f\n", before.Atvr, afterOverdraw.Atvr);
+		std::printf("  OptimizeVertexCache: %8.3f ms\n", cacheMs);
+		std::printf("  OptimizeOverdraw:    %8.3f ms\n", overdrawMs);
+		std::printf("  OptimizeVertexFetch: %8.3f ms\n", fetchMs);
+	}
+
+	return bIsValid ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+#include "pch.h"
+
+#include <cmath>
+
+#include "Graphics/MeshSimplifier.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+// Builds the LOD chain of a 128x128 quad height field the way Model::generateLods does
+int main()
+{
+	constexpr const UINT GRID_SIZE = 128u;
+	constexpr const UINT NUM_LODS = 3u;
+	constexpr const FLOAT LOD_REDUCTION = 0.5f;
+	constexpr const FLOAT MAX_ERROR = 0.5f;
+
+	std::vector<XMFLOAT3> aPositions;
+	for (UINT z = 0u; z <= GRID_SIZE; ++z)
+	{
+		for (UINT x = 0u; x <= GRID_SIZE; ++x)
+		{
+			FLOAT fx = static_cast<FLOAT>(x);
+			FLOAT fz = static_cast<FLOAT>(z);
+			aPositions.push_back(XMFLOAT3(fx, 2.0f * std::sin(fx * 0.05f) * std::cos(fz * 0.07f), fz));
+		}
+	}
+
+	std::vector<WORD> aIndices;
+	for (UINT z = 0u; z < GRID_SIZE; ++z)
+	{
+		for (UINT x = 0u; x < GRID_SIZE; ++x)
+		{
+			WORD uCorner = static_cast<WORD>(z * (GRID_SIZE + 1u) + x);
+			WORD uNext = static_cast<WORD>(uCorner + GRID_SIZE + 1u);
+			aIndices.insert(aIndices.end(), { uCorner, uNext, static_cast<WORD>(uCorner + 1u), static_cast<WORD>(uCorner + 1u), uNext, static_cast<WORD>(uNext + 1u) });
+		}
+	}
+
+	const UINT uNumVertices = static_cast<UINT>(aPositions.size());
+	std::vector<WORD> aaLodIndices[NUM_LODS];
+	FLOAT aErrors[NUM_LODS] = {};
+	auto buildChain = [&]()
+	{
+		const std::vector<WORD>* paIndices = &aIndices;
+		FLOAT error = 0.0f;
+		for (UINT uLod = 0u; uLod < NUM_LODS; ++uLod)
+		{
+			UINT uNumIndices = static_cast<UINT>(paIndices->size());
+			UINT uTargetNumIndices = static_cast<UINT>(static_cast<FLOAT>(uNumIndices / 3u) * LOD_REDUCTION) * 3u;
+			error += SimplifyMesh(aaLodIndices[uLod], aPositions.data(), sizeof(XMFLOAT3), uNumVertices, paIndices->data(), uNumIndices, uTargetNumIndices, std::max(MAX_ERROR - error, 0.0f));
+			aErrors[uLod] = error;
+			paIndices = &aaLodIndices[uLod];
+		}
+	};
+
+	double chainMs = benchmark::MeasureMs(5u, buildChain);
+
+	// The output only depends on the input
+	std::vector<WORD> aaFirstIndices[NUM_LODS];
+	for (UINT uLod = 0u; uLod < NUM_LODS; ++uLod)
+	{
+		aaFirstIndices[uLod] = aaLodIndices[uLod];
+	}
+	buildChain();
+
+	UINT uNumFailures = 0u;
+	std::printf("%u triangles, %u vertices\n", static_cast<UINT>(aIndices.size() / 3u), uNumVertices);
+	for (UINT uLod = 0u; uLod < NUM_LODS; ++uLod)
+	{
+		BOOL bIsValid = aaLodIndices[uLod] == aaFirstIndices[uLod] && aErrors[uLod] <= MAX_ERROR && aaLodIndices[uLod].size() % 3u == 0u;
+		for (WORD uIndex : aaLodIndices[uLod])
+		{
+			bIsValid = bIsValid && uIndex < uNumVertices;
+		}
+		uNumFailures += bIsValid ? 0u : 1u;
+
+		std::printf("  LOD %u: %6u triangles, error %.4f%s\n", uLod + 1u, static_cast<UINT>(aaLodIndices[uLod].size() / 3u), aErrors[uLod], bIsValid ? "" : " (invalid)");
+	}
+	std::printf("  SimplifyMesh chain: %8.3f ms\n", chainMs);
+
+	return uNumFailures == 0u && aaLodIndices[0].size() < aIndices.size() ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include "pch.h"
+
+#include <cmath>
+
+#include "Graphics/Meshlet.h"
+#include "Graphics/MeshOptimizer.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+// Builds the meshlets of a 130k triangle sphere the way Model does and culls them from eyes all around it
+int main()
+{
+	constexpr const UINT NUM_SEGMENTS = 256u;
+	constexpr const UINT NUM_RINGS = 254u;
+	constexpr const UINT NUM_EYES = 64u;
+
+	std::vector<XMFLOAT3> aPositions;
+	for (UINT uRing = 0u; uRing <= NUM_RINGS; ++uRing)
+	{
+		FLOAT theta = XM_PI * static_cast<FLOAT>(uRing) / NUM_RINGS;
+		for (UINT uSegment = 0u; uSegment <= NUM_SEGMENTS; ++uSegment)
+		{
+			FLOAT phi = XM_2PI * static_cast<FLOAT>(uSegment) / NUM_SEGMENTS;
+			aPositions.push_back(XMFLOAT3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+		}
+	}
+
+	// Wound so that the cross product of the edges points out of the sphere, the pole quads are single triangles
+	std::vector<WORD> auIndices;
+	for (UINT uRing = 0u; uRing < NUM_RINGS; ++uRing)
+	{
+		for (UINT uSegment = 0u; uSegment < NUM_SEGMENTS; ++uSegment)
+		{
+			WORD uCorner = static_cast<WORD>(uRing * (NUM_SEGMENTS + 1u) + uSegment);
+			WORD uBelow = static_cast<WORD>(uCorner + NUM_SEGMENTS + 1u);
+			if (uRing > 0u)
+			{
+				auIndices.insert(auIndices.end(), { uCorner, static_cast<WORD>(uCorner + 1u), uBelow });
+			}
+			if (uRing + 1u < NUM_RINGS)
+			{
+				auIndices.insert(auIndices.end(), { static_cast<WORD>(uCorner + 1u), static_cast<WORD>(uBelow + 1u), uBelow });
+			}
+		}
+	}
+
+	const UINT uNumVertices = static_cast<UINT>(aPositions.size());
+	const UINT uNumIndices = static_cast<UINT>(auIndices.size());
+	OptimizeVertexCache(auIndices.data(), uNumIndices, uNumVertices, nullptr);
+
+	std::vector<Meshlet> aMeshlets;
+	std::vector<WORD> auMeshletVertices;
+	std::vector<BYTE> auMeshletTriangles;
+	double buildMs = benchmark::MeasureMs(5u, [&]()
+	{
+		aMeshlets.clear();
+		auMeshletVertices.clear();
+		auMeshletTriangles.clear();
+		BuildMeshlets(aMeshlets, auMeshletVertices, auMeshletTriangles, auIndices.data(), uNumIndices, 0u, aPositions.data(), sizeof(XMFLOAT3), uNumVertices);
+	});
+
+	// Meshlets cover the triangles in order, their local triangles name the same vertices
+	UINT uNumMismatches = 0u;
+	UINT uNextIndex = 0u;
+	for (const Meshlet& meshlet : aMeshlets)
+	{
+		if (meshlet.uBaseIndex != uNextIndex || meshlet.uNumVertices > MAX_MESHLET_VERTICES || meshlet.uNumTriangles > MAX_MESHLET_TRIANGLES)
+		{
+			++uNumMismatches;
+		}
+		for (UINT i = 0u; i < meshlet.uNumTriangles * 3u; ++i)
+		{
+			if (auMeshletVertices[meshlet.uVertexOffset + auMeshletTriangles[meshlet.uTriangleOffset + i]] != auIndices[meshlet.uBaseIndex + i])
+			{
+				++uNumMismatches;
+			}
+		}
+		uNextIndex = meshlet.uBaseIndex + meshlet.uNumTriangles * 3u;
+	}
+	uNumMismatches += uNextIndex == uNumIndices ? 0u : 1u;
+
+	std::vector<MeshletRange> aRanges(aMeshlets.size());
+	std::vector<BYTE> abIsDrawn(uNumIndices / 3u);
+	MeshletCullStats stats = {};
+	UINT uNumDroppedTriangles = 0u;
+	double cullMs = 0.0;
+	for (UINT uEye = 0u; uEye < NUM_EYES; ++uEye)
+	{
+		// Spread over the sphere around the mesh, far enough to see all of it
+		FLOAT y = 1.0f - 2.0f * (static_cast<FLOAT>(uEye) + 0.5f) / NUM_EYES;
+		FLOAT radius = std::sqrt(1.0f - y * y);
+		FLOAT angle = static_cast<FLOAT>(uEye) * XM_PI * (3.0f - std::sqrt(5.0f));
+		XMFLOAT3 eyePosition(3.0f * radius * std::cos(angle), 3.0f * y, 3.0f * radius * std::sin(angle));
+
+		XMVECTOR eye = XMLoadFloat3(&eyePosition);
+		XMVECTOR up = std::fabs(y) > 0.9f ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, XMMatrixLookAtLH(eye, XMVectorZero(), up) * XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 0.1f, 100.0f));
+		const Frustum frustum = ExtractFrustum(viewProjection);
+
+		UINT uNumRanges = 0u;
+		cullMs += benchmark::MeasureMs(20u, [&]()
+		{
+			uNumRanges = CullMeshlets(aRanges.data(), aMeshlets.data(), static_cast<UINT>(aMeshlets.size()), frustum, eyePosition, nullptr);
+		});
+		CullMeshlets(aRanges.data(), aMeshlets.data(), static_cast<UINT>(aMeshlets.size()), frustum, eyePosition, &stats);
+
+		std::fill(abIsDrawn.begin(), abIsDrawn.end(), static_cast<BYTE>(0u));
+		for (UINT i = 0u; i < uNumRanges; ++i)
+		{
+			std::fill_n(abIsDrawn.begin() + aRanges[i].uBaseIndex / 3u, aRanges[i].uNumIndices / 3u, static_cast<BYTE>(1u));
+		}
+
+		// Every triangle that faces the eye has to be drawn
+		for (UINT i = 0u; i < uNumIndices; i += 3u)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&aPositions[auIndices[i]]);
+			XMVECTOR normal = XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&aPositions[auIndices[i + 1u]]), p0), XMVectorSubtract(XMLoadFloat3(&aPositions[auIndices[i + 2u]]), p0));
+			if (XMVectorGetX(XMVector3Dot(normal, XMVectorSubtract(eye, p0))) > 0.0f && !abIsDrawn[i / 3u])
+			{
+				++uNumDroppedTriangles;
+			}
+		}
+	}
+
+	std::printf("%u triangles, %u vertices, %u meshlets averaging %.1f vertices and %.1f triangles%s\n",
+		uNumIndices / 3u,
+		uNumVertices,
+		static_cast<UINT>(aMeshlets.size()),
+		static_cast<double>(auMeshletVertices.size()) / aMeshlets.size(),
+		static_cast<double>(auMeshletTriangles.size()) / (3.0 * aMeshlets.size()),
+		uNumMismatches == 0u ? "" : " (meshlets invalid)"
+	);
+	std::printf("  BuildMeshlets:         %8.3f ms\n", buildMs);
+	std::printf("  CullMeshlets per eye:  %8.3f ms\n", cullMs / NUM_EYES);
+	std::printf("  %u eyes: %.1f%% of meshlets back facing, %.1f%% outside the frustum, %.1f ranges per eye, %u front facing triangles dropped\n",
+		NUM_EYES,
+		100.0 * stats.uNumBackFacing / stats.uNumMeshlets,
+		100.0 * stats.uNumFrustumCulled / stats.uNumMeshlets,
+		static_cast<double>(stats.uNumRanges) / NUM_EYES,
+		uNumDroppedTriangles
+	);
+
+	return uNumMismatches == 0u && uNumDroppedTriangles == 0u && stats.uNumBackFacing > 0u ? 0 : 1;
+}
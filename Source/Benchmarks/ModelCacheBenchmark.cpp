@@ -0,0 +1,235 @@
+#include "pch.h"
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "Graphics/MeshOptimizer.h"
+#include "Graphics/ModelCacheFile.h"
+#include "Graphics/VertexQuantization.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+namespace
+{
+	constexpr const FLOAT OVERDRAW_THRESHOLD = 1.05f;
+
+	// What a cold load computes after parsing the model file and a warm load finds in the cache
+	struct ImportedModel
+	{
+		std::vector<VertexPNT> aVertices;
+		std::vector<WORD> auIndices;
+		std::vector<SceneFile::Mesh> aMeshes;
+		std::vector<ModelCacheFile::MeshMeshlets> aMeshMeshlets;
+		std::vector<VertexPackedPNT> aPackedVertices;
+		PositionDecode Decode;
+		std::vector<Meshlet> aMeshlets;
+		std::vector<WORD> auMeshletVertices;
+		std::vector<BYTE> auMeshletTriangles;
+	};
+
+	// Model::optimizeMesh, packVertices and buildMeshlets in order, on one thread and without the debug output
+	void rebuild(_Inout_ ImportedModel& model, _In_ UINT uNumMeshVertices)
+	{
+		for (SceneFile::Mesh& mesh : model.aMeshes)
+		{
+			WORD* pIndices = model.auIndices.data() + mesh.uBaseIndex;
+			VertexPNT* aVertices = model.aVertices.data() + mesh.uBaseVertex;
+
+			std::vector<UINT> auClusters;
+			OptimizeVertexCache(pIndices, mesh.uNumIndices, uNumMeshVertices, &auClusters);
+			OptimizeOverdraw(pIndices, mesh.uNumIndices, &aVertices[0].Position, sizeof(VertexPNT), uNumMeshVertices, auClusters, OVERDRAW_THRESHOLD);
+
+			std::vector<UINT> auRemap;
+			OptimizeVertexFetch(auRemap, pIndices, mesh.uNumIndices, uNumMeshVertices);
+			std::vector<VertexPNT> aOriginal(aVertices, aVertices + uNumMeshVertices);
+			for (UINT i = 0u; i < uNumMeshVertices; ++i)
+			{
+				aVertices[auRemap[i]] = aOriginal[i];
+			}
+
+			mesh.Bounds = ComputeMeshBounds(&aVertices[0].Position, sizeof(VertexPNT), uNumMeshVertices);
+		}
+
+		const UINT uNumVertices = static_cast<UINT>(model.aVertices.size());
+		model.Decode = ComputePositionDecode(model.aVertices.data(), uNumVertices);
+		model.aPackedVertices.resize(uNumVertices);
+		EncodeVertices(model.aPackedVertices.data(), model.aVertices.data(), uNumVertices, model.Decode);
+
+		model.aMeshlets.clear();
+		model.auMeshletVertices.clear();
+		model.auMeshletTriangles.clear();
+		model.aMeshMeshlets.clear();
+		for (const SceneFile::Mesh& mesh : model.aMeshes)
+		{
+			std::vector<Meshlet> aMeshlets;
+			std::vector<WORD> auVertices;
+			std::vector<BYTE> auTriangles;
+			BuildMeshlets(
+				aMeshlets,
+				auVertices,
+				auTriangles,
+				model.auIndices.data() + mesh.uBaseIndex,
+				mesh.uNumIndices,
+				mesh.uBaseIndex,
+				&model.aVertices[mesh.uBaseVertex].Position,
+				sizeof(VertexPNT),
+				uNumMeshVertices
+			);
+
+			ModelCacheFile::MeshMeshlets meshMeshlets;
+			meshMeshlets.uFirstMeshlet = static_cast<UINT>(model.aMeshlets.size());
+			meshMeshlets.uNumMeshlets = static_cast<UINT>(aMeshlets.size());
+			model.aMeshMeshlets.push_back(meshMeshlets);
+
+			for (Meshlet meshlet : aMeshlets)
+			{
+				meshlet.uVertexOffset += static_cast<UINT>(model.auMeshletVertices.size());
+				meshlet.uTriangleOffset += static_cast<UINT>(model.auMeshletTriangles.size());
+				model.aMeshlets.push_back(meshlet);
+			}
+			model.auMeshletVertices.insert(model.auMeshletVertices.end(), auVertices.begin(), auVertices.end());
+			model.auMeshletTriangles.insert(model.auMeshletTriangles.end(), auTriangles.begin(), auTriangles.end());
+		}
+	}
+
+	template <typename T>
+	BOOL isSame(_In_reads_(uCount) const T* aLeft, _In_ UINT uCount, _In_ const std::vector<T>& aRight)
+	{
+		return uCount == aRight.size() && std::memcmp(aLeft, aRight.data(), aRight.size() * sizeof(T)) == 0;
+	}
+}
+
+// Imports 8 spheres of 32k triangles each again and writes them to a model cache, then reads the cache back
+int main()
+{
+	constexpr const UINT NUM_MESHES = 8u;
+	constexpr const UINT NUM_SEGMENTS = 128u;
+	constexpr const UINT NUM_RINGS = 126u;
+	constexpr const UINT NUM_MESH_VERTICES = (NUM_RINGS + 1u) * (NUM_SEGMENTS + 1u);
+
+	ImportedModel source;
+	for (UINT uMesh = 0u; uMesh < NUM_MESHES; ++uMesh)
+	{
+		SceneFile::Mesh mesh = {};
+		mesh.uBaseVertex = static_cast<UINT>(source.aVertices.size());
+		mesh.uBaseIndex = static_cast<UINT>(source.auIndices.size());
+		mesh.uNumLods = 1u;
+
+		for (UINT uRing = 0u; uRing <= NUM_RINGS; ++uRing)
+		{
+			FLOAT theta = XM_PI * static_cast<FLOAT>(uRing) / NUM_RINGS;
+			for (UINT uSegment = 0u; uSegment <= NUM_SEGMENTS; ++uSegment)
+			{
+				FLOAT phi = XM_2PI * static_cast<FLOAT>(uSegment) / NUM_SEGMENTS;
+				VertexPNT vertex;
+				vertex.Normal = XMFLOAT3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+				vertex.Position = XMFLOAT3(vertex.Normal.x + 3.0f * uMesh, vertex.Normal.y, vertex.Normal.z);
+				vertex.TexCoord = XMFLOAT2(static_cast<FLOAT>(uSegment) / NUM_SEGMENTS, static_cast<FLOAT>(uRing) / NUM_RINGS);
+				source.aVertices.push_back(vertex);
+			}
+		}
+
+		// Triangles in rows as an exporter writes them, the pole quads are single triangles
+		for (UINT uRing = 0u; uRing < NUM_RINGS; ++uRing)
+		{
+			for (UINT uSegment = 0u; uSegment < NUM_SEGMENTS; ++uSegment)
+			{
+				WORD uCorner = static_cast<WORD>(uRing * (NUM_SEGMENTS + 1u) + uSegment);
+				WORD uBelow = static_cast<WORD>(uCorner + NUM_SEGMENTS + 1u);
+				if (uRing > 0u)
+				{
+					source.auIndices.insert(source.auIndices.end(), { uCorner, static_cast<WORD>(uCorner + 1u), uBelow });
+				}
+				if (uRing + 1u < NUM_RINGS)
+				{
+					source.auIndices.insert(source.auIndices.end(), { static_cast<WORD>(uCorner + 1u), static_cast<WORD>(uBelow + 1u), uBelow });
+				}
+			}
+		}
+		mesh.uNumIndices = static_cast<UINT>(source.auIndices.size()) - mesh.uBaseIndex;
+		source.aMeshes.push_back(mesh);
+	}
+
+	// Every run starts from the parsed geometry, the copy is part of the time
+	ImportedModel model;
+	double rebuildMs = benchmark::MeasureMs(3u, [&]()
+	{
+		model = source;
+		rebuild(model, NUM_MESH_VERTICES);
+	});
+
+	const std::string strings = std::string("sphere.dds") + '\0';
+	ModelCacheFile::Material material;
+	material.uDiffuse = 0u;
+	material.uSpecularExponent = ModelCacheFile::INVALID_INDEX;
+	material.uNormal = ModelCacheFile::INVALID_INDEX;
+
+	ModelCacheFile::View view = {};
+	view.aVertices = model.aPackedVertices.data();
+	view.uNumVertices = static_cast<UINT>(model.aPackedVertices.size());
+	view.Decode = model.Decode;
+	view.auIndices = model.auIndices.data();
+	view.uNumIndices = static_cast<UINT>(model.auIndices.size());
+	view.aMeshes = model.aMeshes.data();
+	view.uNumMeshes = NUM_MESHES;
+	view.aMaterials = &material;
+	view.uNumMaterials = 1u;
+	view.aMeshMeshlets = model.aMeshMeshlets.data();
+	view.aMeshlets = model.aMeshlets.data();
+	view.uNumMeshlets = static_cast<UINT>(model.aMeshlets.size());
+	view.auMeshletVertices = model.auMeshletVertices.data();
+	view.uNumMeshletVertices = static_cast<UINT>(model.auMeshletVertices.size());
+	view.auMeshletTriangles = model.auMeshletTriangles.data();
+	view.uNumMeshletTriangles = static_cast<UINT>(model.auMeshletTriangles.size());
+	view.pStrings = strings.data();
+	view.uStringsSize = static_cast<UINT>(strings.size());
+
+	ModelCacheFile::Key key = {};
+	key.uSourceHash = 0x0123456789ABCDEFull;
+	key.uSourceSize = 1u << 20u;
+
+	const std::filesystem::path cachePath = std::filesystem::temp_directory_path() / "ModelCacheBenchmark.prmc";
+	std::vector<BYTE> aFile;
+	HRESULT hrWrite = S_OK;
+	double writeMs = benchmark::MeasureMs(3u, [&]()
+	{
+		hrWrite = ModelCacheFile::Write(aFile, key, view);
+		std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const CHAR*>(aFile.data()), static_cast<std::streamsize>(aFile.size()));
+		hrWrite = file ? hrWrite : E_FAIL;
+	});
+
+	// MappedFile is Windows only, reading the whole file stands in for the mapping and its prefetch
+	std::vector<BYTE> aMapped;
+	ModelCacheFile::View readView = {};
+	HRESULT hrRead = S_OK;
+	double loadMs = benchmark::MeasureMs(10u, [&]()
+	{
+		std::ifstream file(cachePath, std::ios::binary | std::ios::ate);
+		aMapped.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<CHAR*>(aMapped.data()), static_cast<std::streamsize>(aMapped.size()));
+		hrRead = file ? ModelCacheFile::Read(readView, key, aMapped.data(), aMapped.size()) : E_FAIL;
+	});
+	std::filesystem::remove(cachePath);
+
+	BOOL bIsSame = SUCCEEDED(hrRead)
+		&& isSame(readView.aVertices, readView.uNumVertices, model.aPackedVertices)
+		&& isSame(readView.auIndices, readView.uNumIndices, model.auIndices)
+		&& isSame(readView.aMeshes, readView.uNumMeshes, model.aMeshes)
+		&& isSame(readView.aMeshlets, readView.uNumMeshlets, model.aMeshlets)
+		&& isSame(readView.auMeshletTriangles, readView.uNumMeshletTriangles, model.auMeshletTriangles);
+
+	std::printf("%u meshes, %u vertices, %u triangles, %u meshlets, %.1f MB cache\n", NUM_MESHES, NUM_MESHES * NUM_MESH_VERTICES,
+		static_cast<UINT>(model.auIndices.size() / 3u), static_cast<UINT>(model.aMeshlets.size()), static_cast<double>(aFile.size()) / (1024.0 * 1024.0));
+	std::printf("  optimize, pack and build meshlets:       %8.3f ms\n", rebuildMs);
+	std::printf("  ModelCacheFile::Write to a file:         %8.3f ms\n", writeMs);
+	std::printf("  read the file and ModelCacheFile::Read:  %8.3f ms%s\n", loadMs, bIsSame ? "" : " (sections differ)");
+
+	return SUCCEEDED(hrWrite) && bIsSame ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+#include "pch.h"
+
+#include <random>
+
+#include "Graphics/OcclusionCuller.h"
+#include "Utility/JobSystem.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+// Culls 20k small boxes in a street of 200 box shaped buildings, viewed from street level
+int main()
+{
+	constexpr const UINT NUM_BUILDINGS_X = 10u;
+	constexpr const UINT NUM_BUILDINGS_Z = 20u;
+	constexpr const UINT NUM_BOXES = 20000u;
+	constexpr const FLOAT NEAREST_BUILDING_Z = 20.0f;
+
+	OccluderGeometry cube;
+	for (UINT i = 0u; i < 8u; ++i)
+	{
+		cube.aPositions.push_back(XMFLOAT3(i & 1u ? 0.5f : -0.5f, i & 2u ? 0.5f : -0.5f, i & 4u ? 0.5f : -0.5f));
+	}
+	cube.aIndices =
+	{
+		0, 2, 1, 1, 2, 3,	// -z
+		4, 5, 6, 5, 7, 6,	// +z
+		0, 1, 4, 1, 5, 4,	// -y
+		2, 6, 3, 3, 6, 7,	// +y
+		0, 4, 2, 2, 4, 6,	// -x
+		1, 3, 5, 3, 7, 5,	// +x
+	};
+	cube.aMeshes.push_back(OccluderGeometry::Mesh{ .uBaseVertex = 0u, .uNumVertices = 8u, .uBaseIndex = 0u, .uNumIndices = 36u });
+
+	// Buildings line both sides of a street along z, leaving the middle open
+	std::vector<XMFLOAT4X4> aBuildings;
+	for (UINT z = 0u; z < NUM_BUILDINGS_Z; ++z)
+	{
+		for (UINT x = 0u; x < NUM_BUILDINGS_X; ++x)
+		{
+			FLOAT centerX = (static_cast<FLOAT>(x) - 4.5f) * 20.0f + (x < 5u ? -6.0f : 6.0f);
+			FLOAT centerZ = NEAREST_BUILDING_Z + 6.0f + static_cast<FLOAT>(z) * 16.0f;
+			XMFLOAT4X4 world;
+			XMStoreFloat4x4(&world, XMMatrixScaling(12.0f, 40.0f, 12.0f) * XMMatrixTranslation(centerX, 20.0f, centerZ));
+			aBuildings.push_back(world);
+		}
+	}
+
+	std::mt19937 generator(1u);
+	std::uniform_real_distribution<FLOAT> positionX(-100.0f, 100.0f);
+	std::uniform_real_distribution<FLOAT> positionY(0.5f, 5.0f);
+	std::uniform_real_distribution<FLOAT> positionZ(5.0f, 350.0f);
+	std::vector<MeshBounds> aBounds(NUM_BOXES);
+	for (MeshBounds& bounds : aBounds)
+	{
+		bounds.Center = XMFLOAT3(positionX(generator), positionY(generator), positionZ(generator));
+		bounds.Extents = XMFLOAT3(0.5f, 0.5f, 0.5f);
+		bounds.Radius = 0.87f;
+	}
+
+	XMMATRIX viewProjection = XMMatrixLookToLH(XMVectorSet(0.0f, 2.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f))
+		* XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+	XMFLOAT4X4 viewProjectionMatrix;
+	XMStoreFloat4x4(&viewProjectionMatrix, viewProjection);
+
+	OcclusionCuller culler;
+	auto cull = [&](JobSystem& jobSystem)
+	{
+		culler.Reset();
+		for (const XMFLOAT4X4& world : aBuildings)
+		{
+			culler.AddOccluder(cube, 0u, world);
+		}
+		for (const MeshBounds& bounds : aBounds)
+		{
+			culler.AddBounds(bounds);
+		}
+		culler.Cull(viewProjectionMatrix, jobSystem);
+	};
+
+	// Culling is conservative, nothing in front of every building may be rejected
+	auto countWrongRejects = [&]()
+	{
+		UINT uNumWrongRejects = 0u;
+		for (UINT i = 0u; i < NUM_BOXES; ++i)
+		{
+			if (aBounds[i].Center.z + aBounds[i].Extents.z < NEAREST_BUILDING_Z && !culler.IsVisible(i))
+			{
+				++uNumWrongRejects;
+			}
+		}
+		return uNumWrongRejects;
+	};
+
+	JobSystem singleThread(0u);
+	double singleMs = benchmark::MeasureMs(20u, [&]() { cull(singleThread); });
+	UINT uNumSingleWrongRejects = countWrongRejects();
+
+	JobSystem& jobSystem = JobSystem::GetInstance();
+	double parallelMs = benchmark::MeasureMs(20u, [&]() { cull(jobSystem); });
+	UINT uNumParallelWrongRejects = countWrongRejects();
+
+	OcclusionCuller::Stats stats = culler.GetStats();
+	std::printf("%u occluders, %u triangles rasterized, %u of %u boxes occluded, %ux%u depth buffer\n",
+		stats.uNumOccluders, stats.uNumRasterizedTriangles, stats.uNumOccluded, stats.uNumObjects, OcclusionCuller::WIDTH, OcclusionCuller::HEIGHT);
+	std::printf("  OcclusionCuller (1 thread):    %7.3f ms, %u wrongly rejected\n", singleMs, uNumSingleWrongRejects);
+	std::printf("  OcclusionCuller (%2u threads): %7.3f ms, %u wrongly rejected\n", jobSystem.GetNumThreads(), parallelMs, uNumParallelWrongRejects);
+
+	return uNumSingleWrongRejects == 0u && uNumParallelWrongRejects == 0u && stats.uNumOccluded > 0u ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+#include "pch.h"
+
+#include "Scene/SceneFile.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+// Writes and reads a cooked scene of 2000 renderables over 500 geometries of 20 meshes, about 20 MB of geometry
+int main()
+{
+	constexpr const UINT NUM_RENDERABLES = 2000u;
+	constexpr const UINT NUM_GEOMETRIES = 500u;
+	constexpr const UINT NUM_MESHES_PER_GEOMETRY = 20u;
+	constexpr const UINT NUM_MATERIALS = 50u;
+	constexpr const UINT NUM_TEXTURES = 100u;
+	constexpr const UINT NUM_BINDINGS_PER_RENDERABLE = 3u;
+	constexpr const UINT NUM_VERTICES = 1000u;
+	constexpr const UINT NUM_INDICES = 3000u;
+	constexpr const UINT NUM_MESH_INDICES = NUM_INDICES / NUM_MESHES_PER_GEOMETRY;
+	constexpr const eVertexType VERTEX_TYPE = eVertexType::POS_NORM_TEXCOORD;
+
+	const std::string strings = std::string("root") + '\0' + "texture.dds" + '\0';
+
+	std::vector<SceneFile::Geometry> aGeometries(NUM_GEOMETRIES);
+	std::vector<SceneFile::Mesh> aMeshes;
+	std::vector<BYTE> aData;
+	for (SceneFile::Geometry& geometry : aGeometries)
+	{
+		geometry = {};
+		geometry.uVertices = aData.size();
+		geometry.uIndices = aData.size() + NUM_VERTICES * VERTEX_SIZE[static_cast<size_t>(VERTEX_TYPE)];
+		geometry.uNumVertices = NUM_VERTICES;
+		geometry.uNumIndices = NUM_INDICES;
+		geometry.uVertexType = static_cast<UINT>(VERTEX_TYPE);
+		geometry.uFirstMesh = static_cast<UINT>(aMeshes.size());
+		geometry.uNumMeshes = NUM_MESHES_PER_GEOMETRY;
+		aData.resize(geometry.uIndices + NUM_INDICES * sizeof(WORD));
+
+		for (UINT i = 0u; i < NUM_MESHES_PER_GEOMETRY; ++i)
+		{
+			SceneFile::Mesh mesh = {};
+			mesh.uNumIndices = NUM_MESH_INDICES;
+			mesh.uBaseIndex = i * NUM_MESH_INDICES;
+			mesh.uMaterialIndex = i % NUM_BINDINGS_PER_RENDERABLE;
+			mesh.uNumLods = 2u;
+			mesh.aLods[0] = { .uNumIndices = NUM_MESH_INDICES / 2u, .uBaseIndex = i * NUM_MESH_INDICES, .Error = 1.0f };
+			aMeshes.push_back(mesh);
+		}
+	}
+
+	std::vector<SceneFile::Renderable> aRenderables(NUM_RENDERABLES);
+	std::vector<UINT> auMaterialBindings;
+	for (UINT i = 0u; i < NUM_RENDERABLES; ++i)
+	{
+		aRenderables[i] = {};
+		aRenderables[i].uName = i == 0u ? 0u : SceneFile::INVALID_INDEX;
+		aRenderables[i].uParent = i == 0u ? SceneFile::INVALID_INDEX : i - 1u;
+		aRenderables[i].uGeometry = i % NUM_GEOMETRIES;
+		aRenderables[i].uFirstBinding = static_cast<UINT>(auMaterialBindings.size());
+		aRenderables[i].uNumBindings = NUM_BINDINGS_PER_RENDERABLE;
+		for (UINT j = 0u; j < NUM_BINDINGS_PER_RENDERABLE; ++j)
+		{
+			auMaterialBindings.push_back((i + j) % NUM_MATERIALS);
+		}
+	}
+
+	std::vector<SceneFile::Material> aMaterials(NUM_MATERIALS, SceneFile::Material{ .uName = 0u, .uDiffuse = 0u, .uSpecularExponent = SceneFile::INVALID_INDEX, .uNormal = 1u });
+	std::vector<SceneFile::Texture> aTextures(NUM_TEXTURES, SceneFile::Texture{ .uPath = 5u });
+
+	const SceneFile::View view =
+	{
+		.aRenderables = aRenderables.data(),
+		.uNumRenderables = NUM_RENDERABLES,
+		.aGeometries = aGeometries.data(),
+		.uNumGeometries = NUM_GEOMETRIES,
+		.aMeshes = aMeshes.data(),
+		.uNumMeshes = static_cast<UINT>(aMeshes.size()),
+		.auMaterialBindings = auMaterialBindings.data(),
+		.uNumMaterialBindings = static_cast<UINT>(auMaterialBindings.size()),
+		.aMaterials = aMaterials.data(),
+		.uNumMaterials = NUM_MATERIALS,
+		.aTextures = aTextures.data(),
+		.uNumTextures = NUM_TEXTURES,
+		.aLights = nullptr,
+		.uNumLights = 0u,
+		.pStrings = strings.data(),
+		.uStringsSize = static_cast<UINT>(strings.size()),
+		.pData = aData.data(),
+		.uDataSize = aData.size(),
+	};
+
+	std::vector<BYTE> aFile;
+	HRESULT hrWrite = S_OK;
+	double writeMs = benchmark::MeasureMs(5u, [&]() { hrWrite = SceneFile::Write(aFile, view); });
+
+	// Read only checks the records, it never touches the geometry
+	SceneFile::View readView = {};
+	HRESULT hrRead = S_OK;
+	double readMs = benchmark::MeasureMs(100u, [&]() { hrRead = SceneFile::Read(readView, aFile.data(), aFile.size()); });
+
+	BOOL bIsSame = SUCCEEDED(hrRead)
+		&& readView.uNumRenderables == NUM_RENDERABLES
+		&& readView.uNumMeshes == aMeshes.size()
+		&& memcmp(readView.aMeshes, aMeshes.data(), aMeshes.size() * sizeof(SceneFile::Mesh)) == 0
+		&& memcmp(readView.aRenderables, aRenderables.data(), aRenderables.size() * sizeof(SceneFile::Renderable)) == 0;
+
+	std::printf("%u renderables, %u meshes, %.1f MB file\n", NUM_RENDERABLES, static_cast<UINT>(aMeshes.size()), static_cast<double>(aFile.size()) / (1024.0 * 1024.0));
+	std::printf("  SceneFile::Write: %8.3f ms\n", writeMs);
+	std::printf("  SceneFile::Read:  %8.3f ms%s\n", readMs, bIsSame ? "" : " (records differ)");
+
+	return SUCCEEDED(hrWrite) && bIsSame ? 0 : 1;
+}
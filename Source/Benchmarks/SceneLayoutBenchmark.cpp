@@ -0,0 +1,239 @@
+#include "pch.h"
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "Graphics/FrustumCuller.h"
+#include "Utility/JobSystem.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+namespace
+{
+	// World matrix and local mesh bounds on the heap, with the accessors the renderer used on a renderable
+	class Object final
+	{
+	public:
+		explicit Object(_In_ FXMMATRIX world, _In_ const std::vector<MeshBounds>& aLocalBounds, _In_ BOOL bIsMoving)
+			: m_World(world)
+			, m_aLocalBounds(aLocalBounds)
+			, m_bIsMoving(bIsMoving)
+		{
+		}
+
+		// Spins the object in place like a Renderable::Update override, returns whether the world matrix changed
+		BOOL Update(_In_ FLOAT deltaTime) noexcept
+		{
+			if (!m_bIsMoving)
+			{
+				return FALSE;
+			}
+
+			m_World = XMMatrixRotationY(deltaTime) * m_World;
+			return TRUE;
+		}
+
+		UINT GetNumMeshes() const noexcept
+		{
+			return static_cast<UINT>(m_aLocalBounds.size());
+		}
+
+		const MeshBounds& GetLocalBounds(_In_ UINT uMeshIndex) const noexcept
+		{
+			return m_aLocalBounds[uMeshIndex];
+		}
+
+		// Transforms the local bounds on every call, as Renderable::GetWorldBounds does
+		MeshBounds GetWorldBounds(_In_ UINT uMeshIndex) const noexcept
+		{
+			XMFLOAT4X4 world;
+			XMStoreFloat4x4(&world, m_World);
+			return TransformMeshBounds(m_aLocalBounds[uMeshIndex], world);
+		}
+
+		const XMMATRIX& GetWorldMatrix() const noexcept
+		{
+			return m_World;
+		}
+
+	private:
+		XMMATRIX m_World;
+		std::vector<MeshBounds> m_aLocalBounds;
+		BOOL m_bIsMoving;
+	};
+
+	struct CullResult
+	{
+		UINT uNumVisibleMeshes;
+		double depthSum;
+	};
+
+	// Sums the view depth of every visible mesh, standing in for building the draw list
+	void addVisible(_Inout_ CullResult& result, _In_ FXMMATRIX view, _In_ FXMVECTOR position, _In_ UINT uNumVisibleMeshes) noexcept
+	{
+		if (uNumVisibleMeshes > 0u)
+		{
+			result.uNumVisibleMeshes += uNumVisibleMeshes;
+			result.depthSum += XMVectorGetZ(XMVector3Transform(position, view)) * uNumVisibleMeshes;
+		}
+	}
+}
+
+// Updates and culls 100k renderables kept in a name keyed map and in the dense arrays of Scene, 1 in 10 moves every frame
+int main()
+{
+	constexpr const UINT NUM_RENDERABLES = 100000u;
+	constexpr const UINT NUM_RUNS = 10u;
+	constexpr const FLOAT DELTA_TIME = 0.01f;
+
+	const XMMATRIX view = XMMatrixLookToLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.3f, 0.1f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, view * XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f));
+	const Frustum frustum = ExtractFrustum(viewProjection);
+
+	// The old layout, and the dense arrays filled in the same order Scene::AddRenderable fills them
+	std::unordered_map<std::wstring, std::shared_ptr<Object>> mapRenderables;
+	std::vector<std::shared_ptr<Object>> aRenderables;
+	std::vector<XMFLOAT4X4> aWorldMatrices;
+	std::vector<UINT> auFirstMeshes;
+	std::vector<MeshBounds> aMeshBounds;
+
+	std::mt19937 generator(1u);
+	std::uniform_real_distribution<FLOAT> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<FLOAT> offset(-2.0f, 2.0f);
+	std::uniform_real_distribution<FLOAT> extent(0.1f, 3.0f);
+	std::uniform_int_distribution<UINT> numMeshes(1u, 3u);
+	for (UINT i = 0u; i < NUM_RENDERABLES; ++i)
+	{
+		std::vector<MeshBounds> aLocalBounds(numMeshes(generator));
+		for (MeshBounds& bounds : aLocalBounds)
+		{
+			bounds.Center = XMFLOAT3(offset(generator), offset(generator), offset(generator));
+			bounds.Extents = XMFLOAT3(extent(generator), extent(generator), extent(generator));
+			bounds.Radius = std::sqrt(bounds.Extents.x * bounds.Extents.x + bounds.Extents.y * bounds.Extents.y + bounds.Extents.z * bounds.Extents.z);
+		}
+		XMMATRIX world = XMMatrixTranslation(position(generator), position(generator), position(generator));
+
+		mapRenderables[L"Renderable " + std::to_wstring(i)] = std::make_shared<Object>(world, aLocalBounds, i % 10u == 0u);
+
+		std::shared_ptr<Object> pRenderable = std::make_shared<Object>(world, aLocalBounds, i % 10u == 0u);
+		XMFLOAT4X4 worldMatrix;
+		XMStoreFloat4x4(&worldMatrix, world);
+		auFirstMeshes.push_back(static_cast<UINT>(aMeshBounds.size()));
+		for (UINT j = 0u; j < pRenderable->GetNumMeshes(); ++j)
+		{
+			aMeshBounds.push_back(pRenderable->GetWorldBounds(j));
+		}
+		aWorldMatrices.push_back(worldMatrix);
+		aRenderables.push_back(std::move(pRenderable));
+	}
+	const UINT uNumMeshes = static_cast<UINT>(aMeshBounds.size());
+
+	// Update: the map only spins its objects, the culling walk transforms their bounds later
+	double mapUpdateMs = benchmark::MeasureMs(NUM_RUNS, [&]()
+	{
+		for (auto& iter : mapRenderables)
+		{
+			iter.second->Update(DELTA_TIME);
+		}
+	});
+
+	// Update: the dense arrays copy the matrix and re-transform the bounds of the renderables that moved, like Scene::Update
+	double denseUpdateMs = benchmark::MeasureMs(NUM_RUNS, [&]()
+	{
+		for (UINT i = 0u; i < NUM_RENDERABLES; ++i)
+		{
+			Object* pRenderable = aRenderables[i].get();
+			if (!pRenderable->Update(DELTA_TIME))
+			{
+				continue;
+			}
+
+			XMFLOAT4X4& world = aWorldMatrices[i];
+			XMStoreFloat4x4(&world, pRenderable->GetWorldMatrix());
+			for (UINT j = 0u; j < pRenderable->GetNumMeshes(); ++j)
+			{
+				aMeshBounds[auFirstMeshes[i] + j] = TransformMeshBounds(pRenderable->GetLocalBounds(j), world);
+			}
+		}
+	});
+
+	// Cull: the walks of Renderer::Render before and after the dense arrays, frustum cull then visible meshes per renderable
+	JobSystem& jobSystem = JobSystem::GetInstance();
+	FrustumCuller mapCuller;
+	CullResult mapResult = {};
+	double mapCullMs = benchmark::MeasureMs(NUM_RUNS, [&]()
+	{
+		mapCuller.Reset();
+		for (auto& iter : mapRenderables)
+		{
+			for (UINT i = 0u; i < iter.second->GetNumMeshes(); ++i)
+			{
+				mapCuller.AddBounds(iter.second->GetWorldBounds(i));
+			}
+		}
+		mapCuller.Cull(frustum, jobSystem);
+
+		mapResult = {};
+		UINT uCullIndex = 0u;
+		for (auto& iter : mapRenderables)
+		{
+			const Object* pRenderable = iter.second.get();
+			UINT uNumVisibleMeshes = 0u;
+			for (UINT i = 0u; i < pRenderable->GetNumMeshes(); ++i, ++uCullIndex)
+			{
+				uNumVisibleMeshes += mapCuller.IsVisible(uCullIndex) ? 1u : 0u;
+			}
+			addVisible(mapResult, view, pRenderable->GetWorldMatrix().r[3], uNumVisibleMeshes);
+		}
+	});
+
+	FrustumCuller denseCuller;
+	CullResult denseResult = {};
+	double denseCullMs = benchmark::MeasureMs(NUM_RUNS, [&]()
+	{
+		denseCuller.Reset();
+		for (UINT i = 0u; i < uNumMeshes; ++i)
+		{
+			denseCuller.AddBounds(aMeshBounds[i]);
+		}
+		denseCuller.Cull(frustum, jobSystem);
+
+		denseResult = {};
+		for (UINT uRenderable = 0u; uRenderable < NUM_RENDERABLES; ++uRenderable)
+		{
+			const Object* pRenderable = aRenderables[uRenderable].get();
+			UINT uNumVisibleMeshes = 0u;
+			for (UINT i = 0u; i < pRenderable->GetNumMeshes(); ++i)
+			{
+				uNumVisibleMeshes += denseCuller.IsVisible(auFirstMeshes[uRenderable] + i) ? 1u : 0u;
+			}
+			const XMFLOAT4X4& world = aWorldMatrices[uRenderable];
+			addVisible(denseResult, view, XMVectorSet(world._41, world._42, world._43, 1.0f), uNumVisibleMeshes);
+		}
+	});
+	benchmark::g_Sink = mapResult.depthSum + denseResult.depthSum;
+
+	// Both layouts spun their objects the same number of times, so they see the same meshes at the same depths
+	BOOL bIsMatching = mapResult.uNumVisibleMeshes == denseResult.uNumVisibleMeshes
+		&& std::fabs(mapResult.depthSum - denseResult.depthSum) <= 1e-6 * std::fabs(denseResult.depthSum);
+
+	std::printf("%u renderables, %u meshes, %u visible, %u threads\n", NUM_RENDERABLES, uNumMeshes, denseResult.uNumVisibleMeshes, jobSystem.GetNumThreads());
+	std::printf("  map update:     %8.3f ms\n", mapUpdateMs);
+	std::printf("  dense update:   %8.3f ms\n", denseUpdateMs);
+	std::printf("  map cull:       %8.3f ms\n", mapCullMs);
+	std::printf("  dense cull:     %8.3f ms\n", denseCullMs);
+	std::printf("  map frame:      %8.3f ms\n", mapUpdateMs + mapCullMs);
+	std::printf("  dense frame:    %8.3f ms\n", denseUpdateMs + denseCullMs);
+	if (!bIsMatching)
+	{
+		std::printf("  layouts disagree: %u visible meshes at depth sum %g against %u at %g\n",
+			mapResult.uNumVisibleMeshes, mapResult.depthSum, denseResult.uNumVisibleMeshes, denseResult.depthSum);
+	}
+
+	return bIsMatching ? 0 : 1;
+}
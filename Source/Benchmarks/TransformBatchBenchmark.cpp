@@ -0,0 +1,173 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "Graphics/TransformBatch.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+namespace
+{
+	// Local transform with the accessors TransformBatch gathers from and scatters to, like a renderable
+	class Object final
+	{
+	public:
+		const Transform& GetLocalTransform() const noexcept
+		{
+			return m_Local;
+		}
+
+		void SetLocalTransform(_In_ const Transform& local) noexcept
+		{
+			m_Local = local;
+		}
+
+	private:
+		Transform m_Local;
+	};
+
+	// The steps of Renderable::Scale, rotate and Translate one after the other, for one object
+	void compose(_Inout_ Transform& local, _In_ FXMVECTOR scale, _In_ FXMVECTOR rotation, _In_ FXMVECTOR translation)
+	{
+		XMVECTOR localTranslation = XMVectorMultiply(XMLoadFloat3(&local.Translation), scale);
+		XMStoreFloat3(&local.Scale, XMVectorMultiply(XMLoadFloat3(&local.Scale), scale));
+		XMStoreFloat4(&local.Rotation, XMQuaternionNormalize(XMQuaternionMultiply(XMLoadFloat4(&local.Rotation), rotation)));
+		localTranslation = XMVector3Rotate(localTranslation, rotation);
+		XMStoreFloat3(&local.Translation, XMVectorAdd(localTranslation, translation));
+	}
+
+	FLOAT getMaxDifference(_In_reads_(uCount) const FLOAT* pLeft, _In_reads_(uCount) const FLOAT* pRight, _In_ UINT uCount)
+	{
+		FLOAT maxDifference = 0.0f;
+		for (UINT i = 0u; i < uCount; ++i)
+		{
+			maxDifference = std::max(maxDifference, std::fabs(pLeft[i] - pRight[i]));
+		}
+
+		return maxDifference;
+	}
+}
+
+// Transforms 100k objects one at a time and as a batch, the odd count leaves a tail for the scalar path
+int main()
+{
+	constexpr const UINT NUM_OBJECTS = 100003u;
+
+	std::mt19937 generator(1u);
+	std::uniform_real_distribution<FLOAT> unit(-1.0f, 1.0f);
+	std::vector<std::shared_ptr<Object>> apObjects(NUM_OBJECTS);
+	std::vector<Transform> aExpected(NUM_OBJECTS);
+	for (UINT i = 0u; i < NUM_OBJECTS; ++i)
+	{
+		Transform local;
+		local.Scale = XMFLOAT3(1.0f + unit(generator) * 0.5f, 1.2f, 0.8f);
+		XMStoreFloat4(&local.Rotation, XMQuaternionNormalize(XMVectorSet(unit(generator), unit(generator), unit(generator), unit(generator))));
+		local.Translation = XMFLOAT3(unit(generator) * 10.0f, unit(generator) * 10.0f, unit(generator) * 10.0f);
+
+		apObjects[i] = std::make_shared<Object>();
+		apObjects[i]->SetLocalTransform(local);
+		aExpected[i] = local;
+	}
+
+	// Every operation of the batch on overlapping spans, against the same steps per object
+	Transform delta;
+	delta.Scale = XMFLOAT3(1.1f, 0.9f, 1.0f);
+	XMStoreFloat4(&delta.Rotation, XMQuaternionRotationRollPitchYaw(0.3f, 0.2f, 0.1f));
+	delta.Translation = XMFLOAT3(1.0f, 2.0f, 3.0f);
+
+	TransformBatch batch;
+	batch.Gather(apObjects.data(), NUM_OBJECTS);
+	batch.Compose(0u, NUM_OBJECTS, delta);
+	batch.RotateY(5u, NUM_OBJECTS - 3u, 0.7f);
+	batch.Scale(0u, NUM_OBJECTS, 2.0f, 2.0f, 2.0f);
+	batch.Translate(3u, NUM_OBJECTS, XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f));
+	batch.RotateRollPitchYaw(0u, NUM_OBJECTS, 0.1f, 0.2f, 0.3f);
+	batch.Scatter(apObjects.data(), NUM_OBJECTS);
+
+	const XMVECTOR one = XMVectorSplatOne();
+	const XMVECTOR identity = XMQuaternionIdentity();
+	const XMVECTOR zero = XMVectorZero();
+	for (UINT i = 0u; i < NUM_OBJECTS; ++i)
+	{
+		compose(aExpected[i], XMLoadFloat3(&delta.Scale), XMLoadFloat4(&delta.Rotation), XMLoadFloat3(&delta.Translation));
+		if (i >= 5u && i < NUM_OBJECTS - 3u)
+		{
+			compose(aExpected[i], one, XMQuaternionRotationNormal(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), 0.7f), zero);
+		}
+		compose(aExpected[i], XMVectorReplicate(2.0f), identity, zero);
+		if (i >= 3u)
+		{
+			compose(aExpected[i], one, identity, XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f));
+		}
+		compose(aExpected[i], one, XMQuaternionRotationRollPitchYaw(0.2f, 0.3f, 0.1f), zero);
+	}
+
+	FLOAT maxTransformError = 0.0f;
+	for (UINT i = 0u; i < NUM_OBJECTS; ++i)
+	{
+		const Transform& local = apObjects[i]->GetLocalTransform();
+		maxTransformError = std::max(maxTransformError, getMaxDifference(&local.Scale.x, &aExpected[i].Scale.x, 3u));
+		maxTransformError = std::max(maxTransformError, getMaxDifference(&local.Rotation.x, &aExpected[i].Rotation.x, 4u));
+		maxTransformError = std::max(maxTransformError, getMaxDifference(&local.Translation.x, &aExpected[i].Translation.x, 3u));
+	}
+
+	std::vector<XMFLOAT4X4> aMatrices(NUM_OBJECTS);
+	batch.ComputeMatrices(0u, NUM_OBJECTS, aMatrices.data());
+	FLOAT maxMatrixError = 0.0f;
+	for (UINT i = 0u; i < NUM_OBJECTS; ++i)
+	{
+		Transform local = batch.Get(i);
+		XMFLOAT4X4 expected;
+		XMStoreFloat4x4(&expected, XMMatrixAffineTransformation(XMLoadFloat3(&local.Scale), zero, XMLoadFloat4(&local.Rotation), XMLoadFloat3(&local.Translation)));
+		maxMatrixError = std::max(maxMatrixError, getMaxDifference(&aMatrices[i]._11, &expected._11, 16u));
+	}
+
+	// Per object, a world matrix multiplied by a rotation, and the local transform rotated like Renderable::RotateY does
+	std::vector<XMFLOAT4X4> aWorlds(NUM_OBJECTS, aMatrices[0]);
+	double matrixRotateMs = benchmark::MeasureMs(20u, [&]()
+	{
+		for (XMFLOAT4X4& world : aWorlds)
+		{
+			XMStoreFloat4x4(&world, XMMatrixMultiply(XMLoadFloat4x4(&world), XMMatrixRotationY(0.01f)));
+		}
+	});
+	double quaternionRotateMs = benchmark::MeasureMs(20u, [&]()
+	{
+		for (Transform& local : aExpected)
+		{
+			compose(local, one, XMQuaternionRotationNormal(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), 0.01f), zero);
+		}
+	});
+	double objectMatricesMs = benchmark::MeasureMs(20u, [&]()
+	{
+		for (UINT i = 0u; i < NUM_OBJECTS; ++i)
+		{
+			const Transform& local = aExpected[i];
+			XMStoreFloat4x4(&aWorlds[i], XMMatrixAffineTransformation(XMLoadFloat3(&local.Scale), zero, XMLoadFloat4(&local.Rotation), XMLoadFloat3(&local.Translation)));
+		}
+	});
+	double batchRotateMs = benchmark::MeasureMs(20u, [&]() { batch.RotateY(0u, NUM_OBJECTS, 0.01f); });
+	double batchMatricesMs = benchmark::MeasureMs(20u, [&]() { batch.ComputeMatrices(0u, NUM_OBJECTS, aMatrices.data()); });
+	benchmark::g_Sink = aWorlds[7]._11 + aExpected[3].Rotation.x + aMatrices[5]._22;
+
+	auto perObjectNs = [](double ms) { return ms * 1e6 / NUM_OBJECTS; };
+	std::printf("%u objects, %s lanes\n", NUM_OBJECTS,
+#if defined(__AVX__)
+		"AVX"
+#else
+		"SSE"
+#endif
+	);
+	std::printf("  per object XMMatrixMultiply by a rotation:   %6.2f ns\n", perObjectNs(matrixRotateMs));
+	std::printf("  per object quaternion rotate:                %6.2f ns\n", perObjectNs(quaternionRotateMs));
+	std::printf("  per object XMMatrixAffineTransformation:     %6.2f ns\n", perObjectNs(objectMatricesMs));
+	std::printf("  TransformBatch::RotateY:                     %6.2f ns\n", perObjectNs(batchRotateMs));
+	std::printf("  TransformBatch::ComputeMatrices:             %6.2f ns\n", perObjectNs(batchMatricesMs));
+	std::printf("  largest difference to the per object path: %g in the transforms, %g in the matrices\n", maxTransformError, maxMatrixError);
+
+	return maxTransformError < 1e-4f && maxMatrixError < 1e-4f ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+#include "pch.h"
+
+#include <cmath>
+#include <random>
+
+#include "Scene/TransformHierarchy.h"
+#include "Utility/JobSystem.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+namespace
+{
+	XMMATRIX computeWorldMatrix(_In_ const TransformHierarchy& hierarchy, _In_ UINT uNode)
+	{
+		const Transform& local = hierarchy.GetLocalTransform(uNode);
+		XMMATRIX world = XMMatrixScaling(local.Scale.x, local.Scale.y, local.Scale.z)
+			* XMMatrixRotationQuaternion(XMLoadFloat4(&local.Rotation))
+			* XMMatrixTranslation(local.Translation.x, local.Translation.y, local.Translation.z);
+		UINT uParent = hierarchy.GetParent(uNode);
+
+		return uParent == TransformHierarchy::INVALID_NODE ? world : world * computeWorldMatrix(hierarchy, uParent);
+	}
+}
+
+// Updates a forest of 100k nodes under 1000 roots, fully, with 1000 dirty nodes and with none
+int main()
+{
+	constexpr const UINT NUM_NODES = 100000u;
+	constexpr const UINT NUM_ROOTS = 1000u;
+	constexpr const UINT NUM_DIRTY_NODES = 1000u;
+
+	std::mt19937 generator(5u);
+	std::uniform_real_distribution<FLOAT> angle(-3.0f, 3.0f);
+	std::uniform_real_distribution<FLOAT> scale(0.5f, 2.0f);
+	std::uniform_real_distribution<FLOAT> offset(-5.0f, 5.0f);
+	auto randomTransform = [&]()
+	{
+		Transform transform;
+		transform.Scale = XMFLOAT3(scale(generator), scale(generator), scale(generator));
+		XMStoreFloat4(&transform.Rotation, XMQuaternionRotationRollPitchYaw(angle(generator), angle(generator), angle(generator)));
+		transform.Translation = XMFLOAT3(offset(generator), offset(generator), offset(generator));
+		return transform;
+	};
+
+	TransformHierarchy hierarchy;
+	std::vector<UINT> auNodes;
+	for (UINT i = 0u; i < NUM_NODES; ++i)
+	{
+		UINT uParent = i < NUM_ROOTS ? TransformHierarchy::INVALID_NODE : auNodes[generator() % auNodes.size()];
+		auNodes.push_back(hierarchy.AddNode(uParent, randomTransform()));
+	}
+
+	std::vector<std::pair<UINT, Transform>> aEdits;
+	for (UINT i = 0u; i < NUM_DIRTY_NODES; ++i)
+	{
+		aEdits.emplace_back(auNodes[generator() % auNodes.size()], randomTransform());
+	}
+
+	JobSystem singleThread(0u);
+	JobSystem& jobSystem = JobSystem::GetInstance();
+
+	// The first update also sorts the nodes by depth
+	double firstMs = benchmark::MeasureMs(1u, [&]() { hierarchy.Update(singleThread); });
+
+	auto updateDirty = [&](JobSystem& updateJobSystem)
+	{
+		for (const auto& [uNode, local] : aEdits)
+		{
+			hierarchy.SetLocalTransform(uNode, local);
+		}
+		hierarchy.Update(updateJobSystem);
+	};
+	double singleDirtyMs = benchmark::MeasureMs(20u, [&]() { updateDirty(singleThread); });
+	double parallelDirtyMs = benchmark::MeasureMs(20u, [&]() { updateDirty(jobSystem); });
+	UINT uNumUpdated = hierarchy.GetNumUpdatedNodes();
+
+	double idleMs = benchmark::MeasureMs(20u, [&]() { hierarchy.Update(jobSystem); });
+
+	FLOAT maxError = 0.0f;
+	for (UINT i = 0u; i < NUM_NODES; i += 97u)
+	{
+		XMFLOAT4X4 expected;
+		XMStoreFloat4x4(&expected, computeWorldMatrix(hierarchy, auNodes[i]));
+		const XMFLOAT4X4& world = hierarchy.GetWorldMatrix(auNodes[i]);
+		for (UINT uRow = 0u; uRow < 4u; ++uRow)
+		{
+			for (UINT uColumn = 0u; uColumn < 4u; ++uColumn)
+			{
+				FLOAT error = std::fabs(world.m[uRow][uColumn] - expected.m[uRow][uColumn]) / (1.0f + std::fabs(expected.m[uRow][uColumn]));
+				maxError = std::max(maxError, error);
+			}
+		}
+	}
+
+	std::printf("%u nodes under %u roots, %u dirty nodes update %u nodes\n", NUM_NODES, NUM_ROOTS, NUM_DIRTY_NODES, uNumUpdated);
+	std::printf("  first update (1 thread):    %8.3f ms\n", firstMs);
+	std::printf("  dirty update (1 thread):    %8.3f ms\n", singleDirtyMs);
+	std::printf("  dirty update (%2u threads): %8.3f ms\n", jobSystem.GetNumThreads(), parallelDirtyMs);
+	std::printf("  idle update:                %8.3f ms\n", idleMs);
+	std::printf("  largest relative error against the composed matrices: %g\n", maxError);
+
+	return maxError < 1e-3f ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+#include "pch.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#include "Graphics/VertexQuantization.h"
+
+#include "Benchmark.h"
+
+using namespace pr;
+
+// Packs the vertices of a 400x400 height field with normals in every direction, 4 at a time and one at a time
+int main()
+{
+	constexpr const UINT GRID_SIZE = 400u;
+	constexpr const UINT NUM_VERTICES = GRID_SIZE * GRID_SIZE;
+
+	std::mt19937 generator(1u);
+	std::uniform_real_distribution<FLOAT> unit(-1.0f, 1.0f);
+	std::vector<VertexPNT> aVertices(NUM_VERTICES);
+	for (UINT z = 0u; z < GRID_SIZE; ++z)
+	{
+		for (UINT x = 0u; x < GRID_SIZE; ++x)
+		{
+			FLOAT fx = static_cast<FLOAT>(x) * 0.25f;
+			FLOAT fz = static_cast<FLOAT>(z) * 0.25f;
+
+			VertexPNT& vertex = aVertices[z * GRID_SIZE + x];
+			vertex.Position = XMFLOAT3(fx, 2.0f * std::sin(fx * 0.2f) * std::cos(fz * 0.3f), fz);
+			XMStoreFloat3(&vertex.Normal, XMVector3Normalize(XMVectorSet(unit(generator), unit(generator), unit(generator), 0.0f)));
+			vertex.TexCoord = XMFLOAT2(static_cast<FLOAT>(x) / (GRID_SIZE - 1u), static_cast<FLOAT>(z) / (GRID_SIZE - 1u));
+		}
+	}
+
+	const PositionDecode decode = ComputePositionDecode(aVertices.data(), NUM_VERTICES);
+
+	std::vector<VertexPackedPNT> aPackedVertices(NUM_VERTICES);
+	double batchMs = benchmark::MeasureMs(20u, [&]() { EncodeVertices(aPackedVertices.data(), aVertices.data(), NUM_VERTICES, decode); });
+
+	// Single vertices take the scalar path, which has to round the same way
+	std::vector<VertexPackedPNT> aScalarVertices(NUM_VERTICES);
+	double scalarMs = benchmark::MeasureMs(20u, [&]()
+	{
+		for (UINT i = 0u; i < NUM_VERTICES; ++i)
+		{
+			EncodeVertices(&aScalarVertices[i], &aVertices[i], 1u, decode);
+		}
+	});
+	BOOL bIsSame = memcmp(aPackedVertices.data(), aScalarVertices.data(), NUM_VERTICES * sizeof(VertexPackedPNT)) == 0;
+
+	VertexQuantizationError error = MeasureQuantizationError(aPackedVertices.data(), aVertices.data(), NUM_VERTICES, decode);
+
+	// Rounding to the nearest step is off by at most half a step on each axis
+	const FLOAT maxPositionError = 0.5f * std::sqrt(3.0f) * decode.Scale / 65535.0f;
+	BOOL bIsInBounds = error.MaxPositionError <= maxPositionError * 1.001f && error.MaxNormalError < XMConvertToRadians(0.1f) && error.MaxTexCoordError < 1e-3f;
+
+	std::printf("%u vertices, %u bytes packed from %u\n", NUM_VERTICES, static_cast<UINT>(sizeof(VertexPackedPNT)), static_cast<UINT>(sizeof(VertexPNT)));
+	std::printf("  EncodeVertices, 4 at a time:   %8.3f ms\n", batchMs);
+	std::printf("  EncodeVertices, one at a time: %8.3f ms%s\n", scalarMs, bIsSame ? "" : " (vertices differ)");
+	std::printf("  position error %g (bound %g, half a step on each axis), normal error %.4f degrees, texture coordinate error %g\n",
+		error.MaxPositionError, maxPositionError, XMConvertToDegrees(error.MaxNormalError), error.MaxTexCoordError);
+
+	return bIsSame && bIsInBounds ? 0 : 1;
+}
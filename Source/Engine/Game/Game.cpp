@@ -2,6 +2,7 @@
 
 #include "Game/Game.h"
 #include "Graphics/Renderer.h"
+#include "Utility/Profiler.h"
 #include "Utility/Utility.h"
 #include "Window/MainWindow.h"
 
@@ -69,8 +70,15 @@ namespace pr
         hr = m_pMainWindow->Initialize(hInstance, nCmdShow, m_pszGameName);
         CHECK_AND_RETURN_HRESULT(hr, L"Game::Initialize >> MainWindow::Initialize");
 
+        // Loading is profiled as a frame of its own, then discarded from the frame statistics
+        PR_PROFILE_BEGIN_FRAME();
         hr = m_pRenderer->Initialize(m_pMainWindow->GetWindow(), m_pScene);
         CHECK_AND_RETURN_HRESULT(hr, L"Game::Initialize >> Renderer::Initialize");
+        PR_PROFILE_END_FRAME();
+#if PR_ENABLE_PROFILING
+        OutputDebugStringA(Profiler::GetInstance().FormatReport().c_str());
+        Profiler::GetInstance().Reset();
+#endif
 
         return hr;
     }
@@ -105,6 +113,8 @@ namespace pr
             }
             else
             {
+                PR_PROFILE_BEGIN_FRAME();
+
                 // Update our time
                 QueryPerformanceCounter(&endingTime);
                 elapsedMicroseconds.QuadPart = endingTime.QuadPart - startingTime.QuadPart;
@@ -137,6 +147,7 @@ namespace pr
 
                 m_pRenderer->HandleInput(m_pMainWindow->GetKeyboardInput(), m_pMainWindow->GetMouseInput(), deltaTime);
                 m_pMainWindow->ResetMouseMovement();
+                m_pScene->Update(deltaTime);
                 m_pRenderer->Update(deltaTime);
                 if (FAILED(m_pRenderer->Render(m_pScene)))
                 {
@@ -145,11 +156,16 @@ namespace pr
 
                 ++ms_uNumFrames;
                 averageDeltaTime += deltaTime;
+
+                PR_PROFILE_END_FRAME();
             }
         }
         averageDeltaTime /= ms_uNumFrames;
         swprintf_s(szDebugMsg, L"Average Delta Time: %lf, Average FPS: %lf\n", averageDeltaTime, 1.0 / averageDeltaTime);
         OutputDebugString(szDebugMsg);
+#if PR_ENABLE_PROFILING
+        OutputDebugStringA(Profiler::GetInstance().FormatReport().c_str());
+#endif
 
         return static_cast<INT>(msg.wParam);
     }
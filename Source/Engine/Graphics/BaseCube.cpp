@@ -4,19 +4,42 @@
 
 namespace pr
 {
+    BaseCube* BaseCube::sm_pGeometrySource = nullptr;
+
     BaseCube::BaseCube() noexcept
         : Renderable(eVertexType::POS_NORM_TEXCOORD)
     {
     }
 
+    BaseCube::~BaseCube()
+    {
+        if (sm_pGeometrySource == this)
+        {
+            sm_pGeometrySource = nullptr;
+        }
+    }
+
     HRESULT BaseCube::Initialize(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList)
     {
+        if (sm_pGeometrySource)
+        {
+            shareGeometry(*sm_pGeometrySource);
+            return S_OK;
+        }
+
         BasicMeshEntry basicMeshEntry;
         basicMeshEntry.uNumIndices = NUM_INDICES;
+        basicMeshEntry.Bounds = ComputeMeshBounds(&VERTICES[0].Position, sizeof(VertexPNT), NUM_VERTICES);
 
         m_aMeshes.push_back(basicMeshEntry);
 
-        return initialize(pDevice, pCommandList);
+        HRESULT hr = initialize(pDevice, pCommandList);
+        if (SUCCEEDED(hr))
+        {
+            sm_pGeometrySource = this;
+        }
+
+        return hr;
     }
 
     void BaseCube::Update(FLOAT deltaTime)
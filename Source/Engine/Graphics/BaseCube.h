@@ -26,7 +26,7 @@ namespace pr
         BaseCube(BaseCube&& other) = delete;
         BaseCube& operator=(const BaseCube& other) = delete;
         BaseCube& operator=(BaseCube&& other) = delete;
-        ~BaseCube() = default;
+        ~BaseCube();
 
         virtual HRESULT Initialize(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList) override;
         virtual void Update(_In_ FLOAT deltaTime);
@@ -37,6 +37,9 @@ namespace pr
         const void* getVertices() const override;
         const WORD* getIndices() const override;
 
+        // Every cube shares the buffers of the first initialized cube
+        static BaseCube* sm_pGeometrySource;
+
         static constexpr const VertexPNT VERTICES[] =
         {
             {.Position = XMFLOAT3(-1.0f, 1.0f, -1.0f), .Normal = XMFLOAT3(0.0f, 1.0f, 0.0f), .TexCoord = XMFLOAT2(1.0f, 0.0f) },
@@ -0,0 +1,105 @@
+#include "pch.h"
+
+#include "Graphics/Bounds.h"
+
+#include <cfloat>
+#include <cmath>
+
+namespace pr
+{
+	namespace
+	{
+		inline const XMFLOAT3& getPosition(_In_ const XMFLOAT3* pPositions, _In_ size_t uStride, _In_ UINT uIndex) noexcept
+		{
+			return *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const BYTE*>(pPositions) + uStride * uIndex);
+		}
+
+		XMFLOAT4 normalizePlane(_In_ FLOAT a, _In_ FLOAT b, _In_ FLOAT c, _In_ FLOAT d) noexcept
+		{
+			FLOAT length = std::sqrt(a * a + b * b + c * c);
+			FLOAT invLength = length > 0.0f ? 1.0f / length : 0.0f;
+
+			return XMFLOAT4(a * invLength, b * invLength, c * invLength, d * invLength);
+		}
+	}
+
+	MeshBounds ComputeMeshBounds(_In_ const XMFLOAT3* pPositions, _In_ size_t uStride, _In_ UINT uNumPositions) noexcept
+	{
+		MeshBounds bounds =
+		{
+			.Center = XMFLOAT3(0.0f, 0.0f, 0.0f),
+			.Radius = 0.0f,
+			.Extents = XMFLOAT3(0.0f, 0.0f, 0.0f),
+		};
+
+		if (uNumPositions == 0u)
+		{
+			return bounds;
+		}
+
+		XMFLOAT3 minimum(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3 maximum(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (UINT i = 0u; i < uNumPositions; ++i)
+		{
+			const XMFLOAT3& position = getPosition(pPositions, uStride, i);
+			minimum = XMFLOAT3(std::min(minimum.x, position.x), std::min(minimum.y, position.y), std::min(minimum.z, position.z));
+			maximum = XMFLOAT3(std::max(maximum.x, position.x), std::max(maximum.y, position.y), std::max(maximum.z, position.z));
+		}
+
+		bounds.Center = XMFLOAT3((minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f);
+		bounds.Extents = XMFLOAT3((maximum.x - minimum.x) * 0.5f, (maximum.y - minimum.y) * 0.5f, (maximum.z - minimum.z) * 0.5f);
+
+		// The farthest vertex from the box center is never worse than the half diagonal
+		FLOAT radiusSquared = 0.0f;
+		for (UINT i = 0u; i < uNumPositions; ++i)
+		{
+			const XMFLOAT3& position = getPosition(pPositions, uStride, i);
+			FLOAT x = position.x - bounds.Center.x;
+			FLOAT y = position.y - bounds.Center.y;
+			FLOAT z = position.z - bounds.Center.z;
+			radiusSquared = std::max(radiusSquared, x * x + y * y + z * z);
+		}
+		bounds.Radius = std::sqrt(radiusSquared);
+
+		return bounds;
+	}
+
+	MeshBounds TransformMeshBounds(_In_ const MeshBounds& bounds, _In_ const XMFLOAT4X4& world) noexcept
+	{
+		const XMFLOAT3& c = bounds.Center;
+		const XMFLOAT3& e = bounds.Extents;
+
+		FLOAT scaleX = world._11 * world._11 + world._12 * world._12 + world._13 * world._13;
+		FLOAT scaleY = world._21 * world._21 + world._22 * world._22 + world._23 * world._23;
+		FLOAT scaleZ = world._31 * world._31 + world._32 * world._32 + world._33 * world._33;
+
+		return MeshBounds
+		{
+			.Center = XMFLOAT3(
+				c.x * world._11 + c.y * world._21 + c.z * world._31 + world._41,
+				c.x * world._12 + c.y * world._22 + c.z * world._32 + world._42,
+				c.x * world._13 + c.y * world._23 + c.z * world._33 + world._43
+			),
+			.Radius = bounds.Radius * std::sqrt(std::max(scaleX, std::max(scaleY, scaleZ))),
+			.Extents = XMFLOAT3(
+				e.x * std::fabs(world._11) + e.y * std::fabs(world._21) + e.z * std::fabs(world._31),
+				e.x * std::fabs(world._12) + e.y * std::fabs(world._22) + e.z * std::fabs(world._32),
+				e.x * std::fabs(world._13) + e.y * std::fabs(world._23) + e.z * std::fabs(world._33)
+			),
+		};
+	}
+
+	Frustum ExtractFrustum(_In_ const XMFLOAT4X4& m) noexcept
+	{
+		Frustum frustum;
+
+		frustum.aPlanes[0] = normalizePlane(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41);
+		frustum.aPlanes[1] = normalizePlane(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41);
+		frustum.aPlanes[2] = normalizePlane(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42);
+		frustum.aPlanes[3] = normalizePlane(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42);
+		frustum.aPlanes[4] = normalizePlane(m._13, m._23, m._33, m._43);
+		frustum.aPlanes[5] = normalizePlane(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43);
+
+		return frustum;
+	}
+}
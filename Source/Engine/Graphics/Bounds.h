@@ -0,0 +1,50 @@
+#pragma once
+
+#include "pch.h"
+
+namespace pr
+{
+	// Axis aligned box given by center and half extents, plus the bounding sphere around the same center
+	struct MeshBounds
+	{
+		XMFLOAT3 Center;
+		FLOAT Radius;
+		XMFLOAT3 Extents;
+	};
+	static_assert(sizeof(MeshBounds) == 28);
+
+	// Planes as (normal, distance) with normals pointing inside: left, right, bottom, top, near, far
+	struct Frustum
+	{
+		static constexpr const UINT NUM_PLANES = 6u;
+
+		XMFLOAT4 aPlanes[NUM_PLANES];
+	};
+
+	struct Sphere
+	{
+		XMFLOAT3 Center;
+		FLOAT Radius;
+	};
+
+	// Axis aligned box given by its corners
+	struct Box
+	{
+		XMFLOAT3 Min;
+		XMFLOAT3 Max;
+	};
+
+	// Segment from the origin along a normalized direction
+	struct Ray
+	{
+		XMFLOAT3 Origin;
+		FLOAT Length;
+		XMFLOAT3 Direction;
+	};
+
+	MeshBounds ComputeMeshBounds(_In_ const XMFLOAT3* pPositions, _In_ size_t uStride, _In_ UINT uNumPositions) noexcept;
+	MeshBounds TransformMeshBounds(_In_ const MeshBounds& bounds, _In_ const XMFLOAT4X4& world) noexcept;
+
+	// Extracts the planes from a row vector view projection matrix with D3D clip space depth [0, w]
+	Frustum ExtractFrustum(_In_ const XMFLOAT4X4& viewProjection) noexcept;
+}
@@ -0,0 +1,485 @@
+#include "pch.h"
+
+#include "Graphics/ClusteredLightCuller.h"
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <immintrin.h>
+
+#include "Utility/JobSystem.h"
+#include "Utility/Profiler.h"
+
+namespace pr
+{
+	namespace
+	{
+		constexpr const UINT LIGHTS_PER_JOB = 256u;
+		constexpr const UINT NUM_TILES = ClusteredLightCuller::NUM_CLUSTERS_X * ClusteredLightCuller::NUM_CLUSTERS_Y;
+
+		// Bit i is set when the distance of the point to plane i passes the comparison
+		template <typename Compare>
+		UINT testPlanes(_In_ const FLOAT* aPlane, _In_ const FLOAT* aPlaneZ, _In_ UINT uNumPlanes, _In_ __m128 side, _In_ __m128 z, _In_ Compare compare) noexcept
+		{
+			UINT uMask = 0u;
+			for (UINT i = 0u; i < uNumPlanes; i += 4u)
+			{
+				__m128 distance = _mm_add_ps(_mm_mul_ps(side, _mm_load_ps(aPlane + i)), _mm_mul_ps(z, _mm_load_ps(aPlaneZ + i)));
+				uMask |= static_cast<UINT>(_mm_movemask_ps(compare(distance))) << i;
+			}
+
+			return uMask;
+		}
+
+		// Tiles [uOutMin, uOutMax] touched by the part of a sphere in front of the eye, FALSE when it misses all of them.
+		// Only planes the whole sphere lies on one side of narrow the range, so spheres around the eye work as well.
+		BOOL getTileRange(
+			_Out_ UINT& uOutMin,
+			_Out_ UINT& uOutMax,
+			_In_ const FLOAT* aPlane,
+			_In_ const FLOAT* aPlaneZ,
+			_In_ UINT uNumPlanes,
+			_In_ UINT uNumTiles,
+			_In_ FLOAT side,
+			_In_ FLOAT z,
+			_In_ FLOAT radius
+		) noexcept
+		{
+			__m128 sideV = _mm_set1_ps(side);
+			__m128 zV = _mm_set1_ps(z);
+			__m128 radiusV = _mm_set1_ps(radius);
+			__m128 negativeRadiusV = _mm_set1_ps(-radius);
+
+			// Plane i separates tile i - 1 from tile i, positive distances lie towards the higher tiles
+			UINT uBeyond = testPlanes(aPlane, aPlaneZ, uNumPlanes, sideV, zV, [radiusV](__m128 distance) { return _mm_cmpge_ps(distance, radiusV); });
+			UINT uTouching = testPlanes(aPlane, aPlaneZ, uNumPlanes, sideV, zV, [negativeRadiusV](__m128 distance) { return _mm_cmpgt_ps(distance, negativeRadiusV); });
+
+			uOutMin = 0u;
+			uOutMax = 0u;
+			if (!(uTouching & 1u) || (uBeyond & (1u << uNumTiles)))
+			{
+				return FALSE;
+			}
+
+			UINT uInnerPlanes = ((1u << uNumTiles) - 1u) & ~1u;
+			UINT uLowerBounds = uBeyond & uInnerPlanes;
+			UINT uUpperBounds = ~uTouching & uInnerPlanes;
+			uOutMin = uLowerBounds ? 31u - static_cast<UINT>(std::countl_zero(uLowerBounds)) : 0u;
+			uOutMax = uUpperBounds ? static_cast<UINT>(std::countr_zero(uUpperBounds)) - 1u : uNumTiles - 1u;
+
+			return TRUE;
+		}
+	}
+
+	ClusteredLightCuller::ClusteredLightCuller() noexcept
+		: m_aViewLights()
+		, m_auSliceLightOffsets(NUM_CLUSTERS_Z + 1u, 0u)
+		, m_auSliceLights()
+		, m_aClusterRows(static_cast<size_t>(NUM_CLUSTERS_Y) * NUM_CLUSTERS_Z)
+		, m_aSlices(NUM_CLUSTERS_Z)
+		, m_aClusters(NUM_CLUSTERS, LightCluster{})
+		, m_auLightIndices()
+		, m_aPlaneX()
+		, m_aPlaneZX()
+		, m_aPlaneY()
+		, m_aPlaneZY()
+		, m_ProjectionX(0.0f)
+		, m_ProjectionY(0.0f)
+		, m_NearZ(0.0f)
+		, m_FarZ(0.0f)
+		, m_DepthScale(0.0f)
+		, m_DepthBias(0.0f)
+		, m_uNumLights(0u)
+		, m_uNumVisibleLights(0u)
+	{
+	}
+
+	void ClusteredLightCuller::SetProjection(_In_ const XMFLOAT4X4& projection, _In_ FLOAT nearZ, _In_ FLOAT farZ) noexcept
+	{
+		if (projection._11 == m_ProjectionX && projection._22 == m_ProjectionY && nearZ == m_NearZ && farZ == m_FarZ)
+		{
+			return;
+		}
+
+		PR_PROFILE_FUNCTION();
+
+		m_ProjectionX = projection._11;
+		m_ProjectionY = projection._22;
+		m_NearZ = nearZ;
+		m_FarZ = farZ;
+		m_DepthScale = static_cast<FLOAT>(NUM_CLUSTERS_Z) / std::log(farZ / nearZ);
+		m_DepthBias = -std::log(nearZ) * m_DepthScale;
+
+		// Planes through the eye between the tiles, x from the left and y from the top of the screen
+		for (UINT i = 0u; i < NUM_PLANES_X; ++i)
+		{
+			FLOAT ndc = -1.0f + 2.0f * static_cast<FLOAT>(i) / static_cast<FLOAT>(NUM_CLUSTERS_X);
+			FLOAT invLength = i <= NUM_CLUSTERS_X ? 1.0f / std::sqrt(m_ProjectionX * m_ProjectionX + ndc * ndc) : 0.0f;
+			m_aPlaneX[i] = m_ProjectionX * invLength;
+			m_aPlaneZX[i] = -ndc * invLength;
+		}
+
+		for (UINT i = 0u; i < NUM_PLANES_Y; ++i)
+		{
+			FLOAT ndc = 1.0f - 2.0f * static_cast<FLOAT>(i) / static_cast<FLOAT>(NUM_CLUSTERS_Y);
+			FLOAT invLength = i <= NUM_CLUSTERS_Y ? 1.0f / std::sqrt(m_ProjectionY * m_ProjectionY + ndc * ndc) : 0.0f;
+			m_aPlaneY[i] = -m_ProjectionY * invLength;
+			m_aPlaneZY[i] = ndc * invLength;
+		}
+
+		// Boxes around the 8 corners of every froxel and spheres around the boxes
+		for (UINT z = 0u; z < NUM_CLUSTERS_Z; ++z)
+		{
+			FLOAT aDepths[2] =
+			{
+				nearZ * std::pow(farZ / nearZ, static_cast<FLOAT>(z) / static_cast<FLOAT>(NUM_CLUSTERS_Z)),
+				nearZ * std::pow(farZ / nearZ, static_cast<FLOAT>(z + 1u) / static_cast<FLOAT>(NUM_CLUSTERS_Z)),
+			};
+
+			for (UINT y = 0u; y < NUM_CLUSTERS_Y; ++y)
+			{
+				ClusterRow& row = m_aClusterRows[z * NUM_CLUSTERS_Y + y];
+				FLOAT aNdcY[2] =
+				{
+					1.0f - 2.0f * static_cast<FLOAT>(y) / static_cast<FLOAT>(NUM_CLUSTERS_Y),
+					1.0f - 2.0f * static_cast<FLOAT>(y + 1u) / static_cast<FLOAT>(NUM_CLUSTERS_Y),
+				};
+
+				for (UINT x = 0u; x < NUM_CLUSTERS_X; ++x)
+				{
+					FLOAT aNdcX[2] =
+					{
+						-1.0f + 2.0f * static_cast<FLOAT>(x) / static_cast<FLOAT>(NUM_CLUSTERS_X),
+						-1.0f + 2.0f * static_cast<FLOAT>(x + 1u) / static_cast<FLOAT>(NUM_CLUSTERS_X),
+					};
+
+					XMFLOAT3 minimum(FLT_MAX, FLT_MAX, FLT_MAX);
+					XMFLOAT3 maximum(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+					for (UINT uCorner = 0u; uCorner < 8u; ++uCorner)
+					{
+						FLOAT depth = aDepths[uCorner & 1u];
+						FLOAT cornerX = aNdcX[(uCorner >> 1u) & 1u] * depth / m_ProjectionX;
+						FLOAT cornerY = aNdcY[(uCorner >> 2u) & 1u] * depth / m_ProjectionY;
+
+						minimum = XMFLOAT3(std::min(minimum.x, cornerX), std::min(minimum.y, cornerY), std::min(minimum.z, depth));
+						maximum = XMFLOAT3(std::max(maximum.x, cornerX), std::max(maximum.y, cornerY), std::max(maximum.z, depth));
+					}
+
+					row.aMinX[x] = minimum.x;
+					row.aMinY[x] = minimum.y;
+					row.aMinZ[x] = minimum.z;
+					row.aMaxX[x] = maximum.x;
+					row.aMaxY[x] = maximum.y;
+					row.aMaxZ[x] = maximum.z;
+					row.aCenterX[x] = (minimum.x + maximum.x) * 0.5f;
+					row.aCenterY[x] = (minimum.y + maximum.y) * 0.5f;
+					row.aCenterZ[x] = (minimum.z + maximum.z) * 0.5f;
+
+					FLOAT extentX = (maximum.x - minimum.x) * 0.5f;
+					FLOAT extentY = (maximum.y - minimum.y) * 0.5f;
+					FLOAT extentZ = (maximum.z - minimum.z) * 0.5f;
+					row.aRadius[x] = std::sqrt(extentX * extentX + extentY * extentY + extentZ * extentZ);
+				}
+			}
+		}
+	}
+
+	void ClusteredLightCuller::Cull(_In_ const XMFLOAT4X4& view, _In_reads_(uNumLights) const LightData* aLights, _In_ UINT uNumLights, _In_ JobSystem& jobSystem)
+	{
+		PR_PROFILE_FUNCTION();
+
+		assert(m_DepthScale > 0.0f);
+
+		m_uNumLights = uNumLights;
+		m_aViewLights.resize(uNumLights);
+
+		{
+			PR_PROFILE_SCOPE("Transform Lights");
+			jobSystem.ParallelFor(
+				uNumLights,
+				LIGHTS_PER_JOB,
+				[this, &view, aLights](UINT uBegin, UINT uEnd)
+				{
+					transformLights(view, aLights, uBegin, uEnd);
+				}
+			);
+		}
+
+		// Bin the lights by depth slice so every slice only visits the lights reaching it
+		{
+			PR_PROFILE_SCOPE("Bin Lights");
+
+			std::fill(m_auSliceLightOffsets.begin(), m_auSliceLightOffsets.end(), 0u);
+			m_uNumVisibleLights = 0u;
+			for (const ViewLight& light : m_aViewLights)
+			{
+				for (INT iSlice = light.iMinZ; iSlice <= light.iMaxZ; ++iSlice)
+				{
+					++m_auSliceLightOffsets[static_cast<size_t>(iSlice) + 1u];
+				}
+				m_uNumVisibleLights += light.iMinZ <= light.iMaxZ ? 1u : 0u;
+			}
+
+			for (UINT uSlice = 0u; uSlice < NUM_CLUSTERS_Z; ++uSlice)
+			{
+				m_auSliceLightOffsets[uSlice + 1u] += m_auSliceLightOffsets[uSlice];
+			}
+
+			m_auSliceLights.resize(m_auSliceLightOffsets[NUM_CLUSTERS_Z]);
+			UINT auFill[NUM_CLUSTERS_Z];
+			memcpy(auFill, m_auSliceLightOffsets.data(), sizeof(auFill));
+			for (UINT uLight = 0u; uLight < uNumLights; ++uLight)
+			{
+				const ViewLight& light = m_aViewLights[uLight];
+				for (INT iSlice = light.iMinZ; iSlice <= light.iMaxZ; ++iSlice)
+				{
+					m_auSliceLights[auFill[iSlice]++] = uLight;
+				}
+			}
+		}
+
+		{
+			PR_PROFILE_SCOPE("Assign Lights");
+			jobSystem.ParallelFor(
+				NUM_CLUSTERS_Z,
+				1u,
+				[this](UINT uBegin, UINT uEnd)
+				{
+					for (UINT uSlice = uBegin; uSlice < uEnd; ++uSlice)
+					{
+						assignSlice(uSlice);
+					}
+				}
+			);
+		}
+
+		// Concatenate the slices, froxels that share no light get an empty range at the current offset
+		{
+			PR_PROFILE_SCOPE("Compact Light Lists");
+
+			size_t uNumLightIndices = 0u;
+			for (const Slice& slice : m_aSlices)
+			{
+				uNumLightIndices += slice.auLightIndices.size();
+			}
+			m_auLightIndices.resize(uNumLightIndices);
+
+			UINT uOffset = 0u;
+			for (UINT uSlice = 0u; uSlice < NUM_CLUSTERS_Z; ++uSlice)
+			{
+				const Slice& slice = m_aSlices[uSlice];
+				if (!slice.auLightIndices.empty())
+				{
+					memcpy(m_auLightIndices.data() + uOffset, slice.auLightIndices.data(), slice.auLightIndices.size() * sizeof(UINT));
+				}
+
+				for (UINT uTile = 0u; uTile < NUM_TILES; ++uTile)
+				{
+					m_aClusters[uSlice * NUM_TILES + uTile] = LightCluster{ .uOffset = uOffset, .uNumLights = slice.auCounts[uTile] };
+					uOffset += slice.auCounts[uTile];
+				}
+			}
+		}
+	}
+
+	XMFLOAT4 ClusteredLightCuller::GetShaderParameters(_In_ FLOAT viewportWidth, _In_ FLOAT viewportHeight) const noexcept
+	{
+		return XMFLOAT4(
+			static_cast<FLOAT>(NUM_CLUSTERS_X) / viewportWidth,
+			static_cast<FLOAT>(NUM_CLUSTERS_Y) / viewportHeight,
+			m_DepthScale,
+			m_DepthBias
+		);
+	}
+
+	const LightCluster* ClusteredLightCuller::GetClusters() const noexcept
+	{
+		return m_aClusters.data();
+	}
+
+	UINT ClusteredLightCuller::GetNumLightIndices() const noexcept
+	{
+		return static_cast<UINT>(m_auLightIndices.size());
+	}
+
+	const UINT* ClusteredLightCuller::GetLightIndices() const noexcept
+	{
+		return m_auLightIndices.data();
+	}
+
+	ClusteredLightCuller::Stats ClusteredLightCuller::GetStats() const noexcept
+	{
+		Stats stats =
+		{
+			.uNumLights = m_uNumLights,
+			.uNumVisibleLights = m_uNumVisibleLights,
+			.uNumLightIndices = static_cast<UINT>(m_auLightIndices.size()),
+			.uMaxLightsPerCluster = 0u,
+		};
+
+		for (const LightCluster& cluster : m_aClusters)
+		{
+			stats.uMaxLightsPerCluster = std::max(stats.uMaxLightsPerCluster, cluster.uNumLights);
+		}
+
+		return stats;
+	}
+
+	INT ClusteredLightCuller::getSlice(_In_ FLOAT viewDepth) const noexcept
+	{
+		if (viewDepth <= m_NearZ)
+		{
+			return 0;
+		}
+
+		return std::min(static_cast<INT>(std::log(viewDepth) * m_DepthScale + m_DepthBias), static_cast<INT>(NUM_CLUSTERS_Z) - 1);
+	}
+
+	void ClusteredLightCuller::transformLights(_In_ const XMFLOAT4X4& view, _In_reads_(uNumLights) const LightData* aLights, _In_ UINT uBegin, _In_ UINT uEnd) noexcept
+	{
+		for (UINT i = uBegin; i < uEnd; ++i)
+		{
+			const LightData& light = aLights[i];
+			ViewLight& viewLight = m_aViewLights[i];
+
+			const XMFLOAT3& p = light.Position;
+			viewLight.Position = XMFLOAT3(
+				p.x * view._11 + p.y * view._21 + p.z * view._31 + view._41,
+				p.x * view._12 + p.y * view._22 + p.z * view._32 + view._42,
+				p.x * view._13 + p.y * view._23 + p.z * view._33 + view._43
+			);
+			viewLight.Radius = light.Range;
+
+			// Spot lights wider than a half space are tested as point lights
+			viewLight.bIsSpot = light.Type == eLightType::SPOT && light.CosOuterAngle > 0.0f;
+			const XMFLOAT3& d = light.Direction;
+			XMFLOAT3 direction(
+				d.x * view._11 + d.y * view._21 + d.z * view._31,
+				d.x * view._12 + d.y * view._22 + d.z * view._32,
+				d.x * view._13 + d.y * view._23 + d.z * view._33
+			);
+			FLOAT length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+			FLOAT invLength = length > 0.0f ? 1.0f / length : 0.0f;
+			viewLight.Direction = XMFLOAT3(direction.x * invLength, direction.y * invLength, direction.z * invLength);
+			viewLight.CosAngle = std::min(light.CosOuterAngle, 1.0f);
+			viewLight.SinAngle = std::sqrt(std::max(1.0f - viewLight.CosAngle * viewLight.CosAngle, 0.0f));
+			viewLight.bIsSpot = viewLight.bIsSpot && length > 0.0f;
+
+			// Empty range until the light is known to reach the frustum
+			viewLight.uMinX = 0u;
+			viewLight.uMaxX = 0u;
+			viewLight.uMinY = 0u;
+			viewLight.uMaxY = 0u;
+			viewLight.iMinZ = 1;
+			viewLight.iMaxZ = 0;
+
+			FLOAT minDepth = viewLight.Position.z - viewLight.Radius;
+			FLOAT maxDepth = viewLight.Position.z + viewLight.Radius;
+			if (maxDepth < m_NearZ || minDepth > m_FarZ)
+			{
+				continue;
+			}
+
+			if (!getTileRange(viewLight.uMinX, viewLight.uMaxX, m_aPlaneX, m_aPlaneZX, NUM_PLANES_X, NUM_CLUSTERS_X, viewLight.Position.x, viewLight.Position.z, viewLight.Radius) ||
+				!getTileRange(viewLight.uMinY, viewLight.uMaxY, m_aPlaneY, m_aPlaneZY, NUM_PLANES_Y, NUM_CLUSTERS_Y, viewLight.Position.y, viewLight.Position.z, viewLight.Radius))
+			{
+				continue;
+			}
+
+			viewLight.iMinZ = getSlice(minDepth);
+			viewLight.iMaxZ = getSlice(maxDepth);
+		}
+	}
+
+	void ClusteredLightCuller::assignSlice(_In_ UINT uSlice) noexcept
+	{
+		Slice& slice = m_aSlices[uSlice];
+		slice.auEntries.clear();
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+
+		for (UINT i = m_auSliceLightOffsets[uSlice]; i < m_auSliceLightOffsets[uSlice + 1u]; ++i)
+		{
+			const UINT uLight = m_auSliceLights[i];
+			const ViewLight& light = m_aViewLights[uLight];
+
+			const __m128 lightX = _mm_set1_ps(light.Position.x);
+			const __m128 lightY = _mm_set1_ps(light.Position.y);
+			const __m128 lightZ = _mm_set1_ps(light.Position.z);
+			const __m128 radius = _mm_set1_ps(light.Radius);
+			const __m128 radiusSquared = _mm_mul_ps(radius, radius);
+			const __m128 directionX = _mm_set1_ps(light.Direction.x);
+			const __m128 directionY = _mm_set1_ps(light.Direction.y);
+			const __m128 directionZ = _mm_set1_ps(light.Direction.z);
+			const __m128 cosAngle = _mm_set1_ps(light.CosAngle);
+			const __m128 sinAngle = _mm_set1_ps(light.SinAngle);
+			const __m128i minX = _mm_set1_epi32(static_cast<INT>(light.uMinX));
+			const __m128i maxX = _mm_set1_epi32(static_cast<INT>(light.uMaxX));
+
+			for (UINT y = light.uMinY; y <= light.uMaxY; ++y)
+			{
+				const ClusterRow& row = m_aClusterRows[uSlice * NUM_CLUSTERS_Y + y];
+				for (UINT x = light.uMinX & ~3u; x <= light.uMaxX; x += 4u)
+				{
+					// Squared distance from the light to the froxel boxes
+					__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(row.aMinX + x), lightX), _mm_sub_ps(lightX, _mm_load_ps(row.aMaxX + x))), zero);
+					__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(row.aMinY + x), lightY), _mm_sub_ps(lightY, _mm_load_ps(row.aMaxY + x))), zero);
+					__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(row.aMinZ + x), lightZ), _mm_sub_ps(lightZ, _mm_load_ps(row.aMaxZ + x))), zero);
+					__m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+					__m128 inside = _mm_cmple_ps(distanceSquared, radiusSquared);
+
+					// Bounding spheres of the froxels against the cone: outside its angle, past its range or behind its apex
+					if (light.bIsSpot)
+					{
+						__m128 clusterRadius = _mm_load_ps(row.aRadius + x);
+						__m128 vx = _mm_sub_ps(_mm_load_ps(row.aCenterX + x), lightX);
+						__m128 vy = _mm_sub_ps(_mm_load_ps(row.aCenterY + x), lightY);
+						__m128 vz = _mm_sub_ps(_mm_load_ps(row.aCenterZ + x), lightZ);
+						__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+						__m128 axial = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, directionX), _mm_mul_ps(vy, directionY)), _mm_mul_ps(vz, directionZ));
+						__m128 radial = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(lengthSquared, _mm_mul_ps(axial, axial)), zero));
+						__m128 coneDistance = _mm_sub_ps(_mm_mul_ps(cosAngle, radial), _mm_mul_ps(axial, sinAngle));
+
+						inside = _mm_and_ps(inside, _mm_cmple_ps(coneDistance, clusterRadius));
+						inside = _mm_and_ps(inside, _mm_cmple_ps(axial, _mm_add_ps(clusterRadius, radius)));
+						inside = _mm_and_ps(inside, _mm_cmpge_ps(axial, _mm_sub_ps(zero, clusterRadius)));
+					}
+
+					__m128i columns = _mm_add_epi32(_mm_set1_epi32(static_cast<INT>(x)), lanes);
+					__m128i inRange = _mm_andnot_si128(_mm_or_si128(_mm_cmplt_epi32(columns, minX), _mm_cmpgt_epi32(columns, maxX)), _mm_set1_epi32(-1));
+					UINT uMask = static_cast<UINT>(_mm_movemask_ps(_mm_and_ps(inside, _mm_castsi128_ps(inRange))));
+
+					while (uMask)
+					{
+						UINT uLane = static_cast<UINT>(std::countr_zero(uMask));
+						uMask &= uMask - 1u;
+						slice.auEntries.push_back((static_cast<UINT64>(y * NUM_CLUSTERS_X + x + uLane) << 32ull) | uLight);
+					}
+				}
+			}
+		}
+
+		// Counting sort by froxel, lights stay in index order inside a froxel
+		UINT auOffsets[NUM_TILES];
+		memset(slice.auCounts, 0, sizeof(slice.auCounts));
+		for (UINT64 uEntry : slice.auEntries)
+		{
+			++slice.auCounts[uEntry >> 32ull];
+		}
+
+		UINT uOffset = 0u;
+		for (UINT uTile = 0u; uTile < NUM_TILES; ++uTile)
+		{
+			auOffsets[uTile] = uOffset;
+			uOffset += slice.auCounts[uTile];
+		}
+
+		slice.auLightIndices.resize(slice.auEntries.size());
+		for (UINT64 uEntry : slice.auEntries)
+		{
+			slice.auLightIndices[auOffsets[uEntry >> 32ull]++] = static_cast<UINT>(uEntry & 0xFFFFFFFFull);
+		}
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/DataTypes.h"
+
+namespace pr
+{
+	class JobSystem;
+
+	// Splits the view frustum into froxels, screen tiles times exponential depth slices, and lists the lights
+	// touching each of them. Every light gets its tile and slice range from SSE plane tests first, then each job
+	// owns one depth slice and refines the range against 4 froxel boxes at a time, sphere tests for point lights
+	// and sphere and cone tests for spot lights. The lists end up in one compact index array, froxel by froxel.
+	class ClusteredLightCuller final
+	{
+	public:
+		static constexpr const UINT NUM_CLUSTERS_X = 16u;
+		static constexpr const UINT NUM_CLUSTERS_Y = 9u;
+		static constexpr const UINT NUM_CLUSTERS_Z = 24u;
+		static constexpr const UINT NUM_CLUSTERS = NUM_CLUSTERS_X * NUM_CLUSTERS_Y * NUM_CLUSTERS_Z;
+		static_assert(NUM_CLUSTERS_X % 4u == 0u);
+
+		struct Stats
+		{
+			UINT uNumLights;
+			UINT uNumVisibleLights;
+			UINT uNumLightIndices;
+			UINT uMaxLightsPerCluster;
+		};
+
+	public:
+		explicit ClusteredLightCuller() noexcept;
+		ClusteredLightCuller(const ClusteredLightCuller& other) = delete;
+		ClusteredLightCuller(ClusteredLightCuller&& other) = delete;
+		ClusteredLightCuller& operator=(const ClusteredLightCuller& other) = delete;
+		ClusteredLightCuller& operator=(ClusteredLightCuller&& other) = delete;
+		~ClusteredLightCuller() noexcept = default;
+
+		// Rebuilds the froxel boxes when the row vector perspective projection or the depth range changed
+		void SetProjection(_In_ const XMFLOAT4X4& projection, _In_ FLOAT nearZ, _In_ FLOAT farZ) noexcept;
+		void Cull(_In_ const XMFLOAT4X4& view, _In_reads_(uNumLights) const LightData* aLights, _In_ UINT uNumLights, _In_ JobSystem& jobSystem);
+
+		// Froxel lookup for the pixel shader: tiles per pixel in x and y, then the scale and bias of log(view depth)
+		XMFLOAT4 GetShaderParameters(_In_ FLOAT viewportWidth, _In_ FLOAT viewportHeight) const noexcept;
+
+		// Froxels are ordered x first, then y from the top of the screen, then depth
+		const LightCluster* GetClusters() const noexcept;
+		UINT GetNumLightIndices() const noexcept;
+		const UINT* GetLightIndices() const noexcept;
+		Stats GetStats() const noexcept;
+
+	private:
+		static constexpr const UINT NUM_PLANES_X = (NUM_CLUSTERS_X + 1u + 3u) & ~3u;
+		static constexpr const UINT NUM_PLANES_Y = (NUM_CLUSTERS_Y + 1u + 3u) & ~3u;
+
+		// View space light with its froxel range, an empty range when it misses the frustum
+		struct ViewLight
+		{
+			XMFLOAT3 Position;
+			FLOAT Radius;
+			XMFLOAT3 Direction;
+			FLOAT CosAngle;
+			FLOAT SinAngle;
+			BOOL bIsSpot;
+			UINT uMinX;
+			UINT uMaxX;
+			UINT uMinY;
+			UINT uMaxY;
+			INT iMinZ;
+			INT iMaxZ;
+		};
+
+		// Boxes and bounding spheres of the froxels of one row, structure of arrays
+		struct ClusterRow
+		{
+			alignas(16) FLOAT aMinX[NUM_CLUSTERS_X];
+			alignas(16) FLOAT aMinY[NUM_CLUSTERS_X];
+			alignas(16) FLOAT aMinZ[NUM_CLUSTERS_X];
+			alignas(16) FLOAT aMaxX[NUM_CLUSTERS_X];
+			alignas(16) FLOAT aMaxY[NUM_CLUSTERS_X];
+			alignas(16) FLOAT aMaxZ[NUM_CLUSTERS_X];
+			alignas(16) FLOAT aCenterX[NUM_CLUSTERS_X];
+			alignas(16) FLOAT aCenterY[NUM_CLUSTERS_X];
+			alignas(16) FLOAT aCenterZ[NUM_CLUSTERS_X];
+			alignas(16) FLOAT aRadius[NUM_CLUSTERS_X];
+		};
+
+		// Light indices of one depth slice sorted by froxel, filled by the job that owns the slice
+		struct Slice
+		{
+			std::vector<UINT64> auEntries;
+			std::vector<UINT> auLightIndices;
+			UINT auCounts[NUM_CLUSTERS_X * NUM_CLUSTERS_Y];
+		};
+
+	private:
+		INT getSlice(_In_ FLOAT viewDepth) const noexcept;
+		void transformLights(_In_ const XMFLOAT4X4& view, _In_reads_(uNumLights) const LightData* aLights, _In_ UINT uBegin, _In_ UINT uEnd) noexcept;
+		void assignSlice(_In_ UINT uSlice) noexcept;
+
+	private:
+		std::vector<ViewLight> m_aViewLights;
+		std::vector<UINT> m_auSliceLightOffsets;
+		std::vector<UINT> m_auSliceLights;
+		std::vector<ClusterRow> m_aClusterRows;
+		std::vector<Slice> m_aSlices;
+		std::vector<LightCluster> m_aClusters;
+		std::vector<UINT> m_auLightIndices;
+		alignas(16) FLOAT m_aPlaneX[NUM_PLANES_X];
+		alignas(16) FLOAT m_aPlaneZX[NUM_PLANES_X];
+		alignas(16) FLOAT m_aPlaneY[NUM_PLANES_Y];
+		alignas(16) FLOAT m_aPlaneZY[NUM_PLANES_Y];
+		FLOAT m_ProjectionX;
+		FLOAT m_ProjectionY;
+		FLOAT m_NearZ;
+		FLOAT m_FarZ;
+		FLOAT m_DepthScale;
+		FLOAT m_DepthBias;
+		UINT m_uNumLights;
+		UINT m_uNumVisibleLights;
+	};
+}
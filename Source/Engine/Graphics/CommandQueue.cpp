@@ -2,6 +2,7 @@
 
 #include "Graphics/CommandQueue.h"
 
+#include "Utility/Profiler.h"
 #include "Utility/Utility.h"
 
 namespace pr
@@ -87,6 +88,8 @@ namespace pr
 
 	HRESULT CommandQueue::ExecuteCommandList(UINT64& uOutFenceValue, ID3D12GraphicsCommandList2* pCommandList) noexcept
 	{
+		PR_PROFILE_FUNCTION();
+
 		HRESULT hr = S_OK;
 
 		hr = pCommandList->Close();
@@ -137,6 +140,7 @@ namespace pr
 	{
 		if (!IsFenceComplete(uFenceValue))
 		{
+			PR_PROFILE_SCOPE("CommandQueue::WaitForFenceValue");
 			m_pFence->SetEventOnCompletion(uFenceValue, m_FenceEvent);
 			::WaitForSingleObject(m_FenceEvent, DWORD_MAX);
 		}
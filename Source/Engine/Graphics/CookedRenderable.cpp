@@ -0,0 +1,203 @@
+#include "pch.h"
+
+#include "Graphics/CookedRenderable.h"
+
+#include "Scene/SceneArchive.h"
+
+namespace pr
+{
+    namespace
+    {
+        constexpr const size_t MAPPED_PAGE_SIZE = 4096u;
+
+        void touchPages(_In_reads_bytes_(uSize) const void* pData, _In_ size_t uSize) noexcept
+        {
+            const volatile BYTE* pBytes = static_cast<const volatile BYTE*>(pData);
+            for (size_t i = 0; i < uSize; i += MAPPED_PAGE_SIZE)
+            {
+                static_cast<void>(pBytes[i]);
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   CookedRenderable::CookedRenderable
+
+      Summary:  Constructor
+
+      Args:     const std::shared_ptr<const SceneArchive>& pArchive
+                  Validated scene file holding the geometry
+                UINT uGeometry
+                  Index of the geometry in the scene file
+                std::vector<std::shared_ptr<Material>>&& aMaterials
+                  Materials the meshes refer to, owned by the scene
+                CookedRenderable* pGeometrySource
+                  Renderable of the same file and geometry that
+                  uploads it, nullptr to upload it here
+
+      Modifies: [m_aMeshes, m_aMaterials, m_bHasNormalMap, m_PositionDecode,
+                 m_pArchive, m_pGeometry, m_pGeometrySource,
+                 m_pSharedGeometryAllocation, m_pSharedOccluderGeometry].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    CookedRenderable::CookedRenderable(
+        _In_ const std::shared_ptr<const SceneArchive>& pArchive,
+        _In_ UINT uGeometry,
+        _In_ std::vector<std::shared_ptr<Material>>&& aMaterials,
+        _In_opt_ CookedRenderable* pGeometrySource
+    )
+        : Renderable(static_cast<eVertexType>(pArchive->GetView().aGeometries[uGeometry].uVertexType))
+        , m_pArchive(pArchive)
+        , m_pGeometry(&pArchive->GetView().aGeometries[uGeometry])
+        , m_pGeometrySource(pGeometrySource)
+        , m_pSharedGeometryAllocation()
+        , m_pSharedOccluderGeometry()
+    {
+        static_assert(SceneFile::MAX_LODS == MAX_LODS);
+
+        const SceneFile::View& view = m_pArchive->GetView();
+
+        m_PositionDecode = m_pGeometry->Decode;
+
+        m_aMeshes.resize(m_pGeometry->uNumMeshes);
+        for (UINT i = 0u; i < m_pGeometry->uNumMeshes; ++i)
+        {
+            const SceneFile::Mesh& mesh = view.aMeshes[m_pGeometry->uFirstMesh + i];
+
+            m_aMeshes[i].uNumIndices = mesh.uNumIndices;
+            m_aMeshes[i].uBaseVertex = mesh.uBaseVertex;
+            m_aMeshes[i].uBaseIndex = mesh.uBaseIndex;
+            m_aMeshes[i].uMaterialIndex = mesh.uMaterialIndex;
+            m_aMeshes[i].Bounds = mesh.Bounds;
+            m_aMeshes[i].uNumLods = mesh.uNumLods;
+            for (UINT uLod = 1u; uLod < mesh.uNumLods; ++uLod)
+            {
+                m_aMeshes[i].aLods[uLod - 1u] =
+                {
+                    .uNumIndices = mesh.aLods[uLod - 1u].uNumIndices,
+                    .uBaseIndex = mesh.aLods[uLod - 1u].uBaseIndex,
+                    .Error = mesh.aLods[uLod - 1u].Error,
+                };
+            }
+        }
+
+        m_aMaterials = std::move(aMaterials);
+        for (const std::shared_ptr<Material>& material : m_aMaterials)
+        {
+            if (material->pNormal)
+            {
+                m_bHasNormalMap = TRUE;
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   CookedRenderable::Load
+
+      Summary:  Touches every page of the vertices and indices in the
+                mapping, so the disk is read on the calling worker and
+                not while Initialize records the upload
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT CookedRenderable::Load()
+    {
+        touchPages(getVertices(), static_cast<size_t>(GetNumVertices()) * VERTEX_SIZE[static_cast<size_t>(m_VertexType)]);
+        touchPages(getIndices(), static_cast<size_t>(GetNumIndices()) * sizeof(WORD));
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   CookedRenderable::Initialize
+
+      Summary:  Records the upload of the geometry straight from the
+                mapped file, unless another renderable of the same
+                geometry is resident, whose buffers are shared then.
+                Occluders share the occluder geometry the same way.
+                The materials belong to the scene, which initializes
+                them
+
+      Args:     ID3D12Device2* pDevice
+                  Device to create the buffers with
+                ID3D12GraphicsCommandList2* pCommandList
+                  Command list to record the upload to
+
+      Modifies: [m_pGeometryAllocation, m_pUploadBuffer,
+                 m_pOccluderGeometry, m_pSharedGeometryAllocation,
+                 m_pSharedOccluderGeometry].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT CookedRenderable::Initialize(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList)
+    {
+        HRESULT hr = S_OK;
+
+        if (m_pGeometryAllocation)
+        {
+            return hr;
+        }
+
+        // Every renderable of a geometry has the same records, so any of them can upload it
+        CookedRenderable& source = m_pGeometrySource ? *m_pGeometrySource : *this;
+        m_pGeometryAllocation = source.m_pSharedGeometryAllocation.lock();
+        if (!m_pGeometryAllocation)
+        {
+            hr = initialize(pDevice, pCommandList);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            source.m_pSharedGeometryAllocation = m_pGeometryAllocation;
+        }
+
+        // Only occluders keep the positions and indices on the CPU, the first resident one of a geometry copies them
+        if (IsOccluder())
+        {
+            if (!m_pOccluderGeometry)
+            {
+                m_pOccluderGeometry = source.m_pSharedOccluderGeometry.lock();
+            }
+            if (!m_pOccluderGeometry)
+            {
+                m_pOccluderGeometry = createOccluderGeometry(*this);
+            }
+
+            source.m_pSharedOccluderGeometry = m_pOccluderGeometry;
+        }
+
+        return hr;
+    }
+
+    void CookedRenderable::Update(_In_ FLOAT deltaTime)
+    {
+        UNREFERENCED_PARAMETER(deltaTime);
+    }
+
+    BOOL CookedRenderable::IsStreamable() const noexcept
+    {
+        return TRUE;
+    }
+
+    UINT CookedRenderable::GetNumVertices() const
+    {
+        return m_pGeometry->uNumVertices;
+    }
+
+    UINT CookedRenderable::GetNumIndices() const
+    {
+        return m_pGeometry->uNumIndices;
+    }
+
+    const void* CookedRenderable::getVertices() const
+    {
+        return m_pArchive->GetView().pData + m_pGeometry->uVertices;
+    }
+
+    const WORD* CookedRenderable::getIndices() const
+    {
+        return reinterpret_cast<const WORD*>(m_pArchive->GetView().pData + m_pGeometry->uIndices);
+    }
+}
@@ -0,0 +1,90 @@
+/*+===================================================================
+  File:      COOKEDRENDERABLE.H
+
+  Summary:   Cooked renderable header file contains declarations of
+             CookedRenderable class, a renderable loaded from a
+             cooked scene file.
+
+  Classes: CookedRenderable
+
+  ?2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/Renderable.h"
+#include "Scene/SceneFile.h"
+
+namespace pr
+{
+    class SceneArchive;
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    CookedRenderable
+
+      Summary:  Renderable whose geometry lives in a mapped scene file.
+                The meshes are copied from the file records and the
+                vertices and indices are uploaded straight from the
+                mapping, nothing is imported or converted
+
+      Methods:  Load
+                  Reads the geometry from the file into memory
+                Initialize
+                  Records the upload of the geometry, or shares it
+                  with the renderables of the same geometry
+                Update
+                  Does nothing, cooked renderables are static
+                IsStreamable
+                  Returns TRUE, the file is mapped for the lifetime of
+                  the renderable
+                GetNumVertices
+                  Returns the number of vertices
+                GetNumIndices
+                  Returns the number of indices
+                CookedRenderable
+                  Constructor.
+                ~CookedRenderable
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class CookedRenderable : public Renderable
+    {
+    public:
+        CookedRenderable() = delete;
+        explicit CookedRenderable(
+            _In_ const std::shared_ptr<const SceneArchive>& pArchive,
+            _In_ UINT uGeometry,
+            _In_ std::vector<std::shared_ptr<Material>>&& aMaterials,
+            _In_opt_ CookedRenderable* pGeometrySource
+        );
+        CookedRenderable(const CookedRenderable& other) = delete;
+        CookedRenderable(CookedRenderable&& other) = delete;
+        CookedRenderable& operator=(const CookedRenderable& other) = delete;
+        CookedRenderable& operator=(CookedRenderable&& other) = delete;
+        virtual ~CookedRenderable() = default;
+
+        virtual HRESULT Load() override;
+        virtual HRESULT Initialize(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList) override;
+        virtual void Update(_In_ FLOAT deltaTime) override;
+        virtual BOOL IsStreamable() const noexcept override;
+
+        virtual UINT GetNumVertices() const override;
+        virtual UINT GetNumIndices() const override;
+
+    protected:
+        const virtual void* getVertices() const override;
+        virtual const WORD* getIndices() const override;
+
+    protected:
+        // Keeps the mapping of the geometry alive
+        std::shared_ptr<const SceneArchive> m_pArchive;
+        const SceneFile::Geometry* m_pGeometry;
+
+        // First renderable of the scene file with the same geometry, nullptr for that one itself
+        CookedRenderable* m_pGeometrySource;
+
+        // Set on the geometry source, the geometry lives while any renderable drawing it is resident
+        std::weak_ptr<const GeometryArena::Allocation> m_pSharedGeometryAllocation;
+        std::weak_ptr<const OccluderGeometry> m_pSharedOccluderGeometry;
+    };
+}
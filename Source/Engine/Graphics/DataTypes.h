@@ -11,6 +11,21 @@ namespace pr
         POS_TEXCOORD,
         POS_NORM,
         POS_NORM_TEXCOORD,
+        POS_NORM_TEXCOORD_PACKED,
+        COUNT,
+    };
+
+    enum class eRenderPass : BYTE
+    {
+        OPAQUE_PASS,
+        TRANSLUCENT_PASS,
+        COUNT,
+    };
+
+    enum class eLightType : UINT
+    {
+        POINT,
+        SPOT,
         COUNT,
     };
 
@@ -49,6 +64,72 @@ namespace pr
     };
     static_assert(sizeof(VertexPNT) == 32);
 
+    // VertexPNT in half the size. The position is unsigned normalized relative to the bounds of the geometry, see
+    // PositionDecode, the last component only pads. The normal is octahedral encoded as signed normalized, the
+    // texture coordinates are half floats.
+    struct VertexPackedPNT
+    {
+        USHORT auPosition[4];
+        SHORT aiNormal[2];
+        USHORT auTexCoord[2];
+    };
+    static_assert(sizeof(VertexPackedPNT) == 16);
+
+    // Object space position of a packed vertex is Offset + Scale * position, the scale is the same on every axis so
+    // it can be folded into the world matrix without skewing the normals
+    struct PositionDecode
+    {
+        XMFLOAT3 Offset;
+        FLOAT Scale;
+    };
+    static_assert(sizeof(PositionDecode) == 16);
+
+    // Written once per frame and bound as a root constant buffer view
+    struct FrameConstants
+    {
+        XMMATRIX View;
+        XMMATRIX Projection;
+        XMFLOAT4 CameraPosition;
+        XMFLOAT4 ClusterParameters;
+    };
+    static_assert(sizeof(FrameConstants) == 160);
+
+    // Transposed world matrix without the constant last column, one per object per frame
+    struct ObjectConstants
+    {
+        XMFLOAT3X4 World;
+    };
+    static_assert(sizeof(ObjectConstants) == 48);
+
+    // World space light as the pixel shader reads it, spot lights use the direction and the cosine of their outer angle
+    struct LightData
+    {
+        XMFLOAT3 Position;
+        FLOAT Range;
+        XMFLOAT3 Color;
+        eLightType Type;
+        XMFLOAT3 Direction;
+        FLOAT CosOuterAngle;
+    };
+    static_assert(sizeof(LightData) == 48);
+
+    // Range of one froxel in the compact light index list
+    struct LightCluster
+    {
+        UINT uOffset;
+        UINT uNumLights;
+    };
+    static_assert(sizeof(LightCluster) == 8);
+
+    // Local scale, rotation quaternion and translation, applied in that order
+    struct Transform
+    {
+        XMFLOAT3 Scale;
+        XMFLOAT4 Rotation;
+        XMFLOAT3 Translation;
+    };
+    static_assert(sizeof(Transform) == 40);
+
     constexpr size_t VERTEX_SIZE[] =
     {
         sizeof(VertexP),
@@ -56,5 +137,7 @@ namespace pr
         sizeof(VertexPT),
         sizeof(VertexPN),
         sizeof(VertexPNT),
+        sizeof(VertexPackedPNT),
     };
+    static_assert(ARRAYSIZE(VERTEX_SIZE) == static_cast<size_t>(eVertexType::COUNT));
 }
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/DataTypes.h"
+
+namespace pr
+{
+	/*
+		64-bit draw sort keys, most significant bits first.
+
+		Opaque:       | pass 2 | pso 10 | material 16 | vertex buffer 12 | depth 24 |
+		Translucent:  | pass 2 | ~depth 24 | pso 10 | material 16 | vertex buffer 12 |
+
+		Opaque draws are grouped by state and go front-to-back within the same state,
+		translucent draws go strictly back-to-front.
+	*/
+	namespace DrawSortKey
+	{
+		constexpr const UINT PASS_BITS = 2u;
+		constexpr const UINT PSO_BITS = 10u;
+		constexpr const UINT MATERIAL_BITS = 16u;
+		constexpr const UINT VERTEX_BUFFER_BITS = 12u;
+		constexpr const UINT DEPTH_BITS = 24u;
+		static_assert(PASS_BITS + PSO_BITS + MATERIAL_BITS + VERTEX_BUFFER_BITS + DEPTH_BITS == 64u);
+		static_assert((1u << PASS_BITS) >= static_cast<UINT>(eRenderPass::COUNT));
+
+		constexpr const UINT MAX_PSOS = 1u << PSO_BITS;
+		constexpr const UINT MAX_MATERIALS = 1u << MATERIAL_BITS;
+		constexpr const UINT MAX_VERTEX_BUFFERS = 1u << VERTEX_BUFFER_BITS;
+		constexpr const UINT MAX_DEPTH = (1u << DEPTH_BITS) - 1u;
+
+		constexpr const UINT PASS_SHIFT = 64u - PASS_BITS;
+
+		constexpr const UINT OPAQUE_PSO_SHIFT = PASS_SHIFT - PSO_BITS;
+		constexpr const UINT OPAQUE_MATERIAL_SHIFT = OPAQUE_PSO_SHIFT - MATERIAL_BITS;
+		constexpr const UINT OPAQUE_VERTEX_BUFFER_SHIFT = OPAQUE_MATERIAL_SHIFT - VERTEX_BUFFER_BITS;
+		constexpr const UINT OPAQUE_DEPTH_SHIFT = 0u;
+
+		constexpr const UINT TRANSLUCENT_DEPTH_SHIFT = PASS_SHIFT - DEPTH_BITS;
+		constexpr const UINT TRANSLUCENT_PSO_SHIFT = TRANSLUCENT_DEPTH_SHIFT - PSO_BITS;
+		constexpr const UINT TRANSLUCENT_MATERIAL_SHIFT = TRANSLUCENT_PSO_SHIFT - MATERIAL_BITS;
+		constexpr const UINT TRANSLUCENT_VERTEX_BUFFER_SHIFT = 0u;
+
+		inline constexpr UINT64 MakeField(_In_ UINT uValue, _In_ UINT uBits, _In_ UINT uShift) noexcept
+		{
+			return (static_cast<UINT64>(uValue) & ((1ull << uBits) - 1ull)) << uShift;
+		}
+
+		inline constexpr UINT GetField(_In_ UINT64 uKey, _In_ UINT uBits, _In_ UINT uShift) noexcept
+		{
+			return static_cast<UINT>((uKey >> uShift) & ((1ull << uBits) - 1ull));
+		}
+
+		// Maps a view space depth in [nearZ, farZ] onto [0, MAX_DEPTH]
+		inline constexpr UINT QuantizeDepth(_In_ FLOAT viewDepth, _In_ FLOAT nearZ, _In_ FLOAT farZ) noexcept
+		{
+			FLOAT t = (viewDepth - nearZ) / (farZ - nearZ);
+			t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+			return static_cast<UINT>(t * static_cast<FLOAT>(MAX_DEPTH));
+		}
+
+		inline constexpr UINT64 Encode(_In_ eRenderPass pass, _In_ UINT uPso, _In_ UINT uMaterial, _In_ UINT uVertexBuffer, _In_ UINT uDepth) noexcept
+		{
+			UINT64 uKey = MakeField(static_cast<UINT>(pass), PASS_BITS, PASS_SHIFT);
+			if (pass == eRenderPass::TRANSLUCENT_PASS)
+			{
+				return uKey
+					| MakeField(MAX_DEPTH - uDepth, DEPTH_BITS, TRANSLUCENT_DEPTH_SHIFT)
+					| MakeField(uPso, PSO_BITS, TRANSLUCENT_PSO_SHIFT)
+					| MakeField(uMaterial, MATERIAL_BITS, TRANSLUCENT_MATERIAL_SHIFT)
+					| MakeField(uVertexBuffer, VERTEX_BUFFER_BITS, TRANSLUCENT_VERTEX_BUFFER_SHIFT);
+			}
+
+			return uKey
+				| MakeField(uPso, PSO_BITS, OPAQUE_PSO_SHIFT)
+				| MakeField(uMaterial, MATERIAL_BITS, OPAQUE_MATERIAL_SHIFT)
+				| MakeField(uVertexBuffer, VERTEX_BUFFER_BITS, OPAQUE_VERTEX_BUFFER_SHIFT)
+				| MakeField(uDepth, DEPTH_BITS, OPAQUE_DEPTH_SHIFT);
+		}
+
+		inline constexpr eRenderPass GetPass(_In_ UINT64 uKey) noexcept
+		{
+			return static_cast<eRenderPass>(GetField(uKey, PASS_BITS, PASS_SHIFT));
+		}
+
+		inline constexpr UINT GetPso(_In_ UINT64 uKey) noexcept
+		{
+			return GetPass(uKey) == eRenderPass::TRANSLUCENT_PASS ? GetField(uKey, PSO_BITS, TRANSLUCENT_PSO_SHIFT) : GetField(uKey, PSO_BITS, OPAQUE_PSO_SHIFT);
+		}
+
+		inline constexpr UINT GetMaterial(_In_ UINT64 uKey) noexcept
+		{
+			return GetPass(uKey) == eRenderPass::TRANSLUCENT_PASS ? GetField(uKey, MATERIAL_BITS, TRANSLUCENT_MATERIAL_SHIFT) : GetField(uKey, MATERIAL_BITS, OPAQUE_MATERIAL_SHIFT);
+		}
+
+		inline constexpr UINT GetVertexBuffer(_In_ UINT64 uKey) noexcept
+		{
+			return GetPass(uKey) == eRenderPass::TRANSLUCENT_PASS ? GetField(uKey, VERTEX_BUFFER_BITS, TRANSLUCENT_VERTEX_BUFFER_SHIFT) : GetField(uKey, VERTEX_BUFFER_BITS, OPAQUE_VERTEX_BUFFER_SHIFT);
+		}
+
+		static_assert(GetPso(Encode(eRenderPass::OPAQUE_PASS, 5u, 7u, 9u, 11u)) == 5u);
+		static_assert(GetMaterial(Encode(eRenderPass::TRANSLUCENT_PASS, 5u, 7u, 9u, 11u)) == 7u);
+		static_assert(Encode(eRenderPass::OPAQUE_PASS, 0u, 0u, 0u, 1u) < Encode(eRenderPass::OPAQUE_PASS, 0u, 0u, 0u, 2u));
+		static_assert(Encode(eRenderPass::TRANSLUCENT_PASS, 0u, 0u, 0u, 2u) < Encode(eRenderPass::TRANSLUCENT_PASS, 0u, 0u, 0u, 1u));
+		static_assert(Encode(eRenderPass::OPAQUE_PASS, MAX_PSOS - 1u, 0u, 0u, 0u) < Encode(eRenderPass::TRANSLUCENT_PASS, 0u, 0u, 0u, 0u));
+	}
+}
@@ -0,0 +1,230 @@
+#include "pch.h"
+
+#include "Graphics/FrustumCuller.h"
+
+#include <bit>
+#include <cmath>
+#include <immintrin.h>
+
+#include "Scene/BoundingVolumeHierarchy.h"
+#include "Utility/JobSystem.h"
+#include "Utility/Profiler.h"
+
+namespace pr
+{
+	namespace
+	{
+		constexpr const UINT BLOCKS_PER_JOB = 1024u;
+	}
+
+	FrustumCuller::FrustumCuller() noexcept
+		: m_aCenterX()
+		, m_aCenterY()
+		, m_aCenterZ()
+		, m_aExtentX()
+		, m_aExtentY()
+		, m_aExtentZ()
+		, m_auVisibleMasks()
+		, m_auVisibleItems()
+		, m_uNumObjects(0u)
+		, m_uNumVisible(0u)
+	{
+	}
+
+	void FrustumCuller::Reset() noexcept
+	{
+		m_aCenterX.clear();
+		m_aCenterY.clear();
+		m_aCenterZ.clear();
+		m_aExtentX.clear();
+		m_aExtentY.clear();
+		m_aExtentZ.clear();
+		m_auVisibleMasks.clear();
+		m_uNumObjects = 0u;
+		m_uNumVisible = 0u;
+	}
+
+	UINT FrustumCuller::AddBounds(_In_ const MeshBounds& worldBounds)
+	{
+		m_aCenterX.push_back(worldBounds.Center.x);
+		m_aCenterY.push_back(worldBounds.Center.y);
+		m_aCenterZ.push_back(worldBounds.Center.z);
+		m_aExtentX.push_back(worldBounds.Extents.x);
+		m_aExtentY.push_back(worldBounds.Extents.y);
+		m_aExtentZ.push_back(worldBounds.Extents.z);
+
+		return m_uNumObjects++;
+	}
+
+	void FrustumCuller::Cull(_In_ const Frustum& frustum, _In_ JobSystem& jobSystem)
+	{
+		PR_PROFILE_FUNCTION();
+
+		// Pad to whole blocks so the kernel never needs a scalar tail
+		UINT uNumBlocks = (m_uNumObjects + BLOCK_SIZE - 1u) / BLOCK_SIZE;
+		size_t uPaddedSize = static_cast<size_t>(uNumBlocks) * BLOCK_SIZE;
+		m_aCenterX.resize(uPaddedSize, 0.0f);
+		m_aCenterY.resize(uPaddedSize, 0.0f);
+		m_aCenterZ.resize(uPaddedSize, 0.0f);
+		m_aExtentX.resize(uPaddedSize, 0.0f);
+		m_aExtentY.resize(uPaddedSize, 0.0f);
+		m_aExtentZ.resize(uPaddedSize, 0.0f);
+		m_auVisibleMasks.resize(uNumBlocks);
+
+		jobSystem.ParallelFor(uNumBlocks, BLOCKS_PER_JOB, [this, &frustum](UINT uBegin, UINT uEnd)
+		{
+			cullBlocks(frustum, uBegin, uEnd);
+		});
+
+		if (m_uNumObjects % BLOCK_SIZE != 0u)
+		{
+			m_auVisibleMasks.back() &= static_cast<BYTE>((1u << (m_uNumObjects % BLOCK_SIZE)) - 1u);
+		}
+
+		m_uNumVisible = 0u;
+		for (BYTE uMask : m_auVisibleMasks)
+		{
+			m_uNumVisible += static_cast<UINT>(std::popcount(uMask));
+		}
+	}
+
+	void FrustumCuller::Cull(_In_ const Frustum& frustum, _In_ const BoundingVolumeHierarchy& bvh, _In_ JobSystem& jobSystem)
+	{
+		PR_PROFILE_FUNCTION();
+
+		Reset();
+		m_uNumObjects = bvh.GetNumItems();
+		m_auVisibleMasks.resize((m_uNumObjects + BLOCK_SIZE - 1u) / BLOCK_SIZE, 0u);
+
+		bvh.QueryFrustums(&frustum, 1u, &m_auVisibleItems, jobSystem);
+		for (UINT uItem : m_auVisibleItems)
+		{
+			m_auVisibleMasks[uItem / BLOCK_SIZE] |= static_cast<BYTE>(1u << (uItem % BLOCK_SIZE));
+		}
+		m_uNumVisible = static_cast<UINT>(m_auVisibleItems.size());
+	}
+
+	BOOL FrustumCuller::IsVisible(_In_ UINT uIndex) const noexcept
+	{
+		assert(uIndex < m_uNumObjects);
+
+		return (m_auVisibleMasks[uIndex / BLOCK_SIZE] >> (uIndex % BLOCK_SIZE)) & 1u;
+	}
+
+	UINT FrustumCuller::GetNumObjects() const noexcept
+	{
+		return m_uNumObjects;
+	}
+
+	UINT FrustumCuller::GetNumVisible() const noexcept
+	{
+		return m_uNumVisible;
+	}
+
+	// A box is outside when it lies entirely behind one plane:
+	// dot(n, c) + d + dot(|n|, e) < 0
+	void FrustumCuller::cullBlocks(_In_ const Frustum& frustum, _In_ UINT uBeginBlock, _In_ UINT uEndBlock) noexcept
+	{
+#if defined(__AVX__)
+		__m256 aNormalX[Frustum::NUM_PLANES];
+		__m256 aNormalY[Frustum::NUM_PLANES];
+		__m256 aNormalZ[Frustum::NUM_PLANES];
+		__m256 aDistance[Frustum::NUM_PLANES];
+		__m256 aAbsNormalX[Frustum::NUM_PLANES];
+		__m256 aAbsNormalY[Frustum::NUM_PLANES];
+		__m256 aAbsNormalZ[Frustum::NUM_PLANES];
+		for (UINT uPlane = 0u; uPlane < Frustum::NUM_PLANES; ++uPlane)
+		{
+			const XMFLOAT4& plane = frustum.aPlanes[uPlane];
+			aNormalX[uPlane] = _mm256_set1_ps(plane.x);
+			aNormalY[uPlane] = _mm256_set1_ps(plane.y);
+			aNormalZ[uPlane] = _mm256_set1_ps(plane.z);
+			aDistance[uPlane] = _mm256_set1_ps(plane.w);
+			aAbsNormalX[uPlane] = _mm256_set1_ps(std::fabs(plane.x));
+			aAbsNormalY[uPlane] = _mm256_set1_ps(std::fabs(plane.y));
+			aAbsNormalZ[uPlane] = _mm256_set1_ps(std::fabs(plane.z));
+		}
+
+		const __m256 zero = _mm256_setzero_ps();
+		for (UINT uBlock = uBeginBlock; uBlock < uEndBlock; ++uBlock)
+		{
+			size_t uOffset = static_cast<size_t>(uBlock) * BLOCK_SIZE;
+			__m256 centerX = _mm256_loadu_ps(&m_aCenterX[uOffset]);
+			__m256 centerY = _mm256_loadu_ps(&m_aCenterY[uOffset]);
+			__m256 centerZ = _mm256_loadu_ps(&m_aCenterZ[uOffset]);
+			__m256 extentX = _mm256_loadu_ps(&m_aExtentX[uOffset]);
+			__m256 extentY = _mm256_loadu_ps(&m_aExtentY[uOffset]);
+			__m256 extentZ = _mm256_loadu_ps(&m_aExtentZ[uOffset]);
+
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (UINT uPlane = 0u; uPlane < Frustum::NUM_PLANES; ++uPlane)
+			{
+				__m256 distance = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(aNormalX[uPlane], centerX), _mm256_mul_ps(aNormalY[uPlane], centerY)),
+					_mm256_add_ps(_mm256_mul_ps(aNormalZ[uPlane], centerZ), aDistance[uPlane])
+				);
+				__m256 radius = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(aAbsNormalX[uPlane], extentX), _mm256_mul_ps(aAbsNormalY[uPlane], extentY)),
+					_mm256_mul_ps(aAbsNormalZ[uPlane], extentZ)
+				);
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_GE_OQ));
+			}
+
+			m_auVisibleMasks[uBlock] = static_cast<BYTE>(_mm256_movemask_ps(inside));
+		}
+#else
+		__m128 aNormalX[Frustum::NUM_PLANES];
+		__m128 aNormalY[Frustum::NUM_PLANES];
+		__m128 aNormalZ[Frustum::NUM_PLANES];
+		__m128 aDistance[Frustum::NUM_PLANES];
+		__m128 aAbsNormalX[Frustum::NUM_PLANES];
+		__m128 aAbsNormalY[Frustum::NUM_PLANES];
+		__m128 aAbsNormalZ[Frustum::NUM_PLANES];
+		for (UINT uPlane = 0u; uPlane < Frustum::NUM_PLANES; ++uPlane)
+		{
+			const XMFLOAT4& plane = frustum.aPlanes[uPlane];
+			aNormalX[uPlane] = _mm_set1_ps(plane.x);
+			aNormalY[uPlane] = _mm_set1_ps(plane.y);
+			aNormalZ[uPlane] = _mm_set1_ps(plane.z);
+			aDistance[uPlane] = _mm_set1_ps(plane.w);
+			aAbsNormalX[uPlane] = _mm_set1_ps(std::fabs(plane.x));
+			aAbsNormalY[uPlane] = _mm_set1_ps(std::fabs(plane.y));
+			aAbsNormalZ[uPlane] = _mm_set1_ps(std::fabs(plane.z));
+		}
+
+		const __m128 zero = _mm_setzero_ps();
+		for (UINT uBlock = uBeginBlock; uBlock < uEndBlock; ++uBlock)
+		{
+			UINT uMask = 0u;
+			for (UINT uHalf = 0u; uHalf < BLOCK_SIZE; uHalf += 4u)
+			{
+				size_t uOffset = static_cast<size_t>(uBlock) * BLOCK_SIZE + uHalf;
+				__m128 centerX = _mm_loadu_ps(&m_aCenterX[uOffset]);
+				__m128 centerY = _mm_loadu_ps(&m_aCenterY[uOffset]);
+				__m128 centerZ = _mm_loadu_ps(&m_aCenterZ[uOffset]);
+				__m128 extentX = _mm_loadu_ps(&m_aExtentX[uOffset]);
+				__m128 extentY = _mm_loadu_ps(&m_aExtentY[uOffset]);
+				__m128 extentZ = _mm_loadu_ps(&m_aExtentZ[uOffset]);
+
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (UINT uPlane = 0u; uPlane < Frustum::NUM_PLANES; ++uPlane)
+				{
+					__m128 distance = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(aNormalX[uPlane], centerX), _mm_mul_ps(aNormalY[uPlane], centerY)),
+						_mm_add_ps(_mm_mul_ps(aNormalZ[uPlane], centerZ), aDistance[uPlane])
+					);
+					__m128 radius = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(aAbsNormalX[uPlane], extentX), _mm_mul_ps(aAbsNormalY[uPlane], extentY)),
+						_mm_mul_ps(aAbsNormalZ[uPlane], extentZ)
+					);
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+				}
+
+				uMask |= static_cast<UINT>(_mm_movemask_ps(inside)) << uHalf;
+			}
+
+			m_auVisibleMasks[uBlock] = static_cast<BYTE>(uMask);
+		}
+#endif
+	}
+}
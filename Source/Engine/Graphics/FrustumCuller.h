@@ -0,0 +1,53 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/Bounds.h"
+
+namespace pr
+{
+	class BoundingVolumeHierarchy;
+	class JobSystem;
+
+	// Tests world space boxes against a frustum. Boxes are kept as structure of arrays and
+	// tested 8 at a time with AVX when the build enables it, 2 x 4 with SSE otherwise.
+	// Boxes that are already in a bounding volume hierarchy can be culled through it instead.
+	class FrustumCuller final
+	{
+	public:
+		static constexpr const UINT BLOCK_SIZE = 8u;
+
+	public:
+		explicit FrustumCuller() noexcept;
+		FrustumCuller(const FrustumCuller& other) = delete;
+		FrustumCuller(FrustumCuller&& other) = delete;
+		FrustumCuller& operator=(const FrustumCuller& other) = delete;
+		FrustumCuller& operator=(FrustumCuller&& other) = delete;
+		~FrustumCuller() noexcept = default;
+
+		void Reset() noexcept;
+		UINT AddBounds(_In_ const MeshBounds& worldBounds);
+		void Cull(_In_ const Frustum& frustum, _In_ JobSystem& jobSystem);
+		// Culls the items of the hierarchy in place of added bounds, item i is object i
+		void Cull(_In_ const Frustum& frustum, _In_ const BoundingVolumeHierarchy& bvh, _In_ JobSystem& jobSystem);
+
+		BOOL IsVisible(_In_ UINT uIndex) const noexcept;
+		UINT GetNumObjects() const noexcept;
+		UINT GetNumVisible() const noexcept;
+
+	private:
+		void cullBlocks(_In_ const Frustum& frustum, _In_ UINT uBeginBlock, _In_ UINT uEndBlock) noexcept;
+
+	private:
+		std::vector<FLOAT> m_aCenterX;
+		std::vector<FLOAT> m_aCenterY;
+		std::vector<FLOAT> m_aCenterZ;
+		std::vector<FLOAT> m_aExtentX;
+		std::vector<FLOAT> m_aExtentY;
+		std::vector<FLOAT> m_aExtentZ;
+		std::vector<BYTE> m_auVisibleMasks;
+		std::vector<UINT> m_auVisibleItems;
+		UINT m_uNumObjects;
+		UINT m_uNumVisible;
+	};
+}
@@ -0,0 +1,403 @@
+#include "pch.h"
+
+#include "Graphics/GeometryArena.h"
+
+#include "Graphics/GraphicsCommon.h"
+#include "Utility/Math.h"
+#include "Utility/Profiler.h"
+#include "Utility/Utility.h"
+
+namespace pr
+{
+	GeometryArena& GeometryArena::GetInstance() noexcept
+	{
+		static GeometryArena s_GeometryArena;
+		return s_GeometryArena;
+	}
+
+	GeometryArena::GeometryArena() noexcept
+		: m_aVertexPools()
+		, m_IndexPool()
+		, m_aVertexBufferViews()
+		, m_IndexBufferView()
+		, m_Allocations()
+		, m_aRetiredBuffers()
+		, m_Mutex()
+		, m_uFrame(0u)
+		, m_uNumDefragmentations(0u)
+	{
+		for (size_t i = 0; i < static_cast<size_t>(eVertexType::COUNT); ++i)
+		{
+			m_aVertexPools[i].uElementSize = static_cast<UINT>(VERTEX_SIZE[i]);
+			m_aVertexPools[i].bHasFreedRanges = FALSE;
+			m_aVertexPools[i].pCopyDestCommandList = nullptr;
+		}
+		m_IndexPool.uElementSize = sizeof(WORD);
+		m_IndexPool.bHasFreedRanges = FALSE;
+		m_IndexPool.pCopyDestCommandList = nullptr;
+	}
+
+	HRESULT GeometryArena::Allocate(
+		_Out_ std::shared_ptr<const Allocation>& pOutAllocation,
+		_Out_ ComPtr<ID3D12Resource>& pOutUploadBuffer,
+		_In_ ID3D12Device2* pDevice,
+		_In_ ID3D12GraphicsCommandList2* pCommandList,
+		_In_ eVertexType vertexType,
+		_In_reads_bytes_(uNumVertices * VERTEX_SIZE[static_cast<size_t>(vertexType)]) const void* pVertices,
+		_In_ UINT uNumVertices,
+		_In_reads_(uNumIndices) const WORD* pIndices,
+		_In_ UINT uNumIndices
+	)
+	{
+		HRESULT hr = S_OK;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		Pool& vertexPool = m_aVertexPools[static_cast<size_t>(vertexType)];
+		UINT64 uVertexBytes = static_cast<UINT64>(uNumVertices) * vertexPool.uElementSize;
+		UINT64 uIndexBytes = static_cast<UINT64>(uNumIndices) * sizeof(WORD);
+		UINT64 uIndexUploadOffset = AlignUp(static_cast<size_t>(uVertexBytes), sizeof(UINT));
+
+		// Vertices and indices share one upload buffer
+		const CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+		const CD3DX12_RESOURCE_DESC uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(std::max(uIndexUploadOffset + uIndexBytes, static_cast<UINT64>(1u)));
+		hr = pDevice->CreateCommittedResource(
+			&uploadHeapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&uploadBufferDesc,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&pOutUploadBuffer)
+		);
+		CHECK_AND_RETURN_HRESULT(hr, L"GeometryArena::Allocate >> Creating upload buffer");
+
+		BYTE* pUploadData = nullptr;
+		hr = pOutUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&pUploadData));
+		CHECK_AND_RETURN_HRESULT(hr, L"GeometryArena::Allocate >> Mapping upload buffer");
+
+		memcpy(pUploadData, pVertices, static_cast<size_t>(uVertexBytes));
+		memcpy(pUploadData + uIndexUploadOffset, pIndices, static_cast<size_t>(uIndexBytes));
+		pOutUploadBuffer->Unmap(0, nullptr);
+
+		auto pAllocation = std::make_unique<Allocation>(
+			Allocation
+			{
+				.VertexType = vertexType,
+				.uVertexOffset = 0u,
+				.uNumVertices = uNumVertices,
+				.uIndexOffset = 0u,
+				.uNumIndices = uNumIndices,
+			}
+		);
+
+		if (uNumVertices > 0u)
+		{
+			hr = allocateRange(pAllocation->uVertexOffset, pDevice, pCommandList, vertexPool, uNumVertices);
+			CHECK_AND_RETURN_HRESULT(hr, L"GeometryArena::Allocate >> Allocating vertices");
+
+			pCommandList->CopyBufferRegion(
+				vertexPool.pBuffer.Get(),
+				static_cast<UINT64>(pAllocation->uVertexOffset) * vertexPool.uElementSize,
+				pOutUploadBuffer.Get(),
+				0u,
+				uVertexBytes
+			);
+			vertexPool.pCopyDestCommandList = pCommandList;
+		}
+
+		if (uNumIndices > 0u)
+		{
+			hr = allocateRange(pAllocation->uIndexOffset, pDevice, pCommandList, m_IndexPool, uNumIndices);
+			if (FAILED(hr) && uNumVertices > 0u)
+			{
+				vertexPool.Allocator.Free(pAllocation->uVertexOffset);
+			}
+			CHECK_AND_RETURN_HRESULT(hr, L"GeometryArena::Allocate >> Allocating indices");
+
+			pCommandList->CopyBufferRegion(
+				m_IndexPool.pBuffer.Get(),
+				static_cast<UINT64>(pAllocation->uIndexOffset) * sizeof(WORD),
+				pOutUploadBuffer.Get(),
+				uIndexUploadOffset,
+				uIndexBytes
+			);
+			m_IndexPool.pCopyDestCommandList = pCommandList;
+		}
+
+		m_Allocations.insert(pAllocation.get());
+		pOutAllocation = std::shared_ptr<const Allocation>(
+			pAllocation.release(),
+			[this](const Allocation* pAllocation)
+			{
+				free(const_cast<Allocation*>(pAllocation));
+			}
+		);
+
+		return hr;
+	}
+
+	HRESULT GeometryArena::Defragment(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList)
+	{
+		PR_PROFILE_FUNCTION();
+
+		HRESULT hr = S_OK;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		++m_uFrame;
+		std::erase_if(
+			m_aRetiredBuffers,
+			[this](const RetiredBuffer& retiredBuffer)
+			{
+				return retiredBuffer.uRetireFrame + NUM_RETIRE_FRAMES <= m_uFrame;
+			}
+		);
+
+		auto defragmentPool = [&](Pool& pool) -> HRESULT
+		{
+			// The lists of earlier copies have been submitted, so every buffer is back in the common state
+			pool.pCopyDestCommandList = nullptr;
+
+			if (!pool.bHasFreedRanges)
+			{
+				return S_OK;
+			}
+
+			// Ranges freed at the end merge into the trailing free block, which is not a hole
+			const RangeAllocator& allocator = pool.Allocator;
+			UINT64 uHoleSize = static_cast<UINT64>(allocator.GetCapacity()) - allocator.GetUsedSize() - allocator.GetTrailingFreeSize();
+			if (uHoleSize * DEFRAGMENT_HOLE_RATIO < allocator.GetCapacity())
+			{
+				return S_OK;
+			}
+			pool.bHasFreedRanges = FALSE;
+
+			++m_uNumDefragmentations;
+			return rebuildPool(pDevice, pCommandList, pool, pool.Allocator.GetCapacity());
+		};
+
+		for (Pool& vertexPool : m_aVertexPools)
+		{
+			hr = defragmentPool(vertexPool);
+			CHECK_AND_RETURN_HRESULT(hr, L"GeometryArena::Defragment >> Compacting vertex buffer");
+		}
+
+		hr = defragmentPool(m_IndexPool);
+		CHECK_AND_RETURN_HRESULT(hr, L"GeometryArena::Defragment >> Compacting index buffer");
+
+		return hr;
+	}
+
+	const D3D12_VERTEX_BUFFER_VIEW& GeometryArena::GetVertexBufferView(_In_ eVertexType vertexType) const noexcept
+	{
+		return m_aVertexBufferViews[static_cast<size_t>(vertexType)];
+	}
+
+	const D3D12_INDEX_BUFFER_VIEW& GeometryArena::GetIndexBufferView() const noexcept
+	{
+		return m_IndexBufferView;
+	}
+
+	GeometryArena::Stats GeometryArena::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		Stats stats =
+		{
+			.uVertexBufferSize = 0u,
+			.uVertexBytesUsed = 0u,
+			.uIndexBufferSize = static_cast<UINT64>(m_IndexPool.Allocator.GetCapacity()) * m_IndexPool.uElementSize,
+			.uIndexBytesUsed = static_cast<UINT64>(m_IndexPool.Allocator.GetUsedSize()) * m_IndexPool.uElementSize,
+			.uNumAllocations = static_cast<UINT>(m_Allocations.size()),
+			.uNumFreeBlocks = m_IndexPool.Allocator.GetNumFreeBlocks(),
+			.uNumDefragmentations = m_uNumDefragmentations,
+		};
+
+		for (const Pool& vertexPool : m_aVertexPools)
+		{
+			stats.uVertexBufferSize += static_cast<UINT64>(vertexPool.Allocator.GetCapacity()) * vertexPool.uElementSize;
+			stats.uVertexBytesUsed += static_cast<UINT64>(vertexPool.Allocator.GetUsedSize()) * vertexPool.uElementSize;
+			stats.uNumFreeBlocks += vertexPool.Allocator.GetNumFreeBlocks();
+		}
+
+		return stats;
+	}
+
+	HRESULT GeometryArena::allocateRange(_Out_ UINT& uOutOffset, _In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList, _In_ Pool& pool, _In_ UINT uSize)
+	{
+		HRESULT hr = S_OK;
+
+		uOutOffset = pool.Allocator.Allocate(uSize);
+		if (uOutOffset != RangeAllocator::INVALID_OFFSET)
+		{
+			return hr;
+		}
+
+		// Grow into a larger buffer, which also compacts the existing ranges
+		UINT64 uCapacity = pool.Allocator.GetCapacity();
+		if (uCapacity == 0u)
+		{
+			uCapacity = (&pool == &m_IndexPool ? DEFAULT_INDEX_BUFFER_SIZE : DEFAULT_VERTEX_BUFFER_SIZE) / pool.uElementSize;
+		}
+		while (uCapacity < static_cast<UINT64>(pool.Allocator.GetUsedSize()) + uSize)
+		{
+			uCapacity *= 2u;
+		}
+
+		if (uCapacity * pool.uElementSize > static_cast<UINT64>(UINT_MAX))
+		{
+			hr = E_OUTOFMEMORY;
+			CHECK_AND_RETURN_HRESULT(hr, L"GeometryArena::allocateRange >> Buffer views are limited to 4GB");
+		}
+
+		hr = rebuildPool(pDevice, pCommandList, pool, static_cast<UINT>(uCapacity));
+		CHECK_AND_RETURN_HRESULT(hr, L"GeometryArena::allocateRange >> Growing buffer");
+
+		uOutOffset = pool.Allocator.Allocate(uSize);
+		assert(uOutOffset != RangeAllocator::INVALID_OFFSET);
+
+		return hr;
+	}
+
+	void GeometryArena::free(_In_ Allocation* pAllocation)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			Pool& vertexPool = m_aVertexPools[static_cast<size_t>(pAllocation->VertexType)];
+			if (pAllocation->uNumVertices > 0u)
+			{
+				vertexPool.Allocator.Free(pAllocation->uVertexOffset);
+				vertexPool.bHasFreedRanges = TRUE;
+			}
+			if (pAllocation->uNumIndices > 0u)
+			{
+				m_IndexPool.Allocator.Free(pAllocation->uIndexOffset);
+				m_IndexPool.bHasFreedRanges = TRUE;
+			}
+
+			m_Allocations.erase(pAllocation);
+		}
+
+		delete pAllocation;
+	}
+
+	HRESULT GeometryArena::rebuildPool(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList, _In_ Pool& pool, _In_ UINT uNewCapacity)
+	{
+		HRESULT hr = S_OK;
+
+		// Buffers are created in the common state and rely on implicit promotion for copies and draws
+		ComPtr<ID3D12Resource> pNewBuffer;
+		const CD3DX12_HEAP_PROPERTIES defaultHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+		const CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(static_cast<UINT64>(uNewCapacity) * pool.uElementSize);
+		hr = pDevice->CreateCommittedResource(
+			&defaultHeapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&bufferDesc,
+			D3D12_RESOURCE_STATE_COMMON,
+			nullptr,
+			IID_PPV_ARGS(&pNewBuffer)
+		);
+		CHECK_AND_RETURN_HRESULT(hr, L"GeometryArena::rebuildPool >> Creating buffer");
+
+		pool.Allocator.Grow(uNewCapacity);
+		std::vector<RangeAllocator::Move> aMoves = pool.Allocator.Defragment();
+
+		// Copies into the old buffer earlier in this list promoted it to COPY_DEST, from which it cannot be promoted
+		// to COPY_SOURCE
+		if (pool.pBuffer && pool.pCopyDestCommandList == pCommandList)
+		{
+			TransitResource(pCommandList, pool.pBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COPY_SOURCE);
+		}
+
+		std::unordered_map<UINT, UINT> newOffsets;
+		newOffsets.reserve(aMoves.size());
+		for (const RangeAllocator::Move& move : aMoves)
+		{
+			newOffsets.emplace(move.uSourceOffset, move.uDestinationOffset);
+		}
+
+		// Every live range is copied into the new buffer, copying within one buffer would overlap
+		BOOL bHasCopies = FALSE;
+		for (Allocation* pAllocation : m_Allocations)
+		{
+			UINT uSize = 0u;
+			UINT* puOffset = getRange(pool, *pAllocation, uSize);
+			if (!puOffset || uSize == 0u)
+			{
+				continue;
+			}
+
+			auto iter = newOffsets.find(*puOffset);
+			UINT uNewOffset = iter != newOffsets.end() ? iter->second : *puOffset;
+			if (pool.pBuffer)
+			{
+				pCommandList->CopyBufferRegion(
+					pNewBuffer.Get(),
+					static_cast<UINT64>(uNewOffset) * pool.uElementSize,
+					pool.pBuffer.Get(),
+					static_cast<UINT64>(*puOffset) * pool.uElementSize,
+					static_cast<UINT64>(uSize) * pool.uElementSize
+				);
+				bHasCopies = TRUE;
+			}
+			*puOffset = uNewOffset;
+		}
+
+		if (pool.pBuffer)
+		{
+			m_aRetiredBuffers.push_back(
+				RetiredBuffer
+				{
+					.pBuffer = std::move(pool.pBuffer),
+					.uRetireFrame = m_uFrame,
+				}
+			);
+		}
+		pool.pBuffer = std::move(pNewBuffer);
+		pool.pCopyDestCommandList = bHasCopies ? pCommandList : nullptr;
+
+		updateViews();
+
+		return hr;
+	}
+
+	UINT* GeometryArena::getRange(_In_ const Pool& pool, _In_ Allocation& allocation, _Out_ UINT& uOutSize) noexcept
+	{
+		if (&pool == &m_IndexPool)
+		{
+			uOutSize = allocation.uNumIndices;
+			return &allocation.uIndexOffset;
+		}
+
+		if (&pool == &m_aVertexPools[static_cast<size_t>(allocation.VertexType)])
+		{
+			uOutSize = allocation.uNumVertices;
+			return &allocation.uVertexOffset;
+		}
+
+		uOutSize = 0u;
+		return nullptr;
+	}
+
+	void GeometryArena::updateViews() noexcept
+	{
+		for (size_t i = 0; i < static_cast<size_t>(eVertexType::COUNT); ++i)
+		{
+			const Pool& vertexPool = m_aVertexPools[i];
+			m_aVertexBufferViews[i] =
+			{
+				.BufferLocation = vertexPool.pBuffer ? vertexPool.pBuffer->GetGPUVirtualAddress() : D3D12_GPU_VIRTUAL_ADDRESS_NULL,
+				.SizeInBytes = vertexPool.Allocator.GetCapacity() * vertexPool.uElementSize,
+				.StrideInBytes = vertexPool.uElementSize,
+			};
+		}
+
+		m_IndexBufferView =
+		{
+			.BufferLocation = m_IndexPool.pBuffer ? m_IndexPool.pBuffer->GetGPUVirtualAddress() : D3D12_GPU_VIRTUAL_ADDRESS_NULL,
+			.SizeInBytes = m_IndexPool.Allocator.GetCapacity() * m_IndexPool.uElementSize,
+			.Format = INDEX_FORMAT,
+		};
+	}
+}
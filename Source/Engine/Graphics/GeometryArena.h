@@ -0,0 +1,116 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/DataTypes.h"
+#include "Utility/RangeAllocator.h"
+
+namespace pr
+{
+	// Shared vertex and index buffers that every renderable sub-allocates its geometry from, so that
+	// draws of different renderables bind the same buffers. There is one vertex buffer per vertex type
+	// and one 16-bit index buffer. Buffers grow on demand and are compacted after geometry is freed.
+	class GeometryArena final
+	{
+	public:
+		static constexpr const UINT DEFAULT_VERTEX_BUFFER_SIZE = _32MB;
+		static constexpr const UINT DEFAULT_INDEX_BUFFER_SIZE = _16MB;
+		static constexpr const DXGI_FORMAT INDEX_FORMAT = DXGI_FORMAT_R16_UINT;
+
+		// Offsets are in vertices and indices, and change when the arena is compacted or grown
+		struct Allocation
+		{
+			eVertexType VertexType;
+			UINT uVertexOffset;
+			UINT uNumVertices;
+			UINT uIndexOffset;
+			UINT uNumIndices;
+		};
+
+		struct Stats
+		{
+			UINT64 uVertexBufferSize;
+			UINT64 uVertexBytesUsed;
+			UINT64 uIndexBufferSize;
+			UINT64 uIndexBytesUsed;
+			UINT uNumAllocations;
+			UINT uNumFreeBlocks;
+			UINT uNumDefragmentations;
+		};
+
+	public:
+		static GeometryArena& GetInstance() noexcept;
+
+	public:
+		explicit GeometryArena() noexcept;
+		GeometryArena(const GeometryArena& other) = delete;
+		GeometryArena(GeometryArena&& other) = delete;
+		GeometryArena& operator=(const GeometryArena& other) = delete;
+		GeometryArena& operator=(GeometryArena&& other) = delete;
+		~GeometryArena() noexcept = default;
+
+		// Allocates the ranges and records the copies from pOutUploadBuffer, which has to outlive the command list.
+		// The ranges are freed when the last reference to the allocation is released.
+		HRESULT Allocate(
+			_Out_ std::shared_ptr<const Allocation>& pOutAllocation,
+			_Out_ ComPtr<ID3D12Resource>& pOutUploadBuffer,
+			_In_ ID3D12Device2* pDevice,
+			_In_ ID3D12GraphicsCommandList2* pCommandList,
+			_In_ eVertexType vertexType,
+			_In_reads_bytes_(uNumVertices * VERTEX_SIZE[static_cast<size_t>(vertexType)]) const void* pVertices,
+			_In_ UINT uNumVertices,
+			_In_reads_(uNumIndices) const WORD* pIndices,
+			_In_ UINT uNumIndices
+		);
+
+		// Compacts the buffers whose holes between live ranges have grown past 1 / DEFRAGMENT_HOLE_RATIO of the buffer.
+		// Called once per frame after the draws are recorded, since the recorded draws keep using the old buffers until
+		// they are retired, and after the command lists of earlier Allocate calls were submitted.
+		HRESULT Defragment(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList);
+
+		const D3D12_VERTEX_BUFFER_VIEW& GetVertexBufferView(_In_ eVertexType vertexType) const noexcept;
+		const D3D12_INDEX_BUFFER_VIEW& GetIndexBufferView() const noexcept;
+		Stats GetStats();
+
+	private:
+		struct Pool
+		{
+			ComPtr<ID3D12Resource> pBuffer;
+			RangeAllocator Allocator;
+			UINT uElementSize;
+			BOOL bHasFreedRanges;
+			// List whose copies into pBuffer promoted it to COPY_DEST, which lasts until the list has executed
+			ID3D12GraphicsCommandList2* pCopyDestCommandList;
+		};
+
+		// Compacting copies every live range, so small holes are left for later allocations to fill
+		static constexpr const UINT DEFRAGMENT_HOLE_RATIO = 8u;
+
+		// Buffers replaced by a compaction are kept alive for as many frames as can be in flight
+		static constexpr const UINT64 NUM_RETIRE_FRAMES = 3u;
+
+		struct RetiredBuffer
+		{
+			ComPtr<ID3D12Resource> pBuffer;
+			UINT64 uRetireFrame;
+		};
+
+	private:
+		HRESULT allocateRange(_Out_ UINT& uOutOffset, _In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList, _In_ Pool& pool, _In_ UINT uSize);
+		void free(_In_ Allocation* pAllocation);
+		HRESULT rebuildPool(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList, _In_ Pool& pool, _In_ UINT uNewCapacity);
+		UINT* getRange(_In_ const Pool& pool, _In_ Allocation& allocation, _Out_ UINT& uOutSize) noexcept;
+		void updateViews() noexcept;
+
+	private:
+		Pool m_aVertexPools[static_cast<size_t>(eVertexType::COUNT)];
+		Pool m_IndexPool;
+		D3D12_VERTEX_BUFFER_VIEW m_aVertexBufferViews[static_cast<size_t>(eVertexType::COUNT)];
+		D3D12_INDEX_BUFFER_VIEW m_IndexBufferView;
+		std::unordered_set<Allocation*> m_Allocations;
+		std::vector<RetiredBuffer> m_aRetiredBuffers;
+		std::mutex m_Mutex;
+		UINT64 m_uFrame;
+		UINT m_uNumDefragmentations;
+	};
+}
@@ -0,0 +1,153 @@
+#include "pch.h"
+
+#include "Graphics/GpuProfiler.h"
+
+#include "Utility/Utility.h"
+
+namespace pr
+{
+	GpuProfiler::GpuProfiler() noexcept
+		: m_pQueryHeap()
+		, m_pReadbackBuffer()
+		, m_aaEvents()
+		, m_auNumScopes{}
+		, m_abIsResolved{}
+		, m_uTimestampFrequency(0u)
+		, m_uFrameIndex(0u)
+		, m_uCurrentScope(Profiler::INVALID_INDEX)
+	{
+	}
+
+	HRESULT GpuProfiler::Initialize(_In_ ID3D12Device2* pDevice, _In_ ID3D12CommandQueue* pCommandQueue) noexcept
+	{
+		HRESULT hr = S_OK;
+
+		hr = pCommandQueue->GetTimestampFrequency(&m_uTimestampFrequency);
+		CHECK_AND_RETURN_HRESULT(hr, L"GpuProfiler::Initialize >> Getting timestamp frequency");
+
+		// Two timestamps per scope, one block of scopes per frame in flight
+		const UINT uNumQueries = static_cast<UINT>(Profiler::NUM_FRAMES) * MAX_SCOPES_PER_FRAME * 2u;
+
+		D3D12_QUERY_HEAP_DESC queryHeapDesc =
+		{
+			.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP,
+			.Count = uNumQueries,
+			.NodeMask = 0u,
+		};
+		hr = pDevice->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_pQueryHeap));
+		CHECK_AND_RETURN_HRESULT(hr, L"GpuProfiler::Initialize >> Creating timestamp query heap");
+
+		const CD3DX12_HEAP_PROPERTIES readbackHeapProperties(D3D12_HEAP_TYPE_READBACK);
+		const CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(uNumQueries * sizeof(UINT64));
+		hr = pDevice->CreateCommittedResource(
+			&readbackHeapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&resourceDesc,
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			nullptr,
+			IID_PPV_ARGS(&m_pReadbackBuffer)
+		);
+		CHECK_AND_RETURN_HRESULT(hr, L"GpuProfiler::Initialize >> Creating readback buffer");
+
+		for (std::vector<Profiler::ScopeEvent>& aEvents : m_aaEvents)
+		{
+			aEvents.resize(MAX_SCOPES_PER_FRAME);
+		}
+
+		return hr;
+	}
+
+	HRESULT GpuProfiler::BeginFrame(_In_ UINT uFrameIndex) noexcept
+	{
+		HRESULT hr = S_OK;
+
+		assert(uFrameIndex < Profiler::NUM_FRAMES);
+		m_uFrameIndex = uFrameIndex;
+		m_uCurrentScope = Profiler::INVALID_INDEX;
+
+		UINT uNumScopes = m_auNumScopes[uFrameIndex];
+		if (m_abIsResolved[uFrameIndex] && uNumScopes > 0u)
+		{
+			const SIZE_T uBeginOffset = static_cast<SIZE_T>(uFrameIndex) * MAX_SCOPES_PER_FRAME * 2u * sizeof(UINT64);
+			const D3D12_RANGE readRange =
+			{
+				.Begin = uBeginOffset,
+				.End = uBeginOffset + uNumScopes * 2u * sizeof(UINT64),
+			};
+
+			void* pData = nullptr;
+			hr = m_pReadbackBuffer->Map(0u, &readRange, &pData);
+			CHECK_AND_RETURN_HRESULT(hr, L"GpuProfiler::BeginFrame >> Mapping readback buffer");
+
+			const UINT64* auTimestamps = reinterpret_cast<const UINT64*>(static_cast<const BYTE*>(pData) + uBeginOffset);
+			std::vector<Profiler::ScopeEvent>& aEvents = m_aaEvents[uFrameIndex];
+			for (UINT i = 0u; i < uNumScopes; ++i)
+			{
+				aEvents[i].uBegin = auTimestamps[i * 2u];
+				aEvents[i].uEnd = auTimestamps[i * 2u + 1u];
+			}
+
+			const D3D12_RANGE writeRange = { .Begin = 0u, .End = 0u };
+			m_pReadbackBuffer->Unmap(0u, &writeRange);
+
+			Profiler::GetInstance().ResolveGpuFrame(aEvents.data(), uNumScopes, static_cast<DOUBLE>(m_uTimestampFrequency));
+		}
+
+		m_auNumScopes[uFrameIndex] = 0u;
+		m_abIsResolved[uFrameIndex] = FALSE;
+
+		return hr;
+	}
+
+	void GpuProfiler::EndFrame(_In_ ID3D12GraphicsCommandList2* pCommandList) noexcept
+	{
+		UINT uNumScopes = m_auNumScopes[m_uFrameIndex];
+		if (uNumScopes == 0u)
+		{
+			return;
+		}
+
+		const UINT uFirstQuery = m_uFrameIndex * MAX_SCOPES_PER_FRAME * 2u;
+		pCommandList->ResolveQueryData(
+			m_pQueryHeap.Get(),
+			D3D12_QUERY_TYPE_TIMESTAMP,
+			uFirstQuery,
+			uNumScopes * 2u,
+			m_pReadbackBuffer.Get(),
+			uFirstQuery * sizeof(UINT64)
+		);
+		m_abIsResolved[m_uFrameIndex] = TRUE;
+	}
+
+	UINT GpuProfiler::BeginScope(_In_ ID3D12GraphicsCommandList2* pCommandList, _In_ PCSTR pszName) noexcept
+	{
+		UINT uScope = m_auNumScopes[m_uFrameIndex];
+		if (uScope >= MAX_SCOPES_PER_FRAME)
+		{
+			return Profiler::INVALID_INDEX;
+		}
+		++m_auNumScopes[m_uFrameIndex];
+
+		Profiler::ScopeEvent& event = m_aaEvents[m_uFrameIndex][uScope];
+		event.pszName = pszName;
+		event.uParent = m_uCurrentScope;
+		event.uThread = 0u;
+		m_uCurrentScope = uScope;
+
+		pCommandList->EndQuery(m_pQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, (m_uFrameIndex * MAX_SCOPES_PER_FRAME + uScope) * 2u);
+
+		return uScope;
+	}
+
+	void GpuProfiler::EndScope(_In_ ID3D12GraphicsCommandList2* pCommandList, _In_ UINT uScope) noexcept
+	{
+		if (uScope == Profiler::INVALID_INDEX)
+		{
+			return;
+		}
+
+		pCommandList->EndQuery(m_pQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, (m_uFrameIndex * MAX_SCOPES_PER_FRAME + uScope) * 2u + 1u);
+
+		m_uCurrentScope = m_aaEvents[m_uFrameIndex][uScope].uParent;
+	}
+}
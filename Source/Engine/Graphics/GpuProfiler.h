@@ -0,0 +1,74 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Utility/Profiler.h"
+
+namespace pr
+{
+	class GpuProfiler final
+	{
+	public:
+		static constexpr const UINT MAX_SCOPES_PER_FRAME = 256u;
+
+	public:
+		explicit GpuProfiler() noexcept;
+		GpuProfiler(const GpuProfiler& other) = delete;
+		GpuProfiler(GpuProfiler&& other) = delete;
+		GpuProfiler& operator=(const GpuProfiler& other) = delete;
+		GpuProfiler& operator=(GpuProfiler&& other) = delete;
+		~GpuProfiler() noexcept = default;
+
+		HRESULT Initialize(_In_ ID3D12Device2* pDevice, _In_ ID3D12CommandQueue* pCommandQueue) noexcept;
+
+		// The frame slot's fence must already be complete, its last timestamps are read back here
+		HRESULT BeginFrame(_In_ UINT uFrameIndex) noexcept;
+		void EndFrame(_In_ ID3D12GraphicsCommandList2* pCommandList) noexcept;
+
+		UINT BeginScope(_In_ ID3D12GraphicsCommandList2* pCommandList, _In_ PCSTR pszName) noexcept;
+		void EndScope(_In_ ID3D12GraphicsCommandList2* pCommandList, _In_ UINT uScope) noexcept;
+
+	private:
+		ComPtr<ID3D12QueryHeap> m_pQueryHeap;
+		ComPtr<ID3D12Resource> m_pReadbackBuffer;
+		std::vector<Profiler::ScopeEvent> m_aaEvents[Profiler::NUM_FRAMES];
+		UINT m_auNumScopes[Profiler::NUM_FRAMES];
+		BOOL m_abIsResolved[Profiler::NUM_FRAMES];
+		UINT64 m_uTimestampFrequency;
+		UINT m_uFrameIndex;
+		UINT m_uCurrentScope;
+	};
+
+	class GpuProfileScope final
+	{
+	public:
+		explicit GpuProfileScope(_In_ GpuProfiler* pGpuProfiler, _In_ ID3D12GraphicsCommandList2* pCommandList, _In_ PCSTR pszName) noexcept
+			: m_pGpuProfiler(pGpuProfiler)
+			, m_pCommandList(pCommandList)
+			, m_uScope(pGpuProfiler ? pGpuProfiler->BeginScope(pCommandList, pszName) : Profiler::INVALID_INDEX)
+		{
+		}
+		GpuProfileScope(const GpuProfileScope& other) = delete;
+		GpuProfileScope(GpuProfileScope&& other) = delete;
+		GpuProfileScope& operator=(const GpuProfileScope& other) = delete;
+		GpuProfileScope& operator=(GpuProfileScope&& other) = delete;
+		~GpuProfileScope() noexcept
+		{
+			if (m_pGpuProfiler)
+			{
+				m_pGpuProfiler->EndScope(m_pCommandList, m_uScope);
+			}
+		}
+
+	private:
+		GpuProfiler* m_pGpuProfiler;
+		ID3D12GraphicsCommandList2* m_pCommandList;
+		UINT m_uScope;
+	};
+}
+
+#if PR_ENABLE_PROFILING
+#define PR_PROFILE_GPU_SCOPE(pGpuProfiler, pCommandList, pszName) pr::GpuProfileScope PR_PROFILE_CONCAT(gpuProfileScope, __LINE__)(pGpuProfiler, pCommandList, pszName)
+#else
+#define PR_PROFILE_GPU_SCOPE(pGpuProfiler, pCommandList, pszName) ((void)0)
+#endif
@@ -0,0 +1,191 @@
+#include "pch.h"
+
+#include "Graphics/IndirectCommandBuilder.h"
+
+namespace pr
+{
+	/*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+	  Method:   IndirectCommandBuilder::IndirectCommandBuilder
+
+	  Summary:  Constructor
+
+	  Modifies: [m_aCommands].
+	M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+	IndirectCommandBuilder::IndirectCommandBuilder() noexcept
+		: m_aCommands()
+	{
+	}
+
+	/*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+	  Method:   IndirectCommandBuilder::GetArgumentDescs
+
+	  Summary:  Fills the arguments of the command signature in the
+	            order of the fields of IndirectDrawCommand: vertex
+	            buffer view, index buffer view, first instance
+	            constant and indexed draw
+
+	  Args:     D3D12_INDIRECT_ARGUMENT_DESC* aOutArgumentDescs
+	              NUM_ARGUMENTS descs to fill
+	            UINT uFirstInstanceRootParameter
+	              Root parameter of the first instance, a single
+	              32-bit constant
+	M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+	void IndirectCommandBuilder::GetArgumentDescs(_Out_writes_(NUM_ARGUMENTS) D3D12_INDIRECT_ARGUMENT_DESC* aOutArgumentDescs, _In_ UINT uFirstInstanceRootParameter) noexcept
+	{
+		aOutArgumentDescs[0] = {};
+		aOutArgumentDescs[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW;
+		aOutArgumentDescs[0].VertexBuffer.Slot = 0u;
+
+		aOutArgumentDescs[1] = {};
+		aOutArgumentDescs[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+
+		aOutArgumentDescs[2] = {};
+		aOutArgumentDescs[2].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+		aOutArgumentDescs[2].Constant.RootParameterIndex = uFirstInstanceRootParameter;
+		aOutArgumentDescs[2].Constant.DestOffsetIn32BitValues = 0u;
+		aOutArgumentDescs[2].Constant.Num32BitValuesToSet = 1u;
+
+		aOutArgumentDescs[3] = {};
+		aOutArgumentDescs[3].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+	}
+
+	/*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+	  Method:   IndirectCommandBuilder::GetCommandSignatureDesc
+
+	  Summary:  Describes the command signature of IndirectDrawCommand
+
+	  Args:     const D3D12_INDIRECT_ARGUMENT_DESC* aArgumentDescs
+	              Descs filled by GetArgumentDescs, referenced by the
+	              returned desc
+
+	  Returns:  D3D12_COMMAND_SIGNATURE_DESC
+	              Desc with the stride of one IndirectDrawCommand.
+	M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+	D3D12_COMMAND_SIGNATURE_DESC IndirectCommandBuilder::GetCommandSignatureDesc(_In_reads_(NUM_ARGUMENTS) const D3D12_INDIRECT_ARGUMENT_DESC* aArgumentDescs) noexcept
+	{
+		return D3D12_COMMAND_SIGNATURE_DESC
+		{
+			.ByteStride = sizeof(IndirectDrawCommand),
+			.NumArgumentDescs = NUM_ARGUMENTS,
+			.pArgumentDescs = aArgumentDescs,
+			.NodeMask = 0u,
+		};
+	}
+
+	/*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+	  Method:   IndirectCommandBuilder::Reset
+
+	  Summary:  Removes the commands of the last frame
+
+	  Modifies: [m_aCommands].
+	M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+	void IndirectCommandBuilder::Reset() noexcept
+	{
+		m_aCommands.clear();
+	}
+
+	/*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+	  Method:   IndirectCommandBuilder::AddDraw
+
+	  Summary:  Appends an indexed draw with its geometry bindings
+
+	  Args:     const D3D12_VERTEX_BUFFER_VIEW& vertexBufferView
+	              Vertex buffer bound to slot 0
+	            const D3D12_INDEX_BUFFER_VIEW& indexBufferView
+	              Index buffer of the draw
+	            UINT uFirstInstance
+	              Root constant that offsets the instance id
+	            UINT uIndexCountPerInstance
+	              Number of indices per instance
+	            UINT uInstanceCount
+	              Number of instances
+	            UINT uStartIndexLocation
+	              First index of the draw
+	            INT iBaseVertexLocation
+	              Added to each index before reading the vertex
+
+	  Modifies: [m_aCommands].
+	M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+	void IndirectCommandBuilder::AddDraw(
+		_In_ const D3D12_VERTEX_BUFFER_VIEW& vertexBufferView,
+		_In_ const D3D12_INDEX_BUFFER_VIEW& indexBufferView,
+		_In_ UINT uFirstInstance,
+		_In_ UINT uIndexCountPerInstance,
+		_In_ UINT uInstanceCount,
+		_In_ UINT uStartIndexLocation,
+		_In_ INT iBaseVertexLocation
+	)
+	{
+		// Zero the whole command first so padding never leaks into the argument buffer
+		IndirectDrawCommand command;
+		memset(&command, 0, sizeof(command));
+
+		command.VertexBufferView = vertexBufferView;
+		command.IndexBufferView = indexBufferView;
+		command.uFirstInstance = uFirstInstance;
+		command.DrawArguments.IndexCountPerInstance = uIndexCountPerInstance;
+		command.DrawArguments.InstanceCount = uInstanceCount;
+		command.DrawArguments.StartIndexLocation = uStartIndexLocation;
+		command.DrawArguments.BaseVertexLocation = iBaseVertexLocation;
+		command.DrawArguments.StartInstanceLocation = 0u;
+
+		m_aCommands.push_back(command);
+	}
+
+	/*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+	  Method:   IndirectCommandBuilder::GetNumCommands
+
+	  Summary:  Returns the number of commands
+
+	  Returns:  UINT
+	              Number of draws added since the last Reset.
+	M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+	UINT IndirectCommandBuilder::GetNumCommands() const noexcept
+	{
+		return static_cast<UINT>(m_aCommands.size());
+	}
+
+	/*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+	  Method:   IndirectCommandBuilder::GetSizeInBytes
+
+	  Summary:  Returns the size of the argument buffer
+
+	  Returns:  size_t
+	              Size of the commands in bytes.
+	M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+	size_t IndirectCommandBuilder::GetSizeInBytes() const noexcept
+	{
+		return sizeof(IndirectDrawCommand) * m_aCommands.size();
+	}
+
+	/*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+	  Method:   IndirectCommandBuilder::GetCommands
+
+	  Summary:  Returns the commands
+
+	  Returns:  const IndirectDrawCommand*
+	              Commands in the order they were added, valid until
+	              the next AddDraw or Reset.
+	M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+	const IndirectDrawCommand* IndirectCommandBuilder::GetCommands() const noexcept
+	{
+		return m_aCommands.data();
+	}
+
+	/*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+	  Method:   IndirectCommandBuilder::WriteTo
+
+	  Summary:  Copies the argument buffer
+
+	  Args:     void* pDestination
+	              Destination of GetSizeInBytes() bytes, usually a
+	              mapped upload buffer
+	M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+	void IndirectCommandBuilder::WriteTo(_Out_writes_bytes_(GetSizeInBytes()) void* pDestination) const noexcept
+	{
+		if (!m_aCommands.empty())
+		{
+			memcpy(pDestination, m_aCommands.data(), GetSizeInBytes());
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "pch.h"
+
+namespace pr
+{
+	// One ExecuteIndirect command: geometry bindings, the first instance root constant and the draw itself
+	struct IndirectDrawCommand
+	{
+		D3D12_VERTEX_BUFFER_VIEW VertexBufferView;
+		D3D12_INDEX_BUFFER_VIEW IndexBufferView;
+		UINT uFirstInstance;
+		D3D12_DRAW_INDEXED_ARGUMENTS DrawArguments;
+	};
+	static_assert(sizeof(D3D12_VERTEX_BUFFER_VIEW) == 16);
+	static_assert(sizeof(D3D12_INDEX_BUFFER_VIEW) == 16);
+	static_assert(sizeof(D3D12_DRAW_INDEXED_ARGUMENTS) == 20);
+	static_assert(offsetof(IndirectDrawCommand, VertexBufferView) == 0);
+	static_assert(offsetof(IndirectDrawCommand, IndexBufferView) == 16);
+	static_assert(offsetof(IndirectDrawCommand, uFirstInstance) == 32);
+	static_assert(offsetof(IndirectDrawCommand, DrawArguments) == 36);
+	static_assert(sizeof(IndirectDrawCommand) == 56);
+
+	// Builds the argument buffer and the matching command signature layout on the CPU without touching the device
+	class IndirectCommandBuilder final
+	{
+	public:
+		static constexpr const UINT NUM_ARGUMENTS = 4u;
+
+	public:
+		explicit IndirectCommandBuilder() noexcept;
+		IndirectCommandBuilder(const IndirectCommandBuilder& other) = delete;
+		IndirectCommandBuilder(IndirectCommandBuilder&& other) = delete;
+		IndirectCommandBuilder& operator=(const IndirectCommandBuilder& other) = delete;
+		IndirectCommandBuilder& operator=(IndirectCommandBuilder&& other) = delete;
+		~IndirectCommandBuilder() noexcept = default;
+
+		// Argument order must match IndirectDrawCommand, uFirstInstanceRootParameter takes a single 32-bit constant
+		static void GetArgumentDescs(_Out_writes_(NUM_ARGUMENTS) D3D12_INDIRECT_ARGUMENT_DESC* aOutArgumentDescs, _In_ UINT uFirstInstanceRootParameter) noexcept;
+		static D3D12_COMMAND_SIGNATURE_DESC GetCommandSignatureDesc(_In_reads_(NUM_ARGUMENTS) const D3D12_INDIRECT_ARGUMENT_DESC* aArgumentDescs) noexcept;
+
+		void Reset() noexcept;
+		void AddDraw(
+			_In_ const D3D12_VERTEX_BUFFER_VIEW& vertexBufferView,
+			_In_ const D3D12_INDEX_BUFFER_VIEW& indexBufferView,
+			_In_ UINT uFirstInstance,
+			_In_ UINT uIndexCountPerInstance,
+			_In_ UINT uInstanceCount,
+			_In_ UINT uStartIndexLocation,
+			_In_ INT iBaseVertexLocation
+		);
+
+		UINT GetNumCommands() const noexcept;
+		size_t GetSizeInBytes() const noexcept;
+		const IndirectDrawCommand* GetCommands() const noexcept;
+
+		// Copies the argument buffer, pDestination must hold GetSizeInBytes() bytes
+		void WriteTo(_Out_writes_bytes_(GetSizeInBytes()) void* pDestination) const noexcept;
+
+	private:
+		std::vector<IndirectDrawCommand> m_aCommands;
+	};
+}
@@ -0,0 +1,350 @@
+#include "pch.h"
+
+#include "Graphics/MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace pr
+{
+	namespace
+	{
+		constexpr const UINT INVALID_VERTEX = 0xFFFFFFFFu;
+
+		inline const XMFLOAT3& getPosition(_In_ const XMFLOAT3* pPositions, _In_ size_t uStride, _In_ UINT uIndex) noexcept
+		{
+			return *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const BYTE*>(pPositions) + uStride * uIndex);
+		}
+
+		// FIFO cache of vertex indices, a vertex is cached while fewer than uCacheSize misses came after it
+		class FifoCache final
+		{
+		public:
+			explicit FifoCache(_In_ UINT uNumVertices, _In_ UINT uCacheSize)
+				: m_auMissTimes(uNumVertices, 0u)
+				, m_uTime(uCacheSize + 1u)
+				, m_uCacheSize(uCacheSize)
+			{
+			}
+
+			// Returns whether the vertex had to be transformed
+			BOOL Access(_In_ UINT uVertex) noexcept
+			{
+				if (m_uTime - m_auMissTimes[uVertex] <= m_uCacheSize)
+				{
+					return FALSE;
+				}
+
+				m_auMissTimes[uVertex] = ++m_uTime;
+				return TRUE;
+			}
+
+			void Clear() noexcept
+			{
+				m_uTime += m_uCacheSize + 1u;
+			}
+
+		private:
+			std::vector<UINT> m_auMissTimes;
+			UINT m_uTime;
+			UINT m_uCacheSize;
+		};
+	}
+
+	VertexCacheStats SimulateVertexCache(
+		_In_reads_(uNumIndices) const WORD* pIndices,
+		_In_ UINT uNumIndices,
+		_In_ UINT uNumVertices,
+		_In_ UINT uCacheSize
+	)
+	{
+		FifoCache cache(uNumVertices, uCacheSize);
+
+		UINT uNumTransformed = 0u;
+		for (UINT i = 0u; i < uNumIndices; ++i)
+		{
+			uNumTransformed += cache.Access(pIndices[i]) ? 1u : 0u;
+		}
+
+		return VertexCacheStats
+		{
+			.uNumTransformed = uNumTransformed,
+			.Acmr = uNumIndices >= 3u ? static_cast<FLOAT>(uNumTransformed) / static_cast<FLOAT>(uNumIndices / 3u) : 0.0f,
+			.Atvr = uNumVertices > 0u ? static_cast<FLOAT>(uNumTransformed) / static_cast<FLOAT>(uNumVertices) : 0.0f,
+		};
+	}
+
+	void OptimizeVertexCache(
+		_Inout_updates_(uNumIndices) WORD* pIndices,
+		_In_ UINT uNumIndices,
+		_In_ UINT uNumVertices,
+		_Out_opt_ std::vector<UINT>* pOutClusters
+	)
+	{
+		const UINT uNumTriangles = uNumIndices / 3u;
+		if (pOutClusters)
+		{
+			pOutClusters->assign(1u, 0u);
+		}
+
+		if (uNumTriangles == 0u)
+		{
+			return;
+		}
+
+		// Triangles around each vertex, auLiveCounts[v] of them are not emitted yet
+		std::vector<UINT> auFirstTriangles(static_cast<size_t>(uNumVertices) + 1u, 0u);
+		for (UINT i = 0u; i < uNumTriangles * 3u; ++i)
+		{
+			++auFirstTriangles[pIndices[i] + 1u];
+		}
+		std::partial_sum(auFirstTriangles.begin(), auFirstTriangles.end(), auFirstTriangles.begin());
+
+		std::vector<UINT> auLiveCounts(uNumVertices);
+		for (UINT i = 0u; i < uNumVertices; ++i)
+		{
+			auLiveCounts[i] = auFirstTriangles[i + 1u] - auFirstTriangles[i];
+		}
+
+		std::vector<UINT> auAdjacentTriangles(uNumTriangles * 3u);
+		{
+			std::vector<UINT> auOffsets(auFirstTriangles.begin(), auFirstTriangles.end() - 1);
+			for (UINT i = 0u; i < uNumTriangles * 3u; ++i)
+			{
+				auAdjacentTriangles[auOffsets[pIndices[i]]++] = i / 3u;
+			}
+		}
+
+		std::vector<WORD> aOutIndices;
+		aOutIndices.reserve(uNumTriangles * 3u);
+		std::vector<BYTE> abEmitted(uNumTriangles, FALSE);
+		std::vector<UINT> auCacheTimes(uNumVertices, 0u);
+		std::vector<UINT> auDeadEnds;
+		std::vector<UINT> auCandidates;
+		UINT uTime = VERTEX_CACHE_SIZE + 1u;
+		UINT uCursor = 0u;
+
+		UINT uFan = 0u;
+		while (uFan != INVALID_VERTEX)
+		{
+			// Emit every remaining triangle around the fanning vertex
+			auCandidates.clear();
+			for (UINT i = auFirstTriangles[uFan]; i < auFirstTriangles[uFan + 1u]; ++i)
+			{
+				UINT uTriangle = auAdjacentTriangles[i];
+				if (abEmitted[uTriangle])
+				{
+					continue;
+				}
+
+				for (UINT j = 0u; j < 3u; ++j)
+				{
+					UINT uVertex = pIndices[uTriangle * 3u + j];
+					aOutIndices.push_back(static_cast<WORD>(uVertex));
+					auDeadEnds.push_back(uVertex);
+					auCandidates.push_back(uVertex);
+					--auLiveCounts[uVertex];
+					if (uTime - auCacheTimes[uVertex] > VERTEX_CACHE_SIZE)
+					{
+						auCacheTimes[uVertex] = uTime++;
+					}
+				}
+				abEmitted[uTriangle] = TRUE;
+			}
+
+			// Continue with the candidate that stays in the cache while its remaining triangles are emitted, and
+			// of those the one that entered the cache first
+			UINT uNext = INVALID_VERTEX;
+			UINT uBestPriority = 0u;
+			for (UINT uVertex : auCandidates)
+			{
+				if (auLiveCounts[uVertex] == 0u)
+				{
+					continue;
+				}
+
+				UINT uPriority = 0u;
+				if (uTime - auCacheTimes[uVertex] + 2u * auLiveCounts[uVertex] <= VERTEX_CACHE_SIZE)
+				{
+					uPriority = uTime - auCacheTimes[uVertex];
+				}
+
+				if (uNext == INVALID_VERTEX || uPriority > uBestPriority)
+				{
+					uBestPriority = uPriority;
+					uNext = uVertex;
+				}
+			}
+
+			// Dead end, go back to a recent vertex with triangles left, or on to the next one in index order
+			if (uNext == INVALID_VERTEX)
+			{
+				while (!auDeadEnds.empty() && uNext == INVALID_VERTEX)
+				{
+					if (auLiveCounts[auDeadEnds.back()] > 0u)
+					{
+						uNext = auDeadEnds.back();
+					}
+					auDeadEnds.pop_back();
+				}
+
+				if (uNext == INVALID_VERTEX)
+				{
+					while (uCursor < uNumVertices && auLiveCounts[uCursor] == 0u)
+					{
+						++uCursor;
+					}
+					uNext = uCursor < uNumVertices ? uCursor : INVALID_VERTEX;
+				}
+
+				if (pOutClusters && uNext != INVALID_VERTEX)
+				{
+					pOutClusters->push_back(static_cast<UINT>(aOutIndices.size() / 3u));
+				}
+			}
+
+			uFan = uNext;
+		}
+
+		assert(aOutIndices.size() == uNumTriangles * 3u);
+		std::copy(aOutIndices.begin(), aOutIndices.end(), pIndices);
+	}
+
+	void OptimizeOverdraw(
+		_Inout_updates_(uNumIndices) WORD* pIndices,
+		_In_ UINT uNumIndices,
+		_In_ const XMFLOAT3* pPositions,
+		_In_ size_t uStride,
+		_In_ UINT uNumVertices,
+		_In_ const std::vector<UINT>& auClusters,
+		_In_ FLOAT threshold
+	)
+	{
+		const UINT uNumTriangles = uNumIndices / 3u;
+		if (uNumTriangles < 2u)
+		{
+			return;
+		}
+
+		// Soft boundaries, a cluster ends as soon as its own ACMR, starting from a cold cache, is good enough
+		const FLOAT targetAcmr = SimulateVertexCache(pIndices, uNumTriangles * 3u, uNumVertices).Acmr * threshold;
+
+		std::vector<UINT> auSoftClusters;
+		FifoCache cache(uNumVertices, VERTEX_CACHE_SIZE);
+		for (size_t i = 0; i < auClusters.size(); ++i)
+		{
+			const UINT uEnd = i + 1u < auClusters.size() ? auClusters[i + 1u] : uNumTriangles;
+
+			UINT uStart = auClusters[i];
+			UINT uNumTransformed = 0u;
+			cache.Clear();
+			auSoftClusters.push_back(uStart);
+			for (UINT uTriangle = uStart; uTriangle < uEnd; ++uTriangle)
+			{
+				for (UINT j = 0u; j < 3u; ++j)
+				{
+					uNumTransformed += cache.Access(pIndices[uTriangle * 3u + j]) ? 1u : 0u;
+				}
+
+				if (uTriangle + 1u < uEnd && static_cast<FLOAT>(uNumTransformed) <= targetAcmr * static_cast<FLOAT>(uTriangle + 1u - uStart))
+				{
+					uStart = uTriangle + 1u;
+					uNumTransformed = 0u;
+					cache.Clear();
+					auSoftClusters.push_back(uStart);
+				}
+			}
+		}
+
+		// Area weighted centroid and normal of every cluster and of the whole mesh
+		const UINT uNumClusters = static_cast<UINT>(auSoftClusters.size());
+		std::vector<XMFLOAT3> aCentroids(uNumClusters, XMFLOAT3(0.0f, 0.0f, 0.0f));
+		std::vector<XMFLOAT3> aNormals(uNumClusters, XMFLOAT3(0.0f, 0.0f, 0.0f));
+		XMVECTOR meshCentroid = XMVectorZero();
+		FLOAT meshArea = 0.0f;
+		for (UINT i = 0u; i < uNumClusters; ++i)
+		{
+			const UINT uEnd = i + 1u < uNumClusters ? auSoftClusters[i + 1u] : uNumTriangles;
+
+			XMVECTOR centroid = XMVectorZero();
+			XMVECTOR normal = XMVectorZero();
+			FLOAT area = 0.0f;
+			for (UINT uTriangle = auSoftClusters[i]; uTriangle < uEnd; ++uTriangle)
+			{
+				XMVECTOR p0 = XMLoadFloat3(&getPosition(pPositions, uStride, pIndices[uTriangle * 3u]));
+				XMVECTOR p1 = XMLoadFloat3(&getPosition(pPositions, uStride, pIndices[uTriangle * 3u + 1u]));
+				XMVECTOR p2 = XMLoadFloat3(&getPosition(pPositions, uStride, pIndices[uTriangle * 3u + 2u]));
+
+				// Twice the area, the factor cancels out
+				XMVECTOR triangleNormal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+				FLOAT triangleArea = XMVectorGetX(XMVector3Length(triangleNormal));
+
+				centroid = XMVectorAdd(centroid, XMVectorScale(XMVectorAdd(XMVectorAdd(p0, p1), p2), triangleArea / 3.0f));
+				normal = XMVectorAdd(normal, triangleNormal);
+				area += triangleArea;
+			}
+
+			meshCentroid = XMVectorAdd(meshCentroid, centroid);
+			meshArea += area;
+
+			XMStoreFloat3(&aCentroids[i], area > 0.0f ? XMVectorScale(centroid, 1.0f / area) : centroid);
+			XMStoreFloat3(&aNormals[i], XMVector3Normalize(normal));
+		}
+		meshCentroid = meshArea > 0.0f ? XMVectorScale(meshCentroid, 1.0f / meshArea) : meshCentroid;
+
+		std::vector<FLOAT> aSortKeys(uNumClusters);
+		for (UINT i = 0u; i < uNumClusters; ++i)
+		{
+			aSortKeys[i] = XMVectorGetX(XMVector3Dot(XMVectorSubtract(XMLoadFloat3(&aCentroids[i]), meshCentroid), XMLoadFloat3(&aNormals[i])));
+		}
+
+		std::vector<UINT> auOrder(uNumClusters);
+		std::iota(auOrder.begin(), auOrder.end(), 0u);
+		std::stable_sort(
+			auOrder.begin(),
+			auOrder.end(),
+			[&aSortKeys](UINT uA, UINT uB)
+			{
+				return aSortKeys[uA] > aSortKeys[uB];
+			}
+		);
+
+		std::vector<WORD> aOutIndices;
+		aOutIndices.reserve(uNumTriangles * 3u);
+		for (UINT uCluster : auOrder)
+		{
+			const UINT uEnd = uCluster + 1u < uNumClusters ? auSoftClusters[uCluster + 1u] : uNumTriangles;
+			aOutIndices.insert(aOutIndices.end(), pIndices + auSoftClusters[uCluster] * 3u, pIndices + uEnd * 3u);
+		}
+		std::copy(aOutIndices.begin(), aOutIndices.end(), pIndices);
+	}
+
+	void OptimizeVertexFetch(
+		_Out_ std::vector<UINT>& auOutRemap,
+		_Inout_updates_(uNumIndices) WORD* pIndices,
+		_In_ UINT uNumIndices,
+		_In_ UINT uNumVertices
+	)
+	{
+		auOutRemap.assign(uNumVertices, INVALID_VERTEX);
+
+		UINT uNumUsed = 0u;
+		for (UINT i = 0u; i < uNumIndices; ++i)
+		{
+			UINT& uNewIndex = auOutRemap[pIndices[i]];
+			if (uNewIndex == INVALID_VERTEX)
+			{
+				uNewIndex = uNumUsed++;
+			}
+			pIndices[i] = static_cast<WORD>(uNewIndex);
+		}
+
+		for (UINT i = 0u; i < uNumVertices; ++i)
+		{
+			if (auOutRemap[i] == INVALID_VERTEX)
+			{
+				auOutRemap[i] = uNumUsed++;
+			}
+		}
+	}
+}
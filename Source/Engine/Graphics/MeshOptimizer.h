@@ -0,0 +1,59 @@
+#pragma once
+
+#include "pch.h"
+
+namespace pr
+{
+	// Entries of the FIFO post-transform cache the optimizations aim for and the statistics are simulated with
+	constexpr const UINT VERTEX_CACHE_SIZE = 16u;
+
+	// ACMR is the number of vertices transformed per triangle, 3 without any reuse and about 0.5 at best on a
+	// regular grid. ATVR is the number transformed per vertex of the mesh, 1 when every vertex is transformed once.
+	struct VertexCacheStats
+	{
+		UINT uNumTransformed;
+		FLOAT Acmr;
+		FLOAT Atvr;
+	};
+
+	// Draws the triangle list through a FIFO cache of uCacheSize entries
+	VertexCacheStats SimulateVertexCache(
+		_In_reads_(uNumIndices) const WORD* pIndices,
+		_In_ UINT uNumIndices,
+		_In_ UINT uNumVertices,
+		_In_ UINT uCacheSize = VERTEX_CACHE_SIZE
+	);
+
+	// Reorders the triangles for vertex cache locality with Tipsify (Sander, Nehab and Barczak, "Fast Triangle
+	// Reordering for Vertex Locality and Reduced Overdraw", 2007), which fans around vertices while they are still
+	// cached. Triangles where it jumps to a vertex out of the cache are appended to pOutClusters, the clusters
+	// between them can be reordered by OptimizeOverdraw without losing more than their first triangles' reuse.
+	void OptimizeVertexCache(
+		_Inout_updates_(uNumIndices) WORD* pIndices,
+		_In_ UINT uNumIndices,
+		_In_ UINT uNumVertices,
+		_Out_opt_ std::vector<UINT>* pOutClusters
+	);
+
+	// Splits the clusters further where their ACMR stays within threshold times that of the whole list, then sorts
+	// them so clusters on the outside of the mesh facing away from its center come first. Those tend to occlude the
+	// rest from any direction, so the order reduces overdraw without knowing the view.
+	void OptimizeOverdraw(
+		_Inout_updates_(uNumIndices) WORD* pIndices,
+		_In_ UINT uNumIndices,
+		_In_ const XMFLOAT3* pPositions,
+		_In_ size_t uStride,
+		_In_ UINT uNumVertices,
+		_In_ const std::vector<UINT>& auClusters,
+		_In_ FLOAT threshold
+	);
+
+	// Numbers the vertices in the order the triangles first use them and rewrites the indices. Vertex i moves to
+	// auOutRemap[i], unused vertices go last in their original order, so the vertex count does not change.
+	void OptimizeVertexFetch(
+		_Out_ std::vector<UINT>& auOutRemap,
+		_Inout_updates_(uNumIndices) WORD* pIndices,
+		_In_ UINT uNumIndices,
+		_In_ UINT uNumVertices
+	);
+}
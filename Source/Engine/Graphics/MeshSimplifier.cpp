@@ -0,0 +1,389 @@
+#include "pch.h"
+
+#include "Graphics/MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+namespace pr
+{
+	namespace
+	{
+		// Sum of squared distances to planes weighted by triangle area, A = n n^T, b = d n, c = d^2
+		struct Quadric
+		{
+			double a00, a11, a22, a01, a02, a12;
+			double b0, b1, b2;
+			double c;
+			double Weight;
+		};
+
+		struct Collapse
+		{
+			double Cost;
+			UINT uSource;
+			UINT uTarget;
+		};
+
+		constexpr const UINT MAX_PASSES = 64u;
+
+		inline const XMFLOAT3& getPosition(_In_ const XMFLOAT3* pPositions, _In_ size_t uStride, _In_ UINT uIndex) noexcept
+		{
+			return *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const BYTE*>(pPositions) + uStride * uIndex);
+		}
+
+		inline UINT64 makeEdge(_In_ UINT uA, _In_ UINT uB) noexcept
+		{
+			return uA < uB ? (static_cast<UINT64>(uA) << 32ull) | uB : (static_cast<UINT64>(uB) << 32ull) | uA;
+		}
+
+		void addQuadric(_Inout_ Quadric& quadric, _In_ const Quadric& other) noexcept
+		{
+			quadric.a00 += other.a00;
+			quadric.a11 += other.a11;
+			quadric.a22 += other.a22;
+			quadric.a01 += other.a01;
+			quadric.a02 += other.a02;
+			quadric.a12 += other.a12;
+			quadric.b0 += other.b0;
+			quadric.b1 += other.b1;
+			quadric.b2 += other.b2;
+			quadric.c += other.c;
+			quadric.Weight += other.Weight;
+		}
+
+		// Mean squared distance of the point to the planes accumulated in the quadric
+		double evaluateQuadric(_In_ const Quadric& quadric, _In_ const XMFLOAT3& position) noexcept
+		{
+			double x = position.x;
+			double y = position.y;
+			double z = position.z;
+
+			double error = quadric.a00 * x * x + quadric.a11 * y * y + quadric.a22 * z * z
+				+ 2.0 * (quadric.a01 * x * y + quadric.a02 * x * z + quadric.a12 * y * z)
+				+ 2.0 * (quadric.b0 * x + quadric.b1 * y + quadric.b2 * z)
+				+ quadric.c;
+
+			return quadric.Weight > 0.0 ? std::max(error / quadric.Weight, 0.0) : 0.0;
+		}
+
+		XMFLOAT3 computeNormal(_In_ const XMFLOAT3& p0, _In_ const XMFLOAT3& p1, _In_ const XMFLOAT3& p2) noexcept
+		{
+			XMFLOAT3 e0(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z);
+			XMFLOAT3 e1(p2.x - p0.x, p2.y - p0.y, p2.z - p0.z);
+
+			return XMFLOAT3(e0.y * e1.z - e0.z * e1.y, e0.z * e1.x - e0.x * e1.z, e0.x * e1.y - e0.y * e1.x);
+		}
+
+		// Locks every vertex that cannot move without opening a hole or tearing a seam
+		void lockVertices(
+			_Out_ std::vector<BYTE>& abLocked,
+			_In_ const XMFLOAT3* pPositions,
+			_In_ size_t uStride,
+			_In_ UINT uNumVertices,
+			_In_reads_(uNumIndices) const WORD* pIndices,
+			_In_ UINT uNumIndices
+		)
+		{
+			// Split vertices with the same position are welded to the first one
+			std::vector<UINT> auWelded(uNumVertices);
+			std::vector<UINT> auNumWedges(uNumVertices, 0u);
+			std::unordered_map<UINT64, UINT> firstVertices;
+			firstVertices.reserve(uNumVertices);
+			for (UINT i = 0u; i < uNumVertices; ++i)
+			{
+				const XMFLOAT3& position = getPosition(pPositions, uStride, i);
+				UINT auBits[3];
+				memcpy(auBits, &position, sizeof(auBits));
+
+				UINT64 uHash = (static_cast<UINT64>(auBits[0]) * 73856093ull) ^ (static_cast<UINT64>(auBits[1]) * 19349663ull) ^ (static_cast<UINT64>(auBits[2]) * 83492791ull);
+				UINT uWelded = i;
+				for (auto iter = firstVertices.find(uHash); iter != firstVertices.end(); iter = firstVertices.find(++uHash))
+				{
+					if (memcmp(&getPosition(pPositions, uStride, iter->second), &position, sizeof(XMFLOAT3)) == 0)
+					{
+						uWelded = iter->second;
+						break;
+					}
+				}
+				if (uWelded == i)
+				{
+					firstVertices.emplace(uHash, i);
+				}
+
+				auWelded[i] = uWelded;
+				++auNumWedges[uWelded];
+			}
+
+			// Edges of the welded mesh with anything but two triangles are borders or non-manifold
+			std::vector<UINT64> auEdges;
+			auEdges.reserve(uNumIndices);
+			for (UINT i = 0u; i + 2u < uNumIndices; i += 3u)
+			{
+				for (UINT uCorner = 0u; uCorner < 3u; ++uCorner)
+				{
+					UINT uA = auWelded[pIndices[i + uCorner]];
+					UINT uB = auWelded[pIndices[i + (uCorner + 1u) % 3u]];
+					if (uA != uB)
+					{
+						auEdges.push_back(makeEdge(uA, uB));
+					}
+				}
+			}
+			std::sort(auEdges.begin(), auEdges.end());
+
+			std::vector<BYTE> abWeldedLocked(uNumVertices, FALSE);
+			for (UINT i = 0u; i < uNumVertices; ++i)
+			{
+				abWeldedLocked[auWelded[i]] = auNumWedges[auWelded[i]] > 1u;
+			}
+
+			for (size_t uBegin = 0u; uBegin < auEdges.size();)
+			{
+				size_t uEnd = uBegin + 1u;
+				while (uEnd < auEdges.size() && auEdges[uEnd] == auEdges[uBegin])
+				{
+					++uEnd;
+				}
+
+				if (uEnd - uBegin != 2u)
+				{
+					abWeldedLocked[static_cast<UINT>(auEdges[uBegin] >> 32ull)] = TRUE;
+					abWeldedLocked[static_cast<UINT>(auEdges[uBegin] & 0xFFFFFFFFull)] = TRUE;
+				}
+				uBegin = uEnd;
+			}
+
+			abLocked.resize(uNumVertices);
+			for (UINT i = 0u; i < uNumVertices; ++i)
+			{
+				abLocked[i] = abWeldedLocked[auWelded[i]];
+			}
+		}
+	}
+
+	FLOAT SimplifyMesh(
+		_Out_ std::vector<WORD>& aOutIndices,
+		_In_ const XMFLOAT3* pPositions,
+		_In_ size_t uStride,
+		_In_ UINT uNumVertices,
+		_In_reads_(uNumIndices) const WORD* pIndices,
+		_In_ UINT uNumIndices,
+		_In_ UINT uTargetNumIndices,
+		_In_ FLOAT maxError
+	)
+	{
+		aOutIndices.assign(pIndices, pIndices + uNumIndices);
+		if (uNumIndices <= uTargetNumIndices || uNumVertices == 0u)
+		{
+			return 0.0f;
+		}
+
+		std::vector<BYTE> abLocked;
+		lockVertices(abLocked, pPositions, uStride, uNumVertices, pIndices, uNumIndices);
+
+		std::vector<Quadric> aQuadrics(uNumVertices, Quadric{});
+		for (UINT i = 0u; i + 2u < uNumIndices; i += 3u)
+		{
+			const XMFLOAT3& p0 = getPosition(pPositions, uStride, pIndices[i]);
+			const XMFLOAT3& p1 = getPosition(pPositions, uStride, pIndices[i + 1u]);
+			const XMFLOAT3& p2 = getPosition(pPositions, uStride, pIndices[i + 2u]);
+
+			XMFLOAT3 normal = computeNormal(p0, p1, p2);
+			double length = std::sqrt(static_cast<double>(normal.x) * normal.x + static_cast<double>(normal.y) * normal.y + static_cast<double>(normal.z) * normal.z);
+			if (length <= 0.0)
+			{
+				continue;
+			}
+
+			double nx = normal.x / length;
+			double ny = normal.y / length;
+			double nz = normal.z / length;
+			double d = -(nx * p0.x + ny * p0.y + nz * p0.z);
+			double area = length * 0.5;
+
+			Quadric plane =
+			{
+				.a00 = area * nx * nx, .a11 = area * ny * ny, .a22 = area * nz * nz,
+				.a01 = area * nx * ny, .a02 = area * nx * nz, .a12 = area * ny * nz,
+				.b0 = area * d * nx, .b1 = area * d * ny, .b2 = area * d * nz,
+				.c = area * d * d,
+				.Weight = area,
+			};
+
+			for (UINT uCorner = 0u; uCorner < 3u; ++uCorner)
+			{
+				addQuadric(aQuadrics[pIndices[i + uCorner]], plane);
+			}
+		}
+
+		const double maxCost = static_cast<double>(maxError) * static_cast<double>(maxError);
+		const UINT uTargetNumTriangles = uTargetNumIndices / 3u;
+		double error = 0.0;
+
+		std::vector<UINT> auAdjacencyOffsets(uNumVertices + 1u);
+		std::vector<UINT> auAdjacentTriangles;
+		std::vector<UINT64> auEdges;
+		std::vector<Collapse> aCollapses;
+		std::vector<UINT> auRemap(uNumVertices);
+		std::vector<BYTE> abTouched(uNumVertices);
+
+		// Every pass collapses each vertex at most once, so the adjacency built at its start stays usable
+		for (UINT uPass = 0u; uPass < MAX_PASSES && aOutIndices.size() / 3u > uTargetNumTriangles; ++uPass)
+		{
+			UINT uNumTriangles = static_cast<UINT>(aOutIndices.size() / 3u);
+
+			std::fill(auAdjacencyOffsets.begin(), auAdjacencyOffsets.end(), 0u);
+			for (WORD uIndex : aOutIndices)
+			{
+				++auAdjacencyOffsets[uIndex + 1u];
+			}
+			std::partial_sum(auAdjacencyOffsets.begin(), auAdjacencyOffsets.end(), auAdjacencyOffsets.begin());
+
+			auAdjacentTriangles.resize(aOutIndices.size());
+			std::vector<UINT> auFill(auAdjacencyOffsets.begin(), auAdjacencyOffsets.end() - 1);
+			for (UINT i = 0u; i < aOutIndices.size(); ++i)
+			{
+				auAdjacentTriangles[auFill[aOutIndices[i]]++] = i / 3u;
+			}
+
+			auEdges.clear();
+			for (UINT i = 0u; i < aOutIndices.size(); i += 3u)
+			{
+				for (UINT uCorner = 0u; uCorner < 3u; ++uCorner)
+				{
+					auEdges.push_back(makeEdge(aOutIndices[i + uCorner], aOutIndices[i + (uCorner + 1u) % 3u]));
+				}
+			}
+			std::sort(auEdges.begin(), auEdges.end());
+			auEdges.erase(std::unique(auEdges.begin(), auEdges.end()), auEdges.end());
+
+			// Collapse each edge towards the end point that costs less
+			aCollapses.clear();
+			for (UINT64 uEdge : auEdges)
+			{
+				UINT uA = static_cast<UINT>(uEdge >> 32ull);
+				UINT uB = static_cast<UINT>(uEdge & 0xFFFFFFFFull);
+				if (uA == uB || (abLocked[uA] && abLocked[uB]))
+				{
+					continue;
+				}
+
+				Quadric quadric = aQuadrics[uA];
+				addQuadric(quadric, aQuadrics[uB]);
+
+				double costToA = abLocked[uB] ? DBL_MAX : evaluateQuadric(quadric, getPosition(pPositions, uStride, uA));
+				double costToB = abLocked[uA] ? DBL_MAX : evaluateQuadric(quadric, getPosition(pPositions, uStride, uB));
+
+				aCollapses.push_back(costToB <= costToA ? Collapse{ costToB, uA, uB } : Collapse{ costToA, uB, uA });
+			}
+
+			std::sort(
+				aCollapses.begin(),
+				aCollapses.end(),
+				[](const Collapse& a, const Collapse& b)
+				{
+					if (a.Cost != b.Cost)
+					{
+						return a.Cost < b.Cost;
+					}
+					return a.uSource != b.uSource ? a.uSource < b.uSource : a.uTarget < b.uTarget;
+				}
+			);
+
+			std::iota(auRemap.begin(), auRemap.end(), 0u);
+			std::fill(abTouched.begin(), abTouched.end(), FALSE);
+
+			UINT uNumCollapses = 0u;
+			for (const Collapse& collapse : aCollapses)
+			{
+				if (uNumTriangles <= uTargetNumTriangles || collapse.Cost > maxCost)
+				{
+					break;
+				}
+
+				if (abTouched[collapse.uSource] || abTouched[collapse.uTarget])
+				{
+					continue;
+				}
+
+				// Triangles that would turn over reject the collapse, triangles on the edge disappear
+				const XMFLOAT3& target = getPosition(pPositions, uStride, collapse.uTarget);
+				UINT uNumRemoved = 0u;
+				BOOL bIsFlipped = FALSE;
+				for (UINT i = auAdjacencyOffsets[collapse.uSource]; i < auAdjacencyOffsets[collapse.uSource + 1u] && !bIsFlipped; ++i)
+				{
+					UINT uTriangle = auAdjacentTriangles[i];
+					UINT auCorners[3] =
+					{
+						auRemap[aOutIndices[uTriangle * 3u]],
+						auRemap[aOutIndices[uTriangle * 3u + 1u]],
+						auRemap[aOutIndices[uTriangle * 3u + 2u]],
+					};
+
+					if (auCorners[0] == auCorners[1] || auCorners[1] == auCorners[2] || auCorners[0] == auCorners[2])
+					{
+						continue;
+					}
+
+					if (auCorners[0] == collapse.uTarget || auCorners[1] == collapse.uTarget || auCorners[2] == collapse.uTarget)
+					{
+						++uNumRemoved;
+						continue;
+					}
+
+					XMFLOAT3 aBefore[3];
+					XMFLOAT3 aAfter[3];
+					for (UINT uCorner = 0u; uCorner < 3u; ++uCorner)
+					{
+						aBefore[uCorner] = getPosition(pPositions, uStride, auCorners[uCorner]);
+						aAfter[uCorner] = auCorners[uCorner] == collapse.uSource ? target : aBefore[uCorner];
+					}
+
+					XMFLOAT3 before = computeNormal(aBefore[0], aBefore[1], aBefore[2]);
+					XMFLOAT3 after = computeNormal(aAfter[0], aAfter[1], aAfter[2]);
+					bIsFlipped = before.x * after.x + before.y * after.y + before.z * after.z <= 0.0f;
+				}
+
+				if (bIsFlipped)
+				{
+					continue;
+				}
+
+				auRemap[collapse.uSource] = collapse.uTarget;
+				addQuadric(aQuadrics[collapse.uTarget], aQuadrics[collapse.uSource]);
+				abTouched[collapse.uSource] = TRUE;
+				abTouched[collapse.uTarget] = TRUE;
+
+				uNumTriangles -= std::min(uNumRemoved, uNumTriangles);
+				error = std::max(error, collapse.Cost);
+				++uNumCollapses;
+			}
+
+			if (uNumCollapses == 0u)
+			{
+				break;
+			}
+
+			// Apply the collapses and drop the triangles that became degenerate
+			size_t uNumIndicesWritten = 0u;
+			for (size_t i = 0u; i < aOutIndices.size(); i += 3u)
+			{
+				WORD u0 = static_cast<WORD>(auRemap[aOutIndices[i]]);
+				WORD u1 = static_cast<WORD>(auRemap[aOutIndices[i + 1u]]);
+				WORD u2 = static_cast<WORD>(auRemap[aOutIndices[i + 2u]]);
+				if (u0 != u1 && u1 != u2 && u0 != u2)
+				{
+					aOutIndices[uNumIndicesWritten++] = u0;
+					aOutIndices[uNumIndicesWritten++] = u1;
+					aOutIndices[uNumIndicesWritten++] = u2;
+				}
+			}
+			aOutIndices.resize(uNumIndicesWritten);
+		}
+
+		return static_cast<FLOAT>(std::sqrt(error));
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "pch.h"
+
+namespace pr
+{
+	// Quadric error edge collapse on an indexed triangle list. Vertices are only ever collapsed onto other vertices
+	// of the mesh, so the result indexes the same vertex buffer. Vertices on borders, on attribute seams (split
+	// vertices sharing a position) and on non-manifold edges stay in place so neighbouring meshes do not crack.
+	// The output only depends on the input, collapses are applied in a fully ordered sequence.
+	// Returns the largest distance a surface moved, in the units of the positions.
+	FLOAT SimplifyMesh(
+		_Out_ std::vector<WORD>& aOutIndices,
+		_In_ const XMFLOAT3* pPositions,
+		_In_ size_t uStride,
+		_In_ UINT uNumVertices,
+		_In_reads_(uNumIndices) const WORD* pIndices,
+		_In_ UINT uNumIndices,
+		_In_ UINT uTargetNumIndices,
+		_In_ FLOAT maxError
+	);
+}
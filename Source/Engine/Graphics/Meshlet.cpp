@@ -0,0 +1,247 @@
+#include "pch.h"
+
+#include "Graphics/Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pr
+{
+	namespace
+	{
+		constexpr const BYTE INVALID_LOCAL_INDEX = 0xFFu;
+		// Cones with a triangle normal this close to perpendicular to the axis or beyond are nearly hemispheres,
+		// visible from almost everywhere, so they never cull
+		constexpr const FLOAT MIN_CONE_DOT = 0.1f;
+
+		inline XMVECTOR loadPosition(_In_ const XMFLOAT3* pPositions, _In_ size_t uStride, _In_ UINT uIndex) noexcept
+		{
+			return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const BYTE*>(pPositions) + uStride * uIndex));
+		}
+
+		void computeBounds(
+			_Inout_ Meshlet& meshlet,
+			_In_reads_(meshlet.uNumVertices) const WORD* auVertices,
+			_In_reads_(meshlet.uNumTriangles * 3u) const BYTE* auTriangles,
+			_In_ const XMFLOAT3* pPositions,
+			_In_ size_t uStride
+		) noexcept
+		{
+			XMVECTOR minimum = loadPosition(pPositions, uStride, auVertices[0]);
+			XMVECTOR maximum = minimum;
+			for (UINT i = 1u; i < meshlet.uNumVertices; ++i)
+			{
+				XMVECTOR position = loadPosition(pPositions, uStride, auVertices[i]);
+				minimum = XMVectorMin(minimum, position);
+				maximum = XMVectorMax(maximum, position);
+			}
+
+			XMVECTOR center = XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f);
+			FLOAT radius = 0.0f;
+			for (UINT i = 0u; i < meshlet.uNumVertices; ++i)
+			{
+				radius = std::max(radius, XMVectorGetX(XMVector3Length(XMVectorSubtract(loadPosition(pPositions, uStride, auVertices[i]), center))));
+			}
+			XMStoreFloat3(&meshlet.Center, center);
+			meshlet.Radius = radius;
+
+			// Without a usable cone the meshlet is only culled by its sphere
+			meshlet.ConeApex = meshlet.Center;
+			meshlet.ConeAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+			meshlet.ConeCutoff = 1.0f;
+
+			XMFLOAT3 aNormals[MAX_MESHLET_TRIANGLES];
+			XMFLOAT3 aCorners[MAX_MESHLET_TRIANGLES];
+			UINT uNumNormals = 0u;
+			XMVECTOR axis = XMVectorZero();
+			for (UINT i = 0u; i < meshlet.uNumTriangles; ++i)
+			{
+				XMVECTOR p0 = loadPosition(pPositions, uStride, auVertices[auTriangles[i * 3u]]);
+				XMVECTOR p1 = loadPosition(pPositions, uStride, auVertices[auTriangles[i * 3u + 1u]]);
+				XMVECTOR p2 = loadPosition(pPositions, uStride, auVertices[auTriangles[i * 3u + 2u]]);
+
+				// Clockwise triangles are front facing, so this normal points out of the surface
+				XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+				FLOAT length = XMVectorGetX(XMVector3Length(normal));
+				if (length <= 0.0f)
+				{
+					continue;
+				}
+
+				normal = XMVectorScale(normal, 1.0f / length);
+				XMStoreFloat3(&aNormals[uNumNormals], normal);
+				XMStoreFloat3(&aCorners[uNumNormals], p0);
+				++uNumNormals;
+				axis = XMVectorAdd(axis, normal);
+			}
+
+			FLOAT axisLength = XMVectorGetX(XMVector3Length(axis));
+			if (uNumNormals == 0u || axisLength <= 0.0f)
+			{
+				return;
+			}
+			axis = XMVectorScale(axis, 1.0f / axisLength);
+
+			FLOAT minDot = 1.0f;
+			for (UINT i = 0u; i < uNumNormals; ++i)
+			{
+				minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(XMLoadFloat3(&aNormals[i]), axis)));
+			}
+			if (minDot <= MIN_CONE_DOT)
+			{
+				return;
+			}
+
+			// Move the apex back along the axis until it is behind every triangle plane, so the test holds for
+			// eyes close to the meshlet as well
+			FLOAT maxDistance = 0.0f;
+			for (UINT i = 0u; i < uNumNormals; ++i)
+			{
+				XMVECTOR normal = XMLoadFloat3(&aNormals[i]);
+				FLOAT distance = XMVectorGetX(XMVector3Dot(XMVectorSubtract(center, XMLoadFloat3(&aCorners[i])), normal)) / XMVectorGetX(XMVector3Dot(axis, normal));
+				maxDistance = std::max(maxDistance, distance);
+			}
+
+			XMStoreFloat3(&meshlet.ConeApex, XMVectorSubtract(center, XMVectorScale(axis, maxDistance)));
+			XMStoreFloat3(&meshlet.ConeAxis, axis);
+			meshlet.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+		}
+	}
+
+	void BuildMeshlets(
+		_Inout_ std::vector<Meshlet>& aOutMeshlets,
+		_Inout_ std::vector<WORD>& auOutVertices,
+		_Inout_ std::vector<BYTE>& auOutTriangles,
+		_In_reads_(uNumIndices) const WORD* pIndices,
+		_In_ UINT uNumIndices,
+		_In_ UINT uBaseIndex,
+		_In_ const XMFLOAT3* pPositions,
+		_In_ size_t uStride,
+		_In_ UINT uNumVertices
+	)
+	{
+		std::vector<BYTE> auLocalIndices(uNumVertices, INVALID_LOCAL_INDEX);
+
+		Meshlet meshlet = {};
+		auto beginMeshlet = [&](UINT uFirstIndex)
+		{
+			// The bounds are computed once the meshlet ends
+			meshlet = {};
+			meshlet.uBaseIndex = uBaseIndex + uFirstIndex;
+			meshlet.uVertexOffset = static_cast<UINT>(auOutVertices.size());
+			meshlet.uTriangleOffset = static_cast<UINT>(auOutTriangles.size());
+		};
+		auto endMeshlet = [&]()
+		{
+			computeBounds(meshlet, &auOutVertices[meshlet.uVertexOffset], &auOutTriangles[meshlet.uTriangleOffset], pPositions, uStride);
+			aOutMeshlets.push_back(meshlet);
+
+			for (UINT i = 0u; i < meshlet.uNumVertices; ++i)
+			{
+				auLocalIndices[auOutVertices[meshlet.uVertexOffset + i]] = INVALID_LOCAL_INDEX;
+			}
+		};
+
+		beginMeshlet(0u);
+		for (UINT i = 0u; i + 2u < uNumIndices; i += 3u)
+		{
+			const WORD a = pIndices[i];
+			const WORD b = pIndices[i + 1u];
+			const WORD c = pIndices[i + 2u];
+
+			UINT uNumNewVertices = auLocalIndices[a] == INVALID_LOCAL_INDEX ? 1u : 0u;
+			uNumNewVertices += auLocalIndices[b] == INVALID_LOCAL_INDEX && b != a ? 1u : 0u;
+			uNumNewVertices += auLocalIndices[c] == INVALID_LOCAL_INDEX && c != a && c != b ? 1u : 0u;
+
+			if (meshlet.uNumVertices + uNumNewVertices > MAX_MESHLET_VERTICES || meshlet.uNumTriangles == MAX_MESHLET_TRIANGLES)
+			{
+				endMeshlet();
+				beginMeshlet(i);
+			}
+
+			for (WORD uVertex : { a, b, c })
+			{
+				if (auLocalIndices[uVertex] == INVALID_LOCAL_INDEX)
+				{
+					auLocalIndices[uVertex] = static_cast<BYTE>(meshlet.uNumVertices++);
+					auOutVertices.push_back(uVertex);
+				}
+				auOutTriangles.push_back(auLocalIndices[uVertex]);
+			}
+			++meshlet.uNumTriangles;
+		}
+
+		if (meshlet.uNumTriangles > 0u)
+		{
+			endMeshlet();
+		}
+	}
+
+	UINT CullMeshlets(
+		_Out_writes_to_(uNumMeshlets, return) MeshletRange* aOutRanges,
+		_In_reads_(uNumMeshlets) const Meshlet* aMeshlets,
+		_In_ UINT uNumMeshlets,
+		_In_ const Frustum& frustum,
+		_In_ const XMFLOAT3& eyePosition,
+		_Inout_opt_ MeshletCullStats* pStats
+	) noexcept
+	{
+		XMVECTOR aPlanes[Frustum::NUM_PLANES];
+		for (UINT i = 0u; i < Frustum::NUM_PLANES; ++i)
+		{
+			aPlanes[i] = XMLoadFloat4(&frustum.aPlanes[i]);
+		}
+		const XMVECTOR eye = XMLoadFloat3(&eyePosition);
+
+		UINT uNumRanges = 0u;
+		UINT uNumFrustumCulled = 0u;
+		UINT uNumBackFacing = 0u;
+		for (UINT i = 0u; i < uNumMeshlets; ++i)
+		{
+			const Meshlet& meshlet = aMeshlets[i];
+
+			// Planes point inside, a sphere is outside once its center is more than its radius behind one plane
+			const XMVECTOR center = XMVectorSet(meshlet.Center.x, meshlet.Center.y, meshlet.Center.z, 1.0f);
+			BOOL bIsInside = TRUE;
+			for (UINT uPlane = 0u; uPlane < Frustum::NUM_PLANES && bIsInside; ++uPlane)
+			{
+				bIsInside = XMVectorGetX(XMVector4Dot(aPlanes[uPlane], center)) >= -meshlet.Radius;
+			}
+			if (!bIsInside)
+			{
+				++uNumFrustumCulled;
+				continue;
+			}
+
+			if (meshlet.ConeCutoff < 1.0f)
+			{
+				XMVECTOR direction = XMVectorSubtract(XMLoadFloat3(&meshlet.ConeApex), eye);
+				if (XMVectorGetX(XMVector3Dot(direction, XMLoadFloat3(&meshlet.ConeAxis))) >= meshlet.ConeCutoff * XMVectorGetX(XMVector3Length(direction)))
+				{
+					++uNumBackFacing;
+					continue;
+				}
+			}
+
+			const UINT uNumIndices = meshlet.uNumTriangles * 3u;
+			if (uNumRanges > 0u && aOutRanges[uNumRanges - 1u].uBaseIndex + aOutRanges[uNumRanges - 1u].uNumIndices == meshlet.uBaseIndex)
+			{
+				aOutRanges[uNumRanges - 1u].uNumIndices += uNumIndices;
+			}
+			else
+			{
+				aOutRanges[uNumRanges++] = MeshletRange{ .uBaseIndex = meshlet.uBaseIndex, .uNumIndices = uNumIndices };
+			}
+		}
+
+		if (pStats)
+		{
+			pStats->uNumMeshlets += uNumMeshlets;
+			pStats->uNumFrustumCulled += uNumFrustumCulled;
+			pStats->uNumBackFacing += uNumBackFacing;
+			pStats->uNumRanges += uNumRanges;
+		}
+
+		return uNumRanges;
+	}
+}
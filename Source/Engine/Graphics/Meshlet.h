@@ -0,0 +1,75 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/Bounds.h"
+
+namespace pr
+{
+	// Limits of the common mesh shader configuration, 124 triangles keep the primitive indices of a meshlet in
+	// 372 bytes of output
+	constexpr const UINT MAX_MESHLET_VERTICES = 64u;
+	constexpr const UINT MAX_MESHLET_TRIANGLES = 124u;
+
+	// Consecutive triangles [uBaseIndex, uBaseIndex + 3 * uNumTriangles) of the index buffer of a mesh, so visible
+	// meshlets can be drawn as index ranges. For mesh shaders the same triangles are also kept as uNumVertices
+	// indices of the mesh vertices from uVertexOffset and 3 * uNumTriangles local indices from uTriangleOffset.
+	// Bounds are in object space. The meshlet is back facing from every point p where
+	// dot(normalize(ConeApex - p), ConeAxis) >= ConeCutoff, a cutoff of 1 never culls.
+	struct Meshlet
+	{
+		XMFLOAT3 Center;
+		FLOAT Radius;
+		XMFLOAT3 ConeApex;
+		FLOAT ConeCutoff;
+		XMFLOAT3 ConeAxis;
+		UINT uBaseIndex;
+		UINT uVertexOffset;
+		UINT uTriangleOffset;
+		UINT uNumVertices;
+		UINT uNumTriangles;
+	};
+	static_assert(sizeof(Meshlet) == 64);
+
+	// Index range of one or more adjacent visible meshlets
+	struct MeshletRange
+	{
+		UINT uBaseIndex;
+		UINT uNumIndices;
+	};
+
+	struct MeshletCullStats
+	{
+		UINT uNumMeshlets;
+		UINT uNumFrustumCulled;
+		UINT uNumBackFacing;
+		UINT uNumRanges;
+	};
+
+	// Splits the triangle list into meshlets in its order, a meshlet ends once the next triangle would exceed
+	// either limit. Run it on vertex cache optimized indices, whose locality keeps the meshlets compact.
+	// uBaseIndex is the offset of pIndices in the index buffer, the indices are relative to the mesh vertices.
+	// Meshlets, vertex and triangle indices are appended to the outputs.
+	void BuildMeshlets(
+		_Inout_ std::vector<Meshlet>& aOutMeshlets,
+		_Inout_ std::vector<WORD>& auOutVertices,
+		_Inout_ std::vector<BYTE>& auOutTriangles,
+		_In_reads_(uNumIndices) const WORD* pIndices,
+		_In_ UINT uNumIndices,
+		_In_ UINT uBaseIndex,
+		_In_ const XMFLOAT3* pPositions,
+		_In_ size_t uStride,
+		_In_ UINT uNumVertices
+	);
+
+	// Frustum and eye are in the object space of the meshlets. Writes the index ranges of the meshlets that are
+	// inside the frustum and not back facing from the eye, merging adjacent ones, and returns their number.
+	UINT CullMeshlets(
+		_Out_writes_to_(uNumMeshlets, return) MeshletRange* aOutRanges,
+		_In_reads_(uNumMeshlets) const Meshlet* aMeshlets,
+		_In_ UINT uNumMeshlets,
+		_In_ const Frustum& frustum,
+		_In_ const XMFLOAT3& eyePosition,
+		_Inout_opt_ MeshletCullStats* pStats
+	) noexcept;
+}
@@ -2,6 +2,18 @@
 
 #include "Graphics/Model.h"
 
+#include <algorithm>
+#include <fstream>
+
+#include "Graphics/Meshlet.h"
+#include "Graphics/MeshOptimizer.h"
+#include "Graphics/MeshSimplifier.h"
+#include "Graphics/VertexQuantization.h"
+#include "Utility/Hash.h"
+#include "Utility/JobSystem.h"
+#include "Utility/Profiler.h"
+#include "Utility/Utility.h"
+
 #include "assimp/Importer.hpp"	// C++ importer interface
 #include "assimp/scene.h"		// output data structure
 #include "assimp/postprocess.h"	// post processing flags
@@ -9,6 +21,40 @@
 
 namespace pr
 {
+    namespace
+    {
+        // Part of the cache key, a cache is only used for loads with the same flags
+        constexpr const UINT IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_ConvertToLeftHanded | aiProcess_CalcTangentSpace;
+
+        std::string getTexturePath(_In_ const aiMaterial* pMaterial, _In_ aiTextureType textureType)
+        {
+            aiString aiPath;
+            if (pMaterial->GetTextureCount(textureType) == 0u
+                || pMaterial->GetTexture(textureType, 0u, &aiPath, nullptr, nullptr, nullptr, nullptr, nullptr) != AI_SUCCESS)
+            {
+                return std::string();
+            }
+
+            std::string szPath(aiPath.data);
+
+            if (szPath.substr(0ull, 2ull) == ".\\")
+            {
+                szPath = szPath.substr(2ull, szPath.size() - 2ull);
+            }
+
+            return szPath;
+        }
+
+        // Importers are not thread safe, and constructing one registers every loader and post processing step,
+        // so each thread keeps its own for all the models it imports. The scene is orphaned after every read, so
+        // nothing of one import survives into the next.
+        Assimp::Importer& getImporter()
+        {
+            thread_local Assimp::Importer tl_importer;
+            return tl_importer;
+        }
+    }
+
     XMMATRIX ConvertMatrix(_In_ const aiMatrix4x4& matrix)
     {
         return XMMATRIX(
@@ -36,13 +82,21 @@ namespace pr
         return XMFLOAT3(vector.x, vector.y, vector.z);
     }
 
-    std::unique_ptr<Assimp::Importer> Model::sm_pImporter = std::make_unique<Assimp::Importer>();
+    std::unordered_map<std::wstring, Model*> Model::sm_GeometrySources;
+    std::mutex Model::sm_GeometrySourcesMutex;
 
     Model::Model(_In_ const std::filesystem::path& filePath)
-        : Renderable(eVertexType::POS_NORM_TEXCOORD)
+        : Renderable(eVertexType::POS_NORM_TEXCOORD_PACKED)
         , m_filePath(filePath)
         , m_aVertices()
+        , m_aPackedVertices()
         , m_aIndices()
+        , m_aMeshlets()
+        , m_auMeshletVertices()
+        , m_auMeshletTriangles()
+        , m_CacheFile()
+        , m_Cache()
+        , m_pGeometrySource(nullptr)
         , m_pScene(nullptr)
         //, m_padding{ '\0' }
     {
@@ -50,28 +104,68 @@ namespace pr
 
     Model::~Model() noexcept
     {
+        {
+            std::lock_guard<std::mutex> lock(sm_GeometrySourcesMutex);
+            auto iter = sm_GeometrySources.find(m_filePath.wstring());
+            if (iter != sm_GeometrySources.end() && iter->second == this)
+            {
+                sm_GeometrySources.erase(iter);
+            }
+        }
+
         if (m_pScene)
         {
             delete m_pScene;
         }
     }
 
-    HRESULT Model::Initialize(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList)
+    HRESULT Model::Load()
     {
+        PR_PROFILE_FUNCTION();
+
         HRESULT hr = S_OK;
 
-        // Create the buffers for the vertices attributes
+        if (m_pGeometrySource)
+        {
+            return hr;
+        }
+
+        // The first model to load a file imports it, the others share its geometry once it is initialized
+        {
+            std::lock_guard<std::mutex> lock(sm_GeometrySourcesMutex);
+            m_pGeometrySource = sm_GeometrySources.try_emplace(m_filePath.wstring(), this).first->second;
+        }
+
+        if (m_pGeometrySource != this)
+        {
+            return hr;
+        }
+
+        // Warm loads map the cache written by the first import of the same file and skip the importer
+        ModelCacheFile::Key key = {};
+        HRESULT hrKey = computeCacheKey(key);
+        if (SUCCEEDED(hrKey) && SUCCEEDED(loadCache(key)))
+        {
+            return hr;
+        }
+
+        Assimp::Importer& importer = getImporter();
         std::string filePath = m_filePath.string();
 
-        m_pScene = sm_pImporter->ReadFile(
-            filePath.c_str(),
-            (aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_ConvertToLeftHanded | aiProcess_CalcTangentSpace)
-        );
-        m_pScene = sm_pImporter->GetOrphanedScene();
+        {
+            PR_PROFILE_SCOPE("Assimp::Importer::ReadFile");
+            importer.ReadFile(filePath.c_str(), IMPORT_FLAGS);
+            m_pScene = importer.GetOrphanedScene();
+        }
 
         if (m_pScene)
         {
-            hr = initFromScene(pDevice, pCommandList, m_pScene, m_filePath);
+            hr = initFromScene(m_pScene, m_filePath);
+            if (SUCCEEDED(hr) && SUCCEEDED(hrKey))
+            {
+                // A cache that cannot be written only costs the next launch another import
+                saveCache(key);
+            }
         }
         else
         {
@@ -79,10 +173,68 @@ namespace pr
             OutputDebugString(L"Error parsing ");
             OutputDebugString(m_filePath.c_str());
             OutputDebugString(L": ");
-            OutputDebugStringA(sm_pImporter->GetErrorString());
+            OutputDebugStringA(importer.GetErrorString());
             OutputDebugString(L"\n");
         }
 
+        if (FAILED(hr))
+        {
+            // Give up the file, so the next model to load it tries again and reports the error itself
+            std::lock_guard<std::mutex> lock(sm_GeometrySourcesMutex);
+            sm_GeometrySources.erase(m_filePath.wstring());
+            m_pGeometrySource = nullptr;
+        }
+
+        return hr;
+    }
+
+    HRESULT Model::Initialize(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList)
+    {
+        PR_PROFILE_FUNCTION();
+
+        HRESULT hr = S_OK;
+
+        // Already initialized as the geometry source of another model
+        if (m_pGeometryAllocation)
+        {
+            return hr;
+        }
+
+        // Nothing to do when the scene already loaded the model on a worker thread
+        hr = Load();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        if (m_pGeometrySource != this)
+        {
+            // The source may come later in the scene, in which case it is initialized here first
+            hr = m_pGeometrySource->Initialize(pDevice, pCommandList);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            shareGeometry(*m_pGeometrySource);
+            return hr;
+        }
+
+        hr = initialize(pDevice, pCommandList);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        for (const std::shared_ptr<Material>& material : m_aMaterials)
+        {
+            hr = material->Initialize(pDevice, pCommandList);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
         return hr;
     }
 
@@ -93,79 +245,327 @@ namespace pr
 
     UINT Model::GetNumVertices() const
     {
-        return static_cast<UINT>(m_aVertices.size());
+        if (m_CacheFile.GetData())
+        {
+            return m_Cache.uNumVertices;
+        }
+
+        return static_cast<UINT>(m_aPackedVertices.size());
     }
 
     UINT Model::GetNumIndices() const
     {
+        if (m_CacheFile.GetData())
+        {
+            return m_Cache.uNumIndices;
+        }
+
         return static_cast<UINT>(m_aIndices.size());
     }
 
-    void Model::countVerticesAndIndices(_Inout_ UINT& uOutNumVertices, _Inout_ UINT& uOutNumIndices, _In_ const aiScene* pScene)
+    HRESULT Model::computeCacheKey(_Out_ ModelCacheFile::Key& outKey) const
+    {
+        PR_PROFILE_FUNCTION();
+
+        outKey = {};
+
+        // Only the model file itself is hashed, files it refers to such as material libraries are not
+        MappedFile source;
+        HRESULT hr = source.Initialize(m_filePath, TRUE);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        outKey =
+        {
+            .uSourceHash = HashBytes(source.GetData(), source.GetSize()),
+            .uSourceSize = source.GetSize(),
+            .uImportFlags = IMPORT_FLAGS,
+            .uReserved = 0u,
+        };
+
+        return hr;
+    }
+
+    void Model::countVerticesAndIndices(
+        _Inout_ UINT& uOutNumVertices,
+        _Inout_ UINT& uOutNumIndices,
+        _In_ const std::vector<MeshChunk>& aChunks,
+        _In_ const aiScene* pScene
+    )
     {
         for (UINT i = 0u; i < m_aMeshes.size(); ++i)
         {
-            m_aMeshes[i].uMaterialIndex = pScene->mMeshes[i]->mMaterialIndex;
-            m_aMeshes[i].uNumIndices = pScene->mMeshes[i]->mNumFaces * 3u;
+            m_aMeshes[i].uMaterialIndex = pScene->mMeshes[aChunks[i].uMesh]->mMaterialIndex;
+            m_aMeshes[i].uNumIndices = aChunks[i].uNumFaces * 3u;
             m_aMeshes[i].uBaseVertex = uOutNumVertices;
             m_aMeshes[i].uBaseIndex = uOutNumIndices;
 
-            uOutNumVertices += pScene->mMeshes[i]->mNumVertices;
+            uOutNumVertices += aChunks[i].uNumVertices;
             uOutNumIndices += m_aMeshes[i].uNumIndices;
         }
     }
 
     const void* Model::getVertices() const
     {
-        return m_aVertices.data();
+        if (m_CacheFile.GetData())
+        {
+            return m_Cache.aVertices;
+        }
+
+        return m_aPackedVertices.data();
     }
 
     const WORD* Model::getIndices() const
     {
+        if (m_CacheFile.GetData())
+        {
+            return m_Cache.auIndices;
+        }
+
         return m_aIndices.data();
     }
 
-    void Model::initAllMeshes(_In_ const aiScene* pScene)
+    const Meshlet* Model::getMeshlets() const
+    {
+        // Models sharing the geometry of another one cull with its meshlets
+        if (m_pGeometrySource && m_pGeometrySource != this)
+        {
+            return m_pGeometrySource->getMeshlets();
+        }
+
+        if (m_CacheFile.GetData())
+        {
+            return m_Cache.aMeshlets;
+        }
+
+        return m_aMeshlets.data();
+    }
+
+    void Model::buildMeshlets()
     {
+        PR_PROFILE_FUNCTION();
+
+        // Split LOD 0 of every mesh on its own job, the meshlets are appended in mesh order afterwards
+        const UINT uNumMeshes = static_cast<UINT>(m_aMeshes.size());
+        std::vector<std::vector<Meshlet>> aaMeshlets(uNumMeshes);
+        std::vector<std::vector<WORD>> aauVertices(uNumMeshes);
+        std::vector<std::vector<BYTE>> aauTriangles(uNumMeshes);
+        JobSystem::GetInstance().ParallelFor(
+            uNumMeshes,
+            1u,
+            [this, &aaMeshlets, &aauVertices, &aauTriangles](UINT uBegin, UINT uEnd)
+            {
+                for (UINT i = uBegin; i < uEnd; ++i)
+                {
+                    const BasicMeshEntry& mesh = m_aMeshes[i];
+                    const UINT uNumVertices = i + 1u < m_aMeshes.size() ? m_aMeshes[i + 1u].uBaseVertex - mesh.uBaseVertex : static_cast<UINT>(m_aVertices.size()) - mesh.uBaseVertex;
+                    if (uNumVertices == 0u)
+                    {
+                        continue;
+                    }
+
+                    BuildMeshlets(
+                        aaMeshlets[i],
+                        aauVertices[i],
+                        aauTriangles[i],
+                        m_aIndices.data() + mesh.uBaseIndex,
+                        mesh.uNumIndices,
+                        mesh.uBaseIndex,
+                        &m_aVertices[mesh.uBaseVertex].Position,
+                        sizeof(VertexPNT),
+                        uNumVertices
+                    );
+                }
+            }
+        );
+
+        m_aMeshlets.clear();
+        m_auMeshletVertices.clear();
+        m_auMeshletTriangles.clear();
+
+        UINT uNumTriangles = 0u;
+        UINT uNumConeMeshlets = 0u;
+        for (UINT i = 0u; i < uNumMeshes; ++i)
+        {
+            m_aMeshes[i].uFirstMeshlet = static_cast<UINT>(m_aMeshlets.size());
+            m_aMeshes[i].uNumMeshlets = static_cast<UINT>(aaMeshlets[i].size());
+
+            for (Meshlet meshlet : aaMeshlets[i])
+            {
+                meshlet.uVertexOffset += static_cast<UINT>(m_auMeshletVertices.size());
+                meshlet.uTriangleOffset += static_cast<UINT>(m_auMeshletTriangles.size());
+                m_aMeshlets.push_back(meshlet);
+
+                uNumTriangles += meshlet.uNumTriangles;
+                uNumConeMeshlets += meshlet.ConeCutoff < 1.0f ? 1u : 0u;
+            }
+            m_auMeshletVertices.insert(m_auMeshletVertices.end(), aauVertices[i].begin(), aauVertices[i].end());
+            m_auMeshletTriangles.insert(m_auMeshletTriangles.end(), aauTriangles[i].begin(), aauTriangles[i].end());
+        }
+
+        const FLOAT numMeshlets = static_cast<FLOAT>(std::max<size_t>(m_aMeshlets.size(), 1u));
         CHAR szDebugMessage[256];
-        sprintf_s(szDebugMessage, "Parsing %u meshes\n\n", pScene->mNumMeshes);
+        sprintf_s(
+            szDebugMessage,
+            "Built %u meshlets for %u meshes: %.1f vertices and %.1f triangles per meshlet, %u with normal cones\n\n",
+            static_cast<UINT>(m_aMeshlets.size()),
+            uNumMeshes,
+            static_cast<FLOAT>(m_auMeshletVertices.size()) / numMeshlets,
+            static_cast<FLOAT>(uNumTriangles) / numMeshlets,
+            uNumConeMeshlets
+        );
         OutputDebugStringA(szDebugMessage);
-        for (UINT i = 0u; i < m_aMeshes.size(); ++i)
+    }
+
+    void Model::generateLods()
+    {
+        PR_PROFILE_FUNCTION();
+
+        // Each LOD is simplified from the previous one, every mesh on its own job
+        const UINT uNumMeshes = static_cast<UINT>(m_aMeshes.size());
+        std::vector<std::vector<WORD>> aaLodIndices(static_cast<size_t>(uNumMeshes) * (MAX_LODS - 1u));
+        JobSystem::GetInstance().ParallelFor(
+            uNumMeshes,
+            1u,
+            [this, &aaLodIndices](UINT uBegin, UINT uEnd)
+            {
+                for (UINT i = uBegin; i < uEnd; ++i)
+                {
+                    BasicMeshEntry& mesh = m_aMeshes[i];
+                    const UINT uNumVertices = i + 1u < m_aMeshes.size() ? m_aMeshes[i + 1u].uBaseVertex - mesh.uBaseVertex : static_cast<UINT>(m_aVertices.size()) - mesh.uBaseVertex;
+                    const FLOAT maxError = MAX_LOD_ERROR * mesh.Bounds.Radius;
+                    if (uNumVertices == 0u)
+                    {
+                        continue;
+                    }
+
+                    const WORD* pIndices = m_aIndices.data() + mesh.uBaseIndex;
+                    UINT uNumIndices = mesh.uNumIndices;
+                    FLOAT error = 0.0f;
+                    for (UINT uLod = 1u; uLod < MAX_LODS; ++uLod)
+                    {
+                        std::vector<WORD>& aIndices = aaLodIndices[static_cast<size_t>(i) * (MAX_LODS - 1u) + uLod - 1u];
+                        UINT uTargetNumIndices = static_cast<UINT>(static_cast<FLOAT>(uNumIndices / 3u) * LOD_REDUCTION) * 3u;
+
+                        // Errors of consecutive LODs add up, the sum bounds the distance to the full mesh
+                        error += SimplifyMesh(aIndices, &m_aVertices[mesh.uBaseVertex].Position, sizeof(VertexPNT), uNumVertices, pIndices, uNumIndices, uTargetNumIndices, std::max(maxError - error, 0.0f));
+                        if (aIndices.empty() || static_cast<FLOAT>(aIndices.size()) > static_cast<FLOAT>(uNumIndices) * MIN_LOD_REDUCTION)
+                        {
+                            aIndices.clear();
+                            break;
+                        }
+
+                        OptimizeVertexCache(aIndices.data(), static_cast<UINT>(aIndices.size()), uNumVertices, nullptr);
+
+                        mesh.aLods[uLod - 1u].uNumIndices = static_cast<UINT>(aIndices.size());
+                        mesh.aLods[uLod - 1u].Error = error;
+                        mesh.uNumLods = uLod + 1u;
+
+                        pIndices = aIndices.data();
+                        uNumIndices = static_cast<UINT>(aIndices.size());
+                    }
+                }
+            }
+        );
+
+        // Append the LODs after all full meshes in mesh order, so the index buffer does not depend on the schedule
+        UINT uNumFullIndices = static_cast<UINT>(m_aIndices.size());
+        for (UINT i = 0u; i < uNumMeshes; ++i)
         {
-            const aiMesh* pMesh = pScene->mMeshes[i];
-            initSingleMesh(i, pMesh);
+            for (UINT uLod = 1u; uLod < m_aMeshes[i].uNumLods; ++uLod)
+            {
+                const std::vector<WORD>& aIndices = aaLodIndices[static_cast<size_t>(i) * (MAX_LODS - 1u) + uLod - 1u];
+                m_aMeshes[i].aLods[uLod - 1u].uBaseIndex = static_cast<UINT>(m_aIndices.size());
+                m_aIndices.insert(m_aIndices.end(), aIndices.begin(), aIndices.end());
+            }
         }
+
+        CHAR szDebugMessage[256];
+        sprintf_s(
+            szDebugMessage,
+            "Generated LODs for %u meshes: %u indices, %u more for LODs\n\n",
+            uNumMeshes,
+            uNumFullIndices,
+            static_cast<UINT>(m_aIndices.size()) - uNumFullIndices
+        );
+        OutputDebugStringA(szDebugMessage);
+    }
+
+    std::filesystem::path Model::getCachePath() const
+    {
+        std::filesystem::path cachePath = m_filePath;
+        cachePath += L".cache";
+
+        return cachePath;
+    }
+
+    void Model::initAllMeshes(_In_ const aiScene* pScene, _In_ const std::vector<MeshChunk>& aChunks)
+    {
+        PR_PROFILE_FUNCTION();
+
+        CHAR szDebugMessage[256];
+        sprintf_s(szDebugMessage, "Parsing %u meshes\n\n", pScene->mNumMeshes);
+        OutputDebugStringA(szDebugMessage);
+
+        // Every mesh writes its own range of the vertices and indices
+        JobSystem::GetInstance().ParallelFor(
+            static_cast<UINT>(m_aMeshes.size()),
+            1u,
+            [this, pScene, &aChunks](UINT uBegin, UINT uEnd)
+            {
+                for (UINT i = uBegin; i < uEnd; ++i)
+                {
+                    initSingleMesh(i, pScene->mMeshes[aChunks[i].uMesh], aChunks[i]);
+                }
+            }
+        );
     }
 
     HRESULT Model::initFromScene(
-        _In_ ID3D12Device2* pDevice,
-        _In_ ID3D12GraphicsCommandList2* pCommandList,
         _In_ const aiScene* pScene,
         _In_ const std::filesystem::path& filePath
     )
     {
         HRESULT hr = S_OK;
 
-        m_aMeshes.resize(pScene->mNumMeshes);
+        std::vector<MeshChunk> aChunks;
+        splitMeshes(aChunks, pScene);
+        initNodes(aChunks, pScene);
+
+        m_aMeshes.resize(aChunks.size());
 
         //m_aMaterials.resize(pScene->mNumMaterials);
 
         UINT uNumVertices = 0u;
         UINT uNumIndices = 0u;
 
-        countVerticesAndIndices(uNumVertices, uNumIndices, pScene);
+        countVerticesAndIndices(uNumVertices, uNumIndices, aChunks, pScene);
 
         reserveSpace(uNumVertices, uNumIndices);
 
-        initAllMeshes(pScene);
+        initAllMeshes(pScene, aChunks);
 
-        hr = initMaterials(pDevice, pCommandList, pScene, filePath);
-        if (FAILED(hr))
+        generateLods();
+
+        // Meshlet bounds need the full precision positions, so they are built before packing
+        buildMeshlets();
+
+        packVertices();
+
+        std::vector<TexturePaths> aTexturePaths(pScene->mNumMaterials);
+        for (UINT i = 0u; i < pScene->mNumMaterials; ++i)
         {
-            return hr;
+            aTexturePaths[i] =
+            {
+                .szDiffuse = getTexturePath(pScene->mMaterials[i], aiTextureType_DIFFUSE),
+                .szSpecularExponent = getTexturePath(pScene->mMaterials[i], aiTextureType_SHININESS),
+                .szNormal = getTexturePath(pScene->mMaterials[i], aiTextureType_HEIGHT),
+            };
         }
 
-        hr = initialize(pDevice, pCommandList);
+        hr = initMaterials(aTexturePaths, filePath);
         if (FAILED(hr))
         {
             return hr;
@@ -175,9 +575,7 @@ namespace pr
     }
 
     HRESULT Model::initMaterials(
-        _In_ ID3D12Device2* pDevice,
-        _In_ ID3D12GraphicsCommandList2* pCommandList,
-        _In_ const aiScene* pScene,
+        _In_ const std::vector<TexturePaths>& aTexturePaths,
         _In_ const std::filesystem::path& filePath
     )
     {
@@ -186,11 +584,11 @@ namespace pr
         // Extract the directory part from the file name
         std::filesystem::path parentDirectory = filePath.parent_path();
 
+        PR_PROFILE_FUNCTION();
+
         // Initialize the materials
-        for (UINT i = 0u; i < pScene->mNumMaterials; ++i)
+        for (UINT i = 0u; i < aTexturePaths.size(); ++i)
         {
-            const aiMaterial* pMaterial = pScene->mMaterials[i];
-
             //std::string pszName = pMaterial->GetName().data;
             //std::wstring pwszName(pszName.length(), L' ');
             //std::copy(pszName.begin(), pszName.end(), pwszName.begin());
@@ -200,197 +598,334 @@ namespace pr
             std::copy(szName.begin(), szName.end(), pwszName.begin());
 
             m_aMaterials.push_back(std::make_shared<Material>(pwszName));
+        }
+
+        // Decode the textures of every material on its own job, a texture that fails to load is left out
+        JobSystem::GetInstance().ParallelFor(
+            static_cast<UINT>(aTexturePaths.size()),
+            1u,
+            [this, &aTexturePaths, &parentDirectory](UINT uBegin, UINT uEnd)
+            {
+                for (UINT i = uBegin; i < uEnd; ++i)
+                {
+                    loadTextures(parentDirectory, aTexturePaths[i], i);
+                }
+            }
+        );
 
-            loadTextures(pDevice, pCommandList, parentDirectory, pMaterial, i);
+        for (const std::shared_ptr<Material>& material : m_aMaterials)
+        {
+            if (material->pNormal)
+            {
+                m_bHasNormalMap = TRUE;
+            }
         }
 
         return hr;
     }
 
-    void Model::initSingleMesh(_In_ UINT uMeshIndex, _In_ const aiMesh* pMesh)
+    void Model::initNodes(_Inout_ std::vector<MeshChunk>& aChunks, _In_ const aiScene* pScene)
     {
-        CHAR szDebugMessage[256];
-        sprintf_s(
-            szDebugMessage,
-            "\tMesh %u '%s': vertices %u indices %u bones %u\n",
-            uMeshIndex,
-            pMesh->mName.C_Str(),
-            pMesh->mNumVertices,
-            pMesh->mNumFaces * 3,
-            pMesh->mNumBones
-        );
-        OutputDebugStringA(szDebugMessage);
+        PR_PROFILE_FUNCTION();
 
-        const aiVector3D zero3d(0.0f, 0.0f, 0.0f);
+        // Chunks of each file mesh are consecutive, splitMeshes emits them in mesh order
+        std::vector<UINT> auFirstChunks(pScene->mNumMeshes + 1u, static_cast<UINT>(aChunks.size()));
+        for (UINT i = static_cast<UINT>(aChunks.size()); i > 0u; --i)
+        {
+            auFirstChunks[aChunks[i - 1u].uMesh] = i - 1u;
+        }
+        for (UINT i = pScene->mNumMeshes; i > 0u; --i)
+        {
+            auFirstChunks[i - 1u] = std::min(auFirstChunks[i - 1u], auFirstChunks[i]);
+        }
 
-        // Populate the vertex attribute vectors
-        for (UINT i = 0u; i < pMesh->mNumVertices; ++i)
+        // Every node referencing a mesh gets its own copy of the mesh chunks, baked with the world matrix of the node
+        std::vector<MeshChunk> aInstances;
+        std::vector<UINT> auNumReferences(pScene->mNumMeshes, 0u);
+        std::vector<std::pair<const aiNode*, XMFLOAT4X4>> stack;
+        if (pScene->mRootNode)
+        {
+            XMFLOAT4X4 identity;
+            XMStoreFloat4x4(&identity, XMMatrixIdentity());
+            stack.emplace_back(pScene->mRootNode, identity);
+        }
+        while (!stack.empty())
         {
-            const aiVector3D& position = pMesh->mVertices[i];
-            const aiVector3D& normal = pMesh->mNormals[i];
-            const aiVector3D& texCoord = pMesh->HasTextureCoords(0u) ? pMesh->mTextureCoords[0][i] : zero3d;
+            auto [pNode, parentWorld] = stack.back();
+            stack.pop_back();
 
-            m_aVertices.push_back(
-                VertexPNT
+            XMFLOAT4X4 world;
+            XMStoreFloat4x4(&world, ConvertMatrix(pNode->mTransformation) * XMLoadFloat4x4(&parentWorld));
+
+            for (UINT i = 0u; i < pNode->mNumMeshes; ++i)
+            {
+                const UINT uMesh = pNode->mMeshes[i];
+                for (UINT j = auFirstChunks[uMesh]; j < auFirstChunks[uMesh + 1u]; ++j)
                 {
-                    .Position = XMFLOAT3(position.x, position.y, position.z),
-                    .Normal = XMFLOAT3(normal.x, normal.y, normal.z),
-                    .TexCoord = XMFLOAT2(texCoord.x, texCoord.y),
+                    aInstances.push_back(aChunks[j]);
+                    aInstances.back().World = world;
                 }
-            );
+                ++auNumReferences[uMesh];
+            }
+
+            for (UINT i = pNode->mNumChildren; i > 0u; --i)
+            {
+                stack.emplace_back(pNode->mChildren[i - 1u], world);
+            }
         }
 
-        // Populate the index buffer
-        for (UINT i = 0u; i < pMesh->mNumFaces; ++i)
+        // Meshes no node references are not part of the scene, they are kept untransformed
+        for (UINT i = 0u; i < pScene->mNumMeshes; ++i)
         {
-            const aiFace& face = pMesh->mFaces[i];
-            assert(face.mNumIndices == 3u);
+            if (auNumReferences[i] == 0u)
+            {
+                for (UINT j = auFirstChunks[i]; j < auFirstChunks[i + 1u]; ++j)
+                {
+                    aInstances.push_back(aChunks[j]);
+                    XMStoreFloat4x4(&aInstances.back().World, XMMatrixIdentity());
+                }
+            }
 
-            m_aIndices.push_back(static_cast<WORD>(face.mIndices[0]));
-            m_aIndices.push_back(static_cast<WORD>(face.mIndices[1]));
-            m_aIndices.push_back(static_cast<WORD>(face.mIndices[2]));
+            if (auNumReferences[i] != 1u)
+            {
+                CHAR szDebugMessage[256];
+                sprintf_s(
+                    szDebugMessage,
+                    "Mesh %u '%s' is referenced by %u nodes, imported as %u meshes\n",
+                    i,
+                    pScene->mMeshes[i]->mName.C_Str(),
+                    auNumReferences[i],
+                    std::max(auNumReferences[i], 1u)
+                );
+                OutputDebugStringA(szDebugMessage);
+            }
         }
+
+        aChunks = std::move(aInstances);
     }
 
-    HRESULT Model::loadDiffuseTexture(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList, _In_ const std::filesystem::path& parentDirectory, _In_ const aiMaterial* pMaterial, _In_ UINT uIndex)
+    void Model::initSingleMesh(_In_ UINT uMeshIndex, _In_ const aiMesh* pMesh, _In_ const MeshChunk& chunk)
     {
-        HRESULT hr = S_OK;
+        CHAR szDebugMessage[256];
+        sprintf_s(
+            szDebugMessage,
+            "\tMesh %u '%s': vertices %u indices %u bones %u\n",
+            uMeshIndex,
+            pMesh->mName.C_Str(),
+            chunk.uNumVertices,
+            chunk.uNumFaces * 3u,
+            pMesh->mNumBones
+        );
+        OutputDebugStringA(szDebugMessage);
 
-        m_aMaterials[uIndex]->pDiffuse = nullptr;
+        const aiVector3D zero3d(0.0f, 0.0f, 0.0f);
+        const UINT uBaseVertex = m_aMeshes[uMeshIndex].uBaseVertex;
+        const UINT uBaseIndex = m_aMeshes[uMeshIndex].uBaseIndex;
+
+        // A renderable draws all of its meshes with one world matrix, so the node transforms are baked in
+        XMMATRIX nodeWorld = XMLoadFloat4x4(&chunk.World);
+        XMMATRIX nodeNormal = XMMatrixTranspose(XMMatrixInverse(nullptr, nodeWorld));
 
-        if (pMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0)
+        auto convertVertex = [pMesh, &zero3d, &nodeWorld, &nodeNormal](UINT uVertex)
         {
-            aiString aiPath;
+            const aiVector3D& position = pMesh->mVertices[uVertex];
+            const aiVector3D& normal = pMesh->mNormals[uVertex];
+            const aiVector3D& texCoord = pMesh->HasTextureCoords(0u) ? pMesh->mTextureCoords[0][uVertex] : zero3d;
 
-            if (pMaterial->GetTexture(aiTextureType_DIFFUSE, 0u, &aiPath, nullptr, nullptr, nullptr, nullptr, nullptr) == AI_SUCCESS)
+            VertexPNT vertex =
             {
-                std::string szPath(aiPath.data);
+                .Position = XMFLOAT3(position.x, position.y, position.z),
+                .Normal = XMFLOAT3(normal.x, normal.y, normal.z),
+                .TexCoord = XMFLOAT2(texCoord.x, texCoord.y),
+            };
+            XMStoreFloat3(&vertex.Position, XMVector3TransformCoord(XMLoadFloat3(&vertex.Position), nodeWorld));
+            XMStoreFloat3(&vertex.Normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.Normal), nodeNormal)));
 
-                if (szPath.substr(0ull, 2ull) == ".\\")
-                {
-                    szPath = szPath.substr(2ull, szPath.size() - 2ull);
-                }
+            return vertex;
+        };
 
-                std::filesystem::path fullPath = parentDirectory / szPath;
+        if (pMesh->mNumVertices <= MAX_MESH_VERTICES)
+        {
+            // Populate the vertex attribute vectors
+            for (UINT i = 0u; i < pMesh->mNumVertices; ++i)
+            {
+                m_aVertices[uBaseVertex + i] = convertVertex(i);
+            }
 
-                m_aMaterials[uIndex]->pDiffuse = std::make_shared<Texture>(fullPath);
+            // Populate the index buffer
+            for (UINT i = 0u; i < pMesh->mNumFaces; ++i)
+            {
+                const aiFace& face = pMesh->mFaces[i];
+                assert(face.mNumIndices == 3u);
 
-                hr = m_aMaterials[uIndex]->pDiffuse->Initialize(pDevice, pCommandList);
-                if (FAILED(hr))
-                {
-                    OutputDebugString(L"Error loading diffuse texture \"");
-                    OutputDebugString(fullPath.c_str());
-                    OutputDebugString(L"\"\n");
+                m_aIndices[uBaseIndex + i * 3u] = static_cast<WORD>(face.mIndices[0]);
+                m_aIndices[uBaseIndex + i * 3u + 1u] = static_cast<WORD>(face.mIndices[1]);
+                m_aIndices[uBaseIndex + i * 3u + 2u] = static_cast<WORD>(face.mIndices[2]);
+            }
+        }
+        else
+        {
+            // A chunk of a split mesh takes its vertices in the order its faces first use them
+            std::vector<UINT> auLocalIndices(pMesh->mNumVertices, UINT_MAX);
+            UINT uNumVertices = 0u;
+            for (UINT i = 0u; i < chunk.uNumFaces; ++i)
+            {
+                const aiFace& face = pMesh->mFaces[chunk.uFirstFace + i];
+                assert(face.mNumIndices == 3u);
 
-                    return hr;
+                for (UINT j = 0u; j < 3u; ++j)
+                {
+                    UINT& uLocalIndex = auLocalIndices[face.mIndices[j]];
+                    if (uLocalIndex == UINT_MAX)
+                    {
+                        uLocalIndex = uNumVertices++;
+                        m_aVertices[uBaseVertex + uLocalIndex] = convertVertex(face.mIndices[j]);
+                    }
+
+                    m_aIndices[uBaseIndex + i * 3u + j] = static_cast<WORD>(uLocalIndex);
                 }
+            }
+            assert(uNumVertices == chunk.uNumVertices);
+        }
 
-                OutputDebugString(L"Loaded diffuse texture \"");
-                OutputDebugString(fullPath.c_str());
-                OutputDebugString(L"\"\n");
+        // A mirroring node matrix turns the triangles inside out
+        if (XMVectorGetX(XMMatrixDeterminant(nodeWorld)) < 0.0f)
+        {
+            for (UINT i = 0u; i < chunk.uNumFaces; ++i)
+            {
+                std::swap(m_aIndices[uBaseIndex + i * 3u + 1u], m_aIndices[uBaseIndex + i * 3u + 2u]);
             }
         }
 
-        return hr;
+        optimizeMesh(uMeshIndex, chunk.uNumVertices);
+
+        m_aMeshes[uMeshIndex].Bounds = ComputeMeshBounds(&m_aVertices.data()[uBaseVertex].Position, sizeof(VertexPNT), chunk.uNumVertices);
     }
 
-    HRESULT Model::loadSpecularTexture(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList, _In_ const std::filesystem::path& parentDirectory, _In_ const aiMaterial* pMaterial, _In_ UINT uIndex)
+    HRESULT Model::loadCache(_In_ const ModelCacheFile::Key& key)
     {
-        HRESULT hr = S_OK;
-        m_aMaterials[uIndex]->pSpecularExponent = nullptr;
+        PR_PROFILE_FUNCTION();
 
-        if (pMaterial->GetTextureCount(aiTextureType_SHININESS) > 0)
+        HRESULT hr = m_CacheFile.Initialize(getCachePath(), TRUE);
+        if (FAILED(hr))
         {
-            aiString aiPath;
-
-            if (pMaterial->GetTexture(aiTextureType_SHININESS, 0u, &aiPath, nullptr, nullptr, nullptr, nullptr, nullptr) == AI_SUCCESS)
-            {
-                std::string szPath(aiPath.data);
+            return hr;
+        }
 
-                if (szPath.substr(0ull, 2ull) == ".\\")
-                {
-                    szPath = szPath.substr(2ull, szPath.size() - 2ull);
-                }
+        hr = ModelCacheFile::Read(m_Cache, key, m_CacheFile.GetData(), m_CacheFile.GetSize());
+        if (FAILED(hr))
+        {
+            m_CacheFile.Release();
 
-                std::filesystem::path fullPath = parentDirectory / szPath;
+            OutputDebugString(L"Importing again, stale model cache of ");
+            OutputDebugString(m_filePath.c_str());
+            OutputDebugString(L"\n");
 
-                m_aMaterials[uIndex]->pSpecularExponent = std::make_shared<Texture>(fullPath);
+            return hr;
+        }
 
-                hr = m_aMaterials[uIndex]->pSpecularExponent->Initialize(pDevice, pCommandList);
-                if (FAILED(hr))
-                {
-                    OutputDebugString(L"Error loading specular texture \"");
-                    OutputDebugString(fullPath.c_str());
-                    OutputDebugString(L"\"\n");
+        // Read the mapping here on the loading thread, not while Initialize records the upload
+        m_CacheFile.Prefetch();
 
-                    return hr;
-                }
+        m_PositionDecode = m_Cache.Decode;
 
-                OutputDebugString(L"Loaded specular texture \"");
-                OutputDebugString(fullPath.c_str());
-                OutputDebugString(L"\"\n");
+        m_aMeshes.resize(m_Cache.uNumMeshes);
+        for (UINT i = 0u; i < m_Cache.uNumMeshes; ++i)
+        {
+            const SceneFile::Mesh& mesh = m_Cache.aMeshes[i];
+
+            m_aMeshes[i].uNumIndices = mesh.uNumIndices;
+            m_aMeshes[i].uBaseVertex = mesh.uBaseVertex;
+            m_aMeshes[i].uBaseIndex = mesh.uBaseIndex;
+            m_aMeshes[i].uMaterialIndex = mesh.uMaterialIndex;
+            m_aMeshes[i].Bounds = mesh.Bounds;
+            m_aMeshes[i].uNumLods = mesh.uNumLods;
+            m_aMeshes[i].uFirstMeshlet = m_Cache.aMeshMeshlets[i].uFirstMeshlet;
+            m_aMeshes[i].uNumMeshlets = m_Cache.aMeshMeshlets[i].uNumMeshlets;
+            for (UINT uLod = 1u; uLod < mesh.uNumLods; ++uLod)
+            {
+                m_aMeshes[i].aLods[uLod - 1u] =
+                {
+                    .uNumIndices = mesh.aLods[uLod - 1u].uNumIndices,
+                    .uBaseIndex = mesh.aLods[uLod - 1u].uBaseIndex,
+                    .Error = mesh.aLods[uLod - 1u].Error,
+                };
             }
         }
 
-        return hr;
+        std::vector<TexturePaths> aTexturePaths(m_Cache.uNumMaterials);
+        for (UINT i = 0u; i < m_Cache.uNumMaterials; ++i)
+        {
+            const ModelCacheFile::Material& material = m_Cache.aMaterials[i];
+            aTexturePaths[i] =
+            {
+                .szDiffuse = ModelCacheFile::GetString(m_Cache, material.uDiffuse),
+                .szSpecularExponent = ModelCacheFile::GetString(m_Cache, material.uSpecularExponent),
+                .szNormal = ModelCacheFile::GetString(m_Cache, material.uNormal),
+            };
+        }
+
+        return initMaterials(aTexturePaths, m_filePath);
     }
 
-    HRESULT Model::loadNormalTexture(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList, _In_ const std::filesystem::path& parentDirectory, _In_ const aiMaterial* pMaterial, _In_ UINT uIndex)
+    HRESULT Model::loadTexture(
+        _In_ const std::filesystem::path& parentDirectory,
+        _In_ const std::string& szPath,
+        _In_ PCWSTR pszType,
+        _Out_ std::shared_ptr<Texture>& pOutTexture
+    )
     {
         HRESULT hr = S_OK;
-        m_aMaterials[uIndex]->pNormal = nullptr;
 
-        if (pMaterial->GetTextureCount(aiTextureType_HEIGHT) > 0)
-        {
-            aiString aiPath;
+        pOutTexture = nullptr;
 
-            if (pMaterial->GetTexture(aiTextureType_HEIGHT, 0u, &aiPath, nullptr, nullptr, nullptr, nullptr, nullptr) == AI_SUCCESS)
-            {
-                std::string szPath(aiPath.data);
+        if (szPath.empty())
+        {
+            return hr;
+        }
 
-                if (szPath.substr(0ull, 2ull) == ".\\")
-                {
-                    szPath = szPath.substr(2ull, szPath.size() - 2ull);
-                }
+        std::filesystem::path fullPath = parentDirectory / szPath;
 
-                std::filesystem::path fullPath = parentDirectory / szPath;
+        pOutTexture = std::make_shared<Texture>(fullPath);
 
-                m_aMaterials[uIndex]->pNormal = std::make_shared<Texture>(fullPath);
-                m_bHasNormalMap = TRUE;
-                hr = m_aMaterials[uIndex]->pNormal->Initialize(pDevice, pCommandList);
-                if (FAILED(hr))
-                {
-                    OutputDebugString(L"Error loading normal texture \"");
-                    OutputDebugString(fullPath.c_str());
-                    OutputDebugString(L"\"\n");
+        hr = pOutTexture->Load();
+        if (FAILED(hr))
+        {
+            OutputDebugString(L"Error loading ");
+            OutputDebugString(pszType);
+            OutputDebugString(L" texture \"");
+            OutputDebugString(fullPath.c_str());
+            OutputDebugString(L"\"\n");
 
-                    return hr;
-                }
+            pOutTexture = nullptr;
 
-                OutputDebugString(L"Loaded normal texture \"");
-                OutputDebugString(fullPath.c_str());
-                OutputDebugString(L"\"\n");
-            }
+            return hr;
         }
 
+        OutputDebugString(L"Loaded ");
+        OutputDebugString(pszType);
+        OutputDebugString(L" texture \"");
+        OutputDebugString(fullPath.c_str());
+        OutputDebugString(L"\"\n");
+
         return hr;
     }
 
-    HRESULT Model::loadTextures(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList, _In_ const std::filesystem::path& parentDirectory, _In_ const aiMaterial* pMaterial, _In_ UINT uIndex)
+    HRESULT Model::loadTextures(_In_ const std::filesystem::path& parentDirectory, _In_ const TexturePaths& texturePaths, _In_ UINT uIndex)
     {
-        HRESULT hr = loadDiffuseTexture(pDevice, pCommandList, parentDirectory, pMaterial, uIndex);
+        HRESULT hr = loadTexture(parentDirectory, texturePaths.szDiffuse, L"diffuse", m_aMaterials[uIndex]->pDiffuse);
         if (FAILED(hr))
         {
             return hr;
         }
 
-        hr = loadSpecularTexture(pDevice, pCommandList, parentDirectory, pMaterial, uIndex);
+        hr = loadTexture(parentDirectory, texturePaths.szSpecularExponent, L"specular", m_aMaterials[uIndex]->pSpecularExponent);
         if (FAILED(hr))
         {
             return hr;
         }
 
-        hr = loadNormalTexture(pDevice, pCommandList, parentDirectory, pMaterial, uIndex);
+        hr = loadTexture(parentDirectory, texturePaths.szNormal, L"normal", m_aMaterials[uIndex]->pNormal);
         if (FAILED(hr))
         {
             return hr;
@@ -399,9 +934,252 @@ namespace pr
         return hr;
     }
 
+    void Model::optimizeMesh(_In_ UINT uMeshIndex, _In_ UINT uNumVertices)
+    {
+        const UINT uBaseVertex = m_aMeshes[uMeshIndex].uBaseVertex;
+        const UINT uBaseIndex = m_aMeshes[uMeshIndex].uBaseIndex;
+        const UINT uNumIndices = m_aMeshes[uMeshIndex].uNumIndices;
+        WORD* pIndices = m_aIndices.data() + uBaseIndex;
+
+        VertexCacheStats before = SimulateVertexCache(pIndices, uNumIndices, uNumVertices);
+
+        std::vector<UINT> auClusters;
+        OptimizeVertexCache(pIndices, uNumIndices, uNumVertices, &auClusters);
+        OptimizeOverdraw(pIndices, uNumIndices, &m_aVertices[uBaseVertex].Position, sizeof(VertexPNT), uNumVertices, auClusters, OVERDRAW_THRESHOLD);
+
+        // The vertices move to the order the reordered triangles fetch them in
+        std::vector<UINT> auRemap;
+        OptimizeVertexFetch(auRemap, pIndices, uNumIndices, uNumVertices);
+
+        std::vector<VertexPNT> aVertices(m_aVertices.begin() + uBaseVertex, m_aVertices.begin() + uBaseVertex + uNumVertices);
+        for (UINT i = 0u; i < uNumVertices; ++i)
+        {
+            m_aVertices[uBaseVertex + auRemap[i]] = aVertices[i];
+        }
+
+        VertexCacheStats after = SimulateVertexCache(pIndices, uNumIndices, uNumVertices);
+
+        CHAR szDebugMessage[256];
+        sprintf_s(
+            szDebugMessage,
+            "\tMesh %u: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+            uMeshIndex,
+            before.Acmr,
+            after.Acmr,
+            before.Atvr,
+            after.Atvr
+        );
+        OutputDebugStringA(szDebugMessage);
+    }
+
+    void Model::packVertices()
+    {
+        PR_PROFILE_FUNCTION();
+
+        // All meshes share the world matrix and so the decode, the bounds are those of the whole model
+        const UINT uNumVertices = static_cast<UINT>(m_aVertices.size());
+        m_PositionDecode = ComputePositionDecode(m_aVertices.data(), uNumVertices);
+
+        m_aPackedVertices.resize(uNumVertices);
+        EncodeVertices(m_aPackedVertices.data(), m_aVertices.data(), uNumVertices, m_PositionDecode);
+
+        VertexQuantizationError error = MeasureQuantizationError(m_aPackedVertices.data(), m_aVertices.data(), uNumVertices, m_PositionDecode);
+
+        CHAR szDebugMessage[256];
+        sprintf_s(
+            szDebugMessage,
+            "Packed %u vertices from %u to %u bytes: position error %g, normal error %g degrees, texture coordinate error %g\n\n",
+            uNumVertices,
+            static_cast<UINT>(uNumVertices * sizeof(VertexPNT)),
+            static_cast<UINT>(uNumVertices * sizeof(VertexPackedPNT)),
+            error.MaxPositionError,
+            XMConvertToDegrees(error.MaxNormalError),
+            error.MaxTexCoordError
+        );
+        OutputDebugStringA(szDebugMessage);
+
+        // Only the packed vertices are uploaded and cached
+        m_aVertices.clear();
+        m_aVertices.shrink_to_fit();
+    }
+
     void Model::reserveSpace(_In_ UINT uNumVertices, _In_ UINT uNumIndices)
     {
-        m_aVertices.reserve(uNumVertices);
-        m_aIndices.reserve(uNumIndices);
+        m_aVertices.resize(uNumVertices);
+        m_aIndices.resize(uNumIndices);
+    }
+
+    void Model::splitMeshes(_Out_ std::vector<MeshChunk>& aOutChunks, _In_ const aiScene* pScene)
+    {
+        PR_PROFILE_FUNCTION();
+
+        aOutChunks.clear();
+        aOutChunks.reserve(pScene->mNumMeshes);
+
+        // Chunk of the split mesh that last used each vertex
+        std::vector<UINT> auVertexChunks;
+        for (UINT i = 0u; i < pScene->mNumMeshes; ++i)
+        {
+            const aiMesh* pMesh = pScene->mMeshes[i];
+            if (pMesh->mNumVertices <= MAX_MESH_VERTICES)
+            {
+                aOutChunks.push_back(MeshChunk{ .uMesh = i, .uFirstFace = 0u, .uNumFaces = pMesh->mNumFaces, .uNumVertices = pMesh->mNumVertices });
+                continue;
+            }
+
+            // Faces are taken in order until the next one could need one vertex too many, so chunks stay contiguous
+            const size_t uFirstChunk = aOutChunks.size();
+            auVertexChunks.assign(pMesh->mNumVertices, UINT_MAX);
+            MeshChunk chunk = { .uMesh = i, .uFirstFace = 0u, .uNumFaces = 0u, .uNumVertices = 0u };
+            for (UINT uFace = 0u; uFace < pMesh->mNumFaces; ++uFace)
+            {
+                const aiFace& face = pMesh->mFaces[uFace];
+                assert(face.mNumIndices == 3u);
+
+                if (chunk.uNumVertices + 3u > MAX_MESH_VERTICES)
+                {
+                    UINT uNumNewVertices = 0u;
+                    for (UINT j = 0u; j < 3u; ++j)
+                    {
+                        if (auVertexChunks[face.mIndices[j]] != static_cast<UINT>(aOutChunks.size()))
+                        {
+                            ++uNumNewVertices;
+                        }
+                    }
+
+                    if (chunk.uNumVertices + uNumNewVertices > MAX_MESH_VERTICES)
+                    {
+                        aOutChunks.push_back(chunk);
+                        chunk = { .uMesh = i, .uFirstFace = uFace, .uNumFaces = 0u, .uNumVertices = 0u };
+                    }
+                }
+
+                for (UINT j = 0u; j < 3u; ++j)
+                {
+                    UINT& uVertexChunk = auVertexChunks[face.mIndices[j]];
+                    if (uVertexChunk != static_cast<UINT>(aOutChunks.size()))
+                    {
+                        uVertexChunk = static_cast<UINT>(aOutChunks.size());
+                        ++chunk.uNumVertices;
+                    }
+                }
+                ++chunk.uNumFaces;
+            }
+
+            if (chunk.uNumFaces > 0u)
+            {
+                aOutChunks.push_back(chunk);
+            }
+
+            CHAR szDebugMessage[256];
+            sprintf_s(
+                szDebugMessage,
+                "Split mesh %u '%s' of %u vertices into %u meshes for 16-bit indices\n",
+                i,
+                pMesh->mName.C_Str(),
+                pMesh->mNumVertices,
+                static_cast<UINT>(aOutChunks.size() - uFirstChunk)
+            );
+            OutputDebugStringA(szDebugMessage);
+        }
+    }
+
+    HRESULT Model::saveCache(_In_ const ModelCacheFile::Key& key) const
+    {
+        PR_PROFILE_FUNCTION();
+
+        HRESULT hr = S_OK;
+
+        std::vector<SceneFile::Mesh> aMeshes;
+        std::vector<ModelCacheFile::MeshMeshlets> aMeshMeshlets;
+        aMeshes.reserve(m_aMeshes.size());
+        aMeshMeshlets.reserve(m_aMeshes.size());
+        for (const BasicMeshEntry& entry : m_aMeshes)
+        {
+            aMeshMeshlets.push_back(ModelCacheFile::MeshMeshlets{ .uFirstMeshlet = entry.uFirstMeshlet, .uNumMeshlets = entry.uNumMeshlets });
+
+            SceneFile::Mesh mesh =
+            {
+                .uNumIndices = entry.uNumIndices,
+                .uBaseVertex = entry.uBaseVertex,
+                .uBaseIndex = entry.uBaseIndex,
+                .uMaterialIndex = entry.uMaterialIndex,
+                .Bounds = entry.Bounds,
+                .uNumLods = entry.uNumLods,
+                .aLods = {},
+            };
+            for (UINT uLod = 1u; uLod < entry.uNumLods; ++uLod)
+            {
+                mesh.aLods[uLod - 1u] =
+                {
+                    .uNumIndices = entry.aLods[uLod - 1u].uNumIndices,
+                    .uBaseIndex = entry.aLods[uLod - 1u].uBaseIndex,
+                    .Error = entry.aLods[uLod - 1u].Error,
+                };
+            }
+            aMeshes.push_back(mesh);
+        }
+
+        // Paths are cached as written in the model file, so the textures load the same way as after an import
+        std::string strings;
+        auto addString = [&strings](const std::string& string)
+        {
+            if (string.empty())
+            {
+                return ModelCacheFile::INVALID_INDEX;
+            }
+
+            const UINT uOffset = static_cast<UINT>(strings.size());
+            strings.append(string.c_str(), string.size() + 1u);
+            return uOffset;
+        };
+
+        std::vector<ModelCacheFile::Material> aMaterials(m_pScene->mNumMaterials);
+        for (UINT i = 0u; i < m_pScene->mNumMaterials; ++i)
+        {
+            aMaterials[i] =
+            {
+                .uDiffuse = addString(getTexturePath(m_pScene->mMaterials[i], aiTextureType_DIFFUSE)),
+                .uSpecularExponent = addString(getTexturePath(m_pScene->mMaterials[i], aiTextureType_SHININESS)),
+                .uNormal = addString(getTexturePath(m_pScene->mMaterials[i], aiTextureType_HEIGHT)),
+            };
+        }
+
+        const ModelCacheFile::View view =
+        {
+            .aVertices = m_aPackedVertices.data(),
+            .uNumVertices = static_cast<UINT>(m_aPackedVertices.size()),
+            .Decode = m_PositionDecode,
+            .auIndices = m_aIndices.data(),
+            .uNumIndices = static_cast<UINT>(m_aIndices.size()),
+            .aMeshes = aMeshes.data(),
+            .uNumMeshes = static_cast<UINT>(aMeshes.size()),
+            .aMaterials = aMaterials.data(),
+            .uNumMaterials = static_cast<UINT>(aMaterials.size()),
+            .aMeshMeshlets = aMeshMeshlets.data(),
+            .aMeshlets = m_aMeshlets.data(),
+            .uNumMeshlets = static_cast<UINT>(m_aMeshlets.size()),
+            .auMeshletVertices = m_auMeshletVertices.data(),
+            .uNumMeshletVertices = static_cast<UINT>(m_auMeshletVertices.size()),
+            .auMeshletTriangles = m_auMeshletTriangles.data(),
+            .uNumMeshletTriangles = static_cast<UINT>(m_auMeshletTriangles.size()),
+            .pStrings = strings.data(),
+            .uStringsSize = static_cast<UINT>(strings.size()),
+        };
+
+        std::vector<BYTE> aFile;
+        hr = ModelCacheFile::Write(aFile, key, view);
+        CHECK_AND_RETURN_HRESULT(hr, L"Model::saveCache >> Laying out model cache");
+
+        // A cache cut short by a failed write is rejected by its size the next time
+        std::ofstream file(getCachePath(), std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const CHAR*>(aFile.data()), static_cast<std::streamsize>(aFile.size()));
+        if (!file)
+        {
+            hr = E_FAIL;
+            CHECK_AND_RETURN_HRESULT(hr, L"Model::saveCache >> Writing model cache");
+        }
+
+        return hr;
     }
 }
\ No newline at end of file
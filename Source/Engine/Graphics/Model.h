@@ -14,8 +14,10 @@
 #include "pch.h"
 
 #include "Graphics/DataTypes.h"
+#include "Graphics/ModelCacheFile.h"
 #include "Graphics/Renderable.h"
 #include "Texture/Material.h"
+#include "Utility/MappedFile.h"
 
 struct aiScene;
 struct aiMesh;
@@ -25,11 +27,6 @@ struct aiBone;
 struct aiNode;
 struct aiNodeAnim;
 
-namespace Assimp
-{
-    class Importer;
-}
-
 namespace pr
 {
     /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
@@ -37,8 +34,15 @@ namespace pr
 
       Summary:  Model class is a renderable from model files
 
-      Methods:  Initialize
-                  Pure virtual function that initializes the object
+      Methods:  Load
+                  Imports the file, converts its meshes to packed
+                  vertices and meshlets and decodes its textures on
+                  the CPU. The
+                  result is cached next to the file, later loads of
+                  the same file map the cache instead of importing it
+                Initialize
+                  Creates the buffers and textures, loads the model
+                  first if Load was not called
                 Update
                   Pure virtual function that updates the object each
                   frame
@@ -63,6 +67,16 @@ namespace pr
     C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
     class Model : public Renderable
     {
+    public:
+        // Every LOD aims for this fraction of the previous one's triangles
+        static constexpr const FLOAT LOD_REDUCTION = 0.5f;
+        // LODs that keep more than this fraction of the previous one's triangles are not worth a range
+        static constexpr const FLOAT MIN_LOD_REDUCTION = 0.8f;
+        // Simplification stops once a surface moved further than this fraction of the mesh radius
+        static constexpr const FLOAT MAX_LOD_ERROR = 0.05f;
+        // Overdraw ordering may raise the ACMR of the cache optimized triangles by this factor
+        static constexpr const FLOAT OVERDRAW_THRESHOLD = 1.05f;
+
     public:
         Model() = delete;
         Model(_In_ const std::filesystem::path& filePath);
@@ -72,6 +86,7 @@ namespace pr
         Model& operator=(Model&& other) = delete;
         virtual ~Model() noexcept;
 
+        virtual HRESULT Load() override;
         virtual HRESULT Initialize(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList) override;
         virtual void Update(_In_ FLOAT deltaTime) override;
 
@@ -79,62 +94,90 @@ namespace pr
         virtual UINT GetNumIndices() const override;
 
     protected:
-        void countVerticesAndIndices(_Inout_ UINT& uOutNumVertices, _Inout_ UINT& uOutNumIndices, _In_ const aiScene* pScene);
+        // Texture paths of a material as written in the model file, empty for none
+        struct TexturePaths
+        {
+            std::string szDiffuse;
+            std::string szSpecularExponent;
+            std::string szNormal;
+        };
+
+        // Faces of a file mesh that become one mesh, file meshes with more vertices than 16-bit indices address
+        // are split into chunks of consecutive faces. World is the matrix of the node the chunk is baked with.
+        struct MeshChunk
+        {
+            UINT uMesh;
+            UINT uFirstFace;
+            UINT uNumFaces;
+            UINT uNumVertices;
+            XMFLOAT4X4 World;
+        };
+
+    protected:
+        HRESULT computeCacheKey(_Out_ ModelCacheFile::Key& outKey) const;
+        void countVerticesAndIndices(
+            _Inout_ UINT& uOutNumVertices,
+            _Inout_ UINT& uOutNumIndices,
+            _In_ const std::vector<MeshChunk>& aChunks,
+            _In_ const aiScene* pScene
+        );
         const virtual void* getVertices() const override;
         virtual const WORD* getIndices() const override;
-        void initAllMeshes(_In_ const aiScene* pScene);
+        virtual const Meshlet* getMeshlets() const override;
+        void buildMeshlets();
+        void generateLods();
+        std::filesystem::path getCachePath() const;
+        void initAllMeshes(_In_ const aiScene* pScene, _In_ const std::vector<MeshChunk>& aChunks);
         HRESULT initFromScene(
-            _In_ ID3D12Device2* pDevice,
-            _In_ ID3D12GraphicsCommandList2* pCommandList,
             _In_ const aiScene* pScene,
             _In_ const std::filesystem::path& filePath
         );
         HRESULT initMaterials(
-            _In_ ID3D12Device2* pDevice,
-            _In_ ID3D12GraphicsCommandList2* pCommandList,
-            _In_ const aiScene* pScene,
+            _In_ const std::vector<TexturePaths>& aTexturePaths,
             _In_ const std::filesystem::path& filePath
         );
-        void initSingleMesh(_In_ UINT uMeshIndex, _In_ const aiMesh* pMesh);
-        HRESULT loadDiffuseTexture(
-            _In_ ID3D12Device2* pDevice,
-            _In_ ID3D12GraphicsCommandList2* pCommandList,
+        void initNodes(_Inout_ std::vector<MeshChunk>& aChunks, _In_ const aiScene* pScene);
+        void initSingleMesh(_In_ UINT uMeshIndex, _In_ const aiMesh* pMesh, _In_ const MeshChunk& chunk);
+        HRESULT loadCache(_In_ const ModelCacheFile::Key& key);
+        HRESULT loadTexture(
             _In_ const std::filesystem::path& parentDirectory,
-            _In_ const aiMaterial* pMaterial,
-            _In_ UINT uIndex
-        );
-        HRESULT loadSpecularTexture(
-            _In_ ID3D12Device2* pDevice,
-            _In_ ID3D12GraphicsCommandList2* pCommandList,
-            _In_ const std::filesystem::path& parentDirectory,
-            _In_ const aiMaterial* pMaterial,
-            _In_ UINT uIndex
-        );
-        HRESULT loadNormalTexture(
-            _In_ ID3D12Device2* pDevice,
-            _In_ ID3D12GraphicsCommandList2* pCommandList,
-            _In_ const std::filesystem::path& parentDirectory,
-            _In_ const aiMaterial* pMaterial,
-            _In_ UINT uIndex
+            _In_ const std::string& szPath,
+            _In_ PCWSTR pszType,
+            _Out_ std::shared_ptr<Texture>& pOutTexture
         );
         HRESULT loadTextures(
-            _In_ ID3D12Device2* pDevice,
-            _In_ ID3D12GraphicsCommandList2* pCommandList,
             _In_ const std::filesystem::path& parentDirectory,
-            _In_ const aiMaterial* pMaterial,
+            _In_ const TexturePaths& texturePaths,
             _In_ UINT uIndex
         );
+        void optimizeMesh(_In_ UINT uMeshIndex, _In_ UINT uNumVertices);
+        void packVertices();
         void reserveSpace(_In_ UINT uNumVertices, _In_ UINT uNumIndices);
+        HRESULT saveCache(_In_ const ModelCacheFile::Key& key) const;
+        void splitMeshes(_Out_ std::vector<MeshChunk>& aOutChunks, _In_ const aiScene* pScene);
 
     protected:
-        static std::unique_ptr<Assimp::Importer> sm_pImporter;
+        // Models loaded from the same file share the buffers of the first one to load it, models load concurrently
+        static std::unordered_map<std::wstring, Model*> sm_GeometrySources;
+        static std::mutex sm_GeometrySourcesMutex;
 
     protected:
         std::filesystem::path m_filePath;
 
+        // Full precision vertices only live during the import, the packed ones are drawn
         std::vector<VertexPNT> m_aVertices;
+        std::vector<VertexPackedPNT> m_aPackedVertices;
         std::vector<WORD> m_aIndices;
+        std::vector<Meshlet> m_aMeshlets;
+        std::vector<WORD> m_auMeshletVertices;
+        std::vector<BYTE> m_auMeshletTriangles;
+
+        // Set by a warm load, the vertices and indices are uploaded and the meshlets read straight from the mapped cache
+        MappedFile m_CacheFile;
+        ModelCacheFile::View m_Cache;
 
+        // This model once it loaded the file, or the model that loaded it first
+        Model* m_pGeometrySource;
         const aiScene* m_pScene;
     };
 }
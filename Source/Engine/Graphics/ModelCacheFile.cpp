@@ -0,0 +1,256 @@
+#include "pch.h"
+
+#include "Graphics/ModelCacheFile.h"
+
+#include "Utility/Math.h"
+
+namespace pr
+{
+	namespace ModelCacheFile
+	{
+		namespace
+		{
+			constexpr const size_t NUM_SECTIONS = static_cast<size_t>(eSection::COUNT);
+
+			BOOL isString(_In_ const View& view, _In_ UINT uString) noexcept
+			{
+				return uString == INVALID_INDEX || uString < view.uStringsSize;
+			}
+
+			BOOL isRange(_In_ UINT uFirst, _In_ UINT uCount, _In_ UINT uSize) noexcept
+			{
+				return uFirst <= uSize && uCount <= uSize - uFirst;
+			}
+
+			BOOL isSameKey(_In_ const Key& key, _In_ const Key& other) noexcept
+			{
+				return key.uSourceHash == other.uSourceHash && key.uSourceSize == other.uSourceSize && key.uImportFlags == other.uImportFlags;
+			}
+
+			// Every offset and index of the view is in bounds, so the records can be followed without further checks
+			HRESULT validate(_In_ const View& view) noexcept
+			{
+				// Any offset into the strings then ends at a terminator
+				if (view.uStringsSize > 0u && view.pStrings[view.uStringsSize - 1u] != '\0')
+				{
+					return E_FAIL;
+				}
+
+				if (!(view.Decode.Scale > 0.0f))
+				{
+					return E_FAIL;
+				}
+
+				for (UINT i = 0u; i < view.uNumMeshes; ++i)
+				{
+					const SceneFile::Mesh& mesh = view.aMeshes[i];
+					if (mesh.uBaseVertex > view.uNumVertices
+						|| !isRange(mesh.uBaseIndex, mesh.uNumIndices, view.uNumIndices)
+						|| (mesh.uMaterialIndex != INVALID_INDEX && mesh.uMaterialIndex >= view.uNumMaterials)
+						|| mesh.uNumLods == 0u
+						|| mesh.uNumLods > SceneFile::MAX_LODS)
+					{
+						return E_FAIL;
+					}
+
+					for (UINT uLod = 1u; uLod < mesh.uNumLods; ++uLod)
+					{
+						if (!isRange(mesh.aLods[uLod - 1u].uBaseIndex, mesh.aLods[uLod - 1u].uNumIndices, view.uNumIndices))
+						{
+							return E_FAIL;
+						}
+					}
+
+					// Meshlets draw triangles of LOD 0 of their own mesh
+					const MeshMeshlets& meshMeshlets = view.aMeshMeshlets[i];
+					if (!isRange(meshMeshlets.uFirstMeshlet, meshMeshlets.uNumMeshlets, view.uNumMeshlets))
+					{
+						return E_FAIL;
+					}
+
+					for (UINT j = meshMeshlets.uFirstMeshlet; j < meshMeshlets.uFirstMeshlet + meshMeshlets.uNumMeshlets; ++j)
+					{
+						const Meshlet& meshlet = view.aMeshlets[j];
+						if (meshlet.uNumVertices > MAX_MESHLET_VERTICES
+							|| meshlet.uNumTriangles > MAX_MESHLET_TRIANGLES
+							|| meshlet.uBaseIndex < mesh.uBaseIndex
+							|| !isRange(meshlet.uBaseIndex - mesh.uBaseIndex, meshlet.uNumTriangles * 3u, mesh.uNumIndices)
+							|| !isRange(meshlet.uVertexOffset, meshlet.uNumVertices, view.uNumMeshletVertices)
+							|| !isRange(meshlet.uTriangleOffset, meshlet.uNumTriangles * 3u, view.uNumMeshletTriangles))
+						{
+							return E_FAIL;
+						}
+					}
+				}
+
+				for (UINT i = 0u; i < view.uNumMaterials; ++i)
+				{
+					const Material& material = view.aMaterials[i];
+					for (UINT uPath : { material.uDiffuse, material.uSpecularExponent, material.uNormal })
+					{
+						if (!isString(view, uPath))
+						{
+							return E_FAIL;
+						}
+					}
+				}
+
+				return S_OK;
+			}
+		}
+
+		HRESULT Write(_Out_ std::vector<BYTE>& aOutData, _In_ const Key& key, _In_ const View& view)
+		{
+			aOutData.clear();
+
+			if (FAILED(validate(view)))
+			{
+				return E_INVALIDARG;
+			}
+
+			const std::pair<const void*, UINT64> aSections[NUM_SECTIONS] =
+			{
+				{ view.aVertices, sizeof(VertexPackedPNT) * static_cast<UINT64>(view.uNumVertices) },
+				{ view.auIndices, sizeof(WORD) * static_cast<UINT64>(view.uNumIndices) },
+				{ view.aMeshes, sizeof(SceneFile::Mesh) * static_cast<UINT64>(view.uNumMeshes) },
+				{ view.aMaterials, sizeof(Material) * static_cast<UINT64>(view.uNumMaterials) },
+				{ view.aMeshMeshlets, sizeof(MeshMeshlets) * static_cast<UINT64>(view.uNumMeshes) },
+				{ view.aMeshlets, sizeof(Meshlet) * static_cast<UINT64>(view.uNumMeshlets) },
+				{ view.auMeshletVertices, sizeof(WORD) * static_cast<UINT64>(view.uNumMeshletVertices) },
+				{ view.auMeshletTriangles, view.uNumMeshletTriangles },
+				{ view.pStrings, view.uStringsSize },
+			};
+
+			Header header =
+			{
+				.uMagic = MAGIC,
+				.uVersion = VERSION,
+				.uFileSize = 0u,
+				.ImportKey = key,
+				.Decode = view.Decode,
+				.aSections = {},
+			};
+
+			size_t uOffset = sizeof(Header);
+			for (size_t i = 0; i < NUM_SECTIONS; ++i)
+			{
+				uOffset = AlignUp(uOffset, SECTION_ALIGNMENT);
+				header.aSections[i] = SceneFile::Section{ .uOffset = uOffset, .uSize = aSections[i].second };
+				uOffset += static_cast<size_t>(aSections[i].second);
+			}
+			header.uFileSize = uOffset;
+
+			aOutData.assign(uOffset, 0u);
+			memcpy(aOutData.data(), &header, sizeof(Header));
+			for (size_t i = 0; i < NUM_SECTIONS; ++i)
+			{
+				if (aSections[i].second > 0u)
+				{
+					memcpy(aOutData.data() + header.aSections[i].uOffset, aSections[i].first, static_cast<size_t>(aSections[i].second));
+				}
+			}
+
+			return S_OK;
+		}
+
+		HRESULT Read(_Out_ View& outView, _In_ const Key& key, _In_reads_bytes_(uSize) const BYTE* pData, _In_ size_t uSize)
+		{
+			outView = {};
+
+			Header header;
+			if (!pData || uSize < sizeof(Header))
+			{
+				return E_FAIL;
+			}
+			memcpy(&header, pData, sizeof(Header));
+
+			if (header.uMagic != MAGIC || header.uVersion != VERSION || header.uFileSize != uSize || !isSameKey(header.ImportKey, key))
+			{
+				return E_FAIL;
+			}
+
+			// The records are read in place, so the sections have to be aligned within the file
+			constexpr const size_t RECORD_SIZES[NUM_SECTIONS] =
+			{
+				sizeof(VertexPackedPNT),
+				sizeof(WORD),
+				sizeof(SceneFile::Mesh),
+				sizeof(Material),
+				sizeof(MeshMeshlets),
+				sizeof(Meshlet),
+				sizeof(WORD),
+				1u,
+				1u,
+			};
+			for (size_t i = 0; i < NUM_SECTIONS; ++i)
+			{
+				const SceneFile::Section& section = header.aSections[i];
+				if (section.uOffset < sizeof(Header)
+					|| section.uOffset % SECTION_ALIGNMENT != 0u
+					|| section.uOffset > uSize
+					|| section.uSize > uSize - section.uOffset
+					|| section.uSize % RECORD_SIZES[i] != 0u
+					|| section.uSize / RECORD_SIZES[i] > UINT_MAX)
+				{
+					return E_FAIL;
+				}
+			}
+
+			auto getSection = [&header, pData](eSection section)
+			{
+				return pData + header.aSections[static_cast<size_t>(section)].uOffset;
+			};
+			auto getCount = [&header](eSection section, size_t uRecordSize)
+			{
+				return static_cast<UINT>(header.aSections[static_cast<size_t>(section)].uSize / uRecordSize);
+			};
+
+			View view =
+			{
+				.aVertices = reinterpret_cast<const VertexPackedPNT*>(getSection(eSection::VERTICES)),
+				.uNumVertices = getCount(eSection::VERTICES, sizeof(VertexPackedPNT)),
+				.Decode = header.Decode,
+				.auIndices = reinterpret_cast<const WORD*>(getSection(eSection::INDICES)),
+				.uNumIndices = getCount(eSection::INDICES, sizeof(WORD)),
+				.aMeshes = reinterpret_cast<const SceneFile::Mesh*>(getSection(eSection::MESHES)),
+				.uNumMeshes = getCount(eSection::MESHES, sizeof(SceneFile::Mesh)),
+				.aMaterials = reinterpret_cast<const Material*>(getSection(eSection::MATERIALS)),
+				.uNumMaterials = getCount(eSection::MATERIALS, sizeof(Material)),
+				.aMeshMeshlets = reinterpret_cast<const MeshMeshlets*>(getSection(eSection::MESH_MESHLETS)),
+				.aMeshlets = reinterpret_cast<const Meshlet*>(getSection(eSection::MESHLETS)),
+				.uNumMeshlets = getCount(eSection::MESHLETS, sizeof(Meshlet)),
+				.auMeshletVertices = reinterpret_cast<const WORD*>(getSection(eSection::MESHLET_VERTICES)),
+				.uNumMeshletVertices = getCount(eSection::MESHLET_VERTICES, sizeof(WORD)),
+				.auMeshletTriangles = getSection(eSection::MESHLET_TRIANGLES),
+				.uNumMeshletTriangles = getCount(eSection::MESHLET_TRIANGLES, 1u),
+				.pStrings = reinterpret_cast<const CHAR*>(getSection(eSection::STRINGS)),
+				.uStringsSize = getCount(eSection::STRINGS, 1u),
+			};
+
+			if (getCount(eSection::MESH_MESHLETS, sizeof(MeshMeshlets)) != view.uNumMeshes)
+			{
+				return E_FAIL;
+			}
+
+			HRESULT hr = validate(view);
+			if (FAILED(hr))
+			{
+				return hr;
+			}
+
+			outView = view;
+
+			return S_OK;
+		}
+
+		PCSTR GetString(_In_ const View& view, _In_ UINT uString) noexcept
+		{
+			if (uString == INVALID_INDEX)
+			{
+				return "";
+			}
+
+			return view.pStrings + uString;
+		}
+	}
+}
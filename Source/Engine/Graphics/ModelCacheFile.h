@@ -0,0 +1,109 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/DataTypes.h"
+#include "Graphics/Meshlet.h"
+#include "Scene/SceneFile.h"
+
+namespace pr
+{
+	// On disk layout of the geometry of an imported model file, all values little endian:
+	//   Header, then the sections of Header::aSections each aligned to SECTION_ALIGNMENT
+	// The header keeps the key of the import, a cache whose key differs from the source file is stale, and the decode
+	// of the packed vertex positions. Meshes are the records of cooked scenes, material records hold offsets of
+	// texture paths into the string section, as written in the model file. Like scene files, Read checks every
+	// offset and index but not the vertex indices, nor the local indices of meshlet triangles.
+	namespace ModelCacheFile
+	{
+		constexpr const UINT MAGIC = 0x434D5250;	// "PRMC"
+		// Bumped whenever the import or the layout changes, so caches of older builds are imported again
+		constexpr const UINT VERSION = 6u;
+		constexpr const UINT SECTION_ALIGNMENT = 16u;
+		constexpr const UINT INVALID_INDEX = 0xFFFFFFFFu;
+
+		enum class eSection : UINT
+		{
+			VERTICES,
+			INDICES,
+			MESHES,
+			MATERIALS,
+			MESH_MESHLETS,
+			MESHLETS,
+			MESHLET_VERTICES,
+			MESHLET_TRIANGLES,
+			STRINGS,
+			COUNT,
+		};
+
+		// Contents hash and size of the source file and the importer flags it was read with
+		struct Key
+		{
+			UINT64 uSourceHash;
+			UINT64 uSourceSize;
+			UINT uImportFlags;
+			UINT uReserved;
+		};
+		static_assert(sizeof(Key) == 24);
+
+		struct Header
+		{
+			UINT uMagic;
+			UINT uVersion;
+			UINT64 uFileSize;
+			Key ImportKey;
+			PositionDecode Decode;
+			SceneFile::Section aSections[static_cast<size_t>(eSection::COUNT)];
+		};
+		static_assert(sizeof(Header) == 200);
+
+		// Texture paths are string offsets, INVALID_INDEX for none
+		struct Material
+		{
+			UINT uDiffuse;
+			UINT uSpecularExponent;
+			UINT uNormal;
+		};
+		static_assert(sizeof(Material) == 12);
+
+		// Meshlets of the mesh with the same index, every mesh has one record
+		struct MeshMeshlets
+		{
+			UINT uFirstMeshlet;
+			UINT uNumMeshlets;
+		};
+		static_assert(sizeof(MeshMeshlets) == 8);
+
+		// Sections in memory, either to be written or pointing into a file that passed Read
+		struct View
+		{
+			const VertexPackedPNT* aVertices;
+			UINT uNumVertices;
+			PositionDecode Decode;
+			const WORD* auIndices;
+			UINT uNumIndices;
+			const SceneFile::Mesh* aMeshes;
+			UINT uNumMeshes;
+			const Material* aMaterials;
+			UINT uNumMaterials;
+			const MeshMeshlets* aMeshMeshlets;
+			const Meshlet* aMeshlets;
+			UINT uNumMeshlets;
+			const WORD* auMeshletVertices;
+			UINT uNumMeshletVertices;
+			const BYTE* auMeshletTriangles;
+			UINT uNumMeshletTriangles;
+			const CHAR* pStrings;
+			UINT uStringsSize;
+		};
+
+		// Fails with E_INVALIDARG on views that would not pass Read
+		HRESULT Write(_Out_ std::vector<BYTE>& aOutData, _In_ const Key& key, _In_ const View& view);
+
+		// Checks the header against the key, the sections and every offset and index, the view points into pData
+		HRESULT Read(_Out_ View& outView, _In_ const Key& key, _In_reads_bytes_(uSize) const BYTE* pData, _In_ size_t uSize);
+
+		// uString must be a string offset of a view returned by Read, INVALID_INDEX gives an empty string
+		PCSTR GetString(_In_ const View& view, _In_ UINT uString) noexcept;
+	}
+}
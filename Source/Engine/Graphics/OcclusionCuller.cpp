@@ -0,0 +1,512 @@
+#include "pch.h"
+
+#include "Graphics/OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <immintrin.h>
+
+#include "Utility/JobSystem.h"
+#include "Utility/Profiler.h"
+
+namespace pr
+{
+	namespace
+	{
+		constexpr const UINT OBJECTS_PER_JOB = 256u;
+
+		XMFLOAT4X4 multiply(_In_ const XMFLOAT4X4& a, _In_ const XMFLOAT4X4& b) noexcept
+		{
+			XMFLOAT4X4 result;
+			for (UINT uRow = 0u; uRow < 4u; ++uRow)
+			{
+				for (UINT uColumn = 0u; uColumn < 4u; ++uColumn)
+				{
+					result.m[uRow][uColumn] =
+						a.m[uRow][0] * b.m[0][uColumn] +
+						a.m[uRow][1] * b.m[1][uColumn] +
+						a.m[uRow][2] * b.m[2][uColumn] +
+						a.m[uRow][3] * b.m[3][uColumn];
+				}
+			}
+
+			return result;
+		}
+
+		// Range of pixels whose centers lie in [minimum, maximum], empty when iOutBegin > iOutEnd
+		void getPixelRange(_Out_ INT& iOutBegin, _Out_ INT& iOutEnd, _In_ FLOAT minimum, _In_ FLOAT maximum, _In_ UINT uSize) noexcept
+		{
+			iOutBegin = static_cast<INT>(std::max(std::ceil(std::max(minimum, -1.0f) - 0.5f), 0.0f));
+			iOutEnd = static_cast<INT>(std::min(std::floor(std::min(maximum, static_cast<FLOAT>(uSize) + 1.0f) - 0.5f), static_cast<FLOAT>(uSize) - 1.0f));
+		}
+	}
+
+	OcclusionCuller::OcclusionCuller() noexcept
+		: m_aOccluders()
+		, m_auTriangleOffsets()
+		, m_aTriangles()
+		, m_auBinOffsets(NUM_TILES_Y + 1u, 0u)
+		, m_auBinnedTriangles()
+		, m_aBounds()
+		, m_abVisible()
+		, m_aDepthBuffer(static_cast<size_t>(WIDTH) * HEIGHT, 0.0f)
+		, m_aTileDepths(static_cast<size_t>(NUM_TILES_X) * NUM_TILES_Y, 0.0f)
+		, m_uNumVisible(0u)
+		, m_uNumRasterizedTriangles(0u)
+	{
+	}
+
+	void OcclusionCuller::Reset() noexcept
+	{
+		m_aOccluders.clear();
+		m_aBounds.clear();
+		m_abVisible.clear();
+		m_uNumVisible = 0u;
+		m_uNumRasterizedTriangles = 0u;
+	}
+
+	void OcclusionCuller::AddOccluder(_In_ const OccluderGeometry& geometry, _In_ UINT uMesh, _In_ const XMFLOAT4X4& world)
+	{
+		assert(uMesh < geometry.aMeshes.size());
+
+		m_aOccluders.push_back(
+			Occluder
+			{
+				.pGeometry = &geometry,
+				.uMesh = uMesh,
+				.World = world,
+			}
+		);
+	}
+
+	UINT OcclusionCuller::AddBounds(_In_ const MeshBounds& worldBounds)
+	{
+		m_aBounds.push_back(worldBounds);
+
+		return static_cast<UINT>(m_aBounds.size() - 1u);
+	}
+
+	void OcclusionCuller::Cull(_In_ const XMFLOAT4X4& viewProjection, _In_ JobSystem& jobSystem)
+	{
+		PR_PROFILE_FUNCTION();
+
+		m_auTriangleOffsets.resize(m_aOccluders.size() + 1u);
+		m_auTriangleOffsets[0] = 0u;
+		for (size_t i = 0; i < m_aOccluders.size(); ++i)
+		{
+			const Occluder& occluder = m_aOccluders[i];
+			m_auTriangleOffsets[i + 1u] = m_auTriangleOffsets[i] + occluder.pGeometry->aMeshes[occluder.uMesh].uNumIndices / 3u;
+		}
+		m_aTriangles.resize(m_auTriangleOffsets.back());
+
+		{
+			PR_PROFILE_SCOPE("Transform Occluders");
+
+			jobSystem.ParallelFor(static_cast<UINT>(m_aOccluders.size()), 1u, [this, &viewProjection](UINT uBegin, UINT uEnd)
+			{
+				transformOccluders(viewProjection, uBegin, uEnd);
+			});
+		}
+
+		{
+			PR_PROFILE_SCOPE("Bin Triangles");
+
+			binTriangles();
+		}
+
+		{
+			PR_PROFILE_SCOPE("Rasterize Occluders");
+
+			jobSystem.ParallelFor(NUM_TILES_Y, 1u, [this](UINT uBegin, UINT uEnd)
+			{
+				for (UINT uTileRow = uBegin; uTileRow < uEnd; ++uTileRow)
+				{
+					rasterizeTileRow(uTileRow);
+				}
+			});
+		}
+
+		{
+			PR_PROFILE_SCOPE("Test Bounds");
+
+			m_abVisible.assign(m_aBounds.size(), TRUE);
+			jobSystem.ParallelFor(static_cast<UINT>(m_aBounds.size()), OBJECTS_PER_JOB, [this, &viewProjection](UINT uBegin, UINT uEnd)
+			{
+				testBounds(viewProjection, uBegin, uEnd);
+			});
+		}
+
+		m_uNumVisible = static_cast<UINT>(std::count(m_abVisible.begin(), m_abVisible.end(), static_cast<BYTE>(TRUE)));
+	}
+
+	BOOL OcclusionCuller::IsVisible(_In_ UINT uIndex) const noexcept
+	{
+		assert(uIndex < m_abVisible.size());
+
+		return m_abVisible[uIndex];
+	}
+
+	UINT OcclusionCuller::GetNumObjects() const noexcept
+	{
+		return static_cast<UINT>(m_aBounds.size());
+	}
+
+	UINT OcclusionCuller::GetNumVisible() const noexcept
+	{
+		return m_uNumVisible;
+	}
+
+	OcclusionCuller::Stats OcclusionCuller::GetStats() const noexcept
+	{
+		return Stats
+		{
+			.uNumOccluders = static_cast<UINT>(m_aOccluders.size()),
+			.uNumOccluderTriangles = static_cast<UINT>(m_aTriangles.size()),
+			.uNumRasterizedTriangles = m_uNumRasterizedTriangles,
+			.uNumObjects = static_cast<UINT>(m_aBounds.size()),
+			.uNumOccluded = static_cast<UINT>(m_aBounds.size()) - m_uNumVisible,
+		};
+	}
+
+	HRESULT OcclusionCuller::DumpDepthBuffer(_In_ const std::filesystem::path& filePath) const
+	{
+		FLOAT maxDepth = *std::max_element(m_aDepthBuffer.begin(), m_aDepthBuffer.end());
+		FLOAT scale = maxDepth > 0.0f ? 255.0f / maxDepth : 0.0f;
+
+		std::vector<BYTE> aPixels(m_aDepthBuffer.size());
+		for (size_t i = 0; i < m_aDepthBuffer.size(); ++i)
+		{
+			aPixels[i] = static_cast<BYTE>(std::min(m_aDepthBuffer[i] * scale, 255.0f));
+		}
+
+		std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+		file << "P5\n" << WIDTH << ' ' << HEIGHT << "\n255\n";
+		file.write(reinterpret_cast<const CHAR*>(aPixels.data()), static_cast<std::streamsize>(aPixels.size()));
+
+		return file ? S_OK : E_FAIL;
+	}
+
+	void OcclusionCuller::transformOccluders(_In_ const XMFLOAT4X4& viewProjection, _In_ UINT uBegin, _In_ UINT uEnd) noexcept
+	{
+		// x, y in pixels and 1 / w, w is negative for vertices in front of the near plane
+		std::vector<XMFLOAT4> aScreenVertices;
+
+		for (UINT uOccluder = uBegin; uOccluder < uEnd; ++uOccluder)
+		{
+			const Occluder& occluder = m_aOccluders[uOccluder];
+			const OccluderGeometry::Mesh& mesh = occluder.pGeometry->aMeshes[occluder.uMesh];
+			const XMFLOAT3* pPositions = occluder.pGeometry->aPositions.data() + mesh.uBaseVertex;
+			const WORD* pIndices = occluder.pGeometry->aIndices.data() + mesh.uBaseIndex;
+			const XMFLOAT4X4 m = multiply(occluder.World, viewProjection);
+
+			aScreenVertices.resize(mesh.uNumVertices);
+			for (UINT i = 0u; i < mesh.uNumVertices; ++i)
+			{
+				const XMFLOAT3& p = pPositions[i];
+				FLOAT x = p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41;
+				FLOAT y = p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42;
+				FLOAT z = p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43;
+				FLOAT w = p.x * m._14 + p.y * m._24 + p.z * m._34 + m._44;
+				if (z < 0.0f || w <= 0.0f)
+				{
+					aScreenVertices[i] = XMFLOAT4(0.0f, 0.0f, 0.0f, -1.0f);
+					continue;
+				}
+
+				FLOAT invW = 1.0f / w;
+				aScreenVertices[i] = XMFLOAT4(
+					(x * invW * 0.5f + 0.5f) * static_cast<FLOAT>(WIDTH),
+					(0.5f - y * invW * 0.5f) * static_cast<FLOAT>(HEIGHT),
+					invW,
+					1.0f
+				);
+			}
+
+			ScreenTriangle* pTriangles = m_aTriangles.data() + m_auTriangleOffsets[uOccluder];
+			for (UINT uTriangle = 0u; uTriangle < mesh.uNumIndices / 3u; ++uTriangle)
+			{
+				ScreenTriangle& triangle = pTriangles[uTriangle];
+				triangle.uMinTileRow = 1u;
+				triangle.uMaxTileRow = 0u;
+
+				FLOAT minY = FLT_MAX;
+				FLOAT maxY = -FLT_MAX;
+				FLOAT minX = FLT_MAX;
+				FLOAT maxX = -FLT_MAX;
+				BOOL bIsClipped = FALSE;
+				for (UINT uVertex = 0u; uVertex < 3u; ++uVertex)
+				{
+					const XMFLOAT4& vertex = aScreenVertices[pIndices[uTriangle * 3u + uVertex]];
+					bIsClipped |= vertex.w < 0.0f;
+					triangle.aVertices[uVertex] = XMFLOAT3(vertex.x, vertex.y, vertex.z);
+					minX = std::min(minX, vertex.x);
+					maxX = std::max(maxX, vertex.x);
+					minY = std::min(minY, vertex.y);
+					maxY = std::max(maxY, vertex.y);
+				}
+				if (bIsClipped)
+				{
+					continue;
+				}
+
+				INT iBeginX, iEndX, iBeginY, iEndY;
+				getPixelRange(iBeginX, iEndX, minX, maxX, WIDTH);
+				getPixelRange(iBeginY, iEndY, minY, maxY, HEIGHT);
+				if (iBeginX > iEndX || iBeginY > iEndY)
+				{
+					continue;
+				}
+
+				triangle.uMinTileRow = static_cast<UINT>(iBeginY) / TILE_SIZE;
+				triangle.uMaxTileRow = static_cast<UINT>(iEndY) / TILE_SIZE;
+			}
+		}
+	}
+
+	void OcclusionCuller::binTriangles()
+	{
+		std::fill(m_auBinOffsets.begin(), m_auBinOffsets.end(), 0u);
+
+		m_uNumRasterizedTriangles = 0u;
+		for (const ScreenTriangle& triangle : m_aTriangles)
+		{
+			for (UINT uTileRow = triangle.uMinTileRow; uTileRow <= triangle.uMaxTileRow; ++uTileRow)
+			{
+				++m_auBinOffsets[uTileRow + 1u];
+			}
+			m_uNumRasterizedTriangles += triangle.uMinTileRow <= triangle.uMaxTileRow;
+		}
+
+		for (UINT uTileRow = 0u; uTileRow < NUM_TILES_Y; ++uTileRow)
+		{
+			m_auBinOffsets[uTileRow + 1u] += m_auBinOffsets[uTileRow];
+		}
+
+		// Fill in submission order so the result does not depend on the job split
+		m_auBinnedTriangles.resize(m_auBinOffsets.back());
+		std::vector<UINT> auCursors(m_auBinOffsets.begin(), m_auBinOffsets.end() - 1);
+		for (UINT i = 0u; i < m_aTriangles.size(); ++i)
+		{
+			for (UINT uTileRow = m_aTriangles[i].uMinTileRow; uTileRow <= m_aTriangles[i].uMaxTileRow; ++uTileRow)
+			{
+				m_auBinnedTriangles[auCursors[uTileRow]++] = i;
+			}
+		}
+	}
+
+	void OcclusionCuller::rasterizeTileRow(_In_ UINT uTileRow) noexcept
+	{
+		FLOAT* pRows = m_aDepthBuffer.data() + static_cast<size_t>(uTileRow) * TILE_SIZE * WIDTH;
+		std::fill(pRows, pRows + TILE_SIZE * WIDTH, 0.0f);
+
+		for (UINT i = m_auBinOffsets[uTileRow]; i < m_auBinOffsets[uTileRow + 1u]; ++i)
+		{
+			rasterizeTriangle(m_aTriangles[m_auBinnedTriangles[i]], uTileRow);
+		}
+
+		// Farthest depth of every tile
+		for (UINT uTileX = 0u; uTileX < NUM_TILES_X; ++uTileX)
+		{
+			__m128 tileDepth = _mm_set1_ps(FLT_MAX);
+			for (UINT y = 0u; y < TILE_SIZE; ++y)
+			{
+				const FLOAT* pPixels = pRows + static_cast<size_t>(y) * WIDTH + uTileX * TILE_SIZE;
+				tileDepth = _mm_min_ps(tileDepth, _mm_min_ps(_mm_loadu_ps(pPixels), _mm_loadu_ps(pPixels + 4)));
+			}
+			tileDepth = _mm_min_ps(tileDepth, _mm_shuffle_ps(tileDepth, tileDepth, _MM_SHUFFLE(1, 0, 3, 2)));
+			tileDepth = _mm_min_ps(tileDepth, _mm_shuffle_ps(tileDepth, tileDepth, _MM_SHUFFLE(2, 3, 0, 1)));
+
+			m_aTileDepths[static_cast<size_t>(uTileRow) * NUM_TILES_X + uTileX] = _mm_cvtss_f32(tileDepth);
+		}
+	}
+
+	// Pixel centers are inside when all three edge functions are non negative. Triangles of either winding are
+	// rasterized since occluders are closed or double sided often enough that back faces still occlude.
+	void OcclusionCuller::rasterizeTriangle(_In_ const ScreenTriangle& triangle, _In_ UINT uTileRow) noexcept
+	{
+		XMFLOAT3 v0 = triangle.aVertices[0];
+		XMFLOAT3 v1 = triangle.aVertices[1];
+		XMFLOAT3 v2 = triangle.aVertices[2];
+
+		FLOAT area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+		if (area < 0.0f)
+		{
+			std::swap(v1, v2);
+			area = -area;
+		}
+		if (!(area > 0.0f))
+		{
+			return;
+		}
+
+		INT iBeginX, iEndX, iBeginY, iEndY;
+		getPixelRange(iBeginX, iEndX, std::min(v0.x, std::min(v1.x, v2.x)), std::max(v0.x, std::max(v1.x, v2.x)), WIDTH);
+		getPixelRange(iBeginY, iEndY, std::min(v0.y, std::min(v1.y, v2.y)), std::max(v0.y, std::max(v1.y, v2.y)), HEIGHT);
+		iBeginY = std::max(iBeginY, static_cast<INT>(uTileRow * TILE_SIZE));
+		iEndY = std::min(iEndY, static_cast<INT>((uTileRow + 1u) * TILE_SIZE) - 1);
+		if (iBeginX > iEndX || iBeginY > iEndY)
+		{
+			return;
+		}
+
+		// Edge (a, b) evaluated at p: (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x)
+		const XMFLOAT3* apOrigins[3] = { &v0, &v1, &v2 };
+		const XMFLOAT3* apTargets[3] = { &v1, &v2, &v0 };
+		__m128 aEdgeX[3];
+		__m128 aEdgeY[3];
+		__m128 aOriginX[3];
+		__m128 aOriginY[3];
+		for (UINT i = 0u; i < 3u; ++i)
+		{
+			aEdgeX[i] = _mm_set1_ps(apOrigins[i]->y - apTargets[i]->y);
+			aEdgeY[i] = _mm_set1_ps(apTargets[i]->x - apOrigins[i]->x);
+			aOriginX[i] = _mm_set1_ps(apOrigins[i]->x);
+			aOriginY[i] = _mm_set1_ps(apOrigins[i]->y);
+		}
+
+		FLOAT invArea = 1.0f / area;
+		const __m128 depthX = _mm_set1_ps(((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) * invArea);
+		const __m128 depthY = _mm_set1_ps(((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) * invArea);
+		const __m128 depthOriginX = _mm_set1_ps(v0.x);
+		const __m128 depthOriginY = _mm_set1_ps(v0.y);
+		const __m128 depthOrigin = _mm_set1_ps(v0.z);
+
+		const __m128 pixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+		INT iAlignedBeginX = iBeginX & ~3;
+		for (INT y = iBeginY; y <= iEndY; ++y)
+		{
+			FLOAT* pRow = m_aDepthBuffer.data() + static_cast<size_t>(y) * WIDTH;
+			__m128 pixelY = _mm_set1_ps(static_cast<FLOAT>(y) + 0.5f);
+
+			for (INT x = iAlignedBeginX; x <= iEndX; x += 4)
+			{
+				__m128 pixelX = _mm_add_ps(_mm_set1_ps(static_cast<FLOAT>(x)), pixelOffsets);
+
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (UINT i = 0u; i < 3u; ++i)
+				{
+					__m128 edge = _mm_add_ps(
+						_mm_mul_ps(aEdgeX[i], _mm_sub_ps(pixelX, aOriginX[i])),
+						_mm_mul_ps(aEdgeY[i], _mm_sub_ps(pixelY, aOriginY[i]))
+					);
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(edge, zero));
+				}
+				if (_mm_movemask_ps(inside) == 0)
+				{
+					continue;
+				}
+
+				__m128 depth = _mm_add_ps(
+					depthOrigin,
+					_mm_add_ps(_mm_mul_ps(depthX, _mm_sub_ps(pixelX, depthOriginX)), _mm_mul_ps(depthY, _mm_sub_ps(pixelY, depthOriginY)))
+				);
+
+				__m128 previous = _mm_loadu_ps(pRow + x);
+				__m128 nearest = _mm_max_ps(previous, depth);
+				_mm_storeu_ps(pRow + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+			}
+		}
+	}
+
+	// A box is hidden when its nearest corner lies behind the farthest depth of every tile its screen rectangle touches
+	void OcclusionCuller::testBounds(_In_ const XMFLOAT4X4& viewProjection, _In_ UINT uBegin, _In_ UINT uEnd) noexcept
+	{
+		const XMFLOAT4X4& m = viewProjection;
+		const __m128 signX = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+		const __m128 signY = _mm_setr_ps(-1.0f, -1.0f, 1.0f, 1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 width = _mm_set1_ps(static_cast<FLOAT>(WIDTH));
+		const __m128 height = _mm_set1_ps(static_cast<FLOAT>(HEIGHT));
+		const __m128 zero = _mm_setzero_ps();
+
+		for (UINT uObject = uBegin; uObject < uEnd; ++uObject)
+		{
+			const MeshBounds& bounds = m_aBounds[uObject];
+
+			__m128 cornerX = _mm_add_ps(_mm_set1_ps(bounds.Center.x), _mm_mul_ps(signX, _mm_set1_ps(bounds.Extents.x)));
+			__m128 cornerY = _mm_add_ps(_mm_set1_ps(bounds.Center.y), _mm_mul_ps(signY, _mm_set1_ps(bounds.Extents.y)));
+
+			__m128 minX = _mm_set1_ps(FLT_MAX);
+			__m128 maxX = _mm_set1_ps(-FLT_MAX);
+			__m128 minY = _mm_set1_ps(FLT_MAX);
+			__m128 maxY = _mm_set1_ps(-FLT_MAX);
+			__m128 maxDepth = zero;
+			BOOL bIsClipped = FALSE;
+			for (FLOAT signZ : { -1.0f, 1.0f })
+			{
+				__m128 cornerZ = _mm_set1_ps(bounds.Center.z + signZ * bounds.Extents.z);
+
+				__m128 clipX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cornerX, _mm_set1_ps(m._11)), _mm_mul_ps(cornerY, _mm_set1_ps(m._21))), _mm_add_ps(_mm_mul_ps(cornerZ, _mm_set1_ps(m._31)), _mm_set1_ps(m._41)));
+				__m128 clipY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cornerX, _mm_set1_ps(m._12)), _mm_mul_ps(cornerY, _mm_set1_ps(m._22))), _mm_add_ps(_mm_mul_ps(cornerZ, _mm_set1_ps(m._32)), _mm_set1_ps(m._42)));
+				__m128 clipZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cornerX, _mm_set1_ps(m._13)), _mm_mul_ps(cornerY, _mm_set1_ps(m._23))), _mm_add_ps(_mm_mul_ps(cornerZ, _mm_set1_ps(m._33)), _mm_set1_ps(m._43)));
+				__m128 clipW = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cornerX, _mm_set1_ps(m._14)), _mm_mul_ps(cornerY, _mm_set1_ps(m._24))), _mm_add_ps(_mm_mul_ps(cornerZ, _mm_set1_ps(m._34)), _mm_set1_ps(m._44)));
+
+				if (_mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(clipZ, zero), _mm_cmple_ps(clipW, zero))) != 0)
+				{
+					bIsClipped = TRUE;
+					break;
+				}
+
+				__m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), clipW);
+				__m128 screenX = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(clipX, invW), half), half), width);
+				__m128 screenY = _mm_mul_ps(_mm_sub_ps(half, _mm_mul_ps(_mm_mul_ps(clipY, invW), half)), height);
+
+				minX = _mm_min_ps(minX, screenX);
+				maxX = _mm_max_ps(maxX, screenX);
+				minY = _mm_min_ps(minY, screenY);
+				maxY = _mm_max_ps(maxY, screenY);
+				maxDepth = _mm_max_ps(maxDepth, invW);
+			}
+			if (bIsClipped)
+			{
+				continue;
+			}
+
+			alignas(16) FLOAT aMinX[4], aMaxX[4], aMinY[4], aMaxY[4], aMaxDepth[4];
+			_mm_store_ps(aMinX, minX);
+			_mm_store_ps(aMaxX, maxX);
+			_mm_store_ps(aMinY, minY);
+			_mm_store_ps(aMaxY, maxY);
+			_mm_store_ps(aMaxDepth, maxDepth);
+			FLOAT rectMinX = std::min(std::min(aMinX[0], aMinX[1]), std::min(aMinX[2], aMinX[3]));
+			FLOAT rectMaxX = std::max(std::max(aMaxX[0], aMaxX[1]), std::max(aMaxX[2], aMaxX[3]));
+			FLOAT rectMinY = std::min(std::min(aMinY[0], aMinY[1]), std::min(aMinY[2], aMinY[3]));
+			FLOAT rectMaxY = std::max(std::max(aMaxY[0], aMaxY[1]), std::max(aMaxY[2], aMaxY[3]));
+			FLOAT boxDepth = std::max(std::max(aMaxDepth[0], aMaxDepth[1]), std::max(aMaxDepth[2], aMaxDepth[3]));
+
+			if (rectMaxX < 0.0f || rectMaxY < 0.0f || rectMinX >= static_cast<FLOAT>(WIDTH) || rectMinY >= static_cast<FLOAT>(HEIGHT))
+			{
+				continue;
+			}
+
+			UINT uBeginTileX = static_cast<UINT>(std::max(rectMinX, 0.0f)) / TILE_SIZE;
+			UINT uEndTileX = static_cast<UINT>(std::min(rectMaxX, static_cast<FLOAT>(WIDTH - 1u))) / TILE_SIZE;
+			UINT uBeginTileY = static_cast<UINT>(std::max(rectMinY, 0.0f)) / TILE_SIZE;
+			UINT uEndTileY = static_cast<UINT>(std::min(rectMaxY, static_cast<FLOAT>(HEIGHT - 1u))) / TILE_SIZE;
+
+			const __m128 boxDepths = _mm_set1_ps(boxDepth);
+			BOOL bIsVisible = FALSE;
+			for (UINT uTileY = uBeginTileY; uTileY <= uEndTileY && !bIsVisible; ++uTileY)
+			{
+				const FLOAT* pTiles = m_aTileDepths.data() + static_cast<size_t>(uTileY) * NUM_TILES_X;
+				UINT uTileX = uBeginTileX;
+				for (; uTileX + 4u <= uEndTileX + 1u; uTileX += 4u)
+				{
+					if (_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(pTiles + uTileX), boxDepths)) != 0)
+					{
+						bIsVisible = TRUE;
+						break;
+					}
+				}
+				for (; uTileX <= uEndTileX && !bIsVisible; ++uTileX)
+				{
+					bIsVisible = pTiles[uTileX] <= boxDepth;
+				}
+			}
+
+			m_abVisible[uObject] = static_cast<BYTE>(bIsVisible);
+		}
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/Bounds.h"
+
+namespace pr
+{
+	class JobSystem;
+
+	// Positions and triangle lists of a renderable kept on the CPU so it can be rasterized as an occluder.
+	// Indices are relative to the base vertex of their mesh.
+	struct OccluderGeometry
+	{
+		struct Mesh
+		{
+			UINT uBaseVertex;
+			UINT uNumVertices;
+			UINT uBaseIndex;
+			UINT uNumIndices;
+		};
+
+		std::vector<XMFLOAT3> aPositions;
+		std::vector<WORD> aIndices;
+		std::vector<Mesh> aMeshes;
+	};
+
+	// Rasterizes the occluders into a low resolution buffer of 1 / w on the CPU, keeps the farthest value of every
+	// tile and rejects boxes whose nearest point lies behind all tiles they cover. Each job owns one row of tiles,
+	// so the rasterizer writes without synchronization; rows are filled 4 pixels at a time with SSE.
+	// Triangles crossing the near plane are dropped and boxes crossing it are kept, both only lose culling.
+	class OcclusionCuller final
+	{
+	public:
+		static constexpr const UINT WIDTH = 320u;
+		static constexpr const UINT HEIGHT = 192u;
+		static constexpr const UINT TILE_SIZE = 8u;
+		static constexpr const UINT NUM_TILES_X = WIDTH / TILE_SIZE;
+		static constexpr const UINT NUM_TILES_Y = HEIGHT / TILE_SIZE;
+
+		struct Stats
+		{
+			UINT uNumOccluders;
+			UINT uNumOccluderTriangles;
+			UINT uNumRasterizedTriangles;
+			UINT uNumObjects;
+			UINT uNumOccluded;
+		};
+
+	public:
+		explicit OcclusionCuller() noexcept;
+		OcclusionCuller(const OcclusionCuller& other) = delete;
+		OcclusionCuller(OcclusionCuller&& other) = delete;
+		OcclusionCuller& operator=(const OcclusionCuller& other) = delete;
+		OcclusionCuller& operator=(OcclusionCuller&& other) = delete;
+		~OcclusionCuller() noexcept = default;
+
+		void Reset() noexcept;
+
+		// The geometry is referenced, not copied, and has to stay alive until Cull returns
+		void AddOccluder(_In_ const OccluderGeometry& geometry, _In_ UINT uMesh, _In_ const XMFLOAT4X4& world);
+		UINT AddBounds(_In_ const MeshBounds& worldBounds);
+
+		void Cull(_In_ const XMFLOAT4X4& viewProjection, _In_ JobSystem& jobSystem);
+
+		BOOL IsVisible(_In_ UINT uIndex) const noexcept;
+		UINT GetNumObjects() const noexcept;
+		UINT GetNumVisible() const noexcept;
+		Stats GetStats() const noexcept;
+
+		// Writes the depth buffer of the last Cull as a binary PGM, nearer is brighter
+		HRESULT DumpDepthBuffer(_In_ const std::filesystem::path& filePath) const;
+
+	private:
+		struct Occluder
+		{
+			const OccluderGeometry* pGeometry;
+			UINT uMesh;
+			XMFLOAT4X4 World;
+		};
+
+		// x and y in pixels, z is 1 / w
+		struct ScreenTriangle
+		{
+			XMFLOAT3 aVertices[3];
+			UINT uMinTileRow;
+			UINT uMaxTileRow;
+		};
+
+	private:
+		void transformOccluders(_In_ const XMFLOAT4X4& viewProjection, _In_ UINT uBegin, _In_ UINT uEnd) noexcept;
+		void binTriangles();
+		void rasterizeTileRow(_In_ UINT uTileRow) noexcept;
+		void rasterizeTriangle(_In_ const ScreenTriangle& triangle, _In_ UINT uTileRow) noexcept;
+		void testBounds(_In_ const XMFLOAT4X4& viewProjection, _In_ UINT uBegin, _In_ UINT uEnd) noexcept;
+
+	private:
+		std::vector<Occluder> m_aOccluders;
+		std::vector<UINT> m_auTriangleOffsets;
+		std::vector<ScreenTriangle> m_aTriangles;
+		std::vector<UINT> m_auBinOffsets;
+		std::vector<UINT> m_auBinnedTriangles;
+		std::vector<MeshBounds> m_aBounds;
+		std::vector<BYTE> m_abVisible;
+		std::vector<FLOAT> m_aDepthBuffer;
+		std::vector<FLOAT> m_aTileDepths;
+		UINT m_uNumVisible;
+		UINT m_uNumRasterizedTriangles;
+	};
+}
@@ -0,0 +1,105 @@
+#include "Graphics/PipelineCacheFile.h"
+
+#include <cstring>
+
+#include "Utility/Hash.h"
+#include "Utility/Math.h"
+
+namespace pr
+{
+	namespace PipelineCacheFile
+	{
+		void Write(_Out_ std::vector<BYTE>& aOutData, _In_ const std::vector<Blob>& aBlobs)
+		{
+			size_t uOffset = sizeof(Header) + sizeof(Entry) * aBlobs.size();
+
+			std::vector<Entry> aEntries;
+			aEntries.reserve(aBlobs.size());
+			for (const Blob& blob : aBlobs)
+			{
+				uOffset = AlignUp(uOffset, BLOB_ALIGNMENT);
+				aEntries.push_back(
+					Entry
+					{
+						.uKey = blob.uKey,
+						.uOffset = uOffset,
+						.uSize = blob.uSize,
+					}
+				);
+				uOffset += blob.uSize;
+			}
+
+			aOutData.assign(uOffset, 0u);
+			if (!aEntries.empty())
+			{
+				memcpy(aOutData.data() + sizeof(Header), aEntries.data(), sizeof(Entry) * aEntries.size());
+			}
+			for (size_t i = 0; i < aBlobs.size(); ++i)
+			{
+				memcpy(aOutData.data() + aEntries[i].uOffset, aBlobs[i].pData, aBlobs[i].uSize);
+			}
+
+			Header header =
+			{
+				.uMagic = MAGIC,
+				.uVersion = VERSION,
+				.uNumEntries = static_cast<UINT>(aBlobs.size()),
+				.uReserved = 0u,
+				.uChecksum = HashBytes(aOutData.data() + sizeof(Header), aOutData.size() - sizeof(Header)),
+			};
+			memcpy(aOutData.data(), &header, sizeof(Header));
+		}
+
+		HRESULT Read(_Out_ std::vector<Blob>& aOutBlobs, _In_reads_bytes_(uSize) const BYTE* pData, _In_ size_t uSize)
+		{
+			aOutBlobs.clear();
+
+			Header header;
+			if (!pData || uSize < sizeof(Header))
+			{
+				return E_FAIL;
+			}
+			memcpy(&header, pData, sizeof(Header));
+
+			if (header.uMagic != MAGIC || header.uVersion != VERSION)
+			{
+				return E_FAIL;
+			}
+
+			if (header.uNumEntries > (uSize - sizeof(Header)) / sizeof(Entry))
+			{
+				return E_FAIL;
+			}
+
+			if (HashBytes(pData + sizeof(Header), uSize - sizeof(Header)) != header.uChecksum)
+			{
+				return E_FAIL;
+			}
+
+			size_t uBlobsBegin = sizeof(Header) + sizeof(Entry) * header.uNumEntries;
+			aOutBlobs.reserve(header.uNumEntries);
+			for (UINT i = 0u; i < header.uNumEntries; ++i)
+			{
+				Entry entry;
+				memcpy(&entry, pData + sizeof(Header) + sizeof(Entry) * i, sizeof(Entry));
+
+				if (entry.uOffset < uBlobsBegin || entry.uOffset > uSize || entry.uSize > uSize - entry.uOffset)
+				{
+					aOutBlobs.clear();
+					return E_FAIL;
+				}
+
+				aOutBlobs.push_back(
+					Blob
+					{
+						.uKey = entry.uKey,
+						.pData = pData + entry.uOffset,
+						.uSize = static_cast<size_t>(entry.uSize),
+					}
+				);
+			}
+
+			return S_OK;
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include "Utility/Types.h"
+
+namespace pr
+{
+	// On disk layout of the pipeline cache, all values little endian:
+	//   Header, Entry[uNumEntries], blobs each aligned to BLOB_ALIGNMENT
+	// The checksum covers everything after the header, a file that fails any check is ignored as a whole.
+	namespace PipelineCacheFile
+	{
+		constexpr const UINT MAGIC = 0x43505250;	// "PRPC"
+		constexpr const UINT VERSION = 1u;
+		constexpr const UINT BLOB_ALIGNMENT = 16u;
+
+		struct Header
+		{
+			UINT uMagic;
+			UINT uVersion;
+			UINT uNumEntries;
+			UINT uReserved;
+			UINT64 uChecksum;
+		};
+		static_assert(sizeof(Header) == 24);
+
+		struct Entry
+		{
+			UINT64 uKey;
+			UINT64 uOffset;
+			UINT64 uSize;
+		};
+		static_assert(sizeof(Entry) == 24);
+
+		struct Blob
+		{
+			UINT64 uKey;
+			const BYTE* pData;
+			size_t uSize;
+		};
+
+		void Write(_Out_ std::vector<BYTE>& aOutData, _In_ const std::vector<Blob>& aBlobs);
+
+		// The blobs point into pData
+		HRESULT Read(_Out_ std::vector<Blob>& aOutBlobs, _In_reads_bytes_(uSize) const BYTE* pData, _In_ size_t uSize);
+	}
+}
@@ -0,0 +1,339 @@
+#include "pch.h"
+
+#include "Graphics/PipelineStateCache.h"
+
+#include "Graphics/PipelineCacheFile.h"
+#include "Utility/JobSystem.h"
+#include "Utility/Profiler.h"
+#include "Utility/Utility.h"
+
+#include <fstream>
+#include <thread>
+
+namespace pr
+{
+	PipelineStateCache::PipelineStateCache() noexcept
+		: m_pDevice()
+		, m_FilePath()
+		, m_Entries()
+		, m_CachedBlobs()
+		, m_Mutex()
+		, m_uNumPending(0u)
+		, m_uNumLoadedFromDisk(0u)
+		, m_uNumCompiled(0u)
+		, m_uNumFallbacks(0u)
+		, m_bIsDirty(FALSE)
+	{
+	}
+
+	PipelineStateCache::~PipelineStateCache() noexcept
+	{
+		// Background compiles reference this cache
+		while (m_uNumPending.load(std::memory_order_acquire) > 0u)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	HRESULT PipelineStateCache::Initialize(_In_ ID3D12Device2* pDevice, _In_ const std::filesystem::path& filePath)
+	{
+		PR_PROFILE_FUNCTION();
+
+		m_pDevice = pDevice;
+		m_FilePath = filePath;
+
+		std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+		if (!file)
+		{
+			return S_OK;
+		}
+
+		std::vector<BYTE> aData(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<CHAR*>(aData.data()), static_cast<std::streamsize>(aData.size()));
+
+		std::vector<PipelineCacheFile::Blob> aBlobs;
+		if (!file || FAILED(PipelineCacheFile::Read(aBlobs, aData.data(), aData.size())))
+		{
+			OutputDebugString(L"PipelineStateCache::Initialize >> Ignoring invalid pipeline cache file\n");
+			return S_OK;
+		}
+
+		for (const PipelineCacheFile::Blob& blob : aBlobs)
+		{
+			m_CachedBlobs.emplace(blob.uKey, std::vector<BYTE>(blob.pData, blob.pData + blob.uSize));
+		}
+
+		return S_OK;
+	}
+
+	HRESULT PipelineStateCache::Request(_Out_ UINT64& uOutKey, _In_ const GraphicsPipelineDesc& desc, _In_ ID3D12RootSignature* pRootSignature, _In_ BOOL bWait)
+	{
+		PR_PROFILE_FUNCTION();
+
+		HRESULT hr = S_OK;
+
+		auto pDesc = std::make_shared<const CanonicalPipelineDesc>(desc);
+		uOutKey = pDesc->GetHash();
+
+		BOOL bIsNew = FALSE;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			auto [iter, bIsInserted] = m_Entries.try_emplace(
+				uOutKey,
+				Entry
+				{
+					.pDesc = pDesc,
+					.pRootSignature = pRootSignature,
+					.pPipelineState = nullptr,
+					.bIsPending = TRUE,
+				}
+			);
+			bIsNew = bIsInserted;
+		}
+
+		if (bIsNew)
+		{
+			m_uNumPending.fetch_add(1u, std::memory_order_relaxed);
+			if (bWait)
+			{
+				hr = createPipelineState(uOutKey, *pDesc, pRootSignature);
+				CHECK_AND_RETURN_HRESULT(hr, L"PipelineStateCache::Request >> Creating pipeline state");
+			}
+			else
+			{
+				ComPtr<ID3D12RootSignature> pRootSignatureReference(pRootSignature);
+				UINT64 uKey = uOutKey;
+				JobSystem::GetInstance().Schedule(
+					[this, uKey, pDesc, pRootSignatureReference]()
+					{
+						HRESULT hr = createPipelineState(uKey, *pDesc, pRootSignatureReference.Get());
+						AssertHresult(hr, L"PipelineStateCache::Request >> Creating pipeline state in the background");
+					}
+				);
+			}
+		}
+		else if (bWait)
+		{
+			// Another request already scheduled it
+			for (;;)
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					if (!m_Entries[uOutKey].bIsPending)
+					{
+						break;
+					}
+				}
+				std::this_thread::yield();
+			}
+		}
+
+		return hr;
+	}
+
+	ID3D12PipelineState* PipelineStateCache::GetPipelineState(_In_ UINT64 uKey, _In_opt_ ID3D12PipelineState* pFallback)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto iter = m_Entries.find(uKey);
+		if (iter == m_Entries.end() || !iter->second.pPipelineState)
+		{
+			++m_uNumFallbacks;
+			return pFallback;
+		}
+
+		return iter->second.pPipelineState.Get();
+	}
+
+	HRESULT PipelineStateCache::Save()
+	{
+		PR_PROFILE_FUNCTION();
+
+		HRESULT hr = S_OK;
+
+		std::vector<ComPtr<ID3DBlob>> apBlobs;
+		std::vector<PipelineCacheFile::Blob> aBlobs;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (!m_bIsDirty)
+			{
+				return hr;
+			}
+
+			for (const auto& [uKey, entry] : m_Entries)
+			{
+				if (!entry.pPipelineState)
+				{
+					continue;
+				}
+
+				ComPtr<ID3DBlob> pBlob;
+				hr = entry.pPipelineState->GetCachedBlob(&pBlob);
+				CHECK_AND_RETURN_HRESULT(hr, L"PipelineStateCache::Save >> Getting cached blob");
+
+				aBlobs.push_back(
+					PipelineCacheFile::Blob
+					{
+						.uKey = uKey,
+						.pData = static_cast<const BYTE*>(pBlob->GetBufferPointer()),
+						.uSize = pBlob->GetBufferSize(),
+					}
+				);
+				apBlobs.push_back(std::move(pBlob));
+			}
+			m_bIsDirty = FALSE;
+		}
+
+		std::vector<BYTE> aData;
+		PipelineCacheFile::Write(aData, aBlobs);
+
+		std::ofstream file(m_FilePath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const CHAR*>(aData.data()), static_cast<std::streamsize>(aData.size()));
+		if (!file)
+		{
+			hr = E_FAIL;
+			CHECK_AND_RETURN_HRESULT(hr, L"PipelineStateCache::Save >> Writing pipeline cache file");
+		}
+
+		return hr;
+	}
+
+	PipelineStateCache::Stats PipelineStateCache::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		return Stats
+		{
+			.uNumPipelines = static_cast<UINT>(m_Entries.size()),
+			.uNumPending = m_uNumPending.load(std::memory_order_relaxed),
+			.uNumLoadedFromDisk = m_uNumLoadedFromDisk,
+			.uNumCompiled = m_uNumCompiled,
+			.uNumFallbacks = m_uNumFallbacks,
+		};
+	}
+
+	HRESULT PipelineStateCache::createPipelineState(_In_ UINT64 uKey, _In_ const CanonicalPipelineDesc& desc, _In_ ID3D12RootSignature* pRootSignature)
+	{
+		PR_PROFILE_FUNCTION();
+
+		HRESULT hr = S_OK;
+
+		const GraphicsPipelineDesc& pipelineDesc = desc.GetDesc();
+
+		struct PipelineStateStream
+		{
+			CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE pRootSignature;
+			CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT InputLayout;
+			CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY PrimitiveTopologyType;
+			CD3DX12_PIPELINE_STATE_STREAM_VS VertexShader;
+			CD3DX12_PIPELINE_STATE_STREAM_PS PixelShader;
+			CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER Rasterizer;
+			CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL DepthStencil;
+			CD3DX12_PIPELINE_STATE_STREAM_BLEND_DESC Blend;
+			CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT DsvFormat;
+			CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS RtvFormats;
+			CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_DESC SampleDesc;
+			CD3DX12_PIPELINE_STATE_STREAM_CACHED_PSO CachedPso;
+		};
+
+		CD3DX12_RASTERIZER_DESC rasterizerDesc(D3D12_DEFAULT);
+		rasterizerDesc.FillMode = pipelineDesc.FillMode;
+		rasterizerDesc.CullMode = pipelineDesc.CullMode;
+
+		CD3DX12_DEPTH_STENCIL_DESC depthStencilDesc(D3D12_DEFAULT);
+		depthStencilDesc.DepthEnable = pipelineDesc.bIsDepthEnabled;
+		depthStencilDesc.DepthWriteMask = pipelineDesc.bIsDepthWriteEnabled ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
+		depthStencilDesc.DepthFunc = pipelineDesc.DepthFunc;
+
+		CD3DX12_BLEND_DESC blendDesc(D3D12_DEFAULT);
+		if (pipelineDesc.bIsBlendEnabled)
+		{
+			for (UINT i = 0u; i < pipelineDesc.uNumRenderTargets; ++i)
+			{
+				D3D12_RENDER_TARGET_BLEND_DESC& renderTargetBlendDesc = blendDesc.RenderTarget[i];
+				renderTargetBlendDesc.BlendEnable = TRUE;
+				renderTargetBlendDesc.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+				renderTargetBlendDesc.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+				renderTargetBlendDesc.BlendOp = D3D12_BLEND_OP_ADD;
+				renderTargetBlendDesc.SrcBlendAlpha = D3D12_BLEND_ONE;
+				renderTargetBlendDesc.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+				renderTargetBlendDesc.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+			}
+		}
+
+		D3D12_RT_FORMAT_ARRAY rtvFormats =
+		{
+			.NumRenderTargets = pipelineDesc.uNumRenderTargets,
+		};
+		memcpy(rtvFormats.RTFormats, pipelineDesc.aRtvFormats, sizeof(rtvFormats.RTFormats));
+
+		D3D12_CACHED_PIPELINE_STATE cachedPipelineState = {};
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			auto iter = m_CachedBlobs.find(uKey);
+			if (iter != m_CachedBlobs.end())
+			{
+				cachedPipelineState.pCachedBlob = iter->second.data();
+				cachedPipelineState.CachedBlobSizeInBytes = iter->second.size();
+			}
+		}
+
+		PipelineStateStream pipelineStateStream =
+		{
+			.pRootSignature = pRootSignature,
+			.InputLayout = D3D12_INPUT_LAYOUT_DESC{ .pInputElementDescs = pipelineDesc.pInputElementDescs, .NumElements = pipelineDesc.uNumInputElements },
+			.PrimitiveTopologyType = pipelineDesc.PrimitiveTopologyType,
+			.VertexShader = pipelineDesc.VertexShader,
+			.PixelShader = pipelineDesc.PixelShader,
+			.Rasterizer = rasterizerDesc,
+			.DepthStencil = depthStencilDesc,
+			.Blend = blendDesc,
+			.DsvFormat = pipelineDesc.DsvFormat,
+			.RtvFormats = rtvFormats,
+			.SampleDesc = DXGI_SAMPLE_DESC{ .Count = pipelineDesc.uSampleCount, .Quality = 0u },
+			.CachedPso = cachedPipelineState,
+		};
+
+		D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc =
+		{
+			.SizeInBytes = sizeof(PipelineStateStream),
+			.pPipelineStateSubobjectStream = &pipelineStateStream
+		};
+
+		ComPtr<ID3D12PipelineState> pPipelineState;
+		hr = m_pDevice->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&pPipelineState));
+		BOOL bIsLoadedFromDisk = SUCCEEDED(hr) && cachedPipelineState.pCachedBlob;
+		if (FAILED(hr) && cachedPipelineState.pCachedBlob)
+		{
+			// The blob belongs to another driver or adapter, compile from the bytecode instead
+			pipelineStateStream.CachedPso = D3D12_CACHED_PIPELINE_STATE{};
+			hr = m_pDevice->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&pPipelineState));
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			Entry& entry = m_Entries[uKey];
+			entry.pPipelineState = pPipelineState;
+			entry.bIsPending = FALSE;
+
+			if (SUCCEEDED(hr))
+			{
+				if (bIsLoadedFromDisk)
+				{
+					++m_uNumLoadedFromDisk;
+				}
+				else
+				{
+					++m_uNumCompiled;
+					m_bIsDirty = TRUE;
+				}
+			}
+		}
+		m_uNumPending.fetch_sub(1u, std::memory_order_release);
+
+		CHECK_AND_RETURN_HRESULT(hr, L"PipelineStateCache::createPipelineState >> Creating pipeline state");
+
+		return hr;
+	}
+}
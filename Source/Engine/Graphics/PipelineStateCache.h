@@ -0,0 +1,73 @@
+#pragma once
+
+#include "pch.h"
+
+#include <atomic>
+
+#include "Graphics/PipelineStateDesc.h"
+
+namespace pr
+{
+	// Pipeline states keyed by the hash of their canonical description. Missing pipelines compile on the job
+	// system's background queue while callers draw with a fallback, and the driver's cached blobs are persisted
+	// so the next run only has to validate them.
+	class PipelineStateCache final
+	{
+	public:
+		struct Stats
+		{
+			UINT uNumPipelines;
+			UINT uNumPending;
+			UINT uNumLoadedFromDisk;
+			UINT uNumCompiled;
+			UINT uNumFallbacks;
+		};
+
+	public:
+		explicit PipelineStateCache() noexcept;
+		PipelineStateCache(const PipelineStateCache& other) = delete;
+		PipelineStateCache(PipelineStateCache&& other) = delete;
+		PipelineStateCache& operator=(const PipelineStateCache& other) = delete;
+		PipelineStateCache& operator=(PipelineStateCache&& other) = delete;
+		~PipelineStateCache() noexcept;
+
+		// Loads the cached blobs, a missing or invalid file only means everything compiles from scratch
+		HRESULT Initialize(_In_ ID3D12Device2* pDevice, _In_ const std::filesystem::path& filePath);
+
+		// Returns the key of the pipeline and starts creating it if it is new. With bWait the pipeline is ready on return.
+		// The shader bytecode of desc is referenced, not copied, and has to outlive the cache.
+		HRESULT Request(_Out_ UINT64& uOutKey, _In_ const GraphicsPipelineDesc& desc, _In_ ID3D12RootSignature* pRootSignature, _In_ BOOL bWait);
+
+		// Returns pFallback until the pipeline is ready
+		ID3D12PipelineState* GetPipelineState(_In_ UINT64 uKey, _In_opt_ ID3D12PipelineState* pFallback);
+
+		// Writes the blobs of all ready pipelines if any were created since the file was loaded
+		HRESULT Save();
+
+		Stats GetStats();
+
+	private:
+		struct Entry
+		{
+			std::shared_ptr<const CanonicalPipelineDesc> pDesc;
+			ComPtr<ID3D12RootSignature> pRootSignature;
+			ComPtr<ID3D12PipelineState> pPipelineState;
+			BOOL bIsPending;
+		};
+
+	private:
+		HRESULT createPipelineState(_In_ UINT64 uKey, _In_ const CanonicalPipelineDesc& desc, _In_ ID3D12RootSignature* pRootSignature);
+
+	private:
+		ComPtr<ID3D12Device2> m_pDevice;
+		std::filesystem::path m_FilePath;
+		std::unordered_map<UINT64, Entry> m_Entries;
+		std::unordered_map<UINT64, std::vector<BYTE>> m_CachedBlobs;
+		std::mutex m_Mutex;
+		std::atomic<UINT> m_uNumPending;
+		UINT m_uNumLoadedFromDisk;
+		UINT m_uNumCompiled;
+		UINT m_uNumFallbacks;
+		BOOL m_bIsDirty;
+	};
+}
@@ -0,0 +1,254 @@
+// Built without the precompiled header, the Windows headers that <d3d12.h> includes must not define min and max
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include "Graphics/PipelineStateDesc.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "Utility/Hash.h"
+
+namespace pr
+{
+	CanonicalPipelineDesc::CanonicalPipelineDesc(_In_ const GraphicsPipelineDesc& desc)
+		: m_Desc()
+		, m_aSemanticNames()
+		, m_aInputElementDescs()
+		, m_uRootSignatureHash(0u)
+		, m_uHash(0u)
+	{
+		canonicalize(desc);
+		m_uHash = computeHash();
+	}
+
+	const GraphicsPipelineDesc& CanonicalPipelineDesc::GetDesc() const noexcept
+	{
+		return m_Desc;
+	}
+
+	UINT64 CanonicalPipelineDesc::GetHash() const noexcept
+	{
+		return m_uHash;
+	}
+
+	void CanonicalPipelineDesc::canonicalize(_In_ const GraphicsPipelineDesc& desc)
+	{
+		m_Desc = desc;
+		if (!m_Desc.VertexShader.pShaderBytecode)
+		{
+			m_Desc.VertexShader.BytecodeLength = 0u;
+		}
+		if (!m_Desc.PixelShader.pShaderBytecode)
+		{
+			m_Desc.PixelShader.BytecodeLength = 0u;
+		}
+
+		m_uRootSignatureHash = desc.pRootSignatureBlob ? HashBytes(desc.pRootSignatureBlob, desc.uRootSignatureBlobSize) : 0u;
+		m_Desc.pRootSignatureBlob = nullptr;
+		m_Desc.uRootSignatureBlobSize = 0u;
+
+		// Semantics are case insensitive in HLSL
+		m_aInputElementDescs.assign(desc.pInputElementDescs, desc.pInputElementDescs + desc.uNumInputElements);
+		m_aSemanticNames.resize(m_aInputElementDescs.size());
+		for (size_t i = 0; i < m_aInputElementDescs.size(); ++i)
+		{
+			m_aSemanticNames[i] = m_aInputElementDescs[i].SemanticName;
+			std::transform(
+				m_aSemanticNames[i].begin(),
+				m_aSemanticNames[i].end(),
+				m_aSemanticNames[i].begin(),
+				[](CHAR c) { return static_cast<CHAR>(toupper(static_cast<unsigned char>(c))); }
+			);
+
+			if (m_aInputElementDescs[i].InputSlotClass == D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA)
+			{
+				m_aInputElementDescs[i].InstanceDataStepRate = 0u;
+			}
+		}
+
+		// Resolve appended offsets per input slot, the elements can only be reordered once all of them are explicit
+		BOOL bAreOffsetsResolved = TRUE;
+		UINT auSlotOffsets[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
+		for (D3D12_INPUT_ELEMENT_DESC& element : m_aInputElementDescs)
+		{
+			UINT uSize = GetVertexFormatSize(element.Format);
+			if (element.InputSlot >= D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT)
+			{
+				bAreOffsetsResolved = FALSE;
+				continue;
+			}
+
+			UINT& uSlotOffset = auSlotOffsets[element.InputSlot];
+			if (element.AlignedByteOffset == D3D12_APPEND_ALIGNED_ELEMENT)
+			{
+				if (uSize == 0u || uSlotOffset == D3D12_APPEND_ALIGNED_ELEMENT)
+				{
+					bAreOffsetsResolved = FALSE;
+					uSlotOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+					continue;
+				}
+
+				UINT uAlignment = std::min(uSize, 4u);
+				element.AlignedByteOffset = (uSlotOffset + uAlignment - 1u) / uAlignment * uAlignment;
+			}
+
+			uSlotOffset = uSize == 0u ? static_cast<UINT>(D3D12_APPEND_ALIGNED_ELEMENT) : element.AlignedByteOffset + uSize;
+		}
+
+		std::vector<UINT> auOrder(m_aInputElementDescs.size());
+		for (UINT i = 0u; i < auOrder.size(); ++i)
+		{
+			auOrder[i] = i;
+		}
+		if (bAreOffsetsResolved)
+		{
+			std::stable_sort(
+				auOrder.begin(),
+				auOrder.end(),
+				[this](UINT uLeft, UINT uRight)
+				{
+					const D3D12_INPUT_ELEMENT_DESC& left = m_aInputElementDescs[uLeft];
+					const D3D12_INPUT_ELEMENT_DESC& right = m_aInputElementDescs[uRight];
+					return left.InputSlot != right.InputSlot ? left.InputSlot < right.InputSlot : left.AlignedByteOffset < right.AlignedByteOffset;
+				}
+			);
+		}
+
+		std::vector<D3D12_INPUT_ELEMENT_DESC> aSortedElementDescs(m_aInputElementDescs.size());
+		std::vector<std::string> aSortedSemanticNames(m_aSemanticNames.size());
+		for (size_t i = 0; i < auOrder.size(); ++i)
+		{
+			aSortedElementDescs[i] = m_aInputElementDescs[auOrder[i]];
+			aSortedSemanticNames[i] = std::move(m_aSemanticNames[auOrder[i]]);
+		}
+		m_aInputElementDescs = std::move(aSortedElementDescs);
+		m_aSemanticNames = std::move(aSortedSemanticNames);
+		for (size_t i = 0; i < m_aInputElementDescs.size(); ++i)
+		{
+			m_aInputElementDescs[i].SemanticName = m_aSemanticNames[i].c_str();
+		}
+		m_Desc.pInputElementDescs = m_aInputElementDescs.data();
+		m_Desc.uNumInputElements = static_cast<UINT>(m_aInputElementDescs.size());
+
+		// Depth state does not matter without a depth test
+		if (!m_Desc.bIsDepthEnabled)
+		{
+			m_Desc.bIsDepthWriteEnabled = FALSE;
+			m_Desc.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+		}
+
+		m_Desc.uNumRenderTargets = std::min(m_Desc.uNumRenderTargets, static_cast<UINT>(D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT));
+		for (UINT i = m_Desc.uNumRenderTargets; i < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
+		{
+			m_Desc.aRtvFormats[i] = DXGI_FORMAT_UNKNOWN;
+		}
+
+		m_Desc.uSampleCount = std::max(m_Desc.uSampleCount, 1u);
+	}
+
+	UINT64 CanonicalPipelineDesc::computeHash() const
+	{
+		// Fields are written one by one with fixed widths so padding and pointers never reach the hash
+		std::vector<BYTE> aBytes;
+		auto write = [&aBytes](UINT64 uValue)
+		{
+			for (UINT i = 0u; i < sizeof(UINT64); ++i)
+			{
+				aBytes.push_back(static_cast<BYTE>(uValue >> (8u * i)));
+			}
+		};
+
+		write(HashBytes(m_Desc.VertexShader.pShaderBytecode, m_Desc.VertexShader.BytecodeLength));
+		write(HashBytes(m_Desc.PixelShader.pShaderBytecode, m_Desc.PixelShader.BytecodeLength));
+		write(m_uRootSignatureHash);
+
+		write(m_aInputElementDescs.size());
+		for (size_t i = 0; i < m_aInputElementDescs.size(); ++i)
+		{
+			const D3D12_INPUT_ELEMENT_DESC& element = m_aInputElementDescs[i];
+			write(HashBytes(m_aSemanticNames[i].data(), m_aSemanticNames[i].size()));
+			write(element.SemanticIndex);
+			write(static_cast<UINT64>(element.Format));
+			write(element.InputSlot);
+			write(element.AlignedByteOffset);
+			write(static_cast<UINT64>(element.InputSlotClass));
+			write(element.InstanceDataStepRate);
+		}
+
+		write(static_cast<UINT64>(m_Desc.PrimitiveTopologyType));
+		write(static_cast<UINT64>(m_Desc.FillMode));
+		write(static_cast<UINT64>(m_Desc.CullMode));
+		write(m_Desc.bIsDepthEnabled ? 1u : 0u);
+		write(m_Desc.bIsDepthWriteEnabled ? 1u : 0u);
+		write(static_cast<UINT64>(m_Desc.DepthFunc));
+		write(m_Desc.bIsBlendEnabled ? 1u : 0u);
+		write(m_Desc.uNumRenderTargets);
+		for (DXGI_FORMAT format : m_Desc.aRtvFormats)
+		{
+			write(static_cast<UINT64>(format));
+		}
+		write(static_cast<UINT64>(m_Desc.DsvFormat));
+		write(m_Desc.uSampleCount);
+
+		return HashBytes(aBytes.data(), aBytes.size());
+	}
+
+	UINT GetVertexFormatSize(_In_ DXGI_FORMAT format) noexcept
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		case DXGI_FORMAT_R32G32B32A32_UINT:
+		case DXGI_FORMAT_R32G32B32A32_SINT:
+			return 16u;
+		case DXGI_FORMAT_R32G32B32_FLOAT:
+		case DXGI_FORMAT_R32G32B32_UINT:
+		case DXGI_FORMAT_R32G32B32_SINT:
+			return 12u;
+		case DXGI_FORMAT_R32G32_FLOAT:
+		case DXGI_FORMAT_R32G32_UINT:
+		case DXGI_FORMAT_R32G32_SINT:
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		case DXGI_FORMAT_R16G16B16A16_UNORM:
+		case DXGI_FORMAT_R16G16B16A16_SNORM:
+		case DXGI_FORMAT_R16G16B16A16_UINT:
+		case DXGI_FORMAT_R16G16B16A16_SINT:
+			return 8u;
+		case DXGI_FORMAT_R32_FLOAT:
+		case DXGI_FORMAT_R32_UINT:
+		case DXGI_FORMAT_R32_SINT:
+		case DXGI_FORMAT_R16G16_FLOAT:
+		case DXGI_FORMAT_R16G16_UNORM:
+		case DXGI_FORMAT_R16G16_SNORM:
+		case DXGI_FORMAT_R16G16_UINT:
+		case DXGI_FORMAT_R16G16_SINT:
+		case DXGI_FORMAT_R10G10B10A2_UNORM:
+		case DXGI_FORMAT_R10G10B10A2_UINT:
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_SNORM:
+		case DXGI_FORMAT_R8G8B8A8_UINT:
+		case DXGI_FORMAT_R8G8B8A8_SINT:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+			return 4u;
+		case DXGI_FORMAT_R16_FLOAT:
+		case DXGI_FORMAT_R16_UNORM:
+		case DXGI_FORMAT_R16_SNORM:
+		case DXGI_FORMAT_R16_UINT:
+		case DXGI_FORMAT_R16_SINT:
+		case DXGI_FORMAT_R8G8_UNORM:
+		case DXGI_FORMAT_R8G8_SNORM:
+		case DXGI_FORMAT_R8G8_UINT:
+		case DXGI_FORMAT_R8G8_SINT:
+			return 2u;
+		case DXGI_FORMAT_R8_UNORM:
+		case DXGI_FORMAT_R8_SNORM:
+		case DXGI_FORMAT_R8_UINT:
+		case DXGI_FORMAT_R8_SINT:
+			return 1u;
+		default:
+			return 0u;
+		}
+	}
+}
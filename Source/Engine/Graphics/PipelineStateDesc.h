@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <d3d12.h>
+
+#include "Utility/Types.h"
+
+namespace pr
+{
+	// Graphics pipeline state that the renderer varies, everything else keeps the D3D12 defaults. Only
+	// references its data, which has to stay alive until it has been canonicalized. The shader bytecode
+	// has to stay alive as long as the canonical description.
+	struct GraphicsPipelineDesc
+	{
+		D3D12_SHADER_BYTECODE VertexShader;
+		D3D12_SHADER_BYTECODE PixelShader;
+		const void* pRootSignatureBlob;
+		size_t uRootSignatureBlobSize;
+		const D3D12_INPUT_ELEMENT_DESC* pInputElementDescs;
+		UINT uNumInputElements;
+		D3D12_PRIMITIVE_TOPOLOGY_TYPE PrimitiveTopologyType;
+		D3D12_FILL_MODE FillMode;
+		D3D12_CULL_MODE CullMode;
+		BOOL bIsDepthEnabled;
+		BOOL bIsDepthWriteEnabled;
+		D3D12_COMPARISON_FUNC DepthFunc;
+		BOOL bIsBlendEnabled;
+		UINT uNumRenderTargets;
+		DXGI_FORMAT aRtvFormats[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
+		DXGI_FORMAT DsvFormat;
+		UINT uSampleCount;
+	};
+
+	// Copy of a GraphicsPipelineDesc in canonical form, so that descriptions that build the same pipeline
+	// hash the same: semantic names are upper case, appended element offsets are resolved and the elements
+	// sorted, and state without effect is reset. Shaders and the root signature are keyed by content. The
+	// shader bytecode is not copied, the renderer's points into the ShaderArchive mapping, which outlives
+	// the pipeline cache and every compile it runs.
+	class CanonicalPipelineDesc final
+	{
+	public:
+		explicit CanonicalPipelineDesc(_In_ const GraphicsPipelineDesc& desc);
+		CanonicalPipelineDesc(const CanonicalPipelineDesc& other) = delete;
+		CanonicalPipelineDesc(CanonicalPipelineDesc&& other) = delete;
+		CanonicalPipelineDesc& operator=(const CanonicalPipelineDesc& other) = delete;
+		CanonicalPipelineDesc& operator=(CanonicalPipelineDesc&& other) = delete;
+		~CanonicalPipelineDesc() noexcept = default;
+
+		// References the storage of this object and the caller's shader bytecode, the root signature blob is not kept
+		const GraphicsPipelineDesc& GetDesc() const noexcept;
+		UINT64 GetHash() const noexcept;
+
+	private:
+		void canonicalize(_In_ const GraphicsPipelineDesc& desc);
+		UINT64 computeHash() const;
+
+	private:
+		GraphicsPipelineDesc m_Desc;
+		std::vector<std::string> m_aSemanticNames;
+		std::vector<D3D12_INPUT_ELEMENT_DESC> m_aInputElementDescs;
+		UINT64 m_uRootSignatureHash;
+		UINT64 m_uHash;
+	};
+
+	// Size of a vertex element format in bytes, 0 for formats the canonicalization does not resolve
+	UINT GetVertexFormatSize(_In_ DXGI_FORMAT format) noexcept;
+}
@@ -0,0 +1,301 @@
+#include "pch.h"
+
+#include "Graphics/RenderQueue.h"
+
+#include "Utility/JobSystem.h"
+#include "Utility/Profiler.h"
+
+namespace pr
+{
+	RenderQueue::RenderQueue() noexcept
+		: m_aDraws()
+		, m_aItems()
+		, m_aScratch()
+		, m_aInstancedDraws()
+		, m_auInstancedDrawIndices()
+		, m_auInstanceObjectIndices()
+		, m_InstancedDrawLookup()
+		, m_MaterialIds()
+		, m_VertexBufferIds()
+		, m_UnsortedStats()
+		, m_SortedStats()
+	{
+	}
+
+	void RenderQueue::Reset() noexcept
+	{
+		m_aDraws.clear();
+		m_aItems.clear();
+		m_aInstancedDraws.clear();
+		m_auInstanceObjectIndices.clear();
+
+		// Ids only order the draws of one frame. Renumbering every frame keeps them dense, so they only wrap
+		// around with more distinct materials or vertex buffers in a frame than the key fields hold, and never
+		// refer to a destroyed material or to a buffer an arena rebuild or defragment replaced.
+		m_MaterialIds.clear();
+		m_VertexBufferIds.clear();
+	}
+
+	void RenderQueue::AddDraw(_In_ Renderable* pRenderable, _In_ UINT uMesh, _In_ UINT uLod, _In_ UINT uObjectIndex, _In_ UINT uPso, _In_ UINT uDepth)
+	{
+		const auto mesh = pRenderable->GetMesh(uMesh, uLod);
+		addDraw(pRenderable, uMesh, uLod, mesh.uBaseIndex, mesh.uNumIndices, uObjectIndex, uPso, uDepth);
+	}
+
+	void RenderQueue::AddDraw(_In_ Renderable* pRenderable, _In_ UINT uMesh, _In_ const MeshletRange& range, _In_ UINT uObjectIndex, _In_ UINT uPso, _In_ UINT uDepth)
+	{
+		// Meshlets index the geometry of the renderable like its mesh entries, not the shared index buffer
+		const UINT uIndexOffset = pRenderable->GetMesh(uMesh).uBaseIndex - pRenderable->GetMeshEntry(uMesh).uBaseIndex;
+		addDraw(pRenderable, uMesh, 0u, uIndexOffset + range.uBaseIndex, range.uNumIndices, uObjectIndex, uPso, uDepth);
+	}
+
+	void RenderQueue::Sort()
+	{
+		PR_PROFILE_FUNCTION();
+
+		m_UnsortedStats = computeStats();
+
+		m_aScratch.resize(m_aItems.size());
+		ParallelRadixSort(m_aItems.data(), m_aScratch.data(), static_cast<UINT>(m_aItems.size()), JobSystem::GetInstance());
+
+		m_SortedStats = computeStats();
+	}
+
+	void RenderQueue::BuildInstancedDraws()
+	{
+		PR_PROFILE_FUNCTION();
+
+		m_aInstancedDraws.clear();
+		m_auInstanceObjectIndices.clear();
+		m_InstancedDrawLookup.clear();
+		m_auInstancedDrawIndices.resize(m_aItems.size());
+
+		// Assign every sorted draw to an instanced draw and count the instances
+		InstanceKey previousKey = {};
+		for (UINT i = 0u; i < m_aItems.size(); ++i)
+		{
+			const DrawPacket& draw = m_aDraws[m_aItems[i].uValue];
+			InstanceKey key = makeInstanceKey(draw);
+
+			UINT uInstancedDraw = static_cast<UINT>(m_aInstancedDraws.size());
+			if (DrawSortKey::GetPass(m_aItems[i].uKey) == eRenderPass::TRANSLUCENT_PASS)
+			{
+				if (i > 0u && DrawSortKey::GetPass(m_aItems[i - 1u].uKey) == eRenderPass::TRANSLUCENT_PASS && key == previousKey)
+				{
+					uInstancedDraw = m_auInstancedDrawIndices[i - 1u];
+				}
+			}
+			else
+			{
+				uInstancedDraw = m_InstancedDrawLookup.try_emplace(key, uInstancedDraw).first->second;
+			}
+
+			if (uInstancedDraw == m_aInstancedDraws.size())
+			{
+				m_aInstancedDraws.push_back(
+					InstancedDraw
+					{
+						.pRenderable = draw.pRenderable,
+						.uMesh = draw.uMesh,
+						.uLod = draw.uLod,
+						.uBaseIndex = draw.uBaseIndex,
+						.uNumIndices = draw.uNumIndices,
+						.uFirstInstance = 0u,
+						.uNumInstances = 0u,
+					}
+				);
+			}
+
+			++m_aInstancedDraws[uInstancedDraw].uNumInstances;
+			m_auInstancedDrawIndices[i] = uInstancedDraw;
+			previousKey = key;
+		}
+
+		// Lay the instances of each instanced draw out contiguously, keeping the sorted order inside it
+		UINT uNumInstances = 0u;
+		for (InstancedDraw& instancedDraw : m_aInstancedDraws)
+		{
+			instancedDraw.uFirstInstance = uNumInstances;
+			uNumInstances += instancedDraw.uNumInstances;
+			instancedDraw.uNumInstances = 0u;
+		}
+
+		m_auInstanceObjectIndices.resize(uNumInstances);
+		for (UINT i = 0u; i < m_aItems.size(); ++i)
+		{
+			InstancedDraw& instancedDraw = m_aInstancedDraws[m_auInstancedDrawIndices[i]];
+			m_auInstanceObjectIndices[instancedDraw.uFirstInstance + instancedDraw.uNumInstances++] = m_aDraws[m_aItems[i].uValue].uObjectIndex;
+		}
+
+		m_SortedStats.uNumInstancedDraws = static_cast<UINT>(m_aInstancedDraws.size());
+	}
+
+	UINT RenderQueue::GetNumDraws() const noexcept
+	{
+		return static_cast<UINT>(m_aItems.size());
+	}
+
+	const RenderQueue::DrawPacket& RenderQueue::GetDraw(_In_ UINT uIndex) const noexcept
+	{
+		assert(uIndex < m_aItems.size());
+
+		return m_aDraws[m_aItems[uIndex].uValue];
+	}
+
+	UINT RenderQueue::GetNumInstancedDraws() const noexcept
+	{
+		return static_cast<UINT>(m_aInstancedDraws.size());
+	}
+
+	const RenderQueue::InstancedDraw& RenderQueue::GetInstancedDraw(_In_ UINT uIndex) const noexcept
+	{
+		assert(uIndex < m_aInstancedDraws.size());
+
+		return m_aInstancedDraws[uIndex];
+	}
+
+	UINT RenderQueue::GetNumInstances() const noexcept
+	{
+		return static_cast<UINT>(m_auInstanceObjectIndices.size());
+	}
+
+	const UINT* RenderQueue::GetInstanceObjectIndices() const noexcept
+	{
+		return m_auInstanceObjectIndices.data();
+	}
+
+	const RenderQueue::Stats& RenderQueue::GetUnsortedStats() const noexcept
+	{
+		return m_UnsortedStats;
+	}
+
+	const RenderQueue::Stats& RenderQueue::GetSortedStats() const noexcept
+	{
+		return m_SortedStats;
+	}
+
+	UINT RenderQueue::GetMaterialId(_In_ const Material* pMaterial)
+	{
+		auto iter = m_MaterialIds.find(pMaterial);
+		if (iter != m_MaterialIds.end())
+		{
+			return iter->second;
+		}
+
+		// Ids wrap around once the key field is exhausted within a frame, which only costs sort quality
+		UINT uId = static_cast<UINT>(m_MaterialIds.size()) % DrawSortKey::MAX_MATERIALS;
+		m_MaterialIds.emplace(pMaterial, uId);
+
+		return uId;
+	}
+
+	UINT RenderQueue::GetVertexBufferId(_In_ D3D12_GPU_VIRTUAL_ADDRESS vertexBufferLocation)
+	{
+		auto iter = m_VertexBufferIds.find(vertexBufferLocation);
+		if (iter != m_VertexBufferIds.end())
+		{
+			return iter->second;
+		}
+
+		UINT uId = static_cast<UINT>(m_VertexBufferIds.size()) % DrawSortKey::MAX_VERTEX_BUFFERS;
+		m_VertexBufferIds.emplace(vertexBufferLocation, uId);
+
+		return uId;
+	}
+
+	size_t RenderQueue::InstanceKeyHash::operator()(_In_ const InstanceKey& key) const noexcept
+	{
+		size_t uHash = std::hash<D3D12_GPU_VIRTUAL_ADDRESS>()(key.VertexBuffer);
+		for (UINT64 uValue : { static_cast<UINT64>(key.IndexBuffer), static_cast<UINT64>(key.uBaseVertex), static_cast<UINT64>(key.uBaseIndex), static_cast<UINT64>(key.uNumIndices), static_cast<UINT64>(key.uMaterial), static_cast<UINT64>(key.uPso) })
+		{
+			uHash ^= std::hash<UINT64>()(uValue) + 0x9e3779b97f4a7c15ull + (uHash << 6) + (uHash >> 2);
+		}
+
+		return uHash;
+	}
+
+	void RenderQueue::addDraw(
+		_In_ Renderable* pRenderable,
+		_In_ UINT uMesh,
+		_In_ UINT uLod,
+		_In_ UINT uBaseIndex,
+		_In_ UINT uNumIndices,
+		_In_ UINT uObjectIndex,
+		_In_ UINT uPso,
+		_In_ UINT uDepth
+	)
+	{
+		UINT uMaterialIndex = pRenderable->GetMesh(uMesh).uMaterialIndex;
+		const Material* pMaterial = uMaterialIndex < pRenderable->GetNumMaterials() ? pRenderable->GetMaterial(uMaterialIndex).get() : nullptr;
+
+		DrawPacket draw =
+		{
+			.pRenderable = pRenderable,
+			.uMesh = uMesh,
+			.uLod = uLod,
+			.uBaseIndex = uBaseIndex,
+			.uNumIndices = uNumIndices,
+			.uObjectIndex = uObjectIndex,
+			.uPso = uPso,
+			.uMaterial = GetMaterialId(pMaterial),
+			.uVertexBuffer = GetVertexBufferId(pRenderable->GetVertexBufferView().BufferLocation),
+		};
+
+		m_aItems.push_back(
+			SortItem
+			{
+				.uKey = DrawSortKey::Encode(pRenderable->GetRenderPass(), draw.uPso, draw.uMaterial, draw.uVertexBuffer, uDepth),
+				.uValue = static_cast<UINT>(m_aDraws.size()),
+				.uPadding = 0u,
+			}
+		);
+		m_aDraws.push_back(draw);
+	}
+
+	RenderQueue::InstanceKey RenderQueue::makeInstanceKey(_In_ const DrawPacket& draw) noexcept
+	{
+		return InstanceKey
+		{
+			.VertexBuffer = draw.pRenderable->GetVertexBufferView().BufferLocation,
+			.IndexBuffer = draw.pRenderable->GetIndexBufferView().BufferLocation,
+			.uBaseVertex = draw.pRenderable->GetMesh(draw.uMesh).uBaseVertex,
+			.uBaseIndex = draw.uBaseIndex,
+			.uNumIndices = draw.uNumIndices,
+			.uMaterial = draw.uMaterial,
+			.uPso = draw.uPso,
+		};
+	}
+
+	RenderQueue::Stats RenderQueue::computeStats() const noexcept
+	{
+		Stats stats =
+		{
+			.uNumDraws = static_cast<UINT>(m_aItems.size()),
+			.uNumInstancedDraws = static_cast<UINT>(m_aItems.size()),
+			.uNumPsoChanges = 0u,
+			.uNumMaterialChanges = 0u,
+			.uNumVertexBufferChanges = 0u,
+		};
+
+		const DrawPacket* pPrevious = nullptr;
+		for (const SortItem& item : m_aItems)
+		{
+			const DrawPacket& draw = m_aDraws[item.uValue];
+			if (!pPrevious || pPrevious->uPso != draw.uPso)
+			{
+				++stats.uNumPsoChanges;
+			}
+			if (!pPrevious || pPrevious->uMaterial != draw.uMaterial)
+			{
+				++stats.uNumMaterialChanges;
+			}
+			if (!pPrevious || pPrevious->uVertexBuffer != draw.uVertexBuffer)
+			{
+				++stats.uNumVertexBufferChanges;
+			}
+			pPrevious = &draw;
+		}
+
+		return stats;
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/DrawSortKey.h"
+#include "Graphics/Renderable.h"
+#include "Utility/RadixSort.h"
+
+namespace pr
+{
+	class RenderQueue final
+	{
+	public:
+		// Draws the index range of the LOD, or of visible meshlets of LOD 0
+		struct DrawPacket
+		{
+			Renderable* pRenderable;
+			UINT uMesh;
+			UINT uLod;
+			UINT uBaseIndex;
+			UINT uNumIndices;
+			UINT uObjectIndex;
+			UINT uPso;
+			UINT uMaterial;
+			UINT uVertexBuffer;
+		};
+
+		// Consecutive instances [uFirstInstance, uFirstInstance + uNumInstances) share geometry and material
+		struct InstancedDraw
+		{
+			Renderable* pRenderable;
+			UINT uMesh;
+			UINT uLod;
+			UINT uBaseIndex;
+			UINT uNumIndices;
+			UINT uFirstInstance;
+			UINT uNumInstances;
+		};
+
+		struct Stats
+		{
+			UINT uNumDraws;
+			UINT uNumInstancedDraws;
+			UINT uNumPsoChanges;
+			UINT uNumMaterialChanges;
+			UINT uNumVertexBufferChanges;
+		};
+
+	public:
+		explicit RenderQueue() noexcept;
+		RenderQueue(const RenderQueue& other) = delete;
+		RenderQueue(RenderQueue&& other) = delete;
+		RenderQueue& operator=(const RenderQueue& other) = delete;
+		RenderQueue& operator=(RenderQueue&& other) = delete;
+		~RenderQueue() noexcept = default;
+
+		void Reset() noexcept;
+		void AddDraw(_In_ Renderable* pRenderable, _In_ UINT uMesh, _In_ UINT uLod, _In_ UINT uObjectIndex, _In_ UINT uPso, _In_ UINT uDepth);
+		// Draws only the range of the meshlets of LOD 0 that passed culling
+		void AddDraw(_In_ Renderable* pRenderable, _In_ UINT uMesh, _In_ const MeshletRange& range, _In_ UINT uObjectIndex, _In_ UINT uPso, _In_ UINT uDepth);
+		void Sort();
+
+		// Collapses sorted draws with the same vertex buffer, index buffer, index range, material and PSO.
+		// Different LODs of a mesh are different index ranges and never merge.
+		// Opaque draws are merged across the whole pass, translucent draws only when adjacent to keep their order.
+		void BuildInstancedDraws();
+
+		UINT GetNumDraws() const noexcept;
+		const DrawPacket& GetDraw(_In_ UINT uIndex) const noexcept;
+		UINT GetNumInstancedDraws() const noexcept;
+		const InstancedDraw& GetInstancedDraw(_In_ UINT uIndex) const noexcept;
+		// Object index of every instance, grouped by instanced draw
+		UINT GetNumInstances() const noexcept;
+		const UINT* GetInstanceObjectIndices() const noexcept;
+
+		// State changes of the last frame in submission order and in sorted order
+		const Stats& GetUnsortedStats() const noexcept;
+		const Stats& GetSortedStats() const noexcept;
+
+		// Sort ids in the order of first use since the last Reset
+		UINT GetMaterialId(_In_ const Material* pMaterial);
+		UINT GetVertexBufferId(_In_ D3D12_GPU_VIRTUAL_ADDRESS vertexBufferLocation);
+
+	private:
+		struct InstanceKey
+		{
+			D3D12_GPU_VIRTUAL_ADDRESS VertexBuffer;
+			D3D12_GPU_VIRTUAL_ADDRESS IndexBuffer;
+			UINT uBaseVertex;
+			UINT uBaseIndex;
+			UINT uNumIndices;
+			UINT uMaterial;
+			UINT uPso;
+
+			bool operator==(_In_ const InstanceKey& other) const noexcept = default;
+		};
+
+		struct InstanceKeyHash
+		{
+			size_t operator()(_In_ const InstanceKey& key) const noexcept;
+		};
+
+	private:
+		void addDraw(
+			_In_ Renderable* pRenderable,
+			_In_ UINT uMesh,
+			_In_ UINT uLod,
+			_In_ UINT uBaseIndex,
+			_In_ UINT uNumIndices,
+			_In_ UINT uObjectIndex,
+			_In_ UINT uPso,
+			_In_ UINT uDepth
+		);
+		static InstanceKey makeInstanceKey(_In_ const DrawPacket& draw) noexcept;
+		Stats computeStats() const noexcept;
+
+	private:
+		std::vector<DrawPacket> m_aDraws;
+		std::vector<SortItem> m_aItems;
+		std::vector<SortItem> m_aScratch;
+		std::vector<InstancedDraw> m_aInstancedDraws;
+		std::vector<UINT> m_auInstancedDrawIndices;
+		std::vector<UINT> m_auInstanceObjectIndices;
+		std::unordered_map<InstanceKey, UINT, InstanceKeyHash> m_InstancedDrawLookup;
+		std::unordered_map<const Material*, UINT> m_MaterialIds;
+		std::unordered_map<D3D12_GPU_VIRTUAL_ADDRESS, UINT> m_VertexBufferIds;
+		Stats m_UnsortedStats;
+		Stats m_SortedStats;
+	};
+}
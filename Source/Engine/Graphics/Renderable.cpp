@@ -2,7 +2,11 @@
 
 #include "Graphics/Renderable.h"
 
+#include <algorithm>
+
 #include "Graphics/GraphicsCommon.h"
+#include "Graphics/VertexQuantization.h"
+#include "Utility/Utility.h"
 
 //#include "assimp/Importer.hpp"	// C++ importer interface
 //#include "assimp/scene.h"		// output data structure
@@ -26,21 +30,88 @@ namespace pr
       Args:     const XMFLOAT4& outputColor
                   Default color to shader the renderable
 
-      Modifies: [m_pVertexBuffer, m_pIndexBuffer, m_constantBuffer,
-                 m_aMeshes, m_aMaterials, m_vertexShader,
-                 m_pixelShader, m_outputColor, m_World].
+      Modifies: [m_pGeometryAllocation, m_pUploadBuffer, m_pOccluderGeometry, m_aMeshes, m_aMaterials,
+                 m_vertexShader, m_pixelShader, m_outputColor, m_World, m_LocalTransform,
+                 m_uTransformVersion, m_PositionDecode, m_bIsOccluder].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     Renderable::Renderable(_In_ eVertexType vertexType) noexcept
         : m_World(XMMatrixIdentity())
+        , m_LocalTransform
+        {
+            .Scale = XMFLOAT3(1.0f, 1.0f, 1.0f),
+            .Rotation = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f),
+            .Translation = XMFLOAT3(0.0f, 0.0f, 0.0f),
+        }
+        , m_uTransformVersion(0u)
         , m_VertexType(vertexType)
-        , m_pVertexBuffer()
-        , m_pVertexUploadBuffer()
-        , m_pIndexBuffer()
-        , m_pIndexUploadBuffer()
-        , m_VertexBufferView()
-        , m_IndexBufferView()
+        , m_RenderPass(eRenderPass::OPAQUE_PASS)
+        , m_PositionDecode
+        {
+            .Offset = XMFLOAT3(0.0f, 0.0f, 0.0f),
+            .Scale = 1.0f,
+        }
+        , m_pGeometryAllocation()
+        , m_pUploadBuffer()
+        , m_pOccluderGeometry()
         , m_bHasNormalMap(FALSE)
+        , m_bIsOccluder(FALSE)
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::Load
+
+      Summary:  Reads and converts the data of the renderable without
+                touching the device, so scenes load their renderables
+                on worker threads before initializing them one by one.
+                Renderables built in code have nothing to load
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Renderable::Load()
+    {
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::Release
+
+      Summary:  Drops the geometry arena ranges, the upload buffer and
+                the occluder geometry. The meshes stay, so the scene
+                keeps culling the renderable while it is not drawn.
+                Ranges shared with other renderables are freed with
+                the last of them
+
+      Modifies: [m_pGeometryAllocation, m_pUploadBuffer,
+                 m_pOccluderGeometry].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderable::Release() noexcept
     {
+        m_pGeometryAllocation.reset();
+        m_pUploadBuffer.Reset();
+        m_pOccluderGeometry.reset();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::IsStreamable
+
+      Summary:  Returns whether the renderable can be released and
+                brought back by Load and Initialize any number of
+                times. Renderables built in code or imported once are
+                not
+
+      Returns:  BOOL
+                  TRUE if a scene streamer may release the renderable
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Renderable::IsStreamable() const noexcept
+    {
+        return FALSE;
+    }
+
+    BOOL Renderable::IsResident() const noexcept
+    {
+        return m_pGeometryAllocation != nullptr;
     }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
@@ -137,39 +208,30 @@ namespace pr
     //}
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Renderable::GetVertexBuffer
+      Method:   Renderable::GetVertexBufferView
 
-      Summary:  Returns the vertex buffer
+      Summary:  Returns the view of the geometry arena vertex buffer
+                that holds the vertices of this renderable
 
-      Returns:  ComPtr<ID3D11Buffer>&
-                  Vertex buffer
+      Returns:  const D3D12_VERTEX_BUFFER_VIEW&
+                  Vertex buffer view
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    ComPtr<ID3D12Resource>& Renderable::GetVertexBuffer()
-    {
-        return m_pVertexBuffer;
-    }
-
     const D3D12_VERTEX_BUFFER_VIEW& Renderable::GetVertexBufferView() const noexcept
     {
-        return m_VertexBufferView;
+        return GeometryArena::GetInstance().GetVertexBufferView(m_VertexType);
     }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Renderable::GetIndexBuffer
+      Method:   Renderable::GetIndexBufferView
 
-      Summary:  Returns the index buffer
+      Summary:  Returns the view of the geometry arena index buffer
 
-      Returns:  ComPtr<ID3D11Buffer>&
-                  Index buffer
+      Returns:  const D3D12_INDEX_BUFFER_VIEW&
+                  Index buffer view
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    ComPtr<ID3D12Resource>& Renderable::GetIndexBuffer()
-    {
-        return m_pIndexBuffer;
-    }
-
     const D3D12_INDEX_BUFFER_VIEW& Renderable::GetIndexBufferView() const noexcept
     {
-        return m_IndexBufferView;
+        return GeometryArena::GetInstance().GetIndexBufferView();
     }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
@@ -198,6 +260,38 @@ namespace pr
         return m_World;
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::SetWorldMatrix
+
+      Summary:  Stores the world matrix the scene computed from the
+                local transform and the parents
+
+      Args:     const XMMATRIX& world
+                  World matrix
+
+      Modifies: [m_World].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderable::SetWorldMatrix(_In_ const XMMATRIX& world) noexcept
+    {
+        m_World = world;
+    }
+
+    const Transform& Renderable::GetLocalTransform() const noexcept
+    {
+        return m_LocalTransform;
+    }
+
+    void Renderable::SetLocalTransform(_In_ const Transform& local) noexcept
+    {
+        m_LocalTransform = local;
+        ++m_uTransformVersion;
+    }
+
+    UINT Renderable::GetTransformVersion() const noexcept
+    {
+        return m_uTransformVersion;
+    }
+
     //const XMFLOAT4& Renderable::GetOutputColor() const
     //{
     //    return m_outputColor;
@@ -208,48 +302,193 @@ namespace pr
     //    return m_aMaterials.size() > 0;
     //}
 
-    //const std::shared_ptr<Material>& Renderable::GetMaterial(UINT uIndex) const
-    //{
-    //    assert(uIndex < m_aMaterials.size());
+    const std::shared_ptr<Material>& Renderable::GetMaterial(UINT uIndex) const
+    {
+        assert(uIndex < m_aMaterials.size());
 
-    //    return m_aMaterials[uIndex];
-    //}
+        return m_aMaterials[uIndex];
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetMesh
 
-    const Renderable::BasicMeshEntry& Renderable::GetMesh(UINT uIndex) const
+      Summary:  Returns a mesh with its base vertex and base index
+                rebased onto the geometry arena. The arena moves
+                ranges when it compacts, so the offsets are resolved
+                on every call instead of being stored.
+
+      Args:     UINT uIndex
+                  Index of the mesh
+                UINT uLod
+                  LOD whose index range replaces the full one
+
+      Returns:  BasicMeshEntry
+                  Mesh entry
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    Renderable::BasicMeshEntry Renderable::GetMesh(UINT uIndex, UINT uLod) const
     {
         assert(uIndex < m_aMeshes.size());
+        assert(uLod < m_aMeshes[uIndex].uNumLods);
+
+        BasicMeshEntry mesh = m_aMeshes[uIndex];
+        if (uLod > 0u)
+        {
+            mesh.uNumIndices = mesh.aLods[uLod - 1u].uNumIndices;
+            mesh.uBaseIndex = mesh.aLods[uLod - 1u].uBaseIndex;
+        }
+
+        if (m_pGeometryAllocation)
+        {
+            mesh.uBaseVertex += m_pGeometryAllocation->uVertexOffset;
+            mesh.uBaseIndex += m_pGeometryAllocation->uIndexOffset;
+        }
+
+        return mesh;
+    }
 
-        return m_aMeshes[uIndex];
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::SelectLod
+
+      Summary:  Projects the error of every LOD of a mesh from the
+                nearest point of its bounding sphere and returns the
+                coarsest one that stays below the threshold
+
+      Args:     UINT uMeshIndex
+                  Index of the mesh
+                const XMVECTOR& eyePosition
+                  Camera position in world space
+                FLOAT projectionScale
+                  Pixels covered by one unit at distance one, half
+                  the viewport height times the projection's y scale
+                FLOAT maxPixelError
+                  Largest error allowed on screen
+
+      Returns:  UINT
+                  LOD to draw
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Renderable::SelectLod(_In_ UINT uMeshIndex, _In_ const XMVECTOR& eyePosition, _In_ FLOAT projectionScale, _In_ FLOAT maxPixelError) const
+    {
+        assert(uMeshIndex < m_aMeshes.size());
+
+        const BasicMeshEntry& mesh = m_aMeshes[uMeshIndex];
+        if (mesh.uNumLods <= 1u || mesh.Bounds.Radius <= 0.0f)
+        {
+            return 0u;
+        }
+
+        // The world radius over the object radius is the largest scale of the world matrix
+        MeshBounds worldBounds = GetWorldBounds(uMeshIndex);
+        FLOAT scale = worldBounds.Radius / mesh.Bounds.Radius;
+        FLOAT distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&worldBounds.Center) - eyePosition)) - worldBounds.Radius;
+        if (distance <= 0.0f)
+        {
+            return 0u;
+        }
+
+        FLOAT maxError = maxPixelError * distance / (projectionScale * scale);
+        UINT uLod = 0u;
+        while (uLod + 1u < mesh.uNumLods && mesh.aLods[uLod].Error <= maxError)
+        {
+            ++uLod;
+        }
+
+        return uLod;
+    }
+
+    MeshBounds Renderable::GetWorldBounds(UINT uMeshIndex) const
+    {
+        assert(uMeshIndex < m_aMeshes.size());
+
+        XMFLOAT4X4 world;
+        XMStoreFloat4x4(&world, m_World);
+
+        return TransformMeshBounds(m_aMeshes[uMeshIndex].Bounds, world);
+    }
+
+    const OccluderGeometry* Renderable::GetOccluderGeometry() const noexcept
+    {
+        return m_pOccluderGeometry.get();
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::RotateX
+
+      Summary:  Rotates around the x axis of the parent after the
+                current transform, the world matrix follows on the
+                next scene update
+
+      Args:     FLOAT angle
+                  Angle in radians
+
+      Modifies: [m_LocalTransform, m_uTransformVersion].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     void Renderable::RotateX(_In_ FLOAT angle)
     {
-        m_World *= XMMatrixRotationX(angle);
+        rotate(XMQuaternionRotationNormal(XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), angle));
     }
 
     void Renderable::RotateY(_In_ FLOAT angle)
     {
-        m_World *= XMMatrixRotationY(angle);
+        rotate(XMQuaternionRotationNormal(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), angle));
     }
 
     void Renderable::RotateZ(_In_ FLOAT angle)
     {
-        m_World *= XMMatrixRotationZ(angle);
+        rotate(XMQuaternionRotationNormal(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), angle));
     }
 
     void Renderable::RotateRollPitchYaw(_In_ FLOAT roll, _In_ FLOAT pitch, _In_ FLOAT yaw)
     {
-        m_World *= XMMatrixRotationRollPitchYaw(pitch, yaw, roll);
+        rotate(XMQuaternionRotationRollPitchYaw(pitch, yaw, roll));
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::Scale
+
+      Summary:  Scales after the current transform. The scale is
+                kept per local axis, so a non-uniform scale after a
+                rotation is applied along the rotated axes
+
+      Args:     FLOAT scaleX
+                  Scale in x
+                FLOAT scaleY
+                  Scale in y
+                FLOAT scaleZ
+                  Scale in z
+
+      Modifies: [m_LocalTransform, m_uTransformVersion].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     void Renderable::Scale(_In_ FLOAT scaleX, _In_ FLOAT scaleY, _In_ FLOAT scaleZ)
     {
-        m_World *= XMMatrixScaling(scaleX, scaleY, scaleZ);
+        XMVECTOR scale = XMVectorSet(scaleX, scaleY, scaleZ, 0.0f);
+        XMStoreFloat3(&m_LocalTransform.Scale, XMVectorMultiply(XMLoadFloat3(&m_LocalTransform.Scale), scale));
+        XMStoreFloat3(&m_LocalTransform.Translation, XMVectorMultiply(XMLoadFloat3(&m_LocalTransform.Translation), scale));
+        ++m_uTransformVersion;
     }
 
     void Renderable::Translate(_In_ const XMVECTOR& offset)
     {
-        m_World *= XMMatrixTranslationFromVector(offset);
+        XMStoreFloat3(&m_LocalTransform.Translation, XMVectorAdd(XMLoadFloat3(&m_LocalTransform.Translation), offset));
+        ++m_uTransformVersion;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::rotate
+
+      Summary:  Applies a rotation after the current transform, which
+                also swings the translation around the parent origin
+
+      Args:     const XMVECTOR& rotation
+                  Rotation quaternion
+
+      Modifies: [m_LocalTransform, m_uTransformVersion].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderable::rotate(_In_ const XMVECTOR& rotation) noexcept
+    {
+        XMVECTOR localRotation = XMQuaternionMultiply(XMLoadFloat4(&m_LocalTransform.Rotation), rotation);
+        XMStoreFloat4(&m_LocalTransform.Rotation, XMQuaternionNormalize(localRotation));
+        XMStoreFloat3(&m_LocalTransform.Translation, XMVector3Rotate(XMLoadFloat3(&m_LocalTransform.Translation), rotation));
+        ++m_uTransformVersion;
     }
 
     eVertexType Renderable::GetVertexType() const noexcept
@@ -257,24 +496,125 @@ namespace pr
         return m_VertexType;
     }
 
+    const PositionDecode& Renderable::GetPositionDecode() const noexcept
+    {
+        return m_PositionDecode;
+    }
+
+    eRenderPass Renderable::GetRenderPass() const noexcept
+    {
+        return m_RenderPass;
+    }
+
+    void Renderable::SetRenderPass(_In_ eRenderPass renderPass) noexcept
+    {
+        m_RenderPass = renderPass;
+    }
+
+    BOOL Renderable::IsOccluder() const noexcept
+    {
+        return m_bIsOccluder;
+    }
+
+    void Renderable::SetOccluder(_In_ BOOL bIsOccluder) noexcept
+    {
+        m_bIsOccluder = bIsOccluder;
+    }
+
     UINT Renderable::GetNumMeshes() const
     {
         return static_cast<UINT>(m_aMeshes.size());
     }
 
-    //UINT Renderable::GetNumMaterials() const
-    //{
-    //    return static_cast<UINT>(m_aMaterials.size());
-    //}
+    UINT Renderable::GetNumMaterials() const
+    {
+        return static_cast<UINT>(m_aMaterials.size());
+    }
+
+    const Renderable::BasicMeshEntry& Renderable::GetMeshEntry(UINT uIndex) const
+    {
+        assert(uIndex < m_aMeshes.size());
+
+        return m_aMeshes[uIndex];
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetVertices
+
+      Summary:  Returns the CPU copy of the vertices. Renderables
+                sharing the geometry of another one may not keep a
+                copy and report no vertices
+
+      Returns:  const void*
+                  Vertices of the vertex type of the renderable
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const void* Renderable::GetVertices() const
+    {
+        return getVertices();
+    }
+
+    const WORD* Renderable::GetIndices() const
+    {
+        return getIndices();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetMeshlets
+
+      Summary:  Returns the meshlets of every mesh, a mesh owns
+                uNumMeshlets of them from uFirstMeshlet
+
+      Returns:  const Meshlet*
+                  Meshlets, nullptr for renderables without meshlets
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const Meshlet* Renderable::GetMeshlets() const
+    {
+        return getMeshlets();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::SharesGeometry
+
+      Summary:  Returns whether both renderables draw the same range of
+                the geometry arena, an initialized renderable shares
+                its geometry with itself
+
+      Args:     const Renderable& other
+                  Renderable to compare with
+
+      Returns:  BOOL
+                  TRUE if both are initialized with the same geometry
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Renderable::SharesGeometry(_In_ const Renderable& other) const noexcept
+    {
+        return m_pGeometryAllocation && m_pGeometryAllocation == other.m_pGeometryAllocation;
+    }
     //BOOL Renderable::HasNormalMap() const
     //{
     //    return m_bHasNormalMap;
     //}
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::getMeshlets
+
+      Summary:  Returns no meshlets, renderables that build them at
+                import override it
+
+      Returns:  const Meshlet*
+                  nullptr
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const Meshlet* Renderable::getMeshlets() const
+    {
+        return nullptr;
+    }
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Renderable::initialize
 
-      Summary:  Initializes the buffers and the world matrix
+      Summary:  Allocates the vertices and indices from the geometry
+                arena and records their upload. Occluders also keep
+                the positions and indices on the CPU for rasterizing
+                the renderable
 
       Args:     ID3D11Device* pDevice
                   The Direct3D device to create the buffers
@@ -283,7 +623,7 @@ namespace pr
                 PCWSTR pszTextureFileName
                   File name of the texture to usen
 
-      Modifies: [m_pVertexBuffer, m_pIndexBuffer, m_constantBuffer].
+      Modifies: [m_pGeometryAllocation, m_pUploadBuffer, m_pOccluderGeometry].
 
       Returns:  HRESULT
                   Status code
@@ -292,40 +632,117 @@ namespace pr
     {
         HRESULT hr = S_OK;
 
-        // Create vertex buffer
-        UpdateBufferResource(
-            &m_pVertexBuffer,
-            &m_pVertexUploadBuffer, 
-            pDevice, 
-            pCommandList, 
-            static_cast<size_t>(GetNumVertices()), 
-            VERTEX_SIZE[static_cast<size_t>(m_VertexType)], 
-            getVertices()
-        );
-
-        // Create the vertex buffer view
-        m_VertexBufferView.BufferLocation = m_pVertexBuffer->GetGPUVirtualAddress();
-        m_VertexBufferView.SizeInBytes = GetNumVertices() * static_cast<UINT>(VERTEX_SIZE[static_cast<size_t>(m_VertexType)]);
-        m_VertexBufferView.StrideInBytes = static_cast<UINT>(VERTEX_SIZE[static_cast<size_t>(m_VertexType)]);
-
-        // Create index buffer
-        UpdateBufferResource(
-            &m_pIndexBuffer,
-            &m_pIndexUploadBuffer,
+        hr = GeometryArena::GetInstance().Allocate(
+            m_pGeometryAllocation,
+            m_pUploadBuffer,
             pDevice,
             pCommandList,
-            static_cast<size_t>(GetNumIndices()),
-            sizeof(WORD),
-            getIndices()
+            m_VertexType,
+            getVertices(),
+            GetNumVertices(),
+            getIndices(),
+            GetNumIndices()
         );
+        CHECK_AND_RETURN_HRESULT(hr, L"Renderable::initialize >> Allocating geometry");
 
-        // Create the index buffer view
-        m_IndexBufferView.BufferLocation = m_pIndexBuffer->GetGPUVirtualAddress();
-        m_IndexBufferView.Format = DXGI_FORMAT_R16_UINT;
-        m_IndexBufferView.SizeInBytes = GetNumIndices() * sizeof(WORD);
+        // Only occluders keep a copy of their positions and indices on the CPU
+        if (m_bIsOccluder)
+        {
+            m_pOccluderGeometry = createOccluderGeometry(*this);
+        }
 
         // Create the constant buffers
 
         return hr;
     }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::shareGeometry
+
+      Summary:  Uses the buffers, meshes and materials of an already
+                initialized renderable instead of creating new ones so
+                that the renderer can draw both with a single instanced
+                draw. An occluder sharing the geometry of a renderable
+                that is not one builds its own occluder geometry
+
+      Args:     const Renderable& source
+                  Initialized renderable with the same geometry
+
+      Modifies: [m_aMeshes, m_aMaterials, m_VertexType, m_PositionDecode,
+                 m_pGeometryAllocation, m_pOccluderGeometry].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderable::shareGeometry(_In_ const Renderable& source)
+    {
+        m_aMeshes = source.m_aMeshes;
+        m_aMaterials = source.m_aMaterials;
+        m_VertexType = source.m_VertexType;
+        m_PositionDecode = source.m_PositionDecode;
+        m_pGeometryAllocation = source.m_pGeometryAllocation;
+        m_pOccluderGeometry = m_bIsOccluder ? source.m_pOccluderGeometry : nullptr;
+        if (m_bIsOccluder && !m_pOccluderGeometry)
+        {
+            m_pOccluderGeometry = createOccluderGeometry(source);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::createOccluderGeometry
+
+      Summary:  Copies the positions and indices of a renderable for
+                rasterizing it as an occluder on the CPU
+
+      Args:     const Renderable& renderable
+                  Renderable whose CPU copy of the geometry is loaded
+
+      Returns:  std::shared_ptr<const OccluderGeometry>
+                  Positions in object space, indices and meshes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    std::shared_ptr<const OccluderGeometry> Renderable::createOccluderGeometry(_In_ const Renderable& renderable)
+    {
+        // Every vertex type starts with its position, packed positions are decoded to object space
+        auto pOccluderGeometry = std::make_shared<OccluderGeometry>();
+        const BYTE* pVertices = static_cast<const BYTE*>(renderable.getVertices());
+        const WORD* pIndices = renderable.getIndices();
+        size_t uStride = VERTEX_SIZE[static_cast<size_t>(renderable.m_VertexType)];
+
+        pOccluderGeometry->aPositions.resize(renderable.GetNumVertices());
+        if (renderable.m_VertexType == eVertexType::POS_NORM_TEXCOORD_PACKED)
+        {
+            const VertexPackedPNT* aPackedVertices = static_cast<const VertexPackedPNT*>(renderable.getVertices());
+            for (UINT i = 0u; i < renderable.GetNumVertices(); ++i)
+            {
+                pOccluderGeometry->aPositions[i] = DecodePosition(aPackedVertices[i], renderable.m_PositionDecode);
+            }
+        }
+        else
+        {
+            for (UINT i = 0u; i < renderable.GetNumVertices(); ++i)
+            {
+                memcpy(&pOccluderGeometry->aPositions[i], pVertices + uStride * i, sizeof(XMFLOAT3));
+            }
+        }
+        pOccluderGeometry->aIndices.assign(pIndices, pIndices + renderable.GetNumIndices());
+
+        pOccluderGeometry->aMeshes.reserve(renderable.m_aMeshes.size());
+        for (const BasicMeshEntry& mesh : renderable.m_aMeshes)
+        {
+            UINT uNumVertices = 0u;
+            for (UINT i = 0u; i < mesh.uNumIndices; ++i)
+            {
+                uNumVertices = std::max(uNumVertices, static_cast<UINT>(pIndices[mesh.uBaseIndex + i]) + 1u);
+            }
+
+            pOccluderGeometry->aMeshes.push_back(
+                OccluderGeometry::Mesh
+                {
+                    .uBaseVertex = mesh.uBaseVertex,
+                    .uNumVertices = uNumVertices,
+                    .uBaseIndex = mesh.uBaseIndex,
+                    .uNumIndices = mesh.uNumIndices,
+                }
+            );
+        }
+
+        return pOccluderGeometry;
+    }
 }
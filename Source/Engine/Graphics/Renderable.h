@@ -13,7 +13,11 @@
 
 #include "pch.h"
 
+#include "Graphics/Bounds.h"
 #include "Graphics/DataTypes.h"
+#include "Graphics/GeometryArena.h"
+#include "Graphics/Meshlet.h"
+#include "Graphics/OcclusionCuller.h"
 //#include "Shader/PixelShader.h"
 //#include "Shader/VertexShader.h"
 #include "Texture/Material.h"
@@ -25,19 +29,69 @@ namespace pr
 
       Summary:  Base class for all renderable classes
 
-      Methods:  Initialize
+      Methods:  Load
+                  Reads and converts the data of the object on the
+                  CPU, may run on a worker thread
+                Initialize
                   Pure virtual function that initializes the object
                 Update
                   Pure virtual function that updates the object each
                   frame
-                GetVertexBuffer
-                  Returns the vertex buffer
-                GetIndexBuffer
-                  Returns the index buffer
+                Release
+                  Frees the geometry created by Initialize
+                IsStreamable
+                  Returns whether Load and Initialize bring the
+                  renderable back after Release
+                IsResident
+                  Returns whether the geometry is on the GPU
+                GetVertexBufferView
+                  Returns the view of the shared vertex buffer
+                GetIndexBufferView
+                  Returns the view of the shared index buffer
                 GetConstantBuffer
                   Returns the constant buffer
                 GetWorldMatrix
-                  Returns the world matrix
+                  Returns the world matrix computed by the scene
+                SetWorldMatrix
+                  Stores the world matrix computed by the scene
+                GetLocalTransform
+                  Returns the scale, rotation and translation relative
+                  to the parent
+                SetLocalTransform
+                  Replaces the scale, rotation and translation
+                GetTransformVersion
+                  Returns a counter bumped by every local transform
+                  change
+                GetMesh
+                  Returns a mesh with its offsets into the shared
+                  geometry buffers
+                GetMeshEntry
+                  Returns a mesh with its offsets into the geometry
+                  of the renderable
+                SelectLod
+                  Returns the coarsest LOD of a mesh whose error
+                  stays below a pixel threshold on screen
+                GetWorldBounds
+                  Returns the bounds of a mesh in world space
+                GetOccluderGeometry
+                  Returns the CPU copy of the geometry used to
+                  rasterize occluders
+                GetVertices
+                  Returns the CPU copy of the vertices
+                GetPositionDecode
+                  Returns how packed positions map to object space
+                GetIndices
+                  Returns the CPU copy of the indices
+                GetMeshlets
+                  Returns the meshlets of every mesh, if any
+                SharesGeometry
+                  Returns whether two initialized renderables draw
+                  the same buffers
+                IsOccluder
+                  Returns whether the renderable hides others
+                SetOccluder
+                  Marks the renderable as an occluder, takes effect
+                  when it is initialized
                 GetNumVertices
                   Pure virtual function that returns the number of
                   vertices
@@ -53,8 +107,18 @@ namespace pr
     {
     public:
         static constexpr const UINT INVALID_MATERIAL = (0xFFFFFFFF);
+        static constexpr const UINT MAX_LODS = 4u;
+        // Indices are 16-bit and relative to the base vertex of their mesh, importers split larger meshes
+        static constexpr const UINT MAX_MESH_VERTICES = 65536u;
+
+        // Simplified index range drawn with the vertices of the full mesh
+        struct MeshLod
+        {
+            UINT uNumIndices;
+            UINT uBaseIndex;
+            FLOAT Error;
+        };
 
-    protected:
         struct BasicMeshEntry
         {
             BasicMeshEntry()
@@ -62,6 +126,11 @@ namespace pr
                 , uBaseVertex(0u)
                 , uBaseIndex(0u)
                 , uMaterialIndex(INVALID_MATERIAL)
+                , Bounds()
+                , uNumLods(1u)
+                , aLods()
+                , uFirstMeshlet(0u)
+                , uNumMeshlets(0u)
             {
             }
 
@@ -69,6 +138,15 @@ namespace pr
             UINT uBaseVertex;
             UINT uBaseIndex;
             UINT uMaterialIndex;
+            MeshBounds Bounds;
+
+            // LOD 0 is the range above, aLods[i] holds LOD i + 1 with its error in object space
+            UINT uNumLods;
+            MeshLod aLods[MAX_LODS - 1u];
+
+            // Meshlets of LOD 0 in GetMeshlets, none when the renderable has no meshlets
+            UINT uFirstMeshlet;
+            UINT uNumMeshlets;
         };
 
     public:
@@ -80,8 +158,12 @@ namespace pr
         Renderable& operator=(Renderable&& other) = delete;
         virtual ~Renderable() = default;
 
+        virtual HRESULT Load();
         virtual HRESULT Initialize(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList) = 0;
         virtual void Update(_In_ FLOAT deltaTime) = 0;
+        void Release() noexcept;
+        virtual BOOL IsStreamable() const noexcept;
+        BOOL IsResident() const noexcept;
 
         //void SetVertexShader(_In_ const std::shared_ptr<VertexShader>& vertexShader);
         //void SetPixelShader(_In_ const std::shared_ptr<PixelShader>& pixelShader);
@@ -92,18 +174,28 @@ namespace pr
         //ComPtr<ID3D11VertexShader>& GetVertexShader();
         //ComPtr<ID3D11PixelShader>& GetPixelShader();
         //ComPtr<ID3D11InputLayout>& GetVertexLayout();
-        ComPtr<ID3D12Resource>& GetVertexBuffer();
         const D3D12_VERTEX_BUFFER_VIEW& GetVertexBufferView() const noexcept;
-        ComPtr<ID3D12Resource>& GetIndexBuffer();
         const D3D12_INDEX_BUFFER_VIEW& GetIndexBufferView() const noexcept;
         //ComPtr<ID3D11Buffer>& GetConstantBuffer();
         //ComPtr<ID3D11Buffer>& GetNormalBuffer();
 
         const XMMATRIX& GetWorldMatrix() const;
+        void SetWorldMatrix(_In_ const XMMATRIX& world) noexcept;
+        const Transform& GetLocalTransform() const noexcept;
+        void SetLocalTransform(_In_ const Transform& local) noexcept;
+        UINT GetTransformVersion() const noexcept;
         //const XMFLOAT4& GetOutputColor() const;
         //BOOL HasTexture() const;
-        //const std::shared_ptr<Material>& GetMaterial(UINT uIndex) const;
-        const BasicMeshEntry& GetMesh(UINT uIndex) const;
+        const std::shared_ptr<Material>& GetMaterial(UINT uIndex) const;
+        BasicMeshEntry GetMesh(UINT uIndex, UINT uLod = 0u) const;
+        const BasicMeshEntry& GetMeshEntry(UINT uIndex) const;
+        UINT SelectLod(_In_ UINT uMeshIndex, _In_ const XMVECTOR& eyePosition, _In_ FLOAT projectionScale, _In_ FLOAT maxPixelError) const;
+        MeshBounds GetWorldBounds(UINT uMeshIndex) const;
+        const OccluderGeometry* GetOccluderGeometry() const noexcept;
+        const void* GetVertices() const;
+        const WORD* GetIndices() const;
+        const Meshlet* GetMeshlets() const;
+        BOOL SharesGeometry(_In_ const Renderable& other) const noexcept;
 
         void RotateX(_In_ FLOAT angle);
         void RotateY(_In_ FLOAT angle);
@@ -116,14 +208,23 @@ namespace pr
         virtual UINT GetNumIndices() const = 0;
 
         eVertexType GetVertexType() const noexcept;
+        const PositionDecode& GetPositionDecode() const noexcept;
+        eRenderPass GetRenderPass() const noexcept;
+        void SetRenderPass(_In_ eRenderPass renderPass) noexcept;
+        BOOL IsOccluder() const noexcept;
+        void SetOccluder(_In_ BOOL bIsOccluder) noexcept;
         UINT GetNumMeshes() const;
-        //UINT GetNumMaterials() const;
+        UINT GetNumMaterials() const;
         //BOOL HasNormalMap() const;
 
     protected:
         const virtual void* getVertices() const = 0;
         virtual const WORD* getIndices() const = 0;
+        virtual const Meshlet* getMeshlets() const;
         virtual HRESULT initialize(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList);
+        void shareGeometry(_In_ const Renderable& source);
+        static std::shared_ptr<const OccluderGeometry> createOccluderGeometry(_In_ const Renderable& renderable);
+        void rotate(_In_ const XMVECTOR& rotation) noexcept;
 
     protected:
         //ComPtr<ID3D12Resource> m_pConstantBuffer;
@@ -138,15 +239,17 @@ namespace pr
         //XMFLOAT4 m_outputColor;
         //BYTE m_padding[8];
         XMMATRIX m_World;           // 80
+        Transform m_LocalTransform;
+        UINT m_uTransformVersion;
         eVertexType m_VertexType;   // 80
+        eRenderPass m_RenderPass;
+        PositionDecode m_PositionDecode;
 
-        ComPtr<ID3D12Resource> m_pVertexBuffer; // 96
-        ComPtr<ID3D12Resource> m_pVertexUploadBuffer; // 96
-        ComPtr<ID3D12Resource> m_pIndexBuffer;  // 96
-        ComPtr<ID3D12Resource> m_pIndexUploadBuffer;  // 96
-        D3D12_VERTEX_BUFFER_VIEW m_VertexBufferView;   // 112
-        D3D12_INDEX_BUFFER_VIEW m_IndexBufferView;   // 128
+        std::shared_ptr<const GeometryArena::Allocation> m_pGeometryAllocation;
+        ComPtr<ID3D12Resource> m_pUploadBuffer;
+        std::shared_ptr<const OccluderGeometry> m_pOccluderGeometry;
         BOOL m_bHasNormalMap;
+        BOOL m_bIsOccluder;
     };
     //static_assert(sizeof(Renderable) == 160);
 }
\ No newline at end of file
@@ -2,9 +2,13 @@
 
 #include "Graphics/Renderer.h"
 
+#include <algorithm>
+
 #include "Graphics/CommandQueue.h"
 #include "Graphics/GraphicsCommon.h"
+#include "Graphics/VertexQuantization.h"
 #include "Shader/Shader.h"
+#include "Utility/JobSystem.h"
 #include "Utility/Utility.h"
 
 namespace pr
@@ -33,9 +37,21 @@ namespace pr
         , m_pDsvDescriptorHeap()
         , m_pRootSignature()
         , m_pPipelineState()
+        , m_pPackedPipelineState()
+        , m_pCommandSignature()
         , m_pDirectCommandQueue()
         , m_pComputeCommandQueue()
         , m_pCopyCommandQueue()
+        , m_pGpuProfiler()
+        , m_pRenderQueue(std::make_unique<RenderQueue>())
+        , m_pFrustumCuller(std::make_unique<FrustumCuller>())
+        , m_pFrameUploadBuffers(std::make_unique<UploadBuffer[]>(NUM_FRAMEBUFFERS))
+        , m_pIndirectCommandBuilder(std::make_unique<IndirectCommandBuilder>())
+        , m_pShaderArchive(std::make_unique<ShaderArchive>())
+        , m_pPipelineStateCache(std::make_unique<PipelineStateCache>())
+        , m_pOcclusionCuller(std::make_unique<OcclusionCuller>())
+        , m_pLightCuller(std::make_unique<ClusteredLightCuller>())
+        , m_aMeshletRanges()
         , m_Viewport(CD3DX12_VIEWPORT{ 0.0f, 0.0f, static_cast<FLOAT>(DEFAULT_WIDTH), static_cast<FLOAT>(DEFAULT_HEIGHT) })
         , m_ScissorsRect(CD3DX12_RECT{ 0, 0, LONG_MAX, LONG_MAX })
         , m_uRtvDescriptorSize(0u)
@@ -43,6 +59,11 @@ namespace pr
         , m_DriverType(D3D_DRIVER_TYPE_UNKNOWN)
         , m_FeatureLevel(D3D_FEATURE_LEVEL_12_1)
         , m_auFrameFenceValues{}
+        , m_uPipelineKey(0u)
+        , m_uWireframePipelineKey(0u)
+        , m_uPackedPipelineKey(0u)
+        , m_uPackedWireframePipelineKey(0u)
+        , m_MeshletCullStats()
         //, m_pBaseCube(std::make_shared<BaseCube>())
         , m_uWidth(DEFAULT_WIDTH)
         , m_uHeight(DEFAULT_HEIGHT)
@@ -50,6 +71,12 @@ namespace pr
         , m_bIsVSyncEnabled(TRUE)
         , m_bIsTearingSupported(FALSE)
         , m_bIsFullScreen(FALSE)
+        , m_bIsIndirectDrawEnabled(FALSE)
+        , m_bIsWireframeEnabled(FALSE)
+        , m_bIsOcclusionCullingEnabled(TRUE)
+        , m_bIsLodEnabled(TRUE)
+        , m_bIsMeshletCullingEnabled(FALSE)
+        , m_CameraVelocity()
     {
     }
 
@@ -58,6 +85,9 @@ namespace pr
     Renderer::~Renderer() noexcept
     {
         flush();
+
+        HRESULT hr = m_pPipelineStateCache->Save();
+        AssertHresult(hr, L"Renderer::~Renderer >> Saving pipeline state cache");
     }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
@@ -78,6 +108,8 @@ namespace pr
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     HRESULT Renderer::Initialize(_In_ HWND hWnd, _In_ std::unique_ptr<Scene>& pScene) noexcept
     {
+        PR_PROFILE_FUNCTION();
+
         HRESULT hr = S_OK;
 
         // Check for DirectX Math library support
@@ -181,6 +213,12 @@ namespace pr
         hr = m_pCopyCommandQueue->Initialize();
         CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Initializing direct command queue");
 
+#if PR_ENABLE_PROFILING
+        m_pGpuProfiler = std::make_unique<GpuProfiler>();
+        hr = m_pGpuProfiler->Initialize(m_pDevice.Get(), m_pDirectCommandQueue->GetD3D12CommandQueue().Get());
+        CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Initializing GPU profiler");
+#endif
+
         // Describe and create the swap chain
         m_bIsTearingSupported = checkTearingSupport();
         hr = CreateSwapChain(m_pSwapChain, hWnd, pDxgiFactory.Get(), m_pDirectCommandQueue->GetD3D12CommandQueue().Get(), m_uWidth, m_uHeight, NUM_FRAMEBUFFERS, m_bIsTearingSupported);
@@ -227,7 +265,7 @@ namespace pr
         //}
 
         // Initialize the projection matrix
-        m_Projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, static_cast<FLOAT>(m_uWidth) / static_cast<FLOAT>(m_uHeight), 0.01f, 1000.0f);
+        m_Projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, static_cast<FLOAT>(m_uWidth) / static_cast<FLOAT>(m_uHeight), NEAR_Z, FAR_Z);
 
         //CBChangeOnResize cbChangesOnResize =
         //{
@@ -264,15 +302,21 @@ namespace pr
         //    return E_FAIL;
         //}
 
-        // Load the vertex shader
-        ComPtr<ID3DBlob> pVertexShaderBlob;
-        hr = D3DReadFileToBlob((SHADERS_PATH / VS_VERTEX_PCN).c_str(), &pVertexShaderBlob);
-        CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Reading vertex shader");
+        // Map the shader archive, the bytecode is used in place for the lifetime of the renderer
+        hr = m_pShaderArchive->Initialize(SHADER_ARCHIVE_PATH);
+        CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Mapping shader archive");
+
+        D3D12_SHADER_BYTECODE vertexShader = {};
+        hr = m_pShaderArchive->GetBytecode(vertexShader, VS_VERTEX_PCN);
+        CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Finding vertex shader");
+
+        D3D12_SHADER_BYTECODE packedVertexShader = {};
+        hr = m_pShaderArchive->GetBytecode(packedVertexShader, VS_VERTEX_PACKED_PCN);
+        CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Finding packed vertex shader");
 
-        // Load the pixel shader
-        ComPtr<ID3DBlob> pPixelShaderBlob;
-        hr = D3DReadFileToBlob((SHADERS_PATH / PS_DEPTH).c_str(), &pPixelShaderBlob);
-        CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Reading pixel shader");
+        D3D12_SHADER_BYTECODE pixelShader = {};
+        hr = m_pShaderArchive->GetBytecode(pixelShader, PS_CLUSTERED);
+        CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Finding pixel shader");
 
         // Create the vertex input layout
         D3D12_INPUT_ELEMENT_DESC aInputLayout[] =
@@ -306,6 +350,38 @@ namespace pr
             },
         };
 
+        // VertexPackedPNT, the input assembler expands the positions to [0, 1] and the normals to [-1, 1]
+        D3D12_INPUT_ELEMENT_DESC aPackedInputLayout[] =
+        {
+            {
+                .SemanticName = "POSITION",
+                .SemanticIndex = 0,
+                .Format = DXGI_FORMAT_R16G16B16A16_UNORM,
+                .InputSlot = 0,
+                .AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
+                .InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+                .InstanceDataStepRate = 0,
+            },
+            {
+                .SemanticName = "NORMAL",
+                .SemanticIndex = 0,
+                .Format = DXGI_FORMAT_R16G16_SNORM,
+                .InputSlot = 0,
+                .AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
+                .InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+                .InstanceDataStepRate = 0,
+            },
+            {
+                .SemanticName = "TEXCOORD",
+                .SemanticIndex = 0,
+                .Format = DXGI_FORMAT_R16G16_FLOAT,
+                .InputSlot = 0,
+                .AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
+                .InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+                .InstanceDataStepRate = 0,
+            },
+        };
+
         // Create a root signature
         D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData =
         {
@@ -322,14 +398,17 @@ namespace pr
             D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
             D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
             D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS;
-
-        // A single 32-bit constant root parameter that is used by the vertex shader
-        CD3DX12_ROOT_PARAMETER1 aRootParameters[3] = {};
-        aRootParameters[0].InitAsConstants((sizeof(XMMATRIX) + sizeof(XMFLOAT4)) / 4, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
-        aRootParameters[1].InitAsConstants(sizeof(XMMATRIX) / 4, 1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
-        aRootParameters[2].InitAsConstants(sizeof(XMMATRIX) / 4, 2, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+            D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS;
+
+        // Frame constants, the first instance of the draw, the object transforms and the object index of every instance
+        CD3DX12_ROOT_PARAMETER1 aRootParameters[7] = {};
+        aRootParameters[0].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_ALL);
+        aRootParameters[1].InitAsConstants(1, 1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+        aRootParameters[2].InitAsShaderResourceView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_VERTEX);
+        aRootParameters[3].InitAsShaderResourceView(1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_VERTEX);
+        aRootParameters[4].InitAsShaderResourceView(2, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_PIXEL);
+        aRootParameters[5].InitAsShaderResourceView(3, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_PIXEL);
+        aRootParameters[6].InitAsShaderResourceView(4, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_PIXEL);
 
         CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
         rootSignatureDesc.Init_1_1(ARRAYSIZE(aRootParameters), aRootParameters, 0, nullptr, rootSignatureFlags);
@@ -344,41 +423,59 @@ namespace pr
         hr = m_pDevice->CreateRootSignature(0, pRootSignatureBlob->GetBufferPointer(), pRootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(&m_pRootSignature));
         CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Creating root signature");
 
-        struct PipelineStateStream
-        {
-            CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE pRootSignature;
-            CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT InputLayout;
-            CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY PrimitiveTopologyType;
-            CD3DX12_PIPELINE_STATE_STREAM_VS VertexShader;
-            CD3DX12_PIPELINE_STATE_STREAM_PS PixelShader;
-            CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT DsvFormat;
-            CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS RtvFormats;
-        };
+        // Create the command signature of the indirect draws, the first instance goes to root parameter 1
+        D3D12_INDIRECT_ARGUMENT_DESC aIndirectArgumentDescs[IndirectCommandBuilder::NUM_ARGUMENTS];
+        IndirectCommandBuilder::GetArgumentDescs(aIndirectArgumentDescs, 1u);
 
-        D3D12_RT_FORMAT_ARRAY rtvFormats =
-        {
-            .RTFormats = { DXGI_FORMAT_R8G8B8A8_UNORM },
-            .NumRenderTargets = 1,
-        };
+        D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc = IndirectCommandBuilder::GetCommandSignatureDesc(aIndirectArgumentDescs);
+        hr = m_pDevice->CreateCommandSignature(&commandSignatureDesc, m_pRootSignature.Get(), IID_PPV_ARGS(&m_pCommandSignature));
+        CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Creating command signature");
+
+        hr = m_pPipelineStateCache->Initialize(m_pDevice.Get(), PIPELINE_CACHE_PATH);
+        CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Initializing pipeline state cache");
 
-        PipelineStateStream pipelineStateStream =
+        GraphicsPipelineDesc pipelineDesc =
         {
-            .pRootSignature = m_pRootSignature.Get(),
-            .InputLayout = D3D12_INPUT_LAYOUT_DESC{ .pInputElementDescs = aInputLayout, .NumElements = ARRAYSIZE(aInputLayout) },
+            .VertexShader = vertexShader,
+            .PixelShader = pixelShader,
+            .pRootSignatureBlob = pRootSignatureBlob->GetBufferPointer(),
+            .uRootSignatureBlobSize = pRootSignatureBlob->GetBufferSize(),
+            .pInputElementDescs = aInputLayout,
+            .uNumInputElements = ARRAYSIZE(aInputLayout),
             .PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,
-            .VertexShader = CD3DX12_SHADER_BYTECODE(pVertexShaderBlob.Get()),
-            .PixelShader = CD3DX12_SHADER_BYTECODE(pPixelShaderBlob.Get()),
+            .FillMode = D3D12_FILL_MODE_SOLID,
+            .CullMode = D3D12_CULL_MODE_BACK,
+            .bIsDepthEnabled = TRUE,
+            .bIsDepthWriteEnabled = TRUE,
+            .DepthFunc = D3D12_COMPARISON_FUNC_LESS,
+            .bIsBlendEnabled = FALSE,
+            .uNumRenderTargets = 1u,
+            .aRtvFormats = { DXGI_FORMAT_R8G8B8A8_UNORM },
             .DsvFormat = DXGI_FORMAT_D32_FLOAT,
-            .RtvFormats = rtvFormats
+            .uSampleCount = 1u,
         };
 
-        D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc =
-        {
-            .SizeInBytes = sizeof(PipelineStateStream),
-            .pPipelineStateSubobjectStream = &pipelineStateStream
-        };
-        hr = m_pDevice->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&m_pPipelineState));
+        // The main pipeline is the fallback of every other variant, so it has to exist before the first frame
+        hr = m_pPipelineStateCache->Request(m_uPipelineKey, pipelineDesc, m_pRootSignature.Get(), TRUE);
         CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Creating pipeline state");
+        m_pPipelineState = m_pPipelineStateCache->GetPipelineState(m_uPipelineKey, nullptr);
+
+        pipelineDesc.FillMode = D3D12_FILL_MODE_WIREFRAME;
+        hr = m_pPipelineStateCache->Request(m_uWireframePipelineKey, pipelineDesc, m_pRootSignature.Get(), FALSE);
+        CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Requesting wireframe pipeline state");
+
+        // Packed vertices cannot fall back to the main pipeline, so their pipeline is created up front as well
+        pipelineDesc.VertexShader = packedVertexShader;
+        pipelineDesc.pInputElementDescs = aPackedInputLayout;
+        pipelineDesc.uNumInputElements = ARRAYSIZE(aPackedInputLayout);
+        pipelineDesc.FillMode = D3D12_FILL_MODE_SOLID;
+        hr = m_pPipelineStateCache->Request(m_uPackedPipelineKey, pipelineDesc, m_pRootSignature.Get(), TRUE);
+        CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Creating packed pipeline state");
+        m_pPackedPipelineState = m_pPipelineStateCache->GetPipelineState(m_uPackedPipelineKey, nullptr);
+
+        pipelineDesc.FillMode = D3D12_FILL_MODE_WIREFRAME;
+        hr = m_pPipelineStateCache->Request(m_uPackedWireframePipelineKey, pipelineDesc, m_pRootSignature.Get(), FALSE);
+        CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Initialize >> Requesting packed wireframe pipeline state");
 
         ComPtr<ID3D12GraphicsCommandList2> pCommandList;
         hr = m_pCopyCommandQueue->GetCommandList(pCommandList);
@@ -478,6 +575,188 @@ namespace pr
             }
         }
 
+        if (input.IsButtonPressed('I'))
+        {
+            m_bIsIndirectDrawEnabled = !m_bIsIndirectDrawEnabled;
+            input.ProcessedButton('I');
+
+            OutputDebugString(L"Indirect Draw ");
+            if (m_bIsIndirectDrawEnabled)
+            {
+                OutputDebugString(L"Enabled\n");
+            }
+            else
+            {
+                OutputDebugString(L"Disabled\n");
+            }
+        }
+
+        if (input.IsButtonPressed('F'))
+        {
+            m_bIsWireframeEnabled = !m_bIsWireframeEnabled;
+            input.ProcessedButton('F');
+
+            OutputDebugString(L"Wireframe ");
+            if (m_bIsWireframeEnabled)
+            {
+                OutputDebugString(L"Enabled\n");
+            }
+            else
+            {
+                OutputDebugString(L"Disabled\n");
+            }
+        }
+
+        if (input.IsButtonPressed('O'))
+        {
+            m_bIsOcclusionCullingEnabled = !m_bIsOcclusionCullingEnabled;
+            input.ProcessedButton('O');
+
+            OutputDebugString(L"Occlusion Culling ");
+            if (m_bIsOcclusionCullingEnabled)
+            {
+                OutputDebugString(L"Enabled\n");
+            }
+            else
+            {
+                OutputDebugString(L"Disabled\n");
+            }
+        }
+
+        if (input.IsButtonPressed('L'))
+        {
+            m_bIsLodEnabled = !m_bIsLodEnabled;
+            input.ProcessedButton('L');
+
+            OutputDebugString(L"LOD Selection ");
+            if (m_bIsLodEnabled)
+            {
+                OutputDebugString(L"Enabled\n");
+            }
+            else
+            {
+                OutputDebugString(L"Disabled\n");
+            }
+        }
+
+        if (input.IsButtonPressed('M'))
+        {
+            m_bIsMeshletCullingEnabled = !m_bIsMeshletCullingEnabled;
+            input.ProcessedButton('M');
+
+            OutputDebugString(L"Meshlet Culling ");
+            if (m_bIsMeshletCullingEnabled)
+            {
+                OutputDebugString(L"Enabled\n");
+            }
+            else
+            {
+                OutputDebugString(L"Disabled\n");
+            }
+        }
+
+        if (input.IsButtonPressed('K'))
+        {
+            input.ProcessedButton('K');
+
+            HRESULT hr = m_pOcclusionCuller->DumpDepthBuffer(L"OcclusionDepth.pgm");
+            AssertHresult(hr, L"Renderer::HandleInput >> Dumping occlusion depth buffer");
+            if (SUCCEEDED(hr))
+            {
+                OutputDebugString(L"Occlusion depth buffer written to OcclusionDepth.pgm\n");
+            }
+        }
+
+        if (input.IsButtonPressed('P'))
+        {
+            input.ProcessedButton('P');
+            OutputDebugStringA(Profiler::GetInstance().FormatReport().c_str());
+
+            const RenderQueue::Stats& unsortedStats = m_pRenderQueue->GetUnsortedStats();
+            const RenderQueue::Stats& sortedStats = m_pRenderQueue->GetSortedStats();
+            CHAR szStats[256];
+            sprintf_s(
+                szStats,
+                "Draws %u in %u instanced draws, PSO changes %u -> %u, material changes %u -> %u, vertex buffer changes %u -> %u\n",
+                sortedStats.uNumDraws,
+                sortedStats.uNumInstancedDraws,
+                unsortedStats.uNumPsoChanges,
+                sortedStats.uNumPsoChanges,
+                unsortedStats.uNumMaterialChanges,
+                sortedStats.uNumMaterialChanges,
+                unsortedStats.uNumVertexBufferChanges,
+                sortedStats.uNumVertexBufferChanges
+            );
+            OutputDebugStringA(szStats);
+
+            sprintf_s(
+                szStats,
+                "Frustum culling: %u of %u meshes visible\n",
+                m_pFrustumCuller->GetNumVisible(),
+                m_pFrustumCuller->GetNumObjects()
+            );
+            OutputDebugStringA(szStats);
+
+            ClusteredLightCuller::Stats lightStats = m_pLightCuller->GetStats();
+            sprintf_s(
+                szStats,
+                "Light culling: %u of %u lights visible, %u light indices, at most %u lights in a cluster\n",
+                lightStats.uNumVisibleLights,
+                lightStats.uNumLights,
+                lightStats.uNumLightIndices,
+                lightStats.uMaxLightsPerCluster
+            );
+            OutputDebugStringA(szStats);
+
+            OcclusionCuller::Stats occlusionStats = m_pOcclusionCuller->GetStats();
+            sprintf_s(
+                szStats,
+                "Occlusion culling: %u of %u meshes occluded by %u occluders, %u of %u occluder triangles rasterized\n",
+                occlusionStats.uNumOccluded,
+                occlusionStats.uNumObjects,
+                occlusionStats.uNumOccluders,
+                occlusionStats.uNumRasterizedTriangles,
+                occlusionStats.uNumOccluderTriangles
+            );
+            OutputDebugStringA(szStats);
+
+            sprintf_s(
+                szStats,
+                "Meshlet culling: %u meshlets, %u outside the frustum, %u back facing, %u index ranges drawn\n",
+                m_MeshletCullStats.uNumMeshlets,
+                m_MeshletCullStats.uNumFrustumCulled,
+                m_MeshletCullStats.uNumBackFacing,
+                m_MeshletCullStats.uNumRanges
+            );
+            OutputDebugStringA(szStats);
+
+            GeometryArena::Stats arenaStats = GeometryArena::GetInstance().GetStats();
+            sprintf_s(
+                szStats,
+                "Geometry arena: %u allocations, vertices %llu / %llu bytes, indices %llu / %llu bytes, %u free blocks, %u defragmentations\n",
+                arenaStats.uNumAllocations,
+                arenaStats.uVertexBytesUsed,
+                arenaStats.uVertexBufferSize,
+                arenaStats.uIndexBytesUsed,
+                arenaStats.uIndexBufferSize,
+                arenaStats.uNumFreeBlocks,
+                arenaStats.uNumDefragmentations
+            );
+            OutputDebugStringA(szStats);
+
+            PipelineStateCache::Stats pipelineStats = m_pPipelineStateCache->GetStats();
+            sprintf_s(
+                szStats,
+                "Pipeline states: %u (%u pending), %u loaded from disk, %u compiled, %u fallbacks\n",
+                pipelineStats.uNumPipelines,
+                pipelineStats.uNumPending,
+                pipelineStats.uNumLoadedFromDisk,
+                pipelineStats.uNumCompiled,
+                pipelineStats.uNumFallbacks
+            );
+            OutputDebugStringA(szStats);
+        }
+
         m_Camera.HandleInput(input, mouseInput, deltaTime);
     }
 
@@ -493,7 +772,14 @@ namespace pr
     {
         //m_scenes[m_pszMainSceneName]->Update(deltaTime);
 
+        XMVECTOR previousEye = m_Camera.GetEye();
         m_Camera.Update(deltaTime);
+
+        // Streaming looks ahead along the camera movement
+        if (deltaTime > 0.0f)
+        {
+            XMStoreFloat3(&m_CameraVelocity, (m_Camera.GetEye() - previousEye) / deltaTime);
+        }
     }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
@@ -503,11 +789,47 @@ namespace pr
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     HRESULT Renderer::Render(const std::unique_ptr<Scene>& pScene)
     {
+        PR_PROFILE_FUNCTION();
+
         HRESULT hr = S_OK;
+
+        // The last frame finished, so evicted geometry is unused. The uploads go in their own command list, between
+        // command lists the geometry buffers return to the common state the draws of the frame promote them from
+        if (pScene->GetStreamer())
+        {
+            PR_PROFILE_SCOPE("Streaming");
+
+            ComPtr<ID3D12GraphicsCommandList2> pStreamingCommandList;
+            hr = m_pDirectCommandQueue->GetCommandList(pStreamingCommandList);
+            CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Getting streaming command list");
+
+            XMFLOAT4X4 viewProjection;
+            XMStoreFloat4x4(&viewProjection, m_Camera.GetView() * m_Projection);
+
+            StreamingPolicy::View view =
+            {
+                .Velocity = m_CameraVelocity,
+                .ViewFrustum = ExtractFrustum(viewProjection),
+            };
+            XMStoreFloat3(&view.Position, m_Camera.GetEye());
+
+            hr = pScene->UpdateStreaming(view, m_pDevice.Get(), pStreamingCommandList.Get());
+            CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Streaming scene");
+
+            UINT64 uFenceValue = 0u;
+            hr = m_pDirectCommandQueue->ExecuteCommandList(uFenceValue, pStreamingCommandList.Get());
+            CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Executing streaming command list");
+        }
+
         ComPtr<ID3D12GraphicsCommandList2> pCommandList;
         hr = m_pDirectCommandQueue->GetCommandList(pCommandList);
         CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Getting command list");
 
+#if PR_ENABLE_PROFILING
+        hr = m_pGpuProfiler->BeginFrame(m_uCurrentBackBufferIndex);
+        CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Reading back GPU timestamps");
+#endif
+
         UINT uCurrentBackBufferIndex = m_uCurrentBackBufferIndex;
         ID3D12Resource* pBackBuffer = m_apBackBuffers[m_uCurrentBackBufferIndex].Get();
         D3D12_CPU_DESCRIPTOR_HANDLE rtv = getCurrentRtv();
@@ -515,6 +837,8 @@ namespace pr
 
         // Clear
         {
+            PR_PROFILE_GPU_SCOPE(m_pGpuProfiler.get(), pCommandList.Get(), "Clear");
+
             // Transit to RENDER_TARGET state
             TransitResource(pCommandList.Get(), pBackBuffer, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
 
@@ -524,47 +848,355 @@ namespace pr
             ClearDepth(pCommandList.Get(), dsv);
         }
 
-        pCommandList->SetPipelineState(m_pPipelineState.Get());
-        pCommandList->SetGraphicsRootSignature(m_pRootSignature.Get());
-        pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        // Draw
+        {
+            PR_PROFILE_SCOPE("Record");
+            PR_PROFILE_GPU_SCOPE(m_pGpuProfiler.get(), pCommandList.Get(), "Main Pass");
 
-        pCommandList->RSSetViewports(1, &m_Viewport);
-        pCommandList->RSSetScissorRects(1, &m_ScissorsRect);
+            // The pipeline follows the vertex type of the draws, which the queue sorts by
+            pCommandList->SetGraphicsRootSignature(m_pRootSignature.Get());
+            pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-        pCommandList->OMSetRenderTargets(1, &rtv, FALSE, &dsv);
+            pCommandList->RSSetViewports(1, &m_Viewport);
+            pCommandList->RSSetScissorRects(1, &m_ScissorsRect);
 
-        Camera::ConstantBuffer cbCamera =
-        {
-            .View = m_Camera.GetView(),
-        };
-        XMStoreFloat4(&cbCamera.Position, m_Camera.GetAt());
+            pCommandList->OMSetRenderTargets(1, &rtv, FALSE, &dsv);
 
-        pCommandList->SetGraphicsRoot32BitConstants(0, (sizeof(XMMATRIX) + sizeof(XMFLOAT4)) / 4, &cbCamera, 0);
-        pCommandList->SetGraphicsRoot32BitConstants(1, (sizeof(XMMATRIX)) / 4, &m_Projection, 0);
+            XMFLOAT4X4 viewProjection;
+            XMStoreFloat4x4(&viewProjection, m_Camera.GetView() * m_Projection);
 
-        for (auto& iter : pScene->GetRenderables())
-        {
-            pCommandList->IASetVertexBuffers(0, 1, &iter.second->GetVertexBufferView());
-            pCommandList->IASetIndexBuffer(&iter.second->GetIndexBufferView());
+            // The scene keeps its renderables in dense arrays, so every pass below walks them linearly
+            const std::vector<std::shared_ptr<Renderable>>& aRenderables = pScene->GetRenderables();
+            const XMFLOAT4X4* aWorldMatrices = pScene->GetWorldMatrices();
+            const UINT* auSceneFlags = pScene->GetFlags();
+            const UINT* auFirstMeshes = pScene->GetFirstMeshes();
+            const MeshBounds* aMeshBounds = pScene->GetMeshBounds();
+            const UINT uNumRenderables = pScene->GetNumRenderables();
+
+            // Cull every mesh against the view frustum, the scene hierarchy skips whole groups of meshes at once
+            {
+                PR_PROFILE_SCOPE("Frustum Culling");
+
+                m_pFrustumCuller->Cull(ExtractFrustum(viewProjection), pScene->GetBoundingVolumeHierarchy(), JobSystem::GetInstance());
+            }
+
+            // Rasterize the occluders that survived frustum culling and test the other survivors against them
+            m_pOcclusionCuller->Reset();
+            if (m_bIsOcclusionCullingEnabled)
+            {
+                PR_PROFILE_SCOPE("Occlusion Culling");
+
+                for (UINT uRenderable = 0u; uRenderable < uNumRenderables; ++uRenderable)
+                {
+                    const Renderable* pRenderable = aRenderables[uRenderable].get();
+                    if (!pRenderable->IsResident())
+                    {
+                        continue;
+                    }
+
+                    BOOL bIsOccluder = (auSceneFlags[uRenderable] & Scene::RENDERABLE_FLAG_OCCLUDER) && pRenderable->GetOccluderGeometry();
+
+                    for (UINT i = 0u; i < pRenderable->GetNumMeshes(); ++i)
+                    {
+                        UINT uCullIndex = auFirstMeshes[uRenderable] + i;
+                        if (!m_pFrustumCuller->IsVisible(uCullIndex))
+                        {
+                            continue;
+                        }
+
+                        if (bIsOccluder)
+                        {
+                            m_pOcclusionCuller->AddOccluder(*pRenderable->GetOccluderGeometry(), i, aWorldMatrices[uRenderable]);
+                        }
+                        m_pOcclusionCuller->AddBounds(aMeshBounds[uCullIndex]);
+                    }
+                }
+
+                m_pOcclusionCuller->Cull(viewProjection, JobSystem::GetInstance());
+            }
+
+            // Bin the scene lights into the froxels of the view frustum
+            {
+                PR_PROFILE_SCOPE("Light Culling");
+
+                XMFLOAT4X4 projection;
+                XMStoreFloat4x4(&projection, m_Projection);
+                m_pLightCuller->SetProjection(projection, NEAR_Z, FAR_Z);
+
+                XMFLOAT4X4 view;
+                XMStoreFloat4x4(&view, m_Camera.GetView());
+                const std::vector<LightData>& aLights = pScene->GetLights();
+                m_pLightCuller->Cull(view, aLights.data(), static_cast<UINT>(aLights.size()), JobSystem::GetInstance());
+            }
+
+            // Build and sort the draw list so state changes are grouped
+            m_pRenderQueue->Reset();
+            m_MeshletCullStats = {};
+            const FLOAT projectionScale = 0.5f * m_Viewport.Height * XMVectorGetY(m_Projection.r[1]);
+            UINT uOcclusionIndex = 0u;
+            for (UINT uObjectIndex = 0u; uObjectIndex < uNumRenderables; ++uObjectIndex)
+            {
+                Renderable* pRenderable = aRenderables[uObjectIndex].get();
+
+                // Streamed renderables are culled while released, but only drawn and tested for occlusion once resident
+                if (!pRenderable->IsResident())
+                {
+                    continue;
+                }
+
+                const XMFLOAT4X4& world = aWorldMatrices[uObjectIndex];
+                FLOAT viewDepth = XMVectorGetZ(XMVector3Transform(XMVectorSet(world._41, world._42, world._43, 1.0f), m_Camera.GetView()));
+                UINT uDepth = DrawSortKey::QuantizeDepth(viewDepth, NEAR_Z, FAR_Z);
+
+                // Meshlets are culled in object space, the frustum and the eye are moved there once per object
+                Frustum objectFrustum = {};
+                XMFLOAT3 objectEye = {};
+                BOOL bCanCullMeshlets = FALSE;
+                if (m_bIsMeshletCullingEnabled && pRenderable->GetMeshlets())
+                {
+                    XMMATRIX objectWorld = XMLoadFloat4x4(&world);
+                    XMVECTOR determinant;
+                    XMMATRIX inverseWorld = XMMatrixInverse(&determinant, objectWorld);
+
+                    // Mirroring flips which side of the triangles the rasterizer culls, such objects draw whole meshes
+                    bCanCullMeshlets = XMVectorGetX(determinant) > 0.0f;
+
+                    XMFLOAT4X4 objectViewProjection;
+                    XMStoreFloat4x4(&objectViewProjection, objectWorld * XMLoadFloat4x4(&viewProjection));
+                    objectFrustum = ExtractFrustum(objectViewProjection);
+                    XMStoreFloat3(&objectEye, XMVector3TransformCoord(m_Camera.GetEye(), inverseWorld));
+                }
+
+                for (UINT i = 0u; i < pRenderable->GetNumMeshes(); ++i)
+                {
+                    if (!m_pFrustumCuller->IsVisible(auFirstMeshes[uObjectIndex] + i))
+                    {
+                        continue;
+                    }
+
+                    // The occlusion culler only knows the meshes inside the frustum
+                    if (m_bIsOcclusionCullingEnabled && !m_pOcclusionCuller->IsVisible(uOcclusionIndex++))
+                    {
+                        continue;
+                    }
+
+                    UINT uLod = m_bIsLodEnabled ? pRenderable->SelectLod(i, m_Camera.GetEye(), projectionScale, MAX_LOD_PIXEL_ERROR) : 0u;
+                    const UINT uPso = static_cast<UINT>(pRenderable->GetVertexType());
+
+                    // Simplified LODs have no meshlets, they are drawn whole
+                    const Renderable::BasicMeshEntry& mesh = pRenderable->GetMeshEntry(i);
+                    if (bCanCullMeshlets && uLod == 0u && mesh.uNumMeshlets > 0u)
+                    {
+                        if (m_aMeshletRanges.size() < mesh.uNumMeshlets)
+                        {
+                            m_aMeshletRanges.resize(mesh.uNumMeshlets);
+                        }
+
+                        UINT uNumRanges = CullMeshlets(
+                            m_aMeshletRanges.data(),
+                            pRenderable->GetMeshlets() + mesh.uFirstMeshlet,
+                            mesh.uNumMeshlets,
+                            objectFrustum,
+                            objectEye,
+                            &m_MeshletCullStats
+                        );
+                        for (UINT j = 0u; j < uNumRanges; ++j)
+                        {
+                            m_pRenderQueue->AddDraw(pRenderable, i, m_aMeshletRanges[j], uObjectIndex, uPso, uDepth);
+                        }
+                        continue;
+                    }
+
+                    m_pRenderQueue->AddDraw(pRenderable, i, uLod, uObjectIndex, uPso, uDepth);
+                }
+            }
+            m_pRenderQueue->Sort();
+            m_pRenderQueue->BuildInstancedDraws();
+
+            // Write the frame constants, every object transform and the instance object indices once,
+            // back to back in this frame's upload buffer
+            {
+                PR_PROFILE_SCOPE("Upload Constants");
+
+                UploadBuffer& frameUploadBuffer = m_pFrameUploadBuffers[uCurrentBackBufferIndex];
+                frameUploadBuffer.Reset();
+
+                UploadBuffer::Allocation frameAllocation;
+                hr = frameUploadBuffer.Allocate(frameAllocation, m_pDevice.Get(), sizeof(FrameConstants), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+                CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Allocating frame constants");
+
+                FrameConstants* pFrameConstants = static_cast<FrameConstants*>(frameAllocation.pCpu);
+                pFrameConstants->View = m_Camera.GetView();
+                pFrameConstants->Projection = m_Projection;
+                XMStoreFloat4(&pFrameConstants->CameraPosition, m_Camera.GetAt());
+                pFrameConstants->ClusterParameters = m_pLightCuller->GetShaderParameters(m_Viewport.Width, m_Viewport.Height);
+
+                pCommandList->SetGraphicsRootConstantBufferView(0, frameAllocation.Gpu);
+
+                // Root descriptors cannot be null, so empty light lists still get one element
+                const std::vector<LightData>& aLights = pScene->GetLights();
+                UploadBuffer::Allocation lightAllocation;
+                hr = frameUploadBuffer.Allocate(lightAllocation, m_pDevice.Get(), sizeof(LightData) * std::max<size_t>(aLights.size(), 1u), sizeof(XMFLOAT4));
+                CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Allocating lights");
+                if (!aLights.empty())
+                {
+                    memcpy(lightAllocation.pCpu, aLights.data(), sizeof(LightData) * aLights.size());
+                }
+                pCommandList->SetGraphicsRootShaderResourceView(4, lightAllocation.Gpu);
+
+                UploadBuffer::Allocation clusterAllocation;
+                hr = frameUploadBuffer.Allocate(clusterAllocation, m_pDevice.Get(), sizeof(LightCluster) * ClusteredLightCuller::NUM_CLUSTERS, sizeof(LightCluster));
+                CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Allocating light clusters");
+                memcpy(clusterAllocation.pCpu, m_pLightCuller->GetClusters(), sizeof(LightCluster) * ClusteredLightCuller::NUM_CLUSTERS);
+                pCommandList->SetGraphicsRootShaderResourceView(5, clusterAllocation.Gpu);
+
+                UploadBuffer::Allocation lightIndexAllocation;
+                hr = frameUploadBuffer.Allocate(lightIndexAllocation, m_pDevice.Get(), sizeof(UINT) * std::max(m_pLightCuller->GetNumLightIndices(), 1u), sizeof(UINT));
+                CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Allocating light indices");
+                if (m_pLightCuller->GetNumLightIndices() > 0u)
+                {
+                    memcpy(lightIndexAllocation.pCpu, m_pLightCuller->GetLightIndices(), sizeof(UINT) * m_pLightCuller->GetNumLightIndices());
+                }
+                pCommandList->SetGraphicsRootShaderResourceView(6, lightIndexAllocation.Gpu);
+
+                if (uNumRenderables > 0u)
+                {
+                    UploadBuffer::Allocation objectAllocation;
+                    hr = frameUploadBuffer.Allocate(objectAllocation, m_pDevice.Get(), sizeof(ObjectConstants) * uNumRenderables, sizeof(XMFLOAT4));
+                    CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Allocating object constants");
+
+                    ObjectConstants* aObjectConstants = static_cast<ObjectConstants*>(objectAllocation.pCpu);
+                    for (UINT i = 0u; i < uNumRenderables; ++i)
+                    {
+                        XMMATRIX world = XMLoadFloat4x4(&aWorldMatrices[i]);
+
+                        // Packed positions are normalized to the bounds of the geometry, the decode goes before the world transform
+                        if (aRenderables[i]->GetVertexType() == eVertexType::POS_NORM_TEXCOORD_PACKED)
+                        {
+                            world = GetPositionDecodeMatrix(aRenderables[i]->GetPositionDecode()) * world;
+                        }
+                        XMStoreFloat3x4(&aObjectConstants[i].World, world);
+                    }
+
+                    pCommandList->SetGraphicsRootShaderResourceView(2, objectAllocation.Gpu);
+                }
+
+                if (m_pRenderQueue->GetNumInstances() > 0u)
+                {
+                    UploadBuffer::Allocation instanceAllocation;
+                    hr = frameUploadBuffer.Allocate(instanceAllocation, m_pDevice.Get(), sizeof(UINT) * m_pRenderQueue->GetNumInstances(), sizeof(UINT));
+                    CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Allocating instance object indices");
 
-            pCommandList->SetGraphicsRoot32BitConstants(2, (sizeof(XMMATRIX)) / 4, &iter.second->GetWorldMatrix(), 0);
+                    memcpy(instanceAllocation.pCpu, m_pRenderQueue->GetInstanceObjectIndices(), sizeof(UINT) * m_pRenderQueue->GetNumInstances());
 
-            for (UINT i = 0u; i < iter.second->GetNumMeshes(); ++i)
+                    pCommandList->SetGraphicsRootShaderResourceView(3, instanceAllocation.Gpu);
+                }
+            }
+
+            if (m_bIsIndirectDrawEnabled)
             {
-                pCommandList->DrawIndexedInstanced(
-                    iter.second->GetMesh(i).uNumIndices,
-                    1, 
-                    iter.second->GetMesh(i).uBaseIndex,
-                    iter.second->GetMesh(i).uBaseVertex,
-                    0
-                );
+                // Whole pass in one ExecuteIndirect, every command rebinds its geometry and first instance
+                m_pIndirectCommandBuilder->Reset();
+                for (UINT i = 0u; i < m_pRenderQueue->GetNumInstancedDraws(); ++i)
+                {
+                    const RenderQueue::InstancedDraw& draw = m_pRenderQueue->GetInstancedDraw(i);
+                    const auto mesh = draw.pRenderable->GetMesh(draw.uMesh, draw.uLod);
+                    m_pIndirectCommandBuilder->AddDraw(
+                        draw.pRenderable->GetVertexBufferView(),
+                        draw.pRenderable->GetIndexBufferView(),
+                        draw.uFirstInstance,
+                        draw.uNumIndices,
+                        draw.uNumInstances,
+                        draw.uBaseIndex,
+                        static_cast<INT>(mesh.uBaseVertex)
+                    );
+                }
+
+                if (m_pIndirectCommandBuilder->GetNumCommands() > 0u)
+                {
+                    UploadBuffer::Allocation argumentAllocation;
+                    hr = m_pFrameUploadBuffers[uCurrentBackBufferIndex].Allocate(argumentAllocation, m_pDevice.Get(), m_pIndirectCommandBuilder->GetSizeInBytes(), sizeof(UINT64));
+                    CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Allocating indirect arguments");
+
+                    m_pIndirectCommandBuilder->WriteTo(argumentAllocation.pCpu);
+
+                    // Command signatures cannot change the pipeline, so each run of draws of one vertex type is an ExecuteIndirect
+                    const UINT uNumCommands = m_pIndirectCommandBuilder->GetNumCommands();
+                    UINT uFirstCommand = 0u;
+                    for (UINT i = 1u; i <= uNumCommands; ++i)
+                    {
+                        eVertexType vertexType = m_pRenderQueue->GetInstancedDraw(uFirstCommand).pRenderable->GetVertexType();
+                        if (i < uNumCommands && m_pRenderQueue->GetInstancedDraw(i).pRenderable->GetVertexType() == vertexType)
+                        {
+                            continue;
+                        }
+
+                        pCommandList->SetPipelineState(getPipelineState(vertexType));
+                        pCommandList->ExecuteIndirect(
+                            m_pCommandSignature.Get(),
+                            i - uFirstCommand,
+                            argumentAllocation.pResource,
+                            argumentAllocation.Offset + sizeof(IndirectDrawCommand) * uFirstCommand,
+                            nullptr,
+                            0u
+                        );
+                        uFirstCommand = i;
+                    }
+                }
             }
+            else
+            {
+                D3D12_GPU_VIRTUAL_ADDRESS boundVertexBuffer = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
+                D3D12_GPU_VIRTUAL_ADDRESS boundIndexBuffer = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
+                eVertexType boundVertexType = eVertexType::COUNT;
+                for (UINT i = 0u; i < m_pRenderQueue->GetNumInstancedDraws(); ++i)
+                {
+                    const RenderQueue::InstancedDraw& draw = m_pRenderQueue->GetInstancedDraw(i);
+                    if (draw.pRenderable->GetVertexType() != boundVertexType)
+                    {
+                        boundVertexType = draw.pRenderable->GetVertexType();
+                        pCommandList->SetPipelineState(getPipelineState(boundVertexType));
+                    }
+                    if (draw.pRenderable->GetVertexBufferView().BufferLocation != boundVertexBuffer)
+                    {
+                        pCommandList->IASetVertexBuffers(0, 1, &draw.pRenderable->GetVertexBufferView());
+                        boundVertexBuffer = draw.pRenderable->GetVertexBufferView().BufferLocation;
+                    }
+                    if (draw.pRenderable->GetIndexBufferView().BufferLocation != boundIndexBuffer)
+                    {
+                        pCommandList->IASetIndexBuffer(&draw.pRenderable->GetIndexBufferView());
+                        boundIndexBuffer = draw.pRenderable->GetIndexBufferView().BufferLocation;
+                    }
+
+                    // SV_InstanceID does not include the start instance, so the offset is passed explicitly
+                    pCommandList->SetGraphicsRoot32BitConstant(1, draw.uFirstInstance, 0);
+
+                    const auto mesh = draw.pRenderable->GetMesh(draw.uMesh, draw.uLod);
+                    pCommandList->DrawIndexedInstanced(
+                        draw.uNumIndices,
+                        draw.uNumInstances,
+                        draw.uBaseIndex,
+                        mesh.uBaseVertex,
+                        0
+                    );
+                }
+            }
+
+            // Compact geometry freed since the last frame, the draws above still reference the old buffers
+            hr = GeometryArena::GetInstance().Defragment(m_pDevice.Get(), pCommandList.Get());
+            CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Defragmenting geometry arena");
         }
 
         // Present
         {
+            PR_PROFILE_SCOPE("Present");
+
             TransitResource(pCommandList.Get(), pBackBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
 
+#if PR_ENABLE_PROFILING
+            m_pGpuProfiler->EndFrame(pCommandList.Get());
+#endif
+
             hr = m_pDirectCommandQueue->ExecuteCommandList(m_auFrameFenceValues[uCurrentBackBufferIndex], pCommandList.Get());
             CHECK_AND_RETURN_HRESULT(hr, L"Renderer::Render >> Executing direct command queue");
 
@@ -678,6 +1310,16 @@ namespace pr
         return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_pRtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), m_uCurrentBackBufferIndex, m_uRtvDescriptorSize);
     }
 
+    ID3D12PipelineState* Renderer::getPipelineState(_In_ eVertexType vertexType) const
+    {
+        // Variants draw with the main pipeline of their vertex type until their background compile finishes
+        if (vertexType == eVertexType::POS_NORM_TEXCOORD_PACKED)
+        {
+            return m_pPipelineStateCache->GetPipelineState(m_bIsWireframeEnabled ? m_uPackedWireframePipelineKey : m_uPackedPipelineKey, m_pPackedPipelineState.Get());
+        }
+        return m_pPipelineStateCache->GetPipelineState(m_bIsWireframeEnabled ? m_uWireframePipelineKey : m_uPipelineKey, m_pPipelineState.Get());
+    }
+
     HRESULT Renderer::present(_Out_ UINT& uOutCurrentBackBufferIndex) noexcept
     {
         HRESULT hr = S_OK;
@@ -15,13 +15,24 @@
 
 #include "Camera/Camera.h"
 #include "Graphics/BaseCube.h"
+#include "Graphics/ClusteredLightCuller.h"
 #include "Graphics/CommandQueue.h"
+#include "Graphics/FrustumCuller.h"
+#include "Graphics/GeometryArena.h"
+#include "Graphics/GpuProfiler.h"
+#include "Graphics/IndirectCommandBuilder.h"
+#include "Graphics/Meshlet.h"
+#include "Graphics/OcclusionCuller.h"
+#include "Graphics/PipelineStateCache.h"
+#include "Graphics/RenderQueue.h"
+#include "Graphics/UploadBuffer.h"
 #include "Input/Input.h"
 //#include "Light/PointLight.h"
 //#include "Model/Model.h"
 //#include "Renderer/DataTypes.h"
 //#include "Renderer/Renderable.h"
 #include "Scene/Scene.h"
+#include "Shader/ShaderArchive.h"
 //#include "Shader/PixelShader.h"
 //#include "Shader/VertexShader.h"
 //#include "Texture/RenderTexture.h"
@@ -71,53 +82,81 @@ namespace pr
         D3D_DRIVER_TYPE GetDriverType() const;
 
         static constexpr const size_t NUM_FRAMEBUFFERS = 3;
+        static constexpr const FLOAT NEAR_Z = 0.01f;
+        static constexpr const FLOAT FAR_Z = 1000.0f;
+        static constexpr const FLOAT MAX_LOD_PIXEL_ERROR = 1.0f;
 
     protected:
         BOOL checkTearingSupport() const noexcept;
         HRESULT flush() noexcept;
         D3D12_CPU_DESCRIPTOR_HANDLE getCurrentRtv() const noexcept;
+        ID3D12PipelineState* getPipelineState(_In_ eVertexType vertexType) const;
         HRESULT present(_Out_ UINT& uOutCurrentBackBufferIndex) noexcept;
         HRESULT resizeDepthBuffer(UINT uWidth, UINT uHeight) noexcept;
 
     private:
-        Camera m_Camera;                                                        // 272      >>  272
-
-        XMMATRIX m_Projection;                                                  // 64       >>  336
-
-        ComPtr<ID3D12Device2> m_pDevice;                                        // 8 + 0    >>  352
-        ComPtr<IDXGISwapChain4> m_pSwapChain;                                   // 8 + 8    >>  352
-        ComPtr<ID3D12Resource> m_apBackBuffers[NUM_FRAMEBUFFERS];               // 16 + 0    >>  368 >>  8 + 0  >>  384
-        ComPtr<ID3D12DescriptorHeap> m_pRtvDescriptorHeap;                      // 8 + 8    >>  384
-        ComPtr<ID3D12Resource> m_pDepthBuffer;                                  // 8 + 0    >>  400
-        ComPtr<ID3D12DescriptorHeap> m_pDsvDescriptorHeap;                      // 8 + 8    >>  400
-        ComPtr<ID3D12RootSignature> m_pRootSignature;                           // 8 + 0    >>  416
-        ComPtr<ID3D12PipelineState> m_pPipelineState;                           // 8 + 8    >>  416
-
-        std::shared_ptr<CommandQueue> m_pDirectCommandQueue;                    // 16 + 0   >>  432
-        std::shared_ptr<CommandQueue> m_pComputeCommandQueue;                   // 16 + 0   >>  448
-        std::shared_ptr<CommandQueue> m_pCopyCommandQueue;                      // 16 + 0   >>  464
-
-        D3D12_VIEWPORT m_Viewport;                                              // 16 + 0   >>  480 >>  8 + 0   >>  496
-        D3D12_RECT m_ScissorsRect;                                              // 8 + 8    >>  496 >>  8 + 0   >>  512
-
-        UINT m_uRtvDescriptorSize;                                              // 4 + 8    >>  512
-        UINT m_uCurrentBackBufferIndex;                                         // 4 + 12   >>  512
-
-        D3D_DRIVER_TYPE m_DriverType;                                           // 4 + 0    >>  528
-        D3D_FEATURE_LEVEL m_FeatureLevel;                                       // 4 + 4    >>  528
-
-        UINT64 m_auFrameFenceValues[NUM_FRAMEBUFFERS];                          // 8 + 8    >>  528 >>  16 + 0   >> 544
-
-        //std::shared_ptr<BaseCube> m_pBaseCube;                                  // 16 + 0   >>  560
-
-        UINT m_uWidth;                                                          // 4 + 0    >>  576
-        UINT m_uHeight;                                                         // 4 + 4    >>  576
-        FLOAT m_FoV;                                                            // 4 + 8    >>  576
-
-        BOOL m_bIsVSyncEnabled;                                                 // 4 + 12   >>  576
-        BOOL m_bIsTearingSupported;                                             // 4 + 0    >>  592
-        BOOL m_bIsFullScreen;                                                   // 4 + 4    >>  592
+        Camera m_Camera;
+
+        XMMATRIX m_Projection;
+
+        ComPtr<ID3D12Device2> m_pDevice;
+        ComPtr<IDXGISwapChain4> m_pSwapChain;
+        ComPtr<ID3D12Resource> m_apBackBuffers[NUM_FRAMEBUFFERS];
+        ComPtr<ID3D12DescriptorHeap> m_pRtvDescriptorHeap;
+        ComPtr<ID3D12Resource> m_pDepthBuffer;
+        ComPtr<ID3D12DescriptorHeap> m_pDsvDescriptorHeap;
+        ComPtr<ID3D12RootSignature> m_pRootSignature;
+        ComPtr<ID3D12PipelineState> m_pPipelineState;
+        ComPtr<ID3D12PipelineState> m_pPackedPipelineState;
+        ComPtr<ID3D12CommandSignature> m_pCommandSignature;
+
+        std::shared_ptr<CommandQueue> m_pDirectCommandQueue;
+        std::shared_ptr<CommandQueue> m_pComputeCommandQueue;
+        std::shared_ptr<CommandQueue> m_pCopyCommandQueue;
+        std::unique_ptr<GpuProfiler> m_pGpuProfiler;
+        std::unique_ptr<RenderQueue> m_pRenderQueue;
+        std::unique_ptr<FrustumCuller> m_pFrustumCuller;
+        std::unique_ptr<UploadBuffer[]> m_pFrameUploadBuffers;
+        std::unique_ptr<IndirectCommandBuilder> m_pIndirectCommandBuilder;
+        std::unique_ptr<ShaderArchive> m_pShaderArchive;
+        std::unique_ptr<PipelineStateCache> m_pPipelineStateCache;
+        std::unique_ptr<OcclusionCuller> m_pOcclusionCuller;
+        std::unique_ptr<ClusteredLightCuller> m_pLightCuller;
+        std::vector<MeshletRange> m_aMeshletRanges;
+
+        D3D12_VIEWPORT m_Viewport;
+        D3D12_RECT m_ScissorsRect;
+
+        UINT m_uRtvDescriptorSize;
+        UINT m_uCurrentBackBufferIndex;
+
+        D3D_DRIVER_TYPE m_DriverType;
+        D3D_FEATURE_LEVEL m_FeatureLevel;
+
+        UINT64 m_auFrameFenceValues[NUM_FRAMEBUFFERS];
+        UINT64 m_uPipelineKey;
+        UINT64 m_uWireframePipelineKey;
+        UINT64 m_uPackedPipelineKey;
+        UINT64 m_uPackedWireframePipelineKey;
+        MeshletCullStats m_MeshletCullStats;
+
+        //std::shared_ptr<BaseCube> m_pBaseCube;
+
+        UINT m_uWidth;
+        UINT m_uHeight;
+        FLOAT m_FoV;
+
+        BOOL m_bIsVSyncEnabled;
+        BOOL m_bIsTearingSupported;
+        BOOL m_bIsFullScreen;
+        BOOL m_bIsIndirectDrawEnabled;
+        BOOL m_bIsWireframeEnabled;
+        BOOL m_bIsOcclusionCullingEnabled;
+        BOOL m_bIsLodEnabled;
+        BOOL m_bIsMeshletCullingEnabled;
+
+        XMFLOAT3 m_CameraVelocity;
     };
     static_assert(sizeof(Renderer) % 16 == 0);
-    static_assert(sizeof(Renderer) == 576);
+    static_assert(Renderer::NUM_FRAMEBUFFERS == Profiler::NUM_FRAMES);
 }
\ No newline at end of file
@@ -0,0 +1,350 @@
+#include "pch.h"
+
+#include "Graphics/TransformBatch.h"
+
+#include <immintrin.h>
+
+namespace pr
+{
+	namespace
+	{
+#if defined(__AVX__)
+		using Lanes = __m256;
+		constexpr const UINT NUM_LANES = 8u;
+
+		inline Lanes load(_In_ const FLOAT* p) noexcept { return _mm256_loadu_ps(p); }
+		inline void store(_Out_ FLOAT* p, _In_ Lanes a) noexcept { _mm256_storeu_ps(p, a); }
+		inline Lanes splat(_In_ FLOAT f) noexcept { return _mm256_set1_ps(f); }
+		inline Lanes add(_In_ Lanes a, _In_ Lanes b) noexcept { return _mm256_add_ps(a, b); }
+		inline Lanes sub(_In_ Lanes a, _In_ Lanes b) noexcept { return _mm256_sub_ps(a, b); }
+		inline Lanes mul(_In_ Lanes a, _In_ Lanes b) noexcept { return _mm256_mul_ps(a, b); }
+		inline Lanes div(_In_ Lanes a, _In_ Lanes b) noexcept { return _mm256_div_ps(a, b); }
+		inline Lanes sqrt(_In_ Lanes a) noexcept { return _mm256_sqrt_ps(a); }
+#else
+		using Lanes = __m128;
+		constexpr const UINT NUM_LANES = 4u;
+
+		inline Lanes load(_In_ const FLOAT* p) noexcept { return _mm_loadu_ps(p); }
+		inline void store(_Out_ FLOAT* p, _In_ Lanes a) noexcept { _mm_storeu_ps(p, a); }
+		inline Lanes splat(_In_ FLOAT f) noexcept { return _mm_set1_ps(f); }
+		inline Lanes add(_In_ Lanes a, _In_ Lanes b) noexcept { return _mm_add_ps(a, b); }
+		inline Lanes sub(_In_ Lanes a, _In_ Lanes b) noexcept { return _mm_sub_ps(a, b); }
+		inline Lanes mul(_In_ Lanes a, _In_ Lanes b) noexcept { return _mm_mul_ps(a, b); }
+		inline Lanes div(_In_ Lanes a, _In_ Lanes b) noexcept { return _mm_div_ps(a, b); }
+		inline Lanes sqrt(_In_ Lanes a) noexcept { return _mm_sqrt_ps(a); }
+#endif
+
+		// Only the parts of a delta that are not the identity are applied, a rotation alone skips the scale and so on
+		template <BOOL bScale, BOOL bRotate, BOOL bTranslate>
+		void composeLanes(
+			_Inout_updates_(uCount) FLOAT* const aParts[10],
+			_In_ UINT uCount,
+			_In_ const XMFLOAT3& scale,
+			_In_ const XMFLOAT4& rotation,
+			_In_ const XMFLOAT3& translation
+		) noexcept
+		{
+			const Lanes scaleX = splat(scale.x);
+			const Lanes scaleY = splat(scale.y);
+			const Lanes scaleZ = splat(scale.z);
+			const Lanes rotationX = splat(rotation.x);
+			const Lanes rotationY = splat(rotation.y);
+			const Lanes rotationZ = splat(rotation.z);
+			const Lanes rotationW = splat(rotation.w);
+			const Lanes translationX = splat(translation.x);
+			const Lanes translationY = splat(translation.y);
+			const Lanes translationZ = splat(translation.z);
+			const Lanes two = splat(2.0f);
+
+			for (UINT i = 0u; i + NUM_LANES <= uCount; i += NUM_LANES)
+			{
+				Lanes tx = load(aParts[7] + i);
+				Lanes ty = load(aParts[8] + i);
+				Lanes tz = load(aParts[9] + i);
+
+				if constexpr (bScale)
+				{
+					store(aParts[0] + i, mul(load(aParts[0] + i), scaleX));
+					store(aParts[1] + i, mul(load(aParts[1] + i), scaleY));
+					store(aParts[2] + i, mul(load(aParts[2] + i), scaleZ));
+					tx = mul(tx, scaleX);
+					ty = mul(ty, scaleY);
+					tz = mul(tz, scaleZ);
+				}
+
+				if constexpr (bRotate)
+				{
+					// Rotation after the current one, as XMQuaternionMultiply(local, rotation)
+					Lanes qx = load(aParts[3] + i);
+					Lanes qy = load(aParts[4] + i);
+					Lanes qz = load(aParts[5] + i);
+					Lanes qw = load(aParts[6] + i);
+
+					Lanes x = add(sub(add(mul(rotationW, qx), mul(rotationX, qw)), mul(rotationZ, qy)), mul(rotationY, qz));
+					Lanes y = add(sub(add(mul(rotationW, qy), mul(rotationY, qw)), mul(rotationX, qz)), mul(rotationZ, qx));
+					Lanes z = add(sub(add(mul(rotationW, qz), mul(rotationZ, qw)), mul(rotationY, qx)), mul(rotationX, qy));
+					Lanes w = sub(sub(sub(mul(rotationW, qw), mul(rotationX, qx)), mul(rotationY, qy)), mul(rotationZ, qz));
+					Lanes length = sqrt(add(add(mul(x, x), mul(y, y)), add(mul(z, z), mul(w, w))));
+
+					store(aParts[3] + i, div(x, length));
+					store(aParts[4] + i, div(y, length));
+					store(aParts[5] + i, div(z, length));
+					store(aParts[6] + i, div(w, length));
+
+					// v + w * c + r x c with c = 2 * (r x v) swings the translation around the parent origin
+					Lanes cx = mul(two, sub(mul(rotationY, tz), mul(rotationZ, ty)));
+					Lanes cy = mul(two, sub(mul(rotationZ, tx), mul(rotationX, tz)));
+					Lanes cz = mul(two, sub(mul(rotationX, ty), mul(rotationY, tx)));
+					tx = add(add(tx, mul(rotationW, cx)), sub(mul(rotationY, cz), mul(rotationZ, cy)));
+					ty = add(add(ty, mul(rotationW, cy)), sub(mul(rotationZ, cx), mul(rotationX, cz)));
+					tz = add(add(tz, mul(rotationW, cz)), sub(mul(rotationX, cy), mul(rotationY, cx)));
+				}
+
+				if constexpr (bTranslate)
+				{
+					tx = add(tx, translationX);
+					ty = add(ty, translationY);
+					tz = add(tz, translationZ);
+				}
+
+				store(aParts[7] + i, tx);
+				store(aParts[8] + i, ty);
+				store(aParts[9] + i, tz);
+			}
+		}
+	}
+
+	TransformBatch::TransformBatch() noexcept
+		: m_aScaleX()
+		, m_aScaleY()
+		, m_aScaleZ()
+		, m_aRotationX()
+		, m_aRotationY()
+		, m_aRotationZ()
+		, m_aRotationW()
+		, m_aTranslationX()
+		, m_aTranslationY()
+		, m_aTranslationZ()
+	{
+	}
+
+	void TransformBatch::Reset() noexcept
+	{
+		m_aScaleX.clear();
+		m_aScaleY.clear();
+		m_aScaleZ.clear();
+		m_aRotationX.clear();
+		m_aRotationY.clear();
+		m_aRotationZ.clear();
+		m_aRotationW.clear();
+		m_aTranslationX.clear();
+		m_aTranslationY.clear();
+		m_aTranslationZ.clear();
+	}
+
+	UINT TransformBatch::Add(_In_ const Transform& local)
+	{
+		m_aScaleX.push_back(local.Scale.x);
+		m_aScaleY.push_back(local.Scale.y);
+		m_aScaleZ.push_back(local.Scale.z);
+		m_aRotationX.push_back(local.Rotation.x);
+		m_aRotationY.push_back(local.Rotation.y);
+		m_aRotationZ.push_back(local.Rotation.z);
+		m_aRotationW.push_back(local.Rotation.w);
+		m_aTranslationX.push_back(local.Translation.x);
+		m_aTranslationY.push_back(local.Translation.y);
+		m_aTranslationZ.push_back(local.Translation.z);
+
+		return static_cast<UINT>(m_aScaleX.size()) - 1u;
+	}
+
+	void TransformBatch::Rotate(_In_ UINT uBegin, _In_ UINT uEnd, _In_ const XMVECTOR& rotation) noexcept
+	{
+		XMFLOAT4 rotationQuaternion;
+		XMStoreFloat4(&rotationQuaternion, rotation);
+		compose(uBegin, uEnd, XMFLOAT3(1.0f, 1.0f, 1.0f), rotationQuaternion, XMFLOAT3(0.0f, 0.0f, 0.0f));
+	}
+
+	void TransformBatch::RotateX(_In_ UINT uBegin, _In_ UINT uEnd, _In_ FLOAT angle) noexcept
+	{
+		Rotate(uBegin, uEnd, XMQuaternionRotationNormal(XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), angle));
+	}
+
+	void TransformBatch::RotateY(_In_ UINT uBegin, _In_ UINT uEnd, _In_ FLOAT angle) noexcept
+	{
+		Rotate(uBegin, uEnd, XMQuaternionRotationNormal(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), angle));
+	}
+
+	void TransformBatch::RotateZ(_In_ UINT uBegin, _In_ UINT uEnd, _In_ FLOAT angle) noexcept
+	{
+		Rotate(uBegin, uEnd, XMQuaternionRotationNormal(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), angle));
+	}
+
+	void TransformBatch::RotateRollPitchYaw(_In_ UINT uBegin, _In_ UINT uEnd, _In_ FLOAT roll, _In_ FLOAT pitch, _In_ FLOAT yaw) noexcept
+	{
+		Rotate(uBegin, uEnd, XMQuaternionRotationRollPitchYaw(pitch, yaw, roll));
+	}
+
+	void TransformBatch::Scale(_In_ UINT uBegin, _In_ UINT uEnd, _In_ FLOAT scaleX, _In_ FLOAT scaleY, _In_ FLOAT scaleZ) noexcept
+	{
+		compose(uBegin, uEnd, XMFLOAT3(scaleX, scaleY, scaleZ), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+	}
+
+	void TransformBatch::Translate(_In_ UINT uBegin, _In_ UINT uEnd, _In_ const XMVECTOR& offset) noexcept
+	{
+		XMFLOAT3 translation;
+		XMStoreFloat3(&translation, offset);
+		compose(uBegin, uEnd, XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f), translation);
+	}
+
+	void TransformBatch::Compose(_In_ UINT uBegin, _In_ UINT uEnd, _In_ const Transform& delta) noexcept
+	{
+		compose(uBegin, uEnd, delta.Scale, delta.Rotation, delta.Translation);
+	}
+
+	void TransformBatch::ComputeMatrices(_In_ UINT uBegin, _In_ UINT uEnd, _Out_writes_(uEnd - uBegin) XMFLOAT4X4* aOutMatrices) const noexcept
+	{
+		assert(uBegin <= uEnd && uEnd <= GetSize());
+
+		const Lanes one = splat(1.0f);
+		const Lanes two = splat(2.0f);
+
+		UINT i = uBegin;
+		for (; i + NUM_LANES <= uEnd; i += NUM_LANES)
+		{
+			Lanes qx = load(&m_aRotationX[i]);
+			Lanes qy = load(&m_aRotationY[i]);
+			Lanes qz = load(&m_aRotationZ[i]);
+			Lanes qw = load(&m_aRotationW[i]);
+			Lanes sx = load(&m_aScaleX[i]);
+			Lanes sy = load(&m_aScaleY[i]);
+			Lanes sz = load(&m_aScaleZ[i]);
+
+			Lanes xx = mul(qx, qx);
+			Lanes yy = mul(qy, qy);
+			Lanes zz = mul(qz, qz);
+			Lanes xy = mul(qx, qy);
+			Lanes xz = mul(qx, qz);
+			Lanes yz = mul(qy, qz);
+			Lanes wx = mul(qw, qx);
+			Lanes wy = mul(qw, qy);
+			Lanes wz = mul(qw, qz);
+
+			// Rows of scale * rotation, written out lane by lane below
+			alignas(32) FLOAT aRows[9][NUM_LANES];
+			store(aRows[0], mul(sx, sub(one, mul(two, add(yy, zz)))));
+			store(aRows[1], mul(sx, mul(two, add(xy, wz))));
+			store(aRows[2], mul(sx, mul(two, sub(xz, wy))));
+			store(aRows[3], mul(sy, mul(two, sub(xy, wz))));
+			store(aRows[4], mul(sy, sub(one, mul(two, add(xx, zz)))));
+			store(aRows[5], mul(sy, mul(two, add(yz, wx))));
+			store(aRows[6], mul(sz, mul(two, add(xz, wy))));
+			store(aRows[7], mul(sz, mul(two, sub(yz, wx))));
+			store(aRows[8], mul(sz, sub(one, mul(two, add(xx, yy)))));
+
+			for (UINT uLane = 0u; uLane < NUM_LANES; ++uLane)
+			{
+				aOutMatrices[i - uBegin + uLane] = XMFLOAT4X4(
+					aRows[0][uLane], aRows[1][uLane], aRows[2][uLane], 0.0f,
+					aRows[3][uLane], aRows[4][uLane], aRows[5][uLane], 0.0f,
+					aRows[6][uLane], aRows[7][uLane], aRows[8][uLane], 0.0f,
+					m_aTranslationX[i + uLane], m_aTranslationY[i + uLane], m_aTranslationZ[i + uLane], 1.0f
+				);
+			}
+		}
+
+		for (; i < uEnd; ++i)
+		{
+			Transform local = Get(i);
+			XMStoreFloat4x4(
+				&aOutMatrices[i - uBegin],
+				XMMatrixAffineTransformation(XMLoadFloat3(&local.Scale), XMVectorZero(), XMLoadFloat4(&local.Rotation), XMLoadFloat3(&local.Translation))
+			);
+		}
+	}
+
+	Transform TransformBatch::Get(_In_ UINT uIndex) const noexcept
+	{
+		return Transform
+		{
+			.Scale = XMFLOAT3(m_aScaleX[uIndex], m_aScaleY[uIndex], m_aScaleZ[uIndex]),
+			.Rotation = XMFLOAT4(m_aRotationX[uIndex], m_aRotationY[uIndex], m_aRotationZ[uIndex], m_aRotationW[uIndex]),
+			.Translation = XMFLOAT3(m_aTranslationX[uIndex], m_aTranslationY[uIndex], m_aTranslationZ[uIndex]),
+		};
+	}
+
+	void TransformBatch::Set(_In_ UINT uIndex, _In_ const Transform& local) noexcept
+	{
+		m_aScaleX[uIndex] = local.Scale.x;
+		m_aScaleY[uIndex] = local.Scale.y;
+		m_aScaleZ[uIndex] = local.Scale.z;
+		m_aRotationX[uIndex] = local.Rotation.x;
+		m_aRotationY[uIndex] = local.Rotation.y;
+		m_aRotationZ[uIndex] = local.Rotation.z;
+		m_aRotationW[uIndex] = local.Rotation.w;
+		m_aTranslationX[uIndex] = local.Translation.x;
+		m_aTranslationY[uIndex] = local.Translation.y;
+		m_aTranslationZ[uIndex] = local.Translation.z;
+	}
+
+	UINT TransformBatch::GetSize() const noexcept
+	{
+		return static_cast<UINT>(m_aScaleX.size());
+	}
+
+	void TransformBatch::compose(_In_ UINT uBegin, _In_ UINT uEnd, _In_ const XMFLOAT3& scale, _In_ const XMFLOAT4& rotation, _In_ const XMFLOAT3& translation) noexcept
+	{
+		assert(uBegin <= uEnd && uEnd <= GetSize());
+
+		BOOL bScale = scale.x != 1.0f || scale.y != 1.0f || scale.z != 1.0f;
+		BOOL bRotate = rotation.x != 0.0f || rotation.y != 0.0f || rotation.z != 0.0f || rotation.w != 1.0f;
+		BOOL bTranslate = translation.x != 0.0f || translation.y != 0.0f || translation.z != 0.0f;
+
+		FLOAT* const aParts[] =
+		{
+			&m_aScaleX[uBegin], &m_aScaleY[uBegin], &m_aScaleZ[uBegin],
+			&m_aRotationX[uBegin], &m_aRotationY[uBegin], &m_aRotationZ[uBegin], &m_aRotationW[uBegin],
+			&m_aTranslationX[uBegin], &m_aTranslationY[uBegin], &m_aTranslationZ[uBegin],
+		};
+		UINT uCount = uEnd - uBegin;
+
+		using ComposeLanes = void (*)(FLOAT* const*, UINT, const XMFLOAT3&, const XMFLOAT4&, const XMFLOAT3&) noexcept;
+		static constexpr const ComposeLanes COMPOSE_LANES[] =
+		{
+			composeLanes<FALSE, FALSE, FALSE>, composeLanes<FALSE, FALSE, TRUE>,
+			composeLanes<FALSE, TRUE, FALSE>, composeLanes<FALSE, TRUE, TRUE>,
+			composeLanes<TRUE, FALSE, FALSE>, composeLanes<TRUE, FALSE, TRUE>,
+			composeLanes<TRUE, TRUE, FALSE>, composeLanes<TRUE, TRUE, TRUE>,
+		};
+		COMPOSE_LANES[(bScale ? 4u : 0u) | (bRotate ? 2u : 0u) | (bTranslate ? 1u : 0u)](aParts, uCount, scale, rotation, translation);
+
+		// The objects past the last full group of lanes go through the same steps as Renderable
+		XMVECTOR scaleVector = XMLoadFloat3(&scale);
+		XMVECTOR rotationQuaternion = XMLoadFloat4(&rotation);
+		XMVECTOR translationVector = XMLoadFloat3(&translation);
+		for (UINT i = uBegin + uCount / NUM_LANES * NUM_LANES; i < uEnd; ++i)
+		{
+			Transform local = Get(i);
+			XMVECTOR localTranslation = XMLoadFloat3(&local.Translation);
+			if (bScale)
+			{
+				XMStoreFloat3(&local.Scale, XMVectorMultiply(XMLoadFloat3(&local.Scale), scaleVector));
+				localTranslation = XMVectorMultiply(localTranslation, scaleVector);
+			}
+
+			if (bRotate)
+			{
+				XMStoreFloat4(&local.Rotation, XMQuaternionNormalize(XMQuaternionMultiply(XMLoadFloat4(&local.Rotation), rotationQuaternion)));
+				localTranslation = XMVector3Rotate(localTranslation, rotationQuaternion);
+			}
+
+			if (bTranslate)
+			{
+				localTranslation = XMVectorAdd(localTranslation, translationVector);
+			}
+
+			XMStoreFloat3(&local.Translation, localTranslation);
+			Set(i, local);
+		}
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/DataTypes.h"
+
+namespace pr
+{
+	// Local transforms of many objects kept as structure of arrays, so a transform applied to a span of them runs
+	// 8 objects at a time with AVX when the build enables it, 4 with SSE otherwise. The operations are the ones of
+	// Renderable with the same results up to rounding, a batch gathers the local transforms of renderables, transforms them and
+	// scatters them back, the scene picks them up on its next update like any other change. Gather and Scatter take anything
+	// with GetLocalTransform and SetLocalTransform, so the batch itself does not depend on Renderable.
+	// Spans are [uBegin, uEnd), disjoint spans can be transformed from different jobs.
+	class TransformBatch final
+	{
+	public:
+		explicit TransformBatch() noexcept;
+		TransformBatch(const TransformBatch& other) = delete;
+		TransformBatch(TransformBatch&& other) = delete;
+		TransformBatch& operator=(const TransformBatch& other) = delete;
+		TransformBatch& operator=(TransformBatch&& other) = delete;
+		~TransformBatch() noexcept = default;
+
+		void Reset() noexcept;
+		UINT Add(_In_ const Transform& local);
+		// Replaces the batch with the local transforms of the objects, object i is apObjects[i]
+		template <class Object>
+		void Gather(_In_reads_(uNumObjects) const std::shared_ptr<Object>* apObjects, _In_ UINT uNumObjects);
+		template <class Object>
+		void Scatter(_In_reads_(uNumObjects) const std::shared_ptr<Object>* apObjects, _In_ UINT uNumObjects) const;
+
+		void Rotate(_In_ UINT uBegin, _In_ UINT uEnd, _In_ const XMVECTOR& rotation) noexcept;
+		void RotateX(_In_ UINT uBegin, _In_ UINT uEnd, _In_ FLOAT angle) noexcept;
+		void RotateY(_In_ UINT uBegin, _In_ UINT uEnd, _In_ FLOAT angle) noexcept;
+		void RotateZ(_In_ UINT uBegin, _In_ UINT uEnd, _In_ FLOAT angle) noexcept;
+		void RotateRollPitchYaw(_In_ UINT uBegin, _In_ UINT uEnd, _In_ FLOAT roll, _In_ FLOAT pitch, _In_ FLOAT yaw) noexcept;
+		void Scale(_In_ UINT uBegin, _In_ UINT uEnd, _In_ FLOAT scaleX, _In_ FLOAT scaleY, _In_ FLOAT scaleZ) noexcept;
+		void Translate(_In_ UINT uBegin, _In_ UINT uEnd, _In_ const XMVECTOR& offset) noexcept;
+		// Scales, rotates and translates by delta in one pass, the same as the three calls one after the other
+		void Compose(_In_ UINT uBegin, _In_ UINT uEnd, _In_ const Transform& delta) noexcept;
+
+		// Same matrices as XMMatrixAffineTransformation of each local transform
+		void ComputeMatrices(_In_ UINT uBegin, _In_ UINT uEnd, _Out_writes_(uEnd - uBegin) XMFLOAT4X4* aOutMatrices) const noexcept;
+
+		Transform Get(_In_ UINT uIndex) const noexcept;
+		void Set(_In_ UINT uIndex, _In_ const Transform& local) noexcept;
+		UINT GetSize() const noexcept;
+
+	private:
+		void compose(_In_ UINT uBegin, _In_ UINT uEnd, _In_ const XMFLOAT3& scale, _In_ const XMFLOAT4& rotation, _In_ const XMFLOAT3& translation) noexcept;
+
+	private:
+		std::vector<FLOAT> m_aScaleX;
+		std::vector<FLOAT> m_aScaleY;
+		std::vector<FLOAT> m_aScaleZ;
+		std::vector<FLOAT> m_aRotationX;
+		std::vector<FLOAT> m_aRotationY;
+		std::vector<FLOAT> m_aRotationZ;
+		std::vector<FLOAT> m_aRotationW;
+		std::vector<FLOAT> m_aTranslationX;
+		std::vector<FLOAT> m_aTranslationY;
+		std::vector<FLOAT> m_aTranslationZ;
+	};
+
+	template <class Object>
+	void TransformBatch::Gather(_In_reads_(uNumObjects) const std::shared_ptr<Object>* apObjects, _In_ UINT uNumObjects)
+	{
+		Reset();
+		for (UINT i = 0u; i < uNumObjects; ++i)
+		{
+			Add(apObjects[i]->GetLocalTransform());
+		}
+	}
+
+	template <class Object>
+	void TransformBatch::Scatter(_In_reads_(uNumObjects) const std::shared_ptr<Object>* apObjects, _In_ UINT uNumObjects) const
+	{
+		assert(uNumObjects <= GetSize());
+
+		for (UINT i = 0u; i < uNumObjects; ++i)
+		{
+			apObjects[i]->SetLocalTransform(Get(i));
+		}
+	}
+}
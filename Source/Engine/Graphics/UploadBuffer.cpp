@@ -45,7 +45,7 @@ namespace pr
 
 	void UploadBuffer::Reset()
 	{
-		m_pCurrentPage->Reset();
+		m_pCurrentPage = nullptr;
 		m_AvailablePages = m_PagePool;
 
 		for (std::shared_ptr<Page>& pPage : m_AvailablePages)
@@ -148,6 +148,8 @@ namespace pr
 		{
 			.pCpu = static_cast<UINT8*>(m_pCpuPtr) + m_Offset,
 			.Gpu = m_GpuPtr + m_Offset,
+			.pResource = m_pResource.Get(),
+			.Offset = m_Offset,
 		};
 
 		m_Offset += alignedSize;
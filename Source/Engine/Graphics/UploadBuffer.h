@@ -14,6 +14,8 @@ namespace pr
 		{
 			void* pCpu;
 			D3D12_GPU_VIRTUAL_ADDRESS Gpu;
+			ID3D12Resource* pResource;
+			size_t Offset;
 		};
 
 	public:
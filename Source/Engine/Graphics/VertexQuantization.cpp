@@ -0,0 +1,285 @@
+#include "pch.h"
+
+#include "Graphics/VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <DirectXPackedVector.h>
+#include <immintrin.h>
+
+namespace pr
+{
+	namespace
+	{
+		constexpr const FLOAT UNORM16_MAX = 65535.0f;
+		constexpr const FLOAT SNORM16_MAX = 32767.0f;
+
+		// Projects the unit normal onto the octahedron |x| + |y| + |z| = 1 and folds the lower half over the upper
+		XMFLOAT2 encodeOctahedral(_In_ const XMFLOAT3& normal) noexcept
+		{
+			const FLOAT l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+			const FLOAT invL1 = l1 > 0.0f ? 1.0f / l1 : 0.0f;
+
+			FLOAT x = normal.x * invL1;
+			FLOAT y = normal.y * invL1;
+			if (normal.z < 0.0f)
+			{
+				const FLOAT foldedX = (1.0f - std::abs(y)) * std::copysign(1.0f, x);
+				const FLOAT foldedY = (1.0f - std::abs(x)) * std::copysign(1.0f, y);
+				x = foldedX;
+				y = foldedY;
+			}
+
+			return XMFLOAT2(x, y);
+		}
+
+		inline USHORT quantizeUnorm16(_In_ FLOAT value) noexcept
+		{
+			return static_cast<USHORT>(std::nearbyint(std::clamp(value, 0.0f, 1.0f) * UNORM16_MAX));
+		}
+
+		inline SHORT quantizeSnorm16(_In_ FLOAT value) noexcept
+		{
+			return static_cast<SHORT>(std::nearbyint(std::clamp(value, -1.0f, 1.0f) * SNORM16_MAX));
+		}
+
+		VertexPackedPNT encodeVertex(_In_ const VertexPNT& vertex, _In_ const PositionDecode& decode, _In_ FLOAT invScale) noexcept
+		{
+			const XMFLOAT2 normal = encodeOctahedral(vertex.Normal);
+
+			return VertexPackedPNT
+			{
+				.auPosition =
+				{
+					quantizeUnorm16((vertex.Position.x - decode.Offset.x) * invScale),
+					quantizeUnorm16((vertex.Position.y - decode.Offset.y) * invScale),
+					quantizeUnorm16((vertex.Position.z - decode.Offset.z) * invScale),
+					0u,
+				},
+				.aiNormal = { quantizeSnorm16(normal.x), quantizeSnorm16(normal.y) },
+				.auTexCoord =
+				{
+					PackedVector::XMConvertFloatToHalf(vertex.TexCoord.x),
+					PackedVector::XMConvertFloatToHalf(vertex.TexCoord.y),
+				},
+			};
+		}
+
+		// Picks a where the mask is set and b elsewhere
+		inline __m128 select(_In_ __m128 mask, _In_ __m128 a, _In_ __m128 b) noexcept
+		{
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+	}
+
+	PositionDecode ComputePositionDecode(_In_reads_(uNumVertices) const VertexPNT* aVertices, _In_ UINT uNumVertices) noexcept
+	{
+		if (uNumVertices == 0u)
+		{
+			return PositionDecode{ .Offset = XMFLOAT3(0.0f, 0.0f, 0.0f), .Scale = 1.0f };
+		}
+
+		XMVECTOR minimum = XMLoadFloat3(&aVertices[0].Position);
+		XMVECTOR maximum = minimum;
+		for (UINT i = 1u; i < uNumVertices; ++i)
+		{
+			XMVECTOR position = XMLoadFloat3(&aVertices[i].Position);
+			minimum = XMVectorMin(minimum, position);
+			maximum = XMVectorMax(maximum, position);
+		}
+
+		XMFLOAT3 extent;
+		XMStoreFloat3(&extent, XMVectorSubtract(maximum, minimum));
+
+		PositionDecode decode =
+		{
+			.Offset = XMFLOAT3(),
+			.Scale = std::max({ extent.x, extent.y, extent.z }),
+		};
+		XMStoreFloat3(&decode.Offset, minimum);
+
+		// A single point still needs an invertible decode
+		if (!(decode.Scale > 0.0f))
+		{
+			decode.Scale = 1.0f;
+		}
+
+		return decode;
+	}
+
+	void EncodeVertices(
+		_Out_writes_(uNumVertices) VertexPackedPNT* aOutVertices,
+		_In_reads_(uNumVertices) const VertexPNT* aVertices,
+		_In_ UINT uNumVertices,
+		_In_ const PositionDecode& decode
+	) noexcept
+	{
+		static_assert(offsetof(VertexPNT, Normal) + sizeof(FLOAT) == 4u * sizeof(FLOAT));
+
+		const FLOAT invScale = 1.0f / decode.Scale;
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 minusOne = _mm_set1_ps(-1.0f);
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 offsetX = _mm_set1_ps(decode.Offset.x);
+		const __m128 offsetY = _mm_set1_ps(decode.Offset.y);
+		const __m128 offsetZ = _mm_set1_ps(decode.Offset.z);
+		const __m128 invScales = _mm_set1_ps(invScale);
+		const __m128 unormMax = _mm_set1_ps(UNORM16_MAX);
+		const __m128 snormMax = _mm_set1_ps(SNORM16_MAX);
+		const __m128i lowMask = _mm_set1_epi32(0xFFFF);
+
+		UINT i = 0u;
+		for (; i + 4u <= uNumVertices; i += 4u)
+		{
+			// Every vertex is 8 floats, the first 4 and the last 4 of 4 vertices transpose into their components
+			const FLOAT* pVertex = &aVertices[i].Position.x;
+			__m128 positionX = _mm_loadu_ps(pVertex);
+			__m128 positionY = _mm_loadu_ps(pVertex + 8);
+			__m128 positionZ = _mm_loadu_ps(pVertex + 16);
+			__m128 normalX = _mm_loadu_ps(pVertex + 24);
+			_MM_TRANSPOSE4_PS(positionX, positionY, positionZ, normalX);
+
+			__m128 normalY = _mm_loadu_ps(pVertex + 4);
+			__m128 normalZ = _mm_loadu_ps(pVertex + 12);
+			__m128 texCoordU = _mm_loadu_ps(pVertex + 20);
+			__m128 texCoordV = _mm_loadu_ps(pVertex + 28);
+			_MM_TRANSPOSE4_PS(normalY, normalZ, texCoordU, texCoordV);
+
+			auto quantizePosition = [zero, one, invScales, unormMax](__m128 position, __m128 offset)
+			{
+				__m128 unorm = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(position, offset), invScales), zero), one);
+				return _mm_cvtps_epi32(_mm_mul_ps(unorm, unormMax));
+			};
+			__m128i quantizedX = quantizePosition(positionX, offsetX);
+			__m128i quantizedY = quantizePosition(positionY, offsetY);
+			__m128i quantizedZ = quantizePosition(positionZ, offsetZ);
+
+			__m128 absX = _mm_andnot_ps(signMask, normalX);
+			__m128 absY = _mm_andnot_ps(signMask, normalY);
+			__m128 absZ = _mm_andnot_ps(signMask, normalZ);
+			__m128 l1 = _mm_add_ps(_mm_add_ps(absX, absY), absZ);
+			__m128 invL1 = _mm_and_ps(_mm_cmpgt_ps(l1, zero), _mm_div_ps(one, l1));
+
+			__m128 octahedralX = _mm_mul_ps(normalX, invL1);
+			__m128 octahedralY = _mm_mul_ps(normalY, invL1);
+			__m128 foldedX = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, octahedralY)), _mm_or_ps(_mm_and_ps(octahedralX, signMask), one));
+			__m128 foldedY = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, octahedralX)), _mm_or_ps(_mm_and_ps(octahedralY, signMask), one));
+			__m128 lowerHalf = _mm_cmplt_ps(normalZ, zero);
+			octahedralX = select(lowerHalf, foldedX, octahedralX);
+			octahedralY = select(lowerHalf, foldedY, octahedralY);
+
+			__m128i quantizedNormalX = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(octahedralX, minusOne), one), snormMax));
+			__m128i quantizedNormalY = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(octahedralY, minusOne), one), snormMax));
+
+#if defined(__AVX2__)
+			__m128i texCoords = _mm_unpacklo_epi16(
+				_mm_cvtps_ph(texCoordU, _MM_FROUND_TO_NEAREST_INT),
+				_mm_cvtps_ph(texCoordV, _MM_FROUND_TO_NEAREST_INT)
+			);
+#else
+			alignas(16) FLOAT aU[4];
+			alignas(16) FLOAT aV[4];
+			_mm_store_ps(aU, texCoordU);
+			_mm_store_ps(aV, texCoordV);
+			alignas(16) UINT auTexCoords[4];
+			for (UINT j = 0u; j < 4u; ++j)
+			{
+				auTexCoords[j] = static_cast<UINT>(PackedVector::XMConvertFloatToHalf(aU[j])) | (static_cast<UINT>(PackedVector::XMConvertFloatToHalf(aV[j])) << 16u);
+			}
+			__m128i texCoords = _mm_load_si128(reinterpret_cast<const __m128i*>(auTexCoords));
+#endif
+
+			// Each register holds one 32-bit word of the 4 vertices, transposed they become the vertices
+			__m128 words0 = _mm_castsi128_ps(_mm_or_si128(quantizedX, _mm_slli_epi32(quantizedY, 16)));
+			__m128 words1 = _mm_castsi128_ps(quantizedZ);
+			__m128 words2 = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(quantizedNormalX, lowMask), _mm_slli_epi32(quantizedNormalY, 16)));
+			__m128 words3 = _mm_castsi128_ps(texCoords);
+			_MM_TRANSPOSE4_PS(words0, words1, words2, words3);
+
+			FLOAT* pOutVertex = reinterpret_cast<FLOAT*>(aOutVertices + i);
+			_mm_storeu_ps(pOutVertex, words0);
+			_mm_storeu_ps(pOutVertex + 4, words1);
+			_mm_storeu_ps(pOutVertex + 8, words2);
+			_mm_storeu_ps(pOutVertex + 12, words3);
+		}
+
+		for (; i < uNumVertices; ++i)
+		{
+			aOutVertices[i] = encodeVertex(aVertices[i], decode, invScale);
+		}
+	}
+
+	XMFLOAT3 DecodePosition(_In_ const VertexPackedPNT& vertex, _In_ const PositionDecode& decode) noexcept
+	{
+		const FLOAT scale = decode.Scale / UNORM16_MAX;
+		return XMFLOAT3(
+			decode.Offset.x + static_cast<FLOAT>(vertex.auPosition[0]) * scale,
+			decode.Offset.y + static_cast<FLOAT>(vertex.auPosition[1]) * scale,
+			decode.Offset.z + static_cast<FLOAT>(vertex.auPosition[2]) * scale
+		);
+	}
+
+	XMFLOAT3 DecodeNormal(_In_ const VertexPackedPNT& vertex) noexcept
+	{
+		const FLOAT x = std::max(static_cast<FLOAT>(vertex.aiNormal[0]) / SNORM16_MAX, -1.0f);
+		const FLOAT y = std::max(static_cast<FLOAT>(vertex.aiNormal[1]) / SNORM16_MAX, -1.0f);
+
+		// Unfolds the lower half, t is zero on the upper one
+		XMFLOAT3 normal(x, y, 1.0f - std::abs(x) - std::abs(y));
+		const FLOAT t = std::clamp(-normal.z, 0.0f, 1.0f);
+		normal.x += normal.x >= 0.0f ? -t : t;
+		normal.y += normal.y >= 0.0f ? -t : t;
+
+		XMStoreFloat3(&normal, XMVector3Normalize(XMLoadFloat3(&normal)));
+		return normal;
+	}
+
+	XMFLOAT2 DecodeTexCoord(_In_ const VertexPackedPNT& vertex) noexcept
+	{
+		return XMFLOAT2(
+			PackedVector::XMConvertHalfToFloat(vertex.auTexCoord[0]),
+			PackedVector::XMConvertHalfToFloat(vertex.auTexCoord[1])
+		);
+	}
+
+	XMMATRIX GetPositionDecodeMatrix(_In_ const PositionDecode& decode) noexcept
+	{
+		return XMMatrixScaling(decode.Scale, decode.Scale, decode.Scale) * XMMatrixTranslation(decode.Offset.x, decode.Offset.y, decode.Offset.z);
+	}
+
+	VertexQuantizationError MeasureQuantizationError(
+		_In_reads_(uNumVertices) const VertexPackedPNT* aPackedVertices,
+		_In_reads_(uNumVertices) const VertexPNT* aVertices,
+		_In_ UINT uNumVertices,
+		_In_ const PositionDecode& decode
+	) noexcept
+	{
+		VertexQuantizationError error =
+		{
+			.MaxPositionError = 0.0f,
+			.MaxNormalError = 0.0f,
+			.MaxTexCoordError = 0.0f,
+		};
+
+		for (UINT i = 0u; i < uNumVertices; ++i)
+		{
+			XMFLOAT3 position = DecodePosition(aPackedVertices[i], decode);
+			XMFLOAT3 normal = DecodeNormal(aPackedVertices[i]);
+			XMFLOAT2 texCoord = DecodeTexCoord(aPackedVertices[i]);
+
+			FLOAT positionError = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&position), XMLoadFloat3(&aVertices[i].Position))));
+			XMVECTOR original = XMLoadFloat3(&aVertices[i].Normal);
+			// Zero normals have no direction to lose
+			FLOAT cosine = XMVectorGetX(XMVector3Dot(original, original)) > 0.0f ? XMVectorGetX(XMVector3Dot(XMLoadFloat3(&normal), XMVector3Normalize(original))) : 1.0f;
+			FLOAT texCoordError = std::max(std::abs(texCoord.x - aVertices[i].TexCoord.x), std::abs(texCoord.y - aVertices[i].TexCoord.y));
+
+			error.MaxPositionError = std::max(error.MaxPositionError, positionError);
+			error.MaxNormalError = std::max(error.MaxNormalError, std::acos(std::clamp(cosine, -1.0f, 1.0f)));
+			error.MaxTexCoordError = std::max(error.MaxTexCoordError, texCoordError);
+		}
+
+		return error;
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/DataTypes.h"
+
+namespace pr
+{
+	// Largest differences between vertices and their packed versions, the position error in object space, the normal
+	// error as an angle in radians
+	struct VertexQuantizationError
+	{
+		FLOAT MaxPositionError;
+		FLOAT MaxNormalError;
+		FLOAT MaxTexCoordError;
+	};
+
+	// Offset at the minimum corner of the bounds of the positions and a scale of their largest extent
+	PositionDecode ComputePositionDecode(_In_reads_(uNumVertices) const VertexPNT* aVertices, _In_ UINT uNumVertices) noexcept;
+
+	// Encodes 4 vertices at a time with SSE, rounding to the nearest step. Texture coordinates are converted with
+	// F16C when the build enables AVX2, one at a time otherwise.
+	void EncodeVertices(
+		_Out_writes_(uNumVertices) VertexPackedPNT* aOutVertices,
+		_In_reads_(uNumVertices) const VertexPNT* aVertices,
+		_In_ UINT uNumVertices,
+		_In_ const PositionDecode& decode
+	) noexcept;
+
+	// Decodes the same way as the input assembler and the vertex shader
+	XMFLOAT3 DecodePosition(_In_ const VertexPackedPNT& vertex, _In_ const PositionDecode& decode) noexcept;
+	XMFLOAT3 DecodeNormal(_In_ const VertexPackedPNT& vertex) noexcept;
+	XMFLOAT2 DecodeTexCoord(_In_ const VertexPackedPNT& vertex) noexcept;
+
+	// Maps the unsigned normalized positions to object space, applied before the world matrix
+	XMMATRIX GetPositionDecodeMatrix(_In_ const PositionDecode& decode) noexcept;
+
+	VertexQuantizationError MeasureQuantizationError(
+		_In_reads_(uNumVertices) const VertexPackedPNT* aPackedVertices,
+		_In_reads_(uNumVertices) const VertexPNT* aVertices,
+		_In_ UINT uNumVertices,
+		_In_ const PositionDecode& decode
+	) noexcept;
+}
@@ -0,0 +1,721 @@
+#include "pch.h"
+
+#include "Scene/BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "Utility/JobSystem.h"
+#include "Utility/Profiler.h"
+
+namespace pr
+{
+	namespace
+	{
+		constexpr const UINT NUM_BINS = 16u;
+		constexpr const UINT ITEMS_PER_JOB = 4096u;
+		// Cost of visiting a node relative to testing an item
+		constexpr const FLOAT TRAVERSAL_COST = 1.0f;
+
+		enum class eOverlap
+		{
+			OUTSIDE,
+			INTERSECTING,
+			INSIDE,
+		};
+
+		inline FLOAT getAxis(_In_ const XMFLOAT3& vector, _In_ UINT uAxis) noexcept
+		{
+			return (&vector.x)[uAxis];
+		}
+
+		inline Box emptyBox() noexcept
+		{
+			return Box{ .Min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX), .Max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX) };
+		}
+
+		inline void growBox(_Inout_ Box& box, _In_ const XMFLOAT3& minimum, _In_ const XMFLOAT3& maximum) noexcept
+		{
+			box.Min = XMFLOAT3(std::min(box.Min.x, minimum.x), std::min(box.Min.y, minimum.y), std::min(box.Min.z, minimum.z));
+			box.Max = XMFLOAT3(std::max(box.Max.x, maximum.x), std::max(box.Max.y, maximum.y), std::max(box.Max.z, maximum.z));
+		}
+
+		inline FLOAT surfaceArea(_In_ const XMFLOAT3& minimum, _In_ const XMFLOAT3& maximum) noexcept
+		{
+			FLOAT x = std::max(maximum.x - minimum.x, 0.0f);
+			FLOAT y = std::max(maximum.y - minimum.y, 0.0f);
+			FLOAT z = std::max(maximum.z - minimum.z, 0.0f);
+
+			return 2.0f * (x * y + y * z + z * x);
+		}
+
+		inline UINT getBin(_In_ const XMFLOAT3& centroid, _In_ UINT uAxis, _In_ FLOAT minimum, _In_ FLOAT scale, _In_ UINT uNumBins) noexcept
+		{
+			return std::min(static_cast<UINT>((getAxis(centroid, uAxis) - minimum) * scale), uNumBins - 1u);
+		}
+
+		// Everything the build reads about an item, partitioned in place so every pass reads memory in order
+		struct BuildItem
+		{
+			Box Bounds;
+			XMFLOAT3 Centroid;
+			UINT uItem;
+		};
+
+		// Builds the nodes over aItems[0, uNumItems) and reorders the items into leaf order, leaves refer to
+		// uFirstIndex + their position. Ranges of at most uMinLeafSize items always become leaves, ranges of at
+		// most uMaxLeafSize when a split costs more.
+		template <class NodeType>
+		void buildNodes(
+			_Inout_ std::vector<NodeType>& aNodes,
+			_Inout_updates_(uNumItems) BuildItem* aItems,
+			_In_ UINT uNumItems,
+			_In_ UINT uFirstIndex,
+			_In_ UINT uMinLeafSize,
+			_In_ UINT uMaxLeafSize
+		)
+		{
+			struct Range
+			{
+				UINT uNode;
+				UINT uBegin;
+				UINT uEnd;
+			};
+
+			aNodes.clear();
+			aNodes.push_back(NodeType{});
+			std::vector<Range> stack = { Range{ .uNode = 0u, .uBegin = 0u, .uEnd = uNumItems } };
+			while (!stack.empty())
+			{
+				const Range range = stack.back();
+				stack.pop_back();
+
+				Box bounds = emptyBox();
+				Box centroidBounds = emptyBox();
+				for (UINT i = range.uBegin; i < range.uEnd; ++i)
+				{
+					growBox(bounds, aItems[i].Bounds.Min, aItems[i].Bounds.Max);
+					growBox(centroidBounds, aItems[i].Centroid, aItems[i].Centroid);
+				}
+
+				const UINT uNumRangeItems = range.uEnd - range.uBegin;
+				aNodes[range.uNode] = NodeType{ .Min = bounds.Min, .uFirst = uFirstIndex + range.uBegin, .Max = bounds.Max, .uCount = uNumRangeItems };
+				if (uNumRangeItems <= uMinLeafSize)
+				{
+					continue;
+				}
+
+				// Bin the centroids along every axis in one pass, axes without extent keep everything in bin 0.
+				// Small ranges get fewer bins, most nodes are near the leaves.
+				const UINT uNumBins = std::min(uNumRangeItems, NUM_BINS);
+				Box aaBinBoxes[3][NUM_BINS];
+				UINT aauBinCounts[3][NUM_BINS] = {};
+				FLOAT aMinimums[3];
+				FLOAT aScales[3];
+				for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+				{
+					std::fill(aaBinBoxes[uAxis], aaBinBoxes[uAxis] + uNumBins, emptyBox());
+					const FLOAT extent = getAxis(centroidBounds.Max, uAxis) - getAxis(centroidBounds.Min, uAxis);
+					aMinimums[uAxis] = getAxis(centroidBounds.Min, uAxis);
+					aScales[uAxis] = extent > 0.0f ? static_cast<FLOAT>(uNumBins) / extent : 0.0f;
+				}
+
+				for (UINT i = range.uBegin; i < range.uEnd; ++i)
+				{
+					const BuildItem& item = aItems[i];
+					for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+					{
+						const UINT uBin = getBin(item.Centroid, uAxis, aMinimums[uAxis], aScales[uAxis], uNumBins);
+						growBox(aaBinBoxes[uAxis][uBin], item.Bounds.Min, item.Bounds.Max);
+						++aauBinCounts[uAxis][uBin];
+					}
+				}
+
+				// Sweep the planes between the bins from both sides
+				FLOAT bestCost = FLT_MAX;
+				UINT uBestAxis = 3u;
+				UINT uBestSplit = 0u;
+				for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+				{
+					FLOAT aRightCosts[NUM_BINS];
+					UINT auRightCounts[NUM_BINS];
+					Box right = emptyBox();
+					UINT uNumRight = 0u;
+					for (UINT uBin = uNumBins - 1u; uBin > 0u; --uBin)
+					{
+						growBox(right, aaBinBoxes[uAxis][uBin].Min, aaBinBoxes[uAxis][uBin].Max);
+						uNumRight += aauBinCounts[uAxis][uBin];
+						aRightCosts[uBin] = surfaceArea(right.Min, right.Max) * static_cast<FLOAT>(uNumRight);
+						auRightCounts[uBin] = uNumRight;
+					}
+
+					Box left = emptyBox();
+					UINT uNumLeft = 0u;
+					for (UINT uSplit = 1u; uSplit < uNumBins; ++uSplit)
+					{
+						growBox(left, aaBinBoxes[uAxis][uSplit - 1u].Min, aaBinBoxes[uAxis][uSplit - 1u].Max);
+						uNumLeft += aauBinCounts[uAxis][uSplit - 1u];
+						if (uNumLeft == 0u || auRightCounts[uSplit] == 0u)
+						{
+							continue;
+						}
+
+						const FLOAT cost = surfaceArea(left.Min, left.Max) * static_cast<FLOAT>(uNumLeft) + aRightCosts[uSplit];
+						if (cost < bestCost)
+						{
+							bestCost = cost;
+							uBestAxis = uAxis;
+							uBestSplit = uSplit;
+						}
+					}
+				}
+
+				// Items with the same centroid cannot be told apart, halve them when they do not fit a leaf
+				UINT uMiddle = range.uBegin + uNumRangeItems / 2u;
+				if (uBestAxis < 3u)
+				{
+					const FLOAT area = surfaceArea(bounds.Min, bounds.Max);
+					if (uNumRangeItems <= uMaxLeafSize && area * static_cast<FLOAT>(uNumRangeItems) <= area * TRAVERSAL_COST + bestCost)
+					{
+						continue;
+					}
+
+					uMiddle = static_cast<UINT>(std::partition(
+						aItems + range.uBegin,
+						aItems + range.uEnd,
+						[uBestAxis, uBestSplit, uNumBins, minimum = aMinimums[uBestAxis], scale = aScales[uBestAxis]](const BuildItem& item)
+						{
+							return getBin(item.Centroid, uBestAxis, minimum, scale, uNumBins) < uBestSplit;
+						}
+					) - aItems);
+				}
+				else if (uNumRangeItems <= uMaxLeafSize)
+				{
+					continue;
+				}
+
+				// Children always come after their parent
+				const UINT uFirstChild = static_cast<UINT>(aNodes.size());
+				aNodes[range.uNode].uFirst = uFirstChild;
+				aNodes[range.uNode].uCount = 0u;
+				aNodes.resize(aNodes.size() + 2u);
+				stack.push_back(Range{ .uNode = uFirstChild + 1u, .uBegin = uMiddle, .uEnd = range.uEnd });
+				stack.push_back(Range{ .uNode = uFirstChild, .uBegin = range.uBegin, .uEnd = uMiddle });
+			}
+		}
+
+		// Recomputes the bounds of every node, walking backwards visits the children before their parent
+		template <class NodeType, class LeafBounds>
+		void refitNodes(_Inout_ std::vector<NodeType>& aNodes, _In_ const LeafBounds& leafBounds) noexcept
+		{
+			for (size_t i = aNodes.size(); i-- > 0u;)
+			{
+				NodeType& node = aNodes[i];
+				Box bounds = emptyBox();
+				if (node.uCount > 0u)
+				{
+					bounds = leafBounds(node);
+				}
+				else
+				{
+					growBox(bounds, aNodes[node.uFirst].Min, aNodes[node.uFirst].Max);
+					growBox(bounds, aNodes[node.uFirst + 1u].Min, aNodes[node.uFirst + 1u].Max);
+				}
+
+				node.Min = bounds.Min;
+				node.Max = bounds.Max;
+			}
+		}
+
+		// Surface area heuristic cost of a tree relative to the area of its root
+		template <class NodeType>
+		FLOAT computeCost(_In_ const std::vector<NodeType>& aNodes, _In_ BOOL bCountsItems) noexcept
+		{
+			FLOAT cost = 0.0f;
+			for (const NodeType& node : aNodes)
+			{
+				FLOAT itemCost = bCountsItems ? static_cast<FLOAT>(node.uCount) : 0.0f;
+				cost += surfaceArea(node.Min, node.Max) * (TRAVERSAL_COST + itemCost);
+			}
+
+			FLOAT rootArea = surfaceArea(aNodes[0].Min, aNodes[0].Max);
+
+			return rootArea > 0.0f ? cost / rootArea : 0.0f;
+		}
+
+		eOverlap testOverlap(_In_ const Frustum& frustum, _In_ const XMFLOAT3& minimum, _In_ const XMFLOAT3& maximum) noexcept
+		{
+			const XMFLOAT3 center((minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f);
+			const XMFLOAT3 extents((maximum.x - minimum.x) * 0.5f, (maximum.y - minimum.y) * 0.5f, (maximum.z - minimum.z) * 0.5f);
+
+			eOverlap overlap = eOverlap::INSIDE;
+			for (const XMFLOAT4& plane : frustum.aPlanes)
+			{
+				FLOAT distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+				FLOAT radius = std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y + std::fabs(plane.z) * extents.z;
+				if (distance + radius < 0.0f)
+				{
+					return eOverlap::OUTSIDE;
+				}
+				if (distance - radius < 0.0f)
+				{
+					overlap = eOverlap::INTERSECTING;
+				}
+			}
+
+			return overlap;
+		}
+
+		eOverlap testOverlap(_In_ const Sphere& sphere, _In_ const XMFLOAT3& minimum, _In_ const XMFLOAT3& maximum) noexcept
+		{
+			FLOAT nearestSquared = 0.0f;
+			FLOAT farthestSquared = 0.0f;
+			for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+			{
+				FLOAT center = getAxis(sphere.Center, uAxis);
+				FLOAT toMinimum = getAxis(minimum, uAxis) - center;
+				FLOAT toMaximum = center - getAxis(maximum, uAxis);
+				FLOAT nearest = std::max(std::max(toMinimum, toMaximum), 0.0f);
+				FLOAT farthest = std::max(std::fabs(toMinimum), std::fabs(toMaximum));
+				nearestSquared += nearest * nearest;
+				farthestSquared += farthest * farthest;
+			}
+
+			FLOAT radiusSquared = sphere.Radius * sphere.Radius;
+			if (nearestSquared > radiusSquared)
+			{
+				return eOverlap::OUTSIDE;
+			}
+
+			return farthestSquared <= radiusSquared ? eOverlap::INSIDE : eOverlap::INTERSECTING;
+		}
+
+		eOverlap testOverlap(_In_ const Box& box, _In_ const XMFLOAT3& minimum, _In_ const XMFLOAT3& maximum) noexcept
+		{
+			if (maximum.x < box.Min.x || maximum.y < box.Min.y || maximum.z < box.Min.z ||
+				minimum.x > box.Max.x || minimum.y > box.Max.y || minimum.z > box.Max.z)
+			{
+				return eOverlap::OUTSIDE;
+			}
+
+			if (minimum.x >= box.Min.x && minimum.y >= box.Min.y && minimum.z >= box.Min.z &&
+				maximum.x <= box.Max.x && maximum.y <= box.Max.y && maximum.z <= box.Max.z)
+			{
+				return eOverlap::INSIDE;
+			}
+
+			return eOverlap::INTERSECTING;
+		}
+
+		// Slab test, writes where the ray enters the box
+		BOOL intersectRay(_In_ const Ray& ray, _In_ const XMFLOAT3& minimum, _In_ const XMFLOAT3& maximum, _Out_ FLOAT& outEntry) noexcept
+		{
+			FLOAT entry = 0.0f;
+			FLOAT exit = ray.Length;
+			for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+			{
+				FLOAT origin = getAxis(ray.Origin, uAxis);
+				FLOAT direction = getAxis(ray.Direction, uAxis);
+				if (direction == 0.0f)
+				{
+					if (origin < getAxis(minimum, uAxis) || origin > getAxis(maximum, uAxis))
+					{
+						return FALSE;
+					}
+					continue;
+				}
+
+				FLOAT invDirection = 1.0f / direction;
+				FLOAT slabEntry = (getAxis(minimum, uAxis) - origin) * invDirection;
+				FLOAT slabExit = (getAxis(maximum, uAxis) - origin) * invDirection;
+				if (slabEntry > slabExit)
+				{
+					std::swap(slabEntry, slabExit);
+				}
+
+				entry = std::max(entry, slabEntry);
+				exit = std::min(exit, slabExit);
+				if (entry > exit)
+				{
+					return FALSE;
+				}
+			}
+
+			outEntry = entry;
+
+			return TRUE;
+		}
+
+		eOverlap testOverlap(_In_ const Ray& ray, _In_ const XMFLOAT3& minimum, _In_ const XMFLOAT3& maximum) noexcept
+		{
+			FLOAT entry = 0.0f;
+
+			return intersectRay(ray, minimum, maximum, entry) ? eOverlap::INTERSECTING : eOverlap::OUTSIDE;
+		}
+
+		// Appends the items of a subtree that overlap a shape, nodes inside the shape add their items untested
+		template <class NodeType, class Shape>
+		void queryNodes(
+			_In_ const std::vector<NodeType>& aNodes,
+			_In_ BOOL bIsInside,
+			_In_ const UINT* auItems,
+			_In_ const Box* aBoxes,
+			_In_ const Shape& shape,
+			_Inout_ std::vector<UINT>& auOutItems
+		)
+		{
+			constexpr const UINT INSIDE_BIT = 0x80000000u;
+
+			std::vector<UINT> stack;
+			stack.reserve(64u);
+			stack.push_back(bIsInside ? INSIDE_BIT : 0u);
+			while (!stack.empty())
+			{
+				const UINT uEntry = stack.back();
+				stack.pop_back();
+
+				const NodeType& node = aNodes[uEntry & ~INSIDE_BIT];
+				BOOL bIsNodeInside = (uEntry & INSIDE_BIT) != 0u;
+				if (!bIsNodeInside)
+				{
+					eOverlap overlap = testOverlap(shape, node.Min, node.Max);
+					if (overlap == eOverlap::OUTSIDE)
+					{
+						continue;
+					}
+					bIsNodeInside = overlap == eOverlap::INSIDE;
+				}
+
+				if (node.uCount > 0u)
+				{
+					for (UINT i = node.uFirst; i < node.uFirst + node.uCount; ++i)
+					{
+						const UINT uItem = auItems[i];
+						if (bIsNodeInside || testOverlap(shape, aBoxes[uItem].Min, aBoxes[uItem].Max) != eOverlap::OUTSIDE)
+						{
+							auOutItems.push_back(uItem);
+						}
+					}
+					continue;
+				}
+
+				const UINT uInsideBit = bIsNodeInside ? INSIDE_BIT : 0u;
+				stack.push_back((node.uFirst + 1u) | uInsideBit);
+				stack.push_back(node.uFirst | uInsideBit);
+			}
+		}
+	}
+
+	BoundingVolumeHierarchy::BoundingVolumeHierarchy() noexcept
+		: m_aBoxes()
+		, m_aCentroids()
+		, m_auItems()
+		, m_aSubtrees()
+		, m_aTopNodes()
+		, m_topBuiltCost(0.0f)
+		, m_uNumRebuiltSubtrees(0u)
+	{
+	}
+
+	void BoundingVolumeHierarchy::Build(_In_reads_(uNumItems) const MeshBounds* aBounds, _In_ UINT uNumItems, _In_ JobSystem& jobSystem)
+	{
+		PR_PROFILE_FUNCTION();
+
+		setBounds(aBounds, uNumItems, jobSystem);
+		buildAll(jobSystem);
+	}
+
+	void BoundingVolumeHierarchy::Refit(_In_reads_(GetNumItems()) const MeshBounds* aBounds, _In_ JobSystem& jobSystem)
+	{
+		PR_PROFILE_FUNCTION();
+
+		setBounds(aBounds, GetNumItems(), jobSystem);
+
+		m_uNumRebuiltSubtrees = 0u;
+		if (m_aSubtrees.empty())
+		{
+			return;
+		}
+
+		// Every subtree is refitted on its own, then the degraded ones are rebuilt over the same items
+		const UINT uNumSubtrees = static_cast<UINT>(m_aSubtrees.size());
+		std::vector<BYTE> abIsDegraded(uNumSubtrees);
+		jobSystem.ParallelFor(uNumSubtrees, 1u, [this, &abIsDegraded](UINT uBegin, UINT uEnd)
+		{
+			for (UINT i = uBegin; i < uEnd; ++i)
+			{
+				abIsDegraded[i] = static_cast<BYTE>(refitSubtree(i));
+			}
+		});
+
+		std::vector<UINT> auDegraded;
+		for (UINT i = 0u; i < uNumSubtrees; ++i)
+		{
+			if (abIsDegraded[i])
+			{
+				auDegraded.push_back(i);
+			}
+		}
+
+		jobSystem.ParallelFor(static_cast<UINT>(auDegraded.size()), 1u, [this, &auDegraded](UINT uBegin, UINT uEnd)
+		{
+			for (UINT i = uBegin; i < uEnd; ++i)
+			{
+				buildSubtree(auDegraded[i]);
+			}
+		});
+		m_uNumRebuiltSubtrees = static_cast<UINT>(auDegraded.size());
+
+		// Items never move between subtrees, so only a full build fixes subtrees that drifted into each other
+		if (refitTop())
+		{
+			buildAll(jobSystem);
+		}
+	}
+
+	void BoundingVolumeHierarchy::QueryFrustums(_In_reads_(uNumQueries) const Frustum* aFrustums, _In_ UINT uNumQueries, _Out_writes_(uNumQueries) std::vector<UINT>* aaOutItems, _In_ JobSystem& jobSystem) const
+	{
+		PR_PROFILE_FUNCTION();
+
+		query(aFrustums, uNumQueries, aaOutItems, jobSystem);
+	}
+
+	void BoundingVolumeHierarchy::QuerySpheres(_In_reads_(uNumQueries) const Sphere* aSpheres, _In_ UINT uNumQueries, _Out_writes_(uNumQueries) std::vector<UINT>* aaOutItems, _In_ JobSystem& jobSystem) const
+	{
+		PR_PROFILE_FUNCTION();
+
+		query(aSpheres, uNumQueries, aaOutItems, jobSystem);
+	}
+
+	void BoundingVolumeHierarchy::QueryBoxes(_In_reads_(uNumQueries) const Box* aBoxes, _In_ UINT uNumQueries, _Out_writes_(uNumQueries) std::vector<UINT>* aaOutItems, _In_ JobSystem& jobSystem) const
+	{
+		PR_PROFILE_FUNCTION();
+
+		query(aBoxes, uNumQueries, aaOutItems, jobSystem);
+	}
+
+	void BoundingVolumeHierarchy::QueryRays(_In_reads_(uNumQueries) const Ray* aRays, _In_ UINT uNumQueries, _Out_writes_(uNumQueries) std::vector<UINT>* aaOutItems, _In_ JobSystem& jobSystem) const
+	{
+		PR_PROFILE_FUNCTION();
+
+		query(aRays, uNumQueries, aaOutItems, jobSystem);
+
+		jobSystem.ParallelFor(uNumQueries, 1u, [this, aRays, aaOutItems](UINT uBegin, UINT uEnd)
+		{
+			std::vector<std::pair<FLOAT, UINT>> aHits;
+			for (UINT uQuery = uBegin; uQuery < uEnd; ++uQuery)
+			{
+				aHits.clear();
+				for (UINT uItem : aaOutItems[uQuery])
+				{
+					FLOAT entry = 0.0f;
+					intersectRay(aRays[uQuery], m_aBoxes[uItem].Min, m_aBoxes[uItem].Max, entry);
+					aHits.emplace_back(entry, uItem);
+				}
+
+				std::sort(aHits.begin(), aHits.end());
+				for (size_t i = 0u; i < aHits.size(); ++i)
+				{
+					aaOutItems[uQuery][i] = aHits[i].second;
+				}
+			}
+		});
+	}
+
+	UINT BoundingVolumeHierarchy::GetNumItems() const noexcept
+	{
+		return static_cast<UINT>(m_aBoxes.size());
+	}
+
+	BoundingVolumeHierarchy::Stats BoundingVolumeHierarchy::GetStats() const noexcept
+	{
+		Stats stats =
+		{
+			.uNumItems = GetNumItems(),
+			.uNumNodes = static_cast<UINT>(m_aTopNodes.size()),
+			.uNumSubtrees = static_cast<UINT>(m_aSubtrees.size()),
+			.uNumRebuiltSubtrees = m_uNumRebuiltSubtrees,
+		};
+
+		for (const Subtree& subtree : m_aSubtrees)
+		{
+			stats.uNumNodes += static_cast<UINT>(subtree.aNodes.size());
+		}
+
+		return stats;
+	}
+
+	void BoundingVolumeHierarchy::setBounds(_In_reads_(uNumItems) const MeshBounds* aBounds, _In_ UINT uNumItems, _In_ JobSystem& jobSystem)
+	{
+		m_aBoxes.resize(uNumItems);
+		m_aCentroids.resize(uNumItems);
+		jobSystem.ParallelFor(uNumItems, ITEMS_PER_JOB, [this, aBounds](UINT uBegin, UINT uEnd)
+		{
+			for (UINT i = uBegin; i < uEnd; ++i)
+			{
+				const XMFLOAT3& c = aBounds[i].Center;
+				const XMFLOAT3& e = aBounds[i].Extents;
+				m_aBoxes[i] = Box{ .Min = XMFLOAT3(c.x - e.x, c.y - e.y, c.z - e.z), .Max = XMFLOAT3(c.x + e.x, c.y + e.y, c.z + e.z) };
+				m_aCentroids[i] = c;
+			}
+		});
+	}
+
+	void BoundingVolumeHierarchy::buildAll(_In_ JobSystem& jobSystem)
+	{
+		const UINT uNumItems = GetNumItems();
+		m_auItems.resize(uNumItems);
+
+		m_aSubtrees.clear();
+		m_aTopNodes.clear();
+		m_topBuiltCost = 0.0f;
+		m_uNumRebuiltSubtrees = 0u;
+		if (uNumItems == 0u)
+		{
+			return;
+		}
+
+		// The top tree only splits, every leaf becomes a subtree
+		std::vector<BuildItem> aItems(uNumItems);
+		for (UINT i = 0u; i < uNumItems; ++i)
+		{
+			aItems[i] = BuildItem{ .Bounds = m_aBoxes[i], .Centroid = m_aCentroids[i], .uItem = i };
+		}
+
+		buildNodes(m_aTopNodes, aItems.data(), uNumItems, 0u, ITEMS_PER_SUBTREE, ITEMS_PER_SUBTREE);
+		for (UINT i = 0u; i < uNumItems; ++i)
+		{
+			m_auItems[i] = aItems[i].uItem;
+		}
+
+		for (Node& node : m_aTopNodes)
+		{
+			if (node.uCount > 0u)
+			{
+				m_aSubtrees.push_back(Subtree{ .aNodes = {}, .uFirstItem = node.uFirst, .uNumItems = node.uCount, .builtCost = 0.0f });
+				node.uFirst = static_cast<UINT>(m_aSubtrees.size()) - 1u;
+			}
+		}
+
+		jobSystem.ParallelFor(static_cast<UINT>(m_aSubtrees.size()), 1u, [this](UINT uBegin, UINT uEnd)
+		{
+			for (UINT i = uBegin; i < uEnd; ++i)
+			{
+				buildSubtree(i);
+			}
+		});
+
+		m_topBuiltCost = computeCost(m_aTopNodes, FALSE);
+		m_uNumRebuiltSubtrees = static_cast<UINT>(m_aSubtrees.size());
+	}
+
+	void BoundingVolumeHierarchy::buildSubtree(_In_ UINT uSubtree)
+	{
+		Subtree& subtree = m_aSubtrees[uSubtree];
+
+		std::vector<BuildItem> aItems(subtree.uNumItems);
+		for (UINT i = 0u; i < subtree.uNumItems; ++i)
+		{
+			const UINT uItem = m_auItems[subtree.uFirstItem + i];
+			aItems[i] = BuildItem{ .Bounds = m_aBoxes[uItem], .Centroid = m_aCentroids[uItem], .uItem = uItem };
+		}
+
+		buildNodes(subtree.aNodes, aItems.data(), subtree.uNumItems, subtree.uFirstItem, 1u, MAX_LEAF_SIZE);
+		for (UINT i = 0u; i < subtree.uNumItems; ++i)
+		{
+			m_auItems[subtree.uFirstItem + i] = aItems[i].uItem;
+		}
+
+		subtree.builtCost = computeCost(subtree.aNodes, TRUE);
+	}
+
+	BOOL BoundingVolumeHierarchy::refitSubtree(_In_ UINT uSubtree) noexcept
+	{
+		Subtree& subtree = m_aSubtrees[uSubtree];
+		refitNodes(subtree.aNodes, [this](const Node& node)
+		{
+			Box bounds = emptyBox();
+			for (UINT i = node.uFirst; i < node.uFirst + node.uCount; ++i)
+			{
+				growBox(bounds, m_aBoxes[m_auItems[i]].Min, m_aBoxes[m_auItems[i]].Max);
+			}
+			return bounds;
+		});
+
+		return computeCost(subtree.aNodes, TRUE) > subtree.builtCost * REBUILD_RATIO;
+	}
+
+	BOOL BoundingVolumeHierarchy::refitTop() noexcept
+	{
+		refitNodes(m_aTopNodes, [this](const Node& node)
+		{
+			const Node& root = m_aSubtrees[node.uFirst].aNodes[0];
+			return Box{ .Min = root.Min, .Max = root.Max };
+		});
+
+		return computeCost(m_aTopNodes, FALSE) > m_topBuiltCost * REBUILD_RATIO;
+	}
+
+	template <class Shape>
+	void BoundingVolumeHierarchy::query(_In_reads_(uNumQueries) const Shape* aShapes, _In_ UINT uNumQueries, _Out_writes_(uNumQueries) std::vector<UINT>* aaOutItems, _In_ JobSystem& jobSystem) const
+	{
+		struct Task
+		{
+			UINT uQuery;
+			UINT uSubtree;
+			BOOL bIsInside;
+		};
+
+		// The top tree is small, so the subtrees every query reaches are found up front and spread over the jobs
+		std::vector<Task> aTasks;
+		std::vector<UINT> stack;
+		for (UINT uQuery = 0u; uQuery < uNumQueries; ++uQuery)
+		{
+			aaOutItems[uQuery].clear();
+			if (m_aTopNodes.empty())
+			{
+				continue;
+			}
+
+			stack.push_back(0u);
+			while (!stack.empty())
+			{
+				const Node& node = m_aTopNodes[stack.back()];
+				stack.pop_back();
+
+				eOverlap overlap = testOverlap(aShapes[uQuery], node.Min, node.Max);
+				if (overlap == eOverlap::OUTSIDE)
+				{
+					continue;
+				}
+
+				if (node.uCount > 0u)
+				{
+					aTasks.push_back(Task{ .uQuery = uQuery, .uSubtree = node.uFirst, .bIsInside = overlap == eOverlap::INSIDE });
+					continue;
+				}
+
+				stack.push_back(node.uFirst + 1u);
+				stack.push_back(node.uFirst);
+			}
+		}
+
+		std::vector<std::vector<UINT>> aaTaskItems(aTasks.size());
+		jobSystem.ParallelFor(static_cast<UINT>(aTasks.size()), 1u, [this, aShapes, &aTasks, &aaTaskItems](UINT uBegin, UINT uEnd)
+		{
+			for (UINT i = uBegin; i < uEnd; ++i)
+			{
+				const Task& task = aTasks[i];
+				queryNodes(m_aSubtrees[task.uSubtree].aNodes, task.bIsInside, m_auItems.data(), m_aBoxes.data(), aShapes[task.uQuery], aaTaskItems[i]);
+			}
+		});
+
+		// The tasks are in query order, so the results do not depend on the schedule
+		for (size_t i = 0u; i < aTasks.size(); ++i)
+		{
+			std::vector<UINT>& auOutItems = aaOutItems[aTasks[i].uQuery];
+			auOutItems.insert(auOutItems.end(), aaTaskItems[i].begin(), aaTaskItems[i].end());
+		}
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/Bounds.h"
+
+namespace pr
+{
+	class JobSystem;
+
+	// Bounding volume hierarchy over world space boxes, the items are the indices of the bounds given to Build.
+	// A top tree splits the items into subtrees of at most ITEMS_PER_SUBTREE, both with a binned surface area
+	// heuristic, and the subtrees are built, refitted and queried in parallel on the job system.
+	// Refit keeps the tree while the bounds move and rebuilds the subtrees whose cost grew by REBUILD_RATIO since
+	// they were built, the whole tree is rebuilt once the top tree degrades the same way.
+	class BoundingVolumeHierarchy final
+	{
+	public:
+		static constexpr const UINT MAX_LEAF_SIZE = 8u;
+		static constexpr const UINT ITEMS_PER_SUBTREE = 1024u;
+		static constexpr const FLOAT REBUILD_RATIO = 2.0f;
+
+		struct Stats
+		{
+			UINT uNumItems;
+			UINT uNumNodes;
+			UINT uNumSubtrees;
+			// Subtrees rebuilt by the last Build or Refit
+			UINT uNumRebuiltSubtrees;
+		};
+
+	public:
+		explicit BoundingVolumeHierarchy() noexcept;
+		BoundingVolumeHierarchy(const BoundingVolumeHierarchy& other) = delete;
+		BoundingVolumeHierarchy(BoundingVolumeHierarchy&& other) = delete;
+		BoundingVolumeHierarchy& operator=(const BoundingVolumeHierarchy& other) = delete;
+		BoundingVolumeHierarchy& operator=(BoundingVolumeHierarchy&& other) = delete;
+		~BoundingVolumeHierarchy() noexcept = default;
+
+		void Build(_In_reads_(uNumItems) const MeshBounds* aBounds, _In_ UINT uNumItems, _In_ JobSystem& jobSystem);
+		// Same items as the last Build with new bounds
+		void Refit(_In_reads_(GetNumItems()) const MeshBounds* aBounds, _In_ JobSystem& jobSystem);
+
+		// Every query writes the items overlapping query i to aaOutItems[i]
+		void QueryFrustums(_In_reads_(uNumQueries) const Frustum* aFrustums, _In_ UINT uNumQueries, _Out_writes_(uNumQueries) std::vector<UINT>* aaOutItems, _In_ JobSystem& jobSystem) const;
+		void QuerySpheres(_In_reads_(uNumQueries) const Sphere* aSpheres, _In_ UINT uNumQueries, _Out_writes_(uNumQueries) std::vector<UINT>* aaOutItems, _In_ JobSystem& jobSystem) const;
+		void QueryBoxes(_In_reads_(uNumQueries) const Box* aBoxes, _In_ UINT uNumQueries, _Out_writes_(uNumQueries) std::vector<UINT>* aaOutItems, _In_ JobSystem& jobSystem) const;
+		// Items whose boxes the rays hit, sorted by the distance where the ray enters the box
+		void QueryRays(_In_reads_(uNumQueries) const Ray* aRays, _In_ UINT uNumQueries, _Out_writes_(uNumQueries) std::vector<UINT>* aaOutItems, _In_ JobSystem& jobSystem) const;
+
+		UINT GetNumItems() const noexcept;
+		Stats GetStats() const noexcept;
+
+	private:
+		// Leaves have a count, internal nodes have their two children at uFirst and uFirst + 1.
+		// Leaves of subtrees refer to items at m_auItems[uFirst], leaves of the top tree to the subtree uFirst.
+		struct Node
+		{
+			XMFLOAT3 Min;
+			UINT uFirst;
+			XMFLOAT3 Max;
+			UINT uCount;
+		};
+		static_assert(sizeof(Node) == 32);
+
+		struct Subtree
+		{
+			std::vector<Node> aNodes;
+			UINT uFirstItem;
+			UINT uNumItems;
+			FLOAT builtCost;
+		};
+
+	private:
+		void setBounds(_In_reads_(uNumItems) const MeshBounds* aBounds, _In_ UINT uNumItems, _In_ JobSystem& jobSystem);
+		void buildAll(_In_ JobSystem& jobSystem);
+		void buildSubtree(_In_ UINT uSubtree);
+		BOOL refitSubtree(_In_ UINT uSubtree) noexcept;
+		BOOL refitTop() noexcept;
+
+		template <class Shape>
+		void query(_In_reads_(uNumQueries) const Shape* aShapes, _In_ UINT uNumQueries, _Out_writes_(uNumQueries) std::vector<UINT>* aaOutItems, _In_ JobSystem& jobSystem) const;
+
+	private:
+		// Indexed by item
+		std::vector<Box> m_aBoxes;
+		std::vector<XMFLOAT3> m_aCentroids;
+
+		// Items in leaf order, the items of a subtree are contiguous
+		std::vector<UINT> m_auItems;
+
+		std::vector<Subtree> m_aSubtrees;
+		std::vector<Node> m_aTopNodes;
+		FLOAT m_topBuiltCost;
+		UINT m_uNumRebuiltSubtrees;
+	};
+}
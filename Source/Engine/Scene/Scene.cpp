@@ -2,98 +2,1084 @@
 
 #include "Scene/Scene.h"
 
+#include <algorithm>
+
+#include "Graphics/CookedRenderable.h"
+#include "Scene/SceneArchive.h"
+#include "Scene/SceneFile.h"
+#include "Scene/SceneStreamer.h"
+#include "Utility/JobSystem.h"
+#include "Utility/Math.h"
+#include "Utility/Profiler.h"
+#include "Utility/Utility.h"
+
 namespace pr
 {
+    namespace
+    {
+        // Strings of scene files are UTF-8
+        std::wstring toWideString(_In_ PCSTR pszUtf8)
+        {
+            return std::filesystem::path(reinterpret_cast<const char8_t*>(pszUtf8)).wstring();
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::Scene
+
+      Summary:  Constructor
+
+      Modifies: [m_aRenderables, m_aWorldMatrices, m_auFlags,
+                 m_auFirstMeshes, m_auTransformNodes, m_auTransformVersions,
+                 m_auSlots, m_aMeshBounds, m_aSlots, m_auFreeSlots,
+                 m_Transforms, m_Bvh, m_renderableNames, m_aMaterials,
+                 m_materialNames, m_aLights, m_pStreamer,
+                 m_StreamingSettings, m_bIsMeshLayoutDirty].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    Scene::Scene() noexcept
+        : m_aRenderables()
+        , m_aWorldMatrices()
+        , m_auFlags()
+        , m_auFirstMeshes()
+        , m_auTransformNodes()
+        , m_auTransformVersions()
+        , m_auSlots()
+        , m_aMeshBounds()
+        , m_aSlots()
+        , m_auFreeSlots()
+        , m_Transforms()
+        , m_Bvh()
+        , m_renderableNames()
+        , m_aMaterials()
+        , m_materialNames()
+        , m_aLights()
+        , m_pStreamer()
+        , m_StreamingSettings(StreamingPolicy::GetDefaultSettings())
+        , m_bIsMeshLayoutDirty(FALSE)
+    {
+    }
+
+    Scene::~Scene() = default;
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::Initialize
+
+      Summary:  Loads every renderable and material on the job system,
+                models import their files, convert their meshes and
+                decode their textures with nested jobs, then creates
+                the resources and records their uploads on this thread.
+                With streaming enabled, the streamable renderables
+                are only sorted into cells and stay released
+
+      Args:     ID3D12Device2* pDevice
+                  Device to create the resources with
+                ID3D12GraphicsCommandList2* pCommandList
+                  Command list to record the uploads to
+
+      Returns:  HRESULT
+                  Status code of the first renderable or material in
+                  scene order that failed
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     HRESULT Scene::Initialize(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList)
     {
-        for (auto it = m_renderables.begin(); it != m_renderables.end(); ++it)
+        PR_PROFILE_FUNCTION();
+
+        // Streamed renderables and the materials only they use are loaded by the streamer later
+        std::vector<Renderable*> apRenderables;
+        std::vector<Material*> apMaterials;
+        {
+            std::unordered_set<const Material*> streamedMaterials;
+            std::unordered_set<const Material*> residentMaterials;
+            for (const std::shared_ptr<Renderable>& renderable : m_aRenderables)
+            {
+                BOOL bIsStreamed = m_pStreamer && renderable->IsStreamable();
+                if (!bIsStreamed)
+                {
+                    apRenderables.push_back(renderable.get());
+                }
+
+                for (UINT i = 0u; i < renderable->GetNumMaterials(); ++i)
+                {
+                    (bIsStreamed ? streamedMaterials : residentMaterials).insert(renderable->GetMaterial(i).get());
+                }
+            }
+
+            for (const std::shared_ptr<Material>& material : m_aMaterials)
+            {
+                if (!streamedMaterials.contains(material.get()) || residentMaterials.contains(material.get()))
+                {
+                    apMaterials.push_back(material.get());
+                }
+            }
+        }
+
+        const UINT uNumRenderables = static_cast<UINT>(apRenderables.size());
+        const UINT uNumMaterials = static_cast<UINT>(apMaterials.size());
+        std::vector<HRESULT> aHrs(static_cast<size_t>(uNumRenderables) + uNumMaterials, S_OK);
+        {
+            PR_PROFILE_SCOPE("Scene::Initialize >> Load");
+            JobSystem::GetInstance().ParallelFor(
+                uNumRenderables + uNumMaterials,
+                1u,
+                [&apRenderables, &apMaterials, uNumRenderables, &aHrs](UINT uBegin, UINT uEnd)
+                {
+                    for (UINT i = uBegin; i < uEnd; ++i)
+                    {
+                        aHrs[i] = i < uNumRenderables ? apRenderables[i]->Load() : apMaterials[i - uNumRenderables]->Load();
+                    }
+                }
+            );
+        }
+
+        for (HRESULT hr : aHrs)
+        {
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
+        // Only the device calls and the recording of the uploads are serialized
+        for (Renderable* pRenderable : apRenderables)
         {
-            HRESULT hr = it->second->Initialize(pDevice, pCommandList);
+            HRESULT hr = pRenderable->Initialize(pDevice, pCommandList);
             if (FAILED(hr))
             {
                 return hr;
             }
         }
 
-        for (auto it = m_materials.begin(); it != m_materials.end(); ++it)
+        for (Material* pMaterial : apMaterials)
         {
-            HRESULT hr = it->second->Initialize(pDevice, pCommandList);
+            HRESULT hr = pMaterial->Initialize(pDevice, pCommandList);
             if (FAILED(hr))
             {
                 return hr;
             }
         }
 
+        // The meshes are only known once the renderables are initialized
+        updateTransforms();
+        rebuildMeshBounds();
+
+        // Cooked renderables know their meshes without being initialized, so the cells are built from the mesh bounds
+        if (m_pStreamer)
+        {
+            m_pStreamer->Initialize(m_aRenderables, m_auFirstMeshes.data(), m_aMeshBounds.data(), m_StreamingSettings);
+        }
+
         return S_OK;
     }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Renderer::AddRenderable
+      Method:   Scene::AddRenderable
 
-      Summary:  Add a renderable object and initialize the object
+      Summary:  Add a named renderable object
 
       Args:     PCWSTR pszRenderableName
                   Key of the renderable object
                 const std::shared_ptr<Renderable>& renderable
-                  Unique pointer to the renderable object
+                  Shared pointer to the renderable object
+                RenderableHandle* pOutHandle
+                  Optional handle of the added renderable
 
-      Modifies: [m_renderables].
+      Modifies: [m_renderableNames].
 
       Returns:  HRESULT
-                  Status code.
+                  Status code, E_FAIL if the name is taken.
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    HRESULT Scene::AddRenderable(_In_ PCWSTR pszRenderableName, _In_ const std::shared_ptr<Renderable>& renderable)
+    HRESULT Scene::AddRenderable(_In_ PCWSTR pszRenderableName, _In_ const std::shared_ptr<Renderable>& renderable, _Out_opt_ RenderableHandle* pOutHandle)
     {
-        if (m_renderables.contains(pszRenderableName))
+        if (m_renderableNames.contains(pszRenderableName))
         {
             return E_FAIL;
         }
 
-        m_renderables[pszRenderableName] = renderable;
+        RenderableHandle handle = AddRenderable(renderable);
+        m_renderableNames[pszRenderableName] = handle;
+
+        if (pOutHandle)
+        {
+            *pOutHandle = handle;
+        }
 
         return S_OK;
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::AddRenderable
+
+      Summary:  Add an unnamed renderable object at the end of the
+                component arrays
+
+      Args:     const std::shared_ptr<Renderable>& renderable
+                  Shared pointer to the renderable object
+
+      Modifies: [m_aRenderables, m_aWorldMatrices, m_auFlags,
+                 m_auFirstMeshes, m_auTransformNodes,
+                 m_auTransformVersions, m_auSlots, m_aSlots,
+                 m_auFreeSlots, m_Transforms, m_bIsMeshLayoutDirty].
+
+      Returns:  RenderableHandle
+                  Handle of the added renderable.
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    RenderableHandle Scene::AddRenderable(_In_ const std::shared_ptr<Renderable>& renderable)
+    {
+        UINT uSlot = 0u;
+        if (m_auFreeSlots.empty())
+        {
+            uSlot = static_cast<UINT>(m_aSlots.size());
+            m_aSlots.push_back(Slot{ .uDenseIndex = 0u, .uGeneration = 1u });
+        }
+        else
+        {
+            uSlot = m_auFreeSlots.back();
+            m_auFreeSlots.pop_back();
+        }
+
+        m_aSlots[uSlot].uDenseIndex = static_cast<UINT>(m_aRenderables.size());
+
+        // The world matrix is computed on the next update
+        XMFLOAT4X4 world;
+        XMStoreFloat4x4(&world, XMMatrixIdentity());
+
+        m_aRenderables.push_back(renderable);
+        m_aWorldMatrices.push_back(world);
+        m_auFlags.push_back(renderable->IsOccluder() ? RENDERABLE_FLAG_OCCLUDER : 0u);
+        m_auFirstMeshes.push_back(0u);
+        m_auTransformNodes.push_back(m_Transforms.AddNode(TransformHierarchy::INVALID_NODE, renderable->GetLocalTransform()));
+        m_auTransformVersions.push_back(renderable->GetTransformVersion());
+        m_auSlots.push_back(uSlot);
+        m_bIsMeshLayoutDirty = TRUE;
+
+        return RenderableHandle{ .uIndex = uSlot, .uGeneration = m_aSlots[uSlot].uGeneration };
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::RemoveRenderable
+
+      Summary:  Remove a renderable object, the last renderable moves
+                into its place in the component arrays. Its children
+                move to its parent
+
+      Args:     RenderableHandle handle
+                  Handle of the renderable object
+
+      Modifies: [m_aRenderables, m_aWorldMatrices, m_auFlags,
+                 m_auFirstMeshes, m_auTransformNodes,
+                 m_auTransformVersions, m_auSlots, m_aSlots,
+                 m_auFreeSlots, m_Transforms, m_renderableNames,
+                 m_bIsMeshLayoutDirty].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG if the handle is stale.
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::RemoveRenderable(_In_ RenderableHandle handle)
+    {
+        if (!GetRenderable(handle))
+        {
+            return E_INVALIDARG;
+        }
+
+        UINT uDenseIndex = m_aSlots[handle.uIndex].uDenseIndex;
+        m_Transforms.RemoveNode(m_auTransformNodes[uDenseIndex]);
+
+        UINT uLastIndex = static_cast<UINT>(m_aRenderables.size()) - 1u;
+        if (uDenseIndex != uLastIndex)
+        {
+            m_aRenderables[uDenseIndex] = std::move(m_aRenderables[uLastIndex]);
+            m_aWorldMatrices[uDenseIndex] = m_aWorldMatrices[uLastIndex];
+            m_auFlags[uDenseIndex] = m_auFlags[uLastIndex];
+            m_auTransformNodes[uDenseIndex] = m_auTransformNodes[uLastIndex];
+            m_auTransformVersions[uDenseIndex] = m_auTransformVersions[uLastIndex];
+            m_auSlots[uDenseIndex] = m_auSlots[uLastIndex];
+            m_aSlots[m_auSlots[uDenseIndex]].uDenseIndex = uDenseIndex;
+        }
+
+        m_aRenderables.pop_back();
+        m_aWorldMatrices.pop_back();
+        m_auFlags.pop_back();
+        m_auFirstMeshes.pop_back();
+        m_auTransformNodes.pop_back();
+        m_auTransformVersions.pop_back();
+        m_auSlots.pop_back();
+
+        ++m_aSlots[handle.uIndex].uGeneration;
+        m_auFreeSlots.push_back(handle.uIndex);
+
+        std::erase_if(
+            m_renderableNames,
+            [&handle](const auto& entry)
+            {
+                return entry.second.uIndex == handle.uIndex;
+            }
+        );
+
+        m_bIsMeshLayoutDirty = TRUE;
+
+        return S_OK;
+    }
+
+    RenderableHandle Scene::FindRenderable(_In_ PCWSTR pszRenderableName) const
+    {
+        auto it = m_renderableNames.find(pszRenderableName);
+        if (it == m_renderableNames.end())
+        {
+            return RenderableHandle{ .uIndex = 0u, .uGeneration = 0u };
+        }
+
+        return it->second;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetRenderable
+
+      Summary:  Returns the renderable of a handle
+
+      Args:     RenderableHandle handle
+                  Handle of the renderable object
+
+      Returns:  Renderable*
+                  The renderable, nullptr if the handle is stale.
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    Renderable* Scene::GetRenderable(_In_ RenderableHandle handle) const noexcept
+    {
+        if (handle.uIndex >= m_aSlots.size() || m_aSlots[handle.uIndex].uGeneration != handle.uGeneration)
+        {
+            return nullptr;
+        }
+
+        return m_aRenderables[m_aSlots[handle.uIndex].uDenseIndex].get();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::SetParent
+
+      Summary:  Attaches a renderable to a parent renderable, or
+                detaches it when the parent handle is empty
+
+      Args:     RenderableHandle child
+                  Handle of the renderable to attach
+                RenderableHandle parent
+                  Handle of the parent, a zero generation detaches
+
+      Modifies: [m_Transforms].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG for stale handles or when
+                  the parent is the child or one of its descendants.
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::SetParent(_In_ RenderableHandle child, _In_ RenderableHandle parent)
+    {
+        if (!GetRenderable(child) || (parent.uGeneration != 0u && !GetRenderable(parent)))
+        {
+            return E_INVALIDARG;
+        }
+
+        UINT uParentNode = TransformHierarchy::INVALID_NODE;
+        if (parent.uGeneration != 0u)
+        {
+            uParentNode = m_auTransformNodes[m_aSlots[parent.uIndex].uDenseIndex];
+        }
+
+        return m_Transforms.SetParent(m_auTransformNodes[m_aSlots[child.uIndex].uDenseIndex], uParentNode);
+    }
+
     HRESULT Scene::AddMaterial(_In_ const std::shared_ptr<Material>& material)
     {
-        if (m_materials.contains(material->GetName()))
+        std::wstring name = material->GetName();
+        if (m_materialNames.contains(name))
         {
             return E_FAIL;
         }
 
-        m_materials[material->GetName()] = material;
+        m_materialNames[name] = static_cast<UINT>(m_aMaterials.size());
+        m_aMaterials.push_back(material);
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::AddLight
+
+      Summary:  Add a point or spot light, lights are culled per frame
+                by the renderer
+
+      Args:     const LightData& light
+                  World space light
+
+      Modifies: [m_aLights].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Scene::AddLight(_In_ const LightData& light)
+    {
+        m_aLights.push_back(light);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::LoadFile
+
+      Summary:  Maps a cooked scene file and adds its renderables,
+                materials and lights. The renderables draw the
+                geometry straight from the mapping and the textures
+                are the cooked DDS files next to it, both are read by
+                the next Initialize. Materials named like one of the
+                scene are that material
+
+      Args:     const std::filesystem::path& filePath
+                  Path of the scene file
+
+      Modifies: [m_aRenderables, m_aWorldMatrices, m_auFlags,
+                 m_auFirstMeshes, m_auTransformNodes,
+                 m_auTransformVersions, m_auSlots, m_aSlots,
+                 m_auFreeSlots, m_Transforms, m_renderableNames,
+                 m_aMaterials, m_materialNames, m_aLights,
+                 m_bIsMeshLayoutDirty].
+
+      Returns:  HRESULT
+                  Status code, the error of the file system if there
+                  is no file and E_FAIL if a name of the file is
+                  already taken, nothing is added then.
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::LoadFile(_In_ const std::filesystem::path& filePath)
+    {
+        PR_PROFILE_FUNCTION();
+
+        std::shared_ptr<SceneArchive> pArchive = std::make_shared<SceneArchive>();
+        HRESULT hr = pArchive->Initialize(filePath);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        const SceneFile::View& view = pArchive->GetView();
+
+        std::vector<std::wstring> aNames(view.uNumRenderables);
+        std::unordered_map<std::wstring, UINT> fileNames;
+        for (UINT i = 0u; i < view.uNumRenderables; ++i)
+        {
+            if (view.aRenderables[i].uName == SceneFile::INVALID_INDEX)
+            {
+                continue;
+            }
+
+            aNames[i] = toWideString(SceneFile::GetString(view, view.aRenderables[i].uName));
+            if (m_renderableNames.contains(aNames[i]) || !fileNames.try_emplace(aNames[i], i).second)
+            {
+                hr = E_FAIL;
+                CHECK_AND_RETURN_HRESULT(hr, L"Scene::LoadFile >> Renderable name is already taken");
+            }
+        }
+
+        std::vector<std::shared_ptr<Texture>> apTextures(view.uNumTextures);
+        for (UINT i = 0u; i < view.uNumTextures; ++i)
+        {
+            apTextures[i] = std::make_shared<Texture>(pArchive->GetDirectory() / toWideString(SceneFile::GetString(view, view.aTextures[i].uPath)));
+        }
+
+        auto getTexture = [&apTextures](UINT uTexture) -> std::shared_ptr<Texture>
+        {
+            return uTexture == SceneFile::INVALID_INDEX ? nullptr : apTextures[uTexture];
+        };
+
+        std::vector<std::shared_ptr<Material>> apMaterials(view.uNumMaterials);
+        for (UINT i = 0u; i < view.uNumMaterials; ++i)
+        {
+            const SceneFile::Material& record = view.aMaterials[i];
+            std::wstring name = toWideString(SceneFile::GetString(view, record.uName));
+
+            auto it = m_materialNames.find(name);
+            if (it != m_materialNames.end())
+            {
+                apMaterials[i] = m_aMaterials[it->second];
+                continue;
+            }
+
+            apMaterials[i] = std::make_shared<Material>(name);
+            apMaterials[i]->pDiffuse = getTexture(record.uDiffuse);
+            apMaterials[i]->pSpecularExponent = getTexture(record.uSpecularExponent);
+            apMaterials[i]->pNormal = getTexture(record.uNormal);
+            AddMaterial(apMaterials[i]);
+        }
+
+        // The first renderable of each geometry uploads it, the others share its buffers
+        std::vector<CookedRenderable*> apGeometrySources(view.uNumGeometries, nullptr);
+        std::vector<RenderableHandle> aHandles(view.uNumRenderables);
+        for (UINT i = 0u; i < view.uNumRenderables; ++i)
+        {
+            const SceneFile::Renderable& record = view.aRenderables[i];
+
+            std::vector<std::shared_ptr<Material>> aBindings(record.uNumBindings);
+            for (UINT j = 0u; j < record.uNumBindings; ++j)
+            {
+                aBindings[j] = apMaterials[view.auMaterialBindings[record.uFirstBinding + j]];
+            }
+
+            std::shared_ptr<CookedRenderable> renderable = std::make_shared<CookedRenderable>(
+                pArchive,
+                record.uGeometry,
+                std::move(aBindings),
+                apGeometrySources[record.uGeometry]
+            );
+            if (!apGeometrySources[record.uGeometry])
+            {
+                apGeometrySources[record.uGeometry] = renderable.get();
+            }
+
+            renderable->SetLocalTransform(record.Local);
+            renderable->SetRenderPass(static_cast<eRenderPass>(record.uRenderPass));
+            renderable->SetOccluder((record.uFlags & RENDERABLE_FLAG_OCCLUDER) ? TRUE : FALSE);
+
+            if (record.uName == SceneFile::INVALID_INDEX)
+            {
+                aHandles[i] = AddRenderable(renderable);
+            }
+            else
+            {
+                AddRenderable(aNames[i].c_str(), renderable, &aHandles[i]);
+            }
+        }
+
+        for (UINT i = 0u; i < view.uNumRenderables; ++i)
+        {
+            if (view.aRenderables[i].uParent != SceneFile::INVALID_INDEX)
+            {
+                hr = SetParent(aHandles[i], aHandles[view.aRenderables[i].uParent]);
+                CHECK_AND_RETURN_HRESULT(hr, L"Scene::LoadFile >> Scene file has a cycle of parents");
+            }
+        }
+
+        m_aLights.insert(m_aLights.end(), view.aLights, view.aLights + view.uNumLights);
 
         return S_OK;
     }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Renderer::Update
+      Method:   Scene::SaveFile
 
-      Summary:  Update the renderables each frame
+      Summary:  Writes the renderables, materials and lights into a
+                scene file LoadFile maps. Renderables sharing their
+                geometry write it once, the textures are saved as
+                <scene name>.<index>.dds next to the scene file. The
+                geometry is taken from the CPU copies of the
+                renderables, so the scene has to be initialized
+
+      Args:     const std::filesystem::path& filePath
+                  Path of the scene file
+
+      Returns:  HRESULT
+                  Status code, E_NOT_VALID_STATE if no renderable of
+                  a geometry kept its vertices.
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::SaveFile(_In_ const std::filesystem::path& filePath) const
+    {
+        PR_PROFILE_FUNCTION();
+
+        HRESULT hr = S_OK;
+        const UINT uNumRenderables = static_cast<UINT>(m_aRenderables.size());
+
+        // Renderables sharing a geometry only keep the vertices in one of them
+        std::vector<UINT> auGeometries(uNumRenderables, SceneFile::INVALID_INDEX);
+        std::vector<const Renderable*> apGeometrySources;
+        for (UINT i = 0u; i < uNumRenderables; ++i)
+        {
+            const Renderable* pRenderable = m_aRenderables[i].get();
+            for (UINT j = 0u; j < apGeometrySources.size(); ++j)
+            {
+                if (apGeometrySources[j]->SharesGeometry(*pRenderable))
+                {
+                    auGeometries[i] = j;
+                    if (apGeometrySources[j]->GetNumVertices() == 0u)
+                    {
+                        apGeometrySources[j] = pRenderable;
+                    }
+                    break;
+                }
+            }
+
+            if (auGeometries[i] == SceneFile::INVALID_INDEX)
+            {
+                auGeometries[i] = static_cast<UINT>(apGeometrySources.size());
+                apGeometrySources.push_back(pRenderable);
+            }
+        }
+
+        std::vector<SceneFile::Geometry> aGeometries(apGeometrySources.size());
+        std::vector<SceneFile::Mesh> aMeshes;
+        std::vector<BYTE> aData;
+        for (UINT i = 0u; i < apGeometrySources.size(); ++i)
+        {
+            const Renderable* pSource = apGeometrySources[i];
+            if (pSource->GetNumVertices() == 0u)
+            {
+                hr = E_NOT_VALID_STATE;
+                CHECK_AND_RETURN_HRESULT(hr, L"Scene::SaveFile >> Geometry without vertices, the scene is not initialized");
+            }
+
+            const size_t uVerticesSize = static_cast<size_t>(pSource->GetNumVertices()) * VERTEX_SIZE[static_cast<size_t>(pSource->GetVertexType())];
+            const size_t uIndicesSize = static_cast<size_t>(pSource->GetNumIndices()) * sizeof(WORD);
+            const size_t uVertices = AlignUp(aData.size(), SceneFile::SECTION_ALIGNMENT);
+            const size_t uIndices = AlignUp(uVertices + uVerticesSize, SceneFile::SECTION_ALIGNMENT);
+            aData.resize(uIndices + uIndicesSize);
+            memcpy(aData.data() + uVertices, pSource->GetVertices(), uVerticesSize);
+            memcpy(aData.data() + uIndices, pSource->GetIndices(), uIndicesSize);
+
+            aGeometries[i] =
+            {
+                .uVertices = uVertices,
+                .uIndices = uIndices,
+                .uNumVertices = pSource->GetNumVertices(),
+                .uNumIndices = pSource->GetNumIndices(),
+                .uVertexType = static_cast<UINT>(pSource->GetVertexType()),
+                .uFirstMesh = static_cast<UINT>(aMeshes.size()),
+                .uNumMeshes = pSource->GetNumMeshes(),
+                .uReserved = 0u,
+                .Decode = pSource->GetPositionDecode(),
+            };
+
+            for (UINT j = 0u; j < pSource->GetNumMeshes(); ++j)
+            {
+                const Renderable::BasicMeshEntry& entry = pSource->GetMeshEntry(j);
+
+                SceneFile::Mesh mesh =
+                {
+                    .uNumIndices = entry.uNumIndices,
+                    .uBaseVertex = entry.uBaseVertex,
+                    .uBaseIndex = entry.uBaseIndex,
+                    .uMaterialIndex = entry.uMaterialIndex,
+                    .Bounds = entry.Bounds,
+                    .uNumLods = entry.uNumLods,
+                    .aLods = {},
+                };
+                for (UINT uLod = 1u; uLod < entry.uNumLods; ++uLod)
+                {
+                    mesh.aLods[uLod - 1u] =
+                    {
+                        .uNumIndices = entry.aLods[uLod - 1u].uNumIndices,
+                        .uBaseIndex = entry.aLods[uLod - 1u].uBaseIndex,
+                        .Error = entry.aLods[uLod - 1u].Error,
+                    };
+                }
+                aMeshes.push_back(mesh);
+            }
+        }
+
+        std::string strings;
+        auto addString = [&strings](const std::wstring& string)
+        {
+            const UINT uOffset = static_cast<UINT>(strings.size());
+            const std::u8string utf8 = std::filesystem::path(string).u8string();
+            strings.append(reinterpret_cast<const CHAR*>(utf8.c_str()), utf8.size() + 1u);
+            return uOffset;
+        };
+
+        // Textures are the same if they come from the same file
+        std::vector<Texture*> apTextures;
+        std::unordered_map<std::wstring, UINT> textureIndices;
+        auto addTexture = [&apTextures, &textureIndices](const std::shared_ptr<Texture>& texture)
+        {
+            if (!texture)
+            {
+                return SceneFile::INVALID_INDEX;
+            }
+
+            auto [it, bIsNew] = textureIndices.try_emplace(texture->GetFilePath().wstring(), static_cast<UINT>(apTextures.size()));
+            if (bIsNew)
+            {
+                apTextures.push_back(texture.get());
+            }
+            return it->second;
+        };
+
+        std::vector<SceneFile::Material> aMaterials;
+        std::unordered_map<const Material*, UINT> materialIndices;
+        auto addMaterial = [&aMaterials, &materialIndices, &addString, &addTexture](const std::shared_ptr<Material>& material)
+        {
+            auto [it, bIsNew] = materialIndices.try_emplace(material.get(), static_cast<UINT>(aMaterials.size()));
+            if (bIsNew)
+            {
+                aMaterials.push_back(
+                    SceneFile::Material
+                    {
+                        .uName = addString(material->GetName()),
+                        .uDiffuse = addTexture(material->pDiffuse),
+                        .uSpecularExponent = addTexture(material->pSpecularExponent),
+                        .uNormal = addTexture(material->pNormal),
+                    }
+                );
+            }
+            return it->second;
+        };
+
+        for (const std::shared_ptr<Material>& material : m_aMaterials)
+        {
+            addMaterial(material);
+        }
+
+        std::vector<const std::wstring*> apNames(m_aSlots.size(), nullptr);
+        for (const auto& [name, handle] : m_renderableNames)
+        {
+            apNames[handle.uIndex] = &name;
+        }
+
+        std::unordered_map<UINT, UINT> nodeRenderables;
+        for (UINT i = 0u; i < uNumRenderables; ++i)
+        {
+            nodeRenderables[m_auTransformNodes[i]] = i;
+        }
+
+        std::vector<SceneFile::Renderable> aRenderables(uNumRenderables);
+        std::vector<UINT> auMaterialBindings;
+        for (UINT i = 0u; i < uNumRenderables; ++i)
+        {
+            const Renderable* pRenderable = m_aRenderables[i].get();
+            const UINT uParentNode = m_Transforms.GetParent(m_auTransformNodes[i]);
+            const std::wstring* pName = apNames[m_auSlots[i]];
+
+            aRenderables[i] =
+            {
+                .Local = pRenderable->GetLocalTransform(),
+                .uName = pName ? addString(*pName) : SceneFile::INVALID_INDEX,
+                .uParent = uParentNode == TransformHierarchy::INVALID_NODE ? SceneFile::INVALID_INDEX : nodeRenderables.at(uParentNode),
+                .uFlags = pRenderable->IsOccluder() ? RENDERABLE_FLAG_OCCLUDER : 0u,
+                .uRenderPass = static_cast<UINT>(pRenderable->GetRenderPass()),
+                .uGeometry = auGeometries[i],
+                .uFirstBinding = static_cast<UINT>(auMaterialBindings.size()),
+                .uNumBindings = pRenderable->GetNumMaterials(),
+                .uReserved = 0u,
+            };
+
+            for (UINT j = 0u; j < pRenderable->GetNumMaterials(); ++j)
+            {
+                auMaterialBindings.push_back(addMaterial(pRenderable->GetMaterial(j)));
+            }
+        }
+
+        // Decoding and writing the textures is most of the work, one job per texture
+        std::vector<SceneFile::Texture> aTextures(apTextures.size());
+        std::vector<std::filesystem::path> aTexturePaths(apTextures.size());
+        for (UINT i = 0u; i < apTextures.size(); ++i)
+        {
+            aTexturePaths[i] = filePath.stem();
+            aTexturePaths[i] += L"." + std::to_wstring(i) + L".dds";
+            aTextures[i].uPath = addString(aTexturePaths[i].wstring());
+        }
+
+        std::vector<HRESULT> aHrs(apTextures.size(), S_OK);
+        JobSystem::GetInstance().ParallelFor(
+            static_cast<UINT>(apTextures.size()),
+            1u,
+            [&apTextures, &aTexturePaths, &aHrs, &filePath](UINT uBegin, UINT uEnd)
+            {
+                for (UINT i = uBegin; i < uEnd; ++i)
+                {
+                    aHrs[i] = apTextures[i]->Save(filePath.parent_path() / aTexturePaths[i]);
+                }
+            }
+        );
+
+        for (HRESULT hrTexture : aHrs)
+        {
+            if (FAILED(hrTexture))
+            {
+                return hrTexture;
+            }
+        }
+
+        const SceneFile::View view =
+        {
+            .aRenderables = aRenderables.data(),
+            .uNumRenderables = static_cast<UINT>(aRenderables.size()),
+            .aGeometries = aGeometries.data(),
+            .uNumGeometries = static_cast<UINT>(aGeometries.size()),
+            .aMeshes = aMeshes.data(),
+            .uNumMeshes = static_cast<UINT>(aMeshes.size()),
+            .auMaterialBindings = auMaterialBindings.data(),
+            .uNumMaterialBindings = static_cast<UINT>(auMaterialBindings.size()),
+            .aMaterials = aMaterials.data(),
+            .uNumMaterials = static_cast<UINT>(aMaterials.size()),
+            .aTextures = aTextures.data(),
+            .uNumTextures = static_cast<UINT>(aTextures.size()),
+            .aLights = m_aLights.data(),
+            .uNumLights = static_cast<UINT>(m_aLights.size()),
+            .pStrings = strings.data(),
+            .uStringsSize = static_cast<UINT>(strings.size()),
+            .pData = aData.data(),
+            .uDataSize = aData.size(),
+        };
+
+        std::vector<BYTE> aFile;
+        hr = SceneFile::Write(aFile, view);
+        CHECK_AND_RETURN_HRESULT(hr, L"Scene::SaveFile >> Laying out scene file");
+
+        std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const CHAR*>(aFile.data()), static_cast<std::streamsize>(aFile.size()));
+        if (!file)
+        {
+            hr = E_FAIL;
+            CHECK_AND_RETURN_HRESULT(hr, L"Scene::SaveFile >> Writing scene file");
+        }
+
+        return hr;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::EnableStreaming
+
+      Summary:  Streams the streamable renderables, those of cooked
+                scene files, in cells around the camera within the
+                memory budgets of the settings. Called before
+                Initialize, later calls only change the settings
+
+      Args:     const StreamingPolicy::Settings& settings
+                  Budgets and distances of the streaming policy
+
+      Modifies: [m_pStreamer, m_StreamingSettings].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Scene::EnableStreaming(_In_ const StreamingPolicy::Settings& settings)
+    {
+        m_StreamingSettings = settings;
+        if (m_pStreamer)
+        {
+            m_pStreamer->SetSettings(settings);
+            return;
+        }
+
+        m_pStreamer = std::make_unique<SceneStreamer>();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::UpdateStreaming
+
+      Summary:  Records the uploads of the cells whose background
+                loads finished, then lets the streaming policy pick
+                the cells to evict and to load for the view. Does
+                nothing unless streaming is enabled
+
+      Args:     const StreamingPolicy::View& view
+                  Camera of the frame
+                ID3D12Device2* pDevice
+                  Device to create the resources with
+                ID3D12GraphicsCommandList2* pCommandList
+                  Command list to record the uploads to, executed
+                  before any draw of the frame
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::UpdateStreaming(_In_ const StreamingPolicy::View& view, _In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList)
+    {
+        if (!m_pStreamer)
+        {
+            return S_OK;
+        }
+
+        return m_pStreamer->Update(view, pDevice, pCommandList);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::Update
+
+      Summary:  Update the renderables each frame and pick up the
+                ones that moved
 
       Args:     FLOAT deltaTime
                   Time difference of a frame
+
+      Modifies: [m_aWorldMatrices, m_auFlags, m_auTransformVersions,
+                 m_Transforms, m_aMeshBounds, m_Bvh].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     void Scene::Update(_In_ FLOAT deltaTime)
     {
-        for (auto it = m_renderables.begin(); it != m_renderables.end(); ++it)
+        PR_PROFILE_FUNCTION();
+
+        for (const std::shared_ptr<Renderable>& renderable : m_aRenderables)
+        {
+            renderable->Update(deltaTime);
+        }
+
+        updateTransforms();
+
+        if (m_bIsMeshLayoutDirty)
+        {
+            rebuildMeshBounds();
+            return;
+        }
+
+        BOOL bHasMoved = FALSE;
+        for (UINT i = 0u; i < m_aRenderables.size(); ++i)
+        {
+            if (m_Transforms.IsChanged(m_auTransformNodes[i]))
+            {
+                refreshRenderable(i);
+                bHasMoved = TRUE;
+            }
+        }
+
+        if (bHasMoved)
         {
-            it->second->Update(deltaTime);
+            m_Bvh.Refit(m_aMeshBounds.data(), JobSystem::GetInstance());
         }
     }
 
-    std::unordered_map<std::wstring, std::shared_ptr<Renderable>>& Scene::GetRenderables() noexcept
+    UINT Scene::GetNumRenderables() const noexcept
+    {
+        return static_cast<UINT>(m_aRenderables.size());
+    }
+
+    const std::vector<std::shared_ptr<Renderable>>& Scene::GetRenderables() const noexcept
+    {
+        return m_aRenderables;
+    }
+
+    const XMFLOAT4X4* Scene::GetWorldMatrices() const noexcept
+    {
+        return m_aWorldMatrices.data();
+    }
+
+    const UINT* Scene::GetFlags() const noexcept
+    {
+        return m_auFlags.data();
+    }
+
+    const UINT* Scene::GetFirstMeshes() const noexcept
+    {
+        return m_auFirstMeshes.data();
+    }
+
+    UINT Scene::GetNumMeshes() const noexcept
+    {
+        return static_cast<UINT>(m_aMeshBounds.size());
+    }
+
+    const MeshBounds* Scene::GetMeshBounds() const noexcept
+    {
+        return m_aMeshBounds.data();
+    }
+
+    const TransformHierarchy& Scene::GetTransformHierarchy() const noexcept
+    {
+        return m_Transforms;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetMeshRenderable
+
+      Summary:  Finds the renderable a mesh of the mesh bounds, and so
+                an item of the bounding volume hierarchy, belongs to
+
+      Args:     UINT uMesh
+                  Index into the mesh bounds
+
+      Returns:  RenderableHandle
+                  Handle of the renderable.
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    RenderableHandle Scene::GetMeshRenderable(_In_ UINT uMesh) const noexcept
+    {
+        assert(uMesh < m_aMeshBounds.size());
+
+        // Renderables without meshes start where the next one does, so the last one starting at or before the mesh owns it
+        UINT uDenseIndex = static_cast<UINT>(std::upper_bound(m_auFirstMeshes.begin(), m_auFirstMeshes.end(), uMesh) - m_auFirstMeshes.begin()) - 1u;
+        UINT uSlot = m_auSlots[uDenseIndex];
+
+        return RenderableHandle{ .uIndex = uSlot, .uGeneration = m_aSlots[uSlot].uGeneration };
+    }
+
+    const SceneStreamer* Scene::GetStreamer() const noexcept
+    {
+        return m_pStreamer.get();
+    }
+
+    const BoundingVolumeHierarchy& Scene::GetBoundingVolumeHierarchy() const noexcept
+    {
+        return m_Bvh;
+    }
+
+    const std::vector<std::shared_ptr<Material>>& Scene::GetMaterials() const noexcept
     {
-        return m_renderables;
+        return m_aMaterials;
     }
 
-    const std::unordered_map<std::wstring, std::shared_ptr<Renderable>>& Scene::GetRenderables() const noexcept
+    const std::vector<LightData>& Scene::GetLights() const noexcept
     {
-        return m_renderables;
+        return m_aLights;
     }
 
-    std::unordered_map<std::wstring, std::shared_ptr<Material>>& Scene::GetMaterials()
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::updateTransforms
+
+      Summary:  Copies the local transforms the renderables changed
+                into the hierarchy and recomputes the dirty subtrees
+
+      Modifies: [m_auFlags, m_auTransformVersions, m_Transforms].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Scene::updateTransforms()
     {
-        return m_materials;
+        for (UINT i = 0u; i < m_aRenderables.size(); ++i)
+        {
+            const Renderable* pRenderable = m_aRenderables[i].get();
+            m_auFlags[i] = pRenderable->IsOccluder() ? RENDERABLE_FLAG_OCCLUDER : 0u;
+
+            if (pRenderable->GetTransformVersion() != m_auTransformVersions[i])
+            {
+                m_Transforms.SetLocalTransform(m_auTransformNodes[i], pRenderable->GetLocalTransform());
+                m_auTransformVersions[i] = pRenderable->GetTransformVersion();
+            }
+        }
+
+        m_Transforms.Update(JobSystem::GetInstance());
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::refreshRenderable
+
+      Summary:  Takes the world matrix of a renderable from the
+                hierarchy and transforms its mesh bounds
+
+      Args:     UINT uDenseIndex
+                  Dense index of the renderable
+
+      Modifies: [m_aWorldMatrices, m_aMeshBounds].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Scene::refreshRenderable(_In_ UINT uDenseIndex)
+    {
+        Renderable* pRenderable = m_aRenderables[uDenseIndex].get();
+        const XMFLOAT4X4& world = m_Transforms.GetWorldMatrix(m_auTransformNodes[uDenseIndex]);
+        pRenderable->SetWorldMatrix(XMLoadFloat4x4(&world));
+
+        m_aWorldMatrices[uDenseIndex] = world;
+        for (UINT i = 0u; i < pRenderable->GetNumMeshes(); ++i)
+        {
+            m_aMeshBounds[m_auFirstMeshes[uDenseIndex] + i] = TransformMeshBounds(pRenderable->GetMesh(i).Bounds, world);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::rebuildMeshBounds
+
+      Summary:  Lays out the mesh bounds of the renderables back to
+                back in dense order, fills all of them and builds the
+                bounding volume hierarchy over them
+
+      Modifies: [m_auFirstMeshes, m_aMeshBounds, m_aWorldMatrices,
+                 m_Bvh, m_bIsMeshLayoutDirty].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Scene::rebuildMeshBounds()
+    {
+        UINT uNumMeshes = 0u;
+        for (UINT i = 0u; i < m_aRenderables.size(); ++i)
+        {
+            m_auFirstMeshes[i] = uNumMeshes;
+            uNumMeshes += m_aRenderables[i]->GetNumMeshes();
+        }
+
+        m_aMeshBounds.resize(uNumMeshes);
+        for (UINT i = 0u; i < m_aRenderables.size(); ++i)
+        {
+            refreshRenderable(i);
+        }
+
+        m_Bvh.Build(m_aMeshBounds.data(), uNumMeshes, JobSystem::GetInstance());
+
+        m_bIsMeshLayoutDirty = FALSE;
     }
-}
\ No newline at end of file
+}
@@ -17,34 +17,177 @@
 
 //#include "Model/Model.h"
 //#include "Light/PointLight.h"
+#include "Graphics/Bounds.h"
+#include "Graphics/DataTypes.h"
 #include "Graphics/Renderable.h"
+#include "Scene/BoundingVolumeHierarchy.h"
+#include "Scene/StreamingPolicy.h"
+#include "Scene/TransformHierarchy.h"
 #include "Texture/Material.h"
 
 namespace pr
 {
+    class SceneStreamer;
+
+    // Refers to a renderable of a scene, stale once the renderable is removed
+    struct RenderableHandle
+    {
+        UINT uIndex;
+        UINT uGeneration;
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    Scene
+
+      Summary:  Renderables, materials and lights of a scene. The
+                renderables are kept as dense component arrays, one
+                entry per renderable in the same order, so a frame
+                walks contiguous memory. Handles stay valid while
+                other renderables are added and removed, names are
+                an optional side index
+
+      Methods:  Initialize
+                  Initializes the renderables and the materials
+                AddRenderable
+                  Adds a renderable and returns its handle
+                RemoveRenderable
+                  Removes a renderable, its handle becomes stale
+                FindRenderable
+                  Returns the handle of a named renderable
+                GetRenderable
+                  Returns the renderable of a handle
+                SetParent
+                  Attaches a renderable to another one, its local
+                  transform becomes relative to the parent
+                AddMaterial
+                  Adds a uniquely named material
+                AddLight
+                  Adds a point or spot light
+                LoadFile
+                  Adds the renderables, materials and lights of a
+                  cooked scene file
+                SaveFile
+                  Cooks the initialized scene into a scene file
+                EnableStreaming
+                  Streams the streamable renderables around the
+                  camera instead of initializing all of them
+                UpdateStreaming
+                  Releases the cells the streaming policy evicts and
+                  uploads the cells loaded in the background
+                Update
+                  Updates the renderables, recomputes the world
+                  matrices of the moved subtrees and their bounds and
+                  refits the bounding volume hierarchy
+                GetNumRenderables
+                  Returns the number of renderables
+                GetRenderables
+                  Returns the dense array of renderables
+                GetWorldMatrices
+                  Returns the world matrix of each renderable
+                GetFlags
+                  Returns the flags of each renderable
+                GetFirstMeshes
+                  Returns where the meshes of each renderable start
+                  in the mesh bounds
+                GetNumMeshes
+                  Returns the number of meshes of all renderables
+                GetMeshBounds
+                  Returns the world bounds of every mesh
+                GetMeshRenderable
+                  Returns the handle of the renderable owning a mesh
+                GetBoundingVolumeHierarchy
+                  Returns the hierarchy over the mesh bounds for
+                  frustum, sphere, box and ray queries
+                GetTransformHierarchy
+                  Returns the transforms of the renderables
+                GetStreamer
+                  Returns the streamer, nullptr unless streaming
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
     class Scene
     {
     public:
-        explicit Scene() noexcept = default;
+        static constexpr const UINT RENDERABLE_FLAG_OCCLUDER = 1u << 0u;
+
+    public:
+        explicit Scene() noexcept;
         Scene(const Scene& other) = delete;
         Scene(Scene&& other) = delete;
         Scene& operator=(const Scene& other) = delete;
         Scene& operator=(Scene&& other) = delete;
-        virtual ~Scene() = default;
+        virtual ~Scene();
 
         virtual HRESULT Initialize(_In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList);
 
-        HRESULT AddRenderable(_In_ PCWSTR pszRenderableName, _In_ const std::shared_ptr<Renderable>& renderable);
+        HRESULT AddRenderable(_In_ PCWSTR pszRenderableName, _In_ const std::shared_ptr<Renderable>& renderable, _Out_opt_ RenderableHandle* pOutHandle = nullptr);
+        RenderableHandle AddRenderable(_In_ const std::shared_ptr<Renderable>& renderable);
+        HRESULT RemoveRenderable(_In_ RenderableHandle handle);
+        RenderableHandle FindRenderable(_In_ PCWSTR pszRenderableName) const;
+        Renderable* GetRenderable(_In_ RenderableHandle handle) const noexcept;
+        HRESULT SetParent(_In_ RenderableHandle child, _In_ RenderableHandle parent);
         HRESULT AddMaterial(_In_ const std::shared_ptr<Material>& material);
+        void AddLight(_In_ const LightData& light);
+        HRESULT LoadFile(_In_ const std::filesystem::path& filePath);
+        HRESULT SaveFile(_In_ const std::filesystem::path& filePath) const;
+        void EnableStreaming(_In_ const StreamingPolicy::Settings& settings);
+        HRESULT UpdateStreaming(_In_ const StreamingPolicy::View& view, _In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList);
 
         void Update(_In_ FLOAT deltaTime);
 
-        std::unordered_map<std::wstring, std::shared_ptr<Renderable>>& GetRenderables() noexcept;
-        const std::unordered_map<std::wstring, std::shared_ptr<Renderable>>& GetRenderables() const noexcept;
-        std::unordered_map<std::wstring, std::shared_ptr<Material>>& GetMaterials();
+        UINT GetNumRenderables() const noexcept;
+        const std::vector<std::shared_ptr<Renderable>>& GetRenderables() const noexcept;
+        const XMFLOAT4X4* GetWorldMatrices() const noexcept;
+        const UINT* GetFlags() const noexcept;
+        const UINT* GetFirstMeshes() const noexcept;
+        UINT GetNumMeshes() const noexcept;
+        const MeshBounds* GetMeshBounds() const noexcept;
+        RenderableHandle GetMeshRenderable(_In_ UINT uMesh) const noexcept;
+        const BoundingVolumeHierarchy& GetBoundingVolumeHierarchy() const noexcept;
+        const TransformHierarchy& GetTransformHierarchy() const noexcept;
+        const SceneStreamer* GetStreamer() const noexcept;
+        const std::vector<std::shared_ptr<Material>>& GetMaterials() const noexcept;
+        const std::vector<LightData>& GetLights() const noexcept;
+
+    private:
+        struct Slot
+        {
+            UINT uDenseIndex;
+            UINT uGeneration;
+        };
+
+    private:
+        void updateTransforms();
+        void refreshRenderable(_In_ UINT uDenseIndex);
+        void rebuildMeshBounds();
 
     private:
-        std::unordered_map<std::wstring, std::shared_ptr<Renderable>> m_renderables;
-        std::unordered_map<std::wstring, std::shared_ptr<Material>> m_materials;
+        // Components, indexed by dense index
+        std::vector<std::shared_ptr<Renderable>> m_aRenderables;
+        std::vector<XMFLOAT4X4> m_aWorldMatrices;
+        std::vector<UINT> m_auFlags;
+        std::vector<UINT> m_auFirstMeshes;
+        std::vector<UINT> m_auTransformNodes;
+        std::vector<UINT> m_auTransformVersions;
+        std::vector<UINT> m_auSlots;
+
+        // World bounds of every mesh, the meshes of a renderable are contiguous
+        std::vector<MeshBounds> m_aMeshBounds;
+
+        // Handle indices refer to slots, freed slots are reused with the next generation
+        std::vector<Slot> m_aSlots;
+        std::vector<UINT> m_auFreeSlots;
+
+        TransformHierarchy m_Transforms;
+        BoundingVolumeHierarchy m_Bvh;
+
+        std::unordered_map<std::wstring, RenderableHandle> m_renderableNames;
+        std::vector<std::shared_ptr<Material>> m_aMaterials;
+        std::unordered_map<std::wstring, UINT> m_materialNames;
+        std::vector<LightData> m_aLights;
+
+        // Created by EnableStreaming, the settings are kept until Initialize builds the cells
+        std::unique_ptr<SceneStreamer> m_pStreamer;
+        StreamingPolicy::Settings m_StreamingSettings;
+
+        BOOL m_bIsMeshLayoutDirty;
     };
-}
\ No newline at end of file
+}
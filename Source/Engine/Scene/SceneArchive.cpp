@@ -0,0 +1,53 @@
+#include "pch.h"
+
+#include "Scene/SceneArchive.h"
+
+#include "Utility/Profiler.h"
+#include "Utility/Utility.h"
+
+namespace pr
+{
+	SceneArchive::SceneArchive() noexcept
+		: m_File()
+		, m_View()
+		, m_directory()
+	{
+	}
+
+	HRESULT SceneArchive::Initialize(_In_ const std::filesystem::path& filePath)
+	{
+		PR_PROFILE_FUNCTION();
+
+		HRESULT hr = S_OK;
+
+		m_View = {};
+
+		// The geometry is read front to back once while its upload is recorded
+		hr = m_File.Initialize(filePath, TRUE);
+		if (FAILED(hr))
+		{
+			return hr;
+		}
+
+		hr = SceneFile::Read(m_View, m_File.GetData(), m_File.GetSize());
+		if (FAILED(hr))
+		{
+			m_File.Release();
+			CHECK_AND_RETURN_HRESULT(hr, L"SceneArchive::Initialize >> Validating scene file");
+		}
+
+		m_directory = filePath.parent_path();
+
+		return S_OK;
+	}
+
+	const SceneFile::View& SceneArchive::GetView() const noexcept
+	{
+		return m_View;
+	}
+
+	const std::filesystem::path& SceneArchive::GetDirectory() const noexcept
+	{
+		return m_directory;
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Scene/SceneFile.h"
+#include "Utility/MappedFile.h"
+
+namespace pr
+{
+	// Read only view of a cooked scene file. The file is mapped once and validated, the records and the geometry
+	// handed out point straight into the mapping, so they stay valid for the lifetime of the archive.
+	class SceneArchive final
+	{
+	public:
+		explicit SceneArchive() noexcept;
+		SceneArchive(const SceneArchive& other) = delete;
+		SceneArchive(SceneArchive&& other) = delete;
+		SceneArchive& operator=(const SceneArchive& other) = delete;
+		SceneArchive& operator=(SceneArchive&& other) = delete;
+		~SceneArchive() noexcept = default;
+
+		HRESULT Initialize(_In_ const std::filesystem::path& filePath);
+
+		const SceneFile::View& GetView() const noexcept;
+		// Texture paths of the file are relative to this directory
+		const std::filesystem::path& GetDirectory() const noexcept;
+
+	private:
+		MappedFile m_File;
+		SceneFile::View m_View;
+		std::filesystem::path m_directory;
+	};
+}
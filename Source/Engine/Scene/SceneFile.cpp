@@ -0,0 +1,279 @@
+#include "pch.h"
+
+#include "Scene/SceneFile.h"
+
+#include "Utility/Math.h"
+
+namespace pr
+{
+	namespace SceneFile
+	{
+		namespace
+		{
+			constexpr const size_t NUM_SECTIONS = static_cast<size_t>(eSection::COUNT);
+
+			BOOL isString(_In_ const View& view, _In_ UINT uString) noexcept
+			{
+				return uString == INVALID_INDEX || uString < view.uStringsSize;
+			}
+
+			BOOL isRange(_In_ UINT uFirst, _In_ UINT uCount, _In_ UINT uSize) noexcept
+			{
+				return uFirst <= uSize && uCount <= uSize - uFirst;
+			}
+
+			BOOL isDataRange(_In_ const View& view, _In_ UINT64 uOffset, _In_ UINT64 uSize, _In_ UINT64 uAlignment) noexcept
+			{
+				return uOffset % uAlignment == 0u && uOffset <= view.uDataSize && uSize <= view.uDataSize - uOffset;
+			}
+
+			// Every offset and index of the view is in bounds, so the records can be followed without further checks
+			HRESULT validate(_In_ const View& view) noexcept
+			{
+				// Any offset into the strings then ends at a terminator
+				if (view.uStringsSize > 0u && view.pStrings[view.uStringsSize - 1u] != '\0')
+				{
+					return E_FAIL;
+				}
+
+				for (UINT i = 0u; i < view.uNumGeometries; ++i)
+				{
+					const Geometry& geometry = view.aGeometries[i];
+					if (geometry.uVertexType >= static_cast<UINT>(eVertexType::COUNT)
+						|| !isDataRange(view, geometry.uVertices, static_cast<UINT64>(geometry.uNumVertices) * VERTEX_SIZE[geometry.uVertexType], sizeof(FLOAT))
+						|| !isDataRange(view, geometry.uIndices, static_cast<UINT64>(geometry.uNumIndices) * sizeof(WORD), sizeof(WORD))
+						|| !isRange(geometry.uFirstMesh, geometry.uNumMeshes, view.uNumMeshes))
+					{
+						return E_FAIL;
+					}
+
+					for (UINT j = 0u; j < geometry.uNumMeshes; ++j)
+					{
+						const Mesh& mesh = view.aMeshes[geometry.uFirstMesh + j];
+						if (mesh.uBaseVertex > geometry.uNumVertices
+							|| !isRange(mesh.uBaseIndex, mesh.uNumIndices, geometry.uNumIndices)
+							|| mesh.uNumLods == 0u
+							|| mesh.uNumLods > MAX_LODS)
+						{
+							return E_FAIL;
+						}
+
+						for (UINT uLod = 1u; uLod < mesh.uNumLods; ++uLod)
+						{
+							if (!isRange(mesh.aLods[uLod - 1u].uBaseIndex, mesh.aLods[uLod - 1u].uNumIndices, geometry.uNumIndices))
+							{
+								return E_FAIL;
+							}
+						}
+					}
+				}
+
+				for (UINT i = 0u; i < view.uNumRenderables; ++i)
+				{
+					const Renderable& renderable = view.aRenderables[i];
+					if (!isString(view, renderable.uName)
+						|| (renderable.uParent != INVALID_INDEX && renderable.uParent >= view.uNumRenderables)
+						|| renderable.uRenderPass >= static_cast<UINT>(eRenderPass::COUNT)
+						|| renderable.uGeometry >= view.uNumGeometries
+						|| !isRange(renderable.uFirstBinding, renderable.uNumBindings, view.uNumMaterialBindings))
+					{
+						return E_FAIL;
+					}
+
+					// Geometries are checked, so their meshes are in bounds
+					const Geometry& geometry = view.aGeometries[renderable.uGeometry];
+					for (UINT j = 0u; j < geometry.uNumMeshes; ++j)
+					{
+						const UINT uMaterialIndex = view.aMeshes[geometry.uFirstMesh + j].uMaterialIndex;
+						if (uMaterialIndex != INVALID_INDEX && uMaterialIndex >= renderable.uNumBindings)
+						{
+							return E_FAIL;
+						}
+					}
+				}
+
+				for (UINT i = 0u; i < view.uNumMaterialBindings; ++i)
+				{
+					if (view.auMaterialBindings[i] >= view.uNumMaterials)
+					{
+						return E_FAIL;
+					}
+				}
+
+				for (UINT i = 0u; i < view.uNumMaterials; ++i)
+				{
+					const Material& material = view.aMaterials[i];
+					for (UINT uTexture : { material.uDiffuse, material.uSpecularExponent, material.uNormal })
+					{
+						if (uTexture != INVALID_INDEX && uTexture >= view.uNumTextures)
+						{
+							return E_FAIL;
+						}
+					}
+
+					if (!isString(view, material.uName))
+					{
+						return E_FAIL;
+					}
+				}
+
+				for (UINT i = 0u; i < view.uNumTextures; ++i)
+				{
+					if (view.aTextures[i].uPath == INVALID_INDEX || !isString(view, view.aTextures[i].uPath))
+					{
+						return E_FAIL;
+					}
+				}
+
+				return S_OK;
+			}
+		}
+
+		HRESULT Write(_Out_ std::vector<BYTE>& aOutData, _In_ const View& view)
+		{
+			aOutData.clear();
+
+			if (FAILED(validate(view)))
+			{
+				return E_INVALIDARG;
+			}
+
+			const std::pair<const void*, UINT64> aSections[NUM_SECTIONS] =
+			{
+				{ view.aRenderables, sizeof(Renderable) * static_cast<UINT64>(view.uNumRenderables) },
+				{ view.aGeometries, sizeof(Geometry) * static_cast<UINT64>(view.uNumGeometries) },
+				{ view.aMeshes, sizeof(Mesh) * static_cast<UINT64>(view.uNumMeshes) },
+				{ view.auMaterialBindings, sizeof(UINT) * static_cast<UINT64>(view.uNumMaterialBindings) },
+				{ view.aMaterials, sizeof(Material) * static_cast<UINT64>(view.uNumMaterials) },
+				{ view.aTextures, sizeof(Texture) * static_cast<UINT64>(view.uNumTextures) },
+				{ view.aLights, sizeof(LightData) * static_cast<UINT64>(view.uNumLights) },
+				{ view.pStrings, view.uStringsSize },
+				{ view.pData, view.uDataSize },
+			};
+
+			Header header =
+			{
+				.uMagic = MAGIC,
+				.uVersion = VERSION,
+				.uFileSize = 0u,
+				.aSections = {},
+			};
+
+			size_t uOffset = sizeof(Header);
+			for (size_t i = 0; i < NUM_SECTIONS; ++i)
+			{
+				uOffset = AlignUp(uOffset, SECTION_ALIGNMENT);
+				header.aSections[i] = Section{ .uOffset = uOffset, .uSize = aSections[i].second };
+				uOffset += static_cast<size_t>(aSections[i].second);
+			}
+			header.uFileSize = uOffset;
+
+			aOutData.assign(uOffset, 0u);
+			memcpy(aOutData.data(), &header, sizeof(Header));
+			for (size_t i = 0; i < NUM_SECTIONS; ++i)
+			{
+				if (aSections[i].second > 0u)
+				{
+					memcpy(aOutData.data() + header.aSections[i].uOffset, aSections[i].first, static_cast<size_t>(aSections[i].second));
+				}
+			}
+
+			return S_OK;
+		}
+
+		HRESULT Read(_Out_ View& outView, _In_reads_bytes_(uSize) const BYTE* pData, _In_ size_t uSize)
+		{
+			outView = {};
+
+			Header header;
+			if (!pData || uSize < sizeof(Header))
+			{
+				return E_FAIL;
+			}
+			memcpy(&header, pData, sizeof(Header));
+
+			if (header.uMagic != MAGIC || header.uVersion != VERSION || header.uFileSize != uSize)
+			{
+				return E_FAIL;
+			}
+
+			// The records are read in place, so the sections have to be aligned within the file
+			constexpr const size_t RECORD_SIZES[NUM_SECTIONS] =
+			{
+				sizeof(Renderable),
+				sizeof(Geometry),
+				sizeof(Mesh),
+				sizeof(UINT),
+				sizeof(Material),
+				sizeof(Texture),
+				sizeof(LightData),
+				1u,
+				1u,
+			};
+			for (size_t i = 0; i < NUM_SECTIONS; ++i)
+			{
+				const Section& section = header.aSections[i];
+				if (section.uOffset < sizeof(Header)
+					|| section.uOffset % SECTION_ALIGNMENT != 0u
+					|| section.uOffset > uSize
+					|| section.uSize > uSize - section.uOffset
+					|| section.uSize % RECORD_SIZES[i] != 0u
+					|| (i != static_cast<size_t>(eSection::DATA) && section.uSize / RECORD_SIZES[i] > UINT_MAX))
+				{
+					return E_FAIL;
+				}
+			}
+
+			auto getSection = [&header, pData](eSection section)
+			{
+				return pData + header.aSections[static_cast<size_t>(section)].uOffset;
+			};
+			auto getCount = [&header](eSection section, size_t uRecordSize)
+			{
+				return static_cast<UINT>(header.aSections[static_cast<size_t>(section)].uSize / uRecordSize);
+			};
+
+			View view =
+			{
+				.aRenderables = reinterpret_cast<const Renderable*>(getSection(eSection::RENDERABLES)),
+				.uNumRenderables = getCount(eSection::RENDERABLES, sizeof(Renderable)),
+				.aGeometries = reinterpret_cast<const Geometry*>(getSection(eSection::GEOMETRIES)),
+				.uNumGeometries = getCount(eSection::GEOMETRIES, sizeof(Geometry)),
+				.aMeshes = reinterpret_cast<const Mesh*>(getSection(eSection::MESHES)),
+				.uNumMeshes = getCount(eSection::MESHES, sizeof(Mesh)),
+				.auMaterialBindings = reinterpret_cast<const UINT*>(getSection(eSection::MATERIAL_BINDINGS)),
+				.uNumMaterialBindings = getCount(eSection::MATERIAL_BINDINGS, sizeof(UINT)),
+				.aMaterials = reinterpret_cast<const Material*>(getSection(eSection::MATERIALS)),
+				.uNumMaterials = getCount(eSection::MATERIALS, sizeof(Material)),
+				.aTextures = reinterpret_cast<const Texture*>(getSection(eSection::TEXTURES)),
+				.uNumTextures = getCount(eSection::TEXTURES, sizeof(Texture)),
+				.aLights = reinterpret_cast<const LightData*>(getSection(eSection::LIGHTS)),
+				.uNumLights = getCount(eSection::LIGHTS, sizeof(LightData)),
+				.pStrings = reinterpret_cast<const CHAR*>(getSection(eSection::STRINGS)),
+				.uStringsSize = getCount(eSection::STRINGS, 1u),
+				.pData = getSection(eSection::DATA),
+				.uDataSize = header.aSections[static_cast<size_t>(eSection::DATA)].uSize,
+			};
+
+			HRESULT hr = validate(view);
+			if (FAILED(hr))
+			{
+				return hr;
+			}
+
+			outView = view;
+
+			return S_OK;
+		}
+
+		PCSTR GetString(_In_ const View& view, _In_ UINT uString) noexcept
+		{
+			if (uString == INVALID_INDEX)
+			{
+				return "";
+			}
+
+			return view.pStrings + uString;
+		}
+	}
+}
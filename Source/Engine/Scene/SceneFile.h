@@ -0,0 +1,153 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/Bounds.h"
+#include "Graphics/DataTypes.h"
+
+namespace pr
+{
+	// On disk layout of a cooked scene, all values little endian:
+	//   Header, then the sections of Header::aSections each aligned to SECTION_ALIGNMENT
+	// Records refer to each other by index and to strings and geometry by offsets into the string and data
+	// sections, so the file is used in place from a mapped view and can be moved freely. Strings are null
+	// terminated UTF-8, texture paths are relative to the directory of the scene file. Read checks every offset
+	// and index once, but neither the vertex indices nor a checksum, which would touch every page at startup.
+	namespace SceneFile
+	{
+		constexpr const UINT MAGIC = 0x43535250;	// "PRSC"
+		constexpr const UINT VERSION = 2u;
+		constexpr const UINT SECTION_ALIGNMENT = 16u;
+		constexpr const UINT INVALID_INDEX = 0xFFFFFFFFu;
+		constexpr const UINT MAX_LODS = 4u;
+
+		enum class eSection : UINT
+		{
+			RENDERABLES,
+			GEOMETRIES,
+			MESHES,
+			MATERIAL_BINDINGS,
+			MATERIALS,
+			TEXTURES,
+			LIGHTS,
+			STRINGS,
+			DATA,
+			COUNT,
+		};
+
+		struct Section
+		{
+			UINT64 uOffset;
+			UINT64 uSize;
+		};
+		static_assert(sizeof(Section) == 16);
+
+		struct Header
+		{
+			UINT uMagic;
+			UINT uVersion;
+			UINT64 uFileSize;
+			Section aSections[static_cast<size_t>(eSection::COUNT)];
+		};
+		static_assert(sizeof(Header) == 160);
+
+		// Parents are renderable indices, the materials of a renderable are aMaterialBindings[uFirstBinding, + uNumBindings)
+		struct Renderable
+		{
+			Transform Local;
+			UINT uName;
+			UINT uParent;
+			UINT uFlags;
+			UINT uRenderPass;
+			UINT uGeometry;
+			UINT uFirstBinding;
+			UINT uNumBindings;
+			UINT uReserved;
+		};
+		static_assert(sizeof(Renderable) == 72);
+
+		// Vertices and indices are offsets into the data section, renderables with the same geometry share it.
+		// Decode maps the positions of packed vertex types to object space.
+		struct Geometry
+		{
+			UINT64 uVertices;
+			UINT64 uIndices;
+			UINT uNumVertices;
+			UINT uNumIndices;
+			UINT uVertexType;
+			UINT uFirstMesh;
+			UINT uNumMeshes;
+			UINT uReserved;
+			PositionDecode Decode;
+		};
+		static_assert(sizeof(Geometry) == 56);
+
+		struct MeshLod
+		{
+			UINT uNumIndices;
+			UINT uBaseIndex;
+			FLOAT Error;
+		};
+
+		// Index ranges relative to the geometry, material indices refer to the bindings of the renderable
+		struct Mesh
+		{
+			UINT uNumIndices;
+			UINT uBaseVertex;
+			UINT uBaseIndex;
+			UINT uMaterialIndex;
+			MeshBounds Bounds;
+			UINT uNumLods;
+			MeshLod aLods[MAX_LODS - 1u];
+		};
+		static_assert(sizeof(Mesh) == 84);
+
+		// Textures are indices into the texture section, INVALID_INDEX for none
+		struct Material
+		{
+			UINT uName;
+			UINT uDiffuse;
+			UINT uSpecularExponent;
+			UINT uNormal;
+		};
+		static_assert(sizeof(Material) == 16);
+
+		struct Texture
+		{
+			UINT uPath;
+		};
+		static_assert(sizeof(Texture) == 4);
+
+		// Sections in memory, either to be written or pointing into a file that passed Read
+		struct View
+		{
+			const Renderable* aRenderables;
+			UINT uNumRenderables;
+			const Geometry* aGeometries;
+			UINT uNumGeometries;
+			const Mesh* aMeshes;
+			UINT uNumMeshes;
+			const UINT* auMaterialBindings;
+			UINT uNumMaterialBindings;
+			const Material* aMaterials;
+			UINT uNumMaterials;
+			const Texture* aTextures;
+			UINT uNumTextures;
+			const LightData* aLights;
+			UINT uNumLights;
+			const CHAR* pStrings;
+			UINT uStringsSize;
+			const BYTE* pData;
+			UINT64 uDataSize;
+		};
+
+		// Fails with E_INVALIDARG on views that would not pass Read
+		HRESULT Write(_Out_ std::vector<BYTE>& aOutData, _In_ const View& view);
+
+		// Checks the header, the sections and every offset and index, the view points into pData
+		HRESULT Read(_Out_ View& outView, _In_reads_bytes_(uSize) const BYTE* pData, _In_ size_t uSize);
+
+		// uString must be a string offset of a view returned by Read, INVALID_INDEX gives an empty string
+		PCSTR GetString(_In_ const View& view, _In_ UINT uString) noexcept;
+	}
+}
@@ -0,0 +1,296 @@
+#include "pch.h"
+
+#include "Scene/SceneStreamer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <thread>
+
+#include "Graphics/Renderable.h"
+#include "Texture/Material.h"
+#include "Utility/JobSystem.h"
+#include "Utility/Profiler.h"
+#include "Utility/Utility.h"
+
+namespace pr
+{
+	namespace
+	{
+		// 21 bits per axis, cells of the same key wrap around far beyond any scene
+		UINT64 getCellKey(_In_ const XMFLOAT3& point) noexcept
+		{
+			constexpr const UINT64 MASK = (1ull << 21u) - 1ull;
+
+			UINT64 uX = static_cast<UINT64>(static_cast<INT64>(floorf(point.x / SceneStreamer::CELL_SIZE))) & MASK;
+			UINT64 uY = static_cast<UINT64>(static_cast<INT64>(floorf(point.y / SceneStreamer::CELL_SIZE))) & MASK;
+			UINT64 uZ = static_cast<UINT64>(static_cast<INT64>(floorf(point.z / SceneStreamer::CELL_SIZE))) & MASK;
+
+			return (uX << 42u) | (uY << 21u) | uZ;
+		}
+
+		void mergeBox(_Inout_ Box& box, _In_ const Box& other) noexcept
+		{
+			box.Min = XMFLOAT3(std::min(box.Min.x, other.Min.x), std::min(box.Min.y, other.Min.y), std::min(box.Min.z, other.Min.z));
+			box.Max = XMFLOAT3(std::max(box.Max.x, other.Max.x), std::max(box.Max.y, other.Max.y), std::max(box.Max.z, other.Max.z));
+		}
+	}
+
+	SceneStreamer::SceneStreamer() noexcept
+		: m_Policy()
+		, m_Decisions()
+		, m_aCellContents()
+		, m_textureReferences()
+		, m_CompletionMutex()
+		, m_aCompletions()
+		, m_aFinished()
+		, m_uNumPending(0u)
+	{
+	}
+
+	SceneStreamer::~SceneStreamer() noexcept
+	{
+		// Background loads reference the cells
+		while (m_uNumPending.load(std::memory_order_acquire) > 0u)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	void SceneStreamer::Initialize(
+		_In_ const std::vector<std::shared_ptr<Renderable>>& aRenderables,
+		_In_reads_(aRenderables.size()) const UINT* auFirstMeshes,
+		_In_ const MeshBounds* aMeshBounds,
+		_In_ const StreamingPolicy::Settings& settings
+	)
+	{
+		PR_PROFILE_FUNCTION();
+
+		std::vector<StreamingPolicy::Cell> aCells;
+		std::unordered_map<UINT64, UINT> cellIndices;
+		m_aCellContents.clear();
+		m_textureReferences.clear();
+
+		for (size_t i = 0; i < aRenderables.size(); ++i)
+		{
+			const std::shared_ptr<Renderable>& renderable = aRenderables[i];
+			if (!renderable->IsStreamable() || renderable->GetNumMeshes() == 0u)
+			{
+				continue;
+			}
+
+			Box bounds =
+			{
+				.Min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX),
+				.Max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX),
+			};
+			for (UINT uMesh = 0u; uMesh < renderable->GetNumMeshes(); ++uMesh)
+			{
+				const MeshBounds& meshBounds = aMeshBounds[auFirstMeshes[i] + uMesh];
+				mergeBox(
+					bounds,
+					Box
+					{
+						.Min = XMFLOAT3(meshBounds.Center.x - meshBounds.Extents.x, meshBounds.Center.y - meshBounds.Extents.y, meshBounds.Center.z - meshBounds.Extents.z),
+						.Max = XMFLOAT3(meshBounds.Center.x + meshBounds.Extents.x, meshBounds.Center.y + meshBounds.Extents.y, meshBounds.Center.z + meshBounds.Extents.z),
+					}
+				);
+			}
+
+			XMFLOAT3 center(0.5f * (bounds.Min.x + bounds.Max.x), 0.5f * (bounds.Min.y + bounds.Max.y), 0.5f * (bounds.Min.z + bounds.Max.z));
+			auto [it, bIsNew] = cellIndices.try_emplace(getCellKey(center), static_cast<UINT>(aCells.size()));
+			if (bIsNew)
+			{
+				aCells.push_back(StreamingPolicy::Cell{ .Bounds = bounds, .uCpuSize = 0u, .uGpuSize = 0u });
+				m_aCellContents.emplace_back();
+			}
+
+			// A renderable spilling out of its cell grows the cell, so the distances stay conservative
+			mergeBox(aCells[it->second].Bounds, bounds);
+
+			CellContents& contents = m_aCellContents[it->second];
+			contents.apRenderables.push_back(renderable);
+			for (UINT uMaterial = 0u; uMaterial < renderable->GetNumMaterials(); ++uMaterial)
+			{
+				const std::shared_ptr<Material>& material = renderable->GetMaterial(uMaterial);
+				for (const std::shared_ptr<Texture>& pTexture : { material->pDiffuse, material->pSpecularExponent, material->pNormal })
+				{
+					if (pTexture && std::find(contents.apTextures.begin(), contents.apTextures.end(), pTexture) == contents.apTextures.end())
+					{
+						contents.apTextures.push_back(pTexture);
+						m_textureReferences.try_emplace(pTexture.get(), 0u);
+					}
+				}
+			}
+		}
+
+		// Until a cell loads, its textures are estimated by their file sizes
+		for (UINT i = 0u; i < aCells.size(); ++i)
+		{
+			measure(i, aCells[i].uCpuSize, aCells[i].uGpuSize);
+		}
+
+		m_Policy.Initialize(aCells.data(), static_cast<UINT>(aCells.size()), settings);
+	}
+
+	void SceneStreamer::SetSettings(_In_ const StreamingPolicy::Settings& settings) noexcept
+	{
+		m_Policy.SetSettings(settings);
+	}
+
+	HRESULT SceneStreamer::Update(_In_ const StreamingPolicy::View& view, _In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList)
+	{
+		PR_PROFILE_FUNCTION();
+
+		HRESULT hr = S_OK;
+
+		{
+			std::lock_guard<std::mutex> lock(m_CompletionMutex);
+			m_aFinished.swap(m_aCompletions);
+		}
+
+		// Cells whose files could not be read are not requested again, only device failures fail the frame
+		for (const Completion& completion : m_aFinished)
+		{
+			HRESULT hrCell = completion.hr;
+			if (SUCCEEDED(hrCell))
+			{
+				hrCell = initialize(completion.uCell, pDevice, pCommandList);
+				if (FAILED(hrCell) && SUCCEEDED(hr))
+				{
+					hr = hrCell;
+				}
+			}
+
+			if (FAILED(hrCell))
+			{
+				release(completion.uCell);
+				m_Policy.OnLoaded(completion.uCell, FALSE, 0u, 0u);
+				continue;
+			}
+
+			UINT64 uCpuSize = 0u;
+			UINT64 uGpuSize = 0u;
+			measure(completion.uCell, uCpuSize, uGpuSize);
+			m_Policy.OnLoaded(completion.uCell, TRUE, uCpuSize, uGpuSize);
+		}
+		m_aFinished.clear();
+		CHECK_AND_RETURN_HRESULT(hr, L"SceneStreamer::Update >> Initializing cell");
+
+		m_Policy.Update(view, m_Decisions);
+
+		for (UINT uCell : m_Decisions.auEvictions)
+		{
+			release(uCell);
+		}
+
+		for (UINT uCell : m_Decisions.auLoads)
+		{
+			load(uCell);
+		}
+
+		return hr;
+	}
+
+	const StreamingPolicy& SceneStreamer::GetPolicy() const noexcept
+	{
+		return m_Policy;
+	}
+
+	void SceneStreamer::load(_In_ UINT uCell)
+	{
+		// Counted before the job starts, so no eviction releases a texture the job decodes
+		for (const std::shared_ptr<Texture>& pTexture : m_aCellContents[uCell].apTextures)
+		{
+			++m_textureReferences[pTexture.get()];
+		}
+
+		m_uNumPending.fetch_add(1u, std::memory_order_relaxed);
+		JobSystem::GetInstance().Schedule(
+			[this, uCell]()
+			{
+				const CellContents& contents = m_aCellContents[uCell];
+
+				HRESULT hr = S_OK;
+				for (size_t i = 0; i < contents.apRenderables.size() && SUCCEEDED(hr); ++i)
+				{
+					hr = contents.apRenderables[i]->Load();
+				}
+
+				for (size_t i = 0; i < contents.apTextures.size() && SUCCEEDED(hr); ++i)
+				{
+					hr = contents.apTextures[i]->Load();
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(m_CompletionMutex);
+					m_aCompletions.push_back(Completion{ .uCell = uCell, .hr = hr });
+				}
+				m_uNumPending.fetch_sub(1u, std::memory_order_release);
+			}
+		);
+	}
+
+	HRESULT SceneStreamer::initialize(_In_ UINT uCell, _In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList)
+	{
+		HRESULT hr = S_OK;
+
+		const CellContents& contents = m_aCellContents[uCell];
+		for (const std::shared_ptr<Texture>& pTexture : contents.apTextures)
+		{
+			hr = pTexture->Initialize(pDevice, pCommandList);
+			CHECK_AND_RETURN_HRESULT(hr, L"SceneStreamer::initialize >> Initializing texture");
+		}
+
+		for (const std::shared_ptr<Renderable>& renderable : contents.apRenderables)
+		{
+			hr = renderable->Initialize(pDevice, pCommandList);
+			CHECK_AND_RETURN_HRESULT(hr, L"SceneStreamer::initialize >> Initializing renderable");
+		}
+
+		return hr;
+	}
+
+	void SceneStreamer::release(_In_ UINT uCell)
+	{
+		const CellContents& contents = m_aCellContents[uCell];
+		for (const std::shared_ptr<Renderable>& renderable : contents.apRenderables)
+		{
+			renderable->Release();
+		}
+
+		for (const std::shared_ptr<Texture>& pTexture : contents.apTextures)
+		{
+			UINT& uNumReferences = m_textureReferences[pTexture.get()];
+			if (--uNumReferences == 0u)
+			{
+				pTexture->Release();
+			}
+		}
+	}
+
+	void SceneStreamer::measure(_In_ UINT uCell, _Out_ UINT64& uOutCpuSize, _Out_ UINT64& uOutGpuSize) const
+	{
+		uOutCpuSize = 0u;
+		uOutGpuSize = 0u;
+
+		// Geometry shared between renderables and textures shared between cells are counted by each of them
+		const CellContents& contents = m_aCellContents[uCell];
+		for (const std::shared_ptr<Renderable>& renderable : contents.apRenderables)
+		{
+			UINT64 uNumVertices = renderable->GetNumVertices();
+			UINT64 uIndexBytes = static_cast<UINT64>(renderable->GetNumIndices()) * sizeof(WORD);
+
+			// Occluders keep a copy of the positions and indices on the CPU
+			if (renderable->IsOccluder())
+			{
+				uOutCpuSize += uNumVertices * sizeof(XMFLOAT3) + uIndexBytes;
+			}
+			uOutGpuSize += uNumVertices * VERTEX_SIZE[static_cast<size_t>(renderable->GetVertexType())] + uIndexBytes;
+		}
+
+		for (const std::shared_ptr<Texture>& pTexture : contents.apTextures)
+		{
+			uOutGpuSize += pTexture->GetSize();
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "pch.h"
+
+#include <atomic>
+
+#include "Graphics/Bounds.h"
+#include "Scene/StreamingPolicy.h"
+
+namespace pr
+{
+	class Renderable;
+	class Texture;
+
+	// Streams the streamable renderables of a scene and their textures in cells of a uniform grid. The files are
+	// read and the textures decoded by background jobs, the render thread only releases evicted cells and records the
+	// uploads of the cells whose jobs finished. Released renderables keep their meshes, so the scene still culls them.
+	class SceneStreamer final
+	{
+	public:
+		static constexpr const FLOAT CELL_SIZE = 50.0f;
+
+	public:
+		explicit SceneStreamer() noexcept;
+		SceneStreamer(const SceneStreamer& other) = delete;
+		SceneStreamer(SceneStreamer&& other) = delete;
+		SceneStreamer& operator=(const SceneStreamer& other) = delete;
+		SceneStreamer& operator=(SceneStreamer&& other) = delete;
+		~SceneStreamer() noexcept;
+
+		// Puts each streamable renderable in the cell holding the center of its world bounds, none of them is resident
+		void Initialize(
+			_In_ const std::vector<std::shared_ptr<Renderable>>& aRenderables,
+			_In_reads_(aRenderables.size()) const UINT* auFirstMeshes,
+			_In_ const MeshBounds* aMeshBounds,
+			_In_ const StreamingPolicy::Settings& settings
+		);
+		void SetSettings(_In_ const StreamingPolicy::Settings& settings) noexcept;
+
+		// Must run while the GPU uses none of the geometry, the uploads are recorded to the command list
+		HRESULT Update(_In_ const StreamingPolicy::View& view, _In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList);
+
+		const StreamingPolicy& GetPolicy() const noexcept;
+
+	private:
+		struct CellContents
+		{
+			std::vector<std::shared_ptr<Renderable>> apRenderables;
+			std::vector<std::shared_ptr<Texture>> apTextures;
+		};
+
+		struct Completion
+		{
+			UINT uCell;
+			HRESULT hr;
+		};
+
+	private:
+		void load(_In_ UINT uCell);
+		HRESULT initialize(_In_ UINT uCell, _In_ ID3D12Device2* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList);
+		void release(_In_ UINT uCell);
+		void measure(_In_ UINT uCell, _Out_ UINT64& uOutCpuSize, _Out_ UINT64& uOutGpuSize) const;
+
+	private:
+		StreamingPolicy m_Policy;
+		StreamingPolicy::Decisions m_Decisions;
+
+		// Indexed by cell
+		std::vector<CellContents> m_aCellContents;
+
+		// Number of loading or resident cells using each texture, textures are released at zero
+		std::unordered_map<const Texture*, UINT> m_textureReferences;
+
+		std::mutex m_CompletionMutex;
+		std::vector<Completion> m_aCompletions;
+		std::vector<Completion> m_aFinished;
+		std::atomic<UINT> m_uNumPending;
+	};
+}
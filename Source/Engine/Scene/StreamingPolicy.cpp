@@ -0,0 +1,252 @@
+#include "pch.h"
+
+#include "Scene/StreamingPolicy.h"
+
+#include <algorithm>
+
+namespace pr
+{
+	namespace
+	{
+		FLOAT distanceToBox(_In_ const Box& box, _In_ const XMFLOAT3& point) noexcept
+		{
+			FLOAT dx = std::max({ box.Min.x - point.x, 0.0f, point.x - box.Max.x });
+			FLOAT dy = std::max({ box.Min.y - point.y, 0.0f, point.y - box.Max.y });
+			FLOAT dz = std::max({ box.Min.z - point.z, 0.0f, point.z - box.Max.z });
+
+			return sqrtf(dx * dx + dy * dy + dz * dz);
+		}
+
+		BOOL isInFrustum(_In_ const Box& box, _In_ const Frustum& frustum) noexcept
+		{
+			XMFLOAT3 center(0.5f * (box.Min.x + box.Max.x), 0.5f * (box.Min.y + box.Max.y), 0.5f * (box.Min.z + box.Max.z));
+			XMFLOAT3 extents(0.5f * (box.Max.x - box.Min.x), 0.5f * (box.Max.y - box.Min.y), 0.5f * (box.Max.z - box.Min.z));
+
+			for (const XMFLOAT4& plane : frustum.aPlanes)
+			{
+				FLOAT distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+				FLOAT radius = fabsf(plane.x) * extents.x + fabsf(plane.y) * extents.y + fabsf(plane.z) * extents.z;
+				if (distance + radius < 0.0f)
+				{
+					return FALSE;
+				}
+			}
+
+			return TRUE;
+		}
+	}
+
+	StreamingPolicy::Settings StreamingPolicy::GetDefaultSettings() noexcept
+	{
+		return Settings
+		{
+			.uCpuBudget = DEFAULT_CPU_BUDGET,
+			.uGpuBudget = DEFAULT_GPU_BUDGET,
+			.LoadRadius = DEFAULT_LOAD_RADIUS,
+			.LookAhead = DEFAULT_LOOK_AHEAD,
+			.uMaxPendingLoads = DEFAULT_MAX_PENDING_LOADS,
+		};
+	}
+
+	StreamingPolicy::StreamingPolicy() noexcept
+		: m_aCells()
+		, m_aResidencies()
+		, m_auLastVisibleFrames()
+		, m_aDistances()
+		, m_Settings(GetDefaultSettings())
+		, m_uFrame(0u)
+		, m_uCpuUsed(0u)
+		, m_uGpuUsed(0u)
+		, m_uNumPendingLoads(0u)
+		, m_uNumLoads(0u)
+		, m_uNumEvictions(0u)
+	{
+	}
+
+	void StreamingPolicy::Initialize(_In_reads_(uNumCells) const Cell* aCells, _In_ UINT uNumCells, _In_ const Settings& settings)
+	{
+		m_aCells.assign(aCells, aCells + uNumCells);
+		m_aResidencies.assign(uNumCells, eResidency::UNLOADED);
+		m_auLastVisibleFrames.assign(uNumCells, 0u);
+		m_aDistances.assign(uNumCells, 0.0f);
+
+		m_Settings = settings;
+		m_uFrame = 0u;
+		m_uCpuUsed = 0u;
+		m_uGpuUsed = 0u;
+		m_uNumPendingLoads = 0u;
+		m_uNumLoads = 0u;
+		m_uNumEvictions = 0u;
+	}
+
+	void StreamingPolicy::SetSettings(_In_ const Settings& settings) noexcept
+	{
+		m_Settings = settings;
+	}
+
+	void StreamingPolicy::Update(_In_ const View& view, _Out_ Decisions& outDecisions)
+	{
+		outDecisions.auEvictions.clear();
+		outDecisions.auLoads.clear();
+
+		++m_uFrame;
+
+		XMFLOAT3 predicted(
+			view.Position.x + view.Velocity.x * m_Settings.LookAhead,
+			view.Position.y + view.Velocity.y * m_Settings.LookAhead,
+			view.Position.z + view.Velocity.z * m_Settings.LookAhead
+		);
+
+		const UINT uNumCells = static_cast<UINT>(m_aCells.size());
+		std::vector<UINT> auCandidates;
+		std::vector<UINT> auEvictable;
+		for (UINT i = 0u; i < uNumCells; ++i)
+		{
+			const Box& bounds = m_aCells[i].Bounds;
+			FLOAT distance = std::min(distanceToBox(bounds, view.Position), distanceToBox(bounds, predicted));
+
+			BOOL bIsVisible = isInFrustum(bounds, view.ViewFrustum);
+			if (bIsVisible)
+			{
+				m_auLastVisibleFrames[i] = m_uFrame;
+			}
+			m_aDistances[i] = bIsVisible ? 0.5f * distance : distance;
+
+			if (m_aResidencies[i] == eResidency::UNLOADED && distance <= m_Settings.LoadRadius)
+			{
+				auCandidates.push_back(i);
+			}
+			else if (m_aResidencies[i] == eResidency::RESIDENT)
+			{
+				auEvictable.push_back(i);
+			}
+		}
+
+		std::sort(
+			auCandidates.begin(),
+			auCandidates.end(),
+			[this](UINT uLeft, UINT uRight)
+			{
+				return m_aDistances[uLeft] < m_aDistances[uRight] || (m_aDistances[uLeft] == m_aDistances[uRight] && uLeft < uRight);
+			}
+		);
+
+		// Least recently visible first, the farthest of those first, so the cells visible this frame come last
+		std::sort(
+			auEvictable.begin(),
+			auEvictable.end(),
+			[this](UINT uLeft, UINT uRight)
+			{
+				if (m_auLastVisibleFrames[uLeft] != m_auLastVisibleFrames[uRight])
+				{
+					return m_auLastVisibleFrames[uLeft] < m_auLastVisibleFrames[uRight];
+				}
+				return m_aDistances[uLeft] > m_aDistances[uRight] || (m_aDistances[uLeft] == m_aDistances[uRight] && uLeft < uRight);
+			}
+		);
+
+		// A lowered budget is met before anything loads, even if visible cells have to go
+		for (size_t i = 0; i < auEvictable.size() && !fits(0u, 0u); ++i)
+		{
+			evict(auEvictable[i], outDecisions);
+		}
+
+		for (UINT uCell : auCandidates)
+		{
+			if (m_uNumPendingLoads >= m_Settings.uMaxPendingLoads)
+			{
+				break;
+			}
+
+			const Cell& cell = m_aCells[uCell];
+			for (size_t i = 0; i < auEvictable.size() && !fits(cell.uCpuSize, cell.uGpuSize); ++i)
+			{
+				UINT uVictim = auEvictable[i];
+				if (m_aResidencies[uVictim] == eResidency::RESIDENT && m_auLastVisibleFrames[uVictim] != m_uFrame && m_aDistances[uVictim] > m_aDistances[uCell])
+				{
+					evict(uVictim, outDecisions);
+				}
+			}
+
+			// The remaining candidates are farther, loading them instead would invert the priorities
+			if (!fits(cell.uCpuSize, cell.uGpuSize))
+			{
+				break;
+			}
+
+			m_aResidencies[uCell] = eResidency::LOADING;
+			m_uCpuUsed += cell.uCpuSize;
+			m_uGpuUsed += cell.uGpuSize;
+			++m_uNumPendingLoads;
+			++m_uNumLoads;
+			outDecisions.auLoads.push_back(uCell);
+		}
+	}
+
+	void StreamingPolicy::OnLoaded(_In_ UINT uCell, _In_ BOOL bSucceeded, _In_ UINT64 uCpuSize, _In_ UINT64 uGpuSize) noexcept
+	{
+		if (uCell >= m_aCells.size() || m_aResidencies[uCell] != eResidency::LOADING)
+		{
+			return;
+		}
+
+		Cell& cell = m_aCells[uCell];
+		m_uCpuUsed -= cell.uCpuSize;
+		m_uGpuUsed -= cell.uGpuSize;
+		--m_uNumPendingLoads;
+
+		if (!bSucceeded)
+		{
+			m_aResidencies[uCell] = eResidency::FAILED;
+			return;
+		}
+
+		cell.uCpuSize = uCpuSize;
+		cell.uGpuSize = uGpuSize;
+		m_uCpuUsed += uCpuSize;
+		m_uGpuUsed += uGpuSize;
+		m_aResidencies[uCell] = eResidency::RESIDENT;
+	}
+
+	UINT StreamingPolicy::GetNumCells() const noexcept
+	{
+		return static_cast<UINT>(m_aCells.size());
+	}
+
+	StreamingPolicy::eResidency StreamingPolicy::GetResidency(_In_ UINT uCell) const noexcept
+	{
+		return m_aResidencies[uCell];
+	}
+
+	const StreamingPolicy::Settings& StreamingPolicy::GetSettings() const noexcept
+	{
+		return m_Settings;
+	}
+
+	StreamingPolicy::Stats StreamingPolicy::GetStats() const noexcept
+	{
+		return Stats
+		{
+			.uCpuUsed = m_uCpuUsed,
+			.uGpuUsed = m_uGpuUsed,
+			.uNumResident = static_cast<UINT>(std::count(m_aResidencies.begin(), m_aResidencies.end(), eResidency::RESIDENT)),
+			.uNumLoading = m_uNumPendingLoads,
+			.uNumLoads = m_uNumLoads,
+			.uNumEvictions = m_uNumEvictions,
+		};
+	}
+
+	BOOL StreamingPolicy::fits(_In_ UINT64 uCpuSize, _In_ UINT64 uGpuSize) const noexcept
+	{
+		return m_uCpuUsed + uCpuSize <= m_Settings.uCpuBudget && m_uGpuUsed + uGpuSize <= m_Settings.uGpuBudget;
+	}
+
+	void StreamingPolicy::evict(_In_ UINT uCell, _Inout_ Decisions& decisions)
+	{
+		m_aResidencies[uCell] = eResidency::UNLOADED;
+		m_uCpuUsed -= m_aCells[uCell].uCpuSize;
+		m_uGpuUsed -= m_aCells[uCell].uGpuSize;
+		++m_uNumEvictions;
+		decisions.auEvictions.push_back(uCell);
+	}
+}
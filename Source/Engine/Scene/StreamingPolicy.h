@@ -0,0 +1,117 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/Bounds.h"
+
+namespace pr
+{
+	// Decides which cells of a streamed scene to load and to evict, without touching any data, so a recorded camera
+	// path replays to the same decisions. Cells within the load radius of the camera or of its position predicted
+	// LOOK_AHEAD seconds ahead are loaded nearest first, cells in the view frustum count as half as far. Loads that
+	// would exceed the CPU or GPU budget evict the resident cells seen least recently, never one seen this frame or
+	// one nearer than the load. Only a lowered budget evicts visible cells, the farthest first.
+	class StreamingPolicy final
+	{
+	public:
+		static constexpr const UINT64 DEFAULT_CPU_BUDGET = _256MB;
+		static constexpr const UINT64 DEFAULT_GPU_BUDGET = 2u * _256MB;
+		static constexpr const FLOAT DEFAULT_LOAD_RADIUS = 100.0f;
+		static constexpr const FLOAT DEFAULT_LOOK_AHEAD = 1.0f;
+		static constexpr const UINT DEFAULT_MAX_PENDING_LOADS = 4u;
+
+		enum class eResidency : BYTE
+		{
+			UNLOADED,
+			LOADING,
+			RESIDENT,
+			// Loading failed, the cell is not requested again
+			FAILED,
+		};
+
+		struct Settings
+		{
+			UINT64 uCpuBudget;
+			UINT64 uGpuBudget;
+			FLOAT LoadRadius;
+			FLOAT LookAhead;
+			UINT uMaxPendingLoads;
+		};
+
+		// Sizes are estimates until the cell is loaded once
+		struct Cell
+		{
+			Box Bounds;
+			UINT64 uCpuSize;
+			UINT64 uGpuSize;
+		};
+
+		// Camera of a frame, the velocity is in units per second
+		struct View
+		{
+			XMFLOAT3 Position;
+			XMFLOAT3 Velocity;
+			Frustum ViewFrustum;
+		};
+
+		// Evictions come first, their memory is counted as free for the loads
+		struct Decisions
+		{
+			std::vector<UINT> auEvictions;
+			std::vector<UINT> auLoads;
+		};
+
+		struct Stats
+		{
+			UINT64 uCpuUsed;
+			UINT64 uGpuUsed;
+			UINT uNumResident;
+			UINT uNumLoading;
+			UINT uNumLoads;
+			UINT uNumEvictions;
+		};
+
+		static Settings GetDefaultSettings() noexcept;
+
+	public:
+		explicit StreamingPolicy() noexcept;
+		StreamingPolicy(const StreamingPolicy& other) = delete;
+		StreamingPolicy(StreamingPolicy&& other) = delete;
+		StreamingPolicy& operator=(const StreamingPolicy& other) = delete;
+		StreamingPolicy& operator=(StreamingPolicy&& other) = delete;
+		~StreamingPolicy() noexcept = default;
+
+		// Every cell starts unloaded
+		void Initialize(_In_reads_(uNumCells) const Cell* aCells, _In_ UINT uNumCells, _In_ const Settings& settings);
+		// A lower budget evicts on the next Update
+		void SetSettings(_In_ const Settings& settings) noexcept;
+
+		void Update(_In_ const View& view, _Out_ Decisions& outDecisions);
+		// Reports a load of the last Decisions with the sizes measured, failed cells free their estimate
+		void OnLoaded(_In_ UINT uCell, _In_ BOOL bSucceeded, _In_ UINT64 uCpuSize, _In_ UINT64 uGpuSize) noexcept;
+
+		UINT GetNumCells() const noexcept;
+		eResidency GetResidency(_In_ UINT uCell) const noexcept;
+		const Settings& GetSettings() const noexcept;
+		Stats GetStats() const noexcept;
+
+	private:
+		BOOL fits(_In_ UINT64 uCpuSize, _In_ UINT64 uGpuSize) const noexcept;
+		void evict(_In_ UINT uCell, _Inout_ Decisions& decisions);
+
+	private:
+		// Indexed by cell
+		std::vector<Cell> m_aCells;
+		std::vector<eResidency> m_aResidencies;
+		std::vector<UINT64> m_auLastVisibleFrames;
+		std::vector<FLOAT> m_aDistances;
+
+		Settings m_Settings;
+		UINT64 m_uFrame;
+		UINT64 m_uCpuUsed;
+		UINT64 m_uGpuUsed;
+		UINT m_uNumPendingLoads;
+		UINT m_uNumLoads;
+		UINT m_uNumEvictions;
+	};
+}
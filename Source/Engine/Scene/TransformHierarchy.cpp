@@ -0,0 +1,326 @@
+#include "pch.h"
+
+#include "Scene/TransformHierarchy.h"
+
+#include <algorithm>
+
+#include "Utility/JobSystem.h"
+#include "Utility/Profiler.h"
+
+namespace pr
+{
+	namespace
+	{
+		constexpr const UINT NODES_PER_JOB = 1024u;
+	}
+
+	TransformHierarchy::TransformHierarchy() noexcept
+		: m_auParentIds()
+		, m_auPositions()
+		, m_auFreeIds()
+		, m_auIds()
+		, m_auParents()
+		, m_aLocals()
+		, m_aWorlds()
+		, m_auFlags()
+		, m_auLevelOffsets()
+		, m_uNumUpdated(0u)
+		, m_bHasDirtyNodes(FALSE)
+		, m_bIsOrderDirty(FALSE)
+		, m_bHasChanges(FALSE)
+	{
+	}
+
+	UINT TransformHierarchy::AddNode(_In_ UINT uParent, _In_ const Transform& local)
+	{
+		assert(uParent == INVALID_NODE || (uParent < m_auPositions.size() && m_auPositions[uParent] != INVALID_NODE));
+
+		UINT uNode = 0u;
+		if (m_auFreeIds.empty())
+		{
+			uNode = static_cast<UINT>(m_auParentIds.size());
+			m_auParentIds.push_back(INVALID_NODE);
+			m_auPositions.push_back(INVALID_NODE);
+		}
+		else
+		{
+			uNode = m_auFreeIds.back();
+			m_auFreeIds.pop_back();
+		}
+
+		XMFLOAT4X4 world;
+		XMStoreFloat4x4(&world, XMMatrixIdentity());
+
+		m_auParentIds[uNode] = uParent;
+		m_auPositions[uNode] = static_cast<UINT>(m_auIds.size());
+		m_auIds.push_back(uNode);
+		m_auParents.push_back(INVALID_NODE);
+		m_aLocals.push_back(local);
+		m_aWorlds.push_back(world);
+		m_auFlags.push_back(FLAG_DIRTY);
+
+		m_bHasDirtyNodes = TRUE;
+		m_bIsOrderDirty = TRUE;
+
+		return uNode;
+	}
+
+	void TransformHierarchy::AddNodes(_In_ UINT uParent, _In_reads_(uNumNodes) const Node* aNodes, _In_ UINT uNumNodes, _Out_writes_(uNumNodes) UINT* auOutNodes)
+	{
+		for (UINT i = 0u; i < uNumNodes; ++i)
+		{
+			assert(aNodes[i].uParent == INVALID_NODE || aNodes[i].uParent < i);
+			auOutNodes[i] = AddNode(aNodes[i].uParent == INVALID_NODE ? uParent : auOutNodes[aNodes[i].uParent], aNodes[i].Local);
+		}
+	}
+
+	void TransformHierarchy::RemoveNode(_In_ UINT uNode)
+	{
+		assert(uNode < m_auPositions.size() && m_auPositions[uNode] != INVALID_NODE);
+
+		const UINT uParent = m_auParentIds[uNode];
+		for (UINT uChild : m_auIds)
+		{
+			if (m_auParentIds[uChild] == uNode)
+			{
+				m_auParentIds[uChild] = uParent;
+				m_auFlags[m_auPositions[uChild]] |= FLAG_DIRTY;
+				m_bHasDirtyNodes = TRUE;
+			}
+		}
+
+		// The last node fills the gap, the order is restored on the next update
+		const UINT uPosition = m_auPositions[uNode];
+		const UINT uLastPosition = static_cast<UINT>(m_auIds.size()) - 1u;
+		if (uPosition != uLastPosition)
+		{
+			m_auIds[uPosition] = m_auIds[uLastPosition];
+			m_aLocals[uPosition] = m_aLocals[uLastPosition];
+			m_aWorlds[uPosition] = m_aWorlds[uLastPosition];
+			m_auFlags[uPosition] = m_auFlags[uLastPosition];
+			m_auPositions[m_auIds[uPosition]] = uPosition;
+		}
+
+		m_auIds.pop_back();
+		m_auParents.pop_back();
+		m_aLocals.pop_back();
+		m_aWorlds.pop_back();
+		m_auFlags.pop_back();
+
+		m_auParentIds[uNode] = INVALID_NODE;
+		m_auPositions[uNode] = INVALID_NODE;
+		m_auFreeIds.push_back(uNode);
+		m_bIsOrderDirty = TRUE;
+	}
+
+	HRESULT TransformHierarchy::SetParent(_In_ UINT uNode, _In_ UINT uParent)
+	{
+		assert(uNode < m_auPositions.size() && m_auPositions[uNode] != INVALID_NODE);
+
+		for (UINT uAncestor = uParent; uAncestor != INVALID_NODE; uAncestor = m_auParentIds[uAncestor])
+		{
+			if (uAncestor == uNode)
+			{
+				return E_INVALIDARG;
+			}
+		}
+
+		m_auParentIds[uNode] = uParent;
+		m_auFlags[m_auPositions[uNode]] |= FLAG_DIRTY;
+		m_bHasDirtyNodes = TRUE;
+		m_bIsOrderDirty = TRUE;
+
+		return S_OK;
+	}
+
+	void TransformHierarchy::SetLocalTransform(_In_ UINT uNode, _In_ const Transform& local) noexcept
+	{
+		const UINT uPosition = m_auPositions[uNode];
+		m_aLocals[uPosition] = local;
+		m_auFlags[uPosition] |= FLAG_DIRTY;
+		m_bHasDirtyNodes = TRUE;
+	}
+
+	void TransformHierarchy::Update(_In_ JobSystem& jobSystem)
+	{
+		PR_PROFILE_FUNCTION();
+
+		if (m_bIsOrderDirty)
+		{
+			sortByDepth();
+		}
+
+		if (m_bHasChanges)
+		{
+			for (BYTE& uFlags : m_auFlags)
+			{
+				uFlags &= FLAG_DIRTY;
+			}
+			m_bHasChanges = FALSE;
+		}
+
+		m_uNumUpdated = 0u;
+		if (!m_bHasDirtyNodes)
+		{
+			return;
+		}
+
+		// Dirty parents make their whole subtree dirty, parents are always visited first
+		const UINT uNumNodes = static_cast<UINT>(m_auIds.size());
+		for (UINT i = 0u; i < uNumNodes; ++i)
+		{
+			if (m_auParents[i] != INVALID_NODE)
+			{
+				m_auFlags[i] |= m_auFlags[m_auParents[i]] & FLAG_DIRTY;
+			}
+			if (m_auFlags[i] & FLAG_DIRTY)
+			{
+				++m_uNumUpdated;
+			}
+		}
+
+		// A level only reads the world matrices of the levels above it
+		for (UINT uLevel = 0u; uLevel + 1u < m_auLevelOffsets.size(); ++uLevel)
+		{
+			const UINT uLevelBegin = m_auLevelOffsets[uLevel];
+			jobSystem.ParallelFor(
+				m_auLevelOffsets[uLevel + 1u] - uLevelBegin,
+				NODES_PER_JOB,
+				[this, uLevelBegin](UINT uBegin, UINT uEnd)
+				{
+					updateNodes(uLevelBegin + uBegin, uLevelBegin + uEnd);
+				}
+			);
+		}
+
+		m_bHasDirtyNodes = FALSE;
+		m_bHasChanges = m_uNumUpdated > 0u;
+	}
+
+	UINT TransformHierarchy::GetParent(_In_ UINT uNode) const noexcept
+	{
+		return m_auParentIds[uNode];
+	}
+
+	const Transform& TransformHierarchy::GetLocalTransform(_In_ UINT uNode) const noexcept
+	{
+		return m_aLocals[m_auPositions[uNode]];
+	}
+
+	const XMFLOAT4X4& TransformHierarchy::GetWorldMatrix(_In_ UINT uNode) const noexcept
+	{
+		return m_aWorlds[m_auPositions[uNode]];
+	}
+
+	BOOL TransformHierarchy::IsChanged(_In_ UINT uNode) const noexcept
+	{
+		return (m_auFlags[m_auPositions[uNode]] & FLAG_CHANGED) != 0u;
+	}
+
+	UINT TransformHierarchy::GetNumNodes() const noexcept
+	{
+		return static_cast<UINT>(m_auIds.size());
+	}
+
+	UINT TransformHierarchy::GetNumUpdatedNodes() const noexcept
+	{
+		return m_uNumUpdated;
+	}
+
+	void TransformHierarchy::sortByDepth()
+	{
+		PR_PROFILE_FUNCTION();
+
+		// Depth of every node, walking up until an ancestor with a known depth
+		std::vector<UINT> auDepths(m_auParentIds.size(), INVALID_NODE);
+		std::vector<UINT> auPath;
+		UINT uNumLevels = 0u;
+		for (UINT uNode : m_auIds)
+		{
+			UINT uAncestor = uNode;
+			while (uAncestor != INVALID_NODE && auDepths[uAncestor] == INVALID_NODE)
+			{
+				auPath.push_back(uAncestor);
+				uAncestor = m_auParentIds[uAncestor];
+			}
+
+			UINT uDepth = uAncestor == INVALID_NODE ? 0u : auDepths[uAncestor] + 1u;
+			for (auto it = auPath.rbegin(); it != auPath.rend(); ++it)
+			{
+				auDepths[*it] = uDepth++;
+			}
+			auPath.clear();
+
+			uNumLevels = std::max(uNumLevels, auDepths[uNode] + 1u);
+		}
+
+		// Stable counting sort by depth
+		m_auLevelOffsets.assign(uNumLevels + 1u, 0u);
+		for (UINT uNode : m_auIds)
+		{
+			++m_auLevelOffsets[auDepths[uNode] + 1u];
+		}
+		for (UINT uLevel = 0u; uLevel < uNumLevels; ++uLevel)
+		{
+			m_auLevelOffsets[uLevel + 1u] += m_auLevelOffsets[uLevel];
+		}
+
+		const UINT uNumNodes = static_cast<UINT>(m_auIds.size());
+		std::vector<UINT> auIds(uNumNodes);
+		std::vector<Transform> aLocals(uNumNodes);
+		std::vector<XMFLOAT4X4> aWorlds(uNumNodes);
+		std::vector<BYTE> auFlags(uNumNodes);
+		std::vector<UINT> auNext(m_auLevelOffsets.begin(), m_auLevelOffsets.end() - 1);
+		for (UINT i = 0u; i < uNumNodes; ++i)
+		{
+			const UINT uPosition = auNext[auDepths[m_auIds[i]]]++;
+			auIds[uPosition] = m_auIds[i];
+			aLocals[uPosition] = m_aLocals[i];
+			aWorlds[uPosition] = m_aWorlds[i];
+			auFlags[uPosition] = m_auFlags[i];
+		}
+
+		m_auIds = std::move(auIds);
+		m_aLocals = std::move(aLocals);
+		m_aWorlds = std::move(aWorlds);
+		m_auFlags = std::move(auFlags);
+
+		for (UINT i = 0u; i < uNumNodes; ++i)
+		{
+			m_auPositions[m_auIds[i]] = i;
+		}
+		for (UINT i = 0u; i < uNumNodes; ++i)
+		{
+			const UINT uParent = m_auParentIds[m_auIds[i]];
+			m_auParents[i] = uParent == INVALID_NODE ? INVALID_NODE : m_auPositions[uParent];
+		}
+
+		m_bIsOrderDirty = FALSE;
+	}
+
+	void TransformHierarchy::updateNodes(_In_ UINT uBegin, _In_ UINT uEnd) noexcept
+	{
+		for (UINT i = uBegin; i < uEnd; ++i)
+		{
+			if (!(m_auFlags[i] & FLAG_DIRTY))
+			{
+				continue;
+			}
+
+			const Transform& local = m_aLocals[i];
+			XMMATRIX world = XMMatrixAffineTransformation(
+				XMLoadFloat3(&local.Scale),
+				XMVectorZero(),
+				XMLoadFloat4(&local.Rotation),
+				XMLoadFloat3(&local.Translation)
+			);
+			if (m_auParents[i] != INVALID_NODE)
+			{
+				world = XMMatrixMultiply(world, XMLoadFloat4x4(&m_aWorlds[m_auParents[i]]));
+			}
+
+			XMStoreFloat4x4(&m_aWorlds[i], world);
+			m_auFlags[i] = FLAG_CHANGED;
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Graphics/DataTypes.h"
+
+namespace pr
+{
+	class JobSystem;
+
+	// Parent / child transforms kept in flat arrays sorted by depth, so every parent comes before its children.
+	// Nodes hold a local scale, rotation and translation, setting one marks the node dirty. Update pushes the
+	// dirty flags down to the children and recomputes the world matrices of the dirty subtrees only, one depth
+	// level after the other with the nodes of a level spread over the job system.
+	// Node ids stay the same while the arrays are re-sorted, freed ids are reused.
+	class TransformHierarchy final
+	{
+	public:
+		static constexpr const UINT INVALID_NODE = 0xFFFFFFFFu;
+
+		// Node of a hierarchy given as an array, parents are indices into the same array and come first
+		struct Node
+		{
+			UINT uParent;
+			Transform Local;
+		};
+
+	public:
+		explicit TransformHierarchy() noexcept;
+		TransformHierarchy(const TransformHierarchy& other) = delete;
+		TransformHierarchy(TransformHierarchy&& other) = delete;
+		TransformHierarchy& operator=(const TransformHierarchy& other) = delete;
+		TransformHierarchy& operator=(TransformHierarchy&& other) = delete;
+		~TransformHierarchy() noexcept = default;
+
+		UINT AddNode(_In_ UINT uParent, _In_ const Transform& local);
+		// Appends a whole hierarchy under uParent and writes the id of every node to auOutNodes
+		void AddNodes(_In_ UINT uParent, _In_reads_(uNumNodes) const Node* aNodes, _In_ UINT uNumNodes, _Out_writes_(uNumNodes) UINT* auOutNodes);
+		// The children of a removed node move to its parent
+		void RemoveNode(_In_ UINT uNode);
+		// E_INVALIDARG when the new parent is the node itself or one of its descendants
+		HRESULT SetParent(_In_ UINT uNode, _In_ UINT uParent);
+		void SetLocalTransform(_In_ UINT uNode, _In_ const Transform& local) noexcept;
+
+		void Update(_In_ JobSystem& jobSystem);
+
+		UINT GetParent(_In_ UINT uNode) const noexcept;
+		const Transform& GetLocalTransform(_In_ UINT uNode) const noexcept;
+		const XMFLOAT4X4& GetWorldMatrix(_In_ UINT uNode) const noexcept;
+		// Whether the world matrix was recomputed by the last Update
+		BOOL IsChanged(_In_ UINT uNode) const noexcept;
+		UINT GetNumNodes() const noexcept;
+		UINT GetNumUpdatedNodes() const noexcept;
+
+	private:
+		static constexpr const BYTE FLAG_DIRTY = 1u << 0u;
+		static constexpr const BYTE FLAG_CHANGED = 1u << 1u;
+
+	private:
+		void sortByDepth();
+		void updateNodes(_In_ UINT uBegin, _In_ UINT uEnd) noexcept;
+
+	private:
+		// Indexed by id
+		std::vector<UINT> m_auParentIds;
+		std::vector<UINT> m_auPositions;
+		std::vector<UINT> m_auFreeIds;
+
+		// Indexed by position in depth order
+		std::vector<UINT> m_auIds;
+		std::vector<UINT> m_auParents;
+		std::vector<Transform> m_aLocals;
+		std::vector<XMFLOAT4X4> m_aWorlds;
+		std::vector<BYTE> m_auFlags;
+		std::vector<UINT> m_auLevelOffsets;
+
+		UINT m_uNumUpdated;
+		BOOL m_bHasDirtyNodes;
+		BOOL m_bIsOrderDirty;
+		BOOL m_bHasChanges;
+	};
+}
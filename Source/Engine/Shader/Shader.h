@@ -15,9 +15,12 @@
 
 namespace pr
 {
-    constexpr PCWSTR VS_VERTEX_PCN = L"VSPCN.cso";
-    constexpr PCWSTR PS_DEPTH = L"PSDepth.cso";
-    constexpr PCWSTR PS_NORMAL = L"PSNormal.cso";
+    // Names of the shaders in the shader archive
+    constexpr PCWSTR VS_VERTEX_PCN = L"VSPCN";
+    constexpr PCWSTR VS_VERTEX_PACKED_PCN = L"VSPackedPCN";
+    constexpr PCWSTR PS_CLUSTERED = L"PSClustered";
+    constexpr PCWSTR PS_DEPTH = L"PSDepth";
+    constexpr PCWSTR PS_NORMAL = L"PSNormal";
 
     //class Shader
     //{
@@ -0,0 +1,134 @@
+#include "pch.h"
+
+#include "Shader/ShaderArchive.h"
+
+#include "Shader/ShaderArchiveFile.h"
+#include "Utility/Profiler.h"
+#include "Utility/Utility.h"
+
+namespace pr
+{
+	ShaderArchive::ShaderArchive() noexcept
+		: m_hFile(INVALID_HANDLE_VALUE)
+		, m_hMapping(nullptr)
+		, m_pData(nullptr)
+		, m_uSize(0)
+	{
+	}
+
+	ShaderArchive::~ShaderArchive() noexcept
+	{
+		release();
+	}
+
+	HRESULT ShaderArchive::Initialize(_In_ const std::filesystem::path& filePath)
+	{
+		PR_PROFILE_FUNCTION();
+
+		HRESULT hr = S_OK;
+
+		release();
+
+		m_hFile = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+		if (m_hFile == INVALID_HANDLE_VALUE)
+		{
+			hr = HRESULT_FROM_WIN32(GetLastError());
+			CHECK_AND_RETURN_HRESULT(hr, L"ShaderArchive::Initialize >> Opening shader archive");
+		}
+
+		LARGE_INTEGER fileSize = {};
+		if (!GetFileSizeEx(m_hFile, &fileSize))
+		{
+			hr = HRESULT_FROM_WIN32(GetLastError());
+			release();
+			CHECK_AND_RETURN_HRESULT(hr, L"ShaderArchive::Initialize >> Getting shader archive size");
+		}
+
+		m_hMapping = CreateFileMappingW(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_hMapping)
+		{
+			hr = HRESULT_FROM_WIN32(GetLastError());
+			release();
+			CHECK_AND_RETURN_HRESULT(hr, L"ShaderArchive::Initialize >> Creating shader archive mapping");
+		}
+
+		m_pData = static_cast<const BYTE*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+		if (!m_pData)
+		{
+			hr = HRESULT_FROM_WIN32(GetLastError());
+			release();
+			CHECK_AND_RETURN_HRESULT(hr, L"ShaderArchive::Initialize >> Mapping shader archive");
+		}
+		m_uSize = static_cast<size_t>(fileSize.QuadPart);
+
+		hr = ShaderArchiveFile::Validate(m_pData, m_uSize);
+		if (FAILED(hr))
+		{
+			release();
+			CHECK_AND_RETURN_HRESULT(hr, L"ShaderArchive::Initialize >> Validating shader archive");
+		}
+
+		return S_OK;
+	}
+
+	HRESULT ShaderArchive::GetBytecode(_Out_ D3D12_SHADER_BYTECODE& outBytecode, _In_ PCWSTR pszName, _In_opt_ PCWSTR pszDefines) const
+	{
+		return GetBytecode(outBytecode, ShaderArchiveFile::HashName(pszName), ShaderArchiveFile::HashPermutation(pszDefines));
+	}
+
+	HRESULT ShaderArchive::GetBytecode(_Out_ D3D12_SHADER_BYTECODE& outBytecode, _In_ UINT64 uNameHash, _In_ UINT64 uPermutationHash) const
+	{
+		outBytecode = {};
+
+		if (!m_pData)
+		{
+			return E_NOT_VALID_STATE;
+		}
+
+		const BYTE* pBytecode = nullptr;
+		size_t uSize = 0;
+		if (!ShaderArchiveFile::Find(pBytecode, uSize, m_pData, uNameHash, uPermutationHash))
+		{
+			return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+		}
+
+		outBytecode = { pBytecode, uSize };
+
+		return S_OK;
+	}
+
+	UINT ShaderArchive::GetNumShaders() const noexcept
+	{
+		if (!m_pData)
+		{
+			return 0u;
+		}
+
+		ShaderArchiveFile::Header header;
+		memcpy(&header, m_pData, sizeof(header));
+
+		return header.uNumEntries;
+	}
+
+	void ShaderArchive::release() noexcept
+	{
+		if (m_pData)
+		{
+			UnmapViewOfFile(m_pData);
+			m_pData = nullptr;
+		}
+		m_uSize = 0;
+
+		if (m_hMapping)
+		{
+			CloseHandle(m_hMapping);
+			m_hMapping = nullptr;
+		}
+
+		if (m_hFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_hFile);
+			m_hFile = INVALID_HANDLE_VALUE;
+		}
+	}
+}
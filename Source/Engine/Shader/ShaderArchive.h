@@ -0,0 +1,36 @@
+#pragma once
+
+#include "pch.h"
+
+namespace pr
+{
+	// Read only view of a shader archive written by the ShaderArchiveBuilder tool. The file is mapped once and the
+	// bytecode handed out points straight into the mapping, so it stays valid for the lifetime of the archive.
+	class ShaderArchive final
+	{
+	public:
+		explicit ShaderArchive() noexcept;
+		ShaderArchive(const ShaderArchive& other) = delete;
+		ShaderArchive(ShaderArchive&& other) = delete;
+		ShaderArchive& operator=(const ShaderArchive& other) = delete;
+		ShaderArchive& operator=(ShaderArchive&& other) = delete;
+		~ShaderArchive() noexcept;
+
+		HRESULT Initialize(_In_ const std::filesystem::path& filePath);
+
+		// pszName is the file name of the compiled shader without its extension, pszDefines names the permutation
+		HRESULT GetBytecode(_Out_ D3D12_SHADER_BYTECODE& outBytecode, _In_ PCWSTR pszName, _In_opt_ PCWSTR pszDefines = nullptr) const;
+		HRESULT GetBytecode(_Out_ D3D12_SHADER_BYTECODE& outBytecode, _In_ UINT64 uNameHash, _In_ UINT64 uPermutationHash) const;
+
+		UINT GetNumShaders() const noexcept;
+
+	private:
+		void release() noexcept;
+
+	private:
+		HANDLE m_hFile;
+		HANDLE m_hMapping;
+		const BYTE* m_pData;
+		size_t m_uSize;
+	};
+}
@@ -0,0 +1,185 @@
+#include "pch.h"
+
+#include "Shader/ShaderArchiveFile.h"
+
+#include <algorithm>
+
+#include "Utility/Hash.h"
+#include "Utility/Math.h"
+
+namespace pr
+{
+	namespace ShaderArchiveFile
+	{
+		namespace
+		{
+			UINT64 hashLowerCase(_In_ PCWSTR pszText) noexcept
+			{
+				// Hashes the lower case ASCII bytes so the keys do not depend on the size of wchar_t
+				CHAR aText[256];
+				size_t uLength = 0;
+				for (; pszText[uLength] != L'\0' && uLength < ARRAYSIZE(aText); ++uLength)
+				{
+					WCHAR ch = pszText[uLength];
+					aText[uLength] = static_cast<CHAR>(ch >= L'A' && ch <= L'Z' ? ch - L'A' + L'a' : ch);
+				}
+
+				return HashBytes(aText, uLength);
+			}
+
+			BOOL isLess(_In_ const Entry& lhs, _In_ UINT64 uNameHash, _In_ UINT64 uPermutationHash) noexcept
+			{
+				return lhs.uNameHash < uNameHash || (lhs.uNameHash == uNameHash && lhs.uPermutationHash < uPermutationHash);
+			}
+		}
+
+		UINT64 HashName(_In_ PCWSTR pszName) noexcept
+		{
+			return hashLowerCase(pszName);
+		}
+
+		UINT64 HashPermutation(_In_ PCWSTR pszDefines) noexcept
+		{
+			if (!pszDefines || pszDefines[0] == L'\0')
+			{
+				return 0u;
+			}
+
+			return hashLowerCase(pszDefines);
+		}
+
+		HRESULT Write(_Out_ std::vector<BYTE>& aOutData, _In_ const std::vector<Shader>& aShaders)
+		{
+			aOutData.clear();
+
+			std::vector<const Shader*> apSorted;
+			apSorted.reserve(aShaders.size());
+			for (const Shader& shader : aShaders)
+			{
+				apSorted.push_back(&shader);
+			}
+			std::sort(apSorted.begin(), apSorted.end(),
+				[](const Shader* pLhs, const Shader* pRhs)
+				{
+					return pLhs->uNameHash < pRhs->uNameHash || (pLhs->uNameHash == pRhs->uNameHash && pLhs->uPermutationHash < pRhs->uPermutationHash);
+				}
+			);
+
+			size_t uOffset = sizeof(Header) + sizeof(Entry) * apSorted.size();
+
+			std::vector<Entry> aEntries;
+			aEntries.reserve(apSorted.size());
+			for (const Shader* pShader : apSorted)
+			{
+				if (!aEntries.empty() && aEntries.back().uNameHash == pShader->uNameHash && aEntries.back().uPermutationHash == pShader->uPermutationHash)
+				{
+					return E_INVALIDARG;
+				}
+
+				uOffset = AlignUp(uOffset, BLOB_ALIGNMENT);
+				aEntries.push_back(
+					Entry
+					{
+						.uNameHash = pShader->uNameHash,
+						.uPermutationHash = pShader->uPermutationHash,
+						.uOffset = uOffset,
+						.uSize = pShader->uSize,
+					}
+				);
+				uOffset += pShader->uSize;
+			}
+
+			Header header =
+			{
+				.uMagic = MAGIC,
+				.uVersion = VERSION,
+				.uNumEntries = static_cast<UINT>(aEntries.size()),
+				.uReserved = 0u,
+			};
+
+			aOutData.assign(uOffset, 0u);
+			memcpy(aOutData.data(), &header, sizeof(Header));
+			if (!aEntries.empty())
+			{
+				memcpy(aOutData.data() + sizeof(Header), aEntries.data(), sizeof(Entry) * aEntries.size());
+			}
+			for (size_t i = 0; i < apSorted.size(); ++i)
+			{
+				memcpy(aOutData.data() + aEntries[i].uOffset, apSorted[i]->pData, apSorted[i]->uSize);
+			}
+
+			return S_OK;
+		}
+
+		HRESULT Validate(_In_reads_bytes_(uSize) const BYTE* pData, _In_ size_t uSize)
+		{
+			Header header;
+			if (!pData || uSize < sizeof(Header))
+			{
+				return E_FAIL;
+			}
+			memcpy(&header, pData, sizeof(Header));
+
+			if (header.uMagic != MAGIC || header.uVersion != VERSION)
+			{
+				return E_FAIL;
+			}
+
+			if (header.uNumEntries > (uSize - sizeof(Header)) / sizeof(Entry))
+			{
+				return E_FAIL;
+			}
+
+			size_t uBlobsBegin = sizeof(Header) + sizeof(Entry) * header.uNumEntries;
+			for (UINT i = 0u; i < header.uNumEntries; ++i)
+			{
+				Entry entry;
+				memcpy(&entry, pData + sizeof(Header) + sizeof(Entry) * i, sizeof(Entry));
+
+				if (entry.uOffset < uBlobsBegin || entry.uOffset > uSize || entry.uSize > uSize - entry.uOffset)
+				{
+					return E_FAIL;
+				}
+
+				// Find relies on the order
+				if (i > 0u)
+				{
+					Entry previous;
+					memcpy(&previous, pData + sizeof(Header) + sizeof(Entry) * (i - 1u), sizeof(Entry));
+					if (!isLess(previous, entry.uNameHash, entry.uPermutationHash))
+					{
+						return E_FAIL;
+					}
+				}
+			}
+
+			return S_OK;
+		}
+
+		BOOL Find(_Out_ const BYTE*& pOutBytecode, _Out_ size_t& uOutSize, _In_ const BYTE* pData, _In_ UINT64 uNameHash, _In_ UINT64 uPermutationHash) noexcept
+		{
+			pOutBytecode = nullptr;
+			uOutSize = 0;
+
+			const Header* pHeader = reinterpret_cast<const Header*>(pData);
+			const Entry* pBegin = reinterpret_cast<const Entry*>(pData + sizeof(Header));
+			const Entry* pEnd = pBegin + pHeader->uNumEntries;
+
+			const Entry* pEntry = std::lower_bound(pBegin, pEnd, uNameHash,
+				[uPermutationHash](const Entry& entry, UINT64 uName)
+				{
+					return isLess(entry, uName, uPermutationHash);
+				}
+			);
+			if (pEntry == pEnd || pEntry->uNameHash != uNameHash || pEntry->uPermutationHash != uPermutationHash)
+			{
+				return FALSE;
+			}
+
+			pOutBytecode = pData + pEntry->uOffset;
+			uOutSize = static_cast<size_t>(pEntry->uSize);
+
+			return TRUE;
+		}
+	}
+}
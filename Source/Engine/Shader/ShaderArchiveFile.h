@@ -0,0 +1,58 @@
+#pragma once
+
+#include "pch.h"
+
+namespace pr
+{
+	// On disk layout of the shader archive, all values little endian:
+	//   Header, Entry[uNumEntries] sorted by name and permutation hash, blobs each aligned to BLOB_ALIGNMENT
+	// The archive is read in place from a mapped view, so there is no checksum that would touch every page at
+	// startup. The bytecode containers carry their own hash which the runtime validates on pipeline creation.
+	namespace ShaderArchiveFile
+	{
+		constexpr const UINT MAGIC = 0x41535250;	// "PRSA"
+		constexpr const UINT VERSION = 1u;
+		constexpr const UINT BLOB_ALIGNMENT = 16u;
+
+		struct Header
+		{
+			UINT uMagic;
+			UINT uVersion;
+			UINT uNumEntries;
+			UINT uReserved;
+		};
+		static_assert(sizeof(Header) == 16);
+
+		struct Entry
+		{
+			UINT64 uNameHash;
+			UINT64 uPermutationHash;
+			UINT64 uOffset;
+			UINT64 uSize;
+		};
+		static_assert(sizeof(Entry) == 32);
+
+		struct Shader
+		{
+			UINT64 uNameHash;
+			UINT64 uPermutationHash;
+			const BYTE* pData;
+			size_t uSize;
+		};
+
+		// Names are case insensitive ASCII, the file name of the compiled shader without its extension
+		UINT64 HashName(_In_ PCWSTR pszName) noexcept;
+
+		// Permutations are named by their defines, e.g. "SKINNED_ALPHA_TEST". The empty permutation hashes to 0.
+		UINT64 HashPermutation(_In_ PCWSTR pszDefines) noexcept;
+
+		// Fails on duplicate keys
+		HRESULT Write(_Out_ std::vector<BYTE>& aOutData, _In_ const std::vector<Shader>& aShaders);
+
+		// Checks the header and the bounds of every entry, pData has to stay valid for Find
+		HRESULT Validate(_In_reads_bytes_(uSize) const BYTE* pData, _In_ size_t uSize);
+
+		// pData must have passed Validate and be aligned to 8 bytes, returns FALSE if the shader is not in the archive
+		BOOL Find(_Out_ const BYTE*& pOutBytecode, _Out_ size_t& uOutSize, _In_ const BYTE* pData, _In_ UINT64 uNameHash, _In_ UINT64 uPermutationHash) noexcept;
+	}
+}
@@ -0,0 +1,76 @@
+#define NUM_CLUSTERS_X 16
+#define NUM_CLUSTERS_Y 9
+#define NUM_CLUSTERS_Z 24
+
+#define LIGHT_TYPE_SPOT 1
+
+struct Frame
+{
+    matrix View;
+    matrix Projection;
+    float4 CameraPosition;
+    float4 ClusterParameters;
+};
+
+struct Light
+{
+    float3 Position;
+    float Range;
+    float3 Color;
+    uint Type;
+    float3 Direction;
+    float CosOuterAngle;
+};
+
+struct Cluster
+{
+    uint Offset;
+    uint NumLights;
+};
+
+ConstantBuffer<Frame> cbFrame : register(b0);
+StructuredBuffer<Light> Lights : register(t2);
+StructuredBuffer<Cluster> Clusters : register(t3);
+StructuredBuffer<uint> LightIndices : register(t4);
+
+struct InputVertex
+{
+    float4 Position : SV_Position;
+    float3 Normal : NORMAL;
+    float2 TexCoord : TEXCOORD0;
+    float4 WorldPosition : TEXCOORD1;
+};
+
+float4 main(InputVertex Input) : SV_TARGET
+{
+    float3 normal = normalize(Input.Normal);
+    float3 albedo = (normal + 1.0f) / 2.0f;
+
+    // Froxel of the pixel, depth slices are exponential in view depth
+    uint2 tile = min(uint2(Input.Position.xy * cbFrame.ClusterParameters.xy), uint2(NUM_CLUSTERS_X - 1, NUM_CLUSTERS_Y - 1));
+    uint slice = uint(clamp(log(max(Input.WorldPosition.w, 1e-4f)) * cbFrame.ClusterParameters.z + cbFrame.ClusterParameters.w, 0.0f, NUM_CLUSTERS_Z - 1.0f));
+    Cluster cluster = Clusters[tile.x + NUM_CLUSTERS_X * (tile.y + NUM_CLUSTERS_Y * slice)];
+
+    float3 color = albedo * 0.1f;
+    for (uint i = 0; i < cluster.NumLights; ++i)
+    {
+        Light light = Lights[LightIndices[cluster.Offset + i]];
+
+        float3 toLight = light.Position - Input.WorldPosition.xyz;
+        float distance = length(toLight);
+        toLight /= max(distance, 1e-4f);
+
+        float attenuation = saturate(1.0f - distance / light.Range);
+        attenuation *= attenuation;
+
+        if (light.Type == LIGHT_TYPE_SPOT)
+        {
+            float spot = saturate((dot(-toLight, light.Direction) - light.CosOuterAngle) / max(1.0f - light.CosOuterAngle, 1e-4f));
+            attenuation *= spot * spot;
+        }
+
+        color += albedo * light.Color * saturate(dot(normal, toLight)) * attenuation;
+    }
+
+    return float4(color, 1.0f);
+}
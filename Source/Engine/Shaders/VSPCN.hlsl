@@ -1,22 +1,25 @@
-struct Camera
+struct Frame
 {
 	matrix View;
-	float4 Position;
+	matrix Projection;
+	float4 CameraPosition;
+	float4 ClusterParameters;
 };
 
-struct Display
+struct Draw
 {
-	matrix Projection;
+	uint FirstInstance;
 };
 
-struct Model
+struct Object
 {
-	matrix World;
+	row_major float3x4 World;
 };
 
-ConstantBuffer<Camera> cbCamera : register(b0);
-ConstantBuffer<Display> cbDisplay : register(b1);
-ConstantBuffer<Model> cbModel : register(b2);
+ConstantBuffer<Frame> cbFrame : register(b0);
+ConstantBuffer<Draw> cbDraw : register(b1);
+StructuredBuffer<Object> Objects : register(t0);
+StructuredBuffer<uint> InstanceObjectIndices : register(t1);
 
 struct InputVertex
 {
@@ -30,19 +33,24 @@ struct OutputVertex
     float4 Position : SV_Position;
     float3 Normal : NORMAL;
     float2 TexCoord : TEXCOORD0;
+    float4 WorldPosition : TEXCOORD1;
 };
 
-OutputVertex main(InputVertex Input)
+OutputVertex main(InputVertex Input, uint InstanceId : SV_InstanceID)
 {
 	OutputVertex Output;
 
-    Output.Position = mul(cbModel.World, float4(Input.Position, 1.0f));
-    Output.Position = mul(cbCamera.View, Output.Position);
-    Output.Position = mul(cbDisplay.Projection, Output.Position);
+    float3x4 World = Objects[InstanceObjectIndices[cbDraw.FirstInstance + InstanceId]].World;
+
+    Output.Position = float4(mul(World, float4(Input.Position, 1.0f)), 1.0f);
+    Output.WorldPosition = Output.Position;
+    Output.Position = mul(cbFrame.View, Output.Position);
+    Output.WorldPosition.w = Output.Position.z;
+    Output.Position = mul(cbFrame.Projection, Output.Position);
     
     Output.TexCoord = Input.TexCoord;
     
-    Output.Normal = normalize(mul(cbModel.World, float4(Input.Normal, 0.0f)).xyz);
+    Output.Normal = normalize(mul(World, float4(Input.Normal, 0.0f)));
 	
     return Output;
-}
\ No newline at end of file
+}
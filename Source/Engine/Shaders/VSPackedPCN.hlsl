@@ -0,0 +1,66 @@
+struct Frame
+{
+	matrix View;
+	matrix Projection;
+	float4 CameraPosition;
+	float4 ClusterParameters;
+};
+
+struct Draw
+{
+	uint FirstInstance;
+};
+
+struct Object
+{
+	row_major float3x4 World;
+};
+
+ConstantBuffer<Frame> cbFrame : register(b0);
+ConstantBuffer<Draw> cbDraw : register(b1);
+StructuredBuffer<Object> Objects : register(t0);
+StructuredBuffer<uint> InstanceObjectIndices : register(t1);
+
+// VertexPackedPNT, the position is in [0, 1] relative to the bounds of the geometry, the object transforms of packed
+// renderables map it back to object space. The normal is octahedral encoded.
+struct InputVertex
+{
+	float4 Position : POSITION;
+	float2 Normal : NORMAL;
+    float2 TexCoord : TEXCOORD0;
+};
+
+struct OutputVertex
+{
+    float4 Position : SV_Position;
+    float3 Normal : NORMAL;
+    float2 TexCoord : TEXCOORD0;
+    float4 WorldPosition : TEXCOORD1;
+};
+
+float3 DecodeOctahedral(float2 Encoded)
+{
+    float3 Normal = float3(Encoded, 1.0f - abs(Encoded.x) - abs(Encoded.y));
+    float Fold = saturate(-Normal.z);
+    Normal.xy += (Normal.xy >= 0.0f) ? -Fold : Fold;
+    return normalize(Normal);
+}
+
+OutputVertex main(InputVertex Input, uint InstanceId : SV_InstanceID)
+{
+	OutputVertex Output;
+
+    float3x4 World = Objects[InstanceObjectIndices[cbDraw.FirstInstance + InstanceId]].World;
+
+    Output.Position = float4(mul(World, float4(Input.Position.xyz, 1.0f)), 1.0f);
+    Output.WorldPosition = Output.Position;
+    Output.Position = mul(cbFrame.View, Output.Position);
+    Output.WorldPosition.w = Output.Position.z;
+    Output.Position = mul(cbFrame.Projection, Output.Position);
+    
+    Output.TexCoord = Input.TexCoord;
+    
+    Output.Normal = normalize(mul(World, float4(DecodeOctahedral(Input.Normal), 0.0f)));
+	
+    return Output;
+}
@@ -12,6 +12,23 @@ namespace pr
 	{
 	}
 
+	HRESULT Material::Load()
+	{
+		for (const std::shared_ptr<Texture>& pTexture : { pDiffuse, pSpecularExponent, pNormal })
+		{
+			if (pTexture)
+			{
+				HRESULT hr = pTexture->Load();
+				if (FAILED(hr))
+				{
+					return hr;
+				}
+			}
+		}
+
+		return S_OK;
+	}
+
 	HRESULT Material::Initialize(_In_ ID3D12Device* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList)
 	{
 		HRESULT hr = S_OK;
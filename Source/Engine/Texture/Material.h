@@ -27,6 +27,8 @@ namespace pr
 		Material& operator=(Material&& other) = default;
 		virtual ~Material() = default;
 
+		// Decodes the textures on the CPU, safe to call from a worker thread before Initialize
+		HRESULT Load();
 		virtual HRESULT Initialize(_In_ ID3D12Device* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList);
 
 		std::wstring GetName() const;
@@ -11,6 +11,9 @@ namespace pr
 {
 	Texture::Texture(_In_ const std::filesystem::path& filePath)
 		: m_filePath(filePath)
+		, m_pImage()
+		, m_ImageMutex()
+		, m_uSize(0u)
 		//, m_textureRV()
 		//, m_samplerLinear()
 		, m_pTextureResource()
@@ -18,44 +21,83 @@ namespace pr
 	{
 	}
 
+	Texture::~Texture() = default;
+
+	HRESULT Texture::Load()
+	{
+		// Textures shared by several materials are loaded by whichever job comes first
+		std::lock_guard<std::mutex> lock(m_ImageMutex);
+
+		return load();
+	}
+
 	HRESULT Texture::Initialize(_In_ ID3D12Device* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList)
 	{
-		ScratchImage image;
-		TexMetadata metadata;
+		// Streamed scenes decode textures on workers while the render thread uploads others sharing them
+		std::lock_guard<std::mutex> lock(m_ImageMutex);
+
+		return initialize(pDevice, pCommandList);
+	}
+
+	HRESULT Texture::load()
+	{
+		if (m_pImage || m_pTextureResource)
+		{
+			return S_OK;
+		}
+
+		std::unique_ptr<ScratchImage> pImage = std::make_unique<ScratchImage>();
 		HRESULT hr = S_OK;
 
 		WCHAR ext[_MAX_EXT] = {};
 		_wsplitpath_s(m_filePath.c_str(), nullptr, 0, nullptr, 0, nullptr, 0, ext, _MAX_EXT);
 
+		// The loaders fill the metadata themselves, so every file is opened once
 		if (_wcsicmp(ext, L".dds") == 0)
 		{
-			hr = GetMetadataFromDDSFile(m_filePath.c_str(), DDS_FLAGS_NONE, metadata);
-			CHECK_AND_RETURN_HRESULT(hr, L"Texture::Initialize >> Getting metadata from DDS file");
-			hr = LoadFromDDSFile(m_filePath.c_str(), DDS_FLAGS_NONE, nullptr, image);
-			CHECK_AND_RETURN_HRESULT(hr, L"Texture::Initialize >> Loading from DDS file");
+			hr = LoadFromDDSFile(m_filePath.c_str(), DDS_FLAGS_NONE, nullptr, *pImage);
+			CHECK_AND_RETURN_HRESULT(hr, L"Texture::Load >> Loading from DDS file");
 		}
 		else if (_wcsicmp(ext, L".tga") == 0)
 		{
-			hr = GetMetadataFromTGAFile(m_filePath.c_str(), TGA_FLAGS_NONE, metadata);
-			CHECK_AND_RETURN_HRESULT(hr, L"Texture::Initialize >> Getting metadata from TGA file");
-			hr = LoadFromTGAFile(m_filePath.c_str(), nullptr, image);
-			CHECK_AND_RETURN_HRESULT(hr, L"Texture::Initialize >> Loading from TGA file");
+			hr = LoadFromTGAFile(m_filePath.c_str(), nullptr, *pImage);
+			CHECK_AND_RETURN_HRESULT(hr, L"Texture::Load >> Loading from TGA file");
 		}
 		else if (_wcsicmp(ext, L".hdr") == 0)
 		{
-			hr = GetMetadataFromHDRFile(m_filePath.c_str(), metadata);
-			CHECK_AND_RETURN_HRESULT(hr, L"Texture::Initialize >> Getting metadata from HDR file");
-			hr = LoadFromHDRFile(m_filePath.c_str(), nullptr, image);
-			CHECK_AND_RETURN_HRESULT(hr, L"Texture::Initialize >> Loading from HDR file");
+			hr = LoadFromHDRFile(m_filePath.c_str(), nullptr, *pImage);
+			CHECK_AND_RETURN_HRESULT(hr, L"Texture::Load >> Loading from HDR file");
 		}
 		else
 		{
-			hr = GetMetadataFromWICFile(m_filePath.c_str(), WIC_FLAGS_NONE, metadata);
-			CHECK_AND_RETURN_HRESULT(hr, L"Texture::Initialize >> Getting metadata from HDR file");
-			hr = LoadFromWICFile(m_filePath.c_str(), WIC_FLAGS_NONE, nullptr, image);
-			CHECK_AND_RETURN_HRESULT(hr, L"Texture::Initialize >> Loading from WIC file");
+			hr = LoadFromWICFile(m_filePath.c_str(), WIC_FLAGS_NONE, nullptr, *pImage);
+			CHECK_AND_RETURN_HRESULT(hr, L"Texture::Load >> Loading from WIC file");
+		}
+
+		m_uSize = static_cast<UINT64>(pImage->GetPixelsSize());
+		m_pImage = std::move(pImage);
+
+		return hr;
+	}
+
+	HRESULT Texture::initialize(_In_ ID3D12Device* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList)
+	{
+		HRESULT hr = S_OK;
+
+		if (m_pTextureResource)
+		{
+			return hr;
+		}
+
+		hr = load();
+		if (FAILED(hr))
+		{
+			return hr;
 		}
 
+		const ScratchImage& image = *m_pImage;
+		const TexMetadata& metadata = image.GetMetadata();
+
 		//ID3D12Resource* pResource = nullptr;
 		hr = CreateTexture(pDevice, image.GetMetadata(), &m_pTextureResource);
 		CHECK_AND_RETURN_HRESULT(hr, L"Texture::Initialize >> Creating texture");
@@ -99,6 +141,66 @@ namespace pr
 			subresources.data()
 		);
 
+		// UpdateSubresources copied the texels into the upload heap
+		m_pImage.reset();
+
 		return hr;
 	}
+
+	HRESULT Texture::Save(_In_ const std::filesystem::path& filePath)
+	{
+		std::lock_guard<std::mutex> lock(m_ImageMutex);
+
+		// The image is freed once uploaded, so a texture that is already initialized decodes its file again
+		std::unique_ptr<ScratchImage> pImage;
+		const ScratchImage* pSource = m_pImage.get();
+		if (!pSource)
+		{
+			Texture texture(m_filePath);
+			HRESULT hr = texture.Load();
+			if (FAILED(hr))
+			{
+				return hr;
+			}
+
+			pImage = std::move(texture.m_pImage);
+			pSource = pImage.get();
+		}
+
+		HRESULT hr = SaveToDDSFile(pSource->GetImages(), pSource->GetImageCount(), pSource->GetMetadata(), DDS_FLAGS_NONE, filePath.c_str());
+		CHECK_AND_RETURN_HRESULT(hr, L"Texture::Save >> Saving to DDS file");
+
+		return hr;
+	}
+
+	void Texture::Release()
+	{
+		std::lock_guard<std::mutex> lock(m_ImageMutex);
+
+		m_pImage.reset();
+		m_pTextureResource.Reset();
+		m_pTextureUploadHeap.Reset();
+	}
+
+	const std::filesystem::path& Texture::GetFilePath() const noexcept
+	{
+		return m_filePath;
+	}
+
+	UINT64 Texture::GetSize() const
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_ImageMutex);
+			if (m_uSize > 0u)
+			{
+				return m_uSize;
+			}
+		}
+
+		// Cooked textures are uncompressed, so their files are about the size of the texels
+		std::error_code error;
+		UINT64 uFileSize = static_cast<UINT64>(std::filesystem::file_size(m_filePath, error));
+
+		return error ? 0u : uFileSize;
+	}
 }
\ No newline at end of file
@@ -12,6 +12,11 @@
 
 #include "pch.h"
 
+namespace DirectX
+{
+	class ScratchImage;
+}
+
 namespace pr
 {
 	class Texture
@@ -23,16 +28,35 @@ namespace pr
 		Texture(Texture&& other) = delete;
 		Texture& operator=(const Texture& other) = delete;
 		Texture& operator=(Texture&& other) = delete;
-		virtual ~Texture() = default;
+		virtual ~Texture();
 
-		// Should be called once to load the texture
+		// Decodes the file on the CPU, safe to call from several worker threads before Initialize
+		HRESULT Load();
+		// Creates and uploads the texture once, loads it first if Load was not called
 		virtual HRESULT Initialize(_In_ ID3D12Device* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList);
+		// Writes the decoded texture as a DDS file, which later loads without decoding
+		HRESULT Save(_In_ const std::filesystem::path& filePath);
+		// Frees the image and the resource, Load and Initialize bring them back
+		void Release();
+
+		const std::filesystem::path& GetFilePath() const noexcept;
+		// Bytes of the texels once loaded, the size of the file before
+		UINT64 GetSize() const;
 
 		//ComPtr<ID3D11ShaderResourceView>& GetTextureResourceView();
 		//ComPtr<ID3D11SamplerState>& GetSamplerState();
 
+	private:
+		// Both expect m_ImageMutex to be locked
+		HRESULT load();
+		HRESULT initialize(_In_ ID3D12Device* pDevice, _In_ ID3D12GraphicsCommandList2* pCommandList);
+
 	private:
 		std::filesystem::path m_filePath;
+		// Decoded image between Load and the upload recorded by Initialize
+		std::unique_ptr<ScratchImage> m_pImage;
+		mutable std::mutex m_ImageMutex;
+		UINT64 m_uSize;
 		//ComPtr<ID3D11ShaderResourceView> m_textureRV;
 		//ComPtr<ID3D11SamplerState> m_samplerLinear;
 		ComPtr<ID3D12Resource> m_pTextureResource;
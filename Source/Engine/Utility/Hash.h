@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstring>
+
+#include "Utility/Types.h"
+
+namespace pr
+{
+	// MurmurHash64A, eight bytes per step. Used for content keys that are persisted, so the result must not
+	// depend on the platform or on std::hash.
+	inline UINT64 HashBytes(_In_reads_bytes_(uSize) const void* pData, _In_ size_t uSize, _In_ UINT64 uSeed = 0u) noexcept
+	{
+		constexpr const UINT64 M = 0xc6a4a7935bd1e995ull;
+		constexpr const INT R = 47;
+
+		const BYTE* pBytes = static_cast<const BYTE*>(pData);
+		UINT64 uHash = uSeed ^ (static_cast<UINT64>(uSize) * M);
+
+		size_t uNumBlocks = uSize / sizeof(UINT64);
+		for (size_t i = 0; i < uNumBlocks; ++i)
+		{
+			UINT64 uBlock;
+			memcpy(&uBlock, pBytes + i * sizeof(UINT64), sizeof(UINT64));
+
+			uBlock *= M;
+			uBlock ^= uBlock >> R;
+			uBlock *= M;
+
+			uHash ^= uBlock;
+			uHash *= M;
+		}
+
+		const BYTE* pTail = pBytes + uNumBlocks * sizeof(UINT64);
+		size_t uTailSize = uSize & (sizeof(UINT64) - 1u);
+		if (uTailSize > 0u)
+		{
+			for (size_t i = uTailSize; i > 0u; --i)
+			{
+				uHash ^= static_cast<UINT64>(pTail[i - 1u]) << (8u * (i - 1u));
+			}
+			uHash *= M;
+		}
+
+		uHash ^= uHash >> R;
+		uHash *= M;
+		uHash ^= uHash >> R;
+
+		return uHash;
+	}
+
+	inline constexpr UINT64 HashCombine(_In_ UINT64 uSeed, _In_ UINT64 uValue) noexcept
+	{
+		return uSeed ^ (uValue + 0x9e3779b97f4a7c15ull + (uSeed << 6) + (uSeed >> 2));
+	}
+}
@@ -0,0 +1,176 @@
+#include "pch.h"
+
+#include "Utility/JobSystem.h"
+
+namespace pr
+{
+	JobSystem& JobSystem::GetInstance() noexcept
+	{
+		static JobSystem s_JobSystem;
+		return s_JobSystem;
+	}
+
+	JobSystem::JobSystem() noexcept
+		: JobSystem(std::max(std::thread::hardware_concurrency(), 2u) - 1u)
+	{
+	}
+
+	JobSystem::JobSystem(_In_ UINT uNumWorkers) noexcept
+		: m_aWorkers()
+		, m_Jobs()
+		, m_BackgroundJobs()
+		, m_Mutex()
+		, m_ConditionVariable()
+		, m_bIsRunning(TRUE)
+	{
+		m_aWorkers.reserve(uNumWorkers);
+		for (UINT i = 0u; i < uNumWorkers; ++i)
+		{
+			m_aWorkers.emplace_back(&JobSystem::workerMain, this);
+		}
+	}
+
+	JobSystem::~JobSystem() noexcept
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_bIsRunning = FALSE;
+		}
+		m_ConditionVariable.notify_all();
+
+		for (std::thread& worker : m_aWorkers)
+		{
+			worker.join();
+		}
+	}
+
+	UINT JobSystem::GetNumThreads() const noexcept
+	{
+		return static_cast<UINT>(m_aWorkers.size()) + 1u;
+	}
+
+	void JobSystem::ParallelFor(_In_ UINT uNumItems, _In_ UINT uGrainSize, _In_ const std::function<void(UINT uBegin, UINT uEnd)>& function)
+	{
+		if (uNumItems == 0u)
+		{
+			return;
+		}
+
+		uGrainSize = std::max(uGrainSize, 1u);
+		UINT uNumJobs = std::min((uNumItems + uGrainSize - 1u) / uGrainSize, GetNumThreads() * 4u);
+		if (uNumJobs <= 1u || m_aWorkers.empty())
+		{
+			function(0u, uNumItems);
+			return;
+		}
+
+		std::atomic<UINT> uNumPendingJobs = uNumJobs;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			for (UINT i = 0u; i < uNumJobs; ++i)
+			{
+				UINT uBegin = static_cast<UINT>(static_cast<UINT64>(uNumItems) * i / uNumJobs);
+				UINT uEnd = static_cast<UINT>(static_cast<UINT64>(uNumItems) * (i + 1u) / uNumJobs);
+				m_Jobs.push_back(
+					Job
+					{
+						.Function = [&function, uBegin, uEnd]() { function(uBegin, uEnd); },
+						.puNumPendingJobs = &uNumPendingJobs,
+					}
+				);
+			}
+		}
+		m_ConditionVariable.notify_all();
+
+		while (uNumPendingJobs.load(std::memory_order_acquire) > 0u)
+		{
+			if (!tryRunJob())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::Schedule(_In_ std::function<void()> function)
+	{
+		if (m_aWorkers.empty())
+		{
+			function();
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_BackgroundJobs.push_back(
+				Job
+				{
+					.Function = std::move(function),
+					.puNumPendingJobs = nullptr,
+				}
+			);
+		}
+		m_ConditionVariable.notify_one();
+	}
+
+	BOOL JobSystem::tryRunJob() noexcept
+	{
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Jobs.empty())
+			{
+				return FALSE;
+			}
+
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+		}
+
+		runJob(job);
+
+		return TRUE;
+	}
+
+	void JobSystem::runJob(_In_ Job& job) noexcept
+	{
+		job.Function();
+		if (job.puNumPendingJobs)
+		{
+			job.puNumPendingJobs->fetch_sub(1u, std::memory_order_release);
+		}
+	}
+
+	void JobSystem::workerMain() noexcept
+	{
+#if defined(_WIN32)
+		// Jobs decode textures through WIC, which needs COM on the calling thread
+		const HRESULT hrCom = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+
+		for (;;)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_ConditionVariable.wait(lock, [this]() { return !m_bIsRunning || !m_Jobs.empty() || !m_BackgroundJobs.empty(); });
+				if (!m_bIsRunning && m_Jobs.empty() && m_BackgroundJobs.empty())
+				{
+					break;
+				}
+
+				std::deque<Job>& jobs = m_Jobs.empty() ? m_BackgroundJobs : m_Jobs;
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+
+			runJob(job);
+		}
+
+#if defined(_WIN32)
+		if (SUCCEEDED(hrCom))
+		{
+			CoUninitialize();
+		}
+#endif
+	}
+}
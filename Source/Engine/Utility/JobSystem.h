@@ -0,0 +1,58 @@
+#pragma once
+
+#include "pch.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <thread>
+
+namespace pr
+{
+	class JobSystem final
+	{
+	public:
+		static JobSystem& GetInstance() noexcept;
+
+	public:
+		explicit JobSystem() noexcept;
+		explicit JobSystem(_In_ UINT uNumWorkers) noexcept;
+		JobSystem(const JobSystem& other) = delete;
+		JobSystem(JobSystem&& other) = delete;
+		JobSystem& operator=(const JobSystem& other) = delete;
+		JobSystem& operator=(JobSystem&& other) = delete;
+		~JobSystem() noexcept;
+
+		// Number of threads that execute jobs, including the calling thread
+		UINT GetNumThreads() const noexcept;
+
+		// Splits [0, uNumItems) into ranges of at least uGrainSize items and blocks until all of them ran.
+		// The calling thread executes jobs while it waits, so nested calls from jobs are allowed.
+		void ParallelFor(_In_ UINT uNumItems, _In_ UINT uGrainSize, _In_ const std::function<void(UINT uBegin, UINT uEnd)>& function);
+
+		// Queues a long running job that only the workers pick up, after any ParallelFor jobs, so it never
+		// stalls a thread that waits in ParallelFor. The caller tracks its completion.
+		void Schedule(_In_ std::function<void()> function);
+
+	private:
+		struct Job
+		{
+			std::function<void()> Function;
+			std::atomic<UINT>* puNumPendingJobs;
+		};
+
+	private:
+		BOOL tryRunJob() noexcept;
+		void runJob(_In_ Job& job) noexcept;
+		void workerMain() noexcept;
+
+	private:
+		std::vector<std::thread> m_aWorkers;
+		std::deque<Job> m_Jobs;
+		std::deque<Job> m_BackgroundJobs;
+		std::mutex m_Mutex;
+		std::condition_variable m_ConditionVariable;
+		BOOL m_bIsRunning;
+	};
+}
@@ -0,0 +1,115 @@
+#include "pch.h"
+
+#include "Utility/MappedFile.h"
+
+#include "Utility/Utility.h"
+
+namespace pr
+{
+	namespace
+	{
+		constexpr const size_t MAPPED_PAGE_SIZE = 4096u;
+	}
+
+	MappedFile::MappedFile() noexcept
+		: m_hFile(INVALID_HANDLE_VALUE)
+		, m_hMapping(nullptr)
+		, m_pData(nullptr)
+		, m_uSize(0)
+	{
+	}
+
+	MappedFile::~MappedFile() noexcept
+	{
+		Release();
+	}
+
+	HRESULT MappedFile::Initialize(_In_ const std::filesystem::path& filePath, _In_ BOOL bSequential)
+	{
+		HRESULT hr = S_OK;
+
+		Release();
+
+		m_hFile = CreateFileW(
+			filePath.c_str(),
+			GENERIC_READ,
+			FILE_SHARE_READ,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | (bSequential ? FILE_FLAG_SEQUENTIAL_SCAN : 0u),
+			nullptr
+		);
+		if (m_hFile == INVALID_HANDLE_VALUE)
+		{
+			return HRESULT_FROM_WIN32(GetLastError());
+		}
+
+		LARGE_INTEGER fileSize = {};
+		if (!GetFileSizeEx(m_hFile, &fileSize))
+		{
+			hr = HRESULT_FROM_WIN32(GetLastError());
+			Release();
+			CHECK_AND_RETURN_HRESULT(hr, L"MappedFile::Initialize >> Getting file size");
+		}
+
+		m_hMapping = CreateFileMappingW(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_hMapping)
+		{
+			hr = HRESULT_FROM_WIN32(GetLastError());
+			Release();
+			CHECK_AND_RETURN_HRESULT(hr, L"MappedFile::Initialize >> Creating file mapping");
+		}
+
+		m_pData = static_cast<const BYTE*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+		if (!m_pData)
+		{
+			hr = HRESULT_FROM_WIN32(GetLastError());
+			Release();
+			CHECK_AND_RETURN_HRESULT(hr, L"MappedFile::Initialize >> Mapping file");
+		}
+		m_uSize = static_cast<size_t>(fileSize.QuadPart);
+
+		return hr;
+	}
+
+	void MappedFile::Release() noexcept
+	{
+		if (m_pData)
+		{
+			UnmapViewOfFile(m_pData);
+			m_pData = nullptr;
+		}
+		m_uSize = 0;
+
+		if (m_hMapping)
+		{
+			CloseHandle(m_hMapping);
+			m_hMapping = nullptr;
+		}
+
+		if (m_hFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_hFile);
+			m_hFile = INVALID_HANDLE_VALUE;
+		}
+	}
+
+	void MappedFile::Prefetch() const noexcept
+	{
+		const volatile BYTE* pBytes = m_pData;
+		for (size_t i = 0; i < m_uSize; i += MAPPED_PAGE_SIZE)
+		{
+			static_cast<void>(pBytes[i]);
+		}
+	}
+
+	const BYTE* MappedFile::GetData() const noexcept
+	{
+		return m_pData;
+	}
+
+	size_t MappedFile::GetSize() const noexcept
+	{
+		return m_uSize;
+	}
+}
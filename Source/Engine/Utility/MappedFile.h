@@ -0,0 +1,34 @@
+#pragma once
+
+#include "pch.h"
+
+namespace pr
+{
+	// Read only mapping of a whole file, the data stays valid until the file is released or the object destroyed.
+	// Opening a missing file fails silently, so optional files such as caches can be probed with it.
+	class MappedFile final
+	{
+	public:
+		explicit MappedFile() noexcept;
+		MappedFile(const MappedFile& other) = delete;
+		MappedFile(MappedFile&& other) = delete;
+		MappedFile& operator=(const MappedFile& other) = delete;
+		MappedFile& operator=(MappedFile&& other) = delete;
+		~MappedFile() noexcept;
+
+		// Sequential access hints the system to read ahead, for files read front to back once
+		HRESULT Initialize(_In_ const std::filesystem::path& filePath, _In_ BOOL bSequential);
+		void Release() noexcept;
+		// Touches every page, so the disk is read on the calling thread and not by whoever reads the data next
+		void Prefetch() const noexcept;
+
+		const BYTE* GetData() const noexcept;
+		size_t GetSize() const noexcept;
+
+	private:
+		HANDLE m_hFile;
+		HANDLE m_hMapping;
+		const BYTE* m_pData;
+		size_t m_uSize;
+	};
+}
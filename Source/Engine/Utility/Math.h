@@ -1,10 +1,12 @@
 #pragma once
 
+#include <cstddef>
+
 namespace pr
 {
 	inline constexpr size_t AlignUpWithMask(size_t value, size_t mask) noexcept
 	{
-		return value & ~mask;
+		return (value + mask) & ~mask;
 	}
 
 	inline constexpr size_t AlignUp(size_t value, size_t alignment) noexcept
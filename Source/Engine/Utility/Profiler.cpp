@@ -0,0 +1,314 @@
+#include "Utility/Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace pr
+{
+	namespace
+	{
+		// Innermost open scope of the calling thread, valid for tl_uFrameNumber only
+		thread_local UINT tl_uCurrentScope = Profiler::INVALID_INDEX;
+		thread_local UINT64 tl_uFrameNumber = 0u;
+		thread_local UINT tl_uThread = Profiler::INVALID_INDEX;
+	}
+
+	Profiler& Profiler::GetInstance() noexcept
+	{
+		static Profiler s_Profiler;
+		return s_Profiler;
+	}
+
+	UINT64 Profiler::GetCpuTicks() noexcept
+	{
+		return static_cast<UINT64>(std::chrono::steady_clock::now().time_since_epoch().count());
+	}
+
+	DOUBLE Profiler::GetCpuTicksPerSecond() noexcept
+	{
+		return static_cast<DOUBLE>(std::chrono::steady_clock::period::den) / static_cast<DOUBLE>(std::chrono::steady_clock::period::num);
+	}
+
+	Profiler::Profiler() noexcept
+		: m_aFrames()
+		, m_aaNodes()
+		, m_aEventNodes()
+		, m_aFrameMs()
+		, m_aFrameCalls()
+		, m_uFrameNumber(0u)
+		, m_uNumThreads(0u)
+	{
+		for (FrameData& frame : m_aFrames)
+		{
+			frame.aEvents.resize(MAX_SCOPES_PER_FRAME);
+			frame.uNumEvents = 0u;
+			frame.uBegin = 0u;
+			frame.uEnd = 0u;
+		}
+
+		Reset();
+	}
+
+	void Profiler::BeginFrame() noexcept
+	{
+		UINT64 uFrameNumber = m_uFrameNumber.fetch_add(1u) + 1u;
+		FrameData& frame = m_aFrames[uFrameNumber % NUM_FRAMES];
+
+		frame.uNumEvents = 0u;
+		frame.uBegin = GetCpuTicks();
+		frame.uEnd = frame.uBegin;
+
+		tl_uCurrentScope = INVALID_INDEX;
+		tl_uFrameNumber = uFrameNumber;
+	}
+
+	void Profiler::EndFrame() noexcept
+	{
+		FrameData& frame = m_aFrames[m_uFrameNumber % NUM_FRAMES];
+		frame.uEnd = GetCpuTicks();
+
+		DOUBLE ticksPerSecond = GetCpuTicksPerSecond();
+		DOUBLE frameMs = static_cast<DOUBLE>(frame.uEnd - frame.uBegin) * 1000.0 / ticksPerSecond;
+		UINT uNumEvents = std::min(frame.uNumEvents.load(), MAX_SCOPES_PER_FRAME);
+
+		resolve(eTimeline::CPU, frame.aEvents.data(), uNumEvents, ticksPerSecond, frameMs);
+	}
+
+	UINT Profiler::BeginCpuScope(_In_ PCSTR pszName) noexcept
+	{
+		UINT64 uFrameNumber = m_uFrameNumber.load();
+		if (tl_uFrameNumber != uFrameNumber)
+		{
+			tl_uCurrentScope = INVALID_INDEX;
+			tl_uFrameNumber = uFrameNumber;
+		}
+
+		if (tl_uThread == INVALID_INDEX)
+		{
+			tl_uThread = m_uNumThreads.fetch_add(1u);
+		}
+
+		FrameData& frame = m_aFrames[uFrameNumber % NUM_FRAMES];
+		UINT uScope = frame.uNumEvents.fetch_add(1u);
+		if (uScope >= MAX_SCOPES_PER_FRAME)
+		{
+			return INVALID_INDEX;
+		}
+
+		ScopeEvent& event = frame.aEvents[uScope];
+		event.pszName = pszName;
+		event.uParent = tl_uCurrentScope;
+		event.uThread = tl_uThread;
+		event.uEnd = 0u;
+		event.uBegin = GetCpuTicks();
+
+		tl_uCurrentScope = uScope;
+
+		return uScope;
+	}
+
+	void Profiler::EndCpuScope(_In_ UINT uScope) noexcept
+	{
+		UINT64 uEnd = GetCpuTicks();
+
+		// Scopes must not straddle BeginFrame / EndFrame
+		if (uScope == INVALID_INDEX || tl_uFrameNumber != m_uFrameNumber.load())
+		{
+			return;
+		}
+
+		ScopeEvent& event = m_aFrames[tl_uFrameNumber % NUM_FRAMES].aEvents[uScope];
+		event.uEnd = uEnd;
+		tl_uCurrentScope = event.uParent;
+	}
+
+	void Profiler::ResolveGpuFrame(_In_ const ScopeEvent* aEvents, _In_ UINT uNumEvents, _In_ DOUBLE ticksPerSecond) noexcept
+	{
+		UINT64 uBegin = UINT64_MAX;
+		UINT64 uEnd = 0u;
+		for (UINT i = 0u; i < uNumEvents; ++i)
+		{
+			uBegin = std::min(uBegin, aEvents[i].uBegin);
+			uEnd = std::max(uEnd, aEvents[i].uEnd);
+		}
+
+		DOUBLE frameMs = uEnd > uBegin ? static_cast<DOUBLE>(uEnd - uBegin) * 1000.0 / ticksPerSecond : 0.0;
+		resolve(eTimeline::GPU, aEvents, uNumEvents, ticksPerSecond, frameMs);
+	}
+
+	const std::vector<Profiler::Node>& Profiler::GetNodes(_In_ eTimeline timeline) const noexcept
+	{
+		return m_aaNodes[static_cast<size_t>(timeline)];
+	}
+
+	UINT64 Profiler::GetFrameNumber() const noexcept
+	{
+		return m_uFrameNumber.load();
+	}
+
+	std::string Profiler::FormatReport() const
+	{
+		std::string szReport;
+		szReport += "[CPU]\n";
+		formatNode(szReport, eTimeline::CPU, ROOT_NODE);
+		if (GetNodes(eTimeline::GPU)[ROOT_NODE].uNumFrames > 0u)
+		{
+			szReport += "[GPU]\n";
+			formatNode(szReport, eTimeline::GPU, ROOT_NODE);
+		}
+
+		return szReport;
+	}
+
+	void Profiler::Reset() noexcept
+	{
+		static constexpr const PCSTR ROOT_NAMES[] =
+		{
+			"Frame (CPU)",
+			"Frame (GPU)",
+		};
+
+		for (size_t i = 0; i < static_cast<size_t>(eTimeline::COUNT); ++i)
+		{
+			m_aaNodes[i].clear();
+			m_aaNodes[i].push_back(
+				Node
+				{
+					.pszName = ROOT_NAMES[i],
+					.uParent = INVALID_INDEX,
+					.uFirstChild = INVALID_INDEX,
+					.uNextSibling = INVALID_INDEX,
+					.uDepth = 0u,
+					.uNumCalls = 0u,
+					.uNumFrames = 0u,
+					.LastMs = 0.0,
+					.MinMs = DBL_MAX,
+					.MaxMs = 0.0,
+					.TotalMs = 0.0,
+				}
+			);
+		}
+	}
+
+	void Profiler::resolve(_In_ eTimeline timeline, _In_ const ScopeEvent* aEvents, _In_ UINT uNumEvents, _In_ DOUBLE ticksPerSecond, _In_ DOUBLE frameMs) noexcept
+	{
+		std::vector<Node>& aNodes = m_aaNodes[static_cast<size_t>(timeline)];
+
+		m_aEventNodes.resize(uNumEvents);
+		m_aFrameMs.assign(aNodes.size(), 0.0);
+		m_aFrameCalls.assign(aNodes.size(), 0u);
+
+		m_aFrameMs[ROOT_NODE] = frameMs;
+		m_aFrameCalls[ROOT_NODE] = 1u;
+
+		// A parent always begins before its children, so its event index is lower
+		for (UINT i = 0u; i < uNumEvents; ++i)
+		{
+			const ScopeEvent& event = aEvents[i];
+			UINT uParentNode = event.uParent < i ? m_aEventNodes[event.uParent] : ROOT_NODE;
+			UINT uNode = findOrAddChild(timeline, uParentNode, event.pszName);
+			m_aEventNodes[i] = uNode;
+
+			if (uNode >= m_aFrameMs.size())
+			{
+				m_aFrameMs.resize(aNodes.size(), 0.0);
+				m_aFrameCalls.resize(aNodes.size(), 0u);
+			}
+
+			// Unclosed scopes still anchor their children but contribute no time
+			if (event.uEnd >= event.uBegin)
+			{
+				m_aFrameMs[uNode] += static_cast<DOUBLE>(event.uEnd - event.uBegin) * 1000.0 / ticksPerSecond;
+				++m_aFrameCalls[uNode];
+			}
+		}
+
+		for (size_t i = 0; i < aNodes.size(); ++i)
+		{
+			Node& node = aNodes[i];
+			node.uNumCalls = m_aFrameCalls[i];
+			node.LastMs = m_aFrameMs[i];
+			if (node.uNumCalls > 0u)
+			{
+				++node.uNumFrames;
+				node.MinMs = std::min(node.MinMs, node.LastMs);
+				node.MaxMs = std::max(node.MaxMs, node.LastMs);
+				node.TotalMs += node.LastMs;
+			}
+		}
+	}
+
+	UINT Profiler::findOrAddChild(_In_ eTimeline timeline, _In_ UINT uParent, _In_ PCSTR pszName)
+	{
+		std::vector<Node>& aNodes = m_aaNodes[static_cast<size_t>(timeline)];
+
+		UINT uLastChild = INVALID_INDEX;
+		for (UINT uChild = aNodes[uParent].uFirstChild; uChild != INVALID_INDEX; uChild = aNodes[uChild].uNextSibling)
+		{
+			if (aNodes[uChild].pszName == pszName || strcmp(aNodes[uChild].pszName, pszName) == 0)
+			{
+				return uChild;
+			}
+			uLastChild = uChild;
+		}
+
+		UINT uNode = static_cast<UINT>(aNodes.size());
+		aNodes.push_back(
+			Node
+			{
+				.pszName = pszName,
+				.uParent = uParent,
+				.uFirstChild = INVALID_INDEX,
+				.uNextSibling = INVALID_INDEX,
+				.uDepth = aNodes[uParent].uDepth + 1u,
+				.uNumCalls = 0u,
+				.uNumFrames = 0u,
+				.LastMs = 0.0,
+				.MinMs = DBL_MAX,
+				.MaxMs = 0.0,
+				.TotalMs = 0.0,
+			}
+		);
+
+		if (uLastChild == INVALID_INDEX)
+		{
+			aNodes[uParent].uFirstChild = uNode;
+		}
+		else
+		{
+			aNodes[uLastChild].uNextSibling = uNode;
+		}
+
+		return uNode;
+	}
+
+	void Profiler::formatNode(_Inout_ std::string& szReport, _In_ eTimeline timeline, _In_ UINT uNode) const
+	{
+		const std::vector<Node>& aNodes = GetNodes(timeline);
+		const Node& node = aNodes[uNode];
+
+		if (node.uNumFrames > 0u)
+		{
+			CHAR szLine[256];
+			snprintf(
+				szLine,
+				sizeof(szLine),
+				"%*s%-*s min %8.3f ms  avg %8.3f ms  max %8.3f ms  calls %u\n",
+				static_cast<INT>(node.uDepth * 2u),
+				"",
+				static_cast<INT>(40u - std::min(node.uDepth * 2u, 32u)),
+				node.pszName,
+				node.MinMs,
+				node.TotalMs / static_cast<DOUBLE>(node.uNumFrames),
+				node.MaxMs,
+				node.uNumCalls
+			);
+			szReport += szLine;
+		}
+
+		for (UINT uChild = node.uFirstChild; uChild != INVALID_INDEX; uChild = aNodes[uChild].uNextSibling)
+		{
+			formatNode(szReport, timeline, uChild);
+		}
+	}
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Utility/Types.h"
+
+// Set to 0 in the preprocessor definitions to compile every profiling
+// scope out of the engine
+#ifndef PR_ENABLE_PROFILING
+#define PR_ENABLE_PROFILING 1
+#endif
+
+namespace pr
+{
+	class Profiler final
+	{
+	public:
+		enum class eTimeline : BYTE
+		{
+			CPU,
+			GPU,
+			COUNT,
+		};
+
+		// Raw timestamps of a single scope instance, in timeline ticks
+		struct ScopeEvent
+		{
+			PCSTR pszName;
+			UINT64 uBegin;
+			UINT64 uEnd;
+			UINT uParent;
+			UINT uThread;
+		};
+
+		// Resolved per-scope tree node. Sibling scopes with the same name are merged
+		struct Node
+		{
+			PCSTR pszName;
+			UINT uParent;
+			UINT uFirstChild;
+			UINT uNextSibling;
+			UINT uDepth;
+			UINT uNumCalls;
+			UINT64 uNumFrames;
+			DOUBLE LastMs;
+			DOUBLE MinMs;
+			DOUBLE MaxMs;
+			DOUBLE TotalMs;
+		};
+
+		static constexpr const size_t NUM_FRAMES = 3;
+		static constexpr const UINT MAX_SCOPES_PER_FRAME = 4096u;
+		static constexpr const UINT INVALID_INDEX = 0xFFFFFFFF;
+		static constexpr const UINT ROOT_NODE = 0u;
+
+	public:
+		static Profiler& GetInstance() noexcept;
+		static UINT64 GetCpuTicks() noexcept;
+		static DOUBLE GetCpuTicksPerSecond() noexcept;
+
+	public:
+		explicit Profiler() noexcept;
+		Profiler(const Profiler& other) = delete;
+		Profiler(Profiler&& other) = delete;
+		Profiler& operator=(const Profiler& other) = delete;
+		Profiler& operator=(Profiler&& other) = delete;
+		~Profiler() noexcept = default;
+
+		void BeginFrame() noexcept;
+		void EndFrame() noexcept;
+
+		UINT BeginCpuScope(_In_ PCSTR pszName) noexcept;
+		void EndCpuScope(_In_ UINT uScope) noexcept;
+
+		void ResolveGpuFrame(_In_ const ScopeEvent* aEvents, _In_ UINT uNumEvents, _In_ DOUBLE ticksPerSecond) noexcept;
+
+		const std::vector<Node>& GetNodes(_In_ eTimeline timeline) const noexcept;
+		UINT64 GetFrameNumber() const noexcept;
+		std::string FormatReport() const;
+		void Reset() noexcept;
+
+	private:
+		struct FrameData
+		{
+			std::vector<ScopeEvent> aEvents;
+			std::atomic<UINT> uNumEvents;
+			UINT64 uBegin;
+			UINT64 uEnd;
+		};
+
+	private:
+		void resolve(_In_ eTimeline timeline, _In_ const ScopeEvent* aEvents, _In_ UINT uNumEvents, _In_ DOUBLE ticksPerSecond, _In_ DOUBLE frameMs) noexcept;
+		UINT findOrAddChild(_In_ eTimeline timeline, _In_ UINT uParent, _In_ PCSTR pszName);
+		void formatNode(_Inout_ std::string& szReport, _In_ eTimeline timeline, _In_ UINT uNode) const;
+
+	private:
+		FrameData m_aFrames[NUM_FRAMES];
+		std::vector<Node> m_aaNodes[static_cast<size_t>(eTimeline::COUNT)];
+		std::vector<UINT> m_aEventNodes;
+		std::vector<DOUBLE> m_aFrameMs;
+		std::vector<UINT> m_aFrameCalls;
+		std::atomic<UINT64> m_uFrameNumber;
+		std::atomic<UINT> m_uNumThreads;
+	};
+
+	class ProfileScope final
+	{
+	public:
+		explicit ProfileScope(_In_ PCSTR pszName) noexcept
+			: m_uScope(Profiler::GetInstance().BeginCpuScope(pszName))
+		{
+		}
+		ProfileScope(const ProfileScope& other) = delete;
+		ProfileScope(ProfileScope&& other) = delete;
+		ProfileScope& operator=(const ProfileScope& other) = delete;
+		ProfileScope& operator=(ProfileScope&& other) = delete;
+		~ProfileScope() noexcept
+		{
+			Profiler::GetInstance().EndCpuScope(m_uScope);
+		}
+
+	private:
+		UINT m_uScope;
+	};
+}
+
+#define PR_PROFILE_CONCAT_INNER(a, b) a##b
+#define PR_PROFILE_CONCAT(a, b) PR_PROFILE_CONCAT_INNER(a, b)
+
+#if PR_ENABLE_PROFILING
+#define PR_PROFILE_SCOPE(pszName) pr::ProfileScope PR_PROFILE_CONCAT(profileScope, __LINE__)(pszName)
+#define PR_PROFILE_FUNCTION() PR_PROFILE_SCOPE(__FUNCTION__)
+#define PR_PROFILE_BEGIN_FRAME() pr::Profiler::GetInstance().BeginFrame()
+#define PR_PROFILE_END_FRAME() pr::Profiler::GetInstance().EndFrame()
+#else
+#define PR_PROFILE_SCOPE(pszName) ((void)0)
+#define PR_PROFILE_FUNCTION() ((void)0)
+#define PR_PROFILE_BEGIN_FRAME() ((void)0)
+#define PR_PROFILE_END_FRAME() ((void)0)
+#endif
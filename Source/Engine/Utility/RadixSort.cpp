@@ -0,0 +1,171 @@
+#include "pch.h"
+
+#include "Utility/RadixSort.h"
+
+#include "Utility/JobSystem.h"
+
+namespace pr
+{
+	namespace
+	{
+		constexpr const UINT RADIX_BITS = 8u;
+		constexpr const UINT NUM_BUCKETS = 1u << RADIX_BITS;
+		constexpr const UINT NUM_PASSES = 64u / RADIX_BITS;
+		constexpr const UINT MIN_ITEMS_PER_CHUNK = 4096u;
+
+		inline UINT getDigit(_In_ UINT64 uKey, _In_ UINT uPass) noexcept
+		{
+			return static_cast<UINT>(uKey >> (uPass * RADIX_BITS)) & (NUM_BUCKETS - 1u);
+		}
+
+		// Bits that differ between at least two keys; passes over constant digits can be skipped
+		UINT64 getVaryingBits(_In_ const SortItem* aItems, _In_ UINT uBegin, _In_ UINT uEnd, _In_ UINT64 uReferenceKey) noexcept
+		{
+			UINT64 uVaryingBits = 0u;
+			for (UINT i = uBegin; i < uEnd; ++i)
+			{
+				uVaryingBits |= aItems[i].uKey ^ uReferenceKey;
+			}
+
+			return uVaryingBits;
+		}
+	}
+
+	void RadixSort(_Inout_ SortItem* aItems, _Inout_ SortItem* aScratch, _In_ UINT uNumItems) noexcept
+	{
+		if (uNumItems < 2u)
+		{
+			return;
+		}
+
+		UINT64 uVaryingBits = getVaryingBits(aItems, 0u, uNumItems, aItems[0].uKey);
+
+		SortItem* pSource = aItems;
+		SortItem* pDestination = aScratch;
+		for (UINT uPass = 0u; uPass < NUM_PASSES; ++uPass)
+		{
+			if (getDigit(uVaryingBits, uPass) == 0u)
+			{
+				continue;
+			}
+
+			UINT auOffsets[NUM_BUCKETS] = {};
+			for (UINT i = 0u; i < uNumItems; ++i)
+			{
+				++auOffsets[getDigit(pSource[i].uKey, uPass)];
+			}
+
+			UINT uSum = 0u;
+			for (UINT uBucket = 0u; uBucket < NUM_BUCKETS; ++uBucket)
+			{
+				UINT uCount = auOffsets[uBucket];
+				auOffsets[uBucket] = uSum;
+				uSum += uCount;
+			}
+
+			for (UINT i = 0u; i < uNumItems; ++i)
+			{
+				pDestination[auOffsets[getDigit(pSource[i].uKey, uPass)]++] = pSource[i];
+			}
+
+			std::swap(pSource, pDestination);
+		}
+
+		if (pSource != aItems)
+		{
+			memcpy(aItems, pSource, sizeof(SortItem) * uNumItems);
+		}
+	}
+
+	void ParallelRadixSort(_Inout_ SortItem* aItems, _Inout_ SortItem* aScratch, _In_ UINT uNumItems, _In_ JobSystem& jobSystem)
+	{
+		UINT uNumChunks = std::min(jobSystem.GetNumThreads(), uNumItems / MIN_ITEMS_PER_CHUNK);
+		if (uNumChunks <= 1u)
+		{
+			RadixSort(aItems, aScratch, uNumItems);
+			return;
+		}
+
+		auto getChunkBegin = [uNumItems, uNumChunks](UINT uChunk)
+		{
+			return static_cast<UINT>(static_cast<UINT64>(uNumItems) * uChunk / uNumChunks);
+		};
+
+		std::vector<UINT64> auChunkVaryingBits(uNumChunks, 0u);
+		const UINT64 uReferenceKey = aItems[0].uKey;
+		jobSystem.ParallelFor(uNumChunks, 1u, [&](UINT uBegin, UINT uEnd)
+		{
+			for (UINT uChunk = uBegin; uChunk < uEnd; ++uChunk)
+			{
+				auChunkVaryingBits[uChunk] = getVaryingBits(aItems, getChunkBegin(uChunk), getChunkBegin(uChunk + 1u), uReferenceKey);
+			}
+		});
+
+		UINT64 uVaryingBits = 0u;
+		for (UINT64 uChunkVaryingBits : auChunkVaryingBits)
+		{
+			uVaryingBits |= uChunkVaryingBits;
+		}
+
+		// Per chunk bucket counts, turned into per chunk scatter offsets in place
+		std::vector<UINT> auOffsets(static_cast<size_t>(uNumChunks) * NUM_BUCKETS);
+
+		SortItem* pSource = aItems;
+		SortItem* pDestination = aScratch;
+		for (UINT uPass = 0u; uPass < NUM_PASSES; ++uPass)
+		{
+			if (getDigit(uVaryingBits, uPass) == 0u)
+			{
+				continue;
+			}
+
+			jobSystem.ParallelFor(uNumChunks, 1u, [&](UINT uBegin, UINT uEnd)
+			{
+				for (UINT uChunk = uBegin; uChunk < uEnd; ++uChunk)
+				{
+					UINT* auCounts = &auOffsets[static_cast<size_t>(uChunk) * NUM_BUCKETS];
+					std::fill(auCounts, auCounts + NUM_BUCKETS, 0u);
+					for (UINT i = getChunkBegin(uChunk), uChunkEnd = getChunkBegin(uChunk + 1u); i < uChunkEnd; ++i)
+					{
+						++auCounts[getDigit(pSource[i].uKey, uPass)];
+					}
+				}
+			});
+
+			// Bucket major, chunk minor exclusive prefix sum keeps the sort stable
+			UINT uSum = 0u;
+			for (UINT uBucket = 0u; uBucket < NUM_BUCKETS; ++uBucket)
+			{
+				for (UINT uChunk = 0u; uChunk < uNumChunks; ++uChunk)
+				{
+					UINT& uOffset = auOffsets[static_cast<size_t>(uChunk) * NUM_BUCKETS + uBucket];
+					UINT uCount = uOffset;
+					uOffset = uSum;
+					uSum += uCount;
+				}
+			}
+
+			jobSystem.ParallelFor(uNumChunks, 1u, [&](UINT uBegin, UINT uEnd)
+			{
+				for (UINT uChunk = uBegin; uChunk < uEnd; ++uChunk)
+				{
+					UINT* auChunkOffsets = &auOffsets[static_cast<size_t>(uChunk) * NUM_BUCKETS];
+					for (UINT i = getChunkBegin(uChunk), uChunkEnd = getChunkBegin(uChunk + 1u); i < uChunkEnd; ++i)
+					{
+						pDestination[auChunkOffsets[getDigit(pSource[i].uKey, uPass)]++] = pSource[i];
+					}
+				}
+			});
+
+			std::swap(pSource, pDestination);
+		}
+
+		if (pSource != aItems)
+		{
+			jobSystem.ParallelFor(uNumItems, MIN_ITEMS_PER_CHUNK, [&](UINT uBegin, UINT uEnd)
+			{
+				memcpy(aItems + uBegin, pSource + uBegin, sizeof(SortItem) * (uEnd - uBegin));
+			});
+		}
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "pch.h"
+
+namespace pr
+{
+	class JobSystem;
+
+	struct SortItem
+	{
+		UINT64 uKey;
+		UINT uValue;
+		UINT uPadding;
+	};
+	static_assert(sizeof(SortItem) == 16);
+
+	// Stable LSD radix sort on the 64-bit keys, 8 bits per pass. Passes on digits
+	// that are equal for every key are skipped. aScratch must hold uNumItems items.
+	void RadixSort(_Inout_ SortItem* aItems, _Inout_ SortItem* aScratch, _In_ UINT uNumItems) noexcept;
+	void ParallelRadixSort(_Inout_ SortItem* aItems, _Inout_ SortItem* aScratch, _In_ UINT uNumItems, _In_ JobSystem& jobSystem);
+}
@@ -0,0 +1,194 @@
+#include "pch.h"
+
+#include "Utility/RangeAllocator.h"
+
+namespace pr
+{
+	RangeAllocator::RangeAllocator() noexcept
+		: RangeAllocator(0u)
+	{
+	}
+
+	RangeAllocator::RangeAllocator(_In_ UINT uCapacity) noexcept
+		: m_FreeBlocksByOffset()
+		, m_FreeBlocksBySize()
+		, m_Allocations()
+		, m_uCapacity(0u)
+		, m_uUsedSize(0u)
+	{
+		Grow(uCapacity);
+	}
+
+	UINT RangeAllocator::Allocate(_In_ UINT uSize)
+	{
+		if (uSize == 0u)
+		{
+			return INVALID_OFFSET;
+		}
+
+		auto bySizeIter = m_FreeBlocksBySize.lower_bound(uSize);
+		if (bySizeIter == m_FreeBlocksBySize.end())
+		{
+			return INVALID_OFFSET;
+		}
+
+		UINT uOffset = bySizeIter->second;
+		UINT uBlockSize = bySizeIter->first;
+		eraseFreeBlock(m_FreeBlocksByOffset.find(uOffset));
+
+		if (uBlockSize > uSize)
+		{
+			insertFreeBlock(uOffset + uSize, uBlockSize - uSize);
+		}
+
+		m_Allocations.emplace(uOffset, uSize);
+		m_uUsedSize += uSize;
+
+		return uOffset;
+	}
+
+	void RangeAllocator::Free(_In_ UINT uOffset)
+	{
+		auto allocationIter = m_Allocations.find(uOffset);
+		assert(allocationIter != m_Allocations.end());
+
+		UINT uSize = allocationIter->second;
+		m_Allocations.erase(allocationIter);
+		m_uUsedSize -= uSize;
+
+		// Merge with the free neighbours on both sides
+		auto nextIter = m_FreeBlocksByOffset.lower_bound(uOffset);
+		if (nextIter != m_FreeBlocksByOffset.end() && nextIter->first == uOffset + uSize)
+		{
+			uSize += nextIter->second;
+			eraseFreeBlock(nextIter);
+		}
+
+		auto previousIter = m_FreeBlocksByOffset.lower_bound(uOffset);
+		if (previousIter != m_FreeBlocksByOffset.begin())
+		{
+			--previousIter;
+			if (previousIter->first + previousIter->second == uOffset)
+			{
+				uOffset = previousIter->first;
+				uSize += previousIter->second;
+				eraseFreeBlock(previousIter);
+			}
+		}
+
+		insertFreeBlock(uOffset, uSize);
+	}
+
+	void RangeAllocator::Grow(_In_ UINT uNewCapacity)
+	{
+		if (uNewCapacity <= m_uCapacity)
+		{
+			return;
+		}
+
+		UINT uOffset = m_uCapacity;
+		UINT uSize = uNewCapacity - m_uCapacity;
+
+		// Extend a free block that touches the old end
+		if (!m_FreeBlocksByOffset.empty())
+		{
+			auto lastIter = std::prev(m_FreeBlocksByOffset.end());
+			if (lastIter->first + lastIter->second == m_uCapacity)
+			{
+				uOffset = lastIter->first;
+				uSize += lastIter->second;
+				eraseFreeBlock(lastIter);
+			}
+		}
+
+		insertFreeBlock(uOffset, uSize);
+		m_uCapacity = uNewCapacity;
+	}
+
+	std::vector<RangeAllocator::Move> RangeAllocator::Defragment()
+	{
+		std::vector<Move> aMoves;
+
+		std::map<UINT, UINT> compactedAllocations;
+		UINT uDestinationOffset = 0u;
+		for (const auto& [uOffset, uSize] : m_Allocations)
+		{
+			if (uOffset != uDestinationOffset)
+			{
+				aMoves.push_back(
+					Move
+					{
+						.uSourceOffset = uOffset,
+						.uDestinationOffset = uDestinationOffset,
+						.uSize = uSize,
+					}
+				);
+			}
+
+			compactedAllocations.emplace_hint(compactedAllocations.end(), uDestinationOffset, uSize);
+			uDestinationOffset += uSize;
+		}
+
+		m_Allocations = std::move(compactedAllocations);
+		m_FreeBlocksByOffset.clear();
+		m_FreeBlocksBySize.clear();
+		if (uDestinationOffset < m_uCapacity)
+		{
+			insertFreeBlock(uDestinationOffset, m_uCapacity - uDestinationOffset);
+		}
+
+		return aMoves;
+	}
+
+	UINT RangeAllocator::GetCapacity() const noexcept
+	{
+		return m_uCapacity;
+	}
+
+	UINT RangeAllocator::GetUsedSize() const noexcept
+	{
+		return m_uUsedSize;
+	}
+
+	UINT RangeAllocator::GetNumFreeBlocks() const noexcept
+	{
+		return static_cast<UINT>(m_FreeBlocksByOffset.size());
+	}
+
+	UINT RangeAllocator::GetLargestFreeBlock() const noexcept
+	{
+		return m_FreeBlocksBySize.empty() ? 0u : std::prev(m_FreeBlocksBySize.end())->first;
+	}
+
+	UINT RangeAllocator::GetTrailingFreeSize() const noexcept
+	{
+		if (m_FreeBlocksByOffset.empty())
+		{
+			return 0u;
+		}
+
+		auto last = std::prev(m_FreeBlocksByOffset.end());
+		return last->first + last->second == m_uCapacity ? last->second : 0u;
+	}
+
+	void RangeAllocator::insertFreeBlock(_In_ UINT uOffset, _In_ UINT uSize)
+	{
+		m_FreeBlocksByOffset.emplace(uOffset, uSize);
+		m_FreeBlocksBySize.emplace(uSize, uOffset);
+	}
+
+	void RangeAllocator::eraseFreeBlock(_In_ std::map<UINT, UINT>::iterator iter)
+	{
+		auto range = m_FreeBlocksBySize.equal_range(iter->second);
+		for (auto bySizeIter = range.first; bySizeIter != range.second; ++bySizeIter)
+		{
+			if (bySizeIter->second == iter->first)
+			{
+				m_FreeBlocksBySize.erase(bySizeIter);
+				break;
+			}
+		}
+
+		m_FreeBlocksByOffset.erase(iter);
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "pch.h"
+
+namespace pr
+{
+	// Best fit free list over [0, capacity) that coalesces neighbouring free blocks and can compact
+	// every live range to the front. Offsets and sizes are in caller defined units.
+	class RangeAllocator final
+	{
+	public:
+		static constexpr const UINT INVALID_OFFSET = 0xFFFFFFFF;
+
+		struct Move
+		{
+			UINT uSourceOffset;
+			UINT uDestinationOffset;
+			UINT uSize;
+		};
+
+	public:
+		explicit RangeAllocator() noexcept;
+		explicit RangeAllocator(_In_ UINT uCapacity) noexcept;
+		RangeAllocator(const RangeAllocator& other) = default;
+		RangeAllocator(RangeAllocator&& other) = default;
+		RangeAllocator& operator=(const RangeAllocator& other) = default;
+		RangeAllocator& operator=(RangeAllocator&& other) = default;
+		~RangeAllocator() noexcept = default;
+
+		// Returns INVALID_OFFSET when no free block is large enough
+		UINT Allocate(_In_ UINT uSize);
+		void Free(_In_ UINT uOffset);
+		void Grow(_In_ UINT uNewCapacity);
+
+		// Slides every allocation down to close the gaps, moves are returned in ascending offset order
+		// and never overlap a range that has not been moved yet
+		std::vector<Move> Defragment();
+
+		UINT GetCapacity() const noexcept;
+		UINT GetUsedSize() const noexcept;
+		UINT GetNumFreeBlocks() const noexcept;
+		UINT GetLargestFreeBlock() const noexcept;
+		// Size of the free block that ends at the capacity, space that compacting would not gain
+		UINT GetTrailingFreeSize() const noexcept;
+
+	private:
+		void insertFreeBlock(_In_ UINT uOffset, _In_ UINT uSize);
+		void eraseFreeBlock(_In_ std::map<UINT, UINT>::iterator iter);
+
+	private:
+		std::map<UINT, UINT> m_FreeBlocksByOffset;
+		std::multimap<UINT, UINT> m_FreeBlocksBySize;
+		std::map<UINT, UINT> m_Allocations;
+		UINT m_uCapacity;
+		UINT m_uUsedSize;
+	};
+}
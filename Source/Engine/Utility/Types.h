@@ -0,0 +1,90 @@
+#pragma once
+
+// Windows base types and SAL annotations for the engine code that does not need the Windows or Direct3D headers,
+// so it also builds on other platforms. The typedefs are the ones of the Windows SDK, so this header and
+// <windows.h> may be included together in any order.
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <sal.h>
+#else
+#define _In_
+#define _In_opt_
+#define _In_z_
+#define _In_range_(lb, ub)
+#define _In_reads_(size)
+#define _In_reads_opt_(size)
+#define _In_reads_bytes_(size)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(size)
+#define _Out_writes_bytes_(size)
+#define _Out_writes_to_(size, count)
+#define _Outptr_
+#define _Outptr_opt_result_maybenull_
+#define _Inout_
+#define _Inout_opt_
+#define _Inout_updates_(size)
+#define _Use_decl_annotations_
+#define _Analysis_assume_(expr)
+#define _Return_type_success_(expr)
+#endif
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef short SHORT;
+typedef unsigned short USHORT;
+typedef char CHAR;
+typedef wchar_t WCHAR;
+typedef int INT;
+typedef unsigned int UINT;
+typedef float FLOAT;
+typedef double DOUBLE;
+typedef signed char INT8;
+typedef unsigned char UINT8;
+typedef signed short INT16;
+typedef unsigned short UINT16;
+typedef signed int INT32;
+typedef unsigned int UINT32;
+typedef signed long long INT64;
+typedef unsigned long long UINT64;
+typedef const CHAR* PCSTR;
+
+// Windows longs are 32 bits on every Windows target, the fixed size keeps file layouts the same elsewhere
+#if defined(_WIN32)
+typedef long LONG;
+typedef unsigned long DWORD;
+typedef _Return_type_success_(return >= 0) long HRESULT;
+#else
+typedef std::int32_t LONG;
+typedef std::uint32_t DWORD;
+typedef std::int32_t HRESULT;
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef SUCCEEDED
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#endif
+
+#ifndef FAILED
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#endif
+
+#ifndef S_OK
+#define S_OK ((HRESULT)0L)
+#define S_FALSE ((HRESULT)1L)
+#define E_NOTIMPL ((HRESULT)0x80004001L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#endif
@@ -99,6 +99,8 @@ namespace pr
 {
 	const std::filesystem::path CONTENTS_PATH(L"Contents");
 	const std::filesystem::path SHADERS_PATH(CONTENTS_PATH / L"Shaders");
+	const std::filesystem::path PIPELINE_CACHE_PATH(CONTENTS_PATH / L"PipelineCache.bin");
+	const std::filesystem::path SHADER_ARCHIVE_PATH(CONTENTS_PATH / L"Shaders.pak");
 
 	constexpr LPCWSTR LPSZ_ENGINE_TITLE = L"Pipeline Renderer";
 	constexpr const size_t DEFAULT_WIDTH = 1280;
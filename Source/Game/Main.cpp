@@ -48,17 +48,68 @@ INT WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     std::unique_ptr<pr::Game> pGame = std::make_unique<pr::Game>(L"Pipeline Renderer");
 
     std::unique_ptr<pr::Scene> pScene = std::make_unique<pr::Scene>();
-    std::shared_ptr<pr::BaseCube> pCube = std::make_unique<pr::BaseCube>();
+    pr::Scene* pSceneView = pScene.get();
+
+    // The cooked scene is mapped in milliseconds instead of importing the model, it is cooked on the first run
+    const std::filesystem::path cookedScenePath(L"Contents/Sponza/sponza.prscene");
+    BOOL bIsSceneCooked = SUCCEEDED(pScene->LoadFile(cookedScenePath));
+    if (bIsSceneCooked)
+    {
+        // Only the cells around the camera are resident
+        pScene->EnableStreaming(pr::StreamingPolicy::GetDefaultSettings());
+    }
+    else
+    {
+        std::shared_ptr<pr::BaseCube> pCube = std::make_unique<pr::BaseCube>();
     
-    hr = pScene->AddRenderable(L"Cube", pCube);
-    CHECK_AND_RETURN_HRESULT(hr, L"Adding cube to scene");
-
-    std::shared_ptr<pr::Model> pModel = std::make_shared<pr::Model>(L"Contents/Sponza/sponza.obj");
-    //std::shared_ptr<pr::Model> pModel = std::make_shared<pr::Model>(L"Contents/Main/NewSponza_Main_FBX_YUp.fbx");
-    pModel->Scale(0.1f, 0.1f, 0.1f);
-
-    hr = pScene->AddRenderable(L"Model", pModel);
-    CHECK_AND_RETURN_HRESULT(hr, L"Adding sponza model to scene");
+        hr = pScene->AddRenderable(L"Cube", pCube);
+        CHECK_AND_RETURN_HRESULT(hr, L"Adding cube to scene");
+
+        std::shared_ptr<pr::Model> pModel = std::make_shared<pr::Model>(L"Contents/Sponza/sponza.obj");
+        //std::shared_ptr<pr::Model> pModel = std::make_shared<pr::Model>(L"Contents/Main/NewSponza_Main_FBX_YUp.fbx");
+        pModel->Scale(0.1f, 0.1f, 0.1f);
+        pModel->SetOccluder(TRUE);
+
+        hr = pScene->AddRenderable(L"Model", pModel);
+        CHECK_AND_RETURN_HRESULT(hr, L"Adding sponza model to scene");
+
+        // Grid of colored point lights filling the atrium and the corridors
+        for (UINT z = 0u; z < 12u; ++z)
+        {
+            for (UINT y = 0u; y < 3u; ++y)
+            {
+                for (UINT x = 0u; x < 24u; ++x)
+                {
+                    UINT uHue = (x + y * 5u + z * 7u) % 6u;
+                    pScene->AddLight(
+                        pr::LightData
+                        {
+                            .Position = XMFLOAT3(-172.5f + 15.0f * static_cast<FLOAT>(x), 5.0f + 30.0f * static_cast<FLOAT>(y), -55.0f + 10.0f * static_cast<FLOAT>(z)),
+                            .Range = 15.0f,
+                            .Color = XMFLOAT3(uHue < 2u || uHue == 5u ? 1.0f : 0.2f, uHue >= 1u && uHue <= 3u ? 1.0f : 0.2f, uHue >= 3u ? 1.0f : 0.2f),
+                            .Type = pr::eLightType::POINT,
+                        }
+                    );
+                }
+            }
+        }
+
+        // Spot lights shining down from the roof of the atrium
+        for (UINT i = 0u; i < 8u; ++i)
+        {
+            pScene->AddLight(
+                pr::LightData
+                {
+                    .Position = XMFLOAT3(-105.0f + 30.0f * static_cast<FLOAT>(i), 100.0f, 0.0f),
+                    .Range = 120.0f,
+                    .Color = XMFLOAT3(1.0f, 0.9f, 0.7f),
+                    .Type = pr::eLightType::SPOT,
+                    .Direction = XMFLOAT3(0.0f, -1.0f, 0.0f),
+                    .CosOuterAngle = 0.9f,
+                }
+            );
+        }
+    }
 
     hr = pGame->AddScene(std::move(pScene));
     CHECK_AND_RETURN_HRESULT(hr, L"Adding scene");
@@ -66,5 +117,11 @@ INT WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     hr = pGame->Initialize(hInstance, nCmdShow);
     CHECK_AND_RETURN_HRESULT(hr, L"Game Initialization");
 
+    if (!bIsSceneCooked)
+    {
+        // A scene that fails to cook is assembled again on the next run
+        pSceneView->SaveFile(cookedScenePath);
+    }
+
     return pGame->Run();
 }
\ No newline at end of file
@@ -0,0 +1,402 @@
+#pragma once
+
+// The subset of DirectXMath used by the portable engine modules and their tests and benchmarks, for platforms
+// without the Windows SDK. Same conventions as DirectXMath: row vectors, left handed, XMVECTOR is an SSE register.
+// Only the storage types are identical, the functions favour simplicity over speed, so timings of code that
+// spends its time in them are higher than with DirectXMath.
+
+#include <cmath>
+#include <cstdint>
+#include <xmmintrin.h>
+
+#define XM_CALLCONV
+
+namespace DirectX
+{
+	constexpr float XM_PI = 3.141592654f;
+	constexpr float XM_2PI = 6.283185307f;
+	constexpr float XM_PIDIV2 = 1.570796327f;
+	constexpr float XM_PIDIV4 = 0.785398163f;
+
+	inline constexpr float XMConvertToRadians(float degrees) noexcept { return degrees * (XM_PI / 180.0f); }
+	inline constexpr float XMConvertToDegrees(float radians) noexcept { return radians * (180.0f / XM_PI); }
+
+	typedef __m128 XMVECTOR;
+	typedef const XMVECTOR FXMVECTOR;
+	typedef const XMVECTOR GXMVECTOR;
+	typedef const XMVECTOR HXMVECTOR;
+	typedef const XMVECTOR& CXMVECTOR;
+
+	struct XMFLOAT2
+	{
+		float x;
+		float y;
+
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float _x, float _y) noexcept : x(_x), y(_y) {}
+	};
+
+	struct XMFLOAT3
+	{
+		float x;
+		float y;
+		float z;
+
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float _x, float _y, float _z) noexcept : x(_x), y(_y), z(_z) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x;
+		float y;
+		float z;
+		float w;
+
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float _x, float _y, float _z, float _w) noexcept : x(_x), y(_y), z(_z), w(_w) {}
+	};
+
+	struct XMFLOAT3X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+			};
+			float m[3][4];
+		};
+	};
+
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+
+		XMFLOAT4X4() = default;
+		constexpr XMFLOAT4X4(
+			float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33
+		) noexcept
+			: _11(m00), _12(m01), _13(m02), _14(m03)
+			, _21(m10), _22(m11), _23(m12), _24(m13)
+			, _31(m20), _32(m21), _33(m22), _34(m23)
+			, _41(m30), _42(m31), _43(m32), _44(m33)
+		{
+		}
+	};
+
+	struct alignas(16) XMMATRIX
+	{
+		XMVECTOR r[4];
+
+		XMMATRIX() = default;
+		XMMATRIX(FXMVECTOR r0, FXMVECTOR r1, FXMVECTOR r2, CXMVECTOR r3) noexcept : r{ r0, r1, r2, r3 } {}
+		XMMATRIX(
+			float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33
+		) noexcept
+			: r{ _mm_setr_ps(m00, m01, m02, m03), _mm_setr_ps(m10, m11, m12, m13), _mm_setr_ps(m20, m21, m22, m23), _mm_setr_ps(m30, m31, m32, m33) }
+		{
+		}
+	};
+	typedef const XMMATRIX& FXMMATRIX;
+	typedef const XMMATRIX& CXMMATRIX;
+
+	// Vectors
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w) noexcept { return _mm_setr_ps(x, y, z, w); }
+	inline XMVECTOR XMVectorZero() noexcept { return _mm_setzero_ps(); }
+	inline XMVECTOR XMVectorSplatOne() noexcept { return _mm_set1_ps(1.0f); }
+	inline XMVECTOR XMVectorReplicate(float value) noexcept { return _mm_set1_ps(value); }
+
+	inline float XMVectorGetByIndex(FXMVECTOR v, size_t i) noexcept
+	{
+		alignas(16) float af[4];
+		_mm_store_ps(af, v);
+		return af[i];
+	}
+	inline float XMVectorGetX(FXMVECTOR v) noexcept { return _mm_cvtss_f32(v); }
+	inline float XMVectorGetY(FXMVECTOR v) noexcept { return XMVectorGetByIndex(v, 1); }
+	inline float XMVectorGetZ(FXMVECTOR v) noexcept { return XMVectorGetByIndex(v, 2); }
+	inline float XMVectorGetW(FXMVECTOR v) noexcept { return XMVectorGetByIndex(v, 3); }
+
+	inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b) noexcept { return _mm_add_ps(a, b); }
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b) noexcept { return _mm_sub_ps(a, b); }
+	inline XMVECTOR XMVectorMultiply(FXMVECTOR a, FXMVECTOR b) noexcept { return _mm_mul_ps(a, b); }
+	inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c) noexcept { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+	inline XMVECTOR XMVectorScale(FXMVECTOR v, float scale) noexcept { return _mm_mul_ps(v, _mm_set1_ps(scale)); }
+	inline XMVECTOR XMVectorNegate(FXMVECTOR v) noexcept { return _mm_sub_ps(_mm_setzero_ps(), v); }
+	inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b) noexcept { return _mm_min_ps(a, b); }
+	inline XMVECTOR XMVectorMax(FXMVECTOR a, FXMVECTOR b) noexcept { return _mm_max_ps(a, b); }
+	inline XMVECTOR XMVectorAbs(FXMVECTOR v) noexcept { return _mm_max_ps(v, XMVectorNegate(v)); }
+
+	inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b) noexcept
+	{
+		XMVECTOR product = _mm_mul_ps(a, b);
+		return _mm_set1_ps(XMVectorGetX(product) + XMVectorGetY(product) + XMVectorGetZ(product));
+	}
+	inline XMVECTOR XMVector4Dot(FXMVECTOR a, FXMVECTOR b) noexcept
+	{
+		XMVECTOR product = _mm_mul_ps(a, b);
+		return _mm_set1_ps(XMVectorGetX(product) + XMVectorGetY(product) + XMVectorGetZ(product) + XMVectorGetW(product));
+	}
+	inline XMVECTOR XMVector3Length(FXMVECTOR v) noexcept { return _mm_sqrt_ps(XMVector3Dot(v, v)); }
+	inline XMVECTOR XMVector3LengthSq(FXMVECTOR v) noexcept { return XMVector3Dot(v, v); }
+	inline XMVECTOR XMVector4Length(FXMVECTOR v) noexcept { return _mm_sqrt_ps(XMVector4Dot(v, v)); }
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR v) noexcept
+	{
+		float length = XMVectorGetX(XMVector3Length(v));
+		return length > 0.0f ? XMVectorScale(v, 1.0f / length) : v;
+	}
+	inline XMVECTOR XMVector4Normalize(FXMVECTOR v) noexcept
+	{
+		float length = XMVectorGetX(XMVector4Length(v));
+		return length > 0.0f ? XMVectorScale(v, 1.0f / length) : v;
+	}
+	inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b) noexcept
+	{
+		float ax = XMVectorGetX(a), ay = XMVectorGetY(a), az = XMVectorGetZ(a);
+		float bx = XMVectorGetX(b), by = XMVectorGetY(b), bz = XMVectorGetZ(b);
+		return _mm_setr_ps(ay * bz - az * by, az * bx - ax * bz, ax * by - ay * bx, 0.0f);
+	}
+
+	// Loads and stores
+
+	inline XMVECTOR XMLoadFloat2(const XMFLOAT2* pSource) noexcept { return _mm_setr_ps(pSource->x, pSource->y, 0.0f, 0.0f); }
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* pSource) noexcept { return _mm_setr_ps(pSource->x, pSource->y, pSource->z, 0.0f); }
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* pSource) noexcept { return _mm_loadu_ps(&pSource->x); }
+	inline void XMStoreFloat2(XMFLOAT2* pDestination, FXMVECTOR v) noexcept { *pDestination = XMFLOAT2(XMVectorGetX(v), XMVectorGetY(v)); }
+	inline void XMStoreFloat3(XMFLOAT3* pDestination, FXMVECTOR v) noexcept { *pDestination = XMFLOAT3(XMVectorGetX(v), XMVectorGetY(v), XMVectorGetZ(v)); }
+	inline void XMStoreFloat4(XMFLOAT4* pDestination, FXMVECTOR v) noexcept { _mm_storeu_ps(&pDestination->x, v); }
+
+	inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* pSource) noexcept
+	{
+		return XMMATRIX(_mm_loadu_ps(pSource->m[0]), _mm_loadu_ps(pSource->m[1]), _mm_loadu_ps(pSource->m[2]), _mm_loadu_ps(pSource->m[3]));
+	}
+	inline void XMStoreFloat4x4(XMFLOAT4X4* pDestination, FXMMATRIX m) noexcept
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			_mm_storeu_ps(pDestination->m[i], m.r[i]);
+		}
+	}
+
+	// Matrices
+
+	inline XMVECTOR XMVector4Transform(FXMVECTOR v, FXMMATRIX m) noexcept
+	{
+		XMVECTOR result = _mm_mul_ps(_mm_set1_ps(XMVectorGetX(v)), m.r[0]);
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(XMVectorGetY(v)), m.r[1]));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(XMVectorGetZ(v)), m.r[2]));
+		return _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(XMVectorGetW(v)), m.r[3]));
+	}
+	inline XMVECTOR XMVector3TransformNormal(FXMVECTOR v, FXMMATRIX m) noexcept
+	{
+		XMVECTOR result = _mm_mul_ps(_mm_set1_ps(XMVectorGetX(v)), m.r[0]);
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(XMVectorGetY(v)), m.r[1]));
+		return _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(XMVectorGetZ(v)), m.r[2]));
+	}
+	inline XMVECTOR XMVector3Transform(FXMVECTOR v, FXMMATRIX m) noexcept { return _mm_add_ps(XMVector3TransformNormal(v, m), m.r[3]); }
+	inline XMVECTOR XMVector3TransformCoord(FXMVECTOR v, FXMMATRIX m) noexcept
+	{
+		XMVECTOR result = XMVector3Transform(v, m);
+		return _mm_div_ps(result, _mm_set1_ps(XMVectorGetW(result)));
+	}
+
+	inline XMMATRIX XMMatrixIdentity() noexcept
+	{
+		return XMMATRIX(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	inline XMMATRIX XMMatrixMultiply(FXMMATRIX a, CXMMATRIX b) noexcept
+	{
+		return XMMATRIX(XMVector4Transform(a.r[0], b), XMVector4Transform(a.r[1], b), XMVector4Transform(a.r[2], b), XMVector4Transform(a.r[3], b));
+	}
+	inline XMMATRIX operator*(FXMMATRIX a, CXMMATRIX b) noexcept { return XMMatrixMultiply(a, b); }
+	inline XMMATRIX& operator*=(XMMATRIX& a, CXMMATRIX b) noexcept
+	{
+		a = XMMatrixMultiply(a, b);
+		return a;
+	}
+	inline XMMATRIX XMMatrixTranspose(FXMMATRIX m) noexcept
+	{
+		XMMATRIX result = m;
+		_MM_TRANSPOSE4_PS(result.r[0], result.r[1], result.r[2], result.r[3]);
+		return result;
+	}
+	inline void XMStoreFloat3x4(XMFLOAT3X4* pDestination, FXMMATRIX m) noexcept
+	{
+		XMMATRIX transposed = XMMatrixTranspose(m);
+		for (int i = 0; i < 3; ++i)
+		{
+			_mm_storeu_ps(pDestination->m[i], transposed.r[i]);
+		}
+	}
+
+	inline XMMATRIX XMMatrixScaling(float x, float y, float z) noexcept
+	{
+		return XMMATRIX(x, 0.0f, 0.0f, 0.0f, 0.0f, y, 0.0f, 0.0f, 0.0f, 0.0f, z, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	inline XMMATRIX XMMatrixScalingFromVector(FXMVECTOR scale) noexcept { return XMMatrixScaling(XMVectorGetX(scale), XMVectorGetY(scale), XMVectorGetZ(scale)); }
+	inline XMMATRIX XMMatrixTranslation(float x, float y, float z) noexcept
+	{
+		return XMMATRIX(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, x, y, z, 1.0f);
+	}
+	inline XMMATRIX XMMatrixTranslationFromVector(FXMVECTOR offset) noexcept { return XMMatrixTranslation(XMVectorGetX(offset), XMVectorGetY(offset), XMVectorGetZ(offset)); }
+	inline XMMATRIX XMMatrixRotationX(float angle) noexcept
+	{
+		float c = std::cos(angle), s = std::sin(angle);
+		return XMMATRIX(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, c, s, 0.0f, 0.0f, -s, c, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	inline XMMATRIX XMMatrixRotationY(float angle) noexcept
+	{
+		float c = std::cos(angle), s = std::sin(angle);
+		return XMMATRIX(c, 0.0f, -s, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, s, 0.0f, c, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	inline XMMATRIX XMMatrixRotationZ(float angle) noexcept
+	{
+		float c = std::cos(angle), s = std::sin(angle);
+		return XMMATRIX(c, s, 0.0f, 0.0f, -s, c, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	// Roll about z, then pitch about x, then yaw about y
+	inline XMMATRIX XMMatrixRotationRollPitchYaw(float pitch, float yaw, float roll) noexcept
+	{
+		return XMMatrixRotationZ(roll) * XMMatrixRotationX(pitch) * XMMatrixRotationY(yaw);
+	}
+	inline XMMATRIX XMMatrixRotationQuaternion(FXMVECTOR q) noexcept
+	{
+		float x = XMVectorGetX(q), y = XMVectorGetY(q), z = XMVectorGetZ(q), w = XMVectorGetW(q);
+		return XMMATRIX(
+			1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f,
+			2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f,
+			2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
+	}
+	// Scaling about the origin, rotation about rotationOrigin, then translation
+	inline XMMATRIX XMMatrixAffineTransformation(FXMVECTOR scale, FXMVECTOR rotationOrigin, FXMVECTOR rotation, GXMVECTOR translation) noexcept
+	{
+		XMMATRIX result = XMMatrixScalingFromVector(scale);
+		result.r[3] = _mm_sub_ps(result.r[3], _mm_setr_ps(XMVectorGetX(rotationOrigin), XMVectorGetY(rotationOrigin), XMVectorGetZ(rotationOrigin), 0.0f));
+		result = result * XMMatrixRotationQuaternion(rotation);
+		result.r[3] = _mm_add_ps(result.r[3], _mm_setr_ps(
+			XMVectorGetX(rotationOrigin) + XMVectorGetX(translation),
+			XMVectorGetY(rotationOrigin) + XMVectorGetY(translation),
+			XMVectorGetZ(rotationOrigin) + XMVectorGetZ(translation),
+			0.0f
+		));
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixInverse(XMVECTOR* pDeterminant, FXMMATRIX matrix) noexcept
+	{
+		XMFLOAT4X4 source;
+		XMStoreFloat4x4(&source, matrix);
+		const float* m = &source._11;
+
+		float inv[16];
+		inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+		inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+		inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+		inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+		inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+		inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+		inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+		inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+		inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+		inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+		inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+		inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+		inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+		inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+		inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+		inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+		float determinant = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+		if (pDeterminant)
+		{
+			*pDeterminant = _mm_set1_ps(determinant);
+		}
+
+		float scale = 1.0f / determinant;
+		XMMATRIX result;
+		for (int i = 0; i < 4; ++i)
+		{
+			result.r[i] = _mm_mul_ps(_mm_loadu_ps(&inv[i * 4]), _mm_set1_ps(scale));
+		}
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixLookToLH(FXMVECTOR eyePosition, FXMVECTOR eyeDirection, FXMVECTOR upDirection) noexcept
+	{
+		XMVECTOR z = XMVector3Normalize(eyeDirection);
+		XMVECTOR x = XMVector3Normalize(XMVector3Cross(upDirection, z));
+		XMVECTOR y = XMVector3Cross(z, x);
+		XMVECTOR negativeEye = XMVectorNegate(eyePosition);
+		XMMATRIX result(
+			_mm_setr_ps(XMVectorGetX(x), XMVectorGetY(x), XMVectorGetZ(x), XMVectorGetX(XMVector3Dot(x, negativeEye))),
+			_mm_setr_ps(XMVectorGetX(y), XMVectorGetY(y), XMVectorGetZ(y), XMVectorGetX(XMVector3Dot(y, negativeEye))),
+			_mm_setr_ps(XMVectorGetX(z), XMVectorGetY(z), XMVectorGetZ(z), XMVectorGetX(XMVector3Dot(z, negativeEye))),
+			_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f)
+		);
+		return XMMatrixTranspose(result);
+	}
+	inline XMMATRIX XMMatrixLookAtLH(FXMVECTOR eyePosition, FXMVECTOR focusPosition, FXMVECTOR upDirection) noexcept
+	{
+		return XMMatrixLookToLH(eyePosition, XMVectorSubtract(focusPosition, eyePosition), upDirection);
+	}
+	inline XMMATRIX XMMatrixPerspectiveFovLH(float fovAngleY, float aspectRatio, float nearZ, float farZ) noexcept
+	{
+		float height = 1.0f / std::tan(fovAngleY * 0.5f);
+		float width = height / aspectRatio;
+		float range = farZ / (farZ - nearZ);
+		return XMMATRIX(width, 0.0f, 0.0f, 0.0f, 0.0f, height, 0.0f, 0.0f, 0.0f, 0.0f, range, 1.0f, 0.0f, 0.0f, -range * nearZ, 0.0f);
+	}
+
+	// Quaternions
+
+	inline XMVECTOR XMQuaternionIdentity() noexcept { return _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f); }
+	inline XMVECTOR XMQuaternionNormalize(FXMVECTOR q) noexcept { return XMVector4Normalize(q); }
+	// Rotation by q1 followed by rotation by q2
+	inline XMVECTOR XMQuaternionMultiply(FXMVECTOR q1, FXMVECTOR q2) noexcept
+	{
+		float ax = XMVectorGetX(q2), ay = XMVectorGetY(q2), az = XMVectorGetZ(q2), aw = XMVectorGetW(q2);
+		float bx = XMVectorGetX(q1), by = XMVectorGetY(q1), bz = XMVectorGetZ(q1), bw = XMVectorGetW(q1);
+		return _mm_setr_ps(
+			aw * bx + ax * bw + ay * bz - az * by,
+			aw * by - ax * bz + ay * bw + az * bx,
+			aw * bz + ax * by - ay * bx + az * bw,
+			aw * bw - ax * bx - ay * by - az * bz
+		);
+	}
+	inline XMVECTOR XMQuaternionRotationNormal(FXMVECTOR normalAxis, float angle) noexcept
+	{
+		float s = std::sin(angle * 0.5f);
+		return _mm_setr_ps(XMVectorGetX(normalAxis) * s, XMVectorGetY(normalAxis) * s, XMVectorGetZ(normalAxis) * s, std::cos(angle * 0.5f));
+	}
+	inline XMVECTOR XMQuaternionRotationAxis(FXMVECTOR axis, float angle) noexcept { return XMQuaternionRotationNormal(XMVector3Normalize(axis), angle); }
+	inline XMVECTOR XMQuaternionRotationRollPitchYaw(float pitch, float yaw, float roll) noexcept
+	{
+		XMVECTOR qRoll = XMQuaternionRotationNormal(_mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f), roll);
+		XMVECTOR qPitch = XMQuaternionRotationNormal(_mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f), pitch);
+		XMVECTOR qYaw = XMQuaternionRotationNormal(_mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f), yaw);
+		return XMQuaternionMultiply(XMQuaternionMultiply(qRoll, qPitch), qYaw);
+	}
+	inline XMVECTOR XMVector3Rotate(FXMVECTOR v, FXMVECTOR q) noexcept { return XMVector3TransformNormal(v, XMMatrixRotationQuaternion(q)); }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// The half precision conversions of DirectXPackedVector, see DirectXMath.h
+
+#include <cstdint>
+#include <cstring>
+
+namespace DirectX
+{
+	namespace PackedVector
+	{
+		typedef uint16_t HALF;
+
+		// Rounds to nearest even, overflows to infinity and keeps NaNs
+		inline HALF XMConvertFloatToHalf(float value) noexcept
+		{
+			uint32_t uBits;
+			std::memcpy(&uBits, &value, sizeof(uBits));
+			uint32_t uSign = (uBits & 0x80000000u) >> 16u;
+			uBits &= 0x7FFFFFFFu;
+
+			uint32_t uResult;
+			if (uBits > 0x477FE000u)
+			{
+				uResult = (uBits & 0x7F800000u) == 0x7F800000u && (uBits & 0x007FFFFFu) != 0u ? 0x7FFFu : 0x7C00u;
+			}
+			else
+			{
+				if (uBits < 0x38800000u)
+				{
+					uint32_t uShift = 113u - (uBits >> 23u);
+					uBits = uShift < 32u ? (0x800000u | (uBits & 0x7FFFFFu)) >> uShift : 0u;
+				}
+				else
+				{
+					uBits += 0xC8000000u;
+				}
+				uResult = ((uBits + 0x0FFFu + ((uBits >> 13u) & 1u)) >> 13u) & 0x7FFFu;
+			}
+
+			return static_cast<HALF>(uResult | uSign);
+		}
+
+		inline float XMConvertHalfToFloat(HALF value) noexcept
+		{
+			uint32_t uMantissa = value & 0x03FFu;
+			uint32_t uExponent = value & 0x7C00u;
+			if (uExponent == 0x7C00u)
+			{
+				uExponent = 0x8Fu;
+			}
+			else if (uExponent != 0u)
+			{
+				uExponent = (value >> 10u) & 0x1Fu;
+			}
+			else if (uMantissa != 0u)
+			{
+				// Denormal, normalize it
+				uExponent = 1u;
+				do
+				{
+					--uExponent;
+					uMantissa <<= 1u;
+				} while ((uMantissa & 0x0400u) == 0u);
+				uMantissa &= 0x03FFu;
+			}
+			else
+			{
+				uExponent = static_cast<uint32_t>(-112);
+			}
+
+			uint32_t uBits = ((value & 0x8000u) << 16u) | ((uExponent + 112u) << 23u) | (uMantissa << 13u);
+			float result;
+			std::memcpy(&result, &uBits, sizeof(result));
+			return result;
+		}
+	}
+}
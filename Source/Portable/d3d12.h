@@ -0,0 +1,195 @@
+#pragma once
+
+// Stands in for the Windows SDK <d3d12.h> (and the <dxgiformat.h> it includes) in the CMake build. Only the plain
+// structures and enumerations the portable modules use are declared, with the values and layouts of the SDK so
+// files written here can be read by the renderer. There are no interfaces.
+
+#include "Utility/Types.h"
+
+typedef UINT64 D3D12_GPU_VIRTUAL_ADDRESS;
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32A32_UINT = 3,
+	DXGI_FORMAT_R32G32B32A32_SINT = 4,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R32G32B32_UINT = 7,
+	DXGI_FORMAT_R32G32B32_SINT = 8,
+	DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+	DXGI_FORMAT_R16G16B16A16_UNORM = 11,
+	DXGI_FORMAT_R16G16B16A16_UINT = 12,
+	DXGI_FORMAT_R16G16B16A16_SNORM = 13,
+	DXGI_FORMAT_R16G16B16A16_SINT = 14,
+	DXGI_FORMAT_R32G32_FLOAT = 16,
+	DXGI_FORMAT_R32G32_UINT = 17,
+	DXGI_FORMAT_R32G32_SINT = 18,
+	DXGI_FORMAT_R10G10B10A2_UNORM = 24,
+	DXGI_FORMAT_R10G10B10A2_UINT = 25,
+	DXGI_FORMAT_R11G11B10_FLOAT = 26,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+	DXGI_FORMAT_R8G8B8A8_UINT = 30,
+	DXGI_FORMAT_R8G8B8A8_SNORM = 31,
+	DXGI_FORMAT_R8G8B8A8_SINT = 32,
+	DXGI_FORMAT_R16G16_FLOAT = 34,
+	DXGI_FORMAT_R16G16_UNORM = 35,
+	DXGI_FORMAT_R16G16_UINT = 36,
+	DXGI_FORMAT_R16G16_SNORM = 37,
+	DXGI_FORMAT_R16G16_SINT = 38,
+	DXGI_FORMAT_D32_FLOAT = 40,
+	DXGI_FORMAT_R32_FLOAT = 41,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R32_SINT = 43,
+	DXGI_FORMAT_D24_UNORM_S8_UINT = 45,
+	DXGI_FORMAT_R8G8_UNORM = 49,
+	DXGI_FORMAT_R8G8_UINT = 50,
+	DXGI_FORMAT_R8G8_SNORM = 51,
+	DXGI_FORMAT_R8G8_SINT = 52,
+	DXGI_FORMAT_R16_FLOAT = 54,
+	DXGI_FORMAT_R16_UNORM = 56,
+	DXGI_FORMAT_R16_UINT = 57,
+	DXGI_FORMAT_R16_SNORM = 58,
+	DXGI_FORMAT_R16_SINT = 59,
+	DXGI_FORMAT_R8_UNORM = 61,
+	DXGI_FORMAT_R8_UINT = 62,
+	DXGI_FORMAT_R8_SNORM = 63,
+	DXGI_FORMAT_R8_SINT = 64,
+	DXGI_FORMAT_B8G8R8A8_UNORM = 87,
+};
+
+#define D3D12_APPEND_ALIGNED_ELEMENT (0xffffffff)
+#define D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT (32)
+#define D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT (8)
+
+struct D3D12_SHADER_BYTECODE
+{
+	const void* pShaderBytecode;
+	size_t BytecodeLength;
+};
+
+enum D3D12_INPUT_CLASSIFICATION
+{
+	D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA = 0,
+	D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA = 1,
+};
+
+struct D3D12_INPUT_ELEMENT_DESC
+{
+	PCSTR SemanticName;
+	UINT SemanticIndex;
+	DXGI_FORMAT Format;
+	UINT InputSlot;
+	UINT AlignedByteOffset;
+	D3D12_INPUT_CLASSIFICATION InputSlotClass;
+	UINT InstanceDataStepRate;
+};
+
+enum D3D12_PRIMITIVE_TOPOLOGY_TYPE
+{
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED = 0,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT = 1,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE = 2,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE = 3,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_PATCH = 4,
+};
+
+enum D3D12_FILL_MODE
+{
+	D3D12_FILL_MODE_WIREFRAME = 2,
+	D3D12_FILL_MODE_SOLID = 3,
+};
+
+enum D3D12_CULL_MODE
+{
+	D3D12_CULL_MODE_NONE = 1,
+	D3D12_CULL_MODE_FRONT = 2,
+	D3D12_CULL_MODE_BACK = 3,
+};
+
+enum D3D12_COMPARISON_FUNC
+{
+	D3D12_COMPARISON_FUNC_NEVER = 1,
+	D3D12_COMPARISON_FUNC_LESS = 2,
+	D3D12_COMPARISON_FUNC_EQUAL = 3,
+	D3D12_COMPARISON_FUNC_LESS_EQUAL = 4,
+	D3D12_COMPARISON_FUNC_GREATER = 5,
+	D3D12_COMPARISON_FUNC_NOT_EQUAL = 6,
+	D3D12_COMPARISON_FUNC_GREATER_EQUAL = 7,
+	D3D12_COMPARISON_FUNC_ALWAYS = 8,
+};
+
+struct D3D12_VERTEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	UINT StrideInBytes;
+};
+
+struct D3D12_INDEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	DXGI_FORMAT Format;
+};
+
+struct D3D12_DRAW_INDEXED_ARGUMENTS
+{
+	UINT IndexCountPerInstance;
+	UINT InstanceCount;
+	UINT StartIndexLocation;
+	INT BaseVertexLocation;
+	UINT StartInstanceLocation;
+};
+
+enum D3D12_INDIRECT_ARGUMENT_TYPE
+{
+	D3D12_INDIRECT_ARGUMENT_TYPE_DRAW = 0,
+	D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED = 1,
+	D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH = 2,
+	D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW = 3,
+	D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW = 4,
+	D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT = 5,
+	D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW = 6,
+	D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW = 7,
+	D3D12_INDIRECT_ARGUMENT_TYPE_UNORDERED_ACCESS_VIEW = 8,
+};
+
+struct D3D12_INDIRECT_ARGUMENT_DESC
+{
+	D3D12_INDIRECT_ARGUMENT_TYPE Type;
+	union
+	{
+		struct
+		{
+			UINT Slot;
+		} VertexBuffer;
+		struct
+		{
+			UINT RootParameterIndex;
+			UINT DestOffsetIn32BitValues;
+			UINT Num32BitValuesToSet;
+		} Constant;
+		struct
+		{
+			UINT RootParameterIndex;
+		} ConstantBufferView;
+		struct
+		{
+			UINT RootParameterIndex;
+		} ShaderResourceView;
+		struct
+		{
+			UINT RootParameterIndex;
+		} UnorderedAccessView;
+	};
+};
+
+struct D3D12_COMMAND_SIGNATURE_DESC
+{
+	UINT ByteStride;
+	UINT NumArgumentDescs;
+	const D3D12_INDIRECT_ARGUMENT_DESC* pArgumentDescs;
+	UINT NodeMask;
+};
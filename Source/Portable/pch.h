@@ -0,0 +1,63 @@
+#pragma once
+
+// Stands in for Source/Engine/pch.h when the portable modules are built with CMake: the standard library, the
+// Windows base types and the parts of DirectXMath and Direct3D 12 those modules use. Code that needs a device, a
+// window or COM stays out of that build.
+
+#include <algorithm>
+#include <cassert>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cwctype>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Utility/Types.h"
+
+#include <d3d12.h>
+#include "DirectXMath.h"
+
+#define D3D12_GPU_VIRTUAL_ADDRESS_NULL      ((D3D12_GPU_VIRTUAL_ADDRESS)0)
+#define D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN   ((D3D12_GPU_VIRTUAL_ADDRESS)-1)
+
+#ifndef ARRAYSIZE
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
+#endif
+
+using namespace DirectX;
+
+namespace pr
+{
+	inline constexpr size_t ConvertKbToBytes(size_t kilobytes)
+	{
+		return kilobytes * 1024;
+	}
+
+	inline constexpr size_t ConvertMbToBytes(size_t megabytes)
+	{
+		return megabytes * 1024 * 1024;
+	}
+
+	constexpr const size_t _64KB = ConvertKbToBytes(64);
+	constexpr const size_t _1MB = ConvertMbToBytes(1);
+	constexpr const size_t _2MB = ConvertMbToBytes(2);
+	constexpr const size_t _4MB = ConvertMbToBytes(4);
+	constexpr const size_t _8MB = ConvertMbToBytes(8);
+	constexpr const size_t _16MB = ConvertMbToBytes(16);
+	constexpr const size_t _32MB = ConvertMbToBytes(32);
+	constexpr const size_t _64MB = ConvertMbToBytes(64);
+	constexpr const size_t _128MB = ConvertMbToBytes(128);
+	constexpr const size_t _256MB = ConvertMbToBytes(256);
+}
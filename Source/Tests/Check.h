@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for the portable tests: failures are reported and counted, and main returns the count so
+// ctest sees a failing test. They stay active in release builds, unlike assert.
+namespace pr::test
+{
+	inline int g_iNumFailures = 0;
+}
+
+#define PR_CHECK(expr)                                                                      \
+	do                                                                                      \
+	{                                                                                       \
+		if (!(expr))                                                                        \
+		{                                                                                   \
+			std::fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #expr);  \
+			++pr::test::g_iNumFailures;                                                     \
+		}                                                                                   \
+	} while (false)
+
+#define PR_TEST_RESULT() (pr::test::g_iNumFailures == 0 ? 0 : 1)
@@ -0,0 +1,111 @@
+#include "pch.h"
+
+#include "Graphics/IndirectCommandBuilder.h"
+
+#include "Check.h"
+
+using namespace pr;
+
+namespace
+{
+	template <class T>
+	void writeField(_Inout_ std::vector<BYTE>& aBytes, _In_ size_t uOffset, _In_ const T& value)
+	{
+		memcpy(aBytes.data() + uOffset, &value, sizeof(T));
+	}
+
+	void testLayout()
+	{
+		PR_CHECK(sizeof(IndirectDrawCommand) == 56u);
+		PR_CHECK(offsetof(IndirectDrawCommand, VertexBufferView) == 0u);
+		PR_CHECK(offsetof(IndirectDrawCommand, IndexBufferView) == 16u);
+		PR_CHECK(offsetof(IndirectDrawCommand, uFirstInstance) == 32u);
+		PR_CHECK(offsetof(IndirectDrawCommand, DrawArguments) == 36u);
+	}
+
+	void testArgumentBuffer()
+	{
+		IndirectCommandBuilder builder;
+		constexpr const UINT NUM_DRAWS = 3u;
+		for (UINT i = 0u; i < NUM_DRAWS; ++i)
+		{
+			builder.AddDraw(
+				D3D12_VERTEX_BUFFER_VIEW{ .BufferLocation = 0x10000ull * (i + 1u), .SizeInBytes = 4096u + i, .StrideInBytes = 16u },
+				D3D12_INDEX_BUFFER_VIEW{ .BufferLocation = 0x20000ull * (i + 1u), .SizeInBytes = 2048u + i, .Format = DXGI_FORMAT_R16_UINT },
+				100u * i,
+				36u + i,
+				1u + i,
+				3u * i,
+				-static_cast<INT>(i)
+			);
+		}
+		PR_CHECK(builder.GetNumCommands() == NUM_DRAWS);
+		PR_CHECK(builder.GetSizeInBytes() == 56u * NUM_DRAWS);
+
+		// Every byte of the buffer is written, anything the builder leaves out shows up as 0xCD
+		std::vector<BYTE> aBuffer(builder.GetSizeInBytes(), 0xCDu);
+		builder.WriteTo(aBuffer.data());
+
+		std::vector<BYTE> aExpected(56u * NUM_DRAWS, 0u);
+		for (UINT i = 0u; i < NUM_DRAWS; ++i)
+		{
+			size_t uCommand = 56u * i;
+			writeField<UINT64>(aExpected, uCommand + 0u, 0x10000ull * (i + 1u));
+			writeField<UINT>(aExpected, uCommand + 8u, 4096u + i);
+			writeField<UINT>(aExpected, uCommand + 12u, 16u);
+			writeField<UINT64>(aExpected, uCommand + 16u, 0x20000ull * (i + 1u));
+			writeField<UINT>(aExpected, uCommand + 24u, 2048u + i);
+			writeField<UINT>(aExpected, uCommand + 28u, static_cast<UINT>(DXGI_FORMAT_R16_UINT));
+			writeField<UINT>(aExpected, uCommand + 32u, 100u * i);
+			writeField<UINT>(aExpected, uCommand + 36u, 36u + i);
+			writeField<UINT>(aExpected, uCommand + 40u, 1u + i);
+			writeField<UINT>(aExpected, uCommand + 44u, 3u * i);
+			writeField<INT>(aExpected, uCommand + 48u, -static_cast<INT>(i));
+			writeField<UINT>(aExpected, uCommand + 52u, 0u);
+		}
+		PR_CHECK(aBuffer == aExpected);
+		PR_CHECK(memcmp(builder.GetCommands(), aExpected.data(), aExpected.size()) == 0);
+
+		builder.Reset();
+		PR_CHECK(builder.GetNumCommands() == 0u);
+		PR_CHECK(builder.GetSizeInBytes() == 0u);
+	}
+
+	void testCommandSignature()
+	{
+		constexpr const UINT FIRST_INSTANCE_ROOT_PARAMETER = 5u;
+
+		D3D12_INDIRECT_ARGUMENT_DESC aArgumentDescs[IndirectCommandBuilder::NUM_ARGUMENTS];
+		IndirectCommandBuilder::GetArgumentDescs(aArgumentDescs, FIRST_INSTANCE_ROOT_PARAMETER);
+
+		// One argument per field, in field order
+		PR_CHECK(aArgumentDescs[0].Type == D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW);
+		PR_CHECK(aArgumentDescs[0].VertexBuffer.Slot == 0u);
+		PR_CHECK(aArgumentDescs[1].Type == D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW);
+		PR_CHECK(aArgumentDescs[2].Type == D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT);
+		PR_CHECK(aArgumentDescs[2].Constant.RootParameterIndex == FIRST_INSTANCE_ROOT_PARAMETER);
+		PR_CHECK(aArgumentDescs[2].Constant.DestOffsetIn32BitValues == 0u);
+		PR_CHECK(aArgumentDescs[2].Constant.Num32BitValuesToSet * sizeof(UINT) == sizeof(IndirectDrawCommand::uFirstInstance));
+		PR_CHECK(aArgumentDescs[3].Type == D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED);
+
+		D3D12_COMMAND_SIGNATURE_DESC signatureDesc = IndirectCommandBuilder::GetCommandSignatureDesc(aArgumentDescs);
+		PR_CHECK(signatureDesc.ByteStride == sizeof(IndirectDrawCommand));
+		PR_CHECK(signatureDesc.NumArgumentDescs == IndirectCommandBuilder::NUM_ARGUMENTS);
+		PR_CHECK(signatureDesc.pArgumentDescs == aArgumentDescs);
+		PR_CHECK(signatureDesc.NodeMask == 0u);
+
+		// The arguments consume the command without gaps
+		size_t uArgumentsSize = sizeof(D3D12_VERTEX_BUFFER_VIEW) + sizeof(D3D12_INDEX_BUFFER_VIEW)
+			+ aArgumentDescs[2].Constant.Num32BitValuesToSet * sizeof(UINT) + sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+		PR_CHECK(uArgumentsSize == signatureDesc.ByteStride);
+	}
+}
+
+int main()
+{
+	testLayout();
+	testArgumentBuffer();
+	testCommandSignature();
+
+	return PR_TEST_RESULT();
+}
@@ -0,0 +1,261 @@
+#include "Graphics/ModelCacheFile.h"
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include "Check.h"
+
+using namespace pr;
+
+namespace
+{
+	// A quad of two triangles in one mesh and one meshlet, with one material
+	struct TestModel
+	{
+		ModelCacheFile::Key Key;
+		VertexPackedPNT aVertices[4];
+		WORD auIndices[6];
+		SceneFile::Mesh Mesh;
+		ModelCacheFile::Material Material;
+		ModelCacheFile::MeshMeshlets MeshMeshlets;
+		Meshlet MeshletRecord;
+		WORD auMeshletVertices[4];
+		BYTE auMeshletTriangles[6];
+		std::string Strings;
+
+		TestModel()
+			: Key()
+			, aVertices()
+			, auIndices{ 0u, 1u, 2u, 2u, 1u, 3u }
+			, Mesh()
+			, Material()
+			, MeshMeshlets()
+			, MeshletRecord()
+			, auMeshletVertices{ 0u, 1u, 2u, 3u }
+			, auMeshletTriangles{ 0u, 1u, 2u, 2u, 1u, 3u }
+			, Strings(std::string("stone.dds") + '\0' + "stone_normal.dds" + '\0')
+		{
+			Key.uSourceHash = 0x0123456789ABCDEFull;
+			Key.uSourceSize = 4096u;
+			Key.uImportFlags = 0x8Bu;
+
+			for (UINT i = 0u; i < 4u; ++i)
+			{
+				aVertices[i].auPosition[0] = static_cast<USHORT>((i & 1u) * 0xFFFFu);
+				aVertices[i].auPosition[1] = static_cast<USHORT>((i >> 1u) * 0xFFFFu);
+				aVertices[i].aiNormal[1] = 0x7FFF;
+			}
+
+			Mesh.uNumIndices = 6u;
+			Mesh.uNumLods = 1u;
+
+			Material.uDiffuse = 0u;
+			Material.uSpecularExponent = ModelCacheFile::INVALID_INDEX;
+			Material.uNormal = 10u;
+
+			MeshMeshlets.uNumMeshlets = 1u;
+
+			MeshletRecord.Center = XMFLOAT3(0.5f, 0.5f, 0.0f);
+			MeshletRecord.Radius = 0.75f;
+			MeshletRecord.ConeAxis = XMFLOAT3(0.0f, 0.0f, 1.0f);
+			MeshletRecord.ConeCutoff = 1.0f;
+			MeshletRecord.uNumVertices = 4u;
+			MeshletRecord.uNumTriangles = 2u;
+		}
+
+		ModelCacheFile::View GetView() const
+		{
+			return ModelCacheFile::View
+			{
+				.aVertices = aVertices,
+				.uNumVertices = 4u,
+				.Decode = PositionDecode{ .Offset = XMFLOAT3(-1.0f, -1.0f, 0.0f), .Scale = 2.0f },
+				.auIndices = auIndices,
+				.uNumIndices = 6u,
+				.aMeshes = &Mesh,
+				.uNumMeshes = 1u,
+				.aMaterials = &Material,
+				.uNumMaterials = 1u,
+				.aMeshMeshlets = &MeshMeshlets,
+				.aMeshlets = &MeshletRecord,
+				.uNumMeshlets = 1u,
+				.auMeshletVertices = auMeshletVertices,
+				.uNumMeshletVertices = 4u,
+				.auMeshletTriangles = auMeshletTriangles,
+				.uNumMeshletTriangles = 6u,
+				.pStrings = Strings.data(),
+				.uStringsSize = static_cast<UINT>(Strings.size()),
+			};
+		}
+	};
+
+	std::vector<BYTE> writeModel(_In_ const TestModel& model)
+	{
+		std::vector<BYTE> aFile;
+		PR_CHECK(ModelCacheFile::Write(aFile, model.Key, model.GetView()) == S_OK);
+
+		return aFile;
+	}
+
+	ModelCacheFile::Header readHeader(_In_ const std::vector<BYTE>& aFile)
+	{
+		ModelCacheFile::Header header;
+		memcpy(&header, aFile.data(), sizeof(header));
+
+		return header;
+	}
+
+	template <class Record>
+	Record* getRecords(_In_ std::vector<BYTE>& aFile, _In_ ModelCacheFile::eSection section)
+	{
+		return reinterpret_cast<Record*>(aFile.data() + readHeader(aFile).aSections[static_cast<size_t>(section)].uOffset);
+	}
+
+	void testRoundTrip()
+	{
+		TestModel model;
+		std::vector<BYTE> aFile = writeModel(model);
+		PR_CHECK(aFile.size() == readHeader(aFile).uFileSize);
+
+		ModelCacheFile::View view;
+		PR_CHECK(ModelCacheFile::Read(view, model.Key, aFile.data(), aFile.size()) == S_OK);
+		PR_CHECK(view.uNumVertices == 4u && view.uNumIndices == 6u && view.uNumMeshes == 1u && view.uNumMaterials == 1u);
+		PR_CHECK(view.uNumMeshlets == 1u && view.uNumMeshletVertices == 4u && view.uNumMeshletTriangles == 6u);
+		PR_CHECK(view.Decode.Scale == 2.0f && view.Decode.Offset.x == -1.0f);
+		PR_CHECK(memcmp(view.aVertices, model.aVertices, sizeof(model.aVertices)) == 0);
+		PR_CHECK(memcmp(view.auIndices, model.auIndices, sizeof(model.auIndices)) == 0);
+		PR_CHECK(memcmp(view.aMeshes, &model.Mesh, sizeof(model.Mesh)) == 0);
+		PR_CHECK(memcmp(view.aMeshMeshlets, &model.MeshMeshlets, sizeof(model.MeshMeshlets)) == 0);
+		PR_CHECK(memcmp(view.aMeshlets, &model.MeshletRecord, sizeof(model.MeshletRecord)) == 0);
+		PR_CHECK(memcmp(view.auMeshletVertices, model.auMeshletVertices, sizeof(model.auMeshletVertices)) == 0);
+		PR_CHECK(memcmp(view.auMeshletTriangles, model.auMeshletTriangles, sizeof(model.auMeshletTriangles)) == 0);
+
+		// The view points into the file
+		PR_CHECK(reinterpret_cast<const BYTE*>(view.aVertices) > aFile.data() && reinterpret_cast<const BYTE*>(view.aVertices) < aFile.data() + aFile.size());
+		PR_CHECK(std::string(ModelCacheFile::GetString(view, view.aMaterials[0].uDiffuse)) == "stone.dds");
+		PR_CHECK(std::string(ModelCacheFile::GetString(view, view.aMaterials[0].uNormal)) == "stone_normal.dds");
+		PR_CHECK(std::string(ModelCacheFile::GetString(view, view.aMaterials[0].uSpecularExponent)).empty());
+	}
+
+	void testStaleKey()
+	{
+		TestModel model;
+		const std::vector<BYTE> aFile = writeModel(model);
+
+		auto expectStale = [&aFile](const ModelCacheFile::Key& key)
+		{
+			ModelCacheFile::View view;
+			PR_CHECK(FAILED(ModelCacheFile::Read(view, key, aFile.data(), aFile.size())));
+			PR_CHECK(view.uNumMeshes == 0u);
+		};
+
+		ModelCacheFile::Key key = model.Key;
+		key.uSourceHash ^= 1u;
+		expectStale(key);
+
+		key = model.Key;
+		key.uSourceSize += 1u;
+		expectStale(key);
+
+		key = model.Key;
+		key.uImportFlags = 0u;
+		expectStale(key);
+
+		// The reserved field is not part of the key
+		key = model.Key;
+		key.uReserved = 1u;
+		ModelCacheFile::View view;
+		PR_CHECK(ModelCacheFile::Read(view, key, aFile.data(), aFile.size()) == S_OK);
+	}
+
+	void testTruncation()
+	{
+		TestModel model;
+		std::vector<BYTE> aFile = writeModel(model);
+
+		ModelCacheFile::View view;
+		PR_CHECK(FAILED(ModelCacheFile::Read(view, model.Key, nullptr, 0u)));
+		for (size_t uSize = 0; uSize < aFile.size(); uSize += 5u)
+		{
+			PR_CHECK(FAILED(ModelCacheFile::Read(view, model.Key, aFile.data(), uSize)));
+			PR_CHECK(view.uNumVertices == 0u);
+		}
+		PR_CHECK(FAILED(ModelCacheFile::Read(view, model.Key, aFile.data(), aFile.size() - 1u)));
+	}
+
+	void testCorruptHeader()
+	{
+		TestModel model;
+		const std::vector<BYTE> aFile = writeModel(model);
+
+		// Flipping the top bit of any header field breaks the magic, version, size, key, decode scale or a section.
+		// The reserved key field and the sign of the decode offset may hold any value.
+		const size_t uReserved = offsetof(ModelCacheFile::Header, ImportKey) + offsetof(ModelCacheFile::Key, uReserved);
+		const size_t uDecodeOffset = offsetof(ModelCacheFile::Header, Decode) + offsetof(PositionDecode, Offset);
+		for (size_t uOffset = 3u; uOffset < sizeof(ModelCacheFile::Header); uOffset += 4u)
+		{
+			if (uOffset / 4u == uReserved / 4u || (uOffset >= uDecodeOffset && uOffset < uDecodeOffset + sizeof(XMFLOAT3)))
+			{
+				continue;
+			}
+
+			std::vector<BYTE> aCorruptFile = aFile;
+			aCorruptFile[uOffset] ^= 0x80u;
+
+			ModelCacheFile::View view;
+			PR_CHECK(FAILED(ModelCacheFile::Read(view, model.Key, aCorruptFile.data(), aCorruptFile.size())));
+		}
+	}
+
+	void testCorruptRecords()
+	{
+		TestModel model;
+		const std::vector<BYTE> aFile = writeModel(model);
+		const ModelCacheFile::Key key = model.Key;
+
+		auto expectRejected = [&aFile, &key](auto&& corrupt)
+		{
+			std::vector<BYTE> aCorruptFile = aFile;
+			corrupt(aCorruptFile);
+
+			ModelCacheFile::View view;
+			PR_CHECK(FAILED(ModelCacheFile::Read(view, key, aCorruptFile.data(), aCorruptFile.size())));
+		};
+
+		using namespace ModelCacheFile;
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<SceneFile::Mesh>(aCorruptFile, eSection::MESHES)[0].uNumIndices = 9u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<SceneFile::Mesh>(aCorruptFile, eSection::MESHES)[0].uBaseVertex = 5u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<SceneFile::Mesh>(aCorruptFile, eSection::MESHES)[0].uMaterialIndex = 1u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<SceneFile::Mesh>(aCorruptFile, eSection::MESHES)[0].uNumLods = 0u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Material>(aCorruptFile, eSection::MATERIALS)[0].uNormal = 1000u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<MeshMeshlets>(aCorruptFile, eSection::MESH_MESHLETS)[0].uNumMeshlets = 2u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Meshlet>(aCorruptFile, eSection::MESHLETS)[0].uNumTriangles = 3u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Meshlet>(aCorruptFile, eSection::MESHLETS)[0].uNumVertices = MAX_MESHLET_VERTICES + 1u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Meshlet>(aCorruptFile, eSection::MESHLETS)[0].uVertexOffset = 1u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Meshlet>(aCorruptFile, eSection::MESHLETS)[0].uTriangleOffset = 3u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<CHAR>(aCorruptFile, eSection::STRINGS)[readHeader(aCorruptFile).aSections[static_cast<size_t>(eSection::STRINGS)].uSize - 1u] = 'x'; });
+	}
+
+	void testWriteInvalid()
+	{
+		TestModel model;
+		model.MeshletRecord.uNumTriangles = 3u;
+
+		std::vector<BYTE> aFile(1u);
+		PR_CHECK(ModelCacheFile::Write(aFile, model.Key, model.GetView()) == E_INVALIDARG);
+		PR_CHECK(aFile.empty());
+	}
+}
+
+int main()
+{
+	testRoundTrip();
+	testStaleKey();
+	testTruncation();
+	testCorruptHeader();
+	testCorruptRecords();
+	testWriteInvalid();
+
+	return PR_TEST_RESULT();
+}
@@ -0,0 +1,221 @@
+#include "Graphics/PipelineCacheFile.h"
+#include "Graphics/PipelineStateDesc.h"
+
+#include <cstring>
+#include <iterator>
+#include <random>
+
+#include "Check.h"
+
+using namespace pr;
+
+namespace
+{
+	BYTE g_aVertexShader[100];
+	BYTE g_aPixelShader[77];
+	BYTE g_aRootSignature[33];
+
+	GraphicsPipelineDesc createDesc(_In_reads_(uNumInputElements) const D3D12_INPUT_ELEMENT_DESC* pInputElementDescs, _In_ UINT uNumInputElements)
+	{
+		GraphicsPipelineDesc desc = {};
+		desc.VertexShader = { g_aVertexShader, sizeof(g_aVertexShader) };
+		desc.PixelShader = { g_aPixelShader, sizeof(g_aPixelShader) };
+		desc.pRootSignatureBlob = g_aRootSignature;
+		desc.uRootSignatureBlobSize = sizeof(g_aRootSignature);
+		desc.pInputElementDescs = pInputElementDescs;
+		desc.uNumInputElements = uNumInputElements;
+		desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+		desc.FillMode = D3D12_FILL_MODE_SOLID;
+		desc.CullMode = D3D12_CULL_MODE_BACK;
+		desc.bIsDepthEnabled = TRUE;
+		desc.bIsDepthWriteEnabled = TRUE;
+		desc.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+		desc.uNumRenderTargets = 1u;
+		desc.aRtvFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.DsvFormat = DXGI_FORMAT_D32_FLOAT;
+		desc.uSampleCount = 1u;
+
+		return desc;
+	}
+
+	void testCanonicalHash()
+	{
+		const D3D12_INPUT_ELEMENT_DESC aAppendedElements[] =
+		{
+			{ "POSITION", 0u, DXGI_FORMAT_R32G32B32_FLOAT, 0u, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0u },
+			{ "NORMAL", 0u, DXGI_FORMAT_R32G32B32_FLOAT, 0u, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0u },
+			{ "TEXCOORD", 0u, DXGI_FORMAT_R32G32_FLOAT, 0u, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0u },
+		};
+		// Same layout with explicit offsets, other order, other case and a step rate that per vertex data ignores
+		const D3D12_INPUT_ELEMENT_DESC aExplicitElements[] =
+		{
+			{ "texcoord", 0u, DXGI_FORMAT_R32G32_FLOAT, 0u, 24u, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 5u },
+			{ "Position", 0u, DXGI_FORMAT_R32G32B32_FLOAT, 0u, 0u, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0u },
+			{ "NORMAL", 0u, DXGI_FORMAT_R32G32B32_FLOAT, 0u, 12u, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0u },
+		};
+
+		GraphicsPipelineDesc desc = createDesc(aAppendedElements, static_cast<UINT>(std::size(aAppendedElements)));
+		CanonicalPipelineDesc canonical(desc);
+
+		// Unused render target formats, a zero sample count and a shader copy at another address change nothing
+		std::vector<BYTE> aVertexShaderCopy(g_aVertexShader, g_aVertexShader + sizeof(g_aVertexShader));
+		GraphicsPipelineDesc equalDesc = createDesc(aExplicitElements, static_cast<UINT>(std::size(aExplicitElements)));
+		equalDesc.VertexShader = { aVertexShaderCopy.data(), aVertexShaderCopy.size() };
+		equalDesc.aRtvFormats[3] = DXGI_FORMAT_R16_FLOAT;
+		equalDesc.uSampleCount = 0u;
+		CanonicalPipelineDesc equalCanonical(equalDesc);
+		PR_CHECK(equalCanonical.GetHash() == canonical.GetHash());
+
+		const GraphicsPipelineDesc& canonicalDesc = equalCanonical.GetDesc();
+		PR_CHECK(canonicalDesc.uNumInputElements == 3u);
+		PR_CHECK(std::string(canonicalDesc.pInputElementDescs[0].SemanticName) == "POSITION");
+		PR_CHECK(std::string(canonicalDesc.pInputElementDescs[2].SemanticName) == "TEXCOORD");
+		PR_CHECK(canonicalDesc.pInputElementDescs[2].InstanceDataStepRate == 0u);
+		PR_CHECK(canonical.GetDesc().pInputElementDescs[2].AlignedByteOffset == 24u);
+		PR_CHECK(canonicalDesc.uSampleCount == 1u);
+
+		// Shaders are hashed by content but referenced where they are
+		PR_CHECK(canonicalDesc.VertexShader.pShaderBytecode == aVertexShaderCopy.data());
+		PR_CHECK(canonicalDesc.PixelShader.pShaderBytecode == g_aPixelShader);
+		PR_CHECK(canonicalDesc.PixelShader.BytecodeLength == sizeof(g_aPixelShader));
+
+		// Depth state without a depth test is reset
+		GraphicsPipelineDesc noDepthDesc = desc;
+		noDepthDesc.bIsDepthEnabled = FALSE;
+		noDepthDesc.DepthFunc = D3D12_COMPARISON_FUNC_GREATER;
+		GraphicsPipelineDesc otherNoDepthDesc = desc;
+		otherNoDepthDesc.bIsDepthEnabled = FALSE;
+		otherNoDepthDesc.bIsDepthWriteEnabled = FALSE;
+		PR_CHECK(CanonicalPipelineDesc(noDepthDesc).GetHash() == CanonicalPipelineDesc(otherNoDepthDesc).GetHash());
+		PR_CHECK(CanonicalPipelineDesc(noDepthDesc).GetHash() != canonical.GetHash());
+
+		// State and content that builds another pipeline changes the hash
+		GraphicsPipelineDesc wireframeDesc = desc;
+		wireframeDesc.FillMode = D3D12_FILL_MODE_WIREFRAME;
+		PR_CHECK(CanonicalPipelineDesc(wireframeDesc).GetHash() != canonical.GetHash());
+
+		aVertexShaderCopy[50] ^= 1u;
+		GraphicsPipelineDesc otherShaderDesc = desc;
+		otherShaderDesc.VertexShader = { aVertexShaderCopy.data(), aVertexShaderCopy.size() };
+		PR_CHECK(CanonicalPipelineDesc(otherShaderDesc).GetHash() != canonical.GetHash());
+
+		BYTE aOtherRootSignature[sizeof(g_aRootSignature)];
+		memcpy(aOtherRootSignature, g_aRootSignature, sizeof(g_aRootSignature));
+		aOtherRootSignature[0] ^= 1u;
+		GraphicsPipelineDesc otherRootSignatureDesc = desc;
+		otherRootSignatureDesc.pRootSignatureBlob = aOtherRootSignature;
+		PR_CHECK(CanonicalPipelineDesc(otherRootSignatureDesc).GetHash() != canonical.GetHash());
+	}
+
+	std::vector<BYTE> writeCacheFile(_Out_ std::vector<std::vector<BYTE>>& aOutBlobData, _Out_ std::vector<PipelineCacheFile::Blob>& aOutBlobs)
+	{
+		std::mt19937 generator(3u);
+		aOutBlobData.resize(10u);
+		aOutBlobs.clear();
+		for (size_t i = 0; i < aOutBlobData.size(); ++i)
+		{
+			aOutBlobData[i].resize(generator() % 5000u);
+			for (BYTE& byte : aOutBlobData[i])
+			{
+				byte = static_cast<BYTE>(generator());
+			}
+			aOutBlobs.push_back(PipelineCacheFile::Blob{ .uKey = i * 1000u + 7u, .pData = aOutBlobData[i].data(), .uSize = aOutBlobData[i].size() });
+		}
+
+		std::vector<BYTE> aFile;
+		PipelineCacheFile::Write(aFile, aOutBlobs);
+		return aFile;
+	}
+
+	void testCacheFileRoundTrip()
+	{
+		std::vector<std::vector<BYTE>> aBlobData;
+		std::vector<PipelineCacheFile::Blob> aBlobs;
+		std::vector<BYTE> aFile = writeCacheFile(aBlobData, aBlobs);
+
+		std::vector<PipelineCacheFile::Blob> aReadBlobs;
+		PR_CHECK(PipelineCacheFile::Read(aReadBlobs, aFile.data(), aFile.size()) == S_OK);
+		PR_CHECK(aReadBlobs.size() == aBlobs.size());
+		for (size_t i = 0; i < aReadBlobs.size() && i < aBlobs.size(); ++i)
+		{
+			PR_CHECK(aReadBlobs[i].uKey == aBlobs[i].uKey);
+			PR_CHECK(aReadBlobs[i].uSize == aBlobs[i].uSize);
+			PR_CHECK(memcmp(aReadBlobs[i].pData, aBlobs[i].pData, aBlobs[i].uSize) == 0);
+			PR_CHECK((aReadBlobs[i].pData - aFile.data()) % PipelineCacheFile::BLOB_ALIGNMENT == 0);
+		}
+
+		std::vector<BYTE> aEmptyFile;
+		PipelineCacheFile::Write(aEmptyFile, {});
+		PR_CHECK(PipelineCacheFile::Read(aReadBlobs, aEmptyFile.data(), aEmptyFile.size()) == S_OK);
+		PR_CHECK(aReadBlobs.empty());
+	}
+
+	void testCacheFileTruncation()
+	{
+		std::vector<std::vector<BYTE>> aBlobData;
+		std::vector<PipelineCacheFile::Blob> aBlobs;
+		std::vector<BYTE> aFile = writeCacheFile(aBlobData, aBlobs);
+
+		std::vector<PipelineCacheFile::Blob> aReadBlobs;
+		PR_CHECK(FAILED(PipelineCacheFile::Read(aReadBlobs, nullptr, 0u)));
+		for (size_t uSize = 0; uSize < aFile.size(); uSize += 97u)
+		{
+			PR_CHECK(FAILED(PipelineCacheFile::Read(aReadBlobs, aFile.data(), uSize)));
+			PR_CHECK(aReadBlobs.empty());
+		}
+		PR_CHECK(FAILED(PipelineCacheFile::Read(aReadBlobs, aFile.data(), aFile.size() - 1u)));
+	}
+
+	void testCacheFileBitFlips()
+	{
+		std::vector<std::vector<BYTE>> aBlobData;
+		std::vector<PipelineCacheFile::Blob> aBlobs;
+		std::vector<BYTE> aFile = writeCacheFile(aBlobData, aBlobs);
+
+		std::mt19937 generator(5u);
+		std::vector<PipelineCacheFile::Blob> aReadBlobs;
+		for (UINT i = 0u; i < 200u; ++i)
+		{
+			std::vector<BYTE> aCorruptFile = aFile;
+			aCorruptFile[generator() % aCorruptFile.size()] ^= static_cast<BYTE>(1u << (generator() % 8u));
+			PR_CHECK(FAILED(PipelineCacheFile::Read(aReadBlobs, aCorruptFile.data(), aCorruptFile.size())));
+			PR_CHECK(aReadBlobs.empty());
+		}
+
+		// Every header field is checked, the checksum does not cover the header
+		for (size_t uByte = 0; uByte < sizeof(PipelineCacheFile::Header); ++uByte)
+		{
+			if (uByte >= offsetof(PipelineCacheFile::Header, uReserved) && uByte < offsetof(PipelineCacheFile::Header, uChecksum))
+			{
+				continue;
+			}
+
+			std::vector<BYTE> aCorruptFile = aFile;
+			aCorruptFile[uByte] ^= 0x10u;
+			PR_CHECK(FAILED(PipelineCacheFile::Read(aReadBlobs, aCorruptFile.data(), aCorruptFile.size())));
+		}
+	}
+}
+
+int main()
+{
+	for (size_t i = 0; i < sizeof(g_aVertexShader); ++i)
+	{
+		g_aVertexShader[i] = static_cast<BYTE>(i);
+	}
+	for (size_t i = 0; i < sizeof(g_aPixelShader); ++i)
+	{
+		g_aPixelShader[i] = static_cast<BYTE>(3u * i);
+	}
+	for (size_t i = 0; i < sizeof(g_aRootSignature); ++i)
+	{
+		g_aRootSignature[i] = static_cast<BYTE>(7u * i);
+	}
+
+	testCanonicalHash();
+	testCacheFileRoundTrip();
+	testCacheFileTruncation();
+	testCacheFileBitFlips();
+
+	return PR_TEST_RESULT();
+}
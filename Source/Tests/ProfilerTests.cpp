@@ -0,0 +1,107 @@
+#include "Utility/Profiler.h"
+
+#include <cmath>
+#include <thread>
+
+#include "Check.h"
+
+using namespace pr;
+
+namespace
+{
+	const Profiler::Node* findChild(_In_ const std::vector<Profiler::Node>& aNodes, _In_ UINT uParent, _In_ PCSTR pszName)
+	{
+		for (UINT uChild = aNodes[uParent].uFirstChild; uChild != Profiler::INVALID_INDEX; uChild = aNodes[uChild].uNextSibling)
+		{
+			if (strcmp(aNodes[uChild].pszName, pszName) == 0)
+			{
+				return &aNodes[uChild];
+			}
+		}
+
+		return nullptr;
+	}
+
+	void testCpuScopes()
+	{
+		Profiler& profiler = Profiler::GetInstance();
+		profiler.Reset();
+
+		constexpr const UINT NUM_FRAMES = 4u;
+		for (UINT uFrame = 0u; uFrame < NUM_FRAMES; ++uFrame)
+		{
+			PR_PROFILE_BEGIN_FRAME();
+			{
+				PR_PROFILE_SCOPE("Render");
+				{
+					PR_PROFILE_SCOPE("Record");
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				{
+					PR_PROFILE_SCOPE("Record");
+				}
+			}
+
+			// Scopes of other threads hang off the frame root
+			std::thread worker([]() { PR_PROFILE_SCOPE("Worker"); });
+			worker.join();
+			PR_PROFILE_END_FRAME();
+		}
+
+		const std::vector<Profiler::Node>& aNodes = profiler.GetNodes(Profiler::eTimeline::CPU);
+		PR_CHECK(aNodes[Profiler::ROOT_NODE].uNumFrames == NUM_FRAMES);
+
+		const Profiler::Node* pRender = findChild(aNodes, Profiler::ROOT_NODE, "Render");
+		PR_CHECK(pRender != nullptr);
+		if (pRender)
+		{
+			PR_CHECK(pRender->uNumFrames == NUM_FRAMES);
+			PR_CHECK(pRender->uNumCalls == 1u);
+			PR_CHECK(pRender->MinMs >= 1.0);
+
+			// Siblings with the same name merge into one node
+			const Profiler::Node* pRecord = findChild(aNodes, static_cast<UINT>(pRender - aNodes.data()), "Record");
+			PR_CHECK(pRecord != nullptr);
+			PR_CHECK(pRecord && pRecord->uNumCalls == 2u && pRecord->uDepth == 2u);
+			PR_CHECK(pRecord && pRecord->MinMs <= pRender->MinMs);
+		}
+
+		const Profiler::Node* pWorker = findChild(aNodes, Profiler::ROOT_NODE, "Worker");
+		PR_CHECK(pWorker && pWorker->uNumFrames == NUM_FRAMES);
+
+		std::string szReport = profiler.FormatReport();
+		PR_CHECK(szReport.find("[CPU]") != std::string::npos);
+		PR_CHECK(szReport.find("Record") != std::string::npos);
+		PR_CHECK(szReport.find("[GPU]") == std::string::npos);
+	}
+
+	void testGpuFrame()
+	{
+		Profiler& profiler = Profiler::GetInstance();
+		profiler.Reset();
+
+		const Profiler::ScopeEvent aEvents[] =
+		{
+			{ .pszName = "Main Pass", .uBegin = 100u, .uEnd = 1100u, .uParent = Profiler::INVALID_INDEX, .uThread = 0u },
+			{ .pszName = "Draw", .uBegin = 200u, .uEnd = 900u, .uParent = 0u, .uThread = 0u },
+			{ .pszName = "Draw", .uBegin = 950u, .uEnd = 1000u, .uParent = 0u, .uThread = 0u },
+		};
+		profiler.ResolveGpuFrame(aEvents, static_cast<UINT>(std::size(aEvents)), 1000000.0);
+
+		const std::vector<Profiler::Node>& aNodes = profiler.GetNodes(Profiler::eTimeline::GPU);
+		const Profiler::Node* pPass = findChild(aNodes, Profiler::ROOT_NODE, "Main Pass");
+		PR_CHECK(pPass && std::abs(pPass->LastMs - 1.0) < 1e-9);
+		const Profiler::Node* pDraw = pPass ? findChild(aNodes, static_cast<UINT>(pPass - aNodes.data()), "Draw") : nullptr;
+		PR_CHECK(pDraw && pDraw->uNumCalls == 2u && std::abs(pDraw->LastMs - 0.75) < 1e-9);
+		PR_CHECK(std::abs(aNodes[Profiler::ROOT_NODE].LastMs - 1.0) < 1e-9);
+		PR_CHECK(profiler.FormatReport().find("[GPU]") != std::string::npos);
+	}
+}
+
+int main()
+{
+	testCpuScopes();
+	testGpuFrame();
+
+	return PR_TEST_RESULT();
+}
@@ -0,0 +1,158 @@
+#include "Utility/RangeAllocator.h"
+
+#include <cstring>
+
+#include "Check.h"
+
+using namespace pr;
+
+namespace
+{
+	void testBestFit()
+	{
+		RangeAllocator allocator(64u);
+		UINT uA = allocator.Allocate(8u);
+		UINT uB = allocator.Allocate(16u);
+		UINT uC = allocator.Allocate(4u);
+		UINT uD = allocator.Allocate(8u);
+		PR_CHECK(uA == 0u && uB == 8u && uC == 24u && uD == 28u);
+		PR_CHECK(allocator.GetUsedSize() == 36u);
+
+		// B and C merge into one hole in front of D, A then joins it
+		allocator.Free(uB);
+		allocator.Free(uC);
+		PR_CHECK(allocator.GetNumFreeBlocks() == 2u);
+		allocator.Free(uA);
+		PR_CHECK(allocator.GetNumFreeBlocks() == 2u && allocator.GetLargestFreeBlock() == 28u);
+
+		RangeAllocator holes(64u);
+		UINT auOffsets[5];
+		for (UINT i = 0u; i < 5u; ++i)
+		{
+			auOffsets[i] = holes.Allocate(i % 2u == 0u ? 4u : (i == 1u ? 16u : 6u));
+		}
+		holes.Free(auOffsets[1]);
+		holes.Free(auOffsets[3]);
+
+		// The 6 unit hole fits 5 more tightly than the 16 unit hole or the trailing block
+		PR_CHECK(holes.Allocate(5u) == auOffsets[3]);
+		PR_CHECK(holes.Allocate(10u) == auOffsets[1]);
+		PR_CHECK(holes.GetLargestFreeBlock() == 64u - 34u);
+	}
+
+	void testFreeMerging()
+	{
+		RangeAllocator allocator(40u);
+		UINT auOffsets[4];
+		for (UINT& uOffset : auOffsets)
+		{
+			uOffset = allocator.Allocate(10u);
+		}
+		PR_CHECK(allocator.GetNumFreeBlocks() == 0u && allocator.GetLargestFreeBlock() == 0u);
+
+		allocator.Free(auOffsets[1]);
+		allocator.Free(auOffsets[3]);
+		PR_CHECK(allocator.GetNumFreeBlocks() == 2u && allocator.GetTrailingFreeSize() == 10u);
+
+		// Merges with the free blocks on both sides into one
+		allocator.Free(auOffsets[2]);
+		PR_CHECK(allocator.GetNumFreeBlocks() == 1u && allocator.GetLargestFreeBlock() == 30u && allocator.GetTrailingFreeSize() == 30u);
+
+		allocator.Free(auOffsets[0]);
+		PR_CHECK(allocator.GetNumFreeBlocks() == 1u && allocator.GetLargestFreeBlock() == 40u && allocator.GetUsedSize() == 0u);
+		PR_CHECK(allocator.Allocate(40u) == 0u);
+	}
+
+	void testExhaustion()
+	{
+		RangeAllocator allocator(32u);
+		PR_CHECK(allocator.Allocate(0u) == RangeAllocator::INVALID_OFFSET);
+		PR_CHECK(allocator.Allocate(33u) == RangeAllocator::INVALID_OFFSET);
+
+		UINT uFirst = allocator.Allocate(12u);
+		allocator.Allocate(8u);
+		allocator.Allocate(12u);
+		PR_CHECK(allocator.Allocate(1u) == RangeAllocator::INVALID_OFFSET);
+
+		// Enough free space in total, but no block large enough
+		allocator.Free(uFirst);
+		allocator.Free(12u);
+		PR_CHECK(allocator.GetLargestFreeBlock() == 20u);
+		PR_CHECK(allocator.Allocate(21u) == RangeAllocator::INVALID_OFFSET);
+
+		// Growing extends the free block that ends at the old capacity
+		RangeAllocator grown(16u);
+		grown.Allocate(4u);
+		grown.Grow(24u);
+		PR_CHECK(grown.GetCapacity() == 24u && grown.GetNumFreeBlocks() == 1u && grown.GetTrailingFreeSize() == 20u);
+		grown.Grow(8u);
+		PR_CHECK(grown.GetCapacity() == 24u);
+		PR_CHECK(grown.Allocate(20u) == 4u);
+	}
+
+	void testDefragment()
+	{
+		constexpr const UINT CAPACITY = 64u;
+
+		// Every unit holds the id of its allocation, so applying the moves must keep the contents of each range
+		RangeAllocator allocator(CAPACITY);
+		BYTE aBuffer[CAPACITY] = {};
+		UINT auOffsets[8];
+		UINT auSizes[8];
+		for (UINT i = 0u; i < 8u; ++i)
+		{
+			auSizes[i] = 3u + i % 4u;
+			auOffsets[i] = allocator.Allocate(auSizes[i]);
+			memset(aBuffer + auOffsets[i], static_cast<int>(i + 1u), auSizes[i]);
+		}
+		for (UINT i : { 0u, 2u, 3u, 6u })
+		{
+			allocator.Free(auOffsets[i]);
+			memset(aBuffer + auOffsets[i], 0, auSizes[i]);
+		}
+		const UINT uUsedSize = allocator.GetUsedSize();
+
+		std::vector<RangeAllocator::Move> aMoves = allocator.Defragment();
+		PR_CHECK(!aMoves.empty());
+		UINT uPreviousSource = 0u;
+		for (const RangeAllocator::Move& move : aMoves)
+		{
+			// Ascending, and copying down never overwrites a range that is still to be moved
+			PR_CHECK(move.uSourceOffset >= uPreviousSource);
+			PR_CHECK(move.uDestinationOffset < move.uSourceOffset);
+			uPreviousSource = move.uSourceOffset;
+
+			memmove(aBuffer + move.uDestinationOffset, aBuffer + move.uSourceOffset, move.uSize);
+		}
+
+		// The live ranges are packed at the front in their original order
+		UINT uOffset = 0u;
+		for (UINT i : { 1u, 4u, 5u, 7u })
+		{
+			for (UINT j = 0u; j < auSizes[i]; ++j)
+			{
+				PR_CHECK(aBuffer[uOffset + j] == i + 1u);
+			}
+			uOffset += auSizes[i];
+		}
+		PR_CHECK(uOffset == uUsedSize && allocator.GetUsedSize() == uUsedSize);
+		PR_CHECK(allocator.GetNumFreeBlocks() == 1u && allocator.GetTrailingFreeSize() == CAPACITY - uUsedSize);
+
+		// The moved ranges are freed at their new offsets
+		allocator.Free(aMoves.back().uDestinationOffset);
+		PR_CHECK(allocator.GetUsedSize() == uUsedSize - aMoves.back().uSize);
+
+		// Nothing to move once compacted
+		PR_CHECK(allocator.Defragment().empty());
+	}
+}
+
+int main()
+{
+	testBestFit();
+	testFreeMerging();
+	testExhaustion();
+	testDefragment();
+
+	return PR_TEST_RESULT();
+}
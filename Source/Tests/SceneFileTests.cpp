@@ -0,0 +1,228 @@
+#include "Scene/SceneFile.h"
+
+#include <cstring>
+#include <string>
+
+#include "Check.h"
+
+using namespace pr;
+
+namespace
+{
+	// Two renderables sharing one geometry of two meshes, the second is the child of the first
+	struct TestScene
+	{
+		SceneFile::Renderable aRenderables[2];
+		SceneFile::Geometry Geometry;
+		SceneFile::Mesh aMeshes[2];
+		UINT auMaterialBindings[3];
+		SceneFile::Material aMaterials[2];
+		SceneFile::Texture Texture;
+		LightData Light;
+		std::string Strings;
+		std::vector<BYTE> aData;
+
+		TestScene()
+			: aRenderables()
+			, Geometry()
+			, aMeshes()
+			, auMaterialBindings{ 0u, 1u, 1u }
+			, aMaterials()
+			, Texture()
+			, Light()
+			, Strings(std::string("root") + '\0' + "child" + '\0' + "stone.dds" + '\0')
+			, aData(4u * VERTEX_SIZE[static_cast<size_t>(eVertexType::POS_NORM_TEXCOORD)] + 12u * sizeof(WORD))
+		{
+			const UINT uVertexType = static_cast<UINT>(eVertexType::POS_NORM_TEXCOORD);
+
+			aRenderables[0].uName = 0u;
+			aRenderables[0].uParent = SceneFile::INVALID_INDEX;
+			aRenderables[0].uNumBindings = 2u;
+			aRenderables[1].uName = 5u;
+			aRenderables[1].uParent = 0u;
+			aRenderables[1].uFirstBinding = 1u;
+			aRenderables[1].uNumBindings = 2u;
+
+			Geometry.uIndices = 4u * VERTEX_SIZE[uVertexType];
+			Geometry.uNumVertices = 4u;
+			Geometry.uNumIndices = 12u;
+			Geometry.uVertexType = uVertexType;
+			Geometry.uNumMeshes = 2u;
+
+			aMeshes[0].uNumIndices = 6u;
+			aMeshes[0].uNumLods = 2u;
+			aMeshes[0].aLods[0] = { .uNumIndices = 3u, .uBaseIndex = 9u, .Error = 0.5f };
+			aMeshes[1].uNumIndices = 3u;
+			aMeshes[1].uBaseIndex = 6u;
+			aMeshes[1].uMaterialIndex = 1u;
+			aMeshes[1].uNumLods = 1u;
+
+			aMaterials[0] = { .uName = SceneFile::INVALID_INDEX, .uDiffuse = 0u, .uSpecularExponent = SceneFile::INVALID_INDEX, .uNormal = SceneFile::INVALID_INDEX };
+			aMaterials[1] = { .uName = 0u, .uDiffuse = SceneFile::INVALID_INDEX, .uSpecularExponent = SceneFile::INVALID_INDEX, .uNormal = 0u };
+			Texture.uPath = 11u;
+
+			Light.Position = XMFLOAT3(1.0f, 2.0f, 3.0f);
+			Light.Range = 10.0f;
+			Light.Color = XMFLOAT3(1.0f, 1.0f, 1.0f);
+			Light.Type = eLightType::POINT;
+
+			for (size_t i = 0; i < aData.size(); ++i)
+			{
+				aData[i] = static_cast<BYTE>(i);
+			}
+		}
+
+		SceneFile::View GetView() const
+		{
+			return SceneFile::View
+			{
+				.aRenderables = aRenderables,
+				.uNumRenderables = 2u,
+				.aGeometries = &Geometry,
+				.uNumGeometries = 1u,
+				.aMeshes = aMeshes,
+				.uNumMeshes = 2u,
+				.auMaterialBindings = auMaterialBindings,
+				.uNumMaterialBindings = 3u,
+				.aMaterials = aMaterials,
+				.uNumMaterials = 2u,
+				.aTextures = &Texture,
+				.uNumTextures = 1u,
+				.aLights = &Light,
+				.uNumLights = 1u,
+				.pStrings = Strings.data(),
+				.uStringsSize = static_cast<UINT>(Strings.size()),
+				.pData = aData.data(),
+				.uDataSize = aData.size(),
+			};
+		}
+	};
+
+	std::vector<BYTE> writeScene(_In_ const TestScene& scene)
+	{
+		std::vector<BYTE> aFile;
+		PR_CHECK(SceneFile::Write(aFile, scene.GetView()) == S_OK);
+
+		return aFile;
+	}
+
+	SceneFile::Header readHeader(_In_ const std::vector<BYTE>& aFile)
+	{
+		SceneFile::Header header;
+		memcpy(&header, aFile.data(), sizeof(header));
+
+		return header;
+	}
+
+	template <class Record>
+	Record* getRecords(_In_ std::vector<BYTE>& aFile, _In_ SceneFile::eSection section)
+	{
+		return reinterpret_cast<Record*>(aFile.data() + readHeader(aFile).aSections[static_cast<size_t>(section)].uOffset);
+	}
+
+	void testRoundTrip()
+	{
+		TestScene scene;
+		std::vector<BYTE> aFile = writeScene(scene);
+		PR_CHECK(aFile.size() == readHeader(aFile).uFileSize);
+
+		SceneFile::View view;
+		PR_CHECK(SceneFile::Read(view, aFile.data(), aFile.size()) == S_OK);
+		PR_CHECK(view.uNumRenderables == 2u && view.uNumGeometries == 1u && view.uNumMeshes == 2u && view.uNumMaterialBindings == 3u);
+		PR_CHECK(view.uNumMaterials == 2u && view.uNumTextures == 1u && view.uNumLights == 1u && view.uDataSize == scene.aData.size());
+		PR_CHECK(memcmp(view.aRenderables, scene.aRenderables, sizeof(scene.aRenderables)) == 0);
+		PR_CHECK(memcmp(view.aGeometries, &scene.Geometry, sizeof(scene.Geometry)) == 0);
+		PR_CHECK(memcmp(view.aMeshes, scene.aMeshes, sizeof(scene.aMeshes)) == 0);
+		PR_CHECK(memcmp(view.aLights, &scene.Light, sizeof(scene.Light)) == 0);
+		PR_CHECK(memcmp(view.pData, scene.aData.data(), scene.aData.size()) == 0);
+
+		// The view points into the file
+		PR_CHECK(reinterpret_cast<const BYTE*>(view.aMeshes) > aFile.data() && reinterpret_cast<const BYTE*>(view.aMeshes) < aFile.data() + aFile.size());
+		PR_CHECK(std::string(SceneFile::GetString(view, view.aRenderables[1].uName)) == "child");
+		PR_CHECK(std::string(SceneFile::GetString(view, view.aTextures[0].uPath)) == "stone.dds");
+		PR_CHECK(std::string(SceneFile::GetString(view, SceneFile::INVALID_INDEX)).empty());
+	}
+
+	void testTruncation()
+	{
+		TestScene scene;
+		std::vector<BYTE> aFile = writeScene(scene);
+
+		SceneFile::View view;
+		PR_CHECK(FAILED(SceneFile::Read(view, nullptr, 0u)));
+		for (size_t uSize = 0; uSize < aFile.size(); uSize += 7u)
+		{
+			PR_CHECK(FAILED(SceneFile::Read(view, aFile.data(), uSize)));
+			PR_CHECK(view.uNumRenderables == 0u);
+		}
+		PR_CHECK(FAILED(SceneFile::Read(view, aFile.data(), aFile.size() - 1u)));
+	}
+
+	void testCorruptHeader()
+	{
+		TestScene scene;
+		const std::vector<BYTE> aFile = writeScene(scene);
+
+		// Flipping the top bit of any header field breaks the magic, version, size or a section
+		for (size_t uOffset = 3u; uOffset < sizeof(SceneFile::Header); uOffset += 4u)
+		{
+			std::vector<BYTE> aCorruptFile = aFile;
+			aCorruptFile[uOffset] ^= 0x80u;
+
+			SceneFile::View view;
+			PR_CHECK(FAILED(SceneFile::Read(view, aCorruptFile.data(), aCorruptFile.size())));
+		}
+	}
+
+	void testCorruptRecords()
+	{
+		TestScene scene;
+		const std::vector<BYTE> aFile = writeScene(scene);
+
+		auto expectRejected = [&aFile](auto&& corrupt)
+		{
+			std::vector<BYTE> aCorruptFile = aFile;
+			corrupt(aCorruptFile);
+
+			SceneFile::View view;
+			PR_CHECK(FAILED(SceneFile::Read(view, aCorruptFile.data(), aCorruptFile.size())));
+		};
+
+		using namespace SceneFile;
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Renderable>(aCorruptFile, eSection::RENDERABLES)[1].uGeometry = 1u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Renderable>(aCorruptFile, eSection::RENDERABLES)[1].uParent = 2u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Renderable>(aCorruptFile, eSection::RENDERABLES)[1].uNumBindings = 3u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Renderable>(aCorruptFile, eSection::RENDERABLES)[0].uName = 1000u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Geometry>(aCorruptFile, eSection::GEOMETRIES)[0].uNumVertices = 1000u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Geometry>(aCorruptFile, eSection::GEOMETRIES)[0].uVertexType = static_cast<UINT>(eVertexType::COUNT); });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Mesh>(aCorruptFile, eSection::MESHES)[1].uNumIndices = 7u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Mesh>(aCorruptFile, eSection::MESHES)[0].aLods[0].uBaseIndex = 10u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Mesh>(aCorruptFile, eSection::MESHES)[0].uNumLods = MAX_LODS + 1u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Mesh>(aCorruptFile, eSection::MESHES)[1].uMaterialIndex = 2u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<UINT>(aCorruptFile, eSection::MATERIAL_BINDINGS)[2] = 2u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Material>(aCorruptFile, eSection::MATERIALS)[0].uDiffuse = 1u; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<Texture>(aCorruptFile, eSection::TEXTURES)[0].uPath = INVALID_INDEX; });
+		expectRejected([](std::vector<BYTE>& aCorruptFile) { getRecords<CHAR>(aCorruptFile, eSection::STRINGS)[readHeader(aCorruptFile).aSections[static_cast<size_t>(eSection::STRINGS)].uSize - 1u] = 'x'; });
+	}
+
+	void testWriteInvalid()
+	{
+		TestScene scene;
+		scene.aMeshes[1].uMaterialIndex = 2u;
+
+		std::vector<BYTE> aFile(1u);
+		PR_CHECK(SceneFile::Write(aFile, scene.GetView()) == E_INVALIDARG);
+		PR_CHECK(aFile.empty());
+	}
+}
+
+int main()
+{
+	testRoundTrip();
+	testTruncation();
+	testCorruptHeader();
+	testCorruptRecords();
+	testWriteInvalid();
+
+	return PR_TEST_RESULT();
+}
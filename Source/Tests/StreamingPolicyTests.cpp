@@ -0,0 +1,198 @@
+#include "Scene/StreamingPolicy.h"
+
+#include <cmath>
+#include <vector>
+
+#include "Check.h"
+
+using namespace pr;
+
+namespace
+{
+	constexpr const UINT64 CELL_CPU_SIZE = 10u;
+	constexpr const UINT64 CELL_GPU_SIZE = 20u;
+
+	// One frame of a recorded camera path, the budget is counted in cells
+	struct Frame
+	{
+		XMFLOAT3 Position;
+		XMFLOAT3 Velocity;
+		XMFLOAT3 Direction;
+		FLOAT FarZ;
+		UINT uBudgetCells;
+	};
+
+	StreamingPolicy::Cell makeCell(_In_ const XMFLOAT3& min, _In_ const XMFLOAT3& max)
+	{
+		StreamingPolicy::Cell cell;
+		cell.Bounds.Min = min;
+		cell.Bounds.Max = max;
+		cell.uCpuSize = CELL_CPU_SIZE;
+		cell.uGpuSize = CELL_GPU_SIZE;
+		return cell;
+	}
+
+	StreamingPolicy::Settings makeSettings(_In_ UINT uBudgetCells, _In_ FLOAT loadRadius)
+	{
+		StreamingPolicy::Settings settings = StreamingPolicy::GetDefaultSettings();
+		settings.uCpuBudget = uBudgetCells * CELL_CPU_SIZE;
+		settings.uGpuBudget = uBudgetCells * CELL_GPU_SIZE;
+		settings.LoadRadius = loadRadius;
+		return settings;
+	}
+
+	StreamingPolicy::View makeView(_In_ const Frame& frame)
+	{
+		XMVECTOR direction = XMLoadFloat3(&frame.Direction);
+		XMVECTOR up = std::fabs(frame.Direction.y) > 0.9f ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, XMMatrixLookToLH(XMLoadFloat3(&frame.Position), direction, up)
+			* XMMatrixPerspectiveFovLH(XM_PIDIV4, 1.0f, 0.1f, frame.FarZ));
+
+		StreamingPolicy::View view;
+		view.Position = frame.Position;
+		view.Velocity = frame.Velocity;
+		view.ViewFrustum = ExtractFrustum(viewProjection);
+		return view;
+	}
+
+	BOOL isWithinBudget(_In_ const StreamingPolicy& policy)
+	{
+		StreamingPolicy::Stats stats = policy.GetStats();
+		return stats.uCpuUsed <= policy.GetSettings().uCpuBudget && stats.uGpuUsed <= policy.GetSettings().uGpuBudget;
+	}
+
+	// Replays the path one Update per frame, every load finishes before the next frame with the estimated sizes
+	std::vector<StreamingPolicy::Decisions> replay(_Inout_ StreamingPolicy& policy, _In_ const std::vector<Frame>& aFrames, _In_ FLOAT loadRadius)
+	{
+		std::vector<StreamingPolicy::Decisions> aDecisions(aFrames.size());
+		for (size_t i = 0; i < aFrames.size(); ++i)
+		{
+			policy.SetSettings(makeSettings(aFrames[i].uBudgetCells, loadRadius));
+			policy.Update(makeView(aFrames[i]), aDecisions[i]);
+			PR_CHECK(isWithinBudget(policy));
+
+			for (UINT uCell : aDecisions[i].auLoads)
+			{
+				PR_CHECK(policy.GetResidency(uCell) == StreamingPolicy::eResidency::LOADING);
+				policy.OnLoaded(uCell, TRUE, CELL_CPU_SIZE, CELL_GPU_SIZE);
+				PR_CHECK(isWithinBudget(policy));
+			}
+		}
+
+		return aDecisions;
+	}
+
+	void testLoadOrder()
+	{
+		// A row of cells along x, the camera in cell 5 looks down the row and sees cells 5 and 6
+		std::vector<StreamingPolicy::Cell> aCells;
+		for (UINT i = 0u; i < 10u; ++i)
+		{
+			aCells.push_back(makeCell(XMFLOAT3(10.0f * i, -5.0f, -5.0f), XMFLOAT3(10.0f * i + 10.0f, 5.0f, 5.0f)));
+		}
+		const FLOAT loadRadius = 25.0f;
+
+		// Standing still: the cell around the camera, the visible cell at half its distance, then the nearest ones
+		StreamingPolicy standing;
+		standing.Initialize(aCells.data(), static_cast<UINT>(aCells.size()), makeSettings(10u, loadRadius));
+		std::vector<StreamingPolicy::Decisions> aDecisions = replay(standing, { Frame{ XMFLOAT3(55.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), 12.0f, 10u } }, loadRadius);
+		PR_CHECK((aDecisions[0].auLoads == std::vector<UINT>{ 5u, 6u, 4u, 3u }));
+		PR_CHECK(aDecisions[0].auEvictions.empty());
+
+		// Moving at 30 units per second: cell 8 holds the position one second ahead and loads right after cell 5
+		StreamingPolicy moving;
+		moving.Initialize(aCells.data(), static_cast<UINT>(aCells.size()), makeSettings(10u, loadRadius));
+		aDecisions = replay(moving, { Frame{ XMFLOAT3(55.0f, 0.0f, 0.0f), XMFLOAT3(30.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), 12.0f, 10u } }, loadRadius);
+		PR_CHECK((aDecisions[0].auLoads == std::vector<UINT>{ 5u, 8u, 6u, 4u }));
+
+		// No more than the pending limit per frame, the rest follow once those are loaded
+		StreamingPolicy::Stats stats = moving.GetStats();
+		PR_CHECK(stats.uNumResident == 4u && stats.uNumLoading == 0u && stats.uNumLoads == 4u);
+		PR_CHECK(stats.uCpuUsed == 4u * CELL_CPU_SIZE && stats.uGpuUsed == 4u * CELL_GPU_SIZE);
+	}
+
+	void testEvictionOrder()
+	{
+		// Cells 0 to 3 around the origin on +x, -x, +z and -z, cells 4 and 5 stacked above
+		std::vector<StreamingPolicy::Cell> aCells = {
+			makeCell(XMFLOAT3(45.0f, -5.0f, -5.0f), XMFLOAT3(55.0f, 5.0f, 5.0f)),
+			makeCell(XMFLOAT3(-55.0f, -5.0f, -5.0f), XMFLOAT3(-45.0f, 5.0f, 5.0f)),
+			makeCell(XMFLOAT3(-5.0f, -5.0f, 45.0f), XMFLOAT3(5.0f, 5.0f, 55.0f)),
+			makeCell(XMFLOAT3(-5.0f, -5.0f, -55.0f), XMFLOAT3(5.0f, 5.0f, -45.0f)),
+			makeCell(XMFLOAT3(-5.0f, 70.0f, -5.0f), XMFLOAT3(5.0f, 80.0f, 5.0f)),
+			makeCell(XMFLOAT3(-5.0f, 90.0f, -5.0f), XMFLOAT3(5.0f, 100.0f, 5.0f)),
+		};
+		const FLOAT loadRadius = 55.0f;
+
+		// The camera turns in place to look at cells 2, 0, 3 and 1, then rises looking up, and the budget drops to two cells and then one
+		const XMFLOAT3 origin(0.0f, 0.0f, 0.0f);
+		const XMFLOAT3 still(0.0f, 0.0f, 0.0f);
+		const XMFLOAT3 up(0.0f, 1.0f, 0.0f);
+		std::vector<Frame> aFrames = {
+			Frame{ origin, still, XMFLOAT3(0.0f, 0.0f, 1.0f), 100.0f, 4u },
+			Frame{ origin, still, XMFLOAT3(1.0f, 0.0f, 0.0f), 100.0f, 4u },
+			Frame{ origin, still, XMFLOAT3(0.0f, 0.0f, -1.0f), 100.0f, 4u },
+			Frame{ origin, still, XMFLOAT3(-1.0f, 0.0f, 0.0f), 100.0f, 4u },
+			Frame{ XMFLOAT3(0.0f, 30.0f, 0.0f), still, up, 100.0f, 4u },
+			Frame{ XMFLOAT3(0.0f, 45.0f, 0.0f), still, up, 100.0f, 4u },
+			Frame{ XMFLOAT3(0.0f, 45.0f, 0.0f), still, up, 100.0f, 2u },
+			Frame{ XMFLOAT3(0.0f, 45.0f, 0.0f), still, up, 100.0f, 1u },
+		};
+
+		StreamingPolicy policy;
+		policy.Initialize(aCells.data(), static_cast<UINT>(aCells.size()), makeSettings(4u, loadRadius));
+		std::vector<StreamingPolicy::Decisions> aDecisions = replay(policy, aFrames, loadRadius);
+
+		// The four cells around the origin fill the budget, the one in view first
+		PR_CHECK((aDecisions[0].auLoads == std::vector<UINT>{ 2u, 0u, 1u, 3u }));
+		for (size_t i = 1; i < 4; ++i)
+		{
+			PR_CHECK(aDecisions[i].auLoads.empty() && aDecisions[i].auEvictions.empty());
+		}
+
+		// Rising makes cell 4 nearer than the ring, which makes room by evicting the cell seen longest ago
+		PR_CHECK((aDecisions[4].auEvictions == std::vector<UINT>{ 2u }));
+		PR_CHECK((aDecisions[4].auLoads == std::vector<UINT>{ 4u }));
+		PR_CHECK((aDecisions[5].auEvictions == std::vector<UINT>{ 0u }));
+		PR_CHECK((aDecisions[5].auLoads == std::vector<UINT>{ 5u }));
+
+		// A lowered budget evicts the least recently visible cells, then visible ones farthest first
+		PR_CHECK((aDecisions[6].auEvictions == std::vector<UINT>{ 3u, 1u }));
+		PR_CHECK((aDecisions[7].auEvictions == std::vector<UINT>{ 5u }));
+		PR_CHECK(aDecisions[6].auLoads.empty() && aDecisions[7].auLoads.empty());
+		PR_CHECK(policy.GetResidency(4u) == StreamingPolicy::eResidency::RESIDENT);
+
+		StreamingPolicy::Stats stats = policy.GetStats();
+		PR_CHECK(stats.uNumResident == 1u && stats.uNumLoads == 6u && stats.uNumEvictions == 5u);
+		PR_CHECK(stats.uCpuUsed == CELL_CPU_SIZE && stats.uGpuUsed == CELL_GPU_SIZE);
+	}
+
+	void testFailedLoad()
+	{
+		StreamingPolicy::Cell cell = makeCell(XMFLOAT3(-5.0f, -5.0f, -5.0f), XMFLOAT3(5.0f, 5.0f, 5.0f));
+		StreamingPolicy policy;
+		policy.Initialize(&cell, 1u, makeSettings(1u, 10.0f));
+
+		const Frame frame = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f), 100.0f, 1u };
+		StreamingPolicy::Decisions decisions;
+		policy.Update(makeView(frame), decisions);
+		PR_CHECK(decisions.auLoads.size() == 1u && policy.GetStats().uCpuUsed == CELL_CPU_SIZE);
+
+		// The estimate is released and the cell is not requested again
+		policy.OnLoaded(0u, FALSE, 0u, 0u);
+		PR_CHECK(policy.GetResidency(0u) == StreamingPolicy::eResidency::FAILED);
+		PR_CHECK(policy.GetStats().uCpuUsed == 0u && policy.GetStats().uGpuUsed == 0u);
+		policy.Update(makeView(frame), decisions);
+		PR_CHECK(decisions.auLoads.empty());
+	}
+}
+
+int main()
+{
+	testLoadOrder();
+	testEvictionOrder();
+	testFailedLoad();
+
+	return PR_TEST_RESULT();
+}
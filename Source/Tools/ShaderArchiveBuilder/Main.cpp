@@ -0,0 +1,127 @@
+/*+===================================================================
+  File:      MAIN.CPP
+
+  Summary:   Packs the compiled shader objects of a directory into a
+             single shader archive that the renderer maps at startup
+
+  Usage:     ShaderArchiveBuilder <shader directory> <archive file>
+
+             Every <Name>.cso becomes the default permutation of
+             Name, and <Name>.<Defines>.cso the permutation named
+             by Defines
+===================================================================+*/
+
+#include "Shader/ShaderArchiveFile.h"
+
+#include <fstream>
+#include <iostream>
+
+/*F+F+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+  Function: wmain
+
+  Summary:  Entry point of the tool. Reads every compiled shader of
+            the directory and writes the archive.
+
+  Args:     INT argc
+              Number of command-line arguments
+            WCHAR* argv[]
+              Command-line arguments
+
+  Returns:  INT
+              0 on success, 1 on failure
+-----------------------------------------------------------------F-F*/
+INT wmain(_In_ INT argc, _In_reads_(argc) WCHAR* argv[])
+{
+    if (argc != 3)
+    {
+        std::wcerr << L"Usage: ShaderArchiveBuilder <shader directory> <archive file>" << std::endl;
+        return 1;
+    }
+
+    const std::filesystem::path shaderDirectory(argv[1]);
+    const std::filesystem::path archivePath(argv[2]);
+
+    std::error_code errorCode;
+    if (!std::filesystem::is_directory(shaderDirectory, errorCode))
+    {
+        std::wcerr << L"ShaderArchiveBuilder >> " << shaderDirectory.wstring() << L" is not a directory" << std::endl;
+        return 1;
+    }
+
+    // Sorted so the archive does not depend on the directory enumeration order
+    std::set<std::filesystem::path> shaderPaths;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(shaderDirectory, errorCode))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == L".cso")
+        {
+            shaderPaths.insert(entry.path());
+        }
+    }
+
+    std::vector<std::vector<BYTE>> aShaderData;
+    std::vector<pr::ShaderArchiveFile::Shader> aShaders;
+    std::map<std::pair<UINT64, UINT64>, std::wstring> shaderNames;
+    aShaderData.reserve(shaderPaths.size());
+    aShaders.reserve(shaderPaths.size());
+
+    for (const std::filesystem::path& shaderPath : shaderPaths)
+    {
+        std::wstring stem = shaderPath.stem().wstring();
+        size_t uSeparator = stem.find(L'.');
+        std::wstring name = stem.substr(0, uSeparator);
+        std::wstring defines = uSeparator == std::wstring::npos ? std::wstring() : stem.substr(uSeparator + 1);
+
+        std::ifstream file(shaderPath, std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            std::wcerr << L"ShaderArchiveBuilder >> Failed to open " << shaderPath.wstring() << std::endl;
+            return 1;
+        }
+
+        std::vector<BYTE>& aData = aShaderData.emplace_back(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<CHAR*>(aData.data()), static_cast<std::streamsize>(aData.size()));
+        if (!file)
+        {
+            std::wcerr << L"ShaderArchiveBuilder >> Failed to read " << shaderPath.wstring() << std::endl;
+            return 1;
+        }
+
+        pr::ShaderArchiveFile::Shader shader =
+        {
+            .uNameHash = pr::ShaderArchiveFile::HashName(name.c_str()),
+            .uPermutationHash = pr::ShaderArchiveFile::HashPermutation(defines.c_str()),
+            .pData = aData.data(),
+            .uSize = aData.size(),
+        };
+
+        auto [iter, bIsInserted] = shaderNames.try_emplace(std::make_pair(shader.uNameHash, shader.uPermutationHash), stem);
+        if (!bIsInserted)
+        {
+            std::wcerr << L"ShaderArchiveBuilder >> " << stem << L" collides with " << iter->second << std::endl;
+            return 1;
+        }
+
+        aShaders.push_back(shader);
+    }
+
+    std::vector<BYTE> aArchive;
+    HRESULT hr = pr::ShaderArchiveFile::Write(aArchive, aShaders);
+    if (FAILED(hr))
+    {
+        std::wcerr << L"ShaderArchiveBuilder >> Failed to build the archive" << std::endl;
+        return 1;
+    }
+
+    std::ofstream archive(archivePath, std::ios::binary | std::ios::trunc);
+    archive.write(reinterpret_cast<const CHAR*>(aArchive.data()), static_cast<std::streamsize>(aArchive.size()));
+    if (!archive)
+    {
+        std::wcerr << L"ShaderArchiveBuilder >> Failed to write " << archivePath.wstring() << std::endl;
+        return 1;
+    }
+
+    std::wcout << L"ShaderArchiveBuilder >> Packed " << aShaders.size() << L" shaders into " << archivePath.wstring() << L" (" << aArchive.size() << L" bytes)" << std::endl;
+
+    return 0;
+}